@@ -4,28 +4,74 @@
 // Usage: ./bin/bench_cluster [--host H] [--port P] [--ops N] [--threads N]
 //                            [--pipeline N] [--key-size N] [--val-size N]
 //                            [--workload set|get|mixed|readonly] [--warmup-ops N]
+//                            [--protocol text|binary]
+//                            [--routing coordinator|token]
+//                            [--dist seq|uniform|zipfian|hotspot|latest]
+//                            [--keys N] [--zipf S] [--hot-fraction F]
+//                            [--hot-ops F] [--batch N]
+//                            [--rate QPS] [--duration S] [--arrivals poisson|fixed]
+//                            [--cluster-conf FILE] [--json FILE|-] [--csv FILE]
+//
+// --dist picks each operation's key.  seq (the default) gives every
+// operation its own key; the others draw from --keys keys, populated first:
+// uniform; zipfian with exponent --zipf (0.99 if unset; --zipf alone implies
+// zipfian); hotspot, where --hot-ops of the operations go to the first
+// --hot-fraction of the keys; latest, where SETs insert new keys and GETs
+// favour the newest ones (zipfian over recency).
+//
+// --rate switches from closed loop (each thread waits for its pipeline of
+// replies before sending more) to open loop: each thread sends its share of
+// QPS requests per second at Poisson (or, with --arrivals fixed, evenly
+// spaced) intervals regardless of how fast replies come back, and latency
+// runs from when a request was due to be sent, so a stalled server shows up
+// in the percentiles instead of silently slowing the load (coordinated
+// omission).  --duration S sets --ops from the rate.
+//
+// --cluster-conf spreads the threads' connections over every node listed
+// (thread i talks to node i mod N) instead of only --host/--port.  --json
+// writes the result, with percentiles up to p99.99, to a file (or stdout);
+// --csv writes the full latency distribution in µs (one row per histogram
+// bucket: value, percentile, count, running total) for plotting.
+//
+// --batch N sends the keys N at a time as MSET/MGET requests (mixed
+// alternates the two); throughput and ops still count keys, latency is per
+// pipelined round of requests.
+//
+// --routing token fetches the ring with TOPOLOGY and sends each key straight
+// to its primary replica (one connection per node per thread) instead of
+// through the node at --host/--port, which coordinates every request.
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 // POSIX socket headers (Linux / macOS only)
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <unistd.h>
 
+#include "cluster/cluster_config.h"
+#include "cluster/token_router.h"
+#include "utils/histogram.h"
+
 using namespace std::chrono;
 
 // ── Key / Value helpers ────────────────────────────────────────────────────────
@@ -40,40 +86,6 @@ static std::string make_val(int val_size) {
     return std::string(static_cast<size_t>(val_size), 'v');
 }
 
-// ── Latency stats (identical pattern to bench_storage.cpp) ────────────────────
-
-struct Stats {
-    std::vector<int64_t> latencies_ns;
-
-    void reserve(size_t n) { latencies_ns.reserve(n); }
-
-    void record(nanoseconds ns) {
-        latencies_ns.push_back(ns.count());
-    }
-
-    void merge(const Stats& other) {
-        latencies_ns.insert(latencies_ns.end(),
-                            other.latencies_ns.begin(),
-                            other.latencies_ns.end());
-    }
-
-    // Returns percentile (0-100) in microseconds.
-    double percentile(int p) {
-        if (latencies_ns.empty()) return 0;
-        std::sort(latencies_ns.begin(), latencies_ns.end());
-        size_t idx = static_cast<size_t>(p / 100.0 * latencies_ns.size());
-        if (idx >= latencies_ns.size()) idx = latencies_ns.size() - 1;
-        return latencies_ns[idx] / 1000.0;
-    }
-
-    double mean_us() {
-        if (latencies_ns.empty()) return 0;
-        double sum = 0;
-        for (auto v : latencies_ns) sum += static_cast<double>(v);
-        return (sum / static_cast<double>(latencies_ns.size())) / 1000.0;
-    }
-};
-
 // ── Config / Result ───────────────────────────────────────────────────────────
 
 struct BenchConfig {
@@ -86,8 +98,69 @@ struct BenchConfig {
     int         val_size   = 64;
     std::string workload   = "set";   // set | get | mixed | readonly
     int         warmup_ops = 1000;
+    std::string protocol   = "text";  // text | binary
+    std::string routing    = "coordinator";  // coordinator | token
+    std::string dist       = "seq";   // seq | uniform | zipfian | hotspot | latest
+    double      zipf       = 0;       // zipfian / latest exponent (0 = 0.99)
+    int         keys       = 100000;  // key space unless --dist seq
+    double      hot_fraction = 0.2;   // hotspot: share of keys that are hot
+    double      hot_ops    = 0.8;     // hotspot: share of operations on them
+    int         batch      = 1;       // keys per request (> 1: MSET/MGET)
+    double      rate       = 0;       // requests/s in total; 0 = closed loop
+    double      duration   = 0;       // open loop: seconds (sets --ops)
+    std::string arrivals   = "poisson";  // poisson | fixed
+    std::string cluster_conf;         // spread connections over these nodes
+    std::string json;                 // "" = none, "-" = stdout
+    std::string csv;                  // latency distribution; "" = none
+    std::vector<dkv::NodeEntry> nodes;  // parsed from cluster_conf
 };
 
+// ── Zipfian key ranks ─────────────────────────────────────────────────────────
+
+// Cumulative weights of ranks 0..keys-1 under zipf(s); built once in main().
+static std::vector<double> g_zipf_cdf;
+
+static void build_zipf(int keys, double s) {
+    g_zipf_cdf.resize(static_cast<size_t>(keys));
+    double sum = 0;
+    for (int i = 0; i < keys; ++i) {
+        sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+        g_zipf_cdf[static_cast<size_t>(i)] = sum;
+    }
+}
+
+static int zipf_rank(std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> u(0, g_zipf_cdf.back());
+    auto it = std::lower_bound(g_zipf_cdf.begin(), g_zipf_cdf.end(), u(rng));
+    return static_cast<int>(std::min<ptrdiff_t>(it - g_zipf_cdf.begin(),
+                                                static_cast<ptrdiff_t>(g_zipf_cdf.size()) - 1));
+}
+
+// --dist latest: keys [0, g_latest) exist; SETs append.
+static std::atomic<int> g_latest{0};
+
+// Key index for one operation; `seq_idx` is its own index (--dist seq).
+static int pick_key(const BenchConfig& cfg, std::mt19937_64& rng, int seq_idx,
+                    bool is_set) {
+    if (cfg.dist == "uniform") {
+        return std::uniform_int_distribution<int>(0, cfg.keys - 1)(rng);
+    }
+    if (cfg.dist == "zipfian") return zipf_rank(rng);
+    if (cfg.dist == "hotspot") {
+        int hot = std::max(1, static_cast<int>(cfg.keys * cfg.hot_fraction));
+        if (hot >= cfg.keys || std::uniform_real_distribution<double>(0, 1)(rng) < cfg.hot_ops) {
+            return std::uniform_int_distribution<int>(0, std::min(hot, cfg.keys) - 1)(rng);
+        }
+        return std::uniform_int_distribution<int>(hot, cfg.keys - 1)(rng);
+    }
+    if (cfg.dist == "latest") {
+        if (is_set) return g_latest.fetch_add(1, std::memory_order_relaxed);
+        int newest = g_latest.load(std::memory_order_relaxed) - 1;
+        return std::max(0, newest - zipf_rank(rng));
+    }
+    return seq_idx;
+}
+
 struct BenchResult {
     std::string name;
     double      ops_per_sec = 0;
@@ -97,6 +170,11 @@ struct BenchResult {
     double      p999_us     = 0;
     int         errors      = 0;
     int         total_ops   = 0;
+    double      p90_us      = 0;
+    double      p9999_us    = 0;
+    double      max_us      = 0;
+    double      max_lag_us  = 0;  // open loop: furthest a send fell behind
+    dkv::Histogram latency;       // ns, for --csv
 };
 
 // ── TCP helpers ───────────────────────────────────────────────────────────────
@@ -145,16 +223,21 @@ static bool send_all(int fd, const char* buf, size_t len) {
     return true;
 }
 
-// Read until '\n'; returns the full line including '\n', or "" on error.
-static std::string recv_line(int fd) {
-    std::string line;
-    line.reserve(128);
-    char c = '\0';
+// Read until '\n' using `pending` as a receive buffer across calls, so a
+// pipelined batch of responses costs a handful of recv() calls instead of one
+// per byte.  Returns the full line including '\n', or "" on error.
+static std::string recv_line(int fd, std::string& pending) {
     while (true) {
-        ssize_t n = recv(fd, &c, 1, 0);
+        size_t nl = pending.find('\n');
+        if (nl != std::string::npos) {
+            std::string line = pending.substr(0, nl + 1);
+            pending.erase(0, nl + 1);
+            return line;
+        }
+        char buf[16384];
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
         if (n <= 0) return "";
-        line += c;
-        if (c == '\n') return line;
+        pending.append(buf, static_cast<size_t>(n));
     }
 }
 
@@ -169,25 +252,197 @@ static std::string fmt_get(const std::string& key) {
     return "GET " + std::to_string(key.size()) + " " + key + "\n";
 }
 
+// MSET/MGET argument list: <count> <key_len> <key> [<val_len> <value>] ...
+static std::string fmt_multi_args(const std::vector<std::string>& keys,
+                                  const std::string* val) {
+    std::string out = std::to_string(keys.size());
+    for (const auto& key : keys) {
+        out += " " + std::to_string(key.size()) + " " + key;
+        if (val) out += " " + std::to_string(val->size()) + " " + *val;
+    }
+    return out;
+}
+
 static bool is_error_response(const std::string& resp) {
     return !resp.empty() && resp[0] == '-';
 }
 
+// ── Binary protocol (mirrors include/network/protocol.h) ──────────────────────
+//
+// Header: [magic 1B][opcode 1B][flags 1B][extras_len 1B]
+//         [request_id 4B][key_len 4B][val_len 4B], little-endian.
+
+static constexpr uint8_t BIN_MAGIC       = 0xDB;
+static constexpr size_t  BIN_HEADER_SIZE = 16;
+static constexpr uint8_t BIN_OP_GET      = 0x01;
+static constexpr uint8_t BIN_OP_SET      = 0x02;
+static constexpr uint8_t BIN_OP_MGET     = 0x08;
+static constexpr uint8_t BIN_OP_MSET     = 0x09;
+static constexpr uint8_t BIN_OP_ERROR    = 0x83;
+
+static void put_u32(char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<char>((v >> (i * 8)) & 0xFF);
+}
+
+static uint32_t get_u32(const char* p) {
+    uint32_t v = 0;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+static void append_bin(std::string& out, uint8_t op, uint32_t req_id,
+                       const std::string& key, const std::string& val) {
+    char hdr[BIN_HEADER_SIZE];
+    hdr[0] = static_cast<char>(BIN_MAGIC);
+    hdr[1] = static_cast<char>(op);
+    hdr[2] = 0;
+    hdr[3] = 0;
+    put_u32(hdr + 4,  req_id);
+    put_u32(hdr + 8,  static_cast<uint32_t>(key.size()));
+    put_u32(hdr + 12, static_cast<uint32_t>(val.size()));
+    out.append(hdr, sizeof(hdr));
+    out.append(key);
+    out.append(val);
+}
+
+// Receive exactly `len` bytes; returns false on failure.
+static bool recv_exact(int fd, char* buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = recv(fd, buf + got, len - got, 0);
+        if (n <= 0) return false;
+        got += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Read one binary response frame.  Returns false on connection loss;
+// `is_error` reports an ERROR opcode.
+static bool recv_bin_response(int fd, std::string& scratch, bool& is_error) {
+    char hdr[BIN_HEADER_SIZE];
+    if (!recv_exact(fd, hdr, sizeof(hdr))) return false;
+    if (static_cast<uint8_t>(hdr[0]) != BIN_MAGIC) return false;
+    size_t body = static_cast<uint8_t>(hdr[3]) + size_t{get_u32(hdr + 8)}
+                + size_t{get_u32(hdr + 12)};
+    scratch.resize(body);
+    if (body > 0 && !recv_exact(fd, scratch.data(), body)) return false;
+    is_error = static_cast<uint8_t>(hdr[1]) == BIN_OP_ERROR;
+    return true;
+}
+
 // ── Per-thread accumulated state ──────────────────────────────────────────────
 
 struct ThreadState {
-    Stats stats;
-    int   errors    = 0;
-    int   total_ops = 0;
+    dkv::Histogram  latency_ns;
+    int             errors    = 0;
+    int             total_ops = 0;
+    std::mt19937_64 rng;  // key and arrival draws
+    int64_t         max_lag_ns = 0;  // open loop
 };
 
-// Run `count` operations on `fd` starting at key index `key_base`.
+// Each thread records into its own histogram; run_benchmark() merges them.
+template <typename Duration>
+static void record_latency(ThreadState& state, Duration d) {
+    state.latency_ns.record(static_cast<uint64_t>(
+        std::max<int64_t>(duration_cast<nanoseconds>(d).count(), 0)));
+}
+
+// --batch: like run_ops(), with `cfg.batch` keys per MSET/MGET request and
+// `cfg.pipeline` requests per round.  Each request goes to the connection
+// of its first key's primary, which coordinates the rest.
+static bool run_multi_ops(const std::vector<int>& fds,
+                          const dkv::TokenRouter* router, const BenchConfig& cfg,
+                          int key_base, int count, bool record,
+                          ThreadState& state) {
+    const std::string val = make_val(cfg.val_size);
+    const bool binary = cfg.protocol == "binary";
+    std::vector<std::string> reqs(fds.size());
+    std::vector<std::string> pending(fds.size());
+    std::vector<std::vector<int>> sent(fds.size());  // keys per request
+    std::vector<std::string> keys;
+    std::string scratch;
+    uint32_t next_req_id = 0;
+    int      request     = 0;
+
+    int i = 0;
+    while (i < count) {
+        auto t0 = high_resolution_clock::now();
+
+        for (auto& r : reqs) r.clear();
+        for (auto& s : sent) s.clear();
+        for (int p = 0; p < cfg.pipeline && i < count; ++p, ++request) {
+            const int n = std::min(cfg.batch, count - i);
+            const bool is_set = cfg.workload == "set" ||
+                                (cfg.workload == "mixed" && request % 2 == 0);
+            keys.clear();
+            for (int b = 0; b < n; ++b) {
+                int key_idx = pick_key(cfg, state.rng, key_base + i + b, is_set);
+                keys.push_back(make_key(key_idx, cfg.key_size));
+            }
+            i += n;
+
+            size_t c = router ? router->primary(keys[0]) : 0;
+            sent[c].push_back(n);
+            std::string args = fmt_multi_args(keys, is_set ? &val : nullptr);
+            if (binary) {
+                append_bin(reqs[c], is_set ? BIN_OP_MSET : BIN_OP_MGET,
+                           next_req_id++, {}, args);
+            } else {
+                reqs[c] += (is_set ? "MSET " : "MGET ") + args + "\n";
+            }
+        }
+
+        for (size_t c = 0; c < fds.size(); ++c) {
+            if (!reqs[c].empty() && !send_all(fds[c], reqs[c].data(), reqs[c].size())) {
+                return false;
+            }
+        }
+        // A failed request counts as an error for each of its keys.
+        for (size_t c = 0; c < fds.size(); ++c) {
+            for (int n : sent[c]) {
+                bool ok;
+                bool err = false;
+                if (binary) {
+                    ok = recv_bin_response(fds[c], scratch, err);
+                } else {
+                    std::string resp = recv_line(fds[c], pending[c]);
+                    ok  = !resp.empty();
+                    err = is_error_response(resp);
+                }
+                if (record) {
+                    state.total_ops += n;
+                    if (!ok || err) state.errors += n;
+                }
+                if (!ok) return false;
+            }
+        }
+
+        auto t1 = high_resolution_clock::now();
+        if (record) record_latency(state, t1 - t0);
+    }
+    return true;
+}
+
+// Run `count` operations starting at key index `key_base`.  Without a
+// router everything goes to fds[0]; with one, each key goes to the
+// connection of its primary replica (fds is indexed like router->nodes()).
 // When `record` is false (warmup), latencies and error counts are discarded.
-// Returns false if the TCP connection is lost partway through.
-static bool run_ops(int fd, const BenchConfig& cfg,
+// Returns false if a TCP connection is lost partway through.
+static bool run_ops(const std::vector<int>& fds,
+                    const dkv::TokenRouter* router, const BenchConfig& cfg,
                     int key_base, int count, bool record,
                     ThreadState& state) {
     const std::string val = make_val(cfg.val_size);
+    const bool binary = cfg.protocol == "binary";
+    std::vector<std::string> reqs(fds.size());
+    std::vector<std::string> pending(fds.size());   // text-mode receive buffers
+    std::vector<int>         sent(fds.size());
+    std::string scratch;
+    uint32_t next_req_id = 0;
+
+    if (cfg.batch > 1) {
+        return run_multi_ops(fds, router, cfg, key_base, count, record, state);
+    }
 
     int i = 0;
     while (i < count) {
@@ -195,57 +450,309 @@ static bool run_ops(int fd, const BenchConfig& cfg,
 
         auto t0 = high_resolution_clock::now();
 
-        // ── Send batch ────────────────────────────────────────────────────────
-        int sent = 0;
+        // ── Build the whole batch, then send it in one go per connection ──────
+        for (auto& r : reqs) r.clear();
+        std::fill(sent.begin(), sent.end(), 0);
         for (int b = 0; b < batch; ++b) {
             int abs_idx = key_base + i + b;
-            std::string req;
+            bool is_set;
+            int  key_idx = abs_idx;
 
             if (cfg.workload == "set") {
-                req = fmt_set(make_key(abs_idx, cfg.key_size), val);
+                is_set = true;
             } else if (cfg.workload == "get" || cfg.workload == "readonly") {
-                req = fmt_get(make_key(abs_idx, cfg.key_size));
+                is_set = false;
             } else {
                 // mixed: even ops → SET key i, odd ops → GET key i-1
-                if ((i + b) % 2 == 0) {
-                    req = fmt_set(make_key(abs_idx, cfg.key_size), val);
-                } else {
-                    int get_idx = abs_idx > 0 ? abs_idx - 1 : abs_idx;
-                    req = fmt_get(make_key(get_idx, cfg.key_size));
-                }
+                is_set = (i + b) % 2 == 0;
+                if (!is_set && abs_idx > 0) key_idx = abs_idx - 1;
+            }
+            key_idx = pick_key(cfg, state.rng, key_idx, is_set);
+
+            std::string key = make_key(key_idx, cfg.key_size);
+            size_t c = router ? router->primary(key) : 0;
+            std::string& req = reqs[c];
+            ++sent[c];
+            if (binary) {
+                append_bin(req, is_set ? BIN_OP_SET : BIN_OP_GET,
+                           next_req_id++, key, is_set ? val : std::string());
+            } else {
+                req += is_set ? fmt_set(key, val) : fmt_get(key);
             }
-
-            if (!send_all(fd, req.c_str(), req.size())) break;
-            ++sent;
         }
 
-        if (sent == 0) return false;  // connection lost before anything was sent
+        for (size_t c = 0; c < fds.size(); ++c) {
+            if (!reqs[c].empty() && !send_all(fds[c], reqs[c].data(), reqs[c].size())) {
+                return false;  // connection lost before the batch went out
+            }
+        }
 
-        // ── Receive responses for every successfully-sent request ─────────────
-        for (int b = 0; b < sent; ++b) {
-            std::string resp = recv_line(fd);
-            if (record) {
-                ++state.total_ops;
-                if (resp.empty() || is_error_response(resp)) ++state.errors;
+        // ── Receive one response per request ──────────────────────────────────
+        // Binary replies may arrive out of order; in a closed loop only the
+        // count matters, so request ids are not matched here.
+        for (size_t c = 0; c < fds.size(); ++c) {
+            for (int b = 0; b < sent[c]; ++b) {
+                bool ok;
+                bool err = false;
+                if (binary) {
+                    ok = recv_bin_response(fds[c], scratch, err);
+                } else {
+                    std::string resp = recv_line(fds[c], pending[c]);
+                    ok  = !resp.empty();
+                    err = is_error_response(resp);
+                }
+                if (record) {
+                    ++state.total_ops;
+                    if (!ok || err) ++state.errors;
+                }
+                if (!ok) return false;
             }
         }
 
         auto t1 = high_resolution_clock::now();
         if (record) {
             // Batch-level latency granularity (per spec for pipeline > 1).
-            state.stats.record(duration_cast<nanoseconds>(t1 - t0));
+            record_latency(state, t1 - t0);
         }
 
-        if (sent < batch) return false;  // partial send → connection dead
-
         i += batch;
     }
     return true;
 }
 
+// ── Token-aware routing ───────────────────────────────────────────────────────
+
+// Ask the node at host:port for the ring.  Returns false if it cannot be
+// reached or answers with something other than a valid TOPOLOGY value.
+static bool fetch_topology(const BenchConfig& cfg, dkv::TokenRouter& router) {
+    int fd = open_connection(cfg.host, cfg.port);
+    if (fd < 0) return false;
+    static const char k_req[] = "TOPOLOGY\n";
+    std::string pending;
+    std::string resp;
+    if (send_all(fd, k_req, sizeof(k_req) - 1)) resp = recv_line(fd, pending);
+    close(fd);
+
+    // $<len> <payload>\n
+    size_t sp = resp.find(' ');
+    if (resp.empty() || resp[0] != '$' || sp == std::string::npos) return false;
+    return router.update(std::string_view(resp).substr(sp + 1, resp.size() - sp - 2));
+}
+
+// Open thread `t`'s connections: one per node with a router, else one to
+// node t mod N of --cluster-conf, else one to host:port.
+static std::vector<int> open_connections(const BenchConfig& cfg,
+                                         const dkv::TokenRouter* router, int t) {
+    std::vector<int> fds;
+    if (!router) {
+        int fd = cfg.nodes.empty()
+                     ? open_connection(cfg.host, cfg.port)
+                     : open_connection(cfg.nodes[static_cast<size_t>(t) % cfg.nodes.size()].host,
+                                       cfg.nodes[static_cast<size_t>(t) % cfg.nodes.size()].port);
+        if (fd >= 0) fds.push_back(fd);
+        return fds;
+    }
+    for (const auto& node : router->nodes()) {
+        int fd = open_connection(node.host, node.port);
+        if (fd < 0) {
+            for (int open_fd : fds) close(open_fd);
+            return {};
+        }
+        fds.push_back(fd);
+    }
+    return fds;
+}
+
+// ── Open loop ─────────────────────────────────────────────────────────────────
+
+// Requests sent on one connection and not answered yet: when each was due
+// and how many keys it carried.  Text replies come back in order; binary
+// ones may not and are matched by request id.
+struct InFlight {
+    struct Entry {
+        steady_clock::time_point due;
+        int                      keys = 1;
+    };
+    std::mutex                          mutex;
+    std::deque<Entry>                   text;
+    std::unordered_map<uint32_t, Entry> binary;
+};
+
+// Receiver side of run_open_loop(): record every reply against its due
+// time until the sender is done and nothing is outstanding (or nothing has
+// arrived for 5s, or every connection is gone).  Whatever is still
+// unanswered then counts as failed.
+static void receive_open_loop(const std::vector<int>& fds, bool binary,
+                              std::vector<InFlight>& flights,
+                              std::atomic<int>& outstanding,
+                              const std::atomic<bool>& sending,
+                              ThreadState& state) {
+    std::vector<pollfd>      pfds;
+    std::vector<std::string> bufs(fds.size());
+    for (int fd : fds) pfds.push_back(pollfd{fd, POLLIN, 0});
+    std::vector<char> chunk(64 * 1024);
+    auto last_progress = steady_clock::now();
+    size_t open = fds.size();
+
+    while (open > 0 && (sending.load(std::memory_order_acquire) ||
+                        outstanding.load(std::memory_order_acquire) > 0)) {
+        int n = ::poll(pfds.data(), pfds.size(), 100);
+        const auto now = steady_clock::now();
+        if (n <= 0) {
+            if (n < 0 && errno != EINTR) break;
+            if (!sending.load(std::memory_order_acquire) &&
+                now - last_progress > seconds(5)) {
+                break;
+            }
+            continue;
+        }
+        for (size_t c = 0; c < pfds.size(); ++c) {
+            if (pfds[c].fd < 0 || pfds[c].revents == 0) continue;
+            ssize_t got = recv(pfds[c].fd, chunk.data(), chunk.size(), MSG_DONTWAIT);
+            if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                continue;
+            }
+            if (got <= 0) {
+                pfds[c].fd = -1;  // lost: poll() skips it from now on
+                --open;
+                continue;
+            }
+            last_progress = now;
+            std::string& buf = bufs[c];
+            buf.append(chunk.data(), static_cast<size_t>(got));
+
+            size_t off = 0;
+            for (;;) {
+                bool     err = false;
+                uint32_t id  = 0;
+                if (binary) {
+                    if (buf.size() - off < BIN_HEADER_SIZE) break;
+                    const char* hdr = buf.data() + off;
+                    size_t len = BIN_HEADER_SIZE + static_cast<uint8_t>(hdr[3]) +
+                                 size_t{get_u32(hdr + 8)} + size_t{get_u32(hdr + 12)};
+                    if (buf.size() - off < len) break;
+                    id  = get_u32(hdr + 4);
+                    err = static_cast<uint8_t>(hdr[1]) == BIN_OP_ERROR;
+                    off += len;
+                } else {
+                    size_t nl = buf.find('\n', off);
+                    if (nl == std::string::npos) break;
+                    err = buf[off] == '-';
+                    off = nl + 1;
+                }
+
+                InFlight::Entry entry;
+                {
+                    std::lock_guard<std::mutex> lock(flights[c].mutex);
+                    if (binary) {
+                        auto it = flights[c].binary.find(id);
+                        if (it == flights[c].binary.end()) continue;
+                        entry = it->second;
+                        flights[c].binary.erase(it);
+                    } else {
+                        if (flights[c].text.empty()) continue;
+                        entry = flights[c].text.front();
+                        flights[c].text.pop_front();
+                    }
+                }
+                outstanding.fetch_sub(1, std::memory_order_acq_rel);
+                state.total_ops += entry.keys;
+                if (err) state.errors += entry.keys;
+                record_latency(state, now - entry.due);
+            }
+            buf.erase(0, off);
+        }
+    }
+
+    for (auto& flight : flights) {
+        std::lock_guard<std::mutex> lock(flight.mutex);
+        for (const auto& e : flight.text) {
+            state.total_ops += e.keys;
+            state.errors    += e.keys;
+        }
+        for (const auto& [id, e] : flight.binary) {
+            state.total_ops += e.keys;
+            state.errors    += e.keys;
+        }
+    }
+}
+
+// Send `requests` requests (of --batch keys each) at this thread's share of
+// --rate, on schedule whether or not earlier ones were answered; a receiver
+// thread times each reply from when its request was due.
+static void run_open_loop(const std::vector<int>& fds,
+                          const dkv::TokenRouter* router, const BenchConfig& cfg,
+                          int key_base, int requests, ThreadState& state) {
+    const std::string val    = make_val(cfg.val_size);
+    const bool        binary = cfg.protocol == "binary";
+    std::vector<InFlight> flights(fds.size());
+    std::atomic<int>      outstanding{0};
+    std::atomic<bool>     sending{true};
+    std::thread receiver([&]() {
+        receive_open_loop(fds, binary, flights, outstanding, sending, state);
+    });
+
+    const double rate = cfg.rate / cfg.threads;
+    std::exponential_distribution<double> gap(rate);
+    std::vector<std::string> keys;
+    std::string req;
+    auto due = steady_clock::now();
+
+    for (int r = 0; r < requests; ++r) {
+        const double wait = cfg.arrivals == "fixed" ? 1.0 / rate : gap(state.rng);
+        due += duration_cast<steady_clock::duration>(duration<double>(wait));
+        if (steady_clock::now() < due) std::this_thread::sleep_until(due);
+        state.max_lag_ns = std::max<int64_t>(
+            state.max_lag_ns, duration_cast<nanoseconds>(steady_clock::now() - due).count());
+
+        // mixed alternates SET and GET, a GET reading the previous SET's
+        // keys under --dist seq (as in closed loop).
+        const bool is_set = cfg.workload == "set" ||
+                            (cfg.workload == "mixed" && r % 2 == 0);
+        const int seq = key_base + r * cfg.batch -
+                        (cfg.workload == "mixed" && !is_set ? cfg.batch : 0);
+        keys.clear();
+        for (int b = 0; b < cfg.batch; ++b) {
+            keys.push_back(make_key(pick_key(cfg, state.rng, seq + b, is_set), cfg.key_size));
+        }
+
+        const size_t   c  = router ? router->primary(keys[0]) : 0;
+        const uint32_t id = static_cast<uint32_t>(r);
+        req.clear();
+        if (cfg.batch > 1) {
+            std::string args = fmt_multi_args(keys, is_set ? &val : nullptr);
+            if (binary) {
+                append_bin(req, is_set ? BIN_OP_MSET : BIN_OP_MGET, id, {}, args);
+            } else {
+                req = (is_set ? "MSET " : "MGET ") + args + "\n";
+            }
+        } else if (binary) {
+            append_bin(req, is_set ? BIN_OP_SET : BIN_OP_GET, id, keys[0],
+                       is_set ? val : std::string());
+        } else {
+            req = is_set ? fmt_set(keys[0], val) : fmt_get(keys[0]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(flights[c].mutex);
+            if (binary) {
+                flights[c].binary[id] = InFlight::Entry{due, cfg.batch};
+            } else {
+                flights[c].text.push_back(InFlight::Entry{due, cfg.batch});
+            }
+        }
+        outstanding.fetch_add(1, std::memory_order_acq_rel);
+        if (!send_all(fds[c], req.data(), req.size())) break;  // counted by the receiver
+    }
+
+    sending.store(false, std::memory_order_release);
+    receiver.join();
+}
+
 // ── Benchmark orchestration ───────────────────────────────────────────────────
 
-static BenchResult run_benchmark(const BenchConfig& cfg) {
+static BenchResult run_benchmark(const BenchConfig& cfg,
+                                 const dkv::TokenRouter* router) {
     // Build the result name shown in the output table.
     std::string name;
     if (cfg.workload == "mixed") {
@@ -257,6 +764,21 @@ static BenchResult run_benchmark(const BenchConfig& cfg) {
              + (cfg.threads > 1 ? "s" : "") + ", pipeline="
              + std::to_string(cfg.pipeline) + ")";
     }
+    if (cfg.rate > 0) {
+        std::ostringstream r;
+        r << " open@" << cfg.rate << "/s";
+        name += r.str();
+    }
+    if (cfg.dist == "zipfian") {
+        std::ostringstream z;
+        z << " zipf" << cfg.zipf;
+        name += z.str();
+    } else if (cfg.dist != "seq") {
+        name += " " + cfg.dist;
+    }
+    if (cfg.batch > 1) name += " batch" + std::to_string(cfg.batch);
+    if (cfg.protocol == "binary") name += " bin";
+    if (router) name += " token";
 
     int ops_per_thread = cfg.ops / cfg.threads;
 
@@ -271,28 +793,43 @@ static BenchResult run_benchmark(const BenchConfig& cfg) {
         threads.emplace_back([&, t]() {
             auto& state  = thread_states[static_cast<size_t>(t)];
             int key_base = t * ops_per_thread;
+            state.rng.seed(static_cast<uint64_t>(t) + 1);
 
-            int fd = open_connection(cfg.host, cfg.port);
-            if (fd < 0) {
+            std::vector<int> fds = open_connections(cfg, router, t);
+            if (fds.empty()) {
                 state.errors    = ops_per_thread;
                 state.total_ops = ops_per_thread;
                 ready_count.fetch_add(1, std::memory_order_release);
                 return;
             }
 
-            // Pre-populate keys for get / readonly (untimed, pipeline=1 for safety).
-            if (cfg.workload == "get" || cfg.workload == "readonly") {
+            // Pre-populate keys for get / readonly (untimed, pipeline=1 for
+            // safety); with --dist other than seq, this thread's share of
+            // the key space.
+            const bool drawn = cfg.dist != "seq";
+            if (cfg.workload == "get" || cfg.workload == "readonly" || drawn) {
                 BenchConfig pop = cfg;
                 pop.workload    = "set";
                 pop.pipeline    = 1;
+                pop.batch       = 1;
+                pop.dist        = "seq";
                 ThreadState dummy;
-                run_ops(fd, pop, key_base, ops_per_thread, false, dummy);
+                if (drawn) {
+                    int share = cfg.keys / cfg.threads;
+                    run_ops(fds, router, pop, t * share,
+                            t == cfg.threads - 1 ? cfg.keys - t * share : share,
+                            false, dummy);
+                } else {
+                    run_ops(fds, router, pop, key_base, ops_per_thread, false, dummy);
+                }
             }
 
-            // Warmup phase — same workload, not recorded.
+            // Warmup phase — same workload (closed loop), not recorded.
             if (cfg.warmup_ops > 0) {
+                BenchConfig warm = cfg;
+                warm.rate        = 0;
                 ThreadState dummy;
-                run_ops(fd, cfg, key_base,
+                run_ops(fds, router, warm, key_base,
                         std::min(cfg.warmup_ops, ops_per_thread),
                         false, dummy);
             }
@@ -303,12 +840,14 @@ static BenchResult run_benchmark(const BenchConfig& cfg) {
                 std::this_thread::yield();
 
             // Timed benchmark phase.
-            size_t sample_count = static_cast<size_t>(
-                (ops_per_thread + cfg.pipeline - 1) / cfg.pipeline);
-            state.stats.reserve(sample_count);
-            run_ops(fd, cfg, key_base, ops_per_thread, true, state);
+            if (cfg.rate > 0) {
+                int requests = (ops_per_thread + cfg.batch - 1) / cfg.batch;
+                run_open_loop(fds, router, cfg, key_base, requests, state);
+            } else {
+                run_ops(fds, router, cfg, key_base, ops_per_thread, true, state);
+            }
 
-            close(fd);
+            for (int fd : fds) close(fd);
         });
     }
 
@@ -322,30 +861,39 @@ static BenchResult run_benchmark(const BenchConfig& cfg) {
     for (auto& th : threads) th.join();
     auto wall_end = high_resolution_clock::now();
 
-    // Aggregate latency samples and error counts from all threads.
-    Stats combined;
-    combined.reserve(static_cast<size_t>(cfg.ops));
+    // Aggregate latency histograms and error counts from all threads.
+    dkv::Histogram combined;
     int total_errors = 0;
     int total_ops    = 0;
     for (auto& s : thread_states) {
-        combined.merge(s.stats);
+        combined.merge(s.latency_ns);
         total_errors += s.errors;
         total_ops    += s.total_ops;
     }
 
     double elapsed_s = duration_cast<microseconds>(wall_end - wall_start).count() / 1e6;
-    int    measured  = ops_per_thread * cfg.threads;
-
-    return {
-        name,
-        measured / elapsed_s,
-        combined.mean_us(),
-        combined.percentile(50),
-        combined.percentile(99),
-        combined.percentile(99'9),
-        total_errors,
-        total_ops
-    };
+    // Open loop: what was actually answered, which falls short of the
+    // target rate once the cluster saturates.
+    int    measured  = cfg.rate > 0 ? total_ops : ops_per_thread * cfg.threads;
+
+    auto us = [&](double p) { return static_cast<double>(combined.percentile(p)) / 1000.0; };
+    BenchResult result;
+    result.name        = name;
+    result.ops_per_sec = measured / elapsed_s;
+    result.mean_us     = combined.mean() / 1000.0;
+    result.p50_us      = us(50);
+    result.p99_us      = us(99);
+    result.p999_us     = us(99.9);
+    result.errors      = total_errors;
+    result.total_ops   = total_ops;
+    result.p90_us      = us(90);
+    result.p9999_us    = us(99.99);
+    result.max_us      = static_cast<double>(combined.max()) / 1000.0;
+    result.latency     = combined;
+    for (auto& s : thread_states) {
+        result.max_lag_us = std::max(result.max_lag_us, s.max_lag_ns / 1000.0);
+    }
+    return result;
 }
 
 // ── Output (matches bench_storage.cpp column layout exactly) ──────────────────
@@ -390,6 +938,49 @@ static void print_result(const BenchResult& r) {
     }
 }
 
+// One JSON object with the configuration and the result.
+static bool write_json(const BenchConfig& cfg, const BenchResult& r) {
+    std::ostringstream o;
+    o << std::fixed << std::setprecision(2);
+    o << "{\n"
+      << "  \"name\": \"" << r.name << "\",\n"
+      << "  \"mode\": \"" << (cfg.rate > 0 ? "open" : "closed") << "\",\n"
+      << "  \"workload\": \"" << cfg.workload << "\",\n"
+      << "  \"dist\": \"" << cfg.dist << "\",\n"
+      << "  \"keys\": " << cfg.keys << ",\n"
+      << "  \"protocol\": \"" << cfg.protocol << "\",\n"
+      << "  \"routing\": \"" << cfg.routing << "\",\n"
+      << "  \"nodes\": " << std::max<size_t>(cfg.nodes.size(), 1) << ",\n"
+      << "  \"threads\": " << cfg.threads << ",\n"
+      << "  \"pipeline\": " << cfg.pipeline << ",\n"
+      << "  \"batch\": " << cfg.batch << ",\n"
+      << "  \"key_size\": " << cfg.key_size << ",\n"
+      << "  \"val_size\": " << cfg.val_size << ",\n"
+      << "  \"target_rps\": " << cfg.rate << ",\n"
+      << "  \"arrivals\": \"" << (cfg.rate > 0 ? cfg.arrivals : "closed") << "\",\n"
+      << "  \"ops\": " << r.total_ops << ",\n"
+      << "  \"errors\": " << r.errors << ",\n"
+      << "  \"throughput_ops\": " << r.ops_per_sec << ",\n"
+      << "  \"max_send_lag_us\": " << r.max_lag_us << ",\n"
+      << "  \"latency_us\": {\n"
+      << "    \"mean\": " << r.mean_us << ",\n"
+      << "    \"p50\": " << r.p50_us << ",\n"
+      << "    \"p90\": " << r.p90_us << ",\n"
+      << "    \"p99\": " << r.p99_us << ",\n"
+      << "    \"p99.9\": " << r.p999_us << ",\n"
+      << "    \"p99.99\": " << r.p9999_us << ",\n"
+      << "    \"max\": " << r.max_us << "\n"
+      << "  }\n"
+      << "}\n";
+    if (cfg.json == "-") {
+        std::cout << o.str();
+        return true;
+    }
+    std::ofstream out(cfg.json);
+    out << o.str();
+    return static_cast<bool>(out);
+}
+
 // ── Main ──────────────────────────────────────────────────────────────────────
 
 int main(int argc, char* argv[]) {
@@ -414,25 +1005,139 @@ int main(int argc, char* argv[]) {
             cfg.workload   = argv[++i];
         else if (std::strcmp(argv[i], "--warmup-ops")  == 0 && i + 1 < argc)
             cfg.warmup_ops = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--protocol")    == 0 && i + 1 < argc)
+            cfg.protocol   = argv[++i];
+        else if (std::strcmp(argv[i], "--routing")     == 0 && i + 1 < argc)
+            cfg.routing    = argv[++i];
+        else if (std::strcmp(argv[i], "--zipf")        == 0 && i + 1 < argc)
+            cfg.zipf       = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--keys")        == 0 && i + 1 < argc)
+            cfg.keys       = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--batch")       == 0 && i + 1 < argc)
+            cfg.batch      = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--dist")        == 0 && i + 1 < argc)
+            cfg.dist       = argv[++i];
+        else if (std::strcmp(argv[i], "--hot-fraction") == 0 && i + 1 < argc)
+            cfg.hot_fraction = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--hot-ops")     == 0 && i + 1 < argc)
+            cfg.hot_ops    = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--rate")        == 0 && i + 1 < argc)
+            cfg.rate       = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--duration")    == 0 && i + 1 < argc)
+            cfg.duration   = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--arrivals")    == 0 && i + 1 < argc)
+            cfg.arrivals   = argv[++i];
+        else if (std::strcmp(argv[i], "--cluster-conf") == 0 && i + 1 < argc)
+            cfg.cluster_conf = argv[++i];
+        else if (std::strcmp(argv[i], "--json")        == 0 && i + 1 < argc)
+            cfg.json       = argv[++i];
+        else if (std::strcmp(argv[i], "--csv")         == 0 && i + 1 < argc)
+            cfg.csv        = argv[++i];
+    }
+
+    // --zipf S on its own keeps meaning a zipfian key draw.
+    if (cfg.zipf > 0 && cfg.dist == "seq") cfg.dist = "zipfian";
+    if (cfg.dist != "seq" && cfg.dist != "uniform" && cfg.dist != "zipfian" &&
+        cfg.dist != "hotspot" && cfg.dist != "latest") {
+        std::cerr << "Unknown --dist '" << cfg.dist
+                  << "' (expected seq|uniform|zipfian|hotspot|latest)\n";
+        return 1;
+    }
+    if (cfg.arrivals != "poisson" && cfg.arrivals != "fixed") {
+        std::cerr << "Unknown --arrivals '" << cfg.arrivals
+                  << "' (expected poisson|fixed)\n";
+        return 1;
+    }
+
+    if (!cfg.cluster_conf.empty()) {
+        cfg.nodes = dkv::parse_cluster_config(cfg.cluster_conf);
+        if (cfg.nodes.empty()) {
+            std::cerr << "No nodes in --cluster-conf " << cfg.cluster_conf << "\n";
+            return 1;
+        }
+        cfg.host = cfg.nodes[0].host;  // asked for TOPOLOGY
+        cfg.port = cfg.nodes[0].port;
+    }
+
+    if (cfg.protocol != "text" && cfg.protocol != "binary") {
+        std::cerr << "Unknown --protocol '" << cfg.protocol
+                  << "' (expected text|binary)\n";
+        return 1;
+    }
+
+    if (cfg.routing != "coordinator" && cfg.routing != "token") {
+        std::cerr << "Unknown --routing '" << cfg.routing
+                  << "' (expected coordinator|token)\n";
+        return 1;
+    }
+
+    dkv::TokenRouter router;
+    if (cfg.routing == "token" && !fetch_topology(cfg, router)) {
+        std::cerr << "Could not fetch TOPOLOGY from " << cfg.host << ":"
+                  << cfg.port << "\n";
+        return 1;
     }
 
     if (cfg.threads  < 1) cfg.threads  = 1;
     if (cfg.ops      < 1) cfg.ops      = 1;
     if (cfg.pipeline < 1) cfg.pipeline = 1;
+    if (cfg.keys     < 1) cfg.keys     = 1;
+    if (cfg.batch    < 1) cfg.batch    = 1;
+    if (cfg.rate > 0 && cfg.duration > 0) {
+        cfg.ops = std::max(1, static_cast<int>(cfg.rate * cfg.duration) * cfg.batch);
+    }
+    if (cfg.dist == "zipfian" || cfg.dist == "latest") {
+        if (cfg.zipf <= 0) cfg.zipf = 0.99;
+        build_zipf(cfg.keys, cfg.zipf);
+    }
+    g_latest.store(cfg.keys, std::memory_order_relaxed);
 
     std::cout << "DKV Cluster Benchmark\n";
-    std::cout << "  target="   << cfg.host << ":" << cfg.port
-              << "  ops="      << cfg.ops
+    std::cout << "  target="   << cfg.host << ":" << cfg.port;
+    if (cfg.nodes.size() > 1) std::cout << " (+" << cfg.nodes.size() - 1 << " nodes)";
+    std::cout << "  ops="      << cfg.ops
               << "  threads="  << cfg.threads
               << "  pipeline=" << cfg.pipeline
               << "  key_size=" << cfg.key_size << "B"
               << "  val_size=" << cfg.val_size << "B"
-              << "  workload=" << cfg.workload << "\n";
+              << "  workload=" << cfg.workload
+              << "  protocol=" << cfg.protocol
+              << "  routing="  << cfg.routing;
+    if (cfg.dist != "seq") std::cout << "  dist=" << cfg.dist << " over " << cfg.keys << " keys";
+    if (cfg.dist == "zipfian" || cfg.dist == "latest") std::cout << "  zipf=" << cfg.zipf;
+    if (cfg.batch > 1) std::cout << "  batch=" << cfg.batch;
+    if (cfg.rate > 0) std::cout << "  rate=" << cfg.rate << "/s " << cfg.arrivals;
+    std::cout << "\n";
+    if (cfg.routing == "token") {
+        std::cout << "  ring v" << router.version() << ": "
+                  << router.nodes().size() << " nodes, "
+                  << router.token_count() << " tokens, rf="
+                  << router.replication_factor() << "\n";
+    }
 
     print_header();
-    BenchResult result = run_benchmark(cfg);
+    BenchResult result = run_benchmark(
+        cfg, cfg.routing == "token" ? &router : nullptr);
     print_result(result);
     std::cout << std::string(100, '-') << "\n";
+    if (cfg.rate > 0) {
+        std::cout << std::fixed << std::setprecision(2)
+                  << "  p90 " << result.p90_us << " µs  p99.99 " << result.p9999_us
+                  << " µs  max " << result.max_us << " µs  (from intended send time;"
+                  << " sends fell behind by up to " << result.max_lag_us << " µs)\n";
+    }
+    if (!cfg.json.empty() && !write_json(cfg, result)) {
+        std::cerr << "Could not write " << cfg.json << "\n";
+        return 1;
+    }
+    if (!cfg.csv.empty()) {
+        std::ofstream out(cfg.csv);
+        result.latency.write_csv(out, 1000.0);
+        if (!out) {
+            std::cerr << "Could not write " << cfg.csv << "\n";
+            return 1;
+        }
+    }
 
     return 0;
 }
@@ -5,6 +5,7 @@
 // Usage: ./bin/bench_storage [--ops N] [--threads N] [--key-size N] [--val-size N]
 
 #include "storage/storage_engine.h"
+#include "utils/histogram.h"
 
 #include <algorithm>
 #include <atomic>
@@ -34,39 +35,28 @@ static std::string make_val(int val_size) {
     return std::string(static_cast<size_t>(val_size), 'v');
 }
 
-// ── Latency histogram ─────────────────────────────────────────────────────────
+// ── Latency summary ───────────────────────────────────────────────────────────
 
-struct Stats {
-    std::vector<int64_t> latencies_ns;  // per-op latency in nanoseconds
-
-    void reserve(size_t n) { latencies_ns.reserve(n); }
-
-    void record(nanoseconds ns) {
-        latencies_ns.push_back(ns.count());
-    }
-
-    void merge(const Stats& other) {
-        latencies_ns.insert(latencies_ns.end(),
-                            other.latencies_ns.begin(),
-                            other.latencies_ns.end());
-    }
+struct BenchResult {
+    std::string name;
+    double      ops_per_sec;
+    double      mean_us;
+    double      p50_us;
+    double      p99_us;
+    double      p999_us;
+};
 
-    // Returns percentile (0-100) in microseconds.
-    double percentile(int p) {
-        if (latencies_ns.empty()) return 0;
-        std::sort(latencies_ns.begin(), latencies_ns.end());
-        size_t idx = static_cast<size_t>(p / 100.0 * latencies_ns.size());
-        if (idx >= latencies_ns.size()) idx = latencies_ns.size() - 1;
-        return latencies_ns[idx] / 1000.0;
-    }
+// Latencies are recorded in nanoseconds and reported in microseconds.
+static BenchResult summarize(std::string name, double ops_per_sec,
+                             const dkv::Histogram& hist) {
+    auto us = [&](double p) { return static_cast<double>(hist.percentile(p)) / 1000.0; };
+    return {std::move(name), ops_per_sec, hist.mean() / 1000.0, us(50), us(99), us(99.9)};
+}
 
-    double mean_us() {
-        if (latencies_ns.empty()) return 0;
-        double sum = 0;
-        for (auto v : latencies_ns) sum += v;
-        return (sum / latencies_ns.size()) / 1000.0;
-    }
-};
+static void record(dkv::Histogram& hist, high_resolution_clock::time_point start,
+                   high_resolution_clock::time_point end) {
+    hist.record(static_cast<uint64_t>(duration_cast<nanoseconds>(end - start).count()));
+}
 
 // ── Benchmark runners ─────────────────────────────────────────────────────────
 
@@ -77,19 +67,9 @@ struct BenchConfig {
     int val_size   = 64;
 };
 
-struct BenchResult {
-    std::string name;
-    double      ops_per_sec;
-    double      mean_us;
-    double      p50_us;
-    double      p99_us;
-    double      p999_us;
-};
-
 // Single-threaded SET benchmark
 BenchResult bench_set(dkv::StorageEngine& engine, const BenchConfig& cfg) {
-    Stats stats;
-    stats.reserve(static_cast<size_t>(cfg.ops));
+    dkv::Histogram hist;
 
     std::string val = make_val(cfg.val_size);
     dkv::Version ver{1000, 1};
@@ -104,19 +84,12 @@ BenchResult bench_set(dkv::StorageEngine& engine, const BenchConfig& cfg) {
         auto op_start = high_resolution_clock::now();
         engine.set(make_key(i, cfg.key_size), val, ver);
         auto op_end   = high_resolution_clock::now();
-        stats.record(duration_cast<nanoseconds>(op_end - op_start));
+        record(hist, op_start, op_end);
     }
     auto t1 = high_resolution_clock::now();
 
     double elapsed_s = duration_cast<microseconds>(t1 - t0).count() / 1e6;
-    return {
-        "SET (1 thread)",
-        cfg.ops / elapsed_s,
-        stats.mean_us(),
-        stats.percentile(50),
-        stats.percentile(99),
-        stats.percentile(99'9)
-    };
+    return summarize("SET (1 thread)", cfg.ops / elapsed_s, hist);
 }
 
 // Single-threaded GET benchmark (keys inserted first)
@@ -128,8 +101,7 @@ BenchResult bench_get(dkv::StorageEngine& engine, const BenchConfig& cfg) {
         engine.set(make_key(i, cfg.key_size), val, ver);
     }
 
-    Stats stats;
-    stats.reserve(static_cast<size_t>(cfg.ops));
+    dkv::Histogram hist;
 
     auto t0 = high_resolution_clock::now();
     for (int i = 0; i < cfg.ops; ++i) {
@@ -137,26 +109,18 @@ BenchResult bench_get(dkv::StorageEngine& engine, const BenchConfig& cfg) {
         auto result   = engine.get(make_key(i, cfg.key_size));
         (void)result;
         auto op_end   = high_resolution_clock::now();
-        stats.record(duration_cast<nanoseconds>(op_end - op_start));
+        record(hist, op_start, op_end);
     }
     auto t1 = high_resolution_clock::now();
 
     double elapsed_s = duration_cast<microseconds>(t1 - t0).count() / 1e6;
-    return {
-        "GET (1 thread)",
-        cfg.ops / elapsed_s,
-        stats.mean_us(),
-        stats.percentile(50),
-        stats.percentile(99),
-        stats.percentile(99'9)
-    };
+    return summarize("GET (1 thread)", cfg.ops / elapsed_s, hist);
 }
 
 // Multi-threaded SET benchmark
 BenchResult bench_set_mt(dkv::StorageEngine& engine, const BenchConfig& cfg) {
     int ops_per_thread = cfg.ops / cfg.threads;
-    std::vector<Stats> per_thread_stats(static_cast<size_t>(cfg.threads));
-    for (auto& s : per_thread_stats) s.reserve(static_cast<size_t>(ops_per_thread));
+    std::vector<dkv::Histogram> per_thread(static_cast<size_t>(cfg.threads));
 
     std::string val = make_val(cfg.val_size);
     dkv::Version ver{1000, 1};
@@ -172,28 +136,20 @@ BenchResult bench_set_mt(dkv::StorageEngine& engine, const BenchConfig& cfg) {
                 auto op_start = high_resolution_clock::now();
                 engine.set(make_key(base + i, cfg.key_size), val, ver);
                 auto op_end   = high_resolution_clock::now();
-                per_thread_stats[static_cast<size_t>(t)].record(
-                    duration_cast<nanoseconds>(op_end - op_start));
+                record(per_thread[static_cast<size_t>(t)], op_start, op_end);
             }
         });
     }
     for (auto& th : threads) th.join();
     auto t1 = high_resolution_clock::now();
 
-    Stats combined;
-    combined.reserve(static_cast<size_t>(cfg.ops));
-    for (auto& s : per_thread_stats) combined.merge(s);
+    dkv::Histogram combined;
+    for (const auto& h : per_thread) combined.merge(h);
 
     int total_ops    = ops_per_thread * cfg.threads;
     double elapsed_s = duration_cast<microseconds>(t1 - t0).count() / 1e6;
-    return {
-        "SET (" + std::to_string(cfg.threads) + " threads)",
-        total_ops / elapsed_s,
-        combined.mean_us(),
-        combined.percentile(50),
-        combined.percentile(99),
-        combined.percentile(99'9)
-    };
+    return summarize("SET (" + std::to_string(cfg.threads) + " threads)",
+                     total_ops / elapsed_s, combined);
 }
 
 // Multi-threaded GET benchmark (50% read / 50% write mixed)
@@ -206,8 +162,7 @@ BenchResult bench_mixed_mt(dkv::StorageEngine& engine, const BenchConfig& cfg) {
     }
 
     int ops_per_thread = cfg.ops / cfg.threads;
-    std::vector<Stats> per_thread_stats(static_cast<size_t>(cfg.threads));
-    for (auto& s : per_thread_stats) s.reserve(static_cast<size_t>(ops_per_thread));
+    std::vector<dkv::Histogram> per_thread(static_cast<size_t>(cfg.threads));
 
     std::atomic<int> counter{0};
     std::vector<std::thread> threads;
@@ -225,28 +180,20 @@ BenchResult bench_mixed_mt(dkv::StorageEngine& engine, const BenchConfig& cfg) {
                     engine.set(make_key(key_idx, cfg.key_size), val, ver);
                 }
                 auto op_end = high_resolution_clock::now();
-                per_thread_stats[static_cast<size_t>(t)].record(
-                    duration_cast<nanoseconds>(op_end - op_start));
+                record(per_thread[static_cast<size_t>(t)], op_start, op_end);
             }
         });
     }
     for (auto& th : threads) th.join();
     auto t1 = high_resolution_clock::now();
 
-    Stats combined;
-    combined.reserve(static_cast<size_t>(cfg.ops));
-    for (auto& s : per_thread_stats) combined.merge(s);
+    dkv::Histogram combined;
+    for (const auto& h : per_thread) combined.merge(h);
 
     int total_ops    = ops_per_thread * cfg.threads;
     double elapsed_s = duration_cast<microseconds>(t1 - t0).count() / 1e6;
-    return {
-        "MIXED 50/50 (" + std::to_string(cfg.threads) + " threads)",
-        total_ops / elapsed_s,
-        combined.mean_us(),
-        combined.percentile(50),
-        combined.percentile(99),
-        combined.percentile(99'9)
-    };
+    return summarize("MIXED 50/50 (" + std::to_string(cfg.threads) + " threads)",
+                     total_ops / elapsed_s, combined);
 }
 
 // ── Output ────────────────────────────────────────────────────────────────────
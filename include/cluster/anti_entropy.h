@@ -0,0 +1,136 @@
+#pragma once
+
+#include "cluster/hash_ring.h"
+#include "cluster/rpc_client.h"
+#include "network/protocol.h"
+#include "storage/storage_engine.h"
+#include "utils/token_bucket.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace dkv {
+
+/// Background Merkle-tree anti-entropy between replicas.
+///
+/// Every `interval_ms` the service picks the next peer (round-robin, DOWN
+/// nodes skipped) and walks the MerkleIndex attached to the storage engine
+/// top-down, restricted to the token ranges both nodes replicate:
+///
+///   1. AEHASH level 0 — one hash per chunk of RANGES_PER_CHUNK ranges
+///   2. AEHASH level 1 — one hash per range of the differing chunks
+///   3. AEHASH level 2 — one hash per leaf of the differing ranges
+///   4. AEKEYS        — key versions in the differing leaves
+///
+/// and then repairs only the keys whose versions differ, in both directions:
+/// newer entries are pulled (RGET, or a local tombstone for deleted keys)
+/// and applied through `Writer`; older or missing ones are pushed to the
+/// peer as RSET/RDEL.  Replicas that already agree cost one level-0
+/// exchange per round: a few bytes per RANGES_PER_CHUNK ranges.
+///
+/// Throttling: at most `max_leaves_per_round` leaves are listed per round,
+/// and the bytes streamed (key listings plus repaired values) are paced by
+/// a token bucket of `rate_bytes_per_sec`.
+class AntiEntropy {
+public:
+    struct Options {
+        uint32_t interval_ms          = 10000;       // between rounds; 0 = manual
+        uint64_t rate_bytes_per_sec   = 4ull << 20;  // 0 = unlimited
+        size_t   max_leaves_per_round = 256;
+    };
+
+    struct Stats {
+        uint64_t rounds           = 0;
+        uint64_t failed_rounds    = 0;  // peer unreachable or ring mismatch
+        uint64_t ranges_differing = 0;
+        uint64_t leaves_differing = 0;
+        uint64_t keys_pulled      = 0;
+        uint64_t keys_pushed      = 0;
+        uint64_t bytes_streamed   = 0;
+    };
+
+    /// Applies a repaired entry locally (WAL + engine).
+    using Writer = std::function<void(const std::string& key,
+                                      const std::string& value, bool is_del,
+                                      const Version& version)>;
+
+    /// Whether a peer is worth contacting (membership check).
+    using Availability = std::function<bool(uint32_t node_id)>;
+
+    static constexpr uint32_t RANGES_PER_CHUNK = 64;
+
+    AntiEntropy(StorageEngine& engine, const HashRing& ring, RpcClient& rpc,
+                uint32_t node_id, uint32_t replication_factor, Writer writer,
+                Availability available, Options options);
+
+    /// Stops the background thread.
+    ~AntiEntropy();
+
+    /// Start the background thread (no-op when interval_ms is 0).
+    void start();
+
+    /// Stop and join the background thread.  Idempotent.
+    void stop();
+
+    /// Run one synchronous round against `peer`.  Returns false if the
+    /// exchange failed (unreachable peer, ring mismatch, no index).
+    bool sync_with(const NodeInfo& peer);
+
+    Stats stats() const;
+
+    /// Answer an AEHASH or AEKEYS request from the local index.  Returns a
+    /// text-protocol response (value or error).
+    static std::string serve(const StorageEngine& engine, const Command& cmd);
+
+    // Non-copyable
+    AntiEntropy(const AntiEntropy&) = delete;
+    AntiEntropy& operator=(const AntiEntropy&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    StorageEngine&  engine_;
+    const HashRing& ring_;
+    RpcClient&      rpc_;
+    uint32_t        node_id_;
+    uint32_t        replication_factor_;
+    Writer          writer_;
+    Availability    available_;
+    Options         options_;
+
+    mutable std::mutex      mutex_;
+    std::condition_variable cv_;
+    bool                    stopping_  = false;
+    uint32_t                last_peer_ = 0;
+    Stats                   stats_;
+
+    // Paces bytes sent; may go negative after a large transfer.
+    TokenBucket bucket_;
+
+    std::thread worker_;
+
+    void run();
+
+    /// Ask `peer` for hashes at `level` of `ids`; false on any failure.
+    bool fetch_hashes(const NodeInfo& peer, uint64_t fingerprint,
+                      uint8_t level, const std::vector<uint32_t>& ids,
+                      std::vector<uint64_t>& out);
+
+    /// Pull/push every key whose version differs in `leaves`.
+    bool repair_leaves(const NodeInfo& peer, uint64_t fingerprint,
+                       const std::vector<uint32_t>& leaves);
+
+    /// Charge `bytes` to the token bucket and sleep until it is covered
+    /// (or stop() is called).
+    void throttle(size_t bytes);
+};
+
+}  // namespace dkv
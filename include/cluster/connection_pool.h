@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <mutex>
 #include <optional>
@@ -38,6 +40,12 @@ public:
     /// Close all pooled connections (e.g., during shutdown).
     void close_all();
 
+    /// Per-request timeout new connections are configured with.
+    int timeout_ms() const { return timeout_ms_; }
+
+    /// Connections currently idle in the pool, across all peers.
+    size_t idle_connections() const { return idle_.load(std::memory_order_relaxed); }
+
     ~ConnectionPool();
 
     // Non-copyable
@@ -50,6 +58,7 @@ private:
 
     std::mutex mutex_;
     std::unordered_map<std::string, std::vector<int>> pools_;  // address → idle fds
+    std::atomic<size_t> idle_{0};
 
     /// Create a new TCP connection to the given address.
     /// Returns the fd, or -1 on failure.
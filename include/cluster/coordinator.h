@@ -1,11 +1,17 @@
 #pragma once
 
+#include "cluster/anti_entropy.h"
 #include "cluster/connection_pool.h"
 #include "cluster/hash_ring.h"
 #include "cluster/membership.h"
+#include "cluster/dynamic_snitch.h"
+#include "cluster/gossip.h"
+#include "cluster/hot_keys.h"
+#include "cluster/rebalancer.h"
+#include "cluster/rpc_client.h"
 #include "network/protocol.h"
-#include "network/thread_pool.h"
 #include "replication/hint_store.h"
+#include "replication/repair_queue.h"
 #include "storage/snapshot.h"
 #include "storage/storage_engine.h"
 #include "storage/wal.h"
@@ -13,10 +19,10 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
 #include <vector>
@@ -28,12 +34,29 @@ namespace dkv {
 /// Phase 4 (single-owner routing) is extended in Phase 5 with quorum
 /// scatter-gather: SET/DEL scatter to all N replicas in parallel and wait
 /// for W acknowledgements; GET sends to R replicas and returns the highest-
-/// version value with async read repair for stale replicas.
+/// version value with async read repair for stale replicas.  By default only
+/// one of the R replicas returns the value; the others answer RDIGEST with
+/// just their version, and a newer version among them triggers a full read
+/// from that replica.
 ///
-/// PING is always handled locally.
+/// Inter-node traffic goes through an asynchronous RpcClient: a quorum
+/// operation sends to every replica at once and replies from a completion
+/// callback as soon as the quorum outcome is known (W acks, R reads, or too
+/// many failures to reach them); stragglers finish in the background.
+/// Optionally, a read still short of R answers after roughly the p95 replica
+/// latency is hedged to a spare replica.
+///
+/// Client reads are also counted by a hot-key detector; with the read cache
+/// enabled, reads of the hottest keys are answered from this node for a
+/// short lease instead of by R replicas (see HotKeyCache).
+///
+/// PING, HOTKEYS and STATS are always handled locally.
 /// FWD frames have their hop counter decremented; ROUTING_LOOP is returned
 /// if TTL reaches 0.
-/// RSET/RDEL/RGET are internal replication commands executed locally always.
+/// RSET/RDEL/RGET/RDIGEST are internal replication commands executed locally
+/// always; AEHASH/AEKEYS are answered from the local Merkle index, and
+/// RSCAN/RLOAD/RING by the Rebalancer.  While a membership change is staged,
+/// writes also go to the replicas it adds (see Rebalancer).
 class Coordinator {
 public:
     /// @param engine              Local storage engine.
@@ -59,22 +82,149 @@ public:
 
     ~Coordinator();
 
+    /// Receives the text-protocol response to a command.  May be invoked on
+    /// the calling thread or on the RPC client's event loop thread.
+    using Reply = std::function<void(std::string)>;
+
     /// Handle a command: quorum-scatter for SET/DEL/GET, execute locally for
-    /// RSET/RDEL/RGET/FWD, always local for PING.
+    /// RSET/RDEL/RGET/RDIGEST/FWD, always local for PING.  `done` is called exactly
+    /// once; for quorum operations that happens as soon as the quorum outcome
+    /// is known, without blocking the caller in the meantime.
+    void handle_command_async(Command cmd, Reply done);
+
+    /// Blocking convenience wrapper around handle_command_async().
     std::string handle_command(const Command& cmd);
 
+    /// Answer a binary request that needs no other node (RSET/RDEL/RGET/
+    /// RDIGEST and RBATCH) on the calling thread, appending the response
+    /// frame for `request_id` to `out` without going through a text reply.
+    /// Returns false, leaving `out` alone, for anything else: that goes
+    /// through handle_command_async().
+    bool execute_binary(const Command& cmd, uint32_t request_id, uint8_t flags,
+                        std::string& out);
+
     /// Called by Phase 6 heartbeat when a previously-DOWN node responds to a
-    /// PING.  Replays all stored hints and removes them on success (§9.D).
+    /// PING.  Streams the stored hints to it in pipelined windows, removing
+    /// each as it is acknowledged (§9.D).  Stops at the first failure; the
+    /// next call resumes with whatever is still pending.
     void replay_hints_for(uint32_t target_node_id,
                           const std::string& target_address);
 
+    /// Queue replay_hints_for() on the hint replay worker and return at
+    /// once.  The Membership rejoin callback uses this: it runs on the
+    /// heartbeat or gossip thread, whose period must not stretch while a
+    /// replay streams.  A node already queued is not queued twice.
+    void schedule_hint_replay(uint32_t target_node_id,
+                              const std::string& target_address);
+
+    /// Hints waiting for replay, across all target nodes.
+    size_t pending_hints() const { return hints_.size(); }
+
+    /// Per-target size/age caps and fsync policy of the hint log.
+    void set_hint_limits(const HintStore::Options& options) {
+        hints_.set_options(options);
+    }
+
+    HintStore::Stats hint_stats() const { return hints_.stats(); }
+
     /// Register the cluster membership tracker.  When set, quorum_write will
     /// immediately store a hint (no TCP attempt) for DOWN replicas, and
-    /// quorum_read will skip DOWN replicas rather than timing out on them.
+    /// quorum_read will skip DOWN replicas rather than timing out on them and
+    /// ask suspect ones (late or SUSPECTED, see Membership::is_suspect())
+    /// only after the healthy replicas of the preference list.
     /// Safe to call before the first command arrives.  Raw pointer — the
     /// Membership object is owned by main() and outlives the coordinator.
     void set_membership(Membership* membership);
 
+    /// Coalesce concurrent RSET/RDEL frames bound for the same replica into
+    /// RBATCH frames of up to `max_bytes` (0 = off), holding the first write
+    /// of a batch for at most `linger_us`.  See RpcClient::set_batching().
+    void set_replication_batching(size_t max_bytes, uint32_t linger_us);
+
+    /// Enable hedged reads: a GET still short of R answers after
+    /// max(p95 replica read latency, `min_delay_us`) is also sent to the
+    /// next replica in the preference list, and a replica that fails
+    /// outright is replaced by a spare immediately.  Off by default.
+    void set_read_hedging(bool enabled, uint32_t min_delay_us);
+
+    /// Toggle digest reads (on by default): with R > 1, fetch the value from
+    /// one replica and only versions from the rest.
+    void set_digest_reads(bool enabled) {
+        digest_reads_.store(enabled, std::memory_order_relaxed);
+    }
+
+    /// Toggle latency-aware replica selection (on by default): reads ask
+    /// the R replicas the DynamicSnitch ranks fastest rather than the first
+    /// R in ring order.
+    void set_dynamic_snitch(bool enabled) {
+        snitch_enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    /// Per-peer latency scores behind replica selection.
+    const DynamicSnitch& snitch() const { return snitch_; }
+
+    /// True while this node snapshots; binary replies then carry
+    /// BINARY_FLAG_BUSY so peers read from other replicas.
+    bool busy() const { return busy_.load(std::memory_order_relaxed) > 0; }
+
+    /// Cache reads of up to `capacity` hot keys (0 = detect only, the
+    /// default) for `lease_ms` each.  A cached read can miss a write made
+    /// through another coordinator for up to the lease.
+    void set_hot_key_cache(size_t capacity, uint32_t lease_ms) {
+        hot_keys_.set_cache(capacity, lease_ms);
+    }
+
+    /// Hot-key detector and read cache.
+    const HotKeyCache& hot_keys() const { return hot_keys_; }
+
+    /// Reads whose digests disagreed with the value, forcing a second RGET.
+    uint64_t digest_mismatches() const {
+        return digest_mismatches_.load(std::memory_order_relaxed);
+    }
+
+    /// Limits for the read-repair queue (see RepairQueue::Options).
+    void set_read_repair_limits(const RepairQueue::Options& options);
+
+    /// Read-repair queue depth and throughput.
+    RepairQueue::Stats read_repair_stats() const;
+
+    /// Build a Merkle index over the ring's token ranges, attach it to the
+    /// storage engine, and start background anti-entropy with the other
+    /// replicas (rounds every `options.interval_ms`; 0 = only on demand via
+    /// anti_entropy()->sync_with()).  Call once, after set_membership().
+    void start_anti_entropy(const AntiEntropy::Options& options);
+
+    /// The anti-entropy service, or nullptr if it was never started.
+    AntiEntropy* anti_entropy() { return anti_entropy_.get(); }
+
+    /// Enable online membership changes: serve RSCAN/RLOAD/RING from peers
+    /// and accept DECOMMISSION.  Call once, after start_anti_entropy() (a
+    /// committed change rebuilds its Merkle index).
+    void start_rebalancer(const Rebalancer::Options& options);
+
+    /// The rebalancer, or nullptr if it was never started.
+    Rebalancer* rebalancer() { return rebalancer_.get(); }
+
+    /// Join the cluster as `self_address` in the background (see
+    /// Rebalancer::join()).  Requires start_rebalancer().
+    void join_cluster_async(const std::string& self_address);
+
+    /// Detect failures with SWIM gossip (see Gossip) instead of a Heartbeat
+    /// pinging every peer: answer GOSSIP frames from peers and probe one
+    /// member per period.  Requires set_membership(); call once.
+    void start_gossip(const Gossip::Options& options);
+
+    /// The gossip service, or nullptr if it was never started.
+    Gossip* gossip() { return gossip_.get(); }
+
+    /// Hedged requests sent so far.
+    uint64_t hedged_reads() const {
+        return hedged_reads_.load(std::memory_order_relaxed);
+    }
+
+    /// Batching counters from the inter-node RPC client.
+    RpcClient::BatchStats replication_batch_stats() const;
+
     // Non-copyable
     Coordinator(const Coordinator&) = delete;
     Coordinator& operator=(const Coordinator&) = delete;
@@ -106,60 +256,187 @@ private:
     // two operations from this node land in the same millisecond (LWW fix).
     std::atomic<uint64_t> last_ts_{0};
 
-    // ── Quorum thread pool (Task 2: replaces per-request thread spawns) ───────
-    std::unique_ptr<ThreadPool> quorum_pool_;
+    // ── Inter-node RPC (replaces per-replica blocking send/recv) ─────────────
+    std::unique_ptr<RpcClient> rpc_;
 
-    static constexpr uint32_t DEFAULT_HOPS = 2;
+    // ── Digest reads ─────────────────────────────────────────────────────────
+    std::atomic<bool>     digest_reads_{true};
+    std::atomic<uint64_t> digest_mismatches_{0};
 
-    // ── Background repair queue (Task 1: replaces detached thread) ───────────
-    std::queue<std::function<void()>> repair_queue_;
-    std::mutex                        repair_mutex_;
-    std::condition_variable           repair_cv_;
-    std::thread                       repair_thread_;
-    std::atomic<bool>                 repair_running_{false};
+    // ── Replica selection ────────────────────────────────────────────────────
+    std::atomic<bool> snitch_enabled_{true};
+    DynamicSnitch     snitch_;
+    std::atomic<int>  busy_{0};  // snapshots in progress
 
-    /// Worker function that drains repair_queue_ until repair_running_ = false.
-    void repair_worker();
+    // ── Hot keys ─────────────────────────────────────────────────────────────
+    HotKeyCache hot_keys_;
 
-    // ── Quorum operations ────────────────────────────────────────────────────
+    /// Keys listed by HOTKEYS.
+    static constexpr size_t HOT_KEYS_REPORTED = 32;
 
-    /// Scatter a SET or DEL to all N replicas; wait for W acks.
-    /// Returns +OK or -ERR QUORUM_FAILED.
-    std::string quorum_write(const std::string& key, const std::string& value,
-                             bool is_del);
+    // ── Hedged reads ─────────────────────────────────────────────────────────
+    std::atomic<bool>     hedge_reads_{false};
+    std::atomic<uint32_t> hedge_min_delay_us_{1000};
+    std::atomic<uint64_t> hedged_reads_{0};
 
-    /// Send GET to R replicas; return highest-version value.
-    /// Triggers async read repair for stale replicas.
-    std::string quorum_read(const std::string& key);
+    // Recent remote read latencies (µs), a ring of samples; the p95 is
+    // recomputed every LATENCY_RECOMPUTE samples and cached.
+    static constexpr size_t LATENCY_SAMPLES   = 512;
+    static constexpr size_t LATENCY_RECOMPUTE = 64;
+    std::mutex            latency_mutex_;
+    std::vector<uint32_t> latency_samples_;
+    size_t                latency_next_ = 0;
+    uint64_t              latency_seen_ = 0;
+    std::atomic<uint32_t> read_p95_us_{0};
+
+    /// Record one remote RGET round trip.
+    void record_read_latency(uint32_t micros);
+
+    /// Delay before a read is hedged.
+    std::chrono::microseconds hedge_delay() const;
+
+    static constexpr uint32_t DEFAULT_HOPS = 2;
+
+    // ── Anti-entropy (Merkle-tree comparison with the other replicas) ───────
+    std::unique_ptr<AntiEntropy> anti_entropy_;
+
+    // ── Online membership changes ───────────────────────────────────────────
+    std::unique_ptr<Rebalancer> rebalancer_;
+
+    // ── SWIM gossip (optional) ───────────────────────────────────────────────
+    // A client of its own, so probes never queue behind replication traffic.
+    std::unique_ptr<RpcClient>          gossip_rpc_;
+    std::unique_ptr<RpcGossipTransport> gossip_transport_;
+    std::unique_ptr<Gossip>             gossip_;
+    std::mutex                  change_mutex_;
+    std::thread                 change_thread_;  // join or DECOMMISSION
+    bool                        change_running_ = false;
+
+    // ── Hint replay worker (started by the first schedule_hint_replay) ─────
+    std::mutex                                     replay_mutex_;
+    std::condition_variable                        replay_cv_;
+    std::deque<std::pair<uint32_t, std::string>>   replay_queue_;
+    bool                                           replay_stop_ = false;
+    std::thread                                    replay_thread_;
+
+    void replay_loop();
+
+    /// Run `fn` on change_thread_; false if a change is already running.
+    bool run_change_async(std::function<void()> fn);
+
+    /// Ring flip on this node: track the new peer (or forget the old one)
+    /// and rebuild the Merkle index over the new tokens.
+    void on_ring_commit(const Rebalancer::Change& change);
+
+    /// Send the write to replicas that a staged ring adds, outside the
+    /// write quorum.
+    void handover_write(const std::string& key, const std::string& value,
+                        bool is_del, const Version& version,
+                        ReplicaList replicas,
+                        std::shared_ptr<const std::string>& frame);
+
+    // ── Background read repair (deduplicated, batched per replica) ──────────
+    std::unique_ptr<RepairQueue> repairs_;
+
+    /// RepairQueue sender: apply locally, or RSET the batch to the replica
+    /// through the batching RPC path and wait for every ack.
+    size_t send_repair_batch(const NodeInfo& target,
+                             const std::vector<RepairItem>& batch);
+
+    /// Send pre-encoded RSET/RDEL frames to `address` through the batching
+    /// RPC path and wait for every reply.  Returns which were acknowledged.
+    std::vector<bool> send_writes(
+        const std::string& address,
+        std::vector<std::shared_ptr<const std::string>> frames);
+
+    // ── Hinted handoff replay ────────────────────────────────────────────────
+    /// Hints sent to a recovered node at once.
+    static constexpr size_t HINT_REPLAY_WINDOW = 256;
+
+    // ── Quorum operations ────────────────────────────────────────────────────
+
+    /// Scatter a SET or DEL to all N replicas.  Replies +OK as soon as W
+    /// acks arrive, or -ERR QUORUM_FAILED once W can no longer be reached.
+    /// Writes to slow replicas keep going (and are hinted if they fail).
+    void quorum_write(std::string key, std::string value, bool is_del,
+                      Reply done);
+
+    /// Send GET to R replicas (RGET to one, RDIGEST to the rest, plus hedges
+    /// if enabled); reply with the highest-version value once R have
+    /// answered or none are left to ask.
+    /// Triggers async read repair for stale replicas, including ones whose
+    /// answer arrives after the reply.
+    void quorum_read(std::string key, Reply done);
+
+    /// `replicas` with suspect (but not DOWN) nodes among the first
+    /// `primaries` moved behind the healthy ones; stable otherwise.  Returns
+    /// `replicas` itself when nothing needs to move, else a view of `buf`.
+    ReplicaList prefer_healthy(ReplicaList replicas, size_t primaries,
+                               std::vector<NodeInfo>& buf) const;
+
+    /// Per-read bookkeeping shared by the replica callbacks and hedge timer.
+    struct ReadState;
+
+    /// Send the RGET for slot `index` of `st` (reserved under its mutex), or
+    /// serve it from the local engine.
+    void read_dispatch(const std::shared_ptr<ReadState>& st, size_t index);
+
+    /// Record one replica's answer and, once the outcome is known, reply,
+    /// contact a spare, or schedule read repair for a stale straggler.
+    void read_complete(const std::shared_ptr<ReadState>& st, size_t index,
+                       bool ok, bool found, std::string value,
+                       const Version& version);
+
+    // ── Multi-key operations ─────────────────────────────────────────────────
+
+    /// MGET: pick each key's R replicas as quorum_read does (hot-key cache,
+    /// snitch, suspects last), passing over DOWN ones since there are no
+    /// hedges or spares to fall back on, then send every replica
+    /// node one RBATCH of RGETs for all its keys.  Once the batches are
+    /// answered each key is resolved by LWW and repaired like a single read;
+    /// the reply lists the keys in request order.
+    void multi_get(std::string args, Reply done);
+
+    /// MSET: version each key and send every replica node one RBATCH of the
+    /// RSETs it owns.  Replies +OK once every key has W acks, or
+    /// -ERR QUORUM_FAILED once some key can no longer reach W; failed
+    /// replicas are hinted per key.
+    void multi_set(std::string args, Reply done);
+
+    /// Per-command bookkeeping of multi_get() and multi_set().
+    struct MultiGetState;
+    struct MultiSetState;
+
+    /// Send `node` the RGETs for `slots` of an MGET, in as many RBATCH
+    /// frames as the request size needs; keys a reply had no room for are
+    /// asked for again.
+    void multi_get_send(const std::shared_ptr<MultiGetState>& st,
+                        const NodeInfo& node, const std::vector<size_t>& slots);
+
+    /// Resolve every key of a finished MGET and reply.  Fails the MGET with
+    /// REPLY_TOO_LARGE when the reply would not fit in a binary frame.
+    void multi_get_finish(const std::shared_ptr<MultiGetState>& st);
 
     // ── Inter-node helpers ───────────────────────────────────────────────────
 
-    /// Send RSET or RDEL directly to a remote replica.
-    /// Returns true if the replica acknowledged with +OK.
-    bool send_replication_write(const std::string& address,
-                                const std::string& key,
-                                const std::string& value,
-                                bool is_del, const Version& version);
-
-    /// Result of a remote RGET call.
-    struct RemoteGetResult {
-        bool        ok    = false;  // connection + parse succeeded
-        bool        found = false;
-        std::string value;
-        Version     version;
-    };
-
-    /// Send RGET to a remote replica and parse the versioned response.
-    RemoteGetResult send_replication_read(const std::string& address,
-                                          const std::string& key);
-
-    /// Fire-and-forget async RSET to stale replicas (read repair, §9.C).
-    void read_repair_async(const std::string& key, const std::string& value,
+    /// Queue RSETs to stale replicas on the repair queue (read repair, §9.C).
+    void read_repair_async(const std::string& key, std::string value,
                            const Version& latest_ver,
                            std::vector<NodeInfo> stale_replicas);
 
     // ── Legacy / local execution ─────────────────────────────────────────────
 
+    /// Execute every RSET/RDEL/RGET frame of an RBATCH payload locally and
+    /// append a VALUE frame for `request_id` whose bytes are one binary
+    /// response frame per inner request, each carrying its inner id.
+    void execute_batch(std::string_view payload, uint32_t request_id,
+                       uint8_t flags, std::string& out);
+
+    /// Execute a replication command locally and append its binary response
+    /// frame (built from the engine's result, with no text reply between).
+    void append_local_response(const Command& cmd, uint32_t request_id,
+                               uint8_t flags, std::string& out);
+
     /// Execute a command locally on the storage engine.
     /// Handles SET, GET, DEL, PING, RSET, RDEL, RGET.
     std::string execute_local(const Command& cmd);
@@ -179,6 +456,12 @@ private:
 
     /// Trigger a snapshot if ops_since_snapshot_ >= snapshot_interval_.
     void maybe_snapshot();
+
+    /// Log a versioned write to the WAL and apply it to the engine.  The
+    /// value is copied exactly once: into the WAL record, which is then
+    /// moved into the engine.
+    void apply_local_write(const std::string& key, const std::string& value,
+                           bool is_del, const Version& version);
 };
 
 }  // namespace dkv
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "cluster/hash_ring.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dkv {
+
+/// Latency-aware replica ranking for quorum reads ("dynamic snitch").
+///
+/// Every remote replica call is bracketed by begin()/end(), which keep per
+/// peer an EWMA of read latency, the number of requests still outstanding,
+/// and whether the peer last flagged itself busy (BINARY_FLAG_BUSY, set
+/// while it snapshots).  A peer's score is
+///
+///     (ewma_us + 1) * (1 + outstanding) * (busy ? busy_penalty : 1)
+///
+/// so a peer that is slow, queueing, or busy ranks behind the others; this
+/// node itself scores 0 (no network hop), and a peer never sampled scores
+/// low so it gets measured.  rank() keeps the ring order unless it is
+/// clearly worse (by more than `badness_threshold`) than the best order, so
+/// similar replicas keep serving the same keys.  Every `explore_every`-th
+/// read keeps the ring order regardless, which refreshes the scores of
+/// replicas that would otherwise never be asked again.
+class DynamicSnitch {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        double   alpha             = 0.1;   // EWMA weight of a new sample
+        double   badness_threshold = 0.1;   // reorder only if 10% better
+        double   busy_penalty      = 10.0;  // score multiplier while busy
+        uint32_t busy_hold_ms      = 2000;  // a busy flag counts this long
+        uint32_t explore_every     = 64;    // reads; 0 = never explore
+    };
+
+    struct Stats {
+        uint64_t reorders     = 0;  // reads sent away from the ring order
+        uint64_t explorations = 0;  // reads kept in ring order to sample
+    };
+
+    /// One peer's current figures.
+    struct Score {
+        double   ewma_us     = 0;
+        uint32_t outstanding = 0;
+        bool     busy        = false;
+        double   score       = 0;
+    };
+
+    DynamicSnitch() : DynamicSnitch(Options{}) {}
+    explicit DynamicSnitch(Options options) : options_(options) {}
+
+    /// A request to `node_id` was sent.
+    void begin(uint32_t node_id);
+
+    /// It completed after `elapsed`.  `sample` adds the latency to the EWMA
+    /// (reads; batched writes include linger time and only count as
+    /// outstanding).  A failure counts as at least twice the current
+    /// average.  `busy` is the peer's busy flag from the reply.
+    void end(uint32_t node_id, std::chrono::microseconds elapsed, bool ok,
+             bool busy, bool sample = true);
+
+    /// `replicas` in the order reads should use them, the first `primaries`
+    /// being the ones asked.  `self` scores 0.  Returns `replicas` itself
+    /// when the ring order stands, else a view of `buf`.
+    ReplicaList rank(ReplicaList replicas, size_t primaries, uint32_t self,
+                     std::vector<NodeInfo>& buf);
+
+    Score score(uint32_t node_id) const;
+
+    Stats stats() const;
+
+    /// Replace the clock (tests).
+    void set_clock(std::function<Clock::time_point()> now) { now_ = std::move(now); }
+
+private:
+    struct Peer {
+        double            ewma_us     = 0;
+        bool              sampled     = false;
+        uint32_t          outstanding = 0;
+        Clock::time_point busy_until{};
+    };
+
+    Options options_;
+    std::function<Clock::time_point()> now_ = [] { return Clock::now(); };
+
+    mutable std::mutex                 mutex_;
+    std::unordered_map<uint32_t, Peer> peers_;
+    uint64_t                           reads_ = 0;
+    Stats                              stats_;
+
+    /// Caller holds mutex_.
+    double score_locked(uint32_t node_id, uint32_t self, Clock::time_point now) const;
+};
+
+}  // namespace dkv
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "cluster/membership.h"
+#include "cluster/rpc_client.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace dkv {
+
+/// Carries gossip messages between nodes.
+class GossipTransport {
+public:
+    /// `ok` is false when the request was lost, failed or timed out.
+    using Done = std::function<void(bool ok, std::string reply)>;
+
+    virtual ~GossipTransport() = default;
+
+    /// Send `payload` to `address`; `done` is called exactly once, with the
+    /// reply or with ok = false no later than `timeout` from now.
+    virtual void request(const std::string& address, std::string payload,
+                         std::chrono::milliseconds timeout, Done done) = 0;
+};
+
+/// GossipTransport over GOSSIP frames of the inter-node protocol.
+class RpcGossipTransport : public GossipTransport {
+public:
+    explicit RpcGossipTransport(RpcClient& rpc) : rpc_(rpc) {}
+
+    void request(const std::string& address, std::string payload,
+                 std::chrono::milliseconds timeout, Done done) override;
+
+private:
+    RpcClient& rpc_;
+};
+
+/// SWIM-style failure detection and membership dissemination.
+///
+/// Instead of every node pinging every other node each interval (O(N^2)
+/// messages), each node runs one probe per protocol period:
+///
+///   1. PING the next member of a shuffled round-robin list (every member
+///      is probed within N periods) and wait `probe_timeout_ms`.
+///   2. No ACK: ask `indirect_probes` random members to PING it on our
+///      behalf (PINGREQ) and relay the ACK, which gets around a lossy link
+///      between just the two of us.
+///   3. Still nothing: the member becomes SUSPECT.  A suspect that does not
+///      refute within suspicion_mult * max(1, log10 N) periods is DEAD.
+///
+/// State changes travel piggybacked on the probe traffic: every message
+/// carries up to `max_piggyback` recent updates (node, state, incarnation),
+/// each retransmitted retransmit_mult * ceil(log10(N + 1)) times, so news
+/// reaches the whole cluster in O(log N) periods.  Incarnation numbers
+/// order the updates about one node; only the node itself increments its
+/// own, which is how it refutes a suspicion ("I am alive, incarnation
+/// i + 1").  A message to or from a node we think is SUSPECT or DEAD always
+/// carries that view, so a node that restarted learns about it and refutes
+/// at once.
+///
+/// The member list follows Membership (peers added or removed there, e.g.
+/// by the rebalancer, are picked up at the next period), and every state
+/// change is applied back to it (ALIVE -> record_success, SUSPECT ->
+/// SUSPECTED, DEAD -> DOWN) so its down/rejoin callbacks fire as before.
+/// They fire on the gossip thread, never on the transport's, and must not
+/// block it: the protocol period depends on it (the node's rejoin callback
+/// only queues the hint replay, see Coordinator::schedule_hint_replay()).
+class Gossip {
+public:
+    enum class State : uint8_t { ALIVE = 0, SUSPECT = 1, DEAD = 2 };
+
+    struct Options {
+        uint32_t period_ms        = 1000;
+        uint32_t probe_timeout_ms = 200;  // direct PING; PINGREQ gets the rest
+        uint32_t indirect_probes  = 3;    // k
+        uint32_t suspicion_mult   = 4;
+        uint32_t retransmit_mult  = 4;
+        uint32_t max_piggyback    = 8;    // updates per message
+        uint64_t seed             = 0;    // 0 = random
+    };
+
+    struct Stats {
+        uint64_t probes          = 0;  // direct PINGs sent
+        uint64_t indirect_probes = 0;  // PINGREQs sent
+        uint64_t messages_sent   = 0;  // requests + replies
+        uint64_t suspicions      = 0;  // members this node suspected
+        uint64_t deaths          = 0;  // suspects this node declared DEAD
+        uint64_t refutations     = 0;  // times this node refuted a rumour
+    };
+
+    /// One piggybacked update.
+    struct Update {
+        uint32_t node_id     = 0;
+        State    state       = State::ALIVE;
+        uint32_t incarnation = 0;
+    };
+
+    /// A protocol message: PING, PINGREQ (for `target`), ACK or NACK.
+    enum class Type : uint8_t { PING = 1, PINGREQ = 2, ACK = 3, NACK = 4 };
+    struct Message {
+        Type                type        = Type::PING;
+        uint32_t            sender      = 0;
+        uint32_t            incarnation = 0;  // the sender's
+        uint32_t            target      = 0;  // PINGREQ only
+        std::vector<Update> updates;
+    };
+
+    Gossip(Membership& membership, GossipTransport& transport, uint32_t node_id,
+           Options options);
+
+    ~Gossip();
+
+    /// Start/stop the background thread that calls tick() every period.
+    void start();
+    void stop();
+
+    /// Run one protocol period: sync the member list, expire suspicions,
+    /// apply queued Membership changes and start the next probe.
+    void tick();
+
+    /// Apply the Membership changes decided since the last call (tick()
+    /// does this too).
+    void apply_pending();
+
+    /// Handle a message from a peer; `reply` gets the response payload
+    /// (possibly later: a PINGREQ waits for its own probe), or an empty
+    /// string if the message is malformed.
+    void serve(std::string_view payload, std::function<void(std::string)> reply);
+
+    /// Replace the clock (simulations run in virtual time).
+    void set_clock(std::function<std::chrono::steady_clock::time_point()> now) {
+        now_ = std::move(now);
+    }
+
+    /// This node's view of `node_id` (ALIVE for unknown nodes).
+    State state_of(uint32_t node_id) const;
+
+    /// This node's own incarnation.
+    uint32_t incarnation() const;
+
+    Stats stats() const;
+
+    static std::string encode(const Message& m);
+    static bool decode(std::string_view payload, Message& m);
+
+    // Non-copyable
+    Gossip(const Gossip&) = delete;
+    Gossip& operator=(const Gossip&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Member {
+        std::string       address;
+        State             state       = State::ALIVE;
+        uint32_t          incarnation = 0;
+        Clock::time_point suspect_since;
+    };
+
+    /// An update waiting to be piggybacked.
+    struct Broadcast {
+        Update   update;
+        uint32_t transmits = 0;
+    };
+
+    /// A pending change to apply to Membership (on the gossip thread).
+    struct Effect {
+        uint32_t  node_id;
+        NodeState state;
+    };
+
+    Membership&      membership_;
+    GossipTransport& transport_;
+    uint32_t         node_id_;
+    Options          options_;
+    std::function<Clock::time_point()> now_ = [] { return Clock::now(); };
+
+    mutable std::mutex                   mutex_;
+    uint32_t                             incarnation_ = 0;
+    std::unordered_map<uint32_t, Member> members_;
+    std::vector<uint32_t>                probe_order_;
+    size_t                               probe_next_ = 0;
+    std::unordered_map<uint32_t, Broadcast> broadcasts_;  // by node id
+    std::vector<Effect>                  effects_;
+    std::mt19937_64                      rng_;
+    Stats                                stats_;
+
+    std::condition_variable cv_;
+    bool                    running_ = false;
+    std::thread             thread_;
+
+    /// Background loop.
+    void run();
+
+    /// Probe `target` (steps 1-3 above).
+    void probe(uint32_t target, const std::string& address);
+
+    /// Send a message to member `to`, counting it.  `done` as in
+    /// GossipTransport.
+    void send(uint32_t to, const std::string& address, Message m,
+              std::chrono::milliseconds timeout, GossipTransport::Done done);
+
+    /// Fill `m.updates` for a message to `to`.  Caller holds mutex_.
+    void piggyback_locked(Message& m, uint32_t to);
+
+    /// Process a received message's sender incarnation and updates.
+    /// Caller holds mutex_.
+    void absorb_locked(const Message& m);
+
+    /// Apply one update if it is news; queue it for dissemination and its
+    /// effect on Membership.  Caller holds mutex_.
+    void apply_locked(const Update& u);
+
+    /// Mark `target` SUSPECT (or, if already DEAD, nothing).  Caller holds
+    /// mutex_.
+    void suspect_locked(uint32_t target);
+
+    /// The target answered a probe.  Caller holds mutex_.
+    void alive_locked(uint32_t target);
+
+    /// Queue `u` for dissemination.  Caller holds mutex_.
+    void broadcast_locked(const Update& u);
+
+    /// Members other than `a` and `b` that we believe ALIVE, at most `k`,
+    /// chosen at random.  Caller holds mutex_.
+    std::vector<std::pair<uint32_t, std::string>> pick_locked(size_t k, uint32_t a,
+                                                              uint32_t b);
+
+    /// Refresh members_ from Membership.  Caller holds mutex_.
+    void sync_locked(const std::vector<NodeStatus>& peers);
+
+    Clock::duration suspicion_timeout_locked() const;
+    uint32_t        retransmit_limit_locked() const;
+};
+
+}  // namespace dkv
@@ -1,8 +1,16 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -15,13 +23,134 @@ struct NodeInfo {
     std::string address;        // "ip:port"
 };
 
+/// A read-only list of nodes: either a contiguous array, or indices into
+/// one (a ring's preference lists store owner indices, not NodeInfo copies).
+/// Cheap to copy; it borrows, so it lives no longer than what it points at.
+class ReplicaList {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = NodeInfo;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const NodeInfo*;
+        using reference         = const NodeInfo&;
+
+        iterator() = default;
+        iterator(const uint32_t* idx, const NodeInfo* nodes, size_t i)
+            : idx_(idx), nodes_(nodes), i_(i) {}
+
+        reference operator*() const { return idx_ ? nodes_[idx_[i_]] : nodes_[i_]; }
+        pointer operator->() const { return &**this; }
+        iterator& operator++() { ++i_; return *this; }
+        iterator operator++(int) { iterator t = *this; ++i_; return t; }
+        bool operator==(const iterator& o) const { return i_ == o.i_; }
+
+    private:
+        const uint32_t* idx_   = nullptr;
+        const NodeInfo* nodes_ = nullptr;
+        size_t          i_     = 0;
+    };
+
+    ReplicaList() = default;
+    /// `size` entries nodes[idx[0]], nodes[idx[1]], ...
+    ReplicaList(const uint32_t* idx, const NodeInfo* nodes, size_t size)
+        : idx_(idx), nodes_(nodes), size_(size) {}
+    ReplicaList(std::span<const NodeInfo> nodes)
+        : nodes_(nodes.data()), size_(nodes.size()) {}
+    ReplicaList(const std::vector<NodeInfo>& nodes)
+        : nodes_(nodes.data()), size_(nodes.size()) {}
+
+    size_t size() const { return size_; }
+    bool   empty() const { return size_ == 0; }
+    const NodeInfo& operator[](size_t i) const {
+        return idx_ ? nodes_[idx_[i]] : nodes_[i];
+    }
+    const NodeInfo& front() const { return (*this)[0]; }
+
+    /// The first `n` entries (n <= size()).
+    ReplicaList first(size_t n) const { return ReplicaList(idx_, nodes_, n); }
+
+    iterator begin() const { return {idx_, nodes_, 0}; }
+    iterator end() const { return {idx_, nodes_, size_}; }
+
+private:
+    const uint32_t* idx_   = nullptr;  // null: nodes_ is the list itself
+    const NodeInfo* nodes_ = nullptr;
+    size_t          size_  = 0;
+};
+
+/// Immutable, flattened copy of the ring used for every lookup.
+///
+/// Tokens are kept in Eytzinger (BFS) order so the upper-bound search is a
+/// branch-free descent whose next cache lines can be prefetched, and the
+/// distinct-node preference list starting at every token is precomputed,
+/// so a lookup is one search plus a slice of an array: no allocation, no
+/// string copies.  The lists hold owner indices into nodes(), four bytes an
+/// entry instead of a NodeInfo copy.  Lists hold at most MAX_REPLICAS nodes; larger requests
+/// are clipped.
+class RingSnapshot {
+public:
+    static constexpr size_t MAX_REPLICAS = 16;
+
+    RingSnapshot() = default;
+    RingSnapshot(const std::map<uint64_t, uint32_t>& ring,
+                 const std::unordered_map<uint32_t, std::string>& nodes,
+                 uint64_t version);
+
+    /// The first `count` distinct nodes clockwise from `position`.
+    ReplicaList replicas_at(uint64_t position, size_t count) const;
+
+    /// Index (into tokens()) of the first token strictly above `position`,
+    /// wrapping to 0.  Requires a non-empty ring.
+    size_t token_index(uint64_t position) const;
+
+    const std::vector<uint64_t>& tokens() const { return tokens_; }
+    const std::vector<NodeInfo>& nodes() const { return nodes_; }
+    /// Index into nodes() of the owner of each token.
+    const std::vector<uint32_t>& owners() const { return owners_; }
+    uint64_t version() const { return version_; }
+    size_t   size() const { return tokens_.size(); }
+    size_t   node_count() const { return nodes_.size(); }
+
+private:
+    uint64_t              version_ = 0;
+    std::vector<uint64_t> tokens_;     // ascending
+    std::vector<NodeInfo> nodes_;      // by node id
+    std::vector<uint32_t> owners_;     // per token, index into nodes_
+    std::vector<uint64_t> eytzinger_;  // tokens_ in BFS order, 1-based
+    std::vector<uint32_t> rank_;       // eytzinger_ slot → index in tokens_
+    size_t                depth_ = 0;  // entries per preference list
+    std::vector<uint32_t> lists_;      // depth_ entries per token, into nodes_
+};
+
 /// Consistent hash ring with virtual nodes using MurmurHash3.
 ///
 /// Each physical node is mapped to `num_vnodes` positions on a 64-bit
 /// hash ring.  Key lookups walk clockwise (via upper_bound + wrap) to
 /// find the owning node.
+///
+/// Membership changes rebuild a RingSnapshot and publish it with a single
+/// atomic store (RCU): lookups load the current snapshot and take no lock.
+/// A replaced snapshot is retired rather than freed, and reclaimed by a
+/// later change once it is both older than the last RETIRED_SNAPSHOTS
+/// retired ones and was retired more than the grace period ago: a
+/// ReplicaList or snapshot reference from a lookup stays valid for at least
+/// that long after the ring moves on, far longer than a request in flight
+/// holds one.  Hold copies for anything longer.
+///
+/// A membership change can also be staged: the ring it would produce is
+/// published as pending() next to the current one, so writes can reach the
+/// future owners while data is handed over, and commit_pending() later makes
+/// it current in one step.
 class HashRing {
 public:
+    /// Retired snapshots always kept alive for readers still holding them.
+    static constexpr size_t RETIRED_SNAPSHOTS = 8;
+    static constexpr std::chrono::milliseconds DEFAULT_RETIRE_GRACE{30000};
+
+    explicit HashRing(std::chrono::milliseconds retire_grace = DEFAULT_RETIRE_GRACE);
+
     /// Add a physical node with `num_vnodes` virtual nodes.
     void add_node(uint32_t node_id, const std::string& address,
                   uint32_t num_vnodes = 128);
@@ -29,27 +158,112 @@ public:
     /// Remove all virtual nodes belonging to a physical node.
     void remove_node(uint32_t node_id);
 
+    /// Stage adding (or removing) a node without changing the current ring.
+    /// Replaces any change already staged.  Returns false when the change
+    /// is a no-op (node already present, or absent).
+    bool stage_add(uint32_t node_id, const std::string& address,
+                   uint32_t num_vnodes = 128);
+    bool stage_remove(uint32_t node_id);
+
+    /// The ring with the staged change applied, or nullptr if none is staged.
+    const RingSnapshot* pending() const {
+        return pending_.load(std::memory_order_acquire);
+    }
+
+    /// Make the staged ring current.  Returns false if nothing was staged.
+    bool commit_pending();
+
+    /// Drop the staged change.
+    void abort_pending();
+
     /// Lookup the node that owns a given key.
     /// Returns std::nullopt if the ring is empty.
     std::optional<NodeInfo> get_node(const std::string& key) const;
 
     /// Return up to `count` distinct physical nodes clockwise from the
     /// key's position.  Used for replication (replica set selection).
-    std::vector<NodeInfo> get_replica_nodes(const std::string& key,
-                                            size_t count) const;
+    ReplicaList get_replica_nodes(const std::string& key, size_t count) const;
+
+    /// Same as get_replica_nodes(), for a ring position instead of a key.
+    ReplicaList replicas_at(uint64_t position, size_t count) const;
+
+    /// Every vnode position, ascending.  Token i owns the positions in
+    /// [token i-1, token i); token 0 also owns everything past the last.
+    std::vector<uint64_t> tokens() const;
+
+    /// All registered physical nodes, ordered by node id.
+    std::vector<NodeInfo> nodes() const;
+
+    /// Bumped by every add_node()/remove_node(), so clients can tell a
+    /// stale copy of the ring from the current one.
+    uint64_t version() const { return snapshot().version(); }
+
+    /// The ring in the TOPOLOGY wire form, parsed by TokenRouter:
+    ///   <version> <replication_factor> <node_count> {<node_id> <address>}
+    ///   <token_count> {<token> <node_index>}
+    /// space-separated on one line; node_index points into the node list
+    /// and tokens are ascending.
+    std::string encode_topology(uint32_t replication_factor) const;
+
+    /// The current snapshot, for several lookups against one ring version.
+    const RingSnapshot& snapshot() const {
+        return *current_.load(std::memory_order_acquire);
+    }
 
     /// Number of virtual nodes on the ring.
-    size_t size() const { return ring_.size(); }
+    size_t size() const { return snapshot().size(); }
 
     /// Number of physical nodes registered.
-    size_t node_count() const { return nodes_.size(); }
+    size_t node_count() const { return snapshot().node_count(); }
 
-private:
-    /// The ring: hash position → node info.
-    std::map<uint64_t, NodeInfo> ring_;
+    /// Replaced snapshots not reclaimed yet.
+    size_t retired_count() const;
+
+    // Non-copyable
+    HashRing(const HashRing&) = delete;
+    HashRing& operator=(const HashRing&) = delete;
 
-    /// Track which physical nodes are registered (node_id → address).
+private:
+    /// Writers only: the ring as a sorted map (position → node id) and the
+    /// registered nodes (node_id → address).
+    mutable std::mutex                        writer_mutex_;
+    std::map<uint64_t, uint32_t>              ring_;
     std::unordered_map<uint32_t, std::string> nodes_;
+    uint64_t                                  version_ = 0;
+
+    // Staged change (valid while pending_ is set).
+    std::map<uint64_t, uint32_t>              staged_ring_;
+    std::unordered_map<uint32_t, std::string> staged_nodes_;
+
+    std::atomic<const RingSnapshot*> current_;
+    std::atomic<const RingSnapshot*> pending_{nullptr};
+
+    // Owners of the snapshots above, and of the replaced ones still kept
+    // (oldest first).  Writers only.
+    struct Retired {
+        std::unique_ptr<const RingSnapshot>   snapshot;
+        std::chrono::steady_clock::time_point at;
+    };
+    const std::chrono::milliseconds     retire_grace_;
+    std::unique_ptr<const RingSnapshot> current_owner_;
+    std::unique_ptr<const RingSnapshot> pending_owner_;
+    std::deque<Retired>                 retired_;
+
+    /// Keep `snap` for late readers, freeing retired snapshots past both
+    /// bounds.  Caller holds writer_mutex_.
+    void retire_locked(std::unique_ptr<const RingSnapshot> snap);
+
+    /// Build a snapshot of ring_/nodes_ and publish it.  Caller holds
+    /// writer_mutex_.
+    void publish_locked();
+
+    /// Place `num_vnodes` tokens for `node_id` into `ring`.
+    static void place_tokens(std::map<uint64_t, uint32_t>& ring,
+                             uint32_t node_id, uint32_t num_vnodes);
+
+    /// Publish staged_ring_/staged_nodes_ as pending().  Caller holds
+    /// writer_mutex_.
+    void stage_locked();
 };
 
 }  // namespace dkv
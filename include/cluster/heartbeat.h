@@ -7,24 +7,39 @@
 #include <cstdint>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace dkv {
 
 /// Sends periodic PING messages to all peers and updates Membership.
 ///
-/// A background thread wakes every `interval_ms` and sends a PING to
-/// each registered peer via a raw TCP connection.  Results are fed into
-/// the Membership object which owns the state machine.
+/// A background thread wakes every `interval_ms` and probes every
+/// registered peer at once: one PING goes out on each peer's persistent
+/// connection (opened with a non-blocking connect the first time, and again
+/// after a failure), then a single poll() loop collects the PONGs until all
+/// have answered or `timeout_ms` has passed.  A round therefore takes about
+/// the slowest peer's RTT, and at most `timeout_ms` however many peers are
+/// dead.  Results and RTTs are fed into the Membership object, which owns
+/// the state machine.
 ///
-/// The Coordinator's replay_hints_for() is called via the Membership
-/// rejoin callback when a DOWN node returns UP.
+/// When a DOWN node returns UP, the Membership rejoin callback queues the
+/// Coordinator's hint replay (schedule_hint_replay()); the replay itself
+/// runs on the Coordinator's worker, never on this thread.
 class Heartbeat {
 public:
+    struct Stats {
+        uint64_t rounds        = 0;
+        uint64_t probes        = 0;  // PINGs sent
+        uint64_t failures      = 0;  // probes without a PONG in time
+        uint64_t connects      = 0;  // connections opened
+        uint64_t last_round_us = 0;  // duration of the last round
+    };
+
     /// @param membership      Shared membership tracker (must outlive Heartbeat).
     /// @param node_id         This node's own id (used to skip self-pings).
     /// @param interval_ms     How often to ping each peer (ms).
-    /// @param timeout_ms      Socket read/write timeout for PING (ms).
+    /// @param timeout_ms      Deadline for a PONG, connect included (ms).
     Heartbeat(Membership& membership, uint32_t node_id,
               int interval_ms = 1000, int timeout_ms = 500);
 
@@ -36,11 +51,29 @@ public:
     /// Stop the background ping thread (blocks until thread joins).
     void stop();
 
+    Stats stats() const;
+
     // Non-copyable
     Heartbeat(const Heartbeat&) = delete;
     Heartbeat& operator=(const Heartbeat&) = delete;
 
 private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Persistent connection to one peer (heartbeat thread only).
+    struct Probe {
+        uint32_t          node_id = 0;
+        std::string       address;
+        int               fd = -1;
+        bool              connected = false;
+        bool              reused    = false;  // open before this round
+        bool              retried   = false;  // reconnected once this round
+        bool              waiting   = false;  // PING sent, no PONG yet
+        std::string       out;                // unsent part of the PING
+        std::string       in;                 // partial response line
+        Clock::time_point sent_at;
+    };
+
     Membership& membership_;
     uint32_t    node_id_;
     int         interval_ms_;
@@ -49,11 +82,39 @@ private:
     std::atomic<bool> running_{false};
     std::thread       thread_;
 
+    std::unordered_map<uint32_t, Probe> probes_;  // by node id
+
+    std::atomic<uint64_t> rounds_{0};
+    std::atomic<uint64_t> pings_{0};
+    std::atomic<uint64_t> failures_{0};
+    std::atomic<uint64_t> connects_{0};
+    std::atomic<uint64_t> last_round_us_{0};
+
     /// Background loop.
     void run();
 
-    /// Send one PING to `address` and return true if +PONG is received.
-    bool ping_node(const std::string& address) const;
+    /// Probe every peer once and record the results.
+    void round();
+
+    /// Queue a PING on `p`, connecting first if needed.  False if the
+    /// connection cannot even be started.
+    bool send_ping(Probe& p);
+
+    /// Non-blocking connect to p.address.  False on immediate failure.
+    bool open(Probe& p);
+
+    /// Drop p's connection (the next round reconnects).
+    static void close(Probe& p);
+
+    /// Write as much of p.out as the socket takes.  False on error.
+    static bool flush(Probe& p);
+
+    /// Read what is available; sets `answered` once a full line is in.
+    /// False on error, EOF, or a line other than +PONG.
+    static bool receive(Probe& p, bool& answered);
+
+    /// True if an idle connection is still usable (no EOF/error pending).
+    static bool idle_ok(const Probe& p);
 };
 
 }  // namespace dkv
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "storage/storage_engine.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dkv {
+
+/// Hot-key detection and a small coordinator-side read cache.
+///
+/// Every client read is counted in a Count-Min sketch (`sketch_depth` rows
+/// of `sketch_width` atomic counters, no lock).  A key whose estimate
+/// reaches `min_count` and beats the coldest of the current top `top_k`
+/// keys replaces it; counters and top-K are halved every `decay_every`
+/// reads so the set follows the recent traffic.
+///
+/// Reads of a top-K key fill the cache (at most `capacity` keys, 0 = only
+/// detect).  A cached answer is served for `lease_ms`, or until a write of
+/// a newer version passes through this node (invalidate(): writes this node
+/// coordinates or applies as a replica).  Writes coordinated elsewhere to a
+/// key this node does not replicate are only caught by the lease, which
+/// bounds how stale a cached read can be.
+///
+/// A read that misses takes a ticket (the epoch of the key's stripe); a
+/// write to the stripe in the meantime makes its fill a no-op, so a slow
+/// read cannot cache a value older than a write it raced with.
+class HotKeyCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        size_t   capacity        = 0;          // cached keys; 0 = detect only
+        uint32_t lease_ms        = 100;        // a cached answer is served this long
+        size_t   max_value_bytes = 64 << 10;   // larger values are not cached
+        size_t   top_k           = 128;
+        uint64_t min_count       = 32;         // estimated reads to count as hot
+        uint32_t sketch_width    = 4096;
+        uint32_t sketch_depth    = 4;
+        uint64_t decay_every     = 1 << 16;    // reads between halvings
+    };
+
+    struct Stats {
+        uint64_t reads         = 0;  // reads counted
+        uint64_t hits          = 0;  // served from the cache
+        uint64_t fills         = 0;
+        uint64_t stale_fills   = 0;  // dropped: a write raced with the read
+        uint64_t invalidations = 0;  // entries dropped by a newer write
+        uint64_t expirations   = 0;  // lookups that found the lease over
+        uint64_t evictions     = 0;  // entries dropped for room
+        size_t   cached        = 0;
+    };
+
+    /// One of the hottest keys, as listed by top().
+    struct HotKey {
+        std::string key;
+        uint64_t    count  = 0;  // sketch estimate since the last halving
+        bool        cached = false;
+    };
+
+    /// Outcome of read().  On a hit `found`/`value` are the answer;
+    /// otherwise `hot` says whether to fill() with the result of the read,
+    /// passing `ticket`.
+    struct Lookup {
+        bool        hit    = false;
+        bool        found  = false;
+        std::string value;
+        bool        hot    = false;
+        uint64_t    ticket = 0;
+    };
+
+    HotKeyCache() : HotKeyCache(Options{}) {}
+    explicit HotKeyCache(Options options);
+
+    /// Count a read of `key` and answer it from the cache if possible.
+    Lookup read(const std::string& key);
+
+    /// Cache the answer to a read of a hot key (`found` false caches the
+    /// miss).  Ignored if the cache is off, the value is too large, `key`
+    /// was written since read() returned `ticket`, or a newer version is
+    /// already cached.
+    void fill(const std::string& key, uint64_t ticket, bool found,
+              const std::string& value, const Version& version);
+
+    /// A write of `key` at `version` went through this node: drop an older
+    /// cached answer and void outstanding tickets for the key.
+    void invalidate(const std::string& key, const Version& version);
+
+    /// Change the cache size and lease (detection is unaffected).  A smaller
+    /// capacity evicts at once.
+    void set_cache(size_t capacity, uint32_t lease_ms);
+
+    /// The `n` hottest keys, hottest first.
+    std::vector<HotKey> top(size_t n) const;
+
+    Stats stats() const;
+
+    /// Payload of the HOTKEYS command: the Stats counters (reads, hits,
+    /// fills, stale_fills, invalidations, expirations, evictions, cached),
+    /// the number of keys listed, then the `n` hottest keys, each as
+    /// "<count> <cached 0|1> <key_len> <key>"; all space-separated.
+    std::string encode_report(size_t n) const;
+
+    /// Parse an encode_report() payload (clients).
+    static bool decode_report(std::string_view payload, Stats& stats,
+                              std::vector<HotKey>& keys);
+
+    /// Replace the clock (tests).
+    void set_clock(std::function<Clock::time_point()> now) { now_ = std::move(now); }
+
+    // Non-copyable
+    HotKeyCache(const HotKeyCache&) = delete;
+    HotKeyCache& operator=(const HotKeyCache&) = delete;
+
+private:
+    struct Entry {
+        bool              found = false;
+        std::string       value;
+        Version           version;
+        Clock::time_point expires;
+    };
+
+    static constexpr size_t STRIPES = 64;
+
+    Options options_;
+    std::function<Clock::time_point()> now_ = [] { return Clock::now(); };
+
+    // ── Detection ────────────────────────────────────────────────────────────
+    std::unique_ptr<std::atomic<uint32_t>[]> sketch_;  // depth x width
+    std::atomic<uint64_t>                    reads_{0};
+    mutable std::shared_mutex                top_mutex_;
+    std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> top_;  // key -> hash
+    std::atomic<uint64_t>                    floor_{0};  // estimate to enter top_
+
+    // ── Cache ────────────────────────────────────────────────────────────────
+    mutable std::shared_mutex                 cache_mutex_;
+    std::unordered_map<std::string, Entry>    cache_;
+    std::atomic<size_t>                       cache_size_{0};
+    std::atomic<size_t>                       capacity_{0};
+    std::atomic<uint32_t>                     lease_ms_{0};
+    std::array<std::atomic<uint64_t>, STRIPES> epochs_{};
+
+    // ── Counters ─────────────────────────────────────────────────────────────
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> fills_{0};
+    std::atomic<uint64_t> stale_fills_{0};
+    std::atomic<uint64_t> invalidations_{0};
+    std::atomic<uint64_t> expirations_{0};
+    std::atomic<uint64_t> evictions_{0};
+
+    /// Add one to the key's counters; returns the new estimate.
+    uint64_t count(uint64_t h1, uint64_t h2);
+
+    /// Current estimate for a key without counting it.
+    uint64_t estimate(uint64_t h1, uint64_t h2) const;
+
+    /// Admit `key` to top_ if its estimate beats the coldest member;
+    /// returns whether it is a member afterwards.
+    bool admit(const std::string& key, uint64_t h1, uint64_t h2, uint64_t estimate);
+
+    /// Halve the sketch and drop members that fell below min_count.
+    void decay();
+
+    /// Lowest estimate among the members.  Caller holds top_mutex_.
+    uint64_t coldest_locked(std::string* key) const;
+
+    /// Estimate a newcomer must reach.  Caller holds top_mutex_ exclusively.
+    void update_floor_locked();
+
+    /// Drop the entry closest to expiry.  Caller holds cache_mutex_ exclusively.
+    void evict_one_locked();
+};
+
+}  // namespace dkv
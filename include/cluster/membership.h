@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <mutex>
@@ -16,50 +17,140 @@ enum class NodeState {
     DOWN,
 };
 
+/// Sliding window of heartbeat inter-arrival times (ms), the input of the
+/// phi-accrual failure detector.
+///
+/// phi(t) = -log10(P(the next heartbeat arrives later than t)), with the
+/// intervals modelled as a normal distribution of the window's mean and
+/// standard deviation.  phi = 1 means a 10% chance that a heartbeat this
+/// late is still coming, phi = 8 about 1e-8.  Suspicion therefore rises
+/// continuously with silence and adapts to how regular the peer has been.
+class ArrivalWindow {
+public:
+    /// Seeded with two samples around `expected_ms` (mean expected_ms,
+    /// std expected_ms / 4) so phi is defined before the first heartbeat.
+    explicit ArrivalWindow(size_t capacity = 100, double expected_ms = 1000.0);
+
+    void add(double interval_ms);
+
+    /// Suspicion after `elapsed_ms` without a heartbeat.  The standard
+    /// deviation is floored at `min_std_dev_ms`, and `acceptable_pause_ms`
+    /// is added to the mean (a pause that long is not suspicious at all).
+    double phi(double elapsed_ms, double min_std_dev_ms,
+               double acceptable_pause_ms) const;
+
+    double mean() const;
+    double std_dev() const;
+    size_t size() const { return samples_.size(); }
+
+private:
+    std::vector<double> samples_;
+    size_t              capacity_;
+    size_t              next_   = 0;  // oldest sample once full
+    double              sum_    = 0;
+    double              sum_sq_ = 0;
+};
+
 struct NodeStatus {
     uint32_t    node_id    = 0;
     std::string address;           // "host:port"
     NodeState   state      = NodeState::UP;
     int         miss_count = 0;    // consecutive missed PINGs
     std::chrono::steady_clock::time_point last_seen;
+    uint32_t    rtt_us     = 0;    // last PING round trip
+    uint32_t    srtt_us    = 0;    // smoothed RTT (EWMA, 1/8 gain); 0 = none yet
+    ArrivalWindow arrivals;        // PONG inter-arrival times
+    bool        heard      = false;  // a PONG arrived since add_peer()
+    double      phi        = 0.0;  // suspicion when this copy was taken
 };
 
 /// Tracks the liveness state of all peer nodes.
 ///
-/// State machine per node (section 8.B):
+/// State machine per node (section 8.B), with fixed thresholds (default):
 ///   UP        -> SUSPECTED  after `suspect_threshold` consecutive missed PINGs
 ///   SUSPECTED -> DOWN       after `down_threshold_ms` total ms without response
 ///   DOWN      -> UP         when a PING response is received
 ///
+/// With set_phi_accrual() the first two transitions instead happen when a
+/// missed PING finds the node's phi (see ArrivalWindow) at or above
+/// `suspect_phi` / `down_phi`.  Inter-arrival times are recorded in both
+/// modes, so suspicion() is always available to rank replicas.
+///
 /// Thread-safe.
 class Membership {
 public:
+    using Clock          = std::chrono::steady_clock;
     using DownCallback   = std::function<void(uint32_t node_id, const std::string& address)>;
     using RejoinCallback = std::function<void(uint32_t node_id, const std::string& address)>;
 
+    struct PhiOptions {
+        bool   enabled              = false;   // false = fixed thresholds
+        double suspect_phi          = 5.0;
+        double down_phi             = 8.0;
+        size_t window               = 100;     // inter-arrival samples kept
+        double min_std_dev_ms       = 100.0;
+        double acceptable_pause_ms  = 1000.0;
+        double expected_interval_ms = 1000.0;  // heartbeat interval
+    };
+
     explicit Membership(int suspect_threshold = 3, int down_threshold_ms = 5000);
 
+    /// Configure the phi-accrual detector.  Call before add_peer(): windows
+    /// are sized when a peer is added.
+    void set_phi_accrual(const PhiOptions& options);
+
+    /// Replace the clock (simulations replay traces in virtual time).
+    void set_clock(std::function<Clock::time_point()> now) { now_ = std::move(now); }
+
     void add_peer(uint32_t node_id, const std::string& address);
+
+    /// Stop tracking a peer (it left the ring).  No callbacks fire.
+    void remove_peer(uint32_t node_id);
     void record_success(uint32_t node_id);
     void record_failure(uint32_t node_id);
 
+    /// Apply a state decided elsewhere (gossip).  UP behaves like
+    /// record_success(); DOWN fires the down callback once, like a
+    /// record_failure() that crosses the threshold.
+    void set_state(uint32_t node_id, NodeState state);
+
+    /// Record a PING round trip for `node_id` (no state change).
+    void record_rtt(uint32_t node_id, std::chrono::microseconds rtt);
+
     NodeState get_state(uint32_t node_id) const;
     bool is_available(uint32_t node_id) const;
+
+    /// Current phi of `node_id` (0 for unknown nodes).
+    double suspicion(uint32_t node_id) const;
+
+    /// True if the node is not UP, or (phi accrual only) its phi has
+    /// reached `suspect_phi` even though it has not missed a PING yet (it
+    /// is late).  Reads use this to try such replicas last.
+    bool is_suspect(uint32_t node_id) const;
+
     std::vector<uint32_t> down_nodes() const;
     std::vector<NodeStatus> all_peers() const;
 
+    /// Callbacks run synchronously on the thread that reported the change
+    /// (heartbeat or gossip), outside the lock.  Keep them short; hand slow
+    /// work to another thread.
     void set_down_callback(DownCallback cb)    { down_cb_   = std::move(cb); }
     void set_rejoin_callback(RejoinCallback cb) { rejoin_cb_ = std::move(cb); }
 
 private:
     int suspect_threshold_;
     int down_threshold_ms_;
+    PhiOptions phi_;
+    std::function<Clock::time_point()> now_ = [] { return Clock::now(); };
 
     mutable std::mutex                        mutex_;
     std::unordered_map<uint32_t, NodeStatus>  peers_;
 
     DownCallback   down_cb_;
     RejoinCallback rejoin_cb_;
+
+    /// phi of `s` at `now`.  Caller holds mutex_.
+    double phi_locked(const NodeStatus& s, Clock::time_point now) const;
 };
 
 }  // namespace dkv
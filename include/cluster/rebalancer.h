@@ -0,0 +1,247 @@
+#pragma once
+
+#include "cluster/hash_ring.h"
+#include "cluster/rpc_client.h"
+#include "network/protocol.h"
+#include "storage/storage_engine.h"
+#include "utils/token_bucket.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace dkv {
+
+/// Online membership changes: moves key ranges when a node joins or leaves.
+///
+/// A change runs in three steps, driven by the node that joins or leaves:
+///
+///   1. RING STAGE — every node stages the change on its HashRing.  From
+///      then on quorum writes also go to the replicas the new ring adds
+///      (outside the write quorum), so nothing written during the transfer
+///      is missed.
+///   2. Transfer — plan() diffs the current and staged rings into ranges
+///      that gain a replica.  A joining node pulls its ranges from a current
+///      replica (RSCAN, one shard and about `chunk_bytes` per request); a
+///      leaving node pushes its ranges to the gaining nodes (RLOAD).  Each
+///      shard's matching keys are listed and sorted once per transfer (the
+///      source keeps the list between RSCANs), so streaming is linear.  Every
+///      chunk carries a CRC32 and is applied through `Writer` with its
+///      original version, so a transfer never overwrites a newer write.
+///      Bytes moved are paced by a token bucket of `rate_bytes_per_sec`.
+///   3. RING COMMIT — every node makes the staged ring current (one atomic
+///      pointer swap, see HashRing) and calls `OnCommit`.  A node that does
+///      not acknowledge is retried in the background until it does; COMMIT
+///      carries the whole change, so a node that lost its staged state
+///      (e.g. restarted) applies it directly.
+///
+/// Nodes that lose a range keep its data; reads no longer reach it.
+class Rebalancer {
+public:
+    struct Options {
+        uint64_t rate_bytes_per_sec = 32ull << 20;  // 0 = unlimited
+        size_t   chunk_bytes        = 1 << 20;      // per RSCAN/RLOAD
+        uint32_t vnodes             = 128;          // for a joining node
+    };
+
+    struct Stats {
+        uint64_t changes            = 0;  // joins/leaves completed
+        uint64_t ranges             = 0;  // ranges transferred
+        uint64_t chunks             = 0;
+        uint64_t keys_streamed      = 0;
+        uint64_t bytes_streamed     = 0;
+        uint64_t checksum_failures  = 0;
+        size_t   lagging_peers      = 0;  // gauge: COMMIT not yet acknowledged
+    };
+
+    /// How a join or leave ended.
+    enum class Outcome {
+        FAILED,     // aborted everywhere; the ring is unchanged
+        COMMITTED,  // every node switched to the new ring
+        LAGGING,    // committed here and on the nodes that answered; COMMIT
+                    // is retried in the background to the rest
+    };
+
+    /// A membership change as carried by RING.
+    struct Change {
+        bool        add     = true;
+        uint32_t    node_id = 0;
+        std::string address;     // add only
+        uint32_t    vnodes  = 0;  // add only
+    };
+
+    /// One range that gains `target` as a replica, with the nodes that
+    /// replicate it in the current ring.
+    struct Transfer {
+        TokenRange            range;
+        NodeInfo              target;
+        std::vector<NodeInfo> sources;
+    };
+
+    /// Applies a transferred entry locally (WAL + engine, LWW).
+    using Writer = std::function<void(const std::string& key,
+                                      const std::string& value, bool is_del,
+                                      const Version& version)>;
+
+    /// Called on every node right after the staged ring became current.
+    using OnCommit = std::function<void(const Change& change)>;
+
+    /// Whether a peer is worth contacting (membership check).
+    using Availability = std::function<bool(uint32_t node_id)>;
+
+    Rebalancer(StorageEngine& engine, HashRing& ring, RpcClient& rpc,
+               uint32_t node_id, uint32_t replication_factor, Writer writer,
+               OnCommit on_commit, Availability available, Options options);
+
+    /// Wakes any transfer sleeping in the throttle so it fails promptly,
+    /// and stops retrying COMMIT to lagging nodes.
+    ~Rebalancer();
+
+    /// Add this node (at `self_address`) to the ring: stage, pull the
+    /// ranges it gains, commit.  Blocks until done; FAILED if any node
+    /// refused the change or a range could not be fetched (the change is
+    /// then aborted everywhere).
+    Outcome join(const std::string& self_address);
+
+    /// Remove this node from the ring: stage, push its ranges to the nodes
+    /// that gain them, commit.  Blocks until done.
+    Outcome leave();
+
+    /// Every range whose replica set gains a node when `from` becomes `to`,
+    /// split at both rings' tokens and merged where neighbours share a
+    /// target and sources.
+    static std::vector<Transfer> plan(const RingSnapshot& from,
+                                      const RingSnapshot& to,
+                                      uint32_t replication_factor);
+
+    /// Answer RSCAN, RLOAD or RING.  Returns a text-protocol response.
+    std::string serve(const Command& cmd);
+
+    void stop();
+
+    Stats stats() const;
+
+    // ── Wire formats (exposed for tests) ─────────────────────────────────────
+
+    /// RING payload: "<verb> ADD <id> <address> <vnodes>" or "<verb>
+    /// REMOVE <id>", where verb is STAGE, COMMIT or ABORT.
+    static std::string encode_ring(std::string_view verb, const Change& change);
+
+    /// RSCAN request: [u32 shard][u32 max_bytes][u32 cursor_len][cursor]
+    /// [u32 range_count]{[u64 start][u64 end]}.
+    static std::string encode_scan(size_t shard, size_t max_bytes,
+                                   const std::string& cursor,
+                                   const std::vector<TokenRange>& ranges);
+
+    /// Chunk: [u32 crc32 of the rest][u8 more][u32 count]{[u32 key_len][key]
+    /// [u32 value_len][value][u64 ts][u32 node_id][u8 tombstone]}.
+    static std::string encode_chunk(
+        const std::vector<std::pair<std::string, ValueEntry>>& entries,
+        bool more);
+
+    /// Parse a chunk; false on a bad checksum or truncated data.
+    static bool decode_chunk(std::string_view chunk,
+                             std::vector<std::pair<std::string, ValueEntry>>& out,
+                             bool& more);
+
+    // Non-copyable
+    Rebalancer(const Rebalancer&) = delete;
+    Rebalancer& operator=(const Rebalancer&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    StorageEngine& engine_;
+    HashRing&      ring_;
+    RpcClient&     rpc_;
+    uint32_t       node_id_;
+    uint32_t       replication_factor_;
+    Writer         writer_;
+    OnCommit       on_commit_;
+    Availability   available_;
+    Options        options_;
+
+    mutable std::mutex      mutex_;
+    std::condition_variable cv_;
+    bool                    stopping_ = false;
+    bool                    running_  = false;  // a join/leave is in progress
+    Stats                   stats_;
+
+    // Nodes that have not acknowledged the last COMMIT, retried by
+    // resync_loop().  Guarded by mutex_.
+    Change                lagging_change_;
+    std::vector<NodeInfo> lagging_;
+    std::thread           resync_thread_;
+
+    // Staged change, applied on RING COMMIT.
+    std::mutex staged_mutex_;
+    Change     staged_;
+    bool       has_staged_ = false;
+
+    // Paces bytes sent; may go negative after a large chunk.
+    TokenBucket bucket_;
+
+    /// Sorted key list of one shard being pulled from us, kept between the
+    /// puller's RSCANs.  Identified by shard and the request's ranges.
+    struct ScanState {
+        uint32_t          shard = 0;
+        std::string       ranges;  // as encoded
+        std::shared_ptr<const std::vector<std::string>> keys;
+        Clock::time_point used;
+    };
+    std::mutex             scans_mutex_;
+    std::vector<ScanState> scans_;
+
+    /// The key list for an RSCAN, built on the first chunk of a shard.
+    std::shared_ptr<const std::vector<std::string>> scan_keys(
+        uint32_t shard, std::string_view encoded_ranges,
+        const std::vector<TokenRange>& ranges, bool first_chunk);
+
+    /// Forget a finished scan.
+    void end_scan(uint32_t shard, std::string_view encoded_ranges);
+
+    /// Stage, transfer with `move`, then commit; or abort on failure.
+    Outcome run_change(const Change& change,
+                       const std::function<bool(const std::vector<Transfer>&)>& move);
+
+    /// Hand `peers` to resync_loop(), starting it if needed.
+    void retry_commit(const Change& change, std::vector<NodeInfo> peers);
+
+    /// Re-send COMMIT to lagging_ with backoff until all acknowledge.
+    void resync_loop();
+
+    /// Send RING `verb` to every node of `nodes` except us, in parallel.
+    /// Returns false if any of them did not acknowledge.
+    bool broadcast(std::string_view verb, const Change& change,
+                   const std::vector<NodeInfo>& nodes);
+
+    /// Apply a RING message locally.
+    bool apply_ring(std::string_view verb, const Change& change);
+
+    /// Parse a RING payload; false if malformed.
+    static bool decode_ring(std::string_view payload, std::string& verb,
+                            Change& change);
+
+    /// Pull `ranges` from `source`, shard by shard, chunk by chunk.
+    bool pull(const NodeInfo& source, const std::vector<TokenRange>& ranges);
+
+    /// Push the local entries of `ranges` to `target`.
+    bool push(const NodeInfo& target, const std::vector<TokenRange>& ranges);
+
+    /// Apply a decoded chunk through writer_ and count it.
+    void apply(const std::vector<std::pair<std::string, ValueEntry>>& entries,
+               size_t wire_bytes);
+
+    /// Charge `bytes` to the token bucket and sleep until it is covered
+    /// (or stop() is called).
+    void throttle(size_t bytes);
+};
+
+}  // namespace dkv
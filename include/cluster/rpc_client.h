@@ -0,0 +1,288 @@
+#pragma once
+
+#include "network/mpsc_queue.h"
+#include "network/poller.h"
+#include "network/protocol.h"
+#include "network/read_buffer.h"
+#include "network/wakeup_fd.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace dkv {
+
+/// Outcome of an inter-node RPC.
+enum class RpcStatus : uint8_t {
+    OK,              // a response frame arrived (it may still be an ERROR frame)
+    CONNECT_FAILED,  // could not establish a connection to the peer
+    TIMEOUT,         // no response within the client's timeout
+    DISCONNECTED,    // the connection dropped with the request outstanding
+    SHUTDOWN,        // the client was stopped
+};
+
+/// A completed RPC.  `value` and the version are copied out of the
+/// response frame; the version is only meaningful when `has_version`.
+struct RpcResult {
+    RpcStatus    status       = RpcStatus::SHUTDOWN;
+    BinaryOpcode opcode       = BinaryOpcode::ERROR;
+    std::string  value;
+    bool         has_version  = false;
+    uint64_t     timestamp_ms = 0;
+    uint32_t     node_id      = 0;
+    bool         busy         = false;  // the peer set BINARY_FLAG_BUSY
+
+    /// True if the peer answered with +OK / PONG / VALUE / NOT_FOUND.
+    bool ok() const {
+        return status == RpcStatus::OK && opcode != BinaryOpcode::ERROR;
+    }
+};
+
+/// Asynchronous, multiplexed client for node-to-node requests.
+///
+/// One event-loop thread owns a few persistent binary-protocol connections
+/// per peer.  Every request carries a request id, so any number can be
+/// outstanding on a connection at once and replies may arrive in any order.
+/// Callers never block on the network:
+///
+///   rpc.call("10.0.0.2:7001", frame, [](RpcResult r) { ... });
+///
+/// Completion callbacks run on the client's event-loop thread and must be
+/// short (record the result, notify a waiter, post a response) — a slow
+/// callback delays every other peer's I/O.  `call_sync` wraps a call in a
+/// future for background code that is happy to block.
+///
+/// Connections are created lazily and re-established on the next call after
+/// a failure.  A request that gets no reply within `timeout_ms` completes
+/// with TIMEOUT; a late reply is discarded.
+///
+/// Replication writes sent with call_batched() are coalesced per peer into
+/// one RBATCH frame (flushed when it reaches `max_bytes` or its linger time
+/// expires) and written with a single writev(); the peer answers the whole
+/// batch at once and each write's callback still completes individually.
+class RpcClient {
+public:
+    using Callback = std::function<void(RpcResult)>;
+
+    /// @param timeout_ms      Per-request deadline (also bounds connect time).
+    /// @param conns_per_peer  Persistent connections kept to each peer.
+    explicit RpcClient(int timeout_ms = 500, size_t conns_per_peer = 2);
+
+    /// Stops the client; outstanding requests complete with SHUTDOWN.
+    ~RpcClient();
+
+    /// Encode a request frame once (request id left as 0, patched per send)
+    /// so it can be sent to several replicas without re-encoding.
+    static std::shared_ptr<const std::string> encode(BinaryOpcode op,
+                                                     std::string_view extras,
+                                                     std::string_view key,
+                                                     std::string_view value);
+
+    /// Send a pre-encoded request frame to `address` ("host:port").
+    /// `done` is invoked exactly once.  Thread-safe.
+    void call(const std::string& address,
+              std::shared_ptr<const std::string> frame, Callback done);
+
+    /// Same, with a deadline other than the client's `timeout_ms`.
+    void call(const std::string& address,
+              std::shared_ptr<const std::string> frame, Callback done,
+              std::chrono::milliseconds timeout);
+
+    /// Encode and send a request.  Thread-safe.
+    void call(const std::string& address, BinaryOpcode op,
+              std::string_view extras, std::string_view key,
+              std::string_view value, Callback done);
+
+    /// Like call(), but the frame (an RSET or RDEL) may be coalesced with
+    /// other writes to the same peer into one RBATCH frame.  Falls back to
+    /// call() when batching is disabled.  Thread-safe.
+    void call_batched(const std::string& address,
+                      std::shared_ptr<const std::string> frame, Callback done);
+
+    /// Configure write batching.  `max_bytes` = 0 disables it.  With
+    /// `linger_us` = 0 a batch holds whatever queued up while the event loop
+    /// was busy and is sent as soon as the loop catches up; otherwise the
+    /// first write of a batch waits up to `linger_us` for company (rounded
+    /// up to the poller's millisecond resolution).  Thread-safe.
+    void set_batching(size_t max_bytes, uint32_t linger_us);
+
+    /// Run `fn` on the event loop thread after `delay` (rounded up to the
+    /// poller's millisecond resolution).  Dropped if the client stops first.
+    /// Used to schedule hedged requests.  Thread-safe.
+    void run_after(std::chrono::microseconds delay, std::function<void()> fn);
+
+    /// Counters describing batching activity (readable from any thread).
+    struct BatchStats {
+        uint64_t batches        = 0;  // RBATCH frames sent
+        uint64_t batched_writes = 0;  // writes carried inside them
+    };
+    BatchStats batch_stats() const;
+
+    /// Send a request and block until it completes.
+    RpcResult call_sync(const std::string& address, BinaryOpcode op,
+                        std::string_view extras = {}, std::string_view key = {},
+                        std::string_view value = {});
+
+    /// Stop the event loop and fail everything outstanding with SHUTDOWN.
+    /// Idempotent; later calls complete immediately with SHUTDOWN.
+    void stop();
+
+    int timeout_ms() const { return timeout_ms_; }
+
+    // Non-copyable
+    RpcClient(const RpcClient&) = delete;
+    RpcClient& operator=(const RpcClient&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// A request handed from a caller thread to the event loop.
+    struct Submission {
+        std::string                        address;
+        std::shared_ptr<const std::string> frame;
+        Callback                           done;
+        bool                               batchable = false;
+        std::chrono::milliseconds          timeout{0};  // 0 = timeout_ms_
+    };
+
+    /// A timer handed from a caller thread to the event loop.
+    struct TimerSubmission {
+        Clock::time_point     fire_at;
+        std::function<void()> fn;
+    };
+
+    /// Replication writes waiting to go to one peer as an RBATCH frame
+    /// (event loop thread only).  Inner request ids are indices into
+    /// `callbacks`.
+    struct Batch {
+        std::string           body;
+        std::vector<Callback> callbacks;
+        Clock::time_point     deadline;
+    };
+
+    /// One persistent connection to a peer (event loop thread only).
+    struct PeerConn {
+        int                          fd = -1;
+        std::string                  address;
+        bool                         connected = false;
+        std::string                  write_buf;
+        size_t                       write_off = 0;
+        ReadBuffer                   read_buf;
+        std::unordered_set<uint32_t> outstanding;  // request ids on this conn
+    };
+
+    /// An outstanding request (event loop thread only).
+    struct Pending {
+        Callback  done;
+        PeerConn* conn = nullptr;
+    };
+
+    int    timeout_ms_;
+    size_t conns_per_peer_;
+
+    std::unique_ptr<Poller> poller_;
+    WakeupFd                wakeup_;
+    std::thread             loop_thread_;
+    std::atomic<bool>       running_{false};
+    std::atomic<bool>       stopped_{false};
+    std::atomic<uint32_t>   submitters_{0};   // call()s in progress
+
+    // Callers → loop (same coalesced-wakeup scheme as TCPServer responses)
+    MpscQueue<Submission>      submissions_;
+    MpscQueue<TimerSubmission> timer_submissions_;
+    std::atomic<bool>     wakeup_pending_{false};
+
+    // Batching configuration (set from any thread, read by the loop)
+    std::atomic<size_t>   batch_max_bytes_{0};
+    std::atomic<uint32_t> batch_linger_us_{0};
+    std::atomic<uint64_t> batches_sent_{0};
+    std::atomic<uint64_t> batched_writes_{0};
+
+    // ── Event loop state ─────────────────────────────────────────────────
+    std::unordered_map<std::string, std::vector<std::unique_ptr<PeerConn>>> peers_;
+    std::unordered_map<std::string, size_t>  next_conn_;   // round-robin cursor
+    std::unordered_map<int, PeerConn*>       by_fd_;
+    std::unordered_map<uint32_t, Pending>    pending_;
+    uint32_t                                 next_request_id_ = 1;
+
+    /// Min-heap of (deadline, request id); entries for requests that have
+    /// already completed are skipped lazily.
+    using Deadline = std::pair<Clock::time_point, uint32_t>;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>> deadlines_;
+
+    std::unordered_map<std::string, Batch> batches_;  // address → open batch
+
+    std::multimap<Clock::time_point, std::function<void()>> timers_;
+
+    /// Shared body of call() and call_batched().
+    void submit(const std::string& address,
+                std::shared_ptr<const std::string> frame, Callback done,
+                bool batchable,
+                std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
+
+    void run_loop();
+
+    /// Move queued submissions onto connections.
+    void drain_submissions();
+
+    /// One send() per connection with queued output.
+    void flush_connections();
+
+    /// Register `done` under a fresh request id and queue `frame` (with the
+    /// id patched in) on a connection to `address`.  `tail`, if non-empty,
+    /// follows the frame on the wire and is written with writev() when the
+    /// connection is idle.  Completes `done` with CONNECT_FAILED if no
+    /// connection can be started.
+    void enqueue(const std::string& address, std::string_view frame,
+                 std::string_view tail, Callback done,
+                 Clock::time_point deadline);
+
+    /// Add a replication write to `address`'s open batch, flushing it when
+    /// full.
+    void add_to_batch(const std::string& address, std::string_view frame,
+                      Callback done);
+
+    /// Send an open batch as one RBATCH frame (or, if it holds a single
+    /// write, as that plain frame).
+    void flush_batch(const std::string& address, Batch& batch);
+
+    /// Flush batches whose linger time has passed (all of them if `all`);
+    /// returns ms until the next batch deadline, or -1 if none is open.
+    int flush_batches(bool all);
+
+    /// Pick (and if needed open) a connection to `address`.  nullptr if a
+    /// connection cannot even be started.
+    PeerConn* connection_for(const std::string& address);
+
+    /// Start a non-blocking connect.  Returns -1 on immediate failure.
+    int start_connect(const std::string& address);
+
+    void handle_readable(PeerConn* conn);
+    void handle_writable(PeerConn* conn);
+    void flush(PeerConn* conn);
+
+    /// Complete request `id` with `result` (if still outstanding).
+    void complete(uint32_t id, RpcResult result);
+
+    /// Close a connection and fail its outstanding requests with `status`.
+    void fail_connection(PeerConn* conn, RpcStatus status);
+
+    /// Run due timers; returns ms until the next one, or -1 if none.
+    int fire_timers();
+
+    /// Time out expired requests; returns ms until the next deadline.
+    int expire_deadlines();
+};
+
+}  // namespace dkv
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dkv {
+
+/// Client-side copy of the hash ring for token-aware routing.
+///
+/// A client fetches the ring once with TOPOLOGY (any node answers it), then
+/// sends each request straight to one of the key's replicas instead of to
+/// whichever node it happens to be connected to — saving the coordinator's
+/// extra hop whenever that node does not hold the key.  Keys are placed
+/// exactly as HashRing does it: MurmurHash3 of the key, first token above
+/// it (wrapping), then clockwise over distinct nodes.
+///
+/// The map carries the ring version; a client refreshes it when a node
+/// reports a newer one or when a routed request fails.
+class TokenRouter {
+public:
+    struct Node {
+        uint32_t    node_id = 0;
+        std::string address;     // "host:port"
+        std::string host;
+        int         port    = 0;
+    };
+
+    /// Replace the map with the value of a TOPOLOGY response.  Returns
+    /// false, leaving the current map untouched, if it is malformed.
+    bool update(std::string_view payload);
+
+    uint64_t version() const { return version_; }
+    uint32_t replication_factor() const { return replication_factor_; }
+    const std::vector<Node>& nodes() const { return nodes_; }
+    size_t token_count() const { return tokens_.size(); }
+    bool empty() const { return tokens_.empty(); }
+
+    /// Indices into nodes() of the key's replicas, primary first.
+    std::vector<size_t> replicas(const std::string& key) const;
+
+    /// Index into nodes() of the key's primary replica.  Requires !empty().
+    size_t primary(const std::string& key) const;
+
+private:
+    uint64_t              version_            = 0;
+    uint32_t              replication_factor_ = 1;
+    std::vector<Node>     nodes_;
+    std::vector<uint64_t> tokens_;   // ascending
+    std::vector<uint32_t> owners_;   // node index for each token
+
+    size_t first_token(const std::string& key) const;
+};
+
+}  // namespace dkv
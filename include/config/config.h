@@ -11,6 +11,9 @@ struct Config {
     uint32_t    node_id             = 1;
     uint16_t    port                = 7001;
     std::string cluster_conf        = "cluster.conf";
+    std::string join                = "";  // seed "host:port"; "" = use cluster_conf
+    std::string advertise_address   = "";  // "" = 127.0.0.1:<port>
+    uint16_t    metrics_port        = 0;   // Prometheus /metrics over HTTP; 0 = off
 
     // ── Replication ─────────────────────────────────────────────────────────
     uint32_t    replication_factor   = 3;
@@ -29,12 +32,53 @@ struct Config {
     // ── Threading ───────────────────────────────────────────────────────────
     uint32_t    worker_threads       = 4;
 
+    // ── Client Output Limits (bytes, 0 = disabled) ─────────────────────────
+    uint64_t    output_high_water        = 1ull << 20;    // pause reading above
+    uint64_t    output_low_water         = 256ull << 10;  // resume reading at
+    uint64_t    output_hard_limit        = 256ull << 20;  // disconnect above
+    uint64_t    output_global_high_water = 1ull << 30;    // all connections
+
+    // ── Replication Batching ────────────────────────────────────────────────
+    uint64_t    replication_batch_bytes     = 64ull << 10;  // 0 = no batching
+    uint32_t    replication_batch_linger_us = 0;            // 0 = no waiting
+
+    // ── Quorum Reads ────────────────────────────────────────────────────────
+    bool        digest_reads       = true;  // versions only from all but one
+    bool        hedged_reads       = false;
+    uint32_t    hedge_min_delay_us = 1000;  // floor under the p95 hedge delay
+    bool        dynamic_snitch     = true;  // read from the fastest replicas
+    uint32_t    hot_cache_keys     = 0;     // hot keys cached; 0 = detect only
+    uint32_t    hot_cache_lease_ms = 100;   // a cached read is served this long
+
+    // ── Read Repair ─────────────────────────────────────────────────────────
+    uint64_t    repair_queue_bytes = 64ull << 20;  // queued repairs, then drop
+    uint64_t    repair_rate_bytes  = 16ull << 20;  // per second, 0 = unlimited
+    uint32_t    repair_batch       = 64;           // repairs per replica send
+
+    // ── Anti-Entropy ────────────────────────────────────────────────────────
+    uint32_t    anti_entropy_interval_ms = 10000;       // 0 = disabled
+    uint64_t    anti_entropy_rate_bytes  = 4ull << 20;  // per second, 0 = unlimited
+    uint32_t    anti_entropy_max_leaves  = 256;         // leaves repaired per round
+
+    // ── Rebalancing ─────────────────────────────────────────────────────────
+    uint64_t    rebalance_rate_bytes  = 32ull << 20;  // per second, 0 = unlimited
+    uint64_t    rebalance_chunk_bytes = 1ull << 20;   // per transfer request
+
     // ── Cluster Health ──────────────────────────────────────────────────────
     uint32_t    heartbeat_interval_ms = 1000;
-    uint32_t    heartbeat_timeout_ms  = 5000;
+    uint32_t    heartbeat_timeout_ms  = 5000;   // fixed detector: silence before DOWN
+    double      phi_suspect_threshold = 5.0;
+    double      phi_convict_threshold = 8.0;    // 0 = fixed miss-count detector
+    uint32_t    phi_acceptable_pause_ms = 1000;
+    bool        gossip                 = true;  // SWIM probing instead of Heartbeat
+    uint32_t    gossip_indirect_probes = 3;     // helpers asked on a missed ACK
+    uint32_t    gossip_suspicion_mult  = 4;     // suspicion timeout, in log10(N) periods
 
     // ── Hinted Handoff ──────────────────────────────────────────────────────
     std::string hints_dir            = "./data/hints/";
+    uint64_t    hint_max_bytes        = 1ull << 30;  // per target node, 0 = no cap
+    uint64_t    hint_max_age_ms       = 3 * 3600 * 1000;  // 0 = never expire
+    uint32_t    hint_sync_interval_ms = 1000;        // 0 = fsync every hint
 
     // ── Logging ─────────────────────────────────────────────────────────────
     std::string log_level            = "INFO";   // DEBUG|INFO|WARN|ERROR|FATAL
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace dkv {
+
+/// Minimal HTTP endpoint for Prometheus scrapes: `GET /metrics` answers
+/// with Metrics::instance().render(true); any other request gets a 404.
+///
+/// Scrapes are rare (every few seconds) and tiny, so one background thread
+/// serves them one at a time with blocking sockets and `Connection: close`,
+/// kept well away from the request path.  A client that stalls for longer
+/// than the socket timeout is dropped.
+class MetricsHttpServer {
+public:
+    /// @param port  TCP port to listen on; 0 picks a free one (see port()).
+    explicit MetricsHttpServer(uint16_t port);
+    ~MetricsHttpServer();
+
+    /// Bind and start serving.  Returns false (and logs) on failure.
+    bool start();
+
+    /// Stop serving and join the thread.  Idempotent.
+    void stop();
+
+    /// The bound port once started.
+    uint16_t port() const { return port_; }
+
+    MetricsHttpServer(const MetricsHttpServer&) = delete;
+    MetricsHttpServer& operator=(const MetricsHttpServer&) = delete;
+
+private:
+    void serve_loop();
+    void serve_client(int fd);
+
+    uint16_t          port_;
+    int               listen_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread       thread_;
+};
+
+}  // namespace dkv
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <utility>
+
+namespace dkv {
+
+/// Unbounded lock-free multi-producer / single-consumer queue
+/// (Vyukov's node-based MPSC design).
+///
+/// Producers link a node with a single atomic exchange on `head_`; the one
+/// consumer walks `tail_` without any synchronisation against other
+/// consumers.  A stub node means the queue is never structurally empty.
+///
+/// Used to hand worker responses back to the event loop thread without a
+/// mutex.  T must be default-constructible (for the stub) and movable.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue() {
+        T discard;
+        while (try_pop(discard)) {}
+        delete tail_;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /// Enqueue a value.  Safe to call from any number of threads.
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        // seq_cst: a consumer that later observes a cleared wakeup flag must
+        // also observe this exchange (see TCPServer::drain_responses).
+        Node* prev = head_.exchange(node, std::memory_order_seq_cst);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /// Dequeue a value.  Must only be called from the single consumer thread.
+    /// Returns false if the queue is empty.  If a producer is between its
+    /// exchange and its link store, waits for the link rather than reporting
+    /// a spurious empty — the window is a couple of instructions wide.
+    bool try_pop(T& out) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            if (head_.load(std::memory_order_seq_cst) == tail) return false;
+            while ((next = tail->next.load(std::memory_order_acquire)) == nullptr) {
+                std::this_thread::yield();
+            }
+        }
+        out   = std::move(next->value);
+        tail_ = next;  // `next` becomes the new stub
+        delete tail;
+        return true;
+    }
+
+    /// True if nothing is queued.  Consumer-side only.
+    bool empty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr &&
+               head_.load(std::memory_order_seq_cst) == tail_;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T                  value{};
+
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)) {}
+    };
+
+    alignas(64) std::atomic<Node*> head_;  // producers
+    alignas(64) Node*              tail_;  // consumer
+};
+
+}  // namespace dkv
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <vector>
 
 namespace dkv {
 
@@ -13,6 +16,12 @@ enum class CommandType : uint8_t {
     DEL,
     PING,
     FWD,        // Internal forwarded request
+    TOPOLOGY,   // Ring layout for token-aware clients (see TokenRouter)
+    DECOMMISSION,  // Stream this node's ranges away and leave the ring
+    HOTKEYS,    // Admin: hot-key detector and read-cache statistics
+    STATS,      // Admin: every metric in the registry (see Metrics::render())
+    MGET,       // Multi-key GET/SET: `value` holds the argument list
+    MSET,       // (see parse_multi_args()), the same in both protocols
 
     // ── Internal replication commands (Phase 5) ──────────────────────────────
     // These are sent node-to-node during quorum scatter-gather.
@@ -21,8 +30,26 @@ enum class CommandType : uint8_t {
     RSET,       // Replicated SET: carries explicit Version (timestamp_ms + node_id)
     RDEL,       // Replicated DEL: carries explicit Version
     RGET,       // Versioned GET: response includes Version for quorum comparison
+    RDIGEST,    // Version-only GET: like RGET but the value is left out
+    RBATCH,     // Batch of RSET/RDEL/RGET frames (binary protocol only;
+                // `value` holds the concatenated inner frames)
+    AEHASH,     // Anti-entropy: Merkle hashes for a list of ranges/leaves
+    AEKEYS,     // Anti-entropy: key versions in a list of leaves
+                // (both binary protocol only; `value` holds the request)
+    RSCAN,      // Rebalancing: one chunk of the entries in some token ranges
+    RLOAD,      // Rebalancing: apply a chunk produced by RSCAN
+    RING,       // Rebalancing: stage/commit/abort a membership change
+                // (all binary protocol only; `value` holds the request)
+    GOSSIP,     // Failure detection: a SWIM message (binary protocol only;
+                // `value` holds it)
 };
 
+/// Number of CommandType values.
+constexpr size_t COMMAND_TYPE_COUNT = static_cast<size_t>(CommandType::GOSSIP) + 1;
+
+/// The command's wire name ("GET", "RBATCH", ...), for logs and metrics.
+const char* command_name(CommandType type);
+
 /// A parsed client request.
 struct Command {
     CommandType type;
@@ -36,6 +63,26 @@ struct Command {
     std::string inner_line;          // opaque inner command (FWD only)
 };
 
+/// Non-owning view of a parsed command.  All string fields point into the
+/// buffer that was parsed and are valid only until that buffer is modified.
+///
+/// The event loop parses into views so that no bytes are copied while a
+/// frame is merely being recognised; ownership is taken (to_command()) only
+/// when the command is handed to another thread.
+struct CommandView {
+    CommandType      type = CommandType::PING;
+    std::string_view key;
+    std::string_view value;
+    uint64_t         timestamp_ms = 0;
+    uint32_t         node_id      = 0;
+
+    uint32_t         hops_remaining = 2;
+    std::string_view inner_line;
+
+    /// Copy the referenced bytes into an owning Command.
+    Command to_command() const;
+};
+
 /// Result of attempting to parse one command from a byte buffer.
 enum class ParseStatus {
     OK,             // a complete command was parsed
@@ -50,6 +97,18 @@ struct ParseResult {
     std::string error_msg;      // human-readable, set when status == ERROR
 };
 
+/// Allocation-free counterpart of ParseResult.
+struct ParseViewResult {
+    ParseStatus      status;
+    CommandView      command;        // valid only when status == OK
+    size_t           bytes_consumed;
+    std::string_view error_msg;      // static string, set when status == ERROR
+};
+
+/// Parse a single command without copying or allocating.  Same wire format
+/// and error semantics as try_parse().
+ParseViewResult try_parse_view(const char* data, size_t len);
+
 /// Try to parse a single command from `buffer`.
 /// On success, `bytes_consumed` indicates how many bytes were used, so the
 /// caller can advance its read cursor.
@@ -59,6 +118,12 @@ struct ParseResult {
 ///   GET <key_len> <key>\n
 ///   DEL <key_len> <key>\n
 ///   PING\n
+///   TOPOLOGY\n
+///   DECOMMISSION\n
+///   HOTKEYS\n
+///   STATS\n
+///   MGET <count> <key_len> <key> ...\n
+///   MSET <count> <key_len> <key> <val_len> <value> ...\n
 ///   FWD <hops_remaining> <inner_command_without_newline>\n
 ParseResult try_parse(const char* data, size_t len);
 
@@ -68,7 +133,7 @@ ParseResult try_parse(const char* data, size_t len);
 std::string format_ok();
 
 /// $<val_len> <value>\n
-std::string format_value(const std::string& value);
+std::string format_value(std::string_view value);
 
 /// -ERR <message>\n
 std::string format_error(const std::string& message);
@@ -79,6 +144,47 @@ std::string format_not_found();
 /// +PONG\n
 std::string format_pong();
 
+// ── Multi-key commands ──────────────────────────────────────────────────────
+
+/// Most keys one MGET/MSET may carry.
+constexpr uint32_t MAX_MULTI_KEYS = 4096;
+
+/// One key (and, for MSET, its value) of a multi-key command.  Views into
+/// the command's argument list.
+struct MultiKeyArg {
+    std::string_view key;
+    std::string_view value;
+};
+
+/// Split an MGET (`with_values` false) or MSET argument list:
+///   <count> <key_len> <key> [<val_len> <value>] ...
+/// Returns false if it is malformed, empty, or longer than MAX_MULTI_KEYS.
+bool parse_multi_args(std::string_view args, bool with_values,
+                      std::vector<MultiKeyArg>& out);
+
+/// Same checks as parse_multi_args() without building the list; the
+/// parsers use it so MGET/MSET stay allocation-free until executed.
+bool valid_multi_args(std::string_view args, bool with_values);
+
+/// Build an MGET argument list (`values` empty) or an MSET one.
+std::string format_multi_args(const std::vector<std::string>& keys,
+                              const std::vector<std::string>& values = {});
+
+/// One key's outcome in an MGET reply.
+struct MultiGetItem {
+    enum class Status : uint8_t { FOUND, NOT_FOUND, FAILED };
+    Status      status = Status::NOT_FOUND;
+    std::string value;
+};
+
+/// $<len> <count> <item> ...\n — the reply to MGET, one item per key in
+/// request order: "<val_len> <value>", "-1" (not found) or "-2" (the key's
+/// read quorum was not reached).
+std::string format_multi_get(const std::vector<MultiGetItem>& items);
+
+/// Parse the payload of an MGET reply (what follows "$<len> ").
+bool parse_multi_get(std::string_view payload, std::vector<MultiGetItem>& out);
+
 /// FWD <hops> <inner_command>\n
 /// Wraps an existing command line for inter-node forwarding.
 std::string format_forward(uint32_t hops, const std::string& inner_line);
@@ -86,8 +192,9 @@ std::string format_forward(uint32_t hops, const std::string& inner_line);
 // ── Phase 5: Replication helpers ─────────────────────────────────────────────
 
 /// $V <val_len> <value> <timestamp_ms> <node_id>\n
-/// Response to an RGET (versioned GET) when the key is found.
-std::string format_versioned_value(const std::string& value,
+/// Response to an RGET (versioned GET) when the key is found.  RDIGEST
+/// answers with the same shape and an empty value.
+std::string format_versioned_value(std::string_view value,
                                    uint64_t timestamp_ms, uint32_t node_id);
 
 /// Result of parsing a versioned GET response from a replica.
@@ -103,4 +210,143 @@ struct VersionedGetResult {
 /// (treated as an error / not-found).
 VersionedGetResult parse_versioned_response(const std::string& resp);
 
+// ── Binary wire protocol ─────────────────────────────────────────────────────
+//
+// Compact length-prefixed framing for high-throughput clients and inter-node
+// traffic.  The text protocol above stays the default (dkv_cli uses it).
+//
+// Negotiation is per connection and implicit: text commands always start with
+// an ASCII letter, so a connection whose first byte is BINARY_MAGIC speaks the
+// binary protocol for its whole lifetime.
+//
+// Frame layout (requests and responses share it; integers little-endian):
+//   [Magic 1B] [Opcode 1B] [Flags 1B] [ExtrasLen 1B]
+//   [RequestId 4B] [KeyLen 4B] [ValLen 4B]
+//   [Extras ...] [Key ...] [Value ...]
+//
+// The request id is opaque to the server and echoed in the response, so a
+// client may pipeline many requests and match replies that complete out of
+// order.  Extras carry fixed-size per-opcode fields, e.g. the Version of
+// RSET/RDEL requests and of VALUE responses to RGET.
+
+constexpr uint8_t  BINARY_MAGIC        = 0xDB;
+constexpr size_t   BINARY_HEADER_SIZE  = 16;
+constexpr size_t   BINARY_VERSION_SIZE = 12;            // timestamp_ms + node_id
+constexpr uint32_t BINARY_MAX_KEY_LEN  = 64 * 1024;
+constexpr uint32_t BINARY_MAX_VAL_LEN  = 64 * 1024 * 1024;
+
+// Response flags.
+constexpr uint8_t  BINARY_FLAG_BUSY    = 0x01;  // the node is snapshotting:
+                                                // read from others if possible
+
+enum class BinaryOpcode : uint8_t {
+    // ── Requests ─────────────────────────────────────────────────────────
+    GET        = 0x01,
+    SET        = 0x02,
+    DEL        = 0x03,
+    PING       = 0x04,
+    TOPOLOGY   = 0x05,  // answered by a VALUE holding the ring layout
+    DECOMMISSION = 0x06,  // answered by OK once the node has left the ring
+    HOTKEYS    = 0x07,  // answered by a VALUE holding the hot-key report
+    MGET       = 0x08,  // value: argument list as in the text protocol;
+                        // answered by a VALUE holding the MGET reply payload
+    MSET       = 0x09,  // value: argument list as in the text protocol
+    STATS      = 0x0A,  // answered by a VALUE holding the metrics
+    RGET       = 0x10,  // extras: none
+    RSET       = 0x11,  // extras: version
+    RDEL       = 0x12,  // extras: version
+    FWD        = 0x13,  // extras: hops (1 byte); value: inner text command
+    RBATCH     = 0x14,  // value: concatenated RSET/RDEL/RGET frames; answered
+                        // by a VALUE whose value is the concatenated inner
+                        // responses, each carrying its inner request id
+    RDIGEST    = 0x15,  // extras: none; answered by an empty VALUE + version
+    AEHASH     = 0x16,  // value: fingerprint, level, ids; answered by a VALUE
+                        // of 64-bit hashes (see AntiEntropy)
+    AEKEYS     = 0x17,  // value: fingerprint, leaf ids; answered by a VALUE
+                        // listing each key with its version
+    RSCAN      = 0x18,  // value: shard, cursor, ranges; answered by a VALUE
+                        // holding a checksummed chunk (see Rebalancer)
+    RLOAD      = 0x19,  // value: a chunk as returned by RSCAN
+    RING       = 0x1A,  // value: membership change in text form
+    GOSSIP     = 0x1B,  // value: a SWIM message; answered by a VALUE holding
+                        // the reply (see Gossip)
+
+    // ── Responses ────────────────────────────────────────────────────────
+    OK         = 0x80,
+    VALUE      = 0x81,  // extras: version (RGET/RDIGEST only)
+    NOT_FOUND  = 0x82,
+    ERROR      = 0x83,  // value: error message
+    PONG       = 0x84,
+};
+
+/// A decoded binary frame.  All views point into the caller's buffer and are
+/// valid only until that buffer is modified.
+struct BinaryFrame {
+    BinaryOpcode     opcode     = BinaryOpcode::PING;
+    uint8_t          flags      = 0;
+    uint32_t         request_id = 0;
+    std::string_view extras;
+    std::string_view key;
+    std::string_view value;
+};
+
+struct BinaryParseResult {
+    ParseStatus status;
+    BinaryFrame frame;          // valid only when status == OK
+    size_t      bytes_consumed; // frame size; the whole buffer when fatal
+    std::string error_msg;      // set when status == ERROR
+    bool        fatal;          // header unusable — stream cannot resync
+};
+
+/// Try to parse a single binary frame from `data` without copying.
+///
+/// A bad magic byte or an oversized length leaves the stream impossible to
+/// resynchronise: `fatal` is set, `bytes_consumed` covers the whole buffer,
+/// and the caller should close the connection after replying.  Frames that
+/// are well formed but semantically wrong (e.g. an unknown opcode) consume
+/// just that frame.
+BinaryParseResult try_parse_binary(const char* data, size_t len);
+
+/// Append just a frame header to `out`; the caller supplies the extras, key
+/// and value bytes (e.g. as separate iovecs).
+void append_binary_header(std::string& out, BinaryOpcode opcode,
+                          uint32_t request_id, size_t extras_len,
+                          size_t key_len, size_t value_len, uint8_t flags = 0);
+
+/// Append one encoded binary frame to `out`.
+void append_binary_frame(std::string& out, BinaryOpcode opcode,
+                         uint32_t request_id, std::string_view extras = {},
+                         std::string_view key = {}, std::string_view value = {},
+                         uint8_t flags = 0);
+
+/// Encode a Version into the 12-byte extras field.
+std::string encode_version_extras(uint64_t timestamp_ms, uint32_t node_id);
+
+/// Decode a 12-byte version extras field.  Returns false on size mismatch.
+bool decode_version_extras(std::string_view extras,
+                           uint64_t& timestamp_ms, uint32_t& node_id);
+
+/// Convert a binary request frame into a CommandView (no copy).  Returns
+/// false and points `error` at a static message for opcodes that are not
+/// requests or for missing/invalid extras.
+bool binary_frame_to_view(const BinaryFrame& frame, CommandView& out,
+                          std::string_view& error);
+
+/// Convert a binary request frame into a Command (copies key and value).
+/// Returns false and sets `error` for opcodes that are not requests or for
+/// missing/invalid extras.
+bool binary_frame_to_command(const BinaryFrame& frame, Command& out,
+                             std::string& error);
+
+/// Translate a binary response frame back into its text-protocol form
+/// (the inverse of text_to_binary_response).  A VALUE frame carrying
+/// version extras becomes a "$V ..." versioned response.
+std::string binary_response_to_text(const BinaryFrame& frame);
+
+/// Translate a text-protocol response ("+OK\n", "$3 foo\n", "$V ...\n",
+/// "-NOT_FOUND\n", "-ERR ...\n", "+PONG\n") into the equivalent binary
+/// response frame carrying `request_id` and `flags`.
+std::string text_to_binary_response(uint32_t request_id,
+                                    std::string_view text, uint8_t flags = 0);
+
 }  // namespace dkv
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace dkv {
+
+/// Receive buffer of a non-blocking socket.
+///
+/// Bytes are read straight into spare capacity that is never zero-filled
+/// (prepare() / commit()), and parsed frames are dropped from the front by
+/// moving a cursor (consume()); the remaining bytes are moved down only when
+/// the space is needed.  Views into data() stay valid until the next
+/// prepare() or shrink().  After a large frame has gone through,
+/// shrink() hands the memory back so an idle connection does not keep it.
+class ReadBuffer {
+public:
+    const char* data() const { return buf_.get() + begin_; }
+    size_t      size() const { return end_ - begin_; }
+    bool        empty() const { return begin_ == end_; }
+    size_t      capacity() const { return cap_; }
+
+    /// Make room for at least `min` bytes after the data and return where
+    /// they go; spare() says how many fit.
+    char*  prepare(size_t min);
+    size_t spare() const { return cap_ - end_; }
+
+    /// The first `n` spare bytes now hold data.
+    void commit(size_t n) { end_ += n; }
+
+    /// Drop the first `n` bytes.
+    void consume(size_t n);
+
+    void clear() { begin_ = end_ = 0; }
+
+    /// Release the storage if it has grown past `keep` bytes while the data
+    /// left would fit in `keep`.
+    void shrink(size_t keep);
+
+private:
+    std::unique_ptr<char[]> buf_;
+    size_t                  cap_   = 0;
+    size_t                  begin_ = 0;
+    size_t                  end_   = 0;
+
+    /// Move the data to a fresh allocation of `cap` bytes.
+    void reallocate(size_t cap);
+};
+
+}  // namespace dkv
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace dkv {
+
+/// Move-only, type-erased `void()` callable with small-buffer optimisation.
+///
+/// Callables up to INLINE_SIZE bytes (and no more strictly aligned than
+/// max_align_t) are stored in place, so submitting a typical request lambda
+/// to the ThreadPool costs no heap allocation.  Larger callables fall back
+/// to a single heap allocation.  Unlike std::function, move-only captures
+/// (unique_ptr, moved-in Commands) are fine.
+class Task {
+public:
+    /// Sized to hold the TCPServer dispatch lambda (an owned Command plus a
+    /// few scalars) inline.
+    static constexpr size_t INLINE_SIZE = 192;
+
+    Task() noexcept = default;
+
+    template <typename F,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f) {  // implicit, so pool.submit([..]{..}) keeps working
+        using Fn = std::decay_t<F>;
+        if constexpr (fits_inline<Fn>()) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &inline_ops<Fn>;
+        } else {
+            ::new (static_cast<void*>(storage_)) Fn*(new Fn(std::forward<F>(f)));
+            ops_ = &heap_ops<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept : ops_(other.ops_) {
+        if (ops_) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops_ = other.ops_;
+            if (ops_) {
+                ops_->move(storage_, other.storage_);
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    /// Invoke the stored callable.  Precondition: non-empty.
+    void operator()() { ops_->invoke(storage_); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    /// Destroy the stored callable, leaving the task empty.
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    /// True if a callable of type F is stored without a heap allocation.
+    template <typename F>
+    static constexpr bool fits_inline() {
+        return sizeof(F) <= INLINE_SIZE &&
+               alignof(F) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<F>;
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* self);
+        void (*move)(void* dst, void* src) noexcept;  // move-construct + destroy src
+        void (*destroy)(void* self) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr Ops inline_ops = {
+        [](void* self) { (*static_cast<Fn*>(self))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* self) noexcept { static_cast<Fn*>(self)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops heap_ops = {
+        [](void* self) { (**static_cast<Fn**>(self))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn*(*static_cast<Fn**>(src));
+        },
+        [](void* self) noexcept { delete *static_cast<Fn**>(self); },
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[INLINE_SIZE];
+    const Ops* ops_ = nullptr;
+};
+
+}  // namespace dkv
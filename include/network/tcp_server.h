@@ -1,16 +1,21 @@
 #pragma once
 
+#include "network/mpsc_queue.h"
 #include "network/poller.h"
 #include "network/protocol.h"
+#include "network/read_buffer.h"
 #include "network/thread_pool.h"
+#include "network/wakeup_fd.h"
 #include "storage/storage_engine.h"
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
-#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace dkv {
@@ -18,16 +23,28 @@ namespace dkv {
 // Forward declaration — avoid circular include
 class Coordinator;
 
+/// Wire protocol spoken on a connection, decided by its first byte.
+enum class WireProtocol : uint8_t {
+    UNKNOWN,    // nothing received yet
+    TEXT,       // newline-terminated text commands
+    BINARY,     // length-prefixed binary frames (see protocol.h)
+};
+
 /// Per-connection state, owned exclusively by the event loop thread.
 struct Connection {
-    int         fd = -1;
-    std::string read_buf;    // accumulated incoming bytes
-    std::string write_buf;   // pending outgoing bytes
+    int          fd = -1;
+    uint64_t     id = 0;              // unique for the server's lifetime
+    ReadBuffer   read_buf;            // accumulated incoming bytes
+    std::string  write_buf;           // pending outgoing bytes
+    WireProtocol protocol = WireProtocol::UNKNOWN;
+    bool         read_paused = false; // POLL_READ dropped for backpressure
+    bool         write_blocked = false; // last write hit EAGAIN; awaiting POLL_WRITE
 };
 
 /// Response from a worker thread, to be written back on the event loop.
 struct PendingResponse {
-    int         fd;
+    int         fd = -1;
+    uint64_t    conn_id = 0;  // guards against delivery to a reused fd
     std::string data;
 };
 
@@ -36,7 +53,9 @@ struct PendingResponse {
 /// Ownership rules (per ChatGPT feedback §3):
 ///   - The event loop thread owns all Connection state and socket I/O.
 ///   - Workers receive parsed Commands and return response strings.
-///   - Responses are pushed back via a thread-safe queue + wakeup fd.
+///   - Responses are pushed back via a lock-free MPSC queue + wakeup fd.
+///     Workers only signal the fd when no wakeup is already pending, so a
+///     burst of completions costs one eventfd write and one loop iteration.
 class TCPServer {
 public:
     /// Construct the server (local-only mode).
@@ -62,6 +81,38 @@ public:
     /// Signal the event loop to stop (thread-safe).
     void stop();
 
+    /// Output-buffer limits protecting the server from clients that send
+    /// requests faster than they read responses.  All sizes in bytes;
+    /// 0 disables the corresponding check.
+    struct OutputLimits {
+        /// Stop reading from a connection once this much output is queued.
+        size_t high_water        = 1 * 1024 * 1024;
+        /// Resume reading once queued output drains to this.
+        size_t low_water         = 256 * 1024;
+        /// Disconnect a connection with more than this queued.
+        size_t hard_limit        = 256 * 1024 * 1024;
+        /// Across all connections: above this, every connection with
+        /// output pending stops reading.
+        size_t global_high_water = 1024 * 1024 * 1024;
+    };
+
+    /// Counters describing backpressure activity (readable from any thread).
+    struct OutputStats {
+        uint64_t paused_connections      = 0;  // gauge: currently paused
+        uint64_t pause_events            = 0;  // total times a read was paused
+        uint64_t slow_client_disconnects = 0;  // total hard-limit disconnects
+        uint64_t output_bytes            = 0;  // gauge: queued output, all conns
+    };
+
+    /// Configure output limits.  Call before run().
+    void set_output_limits(const OutputLimits& limits);
+
+    /// Snapshot of backpressure counters.
+    OutputStats output_stats() const;
+
+    /// Commands handed to a worker and not yet answered.
+    int in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+
     ~TCPServer();
 
     // Non-copyable
@@ -76,26 +127,64 @@ private:
     std::unique_ptr<Poller>                  poller_;
     ThreadPool                               pool_;
     int                                      listen_fd_ = -1;
-    int                                      wakeup_read_fd_ = -1;
-    int                                      wakeup_write_fd_ = -1;
+    WakeupFd                                 wakeup_;
     std::atomic<bool>                        running_{false};
     std::atomic<bool>                        draining_{false};
     std::atomic<int>                         in_flight_{0};
 
     static constexpr int DRAIN_TIMEOUT_MS = 5000;
 
+    /// Minimum free space reserved in a read buffer before each read().
+    static constexpr size_t READ_CHUNK = 16 * 1024;
+
+    /// Read buffer capacity kept once its data is parsed; beyond this it is
+    /// released (a large value went through).
+    static constexpr size_t READ_BUF_KEEP = 4 * READ_CHUNK;
+
     // Connections owned by the event loop thread
     std::unordered_map<int, Connection>      connections_;
 
-    // Thread-safe response queue (workers → event loop)
-    std::mutex                               response_mutex_;
-    std::vector<PendingResponse>             response_queue_;
+    // Lock-free response queue (workers → event loop)
+    MpscQueue<PendingResponse>               response_queue_;
+
+    // Set by the first producer after the event loop last drained; further
+    // producers see it set and skip the wakeup syscall.
+    std::atomic<bool>                        wakeup_pending_{false};
+
+    // Connections with output appended during the current drain, flushed
+    // once each at the end of it.
+    std::vector<int>                         flush_list_;
+
+    // ── Backpressure (event loop thread, except the atomic counters) ──────
+    OutputLimits                             limits_;
+    uint64_t                                 next_conn_id_ = 1;
+    std::unordered_set<int>                  paused_fds_;
+    std::vector<int>                         resume_list_;
+    std::atomic<uint64_t>                    output_bytes_{0};
+    std::atomic<uint64_t>                    paused_connections_{0};
+    std::atomic<uint64_t>                    pause_events_{0};
+    std::atomic<uint64_t>                    slow_client_disconnects_{0};
 
     /// Create a non-blocking, SO_REUSEADDR listening socket.
     bool setup_listener();
 
-    /// Create the wakeup pipe (eventfd on Linux, pipe on macOS).
-    bool setup_wakeup();
+    /// Push a worker response and wake the event loop if it is not already
+    /// due to drain the queue.
+    void post_response(int fd, uint64_t conn_id, std::string data);
+
+    /// Encode a finished text response for its connection's protocol, post
+    /// it, record the command's latency since `start`, and retire the
+    /// request from in_flight_.  Any thread.
+    void finish_request(int fd, uint64_t conn_id, bool binary,
+                        uint32_t request_id, CommandType type,
+                        std::chrono::steady_clock::time_point start,
+                        std::string response);
+
+    /// The tail of finish_request() for a response already encoded for its
+    /// connection: post it, record latency (and `error`), retire it.
+    void complete_request(int fd, uint64_t conn_id, CommandType type,
+                          std::chrono::steady_clock::time_point start,
+                          bool error, std::string data);
 
     /// Accept new connections from the listen socket.
     void handle_accept();
@@ -106,12 +195,55 @@ private:
     /// Try to parse and dispatch commands from the connection's read buffer.
     void process_commands(int fd);
 
-    /// Execute a parsed command on the storage engine.
-    std::string execute_command(const Command& cmd);
+    /// Text-protocol half of process_commands().
+    void process_text_commands(Connection& conn);
 
-    /// Write queued data to a connection's socket.
+    /// Binary-protocol half of process_commands().  Returns false if the
+    /// connection was closed because the stream could not be resynchronised.
+    bool process_binary_commands(int fd, Connection& conn);
+
+    /// Hand a parsed command to the worker pool, copying it out of the read
+    /// buffer only at that point.  When `binary` is set the response is
+    /// encoded as a binary frame carrying `request_id`.
+    void dispatch(Connection& conn, const CommandView& cmd, bool binary,
+                  uint32_t request_id);
+
+    /// Append a response produced on the event loop thread itself directly
+    /// to the connection's output; it is flushed when the current read
+    /// batch has been processed.
+    void queue_local_response(Connection& conn, std::string resp);
+
+    /// Execute a parsed command on the storage engine (local-only mode).
+    /// Takes the command by non-const reference so a SET value can be moved
+    /// into the engine.
+    std::string execute_command(Command& cmd);
+
+    /// Write queued data to a connection's socket, then apply the output
+    /// limits: disconnect over the hard cap, pause or schedule a resume.
     void handle_write(int fd);
 
+    /// Count and close a connection over the output hard limit.
+    void disconnect_slow_client(Connection& conn);
+
+    /// Append to a connection's write_buf, keeping output_bytes_ in step.
+    void append_output(Connection& conn, std::string_view data);
+
+    /// Re-register the fd for POLL_READ / POLL_WRITE to match its state.
+    void update_interest(Connection& conn);
+
+    /// Whether a connection should stop reading given its queued output.
+    bool should_pause(const Connection& conn) const;
+
+    /// Whether a paused connection may read again.
+    bool can_resume(const Connection& conn) const;
+
+    /// Stop reading from a connection (takes effect via update_interest).
+    void pause_reading(Connection& conn);
+
+    /// Resume connections on resume_list_ (and all paused ones, once back
+    /// under the global mark), processing any input buffered meanwhile.
+    void resume_paused();
+
     /// Drain the response queue (called from event loop after wakeup).
     void drain_responses();
 
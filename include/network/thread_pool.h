@@ -1,32 +1,44 @@
 #pragma once
 
-#include <condition_variable>
-#include <functional>
-#include <mutex>
-#include <queue>
+#include "network/task.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <thread>
 #include <vector>
 
 namespace dkv {
 
-/// A fixed-size thread pool with a blocking task queue.
+/// A fixed-size work-stealing thread pool.
 ///
 /// Ownership rules (per ChatGPT feedback §3):
 ///   - The event loop thread submits tasks (parsed requests).
 ///   - Workers execute business logic and return response objects.
 ///   - Workers NEVER touch socket I/O or connection state.
+///
+/// Scheduling:
+///   - Tasks submitted from outside the pool go through a lock-free bounded
+///     MPMC injection queue (a mutex-protected overflow list catches bursts
+///     beyond its capacity).
+///   - Tasks submitted by a worker of this pool go onto that worker's own
+///     Chase-Lev deque; idle workers steal from the other end.
+///   - An idle worker spins briefly, then parks on an atomic wait.
+///     Submitters only pay for a wake-up when some worker is parked.
+///   - Tasks are `Task` objects (small-buffer optimised), so a typical
+///     request lambda is not heap-allocated.  Worker deques hold them in
+///     per-worker nodes that are recycled, not allocated per submit.
 class ThreadPool {
 public:
     /// Create the pool with `num_threads` workers and start them immediately.
     explicit ThreadPool(size_t num_threads);
 
     /// Submit a task for asynchronous execution.  Returns false if the pool
-    /// has been shut down.
-    bool submit(std::function<void()> task);
+    /// has been shut down; a task for which true was returned always runs.
+    bool submit(Task task);
 
-    /// Signal all workers to stop after finishing their current task.
-    /// Blocks until all threads have joined.  Pending tasks in the queue
-    /// are discarded.
+    /// Stop accepting tasks, run every task already submitted, then join
+    /// all workers.  Idempotent.
     void shutdown();
 
     /// Returns the number of worker threads.
@@ -39,11 +51,30 @@ public:
     ThreadPool& operator=(const ThreadPool&) = delete;
 
 private:
-    std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    bool stopped_ = false;
+    struct Worker;          // per-worker deque + thread (thread_pool.cpp)
+    class InjectionQueue;   // bounded MPMC ring + overflow (thread_pool.cpp)
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::unique_ptr<InjectionQueue>      injection_;
+
+    // ── Shutdown ─────────────────────────────────────────────────────────
+    std::atomic<bool>     stopped_{false};     // submit() refuses new tasks
+    std::atomic<uint32_t> submitters_{0};      // submit() calls in progress
+    std::atomic<bool>     drain_ready_{false}; // no more tasks can arrive
+    std::atomic<bool>     joined_{false};
+
+    // ── Parking ──────────────────────────────────────────────────────────
+    std::atomic<uint32_t> sleepers_{0};        // workers parked (or about to)
+    std::atomic<uint32_t> wake_epoch_{0};      // bumped to wake parked workers
+
+    /// Body of worker thread `index`.
+    void worker_loop(size_t index);
+
+    /// Find a task: own deque, then injection queue, then steal.
+    bool find_task(size_t index, Task& out);
+
+    /// Wake one parked worker, if any are parked.
+    void wake_one();
 };
 
 }  // namespace dkv
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+
+namespace dkv {
+
+/// Cross-thread wake-up for a poll loop: eventfd on Linux, a non-blocking
+/// pipe on macOS.  Register read_fd() with the Poller for POLL_READ; any
+/// thread may call signal(), and the loop calls clear() when it fires.
+class WakeupFd {
+public:
+    WakeupFd() = default;
+    ~WakeupFd();
+
+    /// Create the underlying fd(s).  Returns false (and logs) on failure.
+    bool open();
+
+    /// Close the underlying fd(s).  Not thread-safe with signal().
+    void close();
+
+    bool is_open() const { return read_fd_.load(std::memory_order_acquire) >= 0; }
+
+    /// The fd to register with the Poller.
+    int read_fd() const { return read_fd_.load(std::memory_order_acquire); }
+
+    /// Make read_fd() readable.  Safe from any thread once open.
+    void signal();
+
+    /// Consume pending signals.  Loop thread only.
+    void clear();
+
+    WakeupFd(const WakeupFd&) = delete;
+    WakeupFd& operator=(const WakeupFd&) = delete;
+
+private:
+    std::atomic<int> read_fd_{-1};
+    int              write_fd_ = -1;  // == read_fd_ for eventfd
+};
+
+}  // namespace dkv
@@ -2,9 +2,14 @@
 
 #include "storage/storage_engine.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -20,22 +25,82 @@ struct Hint {
     Version     version;         // the exact version the coordinator chose
 };
 
+/// A hint handed out for replay; `seq` identifies it to HintStore::ack().
+struct ReplayItem {
+    uint64_t seq = 0;
+    Hint     hint;
+};
+
 /// Thread-safe store for hinted handoff.
 ///
 /// When a quorum write cannot reach a replica (connection refused / timeout),
 /// the coordinator stores a Hint here.  Phase 6 calls replay_for() once the
 /// node is seen as UP again so the hints are delivered and then deleted.
 ///
-/// Persistence: hints are appended to "<hints_dir>/hints_<target_node_id>.dat"
-/// in a simple binary format so they survive coordinator crashes.
+/// Hints for a target form a queue.  A newer hint for a key already queued
+/// supersedes the old one; an older or equal one is dropped, so a replay
+/// sends each key at most once, at its latest version.  Replay is streamed:
+/// next_for_replay() hands out a window of hints, ack() marks the delivered
+/// ones individually and drops the finished prefix of the queue.
+///
+/// Persistence: each target has an append-only log split into segments,
+/// "<hints_dir>/hints_<target>.<segment>.log", of CRC-checked records.  Only
+/// keys and versions stay in memory; values are read back from the mmap'd
+/// segments at replay time.  A segment is deleted once every hint in it is
+/// done, and "hints_<target>.ckpt" records where the first undelivered hint
+/// starts, so a replay interrupted by a failure or a crash resumes there.
+/// Without a hints_dir, values are kept in memory instead.
+///
+/// store() runs on the request path, so it never touches the disk: it
+/// queues the hint (value in memory) and wakes a writer thread, which
+/// appends the queued hints, fsyncs, deletes finished segments and compacts.
+/// File work is serialised by io_mutex_, separate from mutex_, so a store()
+/// never waits for a write(2), an fsync or a compaction.  Replay and load
+/// hold io_mutex_ as well: they read values back from the segments.
+///
+/// Bounds (Options): the bytes of pending hints per target are capped (new
+/// hints are dropped once it is full — anti-entropy repairs those keys
+/// later), as are those the writer has not caught up with; hints older than
+/// `max_age_ms` expire, and once superseded hints outnumber live ones (or
+/// they hold the log over the cap) the queue and its log are compacted.
 class HintStore {
 public:
+    struct Options {
+        uint64_t segment_bytes    = 16ull << 20;    // log segment size
+        uint64_t max_bytes        = 1ull << 30;     // per target; 0 = no cap
+        uint64_t max_age_ms       = 3 * 3600 * 1000;  // 0 = never expire
+        uint32_t sync_interval_ms = 1000;           // fsync appends at most
+                                                    // this often; 0 = always
+    };
+
+    struct Stats {
+        size_t   pending     = 0;  // hints waiting for replay
+        uint64_t queued_bytes = 0;  // record bytes held for all targets
+        size_t   segments    = 0;  // log files on disk
+        uint64_t stored      = 0;
+        uint64_t coalesced   = 0;  // dropped or superseded by a newer version
+        uint64_t dropped     = 0;  // rejected by a size cap, or not written
+        uint64_t expired     = 0;  // older than max_age_ms
+        uint64_t delivered   = 0;
+        uint64_t compactions = 0;
+    };
+
     /// @param hints_dir  Directory for hint files.  Empty = in-memory only.
     explicit HintStore(const std::string& hints_dir = "");
+    HintStore(const std::string& hints_dir, Options options);
 
-    /// Persist a hint (and keep it in memory for fast replay).
+    /// Writes out what is still queued and closes the active segments.
+    ~HintStore();
+
+    /// Queue a hint for replay; the writer thread persists it.  Dropped if a
+    /// hint with the same or a newer version of the key is pending, or the
+    /// target is full.
     void store(const Hint& hint);
 
+    /// Write every hint queued so far, run pending compactions and fsync,
+    /// on the caller's thread.  Returns once it is all on disk.
+    void flush();
+
     /// Return all pending hints for the given target node.
     std::vector<Hint> get_hints_for(uint32_t target_node_id) const;
 
@@ -45,7 +110,31 @@ public:
     /// Total number of pending hints across all nodes.
     size_t size() const;
 
-    /// Load hints from disk (call once on startup to recover across crashes).
+    /// Pending hints for one target node.
+    size_t size_for(uint32_t target_node_id) const;
+
+    Stats stats() const;
+
+    /// Adjust the limits; applies to hints stored from now on.
+    void set_options(const Options& options);
+
+    /// Claim the replay of a target's hints.  Returns false if another
+    /// replay for it is still running.
+    bool begin_replay(uint32_t target_node_id);
+    void end_replay(uint32_t target_node_id);
+
+    /// Up to `max` pending hints with seq >= `from_seq`, oldest first.
+    /// `next_seq` is set to where the following call should continue.
+    std::vector<ReplayItem> next_for_replay(uint32_t target_node_id,
+                                            uint64_t from_seq, size_t max,
+                                            uint64_t& next_seq);
+
+    /// Mark hints as delivered, drop the delivered prefix of the queue and
+    /// checkpoint the log position.
+    void ack(uint32_t target_node_id, const std::vector<uint64_t>& seqs);
+
+    /// Load hints from disk (call once on startup, before store(), to recover
+    /// across crashes).
     void load();
 
     // Non-copyable
@@ -53,21 +142,130 @@ public:
     HintStore& operator=(const HintStore&) = delete;
 
 private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Entry::segment of a hint that is not (or not yet) on disk.
+    static constexpr uint32_t NO_SEGMENT = UINT32_MAX;
+
+    struct Entry {
+        std::string key;
+        Version     version;
+        bool        is_del       = false;
+        std::string value;             // in-memory mode, or not written yet
+        uint32_t    segment      = NO_SEGMENT;
+        uint64_t    offset       = 0;  // record start within the segment
+        uint64_t    value_offset = 0;
+        uint32_t    value_len    = 0;
+        uint32_t    record_bytes = 0;
+        uint64_t    stored_ms    = 0;  // wall clock, for max_age_ms
+        bool        superseded   = false;  // a newer hint for the key is queued
+        bool        delivered    = false;
+    };
+
+    struct Segment {
+        uint32_t id   = 0;
+        uint64_t size = 0;
+    };
+
+    struct TargetHints {
+        std::string                               address;        // latest seen
+        std::deque<Entry>                         entries;
+        uint64_t                                  first_seq = 0;  // of entries.front()
+        std::unordered_map<std::string, uint64_t> latest;         // key → seq
+        size_t                                    pending   = 0;  // neither superseded nor delivered
+        uint64_t                                  bytes      = 0;  // record bytes queued
+        uint64_t                                  live_bytes = 0;  // ... of pending hints
+        bool                                      replaying = false;
+
+        // Writer progress: hints from write_seq on are not handed to the
+        // writer yet (their values are in memory).
+        uint64_t write_seq       = 0;
+        uint64_t unwritten_bytes = 0;
+        bool     compact_wanted  = false;
+        bool     files_stale     = false;  // finished hints left the queue
+
+        // Log segments, oldest first; the active one (if open) is last.
+        // Guarded by io_mutex_ alone.
+        std::deque<Segment> segments;
+        int                 fd           = -1;
+        uint32_t            next_segment = 0;
+        Clock::time_point   last_sync;
+        bool                dirty        = false;  // appended since last fsync
+    };
+
     std::string hints_dir_;
+    Options     options_;
 
+    // Lock order: io_mutex_, then mutex_.
+    mutable std::mutex io_mutex_;
     mutable std::mutex mutex_;
-    // target_node_id → pending hints
-    std::unordered_map<uint32_t, std::vector<Hint>> hints_;
+    std::unordered_map<uint32_t, TargetHints> hints_;
+    Stats stats_;
+    std::atomic<size_t> segment_files_{0};
+
+    std::condition_variable writer_cv_;
+    std::thread             writer_;       // started by the first store()
+    bool                    writer_stop_ = false;
+    bool                    writer_work_ = false;
+
+    void writer_loop();
+
+    /// Persist queued hints, compact, trim finished segments and fsync (when
+    /// due, or always with `sync_all`) for every target.  Caller holds
+    /// io_mutex_.
+    void flush_io(bool sync_all);
+
+    /// Hand the target's unwritten hints to the log.  Caller holds io_mutex_.
+    void write_pending(uint32_t target, TargetHints& t);
+
+    /// Queue an entry, coalescing by key.  Returns false if it was dropped.
+    /// Caller holds mutex_.
+    bool insert_locked(TargetHints& t, Entry entry);
+
+    /// A pending entry leaves the live set (superseded, delivered, expired
+    /// or lost); the caller flags it.  Caller holds mutex_.
+    void finish_locked(TargetHints& t, const Entry& e);
+
+    /// Recompute latest, bytes and pending after the queue was rebuilt.
+    /// Caller holds mutex_.
+    void reindex_locked(TargetHints& t);
+
+    /// Append a record to the active segment, rolling to a new one when
+    /// full.  Fills in the entry's location.  Returns false on I/O failure.
+    /// Caller holds io_mutex_.
+    bool append_record(uint32_t target, TargetHints& t, const Hint& hint,
+                       uint64_t segment_bytes, Entry& entry);
+
+    /// Drop finished (delivered/superseded) and expired entries from the
+    /// front of the queue.  Caller holds mutex_.
+    void drop_finished_locked(TargetHints& t);
+
+    /// Delete segments the queue no longer needs and checkpoint.  Caller
+    /// holds io_mutex_ (not mutex_).
+    void trim_files(uint32_t target, TargetHints& t);
+
+    /// Rewrite the queue (and its log) with only the live hints.  Caller
+    /// holds io_mutex_ (not mutex_).
+    void compact(uint32_t target, TargetHints& t);
+
+    /// Values of `entries`, read from the mmap'd segments (or memory).
+    /// Caller holds io_mutex_, so segments and unwritten values stay put.
+    std::vector<std::string> read_values(
+        uint32_t target, const std::vector<const Entry*>& entries) const;
+
+    /// fsync the active segment if the sync interval has passed (or
+    /// `force`).  Caller holds io_mutex_.
+    void sync_segment(TargetHints& t, uint32_t sync_interval_ms, bool force);
 
-    /// Append a single hint to the on-disk file for target_node_id.
-    /// Called while mutex_ is NOT held (file I/O outside the lock).
-    void append_to_disk(const Hint& hint) const;
+    /// Close and delete every segment and the checkpoint of a target.
+    /// Caller holds io_mutex_.
+    void remove_files(uint32_t target, TargetHints& t);
 
-    /// File path for a given target node's hints.
-    std::string hint_file_path(uint32_t target_node_id) const;
+    std::string segment_path(uint32_t target, uint32_t segment) const;
+    std::string checkpoint_path(uint32_t target) const;
 
-    /// Parse all hints from a single hint file.
-    std::vector<Hint> load_file(const std::string& path) const;
+    /// Parse one segment from `offset`, truncating a torn or corrupt tail.
+    void load_segment(uint32_t target, uint32_t segment, uint64_t offset);
 };
 
 }  // namespace dkv
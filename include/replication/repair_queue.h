@@ -0,0 +1,125 @@
+#pragma once
+
+#include "cluster/hash_ring.h"
+#include "storage/storage_engine.h"
+#include "utils/token_bucket.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace dkv {
+
+/// One pending read-repair write: bring `key` on a replica up to `version`.
+struct RepairItem {
+    std::string                        key;
+    std::shared_ptr<const std::string> value;  // shared by every stale replica
+    Version                            version;
+};
+
+/// Background read-repair queue (§9.C of CONTEXT.md).
+///
+/// Repairs are held per target replica and deduplicated by key: a key that
+/// is already pending for a replica keeps only the newest version, so a hot
+/// key read many times while stale costs one repair.  A single worker thread
+/// serves the targets round-robin, handing the sender up to `batch_max`
+/// repairs for one replica at a time.  Queued bytes are capped (repairs past
+/// the cap are dropped; the next read of the key will find it stale again)
+/// and the bytes sent per second can be limited with a token bucket.
+class RepairQueue {
+public:
+    struct Options {
+        size_t   max_bytes          = 64ull << 20;  // queued key+value bytes
+        uint64_t rate_bytes_per_sec = 0;            // 0 = unlimited
+        size_t   batch_max          = 64;           // repairs per send
+    };
+
+    struct Stats {
+        size_t   depth           = 0;  // repairs waiting
+        size_t   queued_bytes    = 0;
+        uint64_t enqueued        = 0;
+        uint64_t deduplicated    = 0;  // merged into an already pending repair
+        uint64_t dropped         = 0;  // rejected by the memory cap
+        uint64_t repaired        = 0;  // acknowledged by the target
+        uint64_t failed          = 0;
+        double   repairs_per_sec = 0;  // over the last completed second
+    };
+
+    /// Delivers one batch to `target`; returns how many repairs succeeded.
+    /// Called on the worker thread, one batch at a time.
+    using Sender = std::function<size_t(const NodeInfo& target,
+                                        const std::vector<RepairItem>& batch)>;
+
+    explicit RepairQueue(Sender sender);
+    RepairQueue(Sender sender, Options options);
+
+    /// Drains what is still queued (ignoring the rate limit) and joins.
+    ~RepairQueue();
+
+    /// Queue a repair.  Returns false if it was dropped by the memory cap.
+    bool enqueue(const NodeInfo& target, const std::string& key,
+                 std::shared_ptr<const std::string> value,
+                 const Version& version);
+
+    /// Adjust the limits; takes effect from the next batch.
+    void set_options(const Options& options);
+
+    /// Send everything still queued, then stop the worker.  Idempotent.
+    void stop();
+
+    Stats stats() const;
+
+    // Non-copyable
+    RepairQueue(const RepairQueue&) = delete;
+    RepairQueue& operator=(const RepairQueue&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct TargetQueue {
+        NodeInfo                                    target;
+        std::deque<std::string>                     order;  // FIFO of keys
+        std::unordered_map<std::string, RepairItem> items;
+    };
+
+    Sender sender_;
+
+    mutable std::mutex                mutex_;
+    std::condition_variable           cv_;
+    Options                           options_;
+    std::map<uint32_t, TargetQueue>   targets_;  // by node id
+    uint32_t                          last_target_ = 0;
+    bool                              running_     = true;
+    Stats                             stats_;
+
+    // Paces bytes sent; may go negative after a large batch.
+    TokenBucket bucket_;
+
+    // repairs/sec bookkeeping
+    Clock::time_point window_start_;
+    uint64_t          window_repaired_ = 0;
+    Clock::time_point last_report_;
+
+    std::thread worker_;
+
+    void run();
+
+    /// Take the next batch, round-robin across targets.  Caller holds mutex_.
+    bool take_batch(NodeInfo& target, std::vector<RepairItem>& batch,
+                    size_t& bytes);
+
+    static size_t item_bytes(const RepairItem& item) {
+        return item.key.size() + (item.value ? item.value->size() : 0);
+    }
+};
+
+}  // namespace dkv
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace dkv {
+
+struct Version;
+
+/// Incrementally maintained hash tree over the token ranges of the ring,
+/// used by anti-entropy to find where two replicas disagree.
+///
+/// There is one range per ring token (the positions the token owns, see
+/// HashRing::tokens()), split evenly into LEAVES_PER_RANGE leaves.  A leaf's
+/// hash is the XOR of the entry hashes of every key that falls in it, so a
+/// write updates one leaf in O(1) by XOR-ing the old entry out and the new
+/// one in — no rebuild and no lock beyond the storage shard already held.
+/// Range and chunk hashes are XORs of their leaves, computed on demand.
+///
+/// Entry hashes cover the key, version and tombstone flag but not the value:
+/// LWW makes (key, version) identify the value, and skipping it keeps large
+/// values from costing anything extra on the write path.
+///
+/// The token list is fixed for the lifetime of an index; when the ring
+/// changes, build a new one and re-attach it to the engine.
+class MerkleIndex {
+public:
+    static constexpr uint32_t LEAVES_PER_RANGE = 16;
+
+    /// `tokens` must be sorted ascending and non-empty.
+    explicit MerkleIndex(std::vector<uint64_t> tokens);
+
+    /// Hash of one stored entry.  `key_hash` is the second 64-bit half of
+    /// the key's MurmurHash3 (the first half is its ring position).
+    static uint64_t entry_hash(uint64_t key_hash, const Version& version,
+                               bool tombstone);
+
+    /// Replace `old_hash` by `new_hash` in the leaf covering `position`.
+    /// Pass 0 as `old_hash` for a new key.  Thread-safe.
+    void update(uint64_t position, uint64_t old_hash, uint64_t new_hash);
+
+    size_t range_count() const { return tokens_.size(); }
+    size_t leaf_count() const { return tokens_.size() * LEAVES_PER_RANGE; }
+
+    /// Range owning `position`.
+    uint32_t range_of(uint64_t position) const;
+
+    /// Global leaf id (range * LEAVES_PER_RANGE + slot) for `position`.
+    uint32_t leaf_of(uint64_t position) const;
+
+    /// A position inside `range`, for replica lookups on the ring.
+    uint64_t range_position(uint32_t range) const { return tokens_[range] - 1; }
+
+    uint64_t leaf_hash(uint32_t leaf) const;
+    uint64_t range_hash(uint32_t range) const;
+
+    /// Identifies the token list; peers only compare trees when it matches.
+    uint64_t fingerprint() const { return fingerprint_; }
+
+    // Non-copyable
+    MerkleIndex(const MerkleIndex&) = delete;
+    MerkleIndex& operator=(const MerkleIndex&) = delete;
+
+private:
+    std::vector<uint64_t>                    tokens_;
+    std::unique_ptr<std::atomic<uint64_t>[]> leaves_;
+    uint64_t                                 fingerprint_ = 0;
+
+    /// First position of `range`: the previous token (the last for range 0).
+    uint64_t range_start(uint32_t range) const;
+};
+
+}  // namespace dkv
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "storage/merkle_index.h"
+#include "utils/murmurhash3.h"
+
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <shared_mutex>
@@ -38,18 +42,48 @@ struct GetResult {
     Version     version;
 };
 
+/// Key and version of one entry, without its value (anti-entropy listings).
+struct EntryVersion {
+    std::string key;
+    Version     version;
+    bool        is_tombstone = false;
+};
+
+/// Ring positions [start, end), wrapping past 2^64 when end <= start
+/// (start == end covers the whole ring).
+struct TokenRange {
+    uint64_t start = 0;
+    uint64_t end   = 0;
+
+    bool contains(uint64_t position) const {
+        if (start < end) return position >= start && position < end;
+        return position >= start || position < end;
+    }
+};
+
 /// Thread-safe, sharded in-memory key-value store with LWW versioning.
 class StorageEngine {
 public:
     /// Retrieve a key.  Returns found=false for missing keys and tombstones.
     GetResult get(const std::string& key) const;
 
+    /// Version of a live key, without copying its value.  Returns nullopt
+    /// for missing keys and tombstones (the same cases get() reports as
+    /// not found).
+    std::optional<Version> get_version(const std::string& key) const;
+
     /// Insert or update a key.  Applies LWW — only writes if `version` is
     /// newer than the existing entry (or if the key doesn't exist).
     /// Returns true if the write was applied.
     bool set(const std::string& key, const std::string& value,
              const Version& version);
 
+    /// Same as above, but moves `value` into the store instead of copying
+    /// it.  Lets the request path hand over a freshly parsed value without a
+    /// second full copy.  `value` is left unspecified if the write applies.
+    bool set(const std::string& key, std::string&& value,
+             const Version& version);
+
     /// Tombstone-delete a key.  Applies LWW — only tombstones if `version`
     /// is newer than the existing entry.
     /// Returns true if the tombstone was applied.
@@ -59,6 +93,40 @@ public:
     /// Used by the Snapshot module for serialization.
     std::vector<std::pair<std::string, ValueEntry>> all_entries() const;
 
+    /// Start maintaining `index` on every write (nullptr detaches).  The
+    /// index is first filled from the current contents, with all shards
+    /// locked so no write is missed or counted twice.
+    void attach_merkle(std::shared_ptr<MerkleIndex> index);
+
+    /// The attached index, or nullptr.
+    std::shared_ptr<MerkleIndex> merkle() const;
+
+    /// Every entry (including tombstones) hashing into one of `leaves` of
+    /// the attached index.  `leaves` must be sorted.  Locks one shard at a
+    /// time, so it may interleave with writes.
+    std::vector<EntryVersion> versions_in_leaves(
+        const std::vector<uint32_t>& leaves) const;
+
+    /// Start of a range transfer: every key (including tombstones) of shard
+    /// `shard` hashing into one of `ranges`, sorted.  One pass over the
+    /// shard under its shared lock; the sort runs after it is released.
+    /// Keys written afterwards are not listed, so transfers begin once
+    /// writes are already reaching the new owner.
+    std::vector<std::string> keys_in_ranges(const std::vector<TokenRange>& ranges,
+                                            size_t shard) const;
+
+    /// One chunk of a range transfer: the current entries of `keys` (from
+    /// keys_in_ranges()) starting at index `begin`, stopping once about
+    /// `max_bytes` of keys and values are collected.  `next` is set to the
+    /// index to resume from (keys.size() at the end).  Keys no longer
+    /// stored are skipped, so an empty result means the list is done.
+    /// Costs only the keys it visits.
+    std::vector<std::pair<std::string, ValueEntry>> entries_for_keys(
+        size_t shard, const std::vector<std::string>& keys, size_t begin,
+        size_t max_bytes, size_t& next) const;
+
+    static constexpr size_t shard_count() { return NUM_SHARDS; }
+
 private:
     static constexpr int NUM_SHARDS = 32;
 
@@ -69,8 +137,18 @@ private:
 
     std::array<Shard, NUM_SHARDS> shards_;
 
+    /// Read and written with a shard lock held; attach_merkle() holds all
+    /// of them exclusively to swap it.
+    std::shared_ptr<MerkleIndex> merkle_;
+
     /// Determine which shard a key belongs to.
     size_t shard_index(const std::string& key) const;
+
+    /// XOR the replaced entry out of the Merkle index and the new one in.
+    /// Caller holds the key's shard lock exclusively.
+    /// `h` is the key's MurmurHash3 (position and entry-hash halves).
+    void track_write(const MurmurHash3Result& h, const ValueEntry* old_entry,
+                     const Version& version, bool tombstone);
 };
 
 }  // namespace dkv
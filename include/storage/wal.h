@@ -93,6 +93,10 @@ private:
     /// Serialize a record into a byte buffer (including CRC32 header).
     static std::vector<uint8_t> serialize(const WalRecord& record);
 
+    /// Serialize `record` as if its sequence number were `seq_no`.
+    static std::vector<uint8_t> serialize(const WalRecord& record,
+                                          uint64_t seq_no);
+
     /// Deserialize a record from raw bytes.  Returns false if CRC32
     /// validation fails or the buffer is too short.
     static bool deserialize(const uint8_t* data, size_t len,
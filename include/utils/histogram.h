@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace dkv {
+
+/// Log-linear latency histogram in the style of HdrHistogram.
+///
+/// Values below 2^precision_bits get a bucket each; every power-of-two
+/// range above that is split into 2^precision_bits equal buckets, so a
+/// value is reported to within 1 / 2^precision_bits of itself (0.8% at the
+/// default 7 bits).  Values above `max_value` count in the top bucket, but
+/// max() stays exact.  Memory is fixed at construction: ~35 KiB for the
+/// defaults, however many values are recorded.
+///
+/// record() is a handful of relaxed atomic adds, so any number of threads
+/// may record into one histogram without a lock.  Benchmarks keep one per
+/// thread and merge() them at the end to avoid sharing the cache lines.
+/// Reads taken while others record see a recent, not an atomic, snapshot.
+///
+/// The histogram is unit-agnostic; the output helpers take a `scale` that
+/// recorded values are divided by (e.g. 1000 to print nanoseconds as µs).
+class Histogram {
+public:
+    static constexpr uint64_t DEFAULT_MAX_VALUE      = uint64_t{1} << 40;  // ~18 min in ns
+    static constexpr uint32_t DEFAULT_PRECISION_BITS = 7;
+
+    explicit Histogram(uint64_t max_value      = DEFAULT_MAX_VALUE,
+                       uint32_t precision_bits = DEFAULT_PRECISION_BITS);
+
+    /// Copies take a snapshot of the counts.
+    Histogram(const Histogram& other);
+    Histogram& operator=(const Histogram& other);
+
+    void record(uint64_t value) { record_n(value, 1); }
+    void record_n(uint64_t value, uint64_t n);
+
+    /// Add `other`'s counts to this one.  Histograms of a different shape
+    /// are folded in at each bucket's upper value.
+    void merge(const Histogram& other);
+    void reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t min() const;  // 0 when empty
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double   mean() const;
+
+    /// Value at or below which `p` percent (0-100) of recorded values fall,
+    /// reported as the highest value equivalent to its bucket (capped at
+    /// max()).  0 when empty.
+    uint64_t percentile(double p) const;
+
+    /// Calls fn(lowest, highest, count) for every non-empty bucket in
+    /// ascending order; [lowest, highest] are the values the bucket holds.
+    void for_each_bucket(
+        const std::function<void(uint64_t, uint64_t, uint64_t)>& fn) const;
+
+    /// Percentile distribution, one line per non-empty bucket:
+    /// `value,percentile,count,total` with a header row.
+    void write_csv(std::ostream& os, double scale = 1.0) const;
+
+    /// {"count":..,"min":..,"mean":..,"p50":..,"p90":..,"p99":..,
+    ///  "p99_9":..,"p99_99":..,"max":..}
+    std::string to_json(double scale = 1.0) const;
+
+    size_t   bucket_count() const { return buckets_; }
+    uint64_t max_value() const { return max_value_; }
+    uint32_t precision_bits() const { return bits_; }
+
+private:
+    size_t   index_of(uint64_t value) const;
+    uint64_t lowest_of(size_t index) const;
+    uint64_t highest_of(size_t index) const;
+    void     copy_from(const Histogram& other);
+
+    uint64_t max_value_;
+    uint32_t bits_;
+    size_t   buckets_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_{0};
+};
+
+}  // namespace dkv
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "utils/histogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dkv {
+
+/// Slots a Counter or LatencyMetric is split over.  Each thread records
+/// into one slot, picked once per thread, so concurrent recorders rarely
+/// share a cache line; reads add the slots up.
+constexpr size_t METRIC_SHARDS = 8;
+
+/// Index of the calling thread's slot.
+size_t metric_shard();
+
+/// Monotonic count (requests, bytes, failures).  add() is one relaxed
+/// atomic add on the calling thread's slot.
+class Counter {
+public:
+    void add(uint64_t n = 1) {
+        shards_[metric_shard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    Shard shards_[METRIC_SHARDS];
+};
+
+/// Latency distribution, one Histogram per slot (nanoseconds, up to ~68 s
+/// at 3% precision: ~8 KiB per slot).
+class LatencyMetric {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LatencyMetric();
+
+    void record(std::chrono::nanoseconds elapsed);
+    void record_since(Clock::time_point start) { record(Clock::now() - start); }
+
+    /// The slots merged into one histogram.
+    Histogram snapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        Shard();
+        Histogram hist;
+    };
+    std::unique_ptr<Shard[]> shards_;
+};
+
+/// Process-wide metrics registry, read by the STATS command and the
+/// optional Prometheus endpoint (see MetricsHttpServer).
+///
+/// Counters and latency metrics are created on first use and live as long
+/// as the process; call sites keep the returned reference, typically in a
+/// function-local static, so the registry lock is only taken once per
+/// metric and recording never locks.  Gauges are callbacks sampled at read
+/// time, for values a component already tracks (queue depths, hint
+/// counts); counter callbacks are the same for totals a component already
+/// keeps, exported with counter type so rate() handles restarts.  Whoever
+/// registers a callback must remove it before what it reads is destroyed.
+///
+/// `labels` is the inside of a Prometheus label set, e.g. `cmd="GET"`.
+class Metrics {
+public:
+    static Metrics& instance();
+
+    Counter& counter(std::string_view name, std::string_view help,
+                     std::string_view labels = {});
+
+    /// Exported as a Prometheus summary in seconds: quantiles 0.5, 0.9,
+    /// 0.99, 0.999 and 1 (the maximum), plus _sum and _count.
+    LatencyMetric& latency(std::string_view name, std::string_view help,
+                           std::string_view labels = {});
+
+    /// Register (or replace) a gauge.
+    void set_gauge(std::string_view name, std::string_view help,
+                   std::function<double()> sample, std::string_view labels = {});
+    void remove_gauge(std::string_view name, std::string_view labels = {});
+
+    /// Register (or replace) a counter read from a monotonic total the
+    /// caller keeps.  Name it `..._total`.
+    void set_counter_callback(std::string_view name, std::string_view help,
+                              std::function<uint64_t()> sample,
+                              std::string_view labels = {});
+    void remove_counter_callback(std::string_view name, std::string_view labels = {});
+
+    /// Every sample as `name{labels} value`, one per line, sorted by name.
+    /// With `help`, the Prometheus text exposition format (0.0.4): each
+    /// name is preceded by its # HELP and # TYPE lines.
+    std::string render(bool help = false) const;
+
+private:
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    enum class Kind : uint8_t { COUNTER, COUNTER_CALLBACK, GAUGE, LATENCY };
+
+    struct Entry {
+        Kind                           kind = Kind::COUNTER;
+        std::string                    help;
+        std::unique_ptr<Counter>       counter;
+        std::unique_ptr<LatencyMetric> latency;
+        std::function<double()>        gauge;
+        std::function<uint64_t()>      counter_callback;
+    };
+
+    /// Keyed by (name, labels) so every label set of a name is adjacent.
+    using Key = std::pair<std::string, std::string>;
+
+    Entry& entry_locked(std::string_view name, std::string_view help,
+                        std::string_view labels, Kind kind);
+
+    mutable std::mutex   mutex_;
+    std::map<Key, Entry> entries_;
+};
+
+}  // namespace dkv
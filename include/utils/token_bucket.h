@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace dkv {
+
+/// Byte-rate limiter shared by the background streams (anti-entropy,
+/// rebalancing, read repair).
+///
+/// The bucket holds up to one second of tokens and starts full.  consume()
+/// may drive the balance negative, so a large chunk is sent at once and
+/// the next caller waits it off.  Not thread-safe: the owner guards it with
+/// the mutex it already holds, which wait() also sleeps on.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// @param rate_per_sec  Tokens (bytes) per second; 0 = unlimited.
+    explicit TokenBucket(uint64_t rate_per_sec = 0);
+
+    /// Change the rate.  The balance is kept, capped at the new burst.
+    void set_rate(uint64_t rate_per_sec);
+    uint64_t rate() const { return rate_; }
+
+    /// Charge `n` tokens.  No-op when unlimited.
+    void consume(size_t n);
+
+    /// How long until the balance is back to zero; zero if it already is
+    /// (or the bucket is unlimited).
+    Clock::duration time_to_refill();
+
+    /// Sleep on `cv` until the balance is back to zero or `stopped()`
+    /// returns true.  `lock` must hold the mutex guarding this bucket.
+    template <typename Stopped>
+    void wait(std::unique_lock<std::mutex>& lock, std::condition_variable& cv,
+              Stopped&& stopped) {
+        while (!stopped()) {
+            const Clock::duration wait = time_to_refill();
+            if (wait == Clock::duration::zero()) return;
+            cv.wait_for(lock, wait);
+        }
+    }
+
+private:
+    void refill();
+
+    uint64_t          rate_;
+    double            tokens_;
+    Clock::time_point refilled_;
+};
+
+}  // namespace dkv
@@ -0,0 +1,440 @@
+#include "cluster/anti_entropy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+
+namespace dkv {
+
+namespace {
+
+/// Listing and repair requests are issued this many at a time.
+constexpr size_t REPAIR_WINDOW = 64;
+
+// AEHASH payload:  [u64 fingerprint][u8 level][u32 id]...
+// AEKEYS payload:  [u64 fingerprint][u32 leaf]...   (leaves sorted)
+// AEHASH response: [u64 hash]...
+// AEKEYS response: ([u32 key_len][key][u64 ts][u32 node_id][u8 tombstone])...
+constexpr size_t FINGERPRINT_SIZE = 8;
+
+void put_u32(std::string& out, uint32_t v) {
+    out.append(reinterpret_cast<const char*>(&v), 4);
+}
+
+void put_u64(std::string& out, uint64_t v) {
+    out.append(reinterpret_cast<const char*>(&v), 8);
+}
+
+uint32_t read_u32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+uint64_t read_u64(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+bool read_ids(std::string_view bytes, std::vector<uint32_t>& ids) {
+    if (bytes.size() % 4 != 0) return false;
+    ids.resize(bytes.size() / 4);
+    for (size_t i = 0; i < ids.size(); i++) ids[i] = read_u32(bytes.data() + i * 4);
+    return true;
+}
+
+/// Hashes of `ids` at `level`: 0 = per chunk of ranges, 1 = per range,
+/// 2 = per leaf.
+std::vector<uint64_t> hashes_at(const MerkleIndex& index, uint8_t level,
+                                const std::vector<uint32_t>& ids) {
+    std::vector<uint64_t> out;
+    if (level == 0) {
+        out.resize((ids.size() + AntiEntropy::RANGES_PER_CHUNK - 1) /
+                   AntiEntropy::RANGES_PER_CHUNK);
+        for (size_t i = 0; i < ids.size(); i++) {
+            out[i / AntiEntropy::RANGES_PER_CHUNK] ^= index.range_hash(ids[i]);
+        }
+    } else {
+        out.reserve(ids.size());
+        for (uint32_t id : ids) {
+            out.push_back(level == 1 ? index.range_hash(id) : index.leaf_hash(id));
+        }
+    }
+    return out;
+}
+
+/// Issue every frame to `address` at once and wait for all replies.
+std::vector<RpcResult> call_all(RpcClient& rpc, const std::string& address,
+                                std::vector<std::shared_ptr<const std::string>> frames,
+                                bool batched) {
+    struct Pending {
+        std::mutex              mutex;
+        std::condition_variable cv;
+        size_t                  remaining = 0;
+        std::vector<RpcResult>  results;
+    };
+    auto pending = std::make_shared<Pending>();
+    pending->remaining = frames.size();
+    pending->results.resize(frames.size());
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        auto cb = [pending, i](RpcResult r) {
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            pending->results[i] = std::move(r);
+            if (--pending->remaining == 0) pending->cv.notify_one();
+        };
+        if (batched) {
+            rpc.call_batched(address, std::move(frames[i]), std::move(cb));
+        } else {
+            rpc.call(address, std::move(frames[i]), std::move(cb));
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(pending->mutex);
+    pending->cv.wait(lock, [&]() { return pending->remaining == 0; });
+    return std::move(pending->results);
+}
+
+}  // namespace
+
+AntiEntropy::AntiEntropy(StorageEngine& engine, const HashRing& ring,
+                         RpcClient& rpc, uint32_t node_id,
+                         uint32_t replication_factor, Writer writer,
+                         Availability available, Options options)
+    : engine_(engine), ring_(ring), rpc_(rpc), node_id_(node_id),
+      replication_factor_(replication_factor), writer_(std::move(writer)),
+      available_(std::move(available)), options_(options),
+      bucket_(options.rate_bytes_per_sec) {}
+
+AntiEntropy::~AntiEntropy() {
+    stop();
+}
+
+void AntiEntropy::start() {
+    if (options_.interval_ms == 0 || worker_.joinable()) return;
+    worker_ = std::thread(&AntiEntropy::run, this);
+}
+
+void AntiEntropy::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+AntiEntropy::Stats AntiEntropy::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void AntiEntropy::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        cv_.wait_for(lock, std::chrono::milliseconds(options_.interval_ms),
+                     [this]() { return stopping_; });
+        if (stopping_) break;
+
+        // Next peer after the one synced last, skipping ourselves and
+        // nodes that are down.
+        auto nodes = ring_.nodes();
+        std::optional<NodeInfo> peer;
+        for (size_t i = 0; i < nodes.size() && !peer; i++) {
+            auto it = std::upper_bound(
+                nodes.begin(), nodes.end(), last_peer_,
+                [](uint32_t id, const NodeInfo& n) { return id < n.node_id; });
+            const NodeInfo& candidate = it == nodes.end() ? nodes.front() : *it;
+            last_peer_ = candidate.node_id;
+            if (candidate.node_id == node_id_) continue;
+            if (available_ && !available_(candidate.node_id)) continue;
+            peer = candidate;
+        }
+        if (!peer) continue;
+
+        lock.unlock();
+        sync_with(*peer);
+        lock.lock();
+    }
+}
+
+void AntiEntropy::throttle(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stats_.bytes_streamed += bytes;
+    bucket_.consume(bytes);
+    bucket_.wait(lock, cv_, [this] { return stopping_; });
+}
+
+bool AntiEntropy::fetch_hashes(const NodeInfo& peer, uint64_t fingerprint,
+                               uint8_t level, const std::vector<uint32_t>& ids,
+                               std::vector<uint64_t>& out) {
+    std::string payload;
+    payload.reserve(FINGERPRINT_SIZE + 1 + ids.size() * 4);
+    put_u64(payload, fingerprint);
+    payload.push_back(static_cast<char>(level));
+    for (uint32_t id : ids) put_u32(payload, id);
+
+    RpcResult r = rpc_.call_sync(peer.address, BinaryOpcode::AEHASH, {}, {},
+                                 payload);
+    if (r.status != RpcStatus::OK || r.opcode != BinaryOpcode::VALUE ||
+        r.value.size() % 8 != 0) {
+        return false;
+    }
+    out.resize(r.value.size() / 8);
+    for (size_t i = 0; i < out.size(); i++) out[i] = read_u64(r.value.data() + i * 8);
+    return true;
+}
+
+bool AntiEntropy::sync_with(const NodeInfo& peer) {
+    auto fail = [this]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.rounds;
+        ++stats_.failed_rounds;
+        return false;
+    };
+
+    auto index = engine_.merkle();
+    if (!index) return fail();
+    const uint64_t fp = index->fingerprint();
+
+    // Only ranges both nodes replicate can be compared.
+    std::vector<uint32_t> shared;
+    for (uint32_t r = 0; r < index->range_count(); r++) {
+        auto replicas = ring_.replicas_at(index->range_position(r),
+                                          replication_factor_);
+        bool self = false, other = false;
+        for (const auto& n : replicas) {
+            self  |= n.node_id == node_id_;
+            other |= n.node_id == peer.node_id;
+        }
+        if (self && other) shared.push_back(r);
+    }
+
+    // Level 0: chunks of ranges.
+    std::vector<uint64_t> remote;
+    if (!shared.empty() && !fetch_hashes(peer, fp, 0, shared, remote)) return fail();
+    auto local = hashes_at(*index, 0, shared);
+    if (remote.size() != local.size()) return fail();
+
+    std::vector<uint32_t> ranges;
+    for (size_t c = 0; c < local.size(); c++) {
+        if (local[c] == remote[c]) continue;
+        size_t end = std::min<size_t>(shared.size(), (c + 1) * RANGES_PER_CHUNK);
+        for (size_t i = c * RANGES_PER_CHUNK; i < end; i++) ranges.push_back(shared[i]);
+    }
+
+    // Level 1: ranges of the differing chunks.
+    std::vector<uint32_t> differing;
+    if (!ranges.empty()) {
+        if (!fetch_hashes(peer, fp, 1, ranges, remote)) return fail();
+        local = hashes_at(*index, 1, ranges);
+        if (remote.size() != local.size()) return fail();
+        for (size_t i = 0; i < ranges.size(); i++) {
+            if (local[i] != remote[i]) differing.push_back(ranges[i]);
+        }
+    }
+
+    // Level 2: leaves of the differing ranges.
+    std::vector<uint32_t> leaves;
+    for (uint32_t r : differing) {
+        for (uint32_t l = 0; l < MerkleIndex::LEAVES_PER_RANGE; l++) {
+            leaves.push_back(r * MerkleIndex::LEAVES_PER_RANGE + l);
+        }
+    }
+    std::vector<uint32_t> bad_leaves;
+    if (!leaves.empty()) {
+        if (!fetch_hashes(peer, fp, 2, leaves, remote)) return fail();
+        local = hashes_at(*index, 2, leaves);
+        if (remote.size() != local.size()) return fail();
+        for (size_t i = 0; i < leaves.size(); i++) {
+            if (local[i] != remote[i]) bad_leaves.push_back(leaves[i]);
+        }
+    }
+    // Leaves past the cap wait for a later round.
+    if (bad_leaves.size() > options_.max_leaves_per_round) {
+        bad_leaves.resize(options_.max_leaves_per_round);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.ranges_differing += differing.size();
+        stats_.leaves_differing += bad_leaves.size();
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < bad_leaves.size() && ok; i += REPAIR_WINDOW) {
+        std::vector<uint32_t> part(
+            bad_leaves.begin() + static_cast<std::ptrdiff_t>(i),
+            bad_leaves.begin() + static_cast<std::ptrdiff_t>(
+                std::min(bad_leaves.size(), i + REPAIR_WINDOW)));
+        ok = repair_leaves(peer, fp, part);
+    }
+    if (!ok) return fail();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.rounds;
+    return true;
+}
+
+bool AntiEntropy::repair_leaves(const NodeInfo& peer, uint64_t fingerprint,
+                                const std::vector<uint32_t>& leaves) {
+    std::string payload;
+    put_u64(payload, fingerprint);
+    for (uint32_t leaf : leaves) put_u32(payload, leaf);
+
+    RpcResult r = rpc_.call_sync(peer.address, BinaryOpcode::AEKEYS, {}, {},
+                                 payload);
+    if (r.status != RpcStatus::OK || r.opcode != BinaryOpcode::VALUE) return false;
+    throttle(r.value.size());
+
+    // Peer's listing.
+    std::unordered_map<std::string, EntryVersion> theirs;
+    const char* p   = r.value.data();
+    const char* end = p + r.value.size();
+    while (p < end) {
+        if (end - p < 4) return false;
+        uint32_t klen = read_u32(p);
+        if (static_cast<size_t>(end - p) < 4ull + klen + 13) return false;
+        EntryVersion e;
+        e.key.assign(p + 4, klen);
+        p += 4 + klen;
+        e.version      = Version{read_u64(p), read_u32(p + 8)};
+        e.is_tombstone = p[12] != 0;
+        p += 13;
+        std::string key = e.key;
+        theirs.emplace(std::move(key), std::move(e));
+    }
+
+    // Decide the direction for every key that differs.
+    std::vector<EntryVersion> pulls;
+    std::vector<EntryVersion> pushes;
+    for (auto& mine : engine_.versions_in_leaves(leaves)) {
+        auto it = theirs.find(mine.key);
+        if (it == theirs.end() || is_newer(mine.version, it->second.version)) {
+            pushes.push_back(std::move(mine));
+        } else if (is_newer(it->second.version, mine.version)) {
+            pulls.push_back(std::move(it->second));
+        }
+        if (it != theirs.end()) theirs.erase(it);
+    }
+    for (auto& [key, e] : theirs) pulls.push_back(std::move(e));
+
+    // Pull: tombstones need no transfer; live keys are fetched in windows.
+    uint64_t pulled = 0;
+    std::vector<const EntryVersion*> fetch;
+    for (const auto& e : pulls) {
+        if (e.is_tombstone) {
+            writer_(e.key, {}, true, e.version);
+            ++pulled;
+        } else {
+            fetch.push_back(&e);
+        }
+    }
+    for (size_t i = 0; i < fetch.size(); i += REPAIR_WINDOW) {
+        size_t n = std::min(REPAIR_WINDOW, fetch.size() - i);
+        std::vector<std::shared_ptr<const std::string>> frames;
+        for (size_t j = 0; j < n; j++) {
+            frames.push_back(RpcClient::encode(BinaryOpcode::RGET, {},
+                                               fetch[i + j]->key, {}));
+        }
+        auto results = call_all(rpc_, peer.address, std::move(frames), false);
+        size_t bytes = 0;
+        for (size_t j = 0; j < n; j++) {
+            const auto& res = results[j];
+            if (res.status != RpcStatus::OK) return false;
+            // NOT_FOUND: deleted since the listing; the next round sees the
+            // tombstone.
+            if (res.opcode != BinaryOpcode::VALUE || !res.has_version) continue;
+            writer_(fetch[i + j]->key, res.value, false,
+                    Version{res.timestamp_ms, res.node_id});
+            bytes += fetch[i + j]->key.size() + res.value.size();
+            ++pulled;
+        }
+        throttle(bytes);
+    }
+
+    // Push: the peer is missing these or holds an older version.
+    uint64_t pushed = 0;
+    for (size_t i = 0; i < pushes.size(); i += REPAIR_WINDOW) {
+        size_t n = std::min(REPAIR_WINDOW, pushes.size() - i);
+        std::vector<std::shared_ptr<const std::string>> frames;
+        size_t bytes = 0;
+        for (size_t j = 0; j < n; j++) {
+            const auto& e = pushes[i + j];
+            if (e.is_tombstone) {
+                frames.push_back(RpcClient::encode(
+                    BinaryOpcode::RDEL,
+                    encode_version_extras(e.version.timestamp_ms, e.version.node_id),
+                    e.key, {}));
+            } else {
+                // Re-read: the value may have moved on since the listing.
+                auto current = engine_.get(e.key);
+                if (!current.found) continue;
+                bytes += e.key.size() + current.value.size();
+                frames.push_back(RpcClient::encode(
+                    BinaryOpcode::RSET,
+                    encode_version_extras(current.version.timestamp_ms,
+                                          current.version.node_id),
+                    e.key, current.value));
+            }
+        }
+        throttle(bytes);
+        for (const auto& res : call_all(rpc_, peer.address, std::move(frames), true)) {
+            if (res.status != RpcStatus::OK) return false;
+            if (res.opcode == BinaryOpcode::OK) ++pushed;
+        }
+    }
+
+    if (pulled + pushed > 0) {
+        std::cerr << "[AE] node " << peer.node_id << ": " << leaves.size()
+                  << " leaves differ, pulled " << pulled << " pushed "
+                  << pushed << " keys\n";
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.keys_pulled += pulled;
+    stats_.keys_pushed += pushed;
+    return true;
+}
+
+std::string AntiEntropy::serve(const StorageEngine& engine, const Command& cmd) {
+    auto index = engine.merkle();
+    if (!index) return format_error("ANTI_ENTROPY_DISABLED");
+
+    std::string_view payload = cmd.value;
+    const size_t header = FINGERPRINT_SIZE + (cmd.type == CommandType::AEHASH ? 1 : 0);
+    if (payload.size() < header) return format_error("MALFORMED_AE");
+    if (read_u64(payload.data()) != index->fingerprint()) {
+        return format_error("RING_MISMATCH");
+    }
+
+    std::vector<uint32_t> ids;
+    if (!read_ids(payload.substr(header), ids)) return format_error("MALFORMED_AE");
+
+    if (cmd.type == CommandType::AEHASH) {
+        const uint8_t level = static_cast<uint8_t>(payload[FINGERPRINT_SIZE]);
+        const size_t limit = level == 2 ? index->leaf_count() : index->range_count();
+        if (level > 2) return format_error("MALFORMED_AE");
+        for (uint32_t id : ids) {
+            if (id >= limit) return format_error("MALFORMED_AE");
+        }
+        std::string out;
+        for (uint64_t h : hashes_at(*index, level, ids)) put_u64(out, h);
+        return format_value(out);
+    }
+
+    std::sort(ids.begin(), ids.end());
+    std::string out;
+    for (const auto& e : engine.versions_in_leaves(ids)) {
+        put_u32(out, static_cast<uint32_t>(e.key.size()));
+        out += e.key;
+        put_u64(out, e.version.timestamp_ms);
+        put_u32(out, e.version.node_id);
+        out.push_back(e.is_tombstone ? 1 : 0);
+    }
+    return format_value(out);
+}
+
+}  // namespace dkv
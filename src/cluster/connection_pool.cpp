@@ -1,4 +1,5 @@
 #include "cluster/connection_pool.h"
+#include "utils/metrics.h"
 
 #include <arpa/inet.h>
 #include <fcntl.h>
@@ -12,6 +13,15 @@
 
 namespace dkv {
 
+namespace {
+/// acquire() outcomes: an idle connection reused, a new one opened, or none.
+Counter& acquires(const char* result) {
+    return Metrics::instance().counter("dkv_pool_acquires_total",
+                                       "Connection pool acquires by outcome",
+                                       std::string("result=\"") + result + '"');
+}
+}  // namespace
+
 ConnectionPool::ConnectionPool(size_t max_per_peer, int timeout_ms)
     : max_per_peer_(max_per_peer), timeout_ms_(timeout_ms) {}
 
@@ -20,20 +30,29 @@ ConnectionPool::~ConnectionPool() {
 }
 
 std::optional<PooledConnection> ConnectionPool::acquire(const std::string& address) {
+    static Counter& reused    = acquires("reused");
+    static Counter& connected = acquires("connected");
+    static Counter& failed    = acquires("failed");
     {
         std::lock_guard lock(mutex_);
         auto it = pools_.find(address);
         if (it != pools_.end() && !it->second.empty()) {
             int fd = it->second.back();
             it->second.pop_back();
+            idle_.fetch_sub(1, std::memory_order_relaxed);
+            reused.add();
             return PooledConnection{fd, address};
         }
     }
 
     // No idle connection — create a new one
     int fd = connect_to(address);
-    if (fd < 0) return std::nullopt;
+    if (fd < 0) {
+        failed.add();
+        return std::nullopt;
+    }
 
+    connected.add();
     return PooledConnection{fd, address};
 }
 
@@ -43,6 +62,7 @@ void ConnectionPool::release(PooledConnection conn) {
 
     if (pool.size() < max_per_peer_) {
         pool.push_back(conn.fd);
+        idle_.fetch_add(1, std::memory_order_relaxed);
     } else {
         // Pool is full — close the extra connection
         ::close(conn.fd);
@@ -57,6 +77,7 @@ void ConnectionPool::close_all() {
         }
     }
     pools_.clear();
+    idle_.store(0, std::memory_order_relaxed);
 }
 
 int ConnectionPool::connect_to(const std::string& address) {
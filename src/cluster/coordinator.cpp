@@ -1,17 +1,24 @@
 #include "cluster/coordinator.h"
+#include "utils/metrics.h"
+#include "utils/murmurhash3.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <cstring>
+#include <condition_variable>
+#include <future>
 #include <iostream>
+#include <mutex>
 #include <thread>
 #include <vector>
-#include <sys/socket.h>
-#include <unistd.h>
 
 namespace dkv {
 
 namespace {
+/// The error for an RBATCH or MGET reply that would not fit in one binary
+/// frame.
+constexpr std::string_view REPLY_TOO_LARGE = "REPLY_TOO_LARGE";
+
 /// Current time in milliseconds since epoch.
 inline uint64_t now_ms() {
     return static_cast<uint64_t>(
@@ -19,6 +26,41 @@ inline uint64_t now_ms() {
             std::chrono::system_clock::now().time_since_epoch()
         ).count());
 }
+
+/// Latency and failures of one kind of quorum operation.
+struct QuorumMetrics {
+    LatencyMetric& latency;
+    Counter&       failures;
+};
+
+QuorumMetrics& write_metrics() {
+    static QuorumMetrics m{
+        Metrics::instance().latency("dkv_quorum_write_seconds",
+                                    "Quorum SET/DEL latency, until W acks or failure"),
+        Metrics::instance().counter("dkv_quorum_failures_total",
+                                    "Quorum operations answered with an error", "op=\"write\"")};
+    return m;
+}
+
+QuorumMetrics& read_metrics() {
+    static QuorumMetrics m{
+        Metrics::instance().latency("dkv_quorum_read_seconds",
+                                    "Quorum GET latency, until R replies or failure"),
+        Metrics::instance().counter("dkv_quorum_failures_total",
+                                    "Quorum operations answered with an error", "op=\"read\"")};
+    return m;
+}
+
+/// Wrap `done` to record the time until it is called, and whether the
+/// reply was an error, in `m`.
+Coordinator::Reply timed(QuorumMetrics& m, Coordinator::Reply done) {
+    return [&m, start = std::chrono::steady_clock::now(),
+            done = std::move(done)](std::string response) {
+        m.latency.record_since(start);
+        if (response.compare(0, 4, "-ERR") == 0) m.failures.add();
+        done(std::move(response));
+    };
+}
 }  // namespace
 
 uint64_t Coordinator::next_ts() {
@@ -50,86 +92,184 @@ Coordinator::Coordinator(StorageEngine& engine, HashRing& ring,
       hints_(hints_dir) {
     // Recover any hints persisted before a previous coordinator crash.
     hints_.load();
-    // Thread pool for scatter-gather quorum operations.
-    quorum_pool_ = std::make_unique<ThreadPool>(
-        std::max<size_t>(4, static_cast<size_t>(replication_factor_) * 2));
-    // Start the background repair worker.
-    repair_running_ = true;
-    repair_thread_ = std::thread(&Coordinator::repair_worker, this);
+    // Multiplexed inter-node client; shares the pool's per-request timeout.
+    rpc_ = std::make_unique<RpcClient>(pool_.timeout_ms());
+    // Background read repair.
+    repairs_ = std::make_unique<RepairQueue>(
+        [this](const NodeInfo& target, const std::vector<RepairItem>& batch) {
+            return send_repair_batch(target, batch);
+        });
 }
 
 Coordinator::~Coordinator() {
-    // Shut down quorum pool first (no new tasks after this point).
-    quorum_pool_.reset();
-    // Then drain and join the repair worker.
+    // Stop the RPC client first: outstanding quorum operations complete
+    // (as failed replicas) and later repair calls fail fast.  A join or
+    // decommission in progress fails at its next request.
+    if (rebalancer_) rebalancer_->stop();
+    if (gossip_) {
+        gossip_->stop();
+        gossip_rpc_->stop();
+    }
+    rpc_->stop();
+    if (change_thread_.joinable()) change_thread_.join();
     {
-        std::lock_guard<std::mutex> lock(repair_mutex_);
-        repair_running_ = false;
+        std::lock_guard<std::mutex> lock(replay_mutex_);
+        replay_stop_ = true;
     }
-    repair_cv_.notify_one();
-    if (repair_thread_.joinable()) repair_thread_.join();
-}
-
-void Coordinator::repair_worker() {
-    while (true) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lock(repair_mutex_);
-            repair_cv_.wait(lock, [this]() {
-                return !repair_queue_.empty() || !repair_running_;
-            });
-            if (!repair_running_ && repair_queue_.empty()) return;
-            task = std::move(repair_queue_.front());
-            repair_queue_.pop();
-        }
-        task();
+    replay_cv_.notify_all();
+    if (replay_thread_.joinable()) replay_thread_.join();
+    // Then drain and join the repair worker and stop anti-entropy.
+    repairs_->stop();
+    if (anti_entropy_) {
+        anti_entropy_->stop();
+        engine_.attach_merkle(nullptr);
     }
 }
 
 std::string Coordinator::handle_command(const Command& cmd) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    auto future  = promise->get_future();
+    handle_command_async(cmd, [promise](std::string response) {
+        promise->set_value(std::move(response));
+    });
+    return future.get();
+}
+
+void Coordinator::handle_command_async(Command cmd, Reply done) {
     // PING is always handled locally
     if (cmd.type == CommandType::PING) {
-        return format_pong();
+        done(format_pong());
+        return;
+    }
+
+    // TOPOLOGY: our view of the ring, for clients that route by token.
+    if (cmd.type == CommandType::TOPOLOGY) {
+        done(format_value(ring_.encode_topology(replication_factor_)));
+        return;
+    }
+
+    // HOTKEYS: this coordinator's hot-key detector and read cache.
+    if (cmd.type == CommandType::HOTKEYS) {
+        done(format_value(hot_keys_.encode_report(HOT_KEYS_REPORTED)));
+        return;
+    }
+
+    // STATS: the process-wide metrics registry.
+    if (cmd.type == CommandType::STATS) {
+        done(format_value(Metrics::instance().render()));
+        return;
     }
 
     // FWD: decrement hop counter, then re-parse and execute the inner command
     // locally (we are the target node for this forwarded request).
     if (cmd.type == CommandType::FWD) {
         if (cmd.hops_remaining == 0) {
-            return format_error("ROUTING_LOOP");
+            done(format_error("ROUTING_LOOP"));
+            return;
         }
 
         std::string inner_with_nl = cmd.inner_line + "\n";
         ParseResult inner_result = try_parse(inner_with_nl.data(),
                                               inner_with_nl.size());
         if (inner_result.status != ParseStatus::OK) {
-            return format_error("MALFORMED_FWD");
+            done(format_error("MALFORMED_FWD"));
+            return;
         }
 
-        return execute_local(inner_result.command);
+        done(execute_local(inner_result.command));
+        return;
     }
 
-    // RSET/RDEL/RGET are internal replication commands sent by the quorum
-    // coordinator directly to this node.  Always execute locally — no further
-    // routing needed; the coordinator already selected us as a replica.
+    // RSET/RDEL/RGET/RDIGEST are internal replication commands sent by the
+    // quorum coordinator directly to this node.  Always execute locally — no
+    // further routing needed; the coordinator already selected us as a replica.
     if (cmd.type == CommandType::RSET ||
         cmd.type == CommandType::RDEL ||
-        cmd.type == CommandType::RGET) {
-        return execute_local(cmd);
+        cmd.type == CommandType::RGET ||
+        cmd.type == CommandType::RDIGEST) {
+        done(execute_local(cmd));
+        return;
+    }
+
+    // RBATCH: many RSET/RDEL (or an MGET's RGETs) from one coordinator,
+    // answered together.  Peers send it in binary (execute_binary()); this
+    // is the text form of the same reply.
+    if (cmd.type == CommandType::RBATCH) {
+        std::string frame;
+        execute_batch(cmd.value, 0, 0, frame);
+        done(format_value(std::string_view(frame).substr(BINARY_HEADER_SIZE)));
+        return;
+    }
+
+    // AEHASH/AEKEYS: a peer's anti-entropy service comparing trees with us.
+    if (cmd.type == CommandType::AEHASH || cmd.type == CommandType::AEKEYS) {
+        done(AntiEntropy::serve(engine_, cmd));
+        return;
+    }
+
+    // RSCAN/RLOAD/RING: a peer moving data or changing the ring.
+    if (cmd.type == CommandType::RSCAN || cmd.type == CommandType::RLOAD ||
+        cmd.type == CommandType::RING) {
+        done(rebalancer_ ? rebalancer_->serve(cmd)
+                         : format_error("REBALANCE_DISABLED"));
+        return;
+    }
+
+    // GOSSIP: a peer's SWIM probe (PINGREQ replies once our own probe is
+    // done).
+    if (cmd.type == CommandType::GOSSIP) {
+        if (!gossip_) {
+            done(format_error("GOSSIP_DISABLED"));
+            return;
+        }
+        gossip_->serve(cmd.value, [done](std::string reply) {
+            done(reply.empty() ? format_error("BAD_GOSSIP") : format_value(reply));
+        });
+        return;
+    }
+
+    // DECOMMISSION: hand our ranges over and leave the ring; replies when
+    // the node is out.
+    if (cmd.type == CommandType::DECOMMISSION) {
+        if (!rebalancer_) {
+            done(format_error("REBALANCE_DISABLED"));
+            return;
+        }
+        // LAGGING still means we are out of the ring: the nodes that missed
+        // COMMIT get it again in the background.
+        bool started = run_change_async([this, done]() {
+            done(rebalancer_->leave() != Rebalancer::Outcome::FAILED
+                     ? format_ok()
+                     : format_error("DECOMMISSION_FAILED"));
+        });
+        if (!started) done(format_error("CHANGE_IN_PROGRESS"));
+        return;
     }
 
-    // Client SET/DEL: scatter to N replicas, wait for W acks (§9.B).
+    // Client SET/DEL: scatter to N replicas, count acks against W (§9.B).
     if (cmd.type == CommandType::SET || cmd.type == CommandType::DEL) {
-        return quorum_write(cmd.key, cmd.value,
-                            cmd.type == CommandType::DEL);
+        quorum_write(std::move(cmd.key), std::move(cmd.value),
+                     cmd.type == CommandType::DEL, std::move(done));
+        return;
     }
 
     // Client GET: query R replicas, return highest-version value (§9.C).
     if (cmd.type == CommandType::GET) {
-        return quorum_read(cmd.key);
+        quorum_read(std::move(cmd.key), std::move(done));
+        return;
+    }
+
+    // Client MGET/MSET: one RBATCH per replica node for all of its keys.
+    if (cmd.type == CommandType::MGET) {
+        multi_get(std::move(cmd.value), std::move(done));
+        return;
+    }
+    if (cmd.type == CommandType::MSET) {
+        multi_set(std::move(cmd.value), std::move(done));
+        return;
     }
 
-    return format_error("INTERNAL");
+    done(format_error("INTERNAL"));
 }
 
 std::string Coordinator::execute_local(const Command& cmd) {
@@ -149,67 +289,27 @@ std::string Coordinator::execute_local(const Command& cmd) {
         // ── Client SET/DEL (used via FWD inner command) ──────────────────────
         // Note: when a client SET/DEL arrives directly (not via FWD), it goes
         // through handle_command → quorum_write/quorum_read instead.
-        case CommandType::SET: {
-            if (wal_) {
-                WalRecord rec;
-                rec.timestamp_ms = ts;
-                rec.op_type      = OpType::SET;
-                rec.key           = cmd.key;
-                rec.value         = cmd.value;
-                wal_->append(rec);
-            }
-            Version v{ts, node_id_};
-            engine_.set(cmd.key, cmd.value, v);
-            maybe_snapshot();
+        case CommandType::SET:
+            apply_local_write(cmd.key, cmd.value, false, Version{ts, node_id_});
             return format_ok();
-        }
 
-        case CommandType::DEL: {
-            if (wal_) {
-                WalRecord rec;
-                rec.timestamp_ms = ts;
-                rec.op_type      = OpType::DEL;
-                rec.key           = cmd.key;
-                wal_->append(rec);
-            }
-            Version v{ts, node_id_};
-            engine_.del(cmd.key, v);
-            maybe_snapshot();
+        case CommandType::DEL:
+            apply_local_write(cmd.key, {}, true, Version{ts, node_id_});
             return format_ok();
-        }
 
         // ── Phase 5: Replication commands ───────────────────────────────────
         // RSET/RDEL carry an explicit version (timestamp_ms + node_id) chosen
         // by the quorum coordinator so all replicas store identical metadata.
 
-        case CommandType::RSET: {
-            Version v{cmd.timestamp_ms, cmd.node_id};
-            if (wal_) {
-                WalRecord rec;
-                rec.timestamp_ms = cmd.timestamp_ms;
-                rec.op_type      = OpType::SET;
-                rec.key           = cmd.key;
-                rec.value         = cmd.value;
-                wal_->append(rec);
-            }
-            engine_.set(cmd.key, cmd.value, v);
-            maybe_snapshot();
+        case CommandType::RSET:
+            apply_local_write(cmd.key, cmd.value, false,
+                              Version{cmd.timestamp_ms, cmd.node_id});
             return format_ok();
-        }
 
-        case CommandType::RDEL: {
-            Version v{cmd.timestamp_ms, cmd.node_id};
-            if (wal_) {
-                WalRecord rec;
-                rec.timestamp_ms = cmd.timestamp_ms;
-                rec.op_type      = OpType::DEL;
-                rec.key           = cmd.key;
-                wal_->append(rec);
-            }
-            engine_.del(cmd.key, v);
-            maybe_snapshot();
+        case CommandType::RDEL:
+            apply_local_write(cmd.key, {}, true,
+                              Version{cmd.timestamp_ms, cmd.node_id});
             return format_ok();
-        }
 
         case CommandType::RGET: {
             // Return value + version so the quorum coordinator can compare
@@ -221,354 +321,1231 @@ std::string Coordinator::execute_local(const Command& cmd) {
                                           result.version.node_id);
         }
 
+        case CommandType::RDIGEST: {
+            // Version only: a digest read compares it against the one
+            // replica that sent the full value.
+            auto version = engine_.get_version(cmd.key);
+            if (!version) return format_not_found();
+            return format_versioned_value({}, version->timestamp_ms,
+                                          version->node_id);
+        }
+
         default:
             return format_error("INTERNAL");
     }
 }
 
+bool Coordinator::execute_binary(const Command& cmd, uint32_t request_id,
+                                 uint8_t flags, std::string& out) {
+    switch (cmd.type) {
+        case CommandType::RSET:
+        case CommandType::RDEL:
+        case CommandType::RGET:
+        case CommandType::RDIGEST:
+            append_local_response(cmd, request_id, flags, out);
+            return true;
+        case CommandType::RBATCH:
+            execute_batch(cmd.value, request_id, flags, out);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Coordinator::append_local_response(const Command& cmd, uint32_t request_id,
+                                        uint8_t flags, std::string& out) {
+    switch (cmd.type) {
+        case CommandType::RSET:
+        case CommandType::RDEL:
+            apply_local_write(cmd.key, cmd.value, cmd.type == CommandType::RDEL,
+                              Version{cmd.timestamp_ms, cmd.node_id});
+            append_binary_frame(out, BinaryOpcode::OK, request_id, {}, {}, {}, flags);
+            return;
+
+        case CommandType::RGET: {
+            auto result = engine_.get(cmd.key);
+            if (!result.found) break;
+            append_binary_frame(out, BinaryOpcode::VALUE, request_id,
+                                encode_version_extras(result.version.timestamp_ms,
+                                                      result.version.node_id),
+                                {}, result.value, flags);
+            return;
+        }
+
+        case CommandType::RDIGEST: {
+            auto version = engine_.get_version(cmd.key);
+            if (!version) break;
+            append_binary_frame(out, BinaryOpcode::VALUE, request_id,
+                                encode_version_extras(version->timestamp_ms,
+                                                      version->node_id),
+                                {}, {}, flags);
+            return;
+        }
+
+        default:
+            out += text_to_binary_response(request_id, execute_local(cmd), flags);
+            return;
+    }
+    append_binary_frame(out, BinaryOpcode::NOT_FOUND, request_id, {}, {}, {}, flags);
+}
+
+void Coordinator::execute_batch(std::string_view payload, uint32_t request_id,
+                                uint8_t flags, std::string& out) {
+    // The outer VALUE header goes first; its length is known at the end.
+    const size_t header = out.size();
+    append_binary_header(out, BinaryOpcode::VALUE, request_id, 0, 0, 0, flags);
+    const size_t body = out.size();
+
+    // The reply must fit in one frame.  Every inner request still to come
+    // (at least a header each) is owed room for an ERROR; a response that
+    // would eat into that room is replaced by one, and the caller asks for
+    // those keys again in a smaller batch.
+    constexpr size_t error_frame = BINARY_HEADER_SIZE + REPLY_TOO_LARGE.size();
+
+    size_t offset = 0;
+    while (offset < payload.size()) {
+        auto res = try_parse_binary(payload.data() + offset,
+                                    payload.size() - offset);
+        if (res.status == ParseStatus::INCOMPLETE || res.fatal) break;
+        offset += res.bytes_consumed;
+        if (res.status != ParseStatus::OK) continue;
+
+        const uint32_t id = res.frame.request_id;
+        Command inner;
+        std::string error;
+        if (!binary_frame_to_command(res.frame, inner, error)) {
+            append_binary_frame(out, BinaryOpcode::ERROR, id, {}, {}, error);
+            continue;
+        }
+        if (inner.type != CommandType::RSET && inner.type != CommandType::RDEL &&
+            inner.type != CommandType::RGET) {
+            append_binary_frame(out, BinaryOpcode::ERROR, id, {}, {},
+                                "NOT_A_REPLICATION_COMMAND");
+            continue;
+        }
+        const size_t before = out.size();
+        append_local_response(inner, id, 0, out);
+        const size_t owed = (payload.size() - offset) / BINARY_HEADER_SIZE * error_frame;
+        if (out.size() - body + owed > BINARY_MAX_VAL_LEN) {
+            out.resize(before);
+            append_binary_frame(out, BinaryOpcode::ERROR, id, {}, {}, REPLY_TOO_LARGE);
+        }
+    }
+
+    std::string hdr;
+    append_binary_header(hdr, BinaryOpcode::VALUE, request_id, 0, 0,
+                         out.size() - header - BINARY_HEADER_SIZE, flags);
+    out.replace(header, BINARY_HEADER_SIZE, hdr);
+}
+
 // ── Phase 5: Quorum write ────────────────────────────────────────────────────
 
-std::string Coordinator::quorum_write(const std::string& key,
-                                       const std::string& value,
-                                       bool is_del) {
+void Coordinator::quorum_write(std::string key, std::string value, bool is_del,
+                               Reply done) {
+    done = timed(write_metrics(), std::move(done));
     auto replicas = ring_.get_replica_nodes(key, replication_factor_);
-    if (replicas.empty()) return format_error("EMPTY_RING");
+    if (replicas.empty()) {
+        done(format_error("EMPTY_RING"));
+        return;
+    }
 
+    // Shared by every replica's completion callback.  Key and value live
+    // here once rather than being copied per replica.
+    struct WriteState {
+        std::string       key;
+        std::string       value;
+        bool              is_del = false;
+        Version           version;
+        std::atomic<int>  acks{0};
+        std::atomic<int>  failed{0};
+        std::atomic<int>  remaining{0};
+        std::atomic<bool> replied{false};
+        Reply             done;
+    };
+    auto state = std::make_shared<WriteState>();
+    state->key     = std::move(key);
+    state->value   = std::move(value);
+    state->is_del  = is_del;
     // One version shared across all replicas (LWW: coordinator's timestamp
     // + node_id as tiebreaker, per §5.A of CONTEXT.md).
     // next_ts() guarantees monotonically increasing timestamps even when
     // two operations from this node land in the same wall-clock millisecond.
-    const Version version{next_ts(), node_id_};
+    state->version = Version{next_ts(), node_id_};
+    state->remaining.store(static_cast<int>(replicas.size()),
+                           std::memory_order_relaxed);
+    state->done    = std::move(done);
+
+    // Reply as soon as the outcome is decided: W acks, or more than N - W
+    // failures (W is then out of reach).  Slower replicas finish later and
+    // are still hinted on failure.
+    const int needed    = static_cast<int>(write_quorum_);
+    const int tolerated = static_cast<int>(replicas.size()) - needed;
+    auto finish_one = [this, needed, tolerated](const std::shared_ptr<WriteState>& st,
+                                                bool ok) {
+        bool decided;
+        if (ok) {
+            decided = st->acks.fetch_add(1, std::memory_order_acq_rel) + 1 >=
+                      needed;
+        } else {
+            decided = st->failed.fetch_add(1, std::memory_order_acq_rel) + 1 >
+                      tolerated;
+        }
+        if (st->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            decided = true;
+        }
+        if (!decided || st->replied.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        // Reads that started before the write completed must not cache
+        // what they find.
+        hot_keys_.invalidate(st->key, st->version);
+        st->done(st->acks.load(std::memory_order_acquire) >= needed
+                     ? format_ok()
+                     : format_error("QUORUM_FAILED"));
+    };
 
-    // Scatter writes to all N replicas via the shared thread pool.
-    std::atomic<int> acks{0};
-    std::atomic<int> remaining{static_cast<int>(replicas.size())};
-    std::mutex done_mutex;
-    std::condition_variable done_cv;
+    // Every remote replica gets byte-identical RSET/RDEL: encode it once.
+    std::shared_ptr<const std::string> frame;
+    bool write_locally = false;
 
     for (const auto& replica : replicas) {
+        if (replica.node_id == node_id_) {
+            write_locally = true;  // applied below, once the remotes are in flight
+            continue;
+        }
+
         // Phase 6: fast-path for known-DOWN remote replicas — skip the TCP
         // attempt entirely and store a hint immediately (§9.D).
-        if (replica.node_id != node_id_ &&
-            membership_ &&
-            !membership_->is_available(replica.node_id)) {
+        if (membership_ && !membership_->is_available(replica.node_id)) {
             hints_.store(Hint{
                 replica.address, replica.node_id,
-                key, value, is_del, version
+                state->key, state->value, state->is_del, state->version
             });
-            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                done_cv.notify_one();
-            }
+            finish_one(state, false);
             continue;
         }
 
-        bool submitted = quorum_pool_->submit([&, replica]() {
-            bool ok = false;
-
-            if (replica.node_id == node_id_) {
-                // Local apply: build an RSET/RDEL command with the
-                // pre-generated version and call execute_local.
-                Command rcmd{};
-                rcmd.type         = is_del ? CommandType::RDEL : CommandType::RSET;
-                rcmd.key          = key;
-                rcmd.value        = value;
-                rcmd.timestamp_ms = version.timestamp_ms;
-                rcmd.node_id      = version.node_id;
-                ok = (execute_local(rcmd) == format_ok());
-            } else {
-                ok = send_replication_write(replica.address, key, value,
-                                            is_del, version);
-                // §9.D: if the replica is down, store a hint so we can
-                // replay once it comes back UP (Membership rejoin callback
-                // triggers replay_hints_for()).
-                if (!ok) {
-                    hints_.store(Hint{
-                        replica.address, replica.node_id,
-                        key, value, is_del, version
-                    });
-                }
-            }
+        if (!frame) {
+            frame = RpcClient::encode(
+                is_del ? BinaryOpcode::RDEL : BinaryOpcode::RSET,
+                encode_version_extras(state->version.timestamp_ms,
+                                      state->version.node_id),
+                state->key, is_del ? std::string_view{} : state->value);
+        }
 
-            if (ok) acks.fetch_add(1, std::memory_order_relaxed);
-            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                done_cv.notify_one();
+        const auto sent = std::chrono::steady_clock::now();
+        snitch_.begin(replica.node_id);
+        rpc_->call_batched(replica.address, frame,
+                           [this, state, finish_one, replica, sent](RpcResult r) {
+            bool ok = r.status == RpcStatus::OK &&
+                      r.opcode == BinaryOpcode::OK;
+            snitch_.end(replica.node_id,
+                        std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - sent),
+                        ok, r.busy, /*sample=*/false);
+            // §9.D: if the replica is down, store a hint so we can replay
+            // once it comes back UP (Membership rejoin callback schedules
+            // replay_hints_for()).  store() only queues it: this runs on the
+            // RPC event loop, and the hint store's writer does the disk I/O.
+            if (!ok) {
+                hints_.store(Hint{
+                    replica.address, replica.node_id,
+                    state->key, state->value, state->is_del, state->version
+                });
             }
+            finish_one(state, ok);
         });
+    }
 
-        if (!submitted) {
-            // Pool was shut down before we could queue the task — treat as
-            // failed replica so we never deadlock on done_cv.
-            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                done_cv.notify_one();
-            }
-        }
+    if (ring_.pending()) {
+        handover_write(state->key, state->value, is_del, state->version,
+                       replicas, frame);
     }
 
-    {
-        std::unique_lock<std::mutex> lock(done_mutex);
-        done_cv.wait(lock, [&]() {
-            return remaining.load(std::memory_order_acquire) == 0;
-        });
+    if (write_locally) {
+        // Local apply with the pre-generated version.  Goes straight to the
+        // WAL/engine instead of building an RSET/RDEL command (which would
+        // copy the value an extra time).
+        apply_local_write(state->key, state->value, state->is_del,
+                          state->version);
+        finish_one(state, true);
     }
+}
 
-    if (acks.load() >= static_cast<int>(write_quorum_)) {
-        return format_ok();
+void Coordinator::handover_write(const std::string& key, const std::string& value,
+                                 bool is_del, const Version& version,
+                                 ReplicaList replicas,
+                                 std::shared_ptr<const std::string>& frame) {
+    const RingSnapshot* next = ring_.pending();
+    if (!next) return;
+    for (const auto& n : next->replicas_at(murmurhash3(key), replication_factor_)) {
+        bool current = std::any_of(replicas.begin(), replicas.end(),
+                                   [&](const NodeInfo& r) {
+                                       return r.node_id == n.node_id;
+                                   });
+        if (current) continue;
+        if (n.node_id == node_id_) {
+            apply_local_write(key, value, is_del, version);
+            continue;
+        }
+        if (!frame) {
+            frame = RpcClient::encode(
+                is_del ? BinaryOpcode::RDEL : BinaryOpcode::RSET,
+                encode_version_extras(version.timestamp_ms, version.node_id),
+                key, is_del ? std::string_view{} : value);
+        }
+        // Best effort: a lost copy is caught by the range transfer or, at
+        // worst, by anti-entropy after the commit.
+        rpc_->call_batched(n.address, frame, [](RpcResult) {});
     }
-    return format_error("QUORUM_FAILED");
 }
 
-bool Coordinator::send_replication_write(const std::string& address,
-                                          const std::string& key,
-                                          const std::string& value,
-                                          bool is_del,
-                                          const Version& version) {
-    auto conn = pool_.acquire(address);
-    if (!conn.has_value()) return false;
+// ── Phase 5: Quorum read (implemented in Increment 3) ───────────────────────
 
-    // Build RSET or RDEL wire frame.
-    std::string frame;
-    if (is_del) {
-        frame = "RDEL " + std::to_string(key.size()) + " " + key + " "
-              + std::to_string(version.timestamp_ms) + " "
-              + std::to_string(version.node_id) + "\n";
-    } else {
-        frame = "RSET " + std::to_string(key.size()) + " " + key + " "
-              + std::to_string(value.size()) + " " + value + " "
-              + std::to_string(version.timestamp_ms) + " "
-              + std::to_string(version.node_id) + "\n";
+namespace {
+struct ReadResponse {
+    bool        digest = false;  // RDIGEST: version only, no value
+    bool        ok    = false;
+    bool        found = false;
+    std::string value;
+    Version     version;
+    NodeInfo    replica;
+};
+}  // namespace
+
+// Everything is guarded by `mutex`; replies, RPC calls and repairs are issued
+// after releasing it (RpcClient::call may complete inline on shutdown).
+struct Coordinator::ReadState {
+    std::mutex                         mutex;
+    std::string                        key;
+    std::shared_ptr<const std::string> frame;       // RGET, encoded once
+    std::shared_ptr<const std::string> digest_frame;  // RDIGEST (or null)
+    std::vector<ReadResponse>          responses;   // one per replica asked
+    std::vector<NodeInfo>              spares;      // hedge candidates
+    size_t                             next_spare = 0;
+    int                                needed     = 1;
+    int                                outstanding = 0;
+    int                                ok_count    = 0;
+    bool                               replied     = false;
+    bool                               fetched     = false;  // mismatch RGET sent
+    bool                               hot         = false;  // fill the hot-key cache
+    uint64_t                           hot_ticket  = 0;
+    // What the reply carried, for repairing replicas that answer late.
+    bool                               best_found  = false;
+    std::string                        best_value;
+    Version                            best_version;
+    Reply                              done;
+
+    /// Append a slot for `replica`; caller holds `mutex`.
+    size_t reserve(const NodeInfo& replica, bool digest = false) {
+        responses.push_back(ReadResponse{});
+        responses.back().replica = replica;
+        responses.back().digest  = digest;
+        ++outstanding;
+        return responses.size() - 1;
+    }
+};
+
+void Coordinator::quorum_read(std::string key, Reply done) {
+    done = timed(read_metrics(), std::move(done));
+    HotKeyCache::Lookup cached = hot_keys_.read(key);
+    if (cached.hit) {
+        done(cached.found ? format_value(cached.value) : format_not_found());
+        return;
     }
 
-    ssize_t sent = ::send(conn->fd, frame.data(), frame.size(), MSG_NOSIGNAL);
-    if (sent <= 0) {
-        ::close(conn->fd);
-        return false;
+    const bool hedging = hedge_reads_.load(std::memory_order_relaxed);
+    const bool ranking = snitch_enabled_.load(std::memory_order_relaxed);
+    // With hedging, or a snitch or membership to rank replicas by, fetch the
+    // whole preference list: positions past R are the spares / stand-ins.
+    auto replicas = ring_.get_replica_nodes(
+        key, hedging || ranking || membership_
+                 ? std::max(read_quorum_, replication_factor_)
+                 : read_quorum_);
+    if (replicas.empty()) {
+        done(format_error("EMPTY_RING"));
+        return;
     }
 
-    // Read response (bounded by SO_RCVTIMEO set in ConnectionPool).
-    char buf[256];
-    std::string response;
-    while (true) {
-        ssize_t n = ::recv(conn->fd, buf, sizeof(buf), 0);
-        if (n > 0) {
-            response.append(buf, static_cast<size_t>(n));
-            if (response.back() == '\n') break;
-        } else {
-            ::close(conn->fd);
-            return false;
+    auto state = std::make_shared<ReadState>();
+    state->key    = std::move(key);
+    state->frame  = RpcClient::encode(BinaryOpcode::RGET, {}, state->key, {});
+    state->needed = static_cast<int>(read_quorum_);
+    state->done   = std::move(done);
+    state->hot        = cached.hot;
+    state->hot_ticket = cached.ticket;
+
+    const size_t primaries = std::min<size_t>(read_quorum_, replicas.size());
+    std::vector<NodeInfo> ranked;
+    std::vector<NodeInfo> reordered;
+    if (ranking) replicas = snitch_.rank(replicas, primaries, node_id_, ranked);
+    if (membership_) replicas = prefer_healthy(replicas, primaries, reordered);
+    if ((ranking || membership_) && !hedging) replicas = replicas.first(primaries);
+    for (size_t i = primaries; i < replicas.size(); ++i) {
+        // A known-DOWN spare would only fail again.
+        if (membership_ && replicas[i].node_id != node_id_ &&
+            !membership_->is_available(replicas[i].node_id)) {
+            continue;
         }
+        state->spares.push_back(replicas[i]);
     }
 
-    pool_.release(std::move(*conn));
-    return response == "+OK\n";
-}
+    // Digest reads: one replica (this node if it is among the R, else the
+    // first) returns the value, the rest only their version.  Spares and
+    // hedges always ask for the full value.
+    size_t data_replica = 0;
+    const bool digests =
+        digest_reads_.load(std::memory_order_relaxed) && primaries > 1;
+    if (digests) {
+        state->digest_frame =
+            RpcClient::encode(BinaryOpcode::RDIGEST, {}, state->key, {});
+        for (size_t i = 0; i < primaries; ++i) {
+            if (replicas[i].node_id == node_id_) data_replica = i;
+        }
+    }
 
-// ── Phase 5: Quorum read (implemented in Increment 3) ───────────────────────
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        for (size_t i = 0; i < primaries; ++i) {
+            state->reserve(replicas[i], digests && i != data_replica);
+        }
+    }
+    for (size_t i = 0; i < primaries; ++i) read_dispatch(state, i);
 
-std::string Coordinator::quorum_read(const std::string& key) {
-    auto replicas = ring_.get_replica_nodes(key, read_quorum_);
-    if (replicas.empty()) return format_error("EMPTY_RING");
+    bool arm_hedge;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        arm_hedge = !state->replied && !state->spares.empty();
+    }
+    if (!arm_hedge) return;
 
-    struct ReadResponse {
-        bool        ok    = false;
-        bool        found = false;
-        std::string value;
-        Version     version;
-        NodeInfo    replica;
+    // Still short of R after the hedge delay: ask one more replica.
+    rpc_->run_after(hedge_delay(), [this, state]() {
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->replied ||
+                state->next_spare >= state->spares.size()) {
+                return;
+            }
+            index = state->reserve(state->spares[state->next_spare++]);
+        }
+        hedged_reads_.fetch_add(1, std::memory_order_relaxed);
+        read_dispatch(state, index);
+    });
+}
+
+ReplicaList Coordinator::prefer_healthy(
+        ReplicaList replicas, size_t primaries,
+        std::vector<NodeInfo>& buf) const {
+    auto suspect = [this](const NodeInfo& n) {
+        return n.node_id != node_id_ && membership_->is_available(n.node_id) &&
+               membership_->is_suspect(n.node_id);
     };
+    bool any = false;
+    for (size_t i = 0; i < primaries && !any; ++i) any = suspect(replicas[i]);
+    if (!any) return replicas;
+
+    // Healthy (and DOWN, which quorum_read skips anyway) nodes keep their
+    // ring order; suspects follow.  A late peer is usually a dying or
+    // pausing one: ask it only if the rest cannot make up R.
+    buf.assign(replicas.begin(), replicas.end());
+    std::stable_partition(buf.begin(), buf.end(),
+                          [&](const NodeInfo& n) { return !suspect(n); });
+    return buf;
+}
 
-    // Pre-sized: each slot written by exactly one pool worker (no aliasing).
-    std::vector<ReadResponse> responses(replicas.size());
-    std::atomic<int> remaining{static_cast<int>(replicas.size())};
-    std::mutex done_mutex;
-    std::condition_variable done_cv;
-
-    for (size_t i = 0; i < replicas.size(); ++i) {
-        const auto& rep = replicas[i];
-
-        // Phase 6: fast-path for known-DOWN remote replicas — leave
-        // responses[i].ok = false (default) so it counts as a failed read.
-        if (rep.node_id != node_id_ &&
-            membership_ &&
-            !membership_->is_available(rep.node_id)) {
-            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                done_cv.notify_one();
-            }
-            continue;
+void Coordinator::read_dispatch(const std::shared_ptr<ReadState>& st,
+                                size_t index) {
+    NodeInfo replica;
+    bool     digest;
+    {
+        std::lock_guard<std::mutex> lock(st->mutex);
+        replica = st->responses[index].replica;
+        digest  = st->responses[index].digest;
+    }
+
+    if (replica.node_id == node_id_) {
+        if (digest) {
+            auto version = engine_.get_version(st->key);
+            read_complete(st, index, true, version.has_value(), {},
+                          version.value_or(Version{}));
+            return;
+        }
+        auto r = engine_.get(st->key);
+        read_complete(st, index, true, r.found, std::move(r.value), r.version);
+        return;
+    }
+
+    // Phase 6: fast-path for known-DOWN remote replicas — counts as a
+    // failed read without a TCP attempt.
+    if (membership_ && !membership_->is_available(replica.node_id)) {
+        read_complete(st, index, false, false, {}, Version{});
+        return;
+    }
+
+    const auto sent = std::chrono::steady_clock::now();
+    snitch_.begin(replica.node_id);
+    rpc_->call(replica.address, digest ? st->digest_frame : st->frame,
+               [this, st, index, sent, node = replica.node_id](RpcResult r) {
+        bool ok    = r.status == RpcStatus::OK &&
+                     r.opcode != BinaryOpcode::ERROR;
+        bool found = ok && r.opcode == BinaryOpcode::VALUE;
+        snitch_.end(node, std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - sent),
+                    ok, r.busy);
+        if (ok && hedge_reads_.load(std::memory_order_relaxed)) {
+            record_read_latency(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - sent).count()));
         }
+        read_complete(st, index, ok, found,
+                      found ? std::move(r.value) : std::string{},
+                      Version{r.timestamp_ms, r.node_id});
+    });
+}
 
-        bool submitted = quorum_pool_->submit([&, i]() {
-            const auto& r2 = replicas[i];
-            auto& resp     = responses[i];
-            resp.replica   = r2;
+void Coordinator::read_complete(const std::shared_ptr<ReadState>& st,
+                                size_t index, bool ok, bool found,
+                                std::string value, const Version& version) {
+    std::string           reply;
+    bool                  send_reply = false;
+    bool                  has_spare  = false;  // also used for the mismatch RGET
+    size_t                spare_index = 0;
+    std::vector<NodeInfo> stale;
+    std::string           repair_value;
+    Version               repair_version;
 
-            if (r2.node_id == node_id_) {
-                resp.ok = true;
-                auto r  = engine_.get(key);
-                resp.found   = r.found;
-                resp.value   = r.value;
-                resp.version = r.version;
-            } else {
-                auto r       = send_replication_read(r2.address, key);
-                resp.ok      = r.ok;
-                resp.found   = r.found;
-                resp.value   = r.value;
-                resp.version = r.version;
+    {
+        std::lock_guard<std::mutex> lock(st->mutex);
+        auto& resp = st->responses[index];
+        resp.ok    = ok;
+        resp.found = found;
+        if (found) {
+            resp.value   = std::move(value);
+            resp.version = version;
+        }
+        --st->outstanding;
+        if (ok) ++st->ok_count;
+
+        if (st->replied) {
+            // Straggler: repair it if it is behind what the client got.
+            if (ok && st->best_found &&
+                (!found || is_newer(st->best_version, resp.version))) {
+                stale.push_back(resp.replica);
+                repair_value   = st->best_value;
+                repair_version = st->best_version;
             }
-
-            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                done_cv.notify_one();
+        } else if (st->ok_count < st->needed && !ok &&
+                   st->next_spare < st->spares.size()) {
+            // A failed replica is replaced right away rather than waiting
+            // for the hedge timer.
+            spare_index = st->reserve(st->spares[st->next_spare++]);
+            has_spare   = true;
+        } else if (st->ok_count >= st->needed || st->outstanding == 0) {
+            // Pick the highest-version response (§9.C LWW comparison),
+            // preferring one that carries the value.
+            const ReadResponse* best = nullptr;
+            for (const auto& r : st->responses) {
+                if (!r.ok || !r.found) continue;
+                if (!best || is_newer(r.version, best->version) ||
+                    (best->digest && !r.digest &&
+                     !is_newer(best->version, r.version))) {
+                    best = &r;
+                }
             }
-        });
 
-        if (!submitted) {
-            // Pool shut down — leave resp.ok = false (already default) and
-            // decrement so we never deadlock.
-            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                done_cv.notify_one();
+            if (best && best->digest && !st->fetched) {
+                // Digest mismatch: a replica that sent only its version is
+                // ahead of the one that sent the value.  Fetch the value
+                // from it, then decide.
+                st->fetched = true;
+                NodeInfo ahead = best->replica;  // reserve() may reallocate
+                spare_index = st->reserve(ahead);
+                has_spare   = true;
+                digest_mismatches_.fetch_add(1, std::memory_order_relaxed);
+            } else if (best && best->digest && st->outstanding > 0) {
+                // Mismatch fetch still in flight.
+            } else if (st->ok_count == 0 || (best && best->digest)) {
+                // Nobody answered, or the newest version could not be read.
+                st->replied = true;
+                send_reply  = true;
+                reply = format_error("QUORUM_FAILED");
+            } else if (!best) {
+                st->replied = true;
+                send_reply  = true;
+                reply = format_not_found();
+                if (st->hot) hot_keys_.fill(st->key, st->hot_ticket, false, {}, Version{});
+            } else {
+                st->replied = true;
+                send_reply  = true;
+                st->best_found   = true;
+                st->best_version = best->version;
+                if (st->hot) {
+                    hot_keys_.fill(st->key, st->hot_ticket, true, best->value,
+                                   best->version);
+                }
+                if (st->outstanding > 0) st->best_value = best->value;
+                reply = format_value(best->value);
+
+                // Collect stale replicas for async read repair (§9.C).
+                for (const auto& r : st->responses) {
+                    if (!r.ok) continue;
+                    if (!r.found || is_newer(best->version, r.version)) {
+                        stale.push_back(r.replica);
+                    }
+                }
+                if (!stale.empty()) {
+                    repair_value   = best->value;
+                    repair_version = best->version;
+                }
             }
         }
     }
 
-    {
-        std::unique_lock<std::mutex> lock(done_mutex);
-        done_cv.wait(lock, [&]() {
-            return remaining.load(std::memory_order_acquire) == 0;
-        });
+    if (has_spare) read_dispatch(st, spare_index);
+    if (!stale.empty()) {
+        read_repair_async(st->key, std::move(repair_value), repair_version,
+                          std::move(stale));
     }
+    if (send_reply) st->done(std::move(reply));
+}
 
-    // Pick the highest-version response (§9.C LWW comparison).
-    const ReadResponse* best = nullptr;
-    int ok_count = 0;
-    for (const auto& r : responses) {
-        if (!r.ok) continue;
-        ++ok_count;
-        if (r.found) {
-            if (!best || !best->found || is_newer(r.version, best->version)) {
-                best = &r;
-            }
+// ── Multi-key GET / SET ──────────────────────────────────────────────────────
+
+namespace {
+/// The keys (MSET) or response slots (MGET) one replica node is sent.
+struct MultiBatch {
+    NodeInfo            node;
+    std::vector<size_t> slots;
+};
+
+void add_to_batch(std::vector<MultiBatch>& batches, const NodeInfo& node,
+                  size_t slot) {
+    for (auto& b : batches) {
+        if (b.node.node_id == node.node_id) {
+            b.slots.push_back(slot);
+            return;
         }
     }
+    batches.push_back(MultiBatch{node, {slot}});
+}
+
+/// Split `slots` into RBATCH payloads no larger than a binary frame allows,
+/// calling `send(payload, first, count)` for each.  `append(out, i, slot)`
+/// adds the inner frame for slots[i] with inner id `i - first`.
+template <typename Append, typename Send>
+void for_each_rbatch(const std::vector<size_t>& slots, Append append, Send send) {
+    std::string payload;
+    size_t first = 0;
+    for (size_t i = 0; i < slots.size(); i++) {
+        const size_t before = payload.size();
+        append(payload, i - first, slots[i]);
+        if (payload.size() <= BINARY_MAX_VAL_LEN || i == first) continue;
+        // Over the limit: send what came before and start over with slot i.
+        payload.resize(before);
+        send(std::move(payload), first, i - first);
+        payload.clear();
+        first = i;
+        append(payload, 0, slots[i]);
+    }
+    if (!payload.empty()) send(std::move(payload), first, slots.size() - first);
+}
+
+/// Call `fn(inner_id, frame)` for each inner response of an RBATCH reply.
+template <typename Fn>
+void for_each_inner(std::string_view payload, Fn fn) {
+    size_t offset = 0;
+    while (offset < payload.size()) {
+        auto res = try_parse_binary(payload.data() + offset, payload.size() - offset);
+        if (res.status == ParseStatus::INCOMPLETE || res.fatal) return;
+        offset += res.bytes_consumed;
+        if (res.status == ParseStatus::OK) fn(res.frame.request_id, res.frame);
+    }
+}
+}  // namespace
 
-    if (ok_count == 0) return format_error("QUORUM_FAILED");
+// Each response slot is written by exactly one batch; the last batch to
+// finish (`pending` reaching zero) resolves the keys and replies.
+struct Coordinator::MultiGetState {
+    struct Key {
+        std::string key;
+        size_t      first  = 0;      // its slots in `responses`
+        size_t      count  = 0;
+        bool        cached = false;  // answered by the hot-key cache
+        bool        hot    = false;
+        uint64_t    hot_ticket = 0;
+    };
+    std::vector<Key>          keys;
+    std::vector<ReadResponse> responses;
+    std::vector<size_t>       slot_key;  // responses[i] belongs to keys[slot_key[i]]
+    std::vector<MultiGetItem> items;
+    std::atomic<size_t>       pending{1};
+    Reply                     done;
+};
+
+void Coordinator::multi_get(std::string args, Reply done) {
+    std::vector<MultiKeyArg> parsed;
+    if (!parse_multi_args(args, /*with_values=*/false, parsed)) {
+        done(format_error("MALFORMED_KEYS"));
+        return;
+    }
+    if (ring_.node_count() == 0) {
+        done(format_error("EMPTY_RING"));
+        return;
+    }
 
-    if (!best || !best->found) return format_not_found();
+    const bool ranking = snitch_enabled_.load(std::memory_order_relaxed);
+    auto st = std::make_shared<MultiGetState>();
+    st->keys.resize(parsed.size());
+    st->items.resize(parsed.size());
+    st->done = std::move(done);
+
+    std::vector<MultiBatch> batches;
+    std::vector<NodeInfo>   ranked;
+    std::vector<NodeInfo>   reordered;
+    std::vector<NodeInfo>   available;
+    for (size_t k = 0; k < parsed.size(); ++k) {
+        auto& key = st->keys[k];
+        key.key.assign(parsed[k].key);
+
+        HotKeyCache::Lookup cached = hot_keys_.read(key.key);
+        if (cached.hit) {
+            key.cached = true;
+            st->items[k].status = cached.found ? MultiGetItem::Status::FOUND
+                                               : MultiGetItem::Status::NOT_FOUND;
+            st->items[k].value  = std::move(cached.value);
+            continue;
+        }
+        key.hot        = cached.hot;
+        key.hot_ticket = cached.ticket;
+
+        auto replicas = ring_.get_replica_nodes(
+            key.key, ranking || membership_
+                         ? std::max(read_quorum_, replication_factor_)
+                         : read_quorum_);
+        const size_t primaries = std::min<size_t>(read_quorum_, replicas.size());
+        if (ranking) replicas = snitch_.rank(replicas, primaries, node_id_, ranked);
+        if (membership_) {
+            replicas = prefer_healthy(replicas, primaries, reordered);
+            // No spares to fall back on: pass over DOWN replicas up front.
+            available.assign(replicas.begin(), replicas.end());
+            std::stable_partition(available.begin(), available.end(),
+                                  [this](const NodeInfo& n) {
+                                      return n.node_id == node_id_ ||
+                                             membership_->is_available(n.node_id);
+                                  });
+            replicas = available;
+        }
 
-    // Collect stale replicas for async read repair (§9.C).
-    std::vector<NodeInfo> stale;
-    for (const auto& r : responses) {
-        if (!r.ok) continue;
-        if (!r.found || is_newer(best->version, r.version)) {
-            stale.push_back(r.replica);
+        key.first = st->responses.size();
+        key.count = primaries;
+        for (size_t i = 0; i < primaries; ++i) {
+            const size_t slot = st->responses.size();
+            st->responses.push_back(ReadResponse{});
+            st->responses.back().replica = replicas[i];
+            st->slot_key.push_back(k);
+            add_to_batch(batches, replicas[i], slot);
         }
     }
-    if (!stale.empty()) {
-        read_repair_async(key, best->value, best->version, std::move(stale));
+
+    // Sent before the local reads so the remote batches are in flight while
+    // this node reads its own keys.
+    const MultiBatch* local = nullptr;
+    for (const auto& batch : batches) {
+        if (batch.node.node_id == node_id_) {
+            local = &batch;
+            continue;
+        }
+        // Phase 6: a known-DOWN replica fails its keys without a TCP attempt.
+        if (membership_ && !membership_->is_available(batch.node.node_id)) continue;
+
+        multi_get_send(st, batch.node, batch.slots);
+    }
+
+    if (local) {
+        for (size_t slot : local->slots) {
+            auto& resp = st->responses[slot];
+            auto  r    = engine_.get(st->keys[st->slot_key[slot]].key);
+            resp.ok    = true;
+            resp.found = r.found;
+            if (r.found) {
+                resp.value   = std::move(r.value);
+                resp.version = r.version;
+            }
+        }
     }
 
-    return format_value(best->value);
+    if (st->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) multi_get_finish(st);
+}
+
+void Coordinator::multi_get_send(const std::shared_ptr<MultiGetState>& st,
+                                 const NodeInfo& node,
+                                 const std::vector<size_t>& node_slots) {
+    for_each_rbatch(node_slots,
+        [&](std::string& out, size_t id, size_t slot) {
+            append_binary_frame(out, BinaryOpcode::RGET,
+                                static_cast<uint32_t>(id), {},
+                                st->keys[st->slot_key[slot]].key);
+        },
+        [&](std::string payload, size_t first, size_t count) {
+            std::vector<size_t> slots(node_slots.begin() + first,
+                                      node_slots.begin() + first + count);
+            auto frame = RpcClient::encode(BinaryOpcode::RBATCH, {}, {}, payload);
+            const auto sent = std::chrono::steady_clock::now();
+            st->pending.fetch_add(1, std::memory_order_relaxed);
+            snitch_.begin(node.node_id);
+            rpc_->call(node.address, std::move(frame),
+                       [this, st, slots = std::move(slots), sent,
+                        node](RpcResult r) {
+                const bool ok = r.status == RpcStatus::OK &&
+                                r.opcode == BinaryOpcode::VALUE;
+                // One round trip for many keys: not comparable with a
+                // single read's latency.
+                snitch_.end(node.node_id,
+                            std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - sent),
+                            ok, r.busy, /*sample=*/false);
+                // Values the replica had no room for in this reply.
+                std::vector<size_t> overflow;
+                if (ok) {
+                    for_each_inner(r.value, [&](uint32_t id, const BinaryFrame& f) {
+                        if (id >= slots.size()) return;
+                        if (f.opcode == BinaryOpcode::ERROR &&
+                            f.value == REPLY_TOO_LARGE) {
+                            overflow.push_back(slots[id]);
+                            return;
+                        }
+                        auto& resp = st->responses[slots[id]];
+                        resp.ok    = f.opcode != BinaryOpcode::ERROR;
+                        resp.found = f.opcode == BinaryOpcode::VALUE;
+                        if (!resp.found) return;
+                        resp.value.assign(f.value);
+                        decode_version_extras(f.extras, resp.version.timestamp_ms,
+                                              resp.version.node_id);
+                    });
+                }
+                // Ask again for the rest while each reply makes progress; a
+                // value that cannot fit even alone stays failed.
+                if (!overflow.empty() && overflow.size() < slots.size()) {
+                    multi_get_send(st, node, overflow);
+                }
+                if (st->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    multi_get_finish(st);
+                }
+            });
+        });
 }
 
-Coordinator::RemoteGetResult Coordinator::send_replication_read(
-        const std::string& address, const std::string& key) {
-    RemoteGetResult result;
+void Coordinator::multi_get_finish(const std::shared_ptr<MultiGetState>& st) {
+    const int needed = static_cast<int>(read_quorum_);
+    for (size_t k = 0; k < st->keys.size(); ++k) {
+        const auto& key = st->keys[k];
+        if (key.cached) continue;
+
+        // Same LWW resolution as read_complete().
+        int ok_count = 0;
+        const ReadResponse* best = nullptr;
+        for (size_t i = key.first; i < key.first + key.count; ++i) {
+            const auto& r = st->responses[i];
+            if (!r.ok) continue;
+            ++ok_count;
+            if (r.found && (!best || is_newer(r.version, best->version))) best = &r;
+        }
+
+        auto& item = st->items[k];
+        if (ok_count < needed) {
+            item.status = MultiGetItem::Status::FAILED;
+            continue;
+        }
+        if (!best) {
+            item.status = MultiGetItem::Status::NOT_FOUND;
+            if (key.hot) hot_keys_.fill(key.key, key.hot_ticket, false, {}, Version{});
+            continue;
+        }
+
+        std::vector<NodeInfo> stale;
+        for (size_t i = key.first; i < key.first + key.count; ++i) {
+            const auto& r = st->responses[i];
+            if (r.ok && (!r.found || is_newer(best->version, r.version))) {
+                stale.push_back(r.replica);
+            }
+        }
+        if (key.hot) hot_keys_.fill(key.key, key.hot_ticket, true, best->value, best->version);
+        item.status = MultiGetItem::Status::FOUND;
+        item.value  = best->value;
+        if (!stale.empty()) {
+            read_repair_async(key.key, best->value, best->version, std::move(stale));
+        }
+    }
+    // The reply is one frame for a binary client: past the limit, the
+    // client has to ask for fewer keys at a time.
+    size_t payload = std::to_string(st->items.size()).size();
+    for (const auto& item : st->items) {
+        payload += item.status == MultiGetItem::Status::FOUND
+                       ? 2 + std::to_string(item.value.size()).size() + item.value.size()
+                       : 3;
+    }
+    if (payload > BINARY_MAX_VAL_LEN) {
+        st->done(format_error(std::string(REPLY_TOO_LARGE)));
+        return;
+    }
+    st->done(format_multi_get(st->items));
+}
 
-    auto conn = pool_.acquire(address);
-    if (!conn.has_value()) return result;
+// Guarded by `mutex`; replies and cache invalidations happen after releasing it.
+struct Coordinator::MultiSetState {
+    struct Key {
+        std::string key;
+        std::string value;
+        Version     version;
+        int         replicas = 0;
+        int         acks     = 0;
+        int         failed   = 0;
+        bool        decided  = false;
+    };
+    std::mutex       mutex;
+    std::vector<Key> keys;
+    size_t           undecided = 0;
+    bool             lost      = false;  // some key missed W
+    bool             replied   = false;
+    Reply            done;
+
+    /// Count one replica's answer for keys[k]; returns whether it decided
+    /// the key.  Caller holds `mutex`.
+    bool record(size_t k, bool ok, int needed) {
+        Key& key = keys[k];
+        if (key.decided) return false;
+        (ok ? key.acks : key.failed)++;
+        if (key.acks < needed && key.failed <= key.replicas - needed &&
+            key.acks + key.failed < key.replicas) {
+            return false;
+        }
+        key.decided = true;
+        if (key.acks < needed) lost = true;
+        --undecided;
+        return true;
+    }
+};
 
-    std::string frame = "RGET " + std::to_string(key.size()) + " " + key + "\n";
-    ssize_t sent = ::send(conn->fd, frame.data(), frame.size(), MSG_NOSIGNAL);
-    if (sent <= 0) {
-        ::close(conn->fd);
-        return result;
+void Coordinator::multi_set(std::string args, Reply done) {
+    std::vector<MultiKeyArg> parsed;
+    if (!parse_multi_args(args, /*with_values=*/true, parsed)) {
+        done(format_error("MALFORMED_KEYS"));
+        return;
+    }
+    if (ring_.node_count() == 0) {
+        done(format_error("EMPTY_RING"));
+        return;
     }
 
-    char buf[4096];
-    std::string response;
-    while (true) {
-        ssize_t n = ::recv(conn->fd, buf, sizeof(buf), 0);
-        if (n > 0) {
-            response.append(buf, static_cast<size_t>(n));
-            if (response.back() == '\n') break;
-        } else {
-            ::close(conn->fd);
-            return result;
+    auto st = std::make_shared<MultiSetState>();
+    st->keys.resize(parsed.size());
+    st->undecided = parsed.size();
+    st->done      = std::move(done);
+
+    std::vector<MultiBatch> batches;
+    for (size_t k = 0; k < parsed.size(); ++k) {
+        auto& key = st->keys[k];
+        key.key.assign(parsed[k].key);
+        key.value.assign(parsed[k].value);
+        key.version = Version{next_ts(), node_id_};
+
+        auto replicas = ring_.get_replica_nodes(key.key, replication_factor_);
+        key.replicas = static_cast<int>(replicas.size());
+        for (const auto& replica : replicas) add_to_batch(batches, replica, k);
+
+        if (ring_.pending()) {
+            std::shared_ptr<const std::string> frame;
+            handover_write(key.key, key.value, false, key.version, replicas, frame);
         }
     }
 
-    pool_.release(std::move(*conn));
-    result.ok = true;
+    // Record answers for `keys`, then invalidate what they decided and
+    // reply once every key is decided or one has failed.
+    const int needed = static_cast<int>(write_quorum_);
+    auto settle = [this, needed](const std::shared_ptr<MultiSetState>& s,
+                                 const std::vector<size_t>& keys,
+                                 const std::vector<bool>& ok) {
+        std::vector<size_t> decided;
+        bool reply = false;
+        bool lost  = false;
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (s->record(keys[i], ok[i], needed)) decided.push_back(keys[i]);
+            }
+            if (!s->replied && (s->undecided == 0 || s->lost)) {
+                s->replied = reply = true;
+                lost = s->lost;
+            }
+        }
+        // Reads that started before the writes completed must not cache
+        // what they find.
+        for (size_t k : decided) hot_keys_.invalidate(s->keys[k].key, s->keys[k].version);
+        if (reply) s->done(lost ? format_error("QUORUM_FAILED") : format_ok());
+    };
+    auto hint_all = [this](const std::shared_ptr<MultiSetState>& s,
+                           const NodeInfo& node, const std::vector<size_t>& keys,
+                           const std::vector<bool>& ok) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (ok[i]) continue;
+            const auto& key = s->keys[keys[i]];
+            hints_.store(Hint{node.address, node.node_id, key.key, key.value,
+                              false, key.version});
+        }
+    };
+
+    const MultiBatch* local = nullptr;
+    for (const auto& batch : batches) {
+        if (batch.node.node_id == node_id_) {
+            local = &batch;
+            continue;
+        }
 
-    auto parsed      = parse_versioned_response(response);
-    result.found     = parsed.found;
-    result.value     = parsed.value;
-    result.version   = Version{parsed.timestamp_ms, parsed.node_id};
-    return result;
+        // Phase 6: hint every key for a known-DOWN replica at once (§9.D).
+        if (membership_ && !membership_->is_available(batch.node.node_id)) {
+            std::vector<bool> ok(batch.slots.size(), false);
+            hint_all(st, batch.node, batch.slots, ok);
+            settle(st, batch.slots, ok);
+            continue;
+        }
+
+        for_each_rbatch(batch.slots,
+            [&](std::string& out, size_t id, size_t k) {
+                const auto& key = st->keys[k];
+                append_binary_frame(out, BinaryOpcode::RSET,
+                                    static_cast<uint32_t>(id),
+                                    encode_version_extras(key.version.timestamp_ms,
+                                                          key.version.node_id),
+                                    key.key, key.value);
+            },
+            [&](std::string payload, size_t first, size_t count) {
+                std::vector<size_t> keys(batch.slots.begin() + first,
+                                         batch.slots.begin() + first + count);
+                auto frame = RpcClient::encode(BinaryOpcode::RBATCH, {}, {}, payload);
+                const auto sent = std::chrono::steady_clock::now();
+                snitch_.begin(batch.node.node_id);
+                rpc_->call(batch.node.address, std::move(frame),
+                           [this, st, settle, hint_all, keys = std::move(keys), sent,
+                            node = batch.node](RpcResult r) {
+                    const bool ok = r.status == RpcStatus::OK &&
+                                    r.opcode == BinaryOpcode::VALUE;
+                    snitch_.end(node.node_id,
+                                std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - sent),
+                                ok, r.busy, /*sample=*/false);
+                    std::vector<bool> acked(keys.size(), false);
+                    if (ok) {
+                        for_each_inner(r.value, [&](uint32_t id, const BinaryFrame& f) {
+                            if (id < acked.size()) acked[id] = f.opcode == BinaryOpcode::OK;
+                        });
+                    }
+                    hint_all(st, node, keys, acked);
+                    settle(st, keys, acked);
+                });
+            });
+    }
+
+    if (local) {
+        // Applied once the remotes are in flight, as in quorum_write().
+        for (size_t k : local->slots) {
+            const auto& key = st->keys[k];
+            apply_local_write(key.key, key.value, false, key.version);
+        }
+        settle(st, local->slots, std::vector<bool>(local->slots.size(), true));
+    }
 }
 
 void Coordinator::read_repair_async(const std::string& key,
-                                     const std::string& value,
+                                     std::string value,
                                      const Version& latest_ver,
                                      std::vector<NodeInfo> stale_replicas) {
-    {
-        std::lock_guard<std::mutex> lock(repair_mutex_);
-        repair_queue_.emplace([this, key, value, latest_ver,
-                               stale = std::move(stale_replicas)]() {
-            for (const auto& replica : stale) {
-                if (replica.node_id == node_id_) {
-                    engine_.set(key, value, latest_ver);
-                } else {
-                    send_replication_write(replica.address, key, value,
-                                           false, latest_ver);
-                }
-            }
-        });
+    // One copy of the value, shared by every stale replica's entry.
+    auto shared = std::make_shared<const std::string>(std::move(value));
+    for (const auto& replica : stale_replicas) {
+        repairs_->enqueue(replica, key, shared, latest_ver);
     }
-    repair_cv_.notify_one();
 }
 
-// ── Phase 4: Legacy FWD forwarding ──────────────────────────────────────────
-
-std::string Coordinator::forward_to(const std::string& address,
-                                     const std::string& inner_line,
-                                     uint32_t hops) {
-    auto conn = pool_.acquire(address);
-    if (!conn.has_value()) {
-        return format_error("NODE_UNAVAILABLE");
+size_t Coordinator::send_repair_batch(const NodeInfo& target,
+                                      const std::vector<RepairItem>& batch) {
+    if (target.node_id == node_id_) {
+        for (const auto& item : batch) {
+            engine_.set(item.key, *item.value, item.version);
+        }
+        return batch.size();
     }
+    // A replica that has gone DOWN since the read will be caught up by
+    // hinted handoff or the next read instead.
+    if (membership_ && !membership_->is_available(target.node_id)) return 0;
+
+    std::vector<std::shared_ptr<const std::string>> frames;
+    frames.reserve(batch.size());
+    for (const auto& item : batch) {
+        frames.push_back(RpcClient::encode(
+            BinaryOpcode::RSET,
+            encode_version_extras(item.version.timestamp_ms, item.version.node_id),
+            item.key, *item.value));
+    }
+    auto acked = send_writes(target.address, std::move(frames));
+    return static_cast<size_t>(std::count(acked.begin(), acked.end(), true));
+}
 
-    // Send the FWD frame
-    std::string frame = format_forward(hops, inner_line);
-    ssize_t sent = ::send(conn->fd, frame.data(), frame.size(), MSG_NOSIGNAL);
-    if (sent <= 0) {
-        ::close(conn->fd);  // Don't return bad connection to pool
-        return format_error("NODE_UNAVAILABLE");
+std::vector<bool> Coordinator::send_writes(
+    const std::string& address,
+    std::vector<std::shared_ptr<const std::string>> frames) {
+    // Issue everything at once so the RPC client can coalesce it into
+    // RBATCH frames, then wait for every ack.
+    struct Pending {
+        std::mutex              mutex;
+        std::condition_variable cv;
+        size_t                  remaining = 0;
+        std::vector<bool>       acked;
+    };
+    auto pending = std::make_shared<Pending>();
+    pending->remaining = frames.size();
+    pending->acked.assign(frames.size(), false);
+    if (frames.empty()) return {};
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        rpc_->call_batched(address, std::move(frames[i]),
+            [pending, i](RpcResult r) {
+                std::lock_guard<std::mutex> lock(pending->mutex);
+                pending->acked[i] = r.status == RpcStatus::OK &&
+                                    r.opcode == BinaryOpcode::OK;
+                if (--pending->remaining == 0) pending->cv.notify_one();
+            });
     }
 
-    // Read the response (blocking, with socket timeout from ConnectionPool)
-    char buf[4096];
-    std::string response;
-    while (true) {
-        ssize_t n = ::recv(conn->fd, buf, sizeof(buf), 0);
-        if (n > 0) {
-            response.append(buf, static_cast<size_t>(n));
-            // Check if we have a complete response (ends with \n)
-            if (!response.empty() && response.back() == '\n') {
+    std::unique_lock<std::mutex> lock(pending->mutex);
+    pending->cv.wait(lock, [&]() { return pending->remaining == 0; });
+    return pending->acked;
+}
+
+void Coordinator::set_read_repair_limits(const RepairQueue::Options& options) {
+    repairs_->set_options(options);
+}
+
+RepairQueue::Stats Coordinator::read_repair_stats() const {
+    return repairs_->stats();
+}
+
+void Coordinator::start_anti_entropy(const AntiEntropy::Options& options) {
+    engine_.attach_merkle(std::make_shared<MerkleIndex>(ring_.tokens()));
+    anti_entropy_ = std::make_unique<AntiEntropy>(
+        engine_, ring_, *rpc_, node_id_, replication_factor_,
+        [this](const std::string& key, const std::string& value, bool is_del,
+               const Version& version) {
+            apply_local_write(key, value, is_del, version);
+        },
+        [this](uint32_t node_id) {
+            return !membership_ || membership_->is_available(node_id);
+        },
+        options);
+    anti_entropy_->start();
+}
+
+void Coordinator::start_rebalancer(const Rebalancer::Options& options) {
+    rebalancer_ = std::make_unique<Rebalancer>(
+        engine_, ring_, *rpc_, node_id_, replication_factor_,
+        [this](const std::string& key, const std::string& value, bool is_del,
+               const Version& version) {
+            apply_local_write(key, value, is_del, version);
+        },
+        [this](const Rebalancer::Change& change) { on_ring_commit(change); },
+        [this](uint32_t node_id) {
+            return !membership_ || membership_->is_available(node_id);
+        },
+        options);
+}
+
+void Coordinator::start_gossip(const Gossip::Options& options) {
+    gossip_rpc_ = std::make_unique<RpcClient>(
+        static_cast<int>(options.period_ms), /*conns_per_peer=*/1);
+    gossip_transport_ = std::make_unique<RpcGossipTransport>(*gossip_rpc_);
+    gossip_ = std::make_unique<Gossip>(*membership_, *gossip_transport_, node_id_,
+                                       options);
+    gossip_->start();
+}
+
+void Coordinator::join_cluster_async(const std::string& self_address) {
+    run_change_async([this, self_address]() {
+        // Peers start sending us writes as soon as the change is staged:
+        // wait until our own server answers.
+        for (int attempt = 0; attempt < 100; attempt++) {
+            RpcResult r = rpc_->call_sync(self_address, BinaryOpcode::PING);
+            if (r.status == RpcStatus::OK) break;
+            if (r.status == RpcStatus::SHUTDOWN) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        switch (rebalancer_->join(self_address)) {
+            case Rebalancer::Outcome::FAILED:
+                std::cerr << "[REBALANCE] Join failed; node " << node_id_
+                          << " is not part of the ring\n";
                 break;
-            }
+            case Rebalancer::Outcome::LAGGING:
+                std::cerr << "[REBALANCE] Node " << node_id_ << " joined; "
+                          << rebalancer_->stats().lagging_peers
+                          << " nodes are still being sent the new ring\n";
+                break;
+            case Rebalancer::Outcome::COMMITTED:
+                break;
+        }
+    });
+}
+
+bool Coordinator::run_change_async(std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(change_mutex_);
+    if (change_running_) return false;
+    if (change_thread_.joinable()) change_thread_.join();  // finished earlier
+    change_running_ = true;
+    change_thread_ = std::thread([this, fn = std::move(fn)]() {
+        fn();
+        std::lock_guard<std::mutex> done_lock(change_mutex_);
+        change_running_ = false;
+    });
+    return true;
+}
+
+void Coordinator::on_ring_commit(const Rebalancer::Change& change) {
+    if (membership_ && change.node_id != node_id_) {
+        if (change.add) {
+            membership_->add_peer(change.node_id, change.address);
         } else {
-            // Timeout or error
-            if (response.empty()) {
-                ::close(conn->fd);
-                return format_error("NODE_TIMEOUT");
-            }
-            break;
+            membership_->remove_peer(change.node_id);
         }
     }
+    // Anti-entropy compares trees built over the same tokens.
+    if (anti_entropy_) {
+        engine_.attach_merkle(std::make_shared<MerkleIndex>(ring_.tokens()));
+    }
+    std::cout << "[REBALANCE] Ring now at version " << ring_.version() << " with "
+              << ring_.node_count() << " nodes\n";
+}
 
-    // Return connection to pool for reuse
-    pool_.release(std::move(*conn));
+// ── Phase 4: Legacy FWD forwarding ──────────────────────────────────────────
 
-    return response;
+std::string Coordinator::forward_to(const std::string& address,
+                                     const std::string& inner_line,
+                                     uint32_t hops) {
+    const char hop_byte = static_cast<char>(std::min<uint32_t>(hops, 255));
+    RpcResult r = rpc_->call_sync(address, BinaryOpcode::FWD,
+                                  std::string_view(&hop_byte, 1), {},
+                                  inner_line);
+
+    if (r.status == RpcStatus::TIMEOUT) return format_error("NODE_TIMEOUT");
+    if (r.status != RpcStatus::OK) return format_error("NODE_UNAVAILABLE");
+
+    BinaryFrame frame;
+    frame.opcode = r.opcode;
+    frame.value  = r.value;
+    std::string extras;
+    if (r.has_version) {
+        extras       = encode_version_extras(r.timestamp_ms, r.node_id);
+        frame.extras = extras;
+    }
+    return binary_response_to_text(frame);
 }
 
 std::string Coordinator::serialize_command_line(const Command& cmd) {
@@ -591,6 +1568,26 @@ std::string Coordinator::serialize_command_line(const Command& cmd) {
     }
 }
 
+void Coordinator::apply_local_write(const std::string& key,
+                                    const std::string& value,
+                                    bool is_del, const Version& version) {
+    WalRecord rec;
+    rec.timestamp_ms = version.timestamp_ms;
+    rec.op_type      = is_del ? OpType::DEL : OpType::SET;
+    rec.key          = key;
+    if (!is_del) rec.value = value;
+
+    if (wal_) wal_->append(rec);
+
+    if (is_del) {
+        engine_.del(key, version);
+    } else {
+        engine_.set(key, std::move(rec.value), version);
+    }
+    hot_keys_.invalidate(key, version);
+    maybe_snapshot();
+}
+
 void Coordinator::maybe_snapshot() {
     if (!wal_ || snapshot_dir_.empty()) return;
 
@@ -599,7 +1596,10 @@ void Coordinator::maybe_snapshot() {
         ops_since_snapshot_ = 0;
         uint64_t seq = wal_->current_seq_no();
         wal_->sync();
-        if (Snapshot::save(engine_, seq, snapshot_dir_)) {
+        busy_.fetch_add(1, std::memory_order_relaxed);
+        bool saved = Snapshot::save(engine_, seq, snapshot_dir_);
+        busy_.fetch_sub(1, std::memory_order_relaxed);
+        if (saved) {
             std::cout << "[SNAP] Snapshot saved at seq " << seq << "\n";
             wal_->truncate_before(seq);
         }
@@ -612,39 +1612,141 @@ void Coordinator::set_membership(Membership* membership) {
     membership_ = membership;
 }
 
+// ── Replication batching ────────────────────────────────────────────────────
+
+void Coordinator::set_replication_batching(size_t max_bytes,
+                                           uint32_t linger_us) {
+    rpc_->set_batching(max_bytes, linger_us);
+}
+
+RpcClient::BatchStats Coordinator::replication_batch_stats() const {
+    return rpc_->batch_stats();
+}
+
+// ── Hedged reads ────────────────────────────────────────────────────────────
+
+void Coordinator::set_read_hedging(bool enabled, uint32_t min_delay_us) {
+    hedge_min_delay_us_.store(min_delay_us, std::memory_order_relaxed);
+    hedge_reads_.store(enabled, std::memory_order_relaxed);
+}
+
+void Coordinator::record_read_latency(uint32_t micros) {
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    if (latency_samples_.size() < LATENCY_SAMPLES) {
+        latency_samples_.push_back(micros);
+    } else {
+        latency_samples_[latency_next_] = micros;
+        latency_next_ = (latency_next_ + 1) % LATENCY_SAMPLES;
+    }
+    if (++latency_seen_ % LATENCY_RECOMPUTE != 0) return;
+
+    std::vector<uint32_t> sorted = latency_samples_;
+    auto p95 = sorted.begin() + static_cast<std::ptrdiff_t>(
+        sorted.size() * 95 / 100);
+    std::nth_element(sorted.begin(), p95, sorted.end());
+    read_p95_us_.store(*p95, std::memory_order_relaxed);
+}
+
+std::chrono::microseconds Coordinator::hedge_delay() const {
+    // Until the first p95 is known, the floor alone decides.
+    uint32_t delay = std::max(read_p95_us_.load(std::memory_order_relaxed),
+                              hedge_min_delay_us_.load(std::memory_order_relaxed));
+    return std::chrono::microseconds(delay);
+}
+
 // ── Phase 5: Hinted handoff replay ──────────────────────────────────────────
 
+void Coordinator::schedule_hint_replay(uint32_t target_node_id,
+                                       const std::string& target_address) {
+    {
+        std::lock_guard<std::mutex> lock(replay_mutex_);
+        if (replay_stop_) return;
+        for (const auto& queued : replay_queue_) {
+            if (queued.first == target_node_id) return;
+        }
+        replay_queue_.emplace_back(target_node_id, target_address);
+        if (!replay_thread_.joinable()) {
+            replay_thread_ = std::thread([this] { replay_loop(); });
+        }
+    }
+    replay_cv_.notify_one();
+}
+
+void Coordinator::replay_loop() {
+    std::unique_lock<std::mutex> lock(replay_mutex_);
+    while (true) {
+        replay_cv_.wait(lock, [this] { return replay_stop_ || !replay_queue_.empty(); });
+        if (replay_stop_) return;
+        auto [node_id, address] = std::move(replay_queue_.front());
+        replay_queue_.pop_front();
+        lock.unlock();
+        replay_hints_for(node_id, address);
+        lock.lock();
+    }
+}
+
 void Coordinator::replay_hints_for(uint32_t target_node_id,
                                     const std::string& target_address) {
-    auto pending = hints_.get_hints_for(target_node_id);
-    if (pending.empty()) return;
+    if (hints_.size_for(target_node_id) == 0) return;
+    // One replay per target at a time; a second UP event while a replay is
+    // running has nothing to add.
+    if (!hints_.begin_replay(target_node_id)) return;
 
-    std::cout << "[HINT] Replaying " << pending.size()
+    std::cout << "[HINT] Replaying " << hints_.size_for(target_node_id)
               << " hints for node " << target_node_id
               << " at " << target_address << "\n";
 
-    bool all_ok = true;
-    for (const auto& hint : pending) {
+    // Stream the queue in windows of HINT_REPLAY_WINDOW writes.  Each window
+    // goes out at once (coalesced into RBATCH frames), every delivered hint
+    // is acknowledged individually, and the store checkpoints its progress.
+    // A failure ends the replay: the node is probably gone again, and the
+    // next one resumes after the last checkpoint.
+    size_t   delivered = 0;
+    size_t   failed    = 0;
+    uint64_t next      = 0;
+    while (failed == 0) {
+        auto window = hints_.next_for_replay(target_node_id, next,
+                                             HINT_REPLAY_WINDOW, next);
+        if (window.empty()) break;
+
         // Use the stored address but allow override with the current address
         // (the node might have a new IP after a restart).
         const std::string& addr = target_address.empty()
-                                      ? hint.target_address
+                                      ? window.front().hint.target_address
                                       : target_address;
-        bool ok = send_replication_write(addr, hint.key, hint.value,
-                                         hint.is_del, hint.version);
-        if (!ok) {
-            std::cerr << "[HINT] Replay failed for key '" << hint.key
-                      << "' to " << addr << "\n";
-            all_ok = false;
+        std::vector<std::shared_ptr<const std::string>> frames;
+        frames.reserve(window.size());
+        for (const auto& item : window) {
+            const Hint& h = item.hint;
+            frames.push_back(RpcClient::encode(
+                h.is_del ? BinaryOpcode::RDEL : BinaryOpcode::RSET,
+                encode_version_extras(h.version.timestamp_ms, h.version.node_id),
+                h.key, h.is_del ? std::string_view{} : std::string_view{h.value}));
         }
+
+        auto acked = send_writes(addr, std::move(frames));
+        std::vector<uint64_t> done;
+        for (size_t i = 0; i < window.size(); i++) {
+            if (acked[i]) {
+                done.push_back(window[i].seq);
+            } else {
+                ++failed;
+            }
+        }
+        delivered += done.size();
+        hints_.ack(target_node_id, done);
     }
+    hints_.end_replay(target_node_id);
 
-    if (all_ok) {
-        hints_.clear_hints_for(target_node_id);
+    if (failed == 0) {
         std::cout << "[HINT] All hints replayed and cleared for node "
-                  << target_node_id << "\n";
+                  << target_node_id << " (" << delivered << " sent)\n";
+    } else {
+        // Undelivered hints are kept for the next retry.
+        std::cerr << "[HINT] Replay to node " << target_node_id << " stopped: "
+                  << delivered << " delivered, " << failed << " failed, "
+                  << hints_.size_for(target_node_id) << " still pending\n";
     }
-    // If some replays failed, hints are kept for the next retry.
 }
 
 }  // namespace dkv
@@ -0,0 +1,103 @@
+#include "cluster/dynamic_snitch.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace dkv {
+
+void DynamicSnitch::begin(uint32_t node_id) {
+    std::lock_guard lock(mutex_);
+    peers_[node_id].outstanding++;
+}
+
+void DynamicSnitch::end(uint32_t node_id, std::chrono::microseconds elapsed, bool ok,
+                        bool busy, bool sample) {
+    std::lock_guard lock(mutex_);
+    Peer& p = peers_[node_id];
+    if (p.outstanding > 0) p.outstanding--;
+    if (ok) {
+        p.busy_until = busy ? now_() + std::chrono::milliseconds(options_.busy_hold_ms)
+                            : Clock::time_point{};
+    }
+    if (!sample && ok) return;
+
+    double us = static_cast<double>(elapsed.count());
+    if (!ok) us = std::max(us, 2 * p.ewma_us);
+    if (!p.sampled) {
+        p.ewma_us = us;
+        p.sampled = true;
+    } else {
+        p.ewma_us += options_.alpha * (us - p.ewma_us);
+    }
+}
+
+double DynamicSnitch::score_locked(uint32_t node_id, uint32_t self,
+                                   Clock::time_point now) const {
+    if (node_id == self) return 0;
+    auto it = peers_.find(node_id);
+    if (it == peers_.end()) return 1;
+    const Peer& p = it->second;
+    double s = (p.ewma_us + 1) * (1 + p.outstanding);
+    if (now < p.busy_until) s *= options_.busy_penalty;
+    return s;
+}
+
+ReplicaList DynamicSnitch::rank(ReplicaList replicas, size_t primaries,
+                                uint32_t self, std::vector<NodeInfo>& buf) {
+    const size_t n = replicas.size();
+    primaries = std::min(primaries, n);
+    if (n < 2 || primaries == 0) return replicas;
+
+    std::vector<double> scores(n);
+    {
+        std::lock_guard lock(mutex_);
+        if (options_.explore_every > 0 && ++reads_ % options_.explore_every == 0) {
+            stats_.explorations++;
+            return replicas;
+        }
+        const auto now = now_();
+        for (size_t i = 0; i < n; i++) scores[i] = score_locked(replicas[i].node_id, self, now);
+    }
+
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return scores[a] < scores[b]; });
+
+    // Keep the ring order unless its worst primary, or the replica that
+    // would serve the value, is clearly worse than the best choice.
+    const double slack = 1 + options_.badness_threshold;
+    double ring_worst = *std::max_element(scores.begin(), scores.begin() + primaries);
+    double best_worst = scores[order[primaries - 1]];
+    if (ring_worst <= slack * best_worst && scores[0] <= slack * scores[order[0]]) {
+        return replicas;
+    }
+
+    buf.clear();
+    buf.reserve(n);
+    for (size_t i : order) buf.push_back(replicas[i]);
+    std::lock_guard lock(mutex_);
+    stats_.reorders++;
+    return buf;
+}
+
+DynamicSnitch::Score DynamicSnitch::score(uint32_t node_id) const {
+    std::lock_guard lock(mutex_);
+    Score s;
+    auto it = peers_.find(node_id);
+    const auto now = now_();
+    if (it != peers_.end()) {
+        s.ewma_us     = it->second.ewma_us;
+        s.outstanding = it->second.outstanding;
+        s.busy        = now < it->second.busy_until;
+    }
+    s.score = score_locked(node_id, UINT32_MAX, now);
+    return s;
+}
+
+DynamicSnitch::Stats DynamicSnitch::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+}  // namespace dkv
@@ -0,0 +1,514 @@
+#include "cluster/gossip.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace dkv {
+
+namespace {
+
+void put_u32(std::string& out, uint32_t v) {
+    out.append(reinterpret_cast<const char*>(&v), 4);
+}
+
+uint32_t read_u32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+constexpr size_t HEADER_BYTES = 1 + 4 + 4 + 4 + 2;
+constexpr size_t UPDATE_BYTES = 4 + 1 + 4;
+
+NodeState to_node_state(Gossip::State s) {
+    switch (s) {
+        case Gossip::State::ALIVE:   return NodeState::UP;
+        case Gossip::State::SUSPECT: return NodeState::SUSPECTED;
+        case Gossip::State::DEAD:    return NodeState::DOWN;
+    }
+    return NodeState::UP;
+}
+
+}  // namespace
+
+// ── RpcGossipTransport ───────────────────────────────────────────────────────
+
+void RpcGossipTransport::request(const std::string& address, std::string payload,
+                                 std::chrono::milliseconds timeout, Done done) {
+    rpc_.call(address, RpcClient::encode(BinaryOpcode::GOSSIP, {}, {}, payload),
+              [done = std::move(done)](RpcResult r) {
+                  bool ok = r.ok();
+                  done(ok, ok ? std::move(r.value) : std::string{});
+              },
+              timeout);
+}
+
+// ── Wire format ──────────────────────────────────────────────────────────────
+//
+// [u8 type][u32 sender][u32 incarnation][u32 target][u16 count]
+// {[u32 node_id][u8 state][u32 incarnation]}
+
+std::string Gossip::encode(const Message& m) {
+    std::string out;
+    out.reserve(HEADER_BYTES + m.updates.size() * UPDATE_BYTES);
+    out.push_back(static_cast<char>(m.type));
+    put_u32(out, m.sender);
+    put_u32(out, m.incarnation);
+    put_u32(out, m.target);
+    uint16_t count = static_cast<uint16_t>(std::min<size_t>(m.updates.size(), UINT16_MAX));
+    out.append(reinterpret_cast<const char*>(&count), 2);
+    for (size_t i = 0; i < count; i++) {
+        const Update& u = m.updates[i];
+        put_u32(out, u.node_id);
+        out.push_back(static_cast<char>(u.state));
+        put_u32(out, u.incarnation);
+    }
+    return out;
+}
+
+bool Gossip::decode(std::string_view payload, Message& m) {
+    if (payload.size() < HEADER_BYTES) return false;
+    const char* p = payload.data();
+    uint8_t type = static_cast<uint8_t>(p[0]);
+    if (type < static_cast<uint8_t>(Type::PING) || type > static_cast<uint8_t>(Type::NACK)) {
+        return false;
+    }
+    m.type        = static_cast<Type>(type);
+    m.sender      = read_u32(p + 1);
+    m.incarnation = read_u32(p + 5);
+    m.target      = read_u32(p + 9);
+    uint16_t count;
+    std::memcpy(&count, p + 13, 2);
+    if (payload.size() != HEADER_BYTES + size_t{count} * UPDATE_BYTES) return false;
+
+    m.updates.clear();
+    m.updates.reserve(count);
+    p += HEADER_BYTES;
+    for (uint16_t i = 0; i < count; i++, p += UPDATE_BYTES) {
+        uint8_t state = static_cast<uint8_t>(p[4]);
+        if (state > static_cast<uint8_t>(State::DEAD)) return false;
+        m.updates.push_back(Update{read_u32(p), static_cast<State>(state), read_u32(p + 5)});
+    }
+    return true;
+}
+
+// ── Gossip ───────────────────────────────────────────────────────────────────
+
+Gossip::Gossip(Membership& membership, GossipTransport& transport, uint32_t node_id,
+               Options options)
+    : membership_(membership),
+      transport_(transport),
+      node_id_(node_id),
+      options_(options),
+      rng_(options.seed ? options.seed : std::random_device{}()) {}
+
+Gossip::~Gossip() {
+    stop();
+}
+
+void Gossip::start() {
+    std::lock_guard lock(mutex_);
+    if (running_) return;
+    running_ = true;
+    thread_  = std::thread([this] { run(); });
+}
+
+void Gossip::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void Gossip::run() {
+    const auto period = std::chrono::milliseconds(options_.period_ms);
+    auto next = Clock::now();
+    std::unique_lock lock(mutex_);
+    while (running_) {
+        if (Clock::now() >= next) {
+            next = std::max(next + period, Clock::now());
+            lock.unlock();
+            tick();
+            lock.lock();
+            continue;
+        }
+        // Wake early to apply Membership changes decided by replies.
+        cv_.wait_until(lock, next, [&] { return !running_ || !effects_.empty(); });
+        if (!effects_.empty()) {
+            lock.unlock();
+            apply_pending();
+            lock.lock();
+        }
+    }
+}
+
+void Gossip::tick() {
+    auto peers = membership_.all_peers();
+
+    uint32_t    target = 0;
+    std::string address;
+    {
+        std::lock_guard lock(mutex_);
+        sync_locked(peers);
+
+        // Suspects that did not refute in time are DEAD.
+        const auto now = now_();
+        const auto timeout = suspicion_timeout_locked();
+        for (auto& [id, m] : members_) {
+            if (m.state != State::SUSPECT || now - m.suspect_since < timeout) continue;
+            m.state = State::DEAD;
+            stats_.deaths++;
+            broadcast_locked(Update{id, State::DEAD, m.incarnation});
+            effects_.push_back(Effect{id, NodeState::DOWN});
+        }
+
+        // Next member of the shuffled round-robin (reshuffled every pass).
+        for (size_t tries = 0; tries <= members_.size() && address.empty(); tries++) {
+            if (probe_next_ >= probe_order_.size()) {
+                probe_order_.clear();
+                for (const auto& [id, m] : members_) probe_order_.push_back(id);
+                std::sort(probe_order_.begin(), probe_order_.end());
+                std::shuffle(probe_order_.begin(), probe_order_.end(), rng_);
+                probe_next_ = 0;
+                if (probe_order_.empty()) break;
+            }
+            uint32_t id = probe_order_[probe_next_++];
+            auto it = members_.find(id);
+            if (it == members_.end()) continue;
+            target  = id;
+            address = it->second.address;
+        }
+    }
+
+    apply_pending();
+    if (!address.empty()) probe(target, address);
+}
+
+void Gossip::apply_pending() {
+    std::vector<Effect> effects;
+    {
+        std::lock_guard lock(mutex_);
+        effects.swap(effects_);
+    }
+    for (const auto& e : effects) {
+        if (e.state == NodeState::UP) {
+            membership_.record_success(e.node_id);
+        } else {
+            membership_.set_state(e.node_id, e.state);
+        }
+    }
+}
+
+void Gossip::probe(uint32_t target, const std::string& address) {
+    {
+        std::lock_guard lock(mutex_);
+        stats_.probes++;
+    }
+    Message ping;
+    ping.type = Type::PING;
+    send(target, address, std::move(ping),
+         std::chrono::milliseconds(options_.probe_timeout_ms),
+         [this, target](bool ok, std::string reply) {
+        Message ack;
+        std::unique_lock lock(mutex_);
+        if (ok && decode(reply, ack)) {
+            absorb_locked(ack);
+            if (ack.type == Type::ACK) {
+                alive_locked(target);
+                return;
+            }
+        }
+
+        // No direct answer: ask k others to try (a DEAD member is only
+        // probed directly, to notice it coming back).
+        auto it = members_.find(target);
+        if (it == members_.end() || it->second.state == State::DEAD) return;
+        auto helpers = pick_locked(options_.indirect_probes, target, node_id_);
+        if (helpers.empty()) {
+            suspect_locked(target);
+            return;
+        }
+        stats_.indirect_probes += helpers.size();
+        lock.unlock();
+
+        struct Indirect {
+            size_t remaining;
+            bool   acked = false;
+        };
+        auto st = std::make_shared<Indirect>(Indirect{helpers.size()});
+        auto timeout = std::chrono::milliseconds(
+            std::max(options_.period_ms - options_.probe_timeout_ms,
+                     2 * options_.probe_timeout_ms));
+        for (auto& [helper, helper_address] : helpers) {
+            Message req;
+            req.type   = Type::PINGREQ;
+            req.target = target;
+            send(helper, helper_address, std::move(req), timeout,
+                 [this, target, st](bool ok, std::string reply) {
+                Message r;
+                std::lock_guard lock(mutex_);
+                bool acked = false;
+                if (ok && decode(reply, r)) {
+                    absorb_locked(r);
+                    acked = r.type == Type::ACK;
+                }
+                if (acked && !st->acked) {
+                    st->acked = true;
+                    alive_locked(target);
+                }
+                if (--st->remaining == 0 && !st->acked) suspect_locked(target);
+            });
+        }
+    });
+}
+
+void Gossip::serve(std::string_view payload, std::function<void(std::string)> reply) {
+    Message m;
+    if (!decode(payload, m) || m.type == Type::ACK || m.type == Type::NACK) {
+        reply({});
+        return;
+    }
+
+    if (m.type == Type::PING) {
+        std::string out;
+        {
+            std::lock_guard lock(mutex_);
+            absorb_locked(m);
+            Message ack;
+            ack.type        = Type::ACK;
+            ack.sender      = node_id_;
+            ack.incarnation = incarnation_;
+            piggyback_locked(ack, m.sender);
+            stats_.messages_sent++;
+            out = encode(ack);
+        }
+        cv_.notify_all();
+        reply(std::move(out));
+        return;
+    }
+
+    // PINGREQ: probe the target for the sender and relay the outcome.
+    std::string address;
+    {
+        std::lock_guard lock(mutex_);
+        absorb_locked(m);
+        auto it = members_.find(m.target);
+        if (it != members_.end()) address = it->second.address;
+    }
+    cv_.notify_all();
+    auto respond = [this, sender = m.sender, reply](bool acked) {
+        std::string out;
+        {
+            std::lock_guard lock(mutex_);
+            Message r;
+            r.type        = acked ? Type::ACK : Type::NACK;
+            r.sender      = node_id_;
+            r.incarnation = incarnation_;
+            piggyback_locked(r, sender);
+            stats_.messages_sent++;
+            out = encode(r);
+        }
+        reply(std::move(out));
+    };
+    if (address.empty()) {
+        respond(false);
+        return;
+    }
+    Message ping;
+    ping.type = Type::PING;
+    send(m.target, address, std::move(ping),
+         std::chrono::milliseconds(options_.probe_timeout_ms),
+         [this, respond, target = m.target](bool ok, std::string r) {
+        Message ack;
+        bool acked = false;
+        if (ok && decode(r, ack)) {
+            std::lock_guard lock(mutex_);
+            absorb_locked(ack);
+            acked = ack.type == Type::ACK;
+            if (acked) alive_locked(target);
+        }
+        cv_.notify_all();
+        respond(acked);
+    });
+}
+
+void Gossip::send(uint32_t to, const std::string& address, Message m,
+                  std::chrono::milliseconds timeout, GossipTransport::Done done) {
+    std::string payload;
+    {
+        std::lock_guard lock(mutex_);
+        m.sender      = node_id_;
+        m.incarnation = incarnation_;
+        piggyback_locked(m, to);
+        stats_.messages_sent++;
+        payload = encode(m);
+    }
+    transport_.request(address, std::move(payload), timeout,
+                       [this, done = std::move(done)](bool ok, std::string reply) {
+        done(ok, std::move(reply));
+        cv_.notify_all();
+    });
+}
+
+void Gossip::piggyback_locked(Message& m, uint32_t to) {
+    m.updates.clear();
+
+    // Tell the recipient what we think of it, so it can refute.
+    auto self = members_.find(to);
+    if (self != members_.end() && self->second.state != State::ALIVE) {
+        m.updates.push_back(Update{to, self->second.state, self->second.incarnation});
+    }
+
+    // Then the freshest news: fewest transmissions first.
+    std::vector<Broadcast*> queue;
+    queue.reserve(broadcasts_.size());
+    for (auto& [id, b] : broadcasts_) queue.push_back(&b);
+    size_t room = options_.max_piggyback > m.updates.size()
+                      ? options_.max_piggyback - m.updates.size() : 0;
+    size_t n = std::min(room, queue.size());
+    std::partial_sort(queue.begin(), queue.begin() + n, queue.end(),
+                      [](const Broadcast* a, const Broadcast* b) {
+                          if (a->transmits != b->transmits) return a->transmits < b->transmits;
+                          return a->update.node_id < b->update.node_id;
+                      });
+    const uint32_t limit = retransmit_limit_locked();
+    std::vector<uint32_t> spent;
+    for (size_t i = 0; i < n; i++) {
+        m.updates.push_back(queue[i]->update);
+        if (++queue[i]->transmits >= limit) spent.push_back(queue[i]->update.node_id);
+    }
+    for (uint32_t id : spent) broadcasts_.erase(id);
+}
+
+void Gossip::absorb_locked(const Message& m) {
+    // The sender is alive at the incarnation it states.
+    if (m.sender != node_id_) apply_locked(Update{m.sender, State::ALIVE, m.incarnation});
+    for (const auto& u : m.updates) apply_locked(u);
+}
+
+void Gossip::apply_locked(const Update& u) {
+    if (u.node_id == node_id_) {
+        // A rumour that we are suspect or dead: refute it.
+        if (u.state != State::ALIVE && u.incarnation >= incarnation_) {
+            incarnation_ = u.incarnation + 1;
+            stats_.refutations++;
+            broadcast_locked(Update{node_id_, State::ALIVE, incarnation_});
+        }
+        return;
+    }
+
+    auto it = members_.find(u.node_id);
+    if (it == members_.end()) return;  // ring membership is not gossiped
+    Member& m = it->second;
+
+    bool news = false;
+    switch (u.state) {
+        case State::ALIVE:
+            news = u.incarnation > m.incarnation;
+            break;
+        case State::SUSPECT:
+            news = (m.state == State::ALIVE && u.incarnation >= m.incarnation) ||
+                   (m.state == State::SUSPECT && u.incarnation > m.incarnation);
+            break;
+        case State::DEAD:
+            news = (m.state != State::DEAD && u.incarnation >= m.incarnation) ||
+                   u.incarnation > m.incarnation;
+            break;
+    }
+    if (!news) return;
+
+    bool changed = m.state != u.state;
+    if (u.state == State::SUSPECT && changed) m.suspect_since = now_();
+    m.state       = u.state;
+    m.incarnation = u.incarnation;
+    broadcast_locked(u);
+    if (changed) effects_.push_back(Effect{u.node_id, to_node_state(u.state)});
+}
+
+void Gossip::suspect_locked(uint32_t target) {
+    auto it = members_.find(target);
+    if (it == members_.end() || it->second.state != State::ALIVE) return;
+    stats_.suspicions++;
+    apply_locked(Update{target, State::SUSPECT, it->second.incarnation});
+}
+
+void Gossip::alive_locked(uint32_t target) {
+    auto it = members_.find(target);
+    if (it == members_.end()) return;
+    // A direct answer is fresh evidence for Membership, but changes the
+    // gossip state only through the incarnation it carries (absorbed
+    // already): a suspect has to refute.
+    if (it->second.state == State::ALIVE) {
+        effects_.push_back(Effect{target, NodeState::UP});
+    }
+}
+
+void Gossip::broadcast_locked(const Update& u) {
+    broadcasts_[u.node_id] = Broadcast{u, 0};
+}
+
+std::vector<std::pair<uint32_t, std::string>> Gossip::pick_locked(size_t k, uint32_t a,
+                                                                  uint32_t b) {
+    std::vector<std::pair<uint32_t, std::string>> out;
+    for (const auto& [id, m] : members_) {
+        if (id != a && id != b && m.state == State::ALIVE) out.emplace_back(id, m.address);
+    }
+    std::sort(out.begin(), out.end());
+    std::shuffle(out.begin(), out.end(), rng_);
+    if (out.size() > k) out.resize(k);
+    return out;
+}
+
+void Gossip::sync_locked(const std::vector<NodeStatus>& peers) {
+    std::unordered_map<uint32_t, const NodeStatus*> listed;
+    for (const auto& p : peers) {
+        if (p.node_id != node_id_) listed[p.node_id] = &p;
+    }
+    for (auto it = members_.begin(); it != members_.end(); ) {
+        if (!listed.count(it->first)) {
+            broadcasts_.erase(it->first);
+            it = members_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const auto& [id, p] : listed) {
+        auto [it, added] = members_.try_emplace(id);
+        it->second.address = p->address;
+    }
+}
+
+Gossip::Clock::duration Gossip::suspicion_timeout_locked() const {
+    double n = static_cast<double>(members_.size() + 1);
+    double periods = options_.suspicion_mult * std::max(1.0, std::log10(n));
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(periods * options_.period_ms));
+}
+
+uint32_t Gossip::retransmit_limit_locked() const {
+    double n = static_cast<double>(members_.size() + 1);
+    return options_.retransmit_mult *
+           static_cast<uint32_t>(std::max(1.0, std::ceil(std::log10(n + 1))));
+}
+
+Gossip::State Gossip::state_of(uint32_t node_id) const {
+    std::lock_guard lock(mutex_);
+    auto it = members_.find(node_id);
+    return it == members_.end() ? State::ALIVE : it->second.state;
+}
+
+uint32_t Gossip::incarnation() const {
+    std::lock_guard lock(mutex_);
+    return incarnation_;
+}
+
+Gossip::Stats Gossip::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+}  // namespace dkv
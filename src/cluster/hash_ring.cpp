@@ -1,36 +1,135 @@
 #include "cluster/hash_ring.h"
 #include "utils/murmurhash3.h"
 
+#include <algorithm>
 #include <iostream>
+#include <utility>
 
 namespace dkv {
 
-void HashRing::add_node(uint32_t node_id, const std::string& address,
-                        uint32_t num_vnodes) {
-    nodes_[node_id] = address;
+// ── RingSnapshot ─────────────────────────────────────────────────────────────
+
+namespace {
+
+/// In-order walk of the implicit tree rooted at slot k, filling it with the
+/// sorted tokens: the result is the Eytzinger layout.
+void fill_eytzinger(const std::vector<uint64_t>& sorted, size_t& next, size_t k,
+                    std::vector<uint64_t>& eyt, std::vector<uint32_t>& rank) {
+    if (k > sorted.size()) return;
+    fill_eytzinger(sorted, next, 2 * k, eyt, rank);
+    eyt[k]  = sorted[next];
+    rank[k] = static_cast<uint32_t>(next);
+    ++next;
+    fill_eytzinger(sorted, next, 2 * k + 1, eyt, rank);
+}
+
+}  // namespace
+
+RingSnapshot::RingSnapshot(const std::map<uint64_t, uint32_t>& ring,
+                           const std::unordered_map<uint32_t, std::string>& nodes,
+                           uint64_t version)
+    : version_(version) {
+    nodes_.reserve(nodes.size());
+    for (const auto& [id, address] : nodes) nodes_.push_back(NodeInfo{id, address});
+    std::sort(nodes_.begin(), nodes_.end(), [](const NodeInfo& a, const NodeInfo& b) {
+        return a.node_id < b.node_id;
+    });
+
+    tokens_.reserve(ring.size());
+    owners_.reserve(ring.size());
+    for (const auto& [pos, id] : ring) {
+        auto it = std::lower_bound(nodes_.begin(), nodes_.end(), id,
+                                   [](const NodeInfo& n, uint32_t v) {
+                                       return n.node_id < v;
+                                   });
+        tokens_.push_back(pos);
+        owners_.push_back(static_cast<uint32_t>(it - nodes_.begin()));
+    }
+
+    const size_t n = tokens_.size();
+    eytzinger_.assign(n + 1, 0);
+    rank_.assign(n + 1, 0);
+    size_t next = 0;
+    fill_eytzinger(tokens_, next, 1, eytzinger_, rank_);
+
+    // Preference list per token: distinct nodes clockwise from it.
+    depth_ = std::min(nodes_.size(), MAX_REPLICAS);
+    lists_.reserve(n * depth_);
+    std::vector<uint32_t> seen;
+    for (size_t i = 0; i < n; i++) {
+        seen.clear();
+        for (size_t j = i, walked = 0; seen.size() < depth_ && walked < n; walked++) {
+            uint32_t owner = owners_[j];
+            if (std::find(seen.begin(), seen.end(), owner) == seen.end()) {
+                seen.push_back(owner);
+                lists_.push_back(owner);
+            }
+            if (++j == n) j = 0;
+        }
+    }
+}
 
-    NodeInfo info{node_id, address};
+size_t RingSnapshot::token_index(uint64_t position) const {
+    // Branch-free upper_bound over the Eytzinger array: descend right while
+    // the slot is <= position; the answer is the last slot where we went
+    // left, recovered by dropping the trailing right-turns from k.
+    const uint64_t* eyt = eytzinger_.data();
+    const size_t n = tokens_.size();
+    size_t k = 1;
+    while (k <= n) {
+        // Slots 8k..8k+7 are k's descendants three levels down: one line.
+        if (8 * k <= n) __builtin_prefetch(eyt + 8 * k);
+        k = 2 * k + (eyt[k] <= position);
+    }
+    k >>= __builtin_ffsll(static_cast<long long>(~k));
+    return k == 0 ? 0 : rank_[k];  // none above: wrap to the first token
+}
+
+ReplicaList RingSnapshot::replicas_at(uint64_t position, size_t count) const {
+    if (tokens_.empty()) return {};
+    const size_t i = token_index(position);
+    return {lists_.data() + i * depth_, nodes_.data(), std::min(count, depth_)};
+}
 
+// ── HashRing ─────────────────────────────────────────────────────────────────
+
+HashRing::HashRing(std::chrono::milliseconds retire_grace)
+    : retire_grace_(retire_grace) {
+    current_owner_ = std::make_unique<const RingSnapshot>();
+    current_.store(current_owner_.get(), std::memory_order_release);
+}
+
+void HashRing::place_tokens(std::map<uint64_t, uint32_t>& ring,
+                            uint32_t node_id, uint32_t num_vnodes) {
     for (uint32_t i = 0; i < num_vnodes; i++) {
         // Hash "node_id:vnode_index" to get the ring position
         std::string vnode_key = std::to_string(node_id) + ":" + std::to_string(i);
         uint64_t hash = murmurhash3(vnode_key);
 
-        if (ring_.count(hash)) {
+        if (ring.count(hash)) {
             std::cerr << "[RING] Hash collision at position " << hash
                       << " for node " << node_id << " vnode " << i
                       << " — skipping\n";
             continue;
         }
 
-        ring_[hash] = info;
+        ring[hash] = node_id;
     }
 }
 
+void HashRing::add_node(uint32_t node_id, const std::string& address,
+                        uint32_t num_vnodes) {
+    std::lock_guard lock(writer_mutex_);
+    nodes_[node_id] = address;
+    place_tokens(ring_, node_id, num_vnodes);
+    publish_locked();
+}
+
 void HashRing::remove_node(uint32_t node_id) {
+    std::lock_guard lock(writer_mutex_);
     // Erase all ring entries belonging to this node
     for (auto it = ring_.begin(); it != ring_.end(); ) {
-        if (it->second.node_id == node_id) {
+        if (it->second == node_id) {
             it = ring_.erase(it);
         } else {
             ++it;
@@ -38,60 +137,129 @@ void HashRing::remove_node(uint32_t node_id) {
     }
 
     nodes_.erase(node_id);
+    publish_locked();
 }
 
-std::optional<NodeInfo> HashRing::get_node(const std::string& key) const {
-    if (ring_.empty()) return std::nullopt;
+void HashRing::publish_locked() {
+    auto snap = std::make_unique<const RingSnapshot>(ring_, nodes_, ++version_);
+    current_.store(snap.get(), std::memory_order_release);
+    retire_locked(std::exchange(current_owner_, std::move(snap)));
+}
 
-    uint64_t hash = murmurhash3(key);
+void HashRing::retire_locked(std::unique_ptr<const RingSnapshot> snap) {
+    if (!snap) return;
+    const auto now = std::chrono::steady_clock::now();
+    retired_.push_back(Retired{std::move(snap), now});
+    // A burst of changes keeps everything for the grace period; a reader
+    // holding a list that long would be stuck anyway.
+    while (retired_.size() > RETIRED_SNAPSHOTS &&
+           now - retired_.front().at >= retire_grace_) {
+        retired_.pop_front();
+    }
+}
 
-    // Walk clockwise: find the first node with position > hash
-    auto it = ring_.upper_bound(hash);
-    if (it == ring_.end()) {
-        // Wrap around to the beginning of the ring
-        it = ring_.begin();
+size_t HashRing::retired_count() const {
+    std::lock_guard lock(writer_mutex_);
+    return retired_.size();
+}
+
+bool HashRing::stage_add(uint32_t node_id, const std::string& address,
+                         uint32_t num_vnodes) {
+    std::lock_guard lock(writer_mutex_);
+    if (nodes_.count(node_id)) return false;
+    staged_ring_  = ring_;
+    staged_nodes_ = nodes_;
+    staged_nodes_[node_id] = address;
+    place_tokens(staged_ring_, node_id, num_vnodes);
+    stage_locked();
+    return true;
+}
+
+bool HashRing::stage_remove(uint32_t node_id) {
+    std::lock_guard lock(writer_mutex_);
+    if (!nodes_.count(node_id)) return false;
+    staged_ring_.clear();
+    for (const auto& [pos, id] : ring_) {
+        if (id != node_id) staged_ring_.emplace_hint(staged_ring_.end(), pos, id);
     }
+    staged_nodes_ = nodes_;
+    staged_nodes_.erase(node_id);
+    stage_locked();
+    return true;
+}
+
+void HashRing::stage_locked() {
+    // Versioned as the ring it will become, so both sides of a handover
+    // agree on the number.
+    auto snap = std::make_unique<const RingSnapshot>(staged_ring_, staged_nodes_,
+                                                     version_ + 1);
+    pending_.store(snap.get(), std::memory_order_release);
+    retire_locked(std::exchange(pending_owner_, std::move(snap)));
+}
 
-    return it->second;
+bool HashRing::commit_pending() {
+    std::lock_guard lock(writer_mutex_);
+    const RingSnapshot* staged = pending_.load(std::memory_order_relaxed);
+    if (!staged) return false;
+    ring_  = std::move(staged_ring_);
+    nodes_ = std::move(staged_nodes_);
+    staged_ring_.clear();
+    staged_nodes_.clear();
+    // The staged snapshot already describes the new ring: publish it as is.
+    ++version_;
+    current_.store(staged, std::memory_order_release);
+    pending_.store(nullptr, std::memory_order_release);
+    retire_locked(std::exchange(current_owner_, std::move(pending_owner_)));
+    return true;
 }
 
-std::vector<NodeInfo> HashRing::get_replica_nodes(const std::string& key,
-                                                   size_t count) const {
-    std::vector<NodeInfo> result;
-    if (ring_.empty()) return result;
+void HashRing::abort_pending() {
+    std::lock_guard lock(writer_mutex_);
+    staged_ring_.clear();
+    staged_nodes_.clear();
+    pending_.store(nullptr, std::memory_order_release);
+    retire_locked(std::move(pending_owner_));
+}
 
-    // Can't return more distinct physical nodes than exist
-    size_t max_nodes = nodes_.size();
-    if (count > max_nodes) count = max_nodes;
+std::optional<NodeInfo> HashRing::get_node(const std::string& key) const {
+    auto replicas = snapshot().replicas_at(murmurhash3(key), 1);
+    if (replicas.empty()) return std::nullopt;
+    return replicas[0];
+}
 
-    uint64_t hash = murmurhash3(key);
-    auto it = ring_.upper_bound(hash);
-    if (it == ring_.end()) it = ring_.begin();
+ReplicaList HashRing::get_replica_nodes(const std::string& key,
+                                        size_t count) const {
+    return snapshot().replicas_at(murmurhash3(key), count);
+}
 
-    // Walk clockwise, collecting distinct physical nodes
-    size_t visited = 0;
-    while (result.size() < count) {
-        // Check if we already have this physical node
-        bool already_have = false;
-        for (const auto& n : result) {
-            if (n.node_id == it->second.node_id) {
-                already_have = true;
-                break;
-            }
-        }
+ReplicaList HashRing::replicas_at(uint64_t position, size_t count) const {
+    return snapshot().replicas_at(position, count);
+}
 
-        if (!already_have) {
-            result.push_back(it->second);
-        }
+std::vector<uint64_t> HashRing::tokens() const {
+    return snapshot().tokens();
+}
+
+std::vector<NodeInfo> HashRing::nodes() const {
+    return snapshot().nodes();
+}
 
-        ++it;
-        if (it == ring_.end()) it = ring_.begin();
+std::string HashRing::encode_topology(uint32_t replication_factor) const {
+    const RingSnapshot& snap = snapshot();
 
-        ++visited;
-        if (visited >= ring_.size()) break;  // full loop, no more unique nodes
+    std::string out;
+    out.reserve(32 + snap.node_count() * 24 + snap.size() * 24);
+    out += std::to_string(snap.version()) + " " + std::to_string(replication_factor) +
+           " " + std::to_string(snap.node_count());
+    for (const auto& n : snap.nodes()) {
+        out += " " + std::to_string(n.node_id) + " " + n.address;
     }
-
-    return result;
+    out += " " + std::to_string(snap.size());
+    for (size_t i = 0; i < snap.size(); i++) {
+        out += " " + std::to_string(snap.tokens()[i]) + " " +
+               std::to_string(snap.owners()[i]);
+    }
+    return out;
 }
 
 }  // namespace dkv
@@ -1,17 +1,26 @@
 #include "cluster/heartbeat.h"
 
 #include <arpa/inet.h>
-#include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <poll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
-#include <iostream>
+#include <unordered_set>
 
 namespace dkv {
 
+namespace {
+
+constexpr char k_ping[] = "PING\n";
+constexpr int  POLL_SLICE_MS = 50;  // keeps stop() responsive
+
+}  // namespace
+
 Heartbeat::Heartbeat(Membership& membership, uint32_t node_id,
                      int interval_ms, int timeout_ms)
     : membership_(membership),
@@ -33,107 +42,265 @@ void Heartbeat::stop() {
     if (thread_.joinable()) thread_.join();
 }
 
+Heartbeat::Stats Heartbeat::stats() const {
+    Stats s;
+    s.rounds        = rounds_.load(std::memory_order_relaxed);
+    s.probes        = pings_.load(std::memory_order_relaxed);
+    s.failures      = failures_.load(std::memory_order_relaxed);
+    s.connects      = connects_.load(std::memory_order_relaxed);
+    s.last_round_us = last_round_us_.load(std::memory_order_relaxed);
+    return s;
+}
+
 void Heartbeat::run() {
     while (running_.load()) {
-        auto peers = membership_.all_peers();
+        auto started = Clock::now();
+        round();
 
-        for (const auto& peer : peers) {
-            if (!running_.load()) break;
-            if (peer.node_id == node_id_) continue;  // skip self
+        // Rounds start every interval_ms; sleep in small increments so
+        // stop() is responsive.
+        auto next = started + std::chrono::milliseconds(interval_ms_);
+        while (running_.load() && Clock::now() < next) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                next - Clock::now());
+            std::this_thread::sleep_for(
+                std::min(left, std::chrono::milliseconds(POLL_SLICE_MS)));
+        }
+    }
 
-            bool alive = ping_node(peer.address);
-            if (alive) {
-                membership_.record_success(peer.node_id);
-            } else {
-                membership_.record_failure(peer.node_id);
-            }
+    for (auto& [id, p] : probes_) close(p);
+    probes_.clear();
+}
+
+void Heartbeat::round() {
+    const auto started  = Clock::now();
+    const auto deadline = started + std::chrono::milliseconds(timeout_ms_);
+
+    // Sync the connection table with the membership list.
+    auto peers = membership_.all_peers();
+    std::unordered_set<uint32_t> listed;
+    std::vector<Probe*> active;
+    std::vector<uint32_t> failed;
+    std::vector<std::pair<uint32_t, std::chrono::microseconds>> answered;
+
+    for (const auto& peer : peers) {
+        if (peer.node_id == node_id_) continue;  // skip self
+        listed.insert(peer.node_id);
+
+        Probe& p = probes_[peer.node_id];
+        if (p.address != peer.address) {
+            close(p);
+            p.node_id = peer.node_id;
+            p.address = peer.address;
         }
+        if (p.fd >= 0 && !idle_ok(p)) close(p);  // peer closed it meanwhile
+        p.reused  = p.fd >= 0;
+        p.retried = false;
 
-        // Sleep in small increments so stop() is responsive.
-        int elapsed = 0;
-        while (running_.load() && elapsed < interval_ms_) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            elapsed += 50;
+        if (send_ping(p)) {
+            active.push_back(&p);
+        } else {
+            failed.push_back(p.node_id);
+        }
+    }
+    for (auto it = probes_.begin(); it != probes_.end(); ) {
+        if (!listed.count(it->first)) {
+            close(it->second);
+            it = probes_.erase(it);
+        } else {
+            ++it;
         }
     }
+
+    // A connection that was open before this round may simply have gone
+    // stale (the peer restarted): retry such a probe once on a fresh one.
+    auto give_up = [&](Probe& p) {
+        close(p);
+        if (p.reused && !p.retried && Clock::now() < deadline) {
+            p.reused  = false;
+            p.retried = true;
+            if (send_ping(p)) return;
+        }
+        p.waiting = false;
+        failed.push_back(p.node_id);
+    };
+
+    std::vector<pollfd> fds;
+    std::vector<Probe*> polled;
+    while (running_.load()) {
+        fds.clear();
+        polled.clear();
+        for (Probe* p : active) {
+            if (!p->waiting) continue;
+            short events = POLLIN;
+            if (!p->connected || !p->out.empty()) events |= POLLOUT;
+            fds.push_back(pollfd{p->fd, events, 0});
+            polled.push_back(p);
+        }
+        if (fds.empty()) break;
+
+        auto now = Clock::now();
+        if (now >= deadline) break;
+        int wait_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - now).count()) + 1;
+        int n = ::poll(fds.data(), fds.size(), std::min(wait_ms, POLL_SLICE_MS));
+        if (n < 0 && errno != EINTR) break;
+        if (n <= 0) continue;
+
+        for (size_t i = 0; i < fds.size(); i++) {
+            Probe& p = *polled[i];
+            short re = fds[i].revents;
+            if (!re) continue;
+
+            if (!p.connected) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                ::getsockopt(p.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0 || !(re & POLLOUT)) {
+                    give_up(p);
+                    continue;
+                }
+                p.connected = true;
+            }
+            if (!p.out.empty() && !flush(p)) {
+                give_up(p);
+                continue;
+            }
+            if (re & (POLLIN | POLLHUP | POLLERR)) {
+                bool done = false;
+                if (!receive(p, done)) {
+                    give_up(p);
+                } else if (done) {
+                    p.waiting = false;
+                    answered.emplace_back(
+                        p.node_id, std::chrono::duration_cast<std::chrono::microseconds>(
+                                       Clock::now() - p.sent_at));
+                }
+            }
+        }
+    }
+
+    // No PONG in time: the connection may have a late reply queued, so
+    // drop it rather than mistake that reply for the next round's.  A round
+    // cut short by stop() proves nothing about the peers still pending.
+    const bool finished = running_.load();
+    for (Probe* p : active) {
+        if (!p->waiting) continue;
+        close(*p);
+        p->waiting = false;
+        if (finished) failed.push_back(p->node_id);
+    }
+
+    // Report after the round so callbacks (hint replay on rejoin) do not
+    // skew the RTTs of the probes still in flight.
+    for (const auto& [id, rtt] : answered) {
+        membership_.record_rtt(id, rtt);
+        membership_.record_success(id);
+    }
+    for (uint32_t id : failed) membership_.record_failure(id);
+
+    rounds_.fetch_add(1, std::memory_order_relaxed);
+    failures_.fetch_add(failed.size(), std::memory_order_relaxed);
+    last_round_us_.store(static_cast<uint64_t>(
+                             std::chrono::duration_cast<std::chrono::microseconds>(
+                                 Clock::now() - started).count()),
+                         std::memory_order_relaxed);
+}
+
+bool Heartbeat::send_ping(Probe& p) {
+    if (p.fd < 0 && !open(p)) return false;
+    p.out.assign(k_ping, sizeof(k_ping) - 1);
+    p.in.clear();
+    p.waiting = true;
+    p.sent_at = Clock::now();
+    pings_.fetch_add(1, std::memory_order_relaxed);
+    if (p.connected && !flush(p)) {
+        close(p);
+        p.waiting = false;
+        return false;
+    }
+    return true;
 }
 
-bool Heartbeat::ping_node(const std::string& address) const {
+bool Heartbeat::open(Probe& p) {
     // Parse "host:port"
-    auto colon = address.rfind(':');
+    auto colon = p.address.rfind(':');
     if (colon == std::string::npos) return false;
 
-    std::string host = address.substr(0, colon);
+    std::string host = p.address.substr(0, colon);
     int port = 0;
     try {
-        port = std::stoi(address.substr(colon + 1));
+        port = std::stoi(p.address.substr(colon + 1));
     } catch (...) {
         return false;
     }
 
-    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
-    if (fd < 0) return false;
-
-    // Non-blocking connect with timeout
-    int flags = ::fcntl(fd, F_GETFL, 0);
-    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
-
     struct sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_port   = htons(static_cast<uint16_t>(port));
-    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) <= 0) {
-        ::close(fd);
-        return false;
-    }
+    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) <= 0) return false;
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
 
     int ret = ::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
     if (ret < 0 && errno != EINPROGRESS) {
         ::close(fd);
         return false;
     }
+    p.fd        = fd;
+    p.connected = ret == 0;
+    connects_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
 
-    if (ret < 0) {
-        struct pollfd pfd{};
-        pfd.fd     = fd;
-        pfd.events = POLLOUT;
-        int pr = ::poll(&pfd, 1, timeout_ms_);
-        if (pr <= 0) {
-            ::close(fd);
-            return false;
-        }
-        int sock_err = 0;
-        socklen_t len = sizeof(sock_err);
-        ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &sock_err, &len);
-        if (sock_err != 0) {
-            ::close(fd);
-            return false;
-        }
-    }
+void Heartbeat::close(Probe& p) {
+    if (p.fd >= 0) ::close(p.fd);
+    p.fd        = -1;
+    p.connected = false;
+    p.out.clear();
+    p.in.clear();
+}
 
-    // Restore blocking and apply timeouts
-    ::fcntl(fd, F_SETFL, flags);
-    struct timeval tv;
-    tv.tv_sec  = timeout_ms_ / 1000;
-    tv.tv_usec = (timeout_ms_ % 1000) * 1000;
-    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-
-    // Send PING
-    const char* ping_msg = "PING\n";
-    ssize_t sent = ::send(fd, ping_msg, 5, 0);
-    if (sent != 5) {
-        ::close(fd);
-        return false;
+bool Heartbeat::flush(Probe& p) {
+    while (!p.out.empty()) {
+        ssize_t n = ::send(p.fd, p.out.data(), p.out.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        p.out.erase(0, static_cast<size_t>(n));
     }
+    return true;
+}
+
+bool Heartbeat::receive(Probe& p, bool& answered) {
+    char buf[256];
+    for (;;) {
+        ssize_t n = ::recv(p.fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n == 0) return false;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        p.in.append(buf, static_cast<size_t>(n));
 
-    // Read response (+PONG\n = 6 bytes)
-    char buf[64];
-    ssize_t n = ::recv(fd, buf, sizeof(buf) - 1, 0);
-    ::close(fd);
+        auto nl = p.in.find('\n');
+        if (nl == std::string::npos) {
+            if (p.in.size() > sizeof(buf)) return false;  // not a PONG
+            continue;
+        }
+        bool pong = p.in.compare(0, 5, "+PONG") == 0;
+        // Anything past the line is unexpected; the next idle_ok() check
+        // closes the connection if so.
+        p.in.clear();
+        answered = pong;
+        return pong;
+    }
+}
 
-    if (n <= 0) return false;
-    buf[n] = '\0';
-    return std::strncmp(buf, "+PONG", 5) == 0;
+bool Heartbeat::idle_ok(const Probe& p) {
+    if (!p.connected) return false;
+    char c;
+    ssize_t n = ::recv(p.fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+    return false;  // EOF, or stray bytes we can't pair with a PING
 }
 
 }  // namespace dkv
@@ -0,0 +1,295 @@
+#include "cluster/hot_keys.h"
+#include "utils/murmurhash3.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+namespace dkv {
+
+HotKeyCache::HotKeyCache(Options options) : options_(options) {
+    options_.sketch_width = std::max<uint32_t>(options_.sketch_width, 1);
+    options_.sketch_depth = std::max<uint32_t>(options_.sketch_depth, 1);
+    options_.min_count    = std::max<uint64_t>(options_.min_count, 1);
+    const size_t cells = size_t{options_.sketch_width} * options_.sketch_depth;
+    sketch_ = std::make_unique<std::atomic<uint32_t>[]>(cells);
+    for (size_t i = 0; i < cells; i++) sketch_[i].store(0, std::memory_order_relaxed);
+    floor_.store(options_.min_count, std::memory_order_relaxed);
+    capacity_.store(options_.capacity, std::memory_order_relaxed);
+    lease_ms_.store(options_.lease_ms, std::memory_order_relaxed);
+}
+
+// ── Detection ────────────────────────────────────────────────────────────────
+
+uint64_t HotKeyCache::count(uint64_t h1, uint64_t h2) {
+    const uint32_t width = options_.sketch_width;
+    uint64_t est = std::numeric_limits<uint64_t>::max();
+    for (uint32_t row = 0; row < options_.sketch_depth; row++) {
+        auto& cell = sketch_[size_t{row} * width + (h1 + row * h2) % width];
+        est = std::min<uint64_t>(est, cell.fetch_add(1, std::memory_order_relaxed) + 1);
+    }
+    return est;
+}
+
+uint64_t HotKeyCache::estimate(uint64_t h1, uint64_t h2) const {
+    const uint32_t width = options_.sketch_width;
+    uint64_t est = std::numeric_limits<uint64_t>::max();
+    for (uint32_t row = 0; row < options_.sketch_depth; row++) {
+        const auto& cell = sketch_[size_t{row} * width + (h1 + row * h2) % width];
+        est = std::min<uint64_t>(est, cell.load(std::memory_order_relaxed));
+    }
+    return est;
+}
+
+uint64_t HotKeyCache::coldest_locked(std::string* key) const {
+    uint64_t coldest = std::numeric_limits<uint64_t>::max();
+    for (const auto& [k, h] : top_) {
+        uint64_t est = estimate(h.first, h.second);
+        if (est < coldest) {
+            coldest = est;
+            if (key) *key = k;
+        }
+    }
+    return coldest;
+}
+
+void HotKeyCache::update_floor_locked() {
+    uint64_t floor = options_.min_count;
+    if (top_.size() >= options_.top_k) floor = std::max(floor, coldest_locked(nullptr) + 1);
+    floor_.store(floor, std::memory_order_relaxed);
+}
+
+bool HotKeyCache::admit(const std::string& key, uint64_t h1, uint64_t h2,
+                        uint64_t estimate) {
+    {
+        std::shared_lock lock(top_mutex_);
+        if (top_.count(key)) return true;
+    }
+    if (estimate < floor_.load(std::memory_order_relaxed) || options_.top_k == 0) {
+        return false;
+    }
+
+    std::unique_lock lock(top_mutex_);
+    if (top_.count(key)) return true;
+    if (top_.size() >= options_.top_k) {
+        std::string coldest_key;
+        if (coldest_locked(&coldest_key) >= estimate) {
+            update_floor_locked();
+            return false;
+        }
+        top_.erase(coldest_key);
+    }
+    top_.emplace(key, std::make_pair(h1, h2));
+    update_floor_locked();
+    return true;
+}
+
+void HotKeyCache::decay() {
+    std::unique_lock lock(top_mutex_);
+    const size_t cells = size_t{options_.sketch_width} * options_.sketch_depth;
+    // Racing increments may be lost or survive a halving; the counts are
+    // estimates either way.
+    for (size_t i = 0; i < cells; i++) {
+        sketch_[i].store(sketch_[i].load(std::memory_order_relaxed) >> 1,
+                         std::memory_order_relaxed);
+    }
+    for (auto it = top_.begin(); it != top_.end();) {
+        if (estimate(it->second.first, it->second.second) < options_.min_count) {
+            it = top_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    update_floor_locked();
+}
+
+// ── Cache ────────────────────────────────────────────────────────────────────
+
+HotKeyCache::Lookup HotKeyCache::read(const std::string& key) {
+    const auto h = murmurhash3_x64_128(key.data(), key.size());
+    const uint64_t n = reads_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (options_.decay_every > 0 && n % options_.decay_every == 0) decay();
+    const uint64_t est = count(h.h1, h.h2);
+
+    Lookup out;
+    if (cache_size_.load(std::memory_order_relaxed) > 0) {
+        std::shared_lock lock(cache_mutex_);
+        auto it = cache_.find(key);
+        if (it != cache_.end()) {
+            if (now_() < it->second.expires) {
+                out.hit   = true;
+                out.found = it->second.found;
+                out.value = it->second.value;
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return out;
+            }
+            expirations_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    out.ticket = epochs_[h.h1 % STRIPES].load(std::memory_order_acquire);
+    out.hot    = est >= options_.min_count && admit(key, h.h1, h.h2, est);
+    return out;
+}
+
+void HotKeyCache::fill(const std::string& key, uint64_t ticket, bool found,
+                       const std::string& value, const Version& version) {
+    const size_t capacity = capacity_.load(std::memory_order_relaxed);
+    if (capacity == 0 || value.size() > options_.max_value_bytes) return;
+    const auto h = murmurhash3_x64_128(key.data(), key.size());
+
+    std::unique_lock lock(cache_mutex_);
+    if (epochs_[h.h1 % STRIPES].load(std::memory_order_acquire) != ticket) {
+        stale_fills_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    auto it = cache_.find(key);
+    if (it != cache_.end() && is_newer(it->second.version, version)) return;
+    if (it == cache_.end()) {
+        while (cache_.size() >= capacity) evict_one_locked();
+        it = cache_.emplace(key, Entry{}).first;
+    }
+    Entry& e  = it->second;
+    e.found   = found;
+    e.value   = found ? value : std::string{};
+    e.version = version;
+    e.expires = now_() + std::chrono::milliseconds(lease_ms_.load(std::memory_order_relaxed));
+    cache_size_.store(cache_.size(), std::memory_order_relaxed);
+    fills_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HotKeyCache::invalidate(const std::string& key, const Version& version) {
+    if (capacity_.load(std::memory_order_relaxed) == 0) return;
+    const auto h = murmurhash3_x64_128(key.data(), key.size());
+    // Bumped before looking: a fill that takes the lock after us sees it.
+    epochs_[h.h1 % STRIPES].fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::shared_lock lock(cache_mutex_);
+        if (!cache_.count(key)) return;
+    }
+    std::unique_lock lock(cache_mutex_);
+    auto it = cache_.find(key);
+    if (it == cache_.end() || is_newer(it->second.version, version)) return;
+    cache_.erase(it);
+    cache_size_.store(cache_.size(), std::memory_order_relaxed);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HotKeyCache::evict_one_locked() {
+    auto victim = cache_.begin();
+    for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+        if (it->second.expires < victim->second.expires) victim = it;
+    }
+    if (victim == cache_.end()) return;
+    cache_.erase(victim);
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HotKeyCache::set_cache(size_t capacity, uint32_t lease_ms) {
+    std::unique_lock lock(cache_mutex_);
+    capacity_.store(capacity, std::memory_order_relaxed);
+    lease_ms_.store(lease_ms, std::memory_order_relaxed);
+    while (cache_.size() > capacity) evict_one_locked();
+    cache_size_.store(cache_.size(), std::memory_order_relaxed);
+}
+
+std::vector<HotKeyCache::HotKey> HotKeyCache::top(size_t n) const {
+    std::vector<HotKey> out;
+    {
+        std::shared_lock lock(top_mutex_);
+        out.reserve(top_.size());
+        for (const auto& [key, h] : top_) {
+            out.push_back(HotKey{key, estimate(h.first, h.second), false});
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const HotKey& a, const HotKey& b) {
+        return a.count != b.count ? a.count > b.count : a.key < b.key;
+    });
+    if (out.size() > n) out.resize(n);
+
+    std::shared_lock lock(cache_mutex_);
+    for (auto& k : out) k.cached = cache_.count(k.key) > 0;
+    return out;
+}
+
+HotKeyCache::Stats HotKeyCache::stats() const {
+    Stats s;
+    s.reads         = reads_.load(std::memory_order_relaxed);
+    s.hits          = hits_.load(std::memory_order_relaxed);
+    s.fills         = fills_.load(std::memory_order_relaxed);
+    s.stale_fills   = stale_fills_.load(std::memory_order_relaxed);
+    s.invalidations = invalidations_.load(std::memory_order_relaxed);
+    s.expirations   = expirations_.load(std::memory_order_relaxed);
+    s.evictions     = evictions_.load(std::memory_order_relaxed);
+    s.cached        = cache_size_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::string HotKeyCache::encode_report(size_t n) const {
+    const Stats s = stats();
+    const auto  keys = top(n);
+    std::string out;
+    for (uint64_t v : {s.reads, s.hits, s.fills, s.stale_fills, s.invalidations,
+                       s.expirations, s.evictions, uint64_t{s.cached},
+                       uint64_t{keys.size()}}) {
+        if (!out.empty()) out += ' ';
+        out += std::to_string(v);
+    }
+    for (const auto& k : keys) {
+        out += ' ' + std::to_string(k.count) + (k.cached ? " 1 " : " 0 ") +
+               std::to_string(k.key.size()) + ' ' + k.key;
+    }
+    return out;
+}
+
+namespace {
+/// Parse one space-terminated number off the front of `in`.
+template <typename T>
+bool next_number(std::string_view& in, T& out) {
+    auto [ptr, ec] = std::from_chars(in.data(), in.data() + in.size(), out);
+    if (ec != std::errc() || ptr == in.data()) return false;
+    in.remove_prefix(static_cast<size_t>(ptr - in.data()));
+    if (!in.empty()) {
+        if (in.front() != ' ') return false;
+        in.remove_prefix(1);
+    }
+    return true;
+}
+}  // namespace
+
+bool HotKeyCache::decode_report(std::string_view payload, Stats& stats,
+                                std::vector<HotKey>& keys) {
+    Stats  s;
+    size_t count = 0;
+    if (!next_number(payload, s.reads) || !next_number(payload, s.hits) ||
+        !next_number(payload, s.fills) || !next_number(payload, s.stale_fills) ||
+        !next_number(payload, s.invalidations) || !next_number(payload, s.expirations) ||
+        !next_number(payload, s.evictions) || !next_number(payload, s.cached) ||
+        !next_number(payload, count)) {
+        return false;
+    }
+    std::vector<HotKey> out;
+    for (size_t i = 0; i < count; i++) {
+        HotKey   k;
+        unsigned cached  = 0;
+        size_t   key_len = 0;
+        if (!next_number(payload, k.count) || !next_number(payload, cached) ||
+            !next_number(payload, key_len) || key_len > payload.size()) {
+            return false;
+        }
+        k.key    = std::string(payload.substr(0, key_len));
+        k.cached = cached != 0;
+        payload.remove_prefix(key_len);
+        if (!payload.empty()) {
+            if (payload.front() != ' ') return false;
+            payload.remove_prefix(1);
+        }
+        out.push_back(std::move(k));
+    }
+    if (!payload.empty()) return false;
+    stats = s;
+    keys  = std::move(out);
+    return true;
+}
+
+}  // namespace dkv
@@ -1,13 +1,73 @@
 #include "cluster/membership.h"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 namespace dkv {
 
+// ── ArrivalWindow ────────────────────────────────────────────────────────────
+
+ArrivalWindow::ArrivalWindow(size_t capacity, double expected_ms)
+    : capacity_(std::max<size_t>(capacity, 2)) {
+    samples_.reserve(capacity_);
+    add(expected_ms - expected_ms / 4);
+    add(expected_ms + expected_ms / 4);
+}
+
+void ArrivalWindow::add(double interval_ms) {
+    if (samples_.size() < capacity_) {
+        samples_.push_back(interval_ms);
+    } else {
+        double& oldest = samples_[next_];
+        sum_    -= oldest;
+        sum_sq_ -= oldest * oldest;
+        oldest = interval_ms;
+        next_  = (next_ + 1) % capacity_;
+    }
+    sum_    += interval_ms;
+    sum_sq_ += interval_ms * interval_ms;
+}
+
+double ArrivalWindow::mean() const {
+    return samples_.empty() ? 0.0 : sum_ / static_cast<double>(samples_.size());
+}
+
+double ArrivalWindow::std_dev() const {
+    if (samples_.empty()) return 0.0;
+    double m = mean();
+    double var = sum_sq_ / static_cast<double>(samples_.size()) - m * m;
+    return var > 0 ? std::sqrt(var) : 0.0;
+}
+
+double ArrivalWindow::phi(double elapsed_ms, double min_std_dev_ms,
+                          double acceptable_pause_ms) const {
+    double m  = mean() + acceptable_pause_ms;
+    double sd = std::max(std_dev(), min_std_dev_ms);
+    if (sd <= 0) return elapsed_ms > m ? 1e9 : 0.0;
+
+    // Logistic approximation of the normal CDF (error < 1e-4), as used by
+    // Akka: 1 - CDF(y) ~= e / (1 + e) with e = exp(-y (1.5976 + 0.070566 y^2)).
+    double y = (elapsed_ms - m) / sd;
+    double e = std::exp(-y * (1.5976 + 0.070566 * y * y));
+    if (elapsed_ms > m) return -std::log10(e / (1.0 + e));
+    return -std::log10(1.0 - 1.0 / (1.0 + e));
+}
+
+// ── Membership ───────────────────────────────────────────────────────────────
+
 Membership::Membership(int suspect_threshold, int down_threshold_ms)
     : suspect_threshold_(suspect_threshold),
       down_threshold_ms_(down_threshold_ms) {}
 
+void Membership::set_phi_accrual(const PhiOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    phi_ = options;
+    for (auto& [id, status] : peers_) {
+        status.arrivals = ArrivalWindow(phi_.window, phi_.expected_interval_ms);
+    }
+}
+
 void Membership::add_peer(uint32_t node_id, const std::string& address) {
     std::lock_guard<std::mutex> lock(mutex_);
     NodeStatus s;
@@ -15,10 +75,16 @@ void Membership::add_peer(uint32_t node_id, const std::string& address) {
     s.address   = address;
     s.state     = NodeState::UP;
     s.miss_count = 0;
-    s.last_seen  = std::chrono::steady_clock::now();
+    s.last_seen  = now_();
+    s.arrivals   = ArrivalWindow(phi_.window, phi_.expected_interval_ms);
     peers_[node_id] = std::move(s);
 }
 
+void Membership::remove_peer(uint32_t node_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    peers_.erase(node_id);
+}
+
 void Membership::record_success(uint32_t node_id) {
     DownCallback   down_cb;
     RejoinCallback rejoin_cb;
@@ -29,9 +95,16 @@ void Membership::record_success(uint32_t node_id) {
         auto it = peers_.find(node_id);
         if (it == peers_.end()) return;
 
+        auto now = now_();
         old_state         = it->second.state;
+        // The gap across an outage says nothing about the peer's rhythm.
+        if (it->second.heard && old_state != NodeState::DOWN) {
+            it->second.arrivals.add(
+                std::chrono::duration<double, std::milli>(now - it->second.last_seen).count());
+        }
+        it->second.heard      = true;
         it->second.miss_count = 0;
-        it->second.last_seen  = std::chrono::steady_clock::now();
+        it->second.last_seen  = now;
 
         if (it->second.state != NodeState::UP) {
             it->second.state = NodeState::UP;
@@ -64,19 +137,30 @@ void Membership::record_failure(uint32_t node_id) {
 
         it->second.miss_count++;
 
-        if (it->second.state == NodeState::UP &&
-            it->second.miss_count >= suspect_threshold_) {
-            it->second.state = NodeState::SUSPECTED;
-        }
-
-        if (it->second.state == NodeState::SUSPECTED) {
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now - it->second.last_seen).count();
-            if (elapsed_ms >= down_threshold_ms_) {
+        auto now = now_();
+        if (phi_.enabled) {
+            double phi = phi_locked(it->second, now);
+            if (phi >= phi_.down_phi) {
                 it->second.state = NodeState::DOWN;
                 fire_down_cb   = down_cb_;
                 fire_down_addr = it->second.address;
+            } else if (phi >= phi_.suspect_phi) {
+                it->second.state = NodeState::SUSPECTED;
+            }
+        } else {
+            if (it->second.state == NodeState::UP &&
+                it->second.miss_count >= suspect_threshold_) {
+                it->second.state = NodeState::SUSPECTED;
+            }
+
+            if (it->second.state == NodeState::SUSPECTED) {
+                auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    now - it->second.last_seen).count();
+                if (elapsed_ms >= down_threshold_ms_) {
+                    it->second.state = NodeState::DOWN;
+                    fire_down_cb   = down_cb_;
+                    fire_down_addr = it->second.address;
+                }
             }
         }
     }
@@ -86,6 +170,48 @@ void Membership::record_failure(uint32_t node_id) {
     }
 }
 
+void Membership::set_state(uint32_t node_id, NodeState state) {
+    if (state == NodeState::UP) {
+        record_success(node_id);
+        return;
+    }
+
+    DownCallback fire_down_cb;
+    std::string  fire_down_addr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = peers_.find(node_id);
+        if (it == peers_.end() || it->second.state == state) return;
+        it->second.state = state;
+        if (state == NodeState::DOWN) {
+            fire_down_cb   = down_cb_;
+            fire_down_addr = it->second.address;
+        }
+    }
+
+    if (fire_down_cb) {
+        fire_down_cb(node_id, fire_down_addr);
+    }
+}
+
+void Membership::record_rtt(uint32_t node_id, std::chrono::microseconds rtt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(node_id);
+    if (it == peers_.end()) return;
+
+    auto us = static_cast<uint32_t>(std::clamp<int64_t>(rtt.count(), 1, UINT32_MAX));
+    it->second.rtt_us  = us;
+    // Same smoothing as TCP's SRTT: srtt += (rtt - srtt) / 8.
+    it->second.srtt_us = it->second.srtt_us == 0
+        ? us
+        : static_cast<uint32_t>((7ull * it->second.srtt_us + us) / 8);
+}
+
+double Membership::phi_locked(const NodeStatus& s, Clock::time_point now) const {
+    double elapsed = std::chrono::duration<double, std::milli>(now - s.last_seen).count();
+    return s.arrivals.phi(elapsed, phi_.min_std_dev_ms, phi_.acceptable_pause_ms);
+}
+
 NodeState Membership::get_state(uint32_t node_id) const {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = peers_.find(node_id);
@@ -97,6 +223,21 @@ bool Membership::is_available(uint32_t node_id) const {
     return get_state(node_id) != NodeState::DOWN;
 }
 
+double Membership::suspicion(uint32_t node_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(node_id);
+    if (it == peers_.end()) return 0.0;
+    return phi_locked(it->second, now_());
+}
+
+bool Membership::is_suspect(uint32_t node_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(node_id);
+    if (it == peers_.end()) return false;
+    if (it->second.state != NodeState::UP) return true;
+    return phi_.enabled && phi_locked(it->second, now_()) >= phi_.suspect_phi;
+}
+
 std::vector<uint32_t> Membership::down_nodes() const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<uint32_t> result;
@@ -110,8 +251,10 @@ std::vector<NodeStatus> Membership::all_peers() const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<NodeStatus> result;
     result.reserve(peers_.size());
+    auto now = now_();
     for (const auto& [id, status] : peers_) {
         result.push_back(status);
+        result.back().phi = phi_locked(status, now);
     }
     return result;
 }
@@ -0,0 +1,708 @@
+#include "cluster/rebalancer.h"
+#include "utils/crc32.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+
+namespace dkv {
+
+namespace {
+
+/// A chunk that fails its checksum is re-sent this many times.
+constexpr int CHUNK_RETRIES = 3;
+
+/// RING COMMIT is retried this many times per node.
+constexpr int COMMIT_RETRIES = 3;
+
+/// After that, lagging nodes get COMMIT again with this backoff.
+constexpr auto RESYNC_MIN_BACKOFF = std::chrono::milliseconds(500);
+constexpr auto RESYNC_MAX_BACKOFF = std::chrono::seconds(30);
+
+/// RSCAN key lists kept for pullers; an abandoned one is dropped once idle
+/// this long, or when more than MAX_SCANS are open.
+constexpr auto   SCAN_IDLE = std::chrono::seconds(60);
+constexpr size_t MAX_SCANS = 16;
+
+void put_u32(std::string& out, uint32_t v) {
+    out.append(reinterpret_cast<const char*>(&v), 4);
+}
+
+void put_u64(std::string& out, uint64_t v) {
+    out.append(reinterpret_cast<const char*>(&v), 8);
+}
+
+uint32_t read_u32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+uint64_t read_u64(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+/// Next space-separated field of `in`, or an empty view at the end.
+std::string_view next_field(std::string_view& in) {
+    size_t start = in.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        in = {};
+        return {};
+    }
+    in.remove_prefix(start);
+    size_t end = in.find(' ');
+    std::string_view field = in.substr(0, end);
+    in.remove_prefix(end == std::string_view::npos ? in.size() : end);
+    return field;
+}
+
+bool next_u32(std::string_view& in, uint32_t& out) {
+    std::string_view f = next_field(in);
+    if (f.empty()) return false;
+    auto [ptr, ec] = std::from_chars(f.data(), f.data() + f.size(), out);
+    return ec == std::errc() && ptr == f.data() + f.size();
+}
+
+bool same_nodes(const std::vector<NodeInfo>& a, const std::vector<NodeInfo>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](const NodeInfo& x, const NodeInfo& y) {
+                          return x.node_id == y.node_id;
+                      });
+}
+
+}  // namespace
+
+Rebalancer::Rebalancer(StorageEngine& engine, HashRing& ring, RpcClient& rpc,
+                       uint32_t node_id, uint32_t replication_factor,
+                       Writer writer, OnCommit on_commit,
+                       Availability available, Options options)
+    : engine_(engine), ring_(ring), rpc_(rpc), node_id_(node_id),
+      replication_factor_(replication_factor), writer_(std::move(writer)),
+      on_commit_(std::move(on_commit)), available_(std::move(available)),
+      options_(options), bucket_(options.rate_bytes_per_sec) {}
+
+Rebalancer::~Rebalancer() {
+    stop();
+    if (resync_thread_.joinable()) resync_thread_.join();
+}
+
+void Rebalancer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+}
+
+Rebalancer::Stats Rebalancer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// ── Planning ─────────────────────────────────────────────────────────────────
+
+std::vector<Rebalancer::Transfer> Rebalancer::plan(const RingSnapshot& from,
+                                                   const RingSnapshot& to,
+                                                   uint32_t replication_factor) {
+    std::vector<Transfer> out;
+    if (to.size() == 0) return out;
+
+    // Between two consecutive tokens of either ring, both replica sets are
+    // fixed: compare them once per such interval.
+    std::vector<uint64_t> bounds;
+    bounds.reserve(from.size() + to.size());
+    std::merge(from.tokens().begin(), from.tokens().end(),
+               to.tokens().begin(), to.tokens().end(), std::back_inserter(bounds));
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    std::map<uint32_t, size_t> last;  // target → its latest transfer in `out`
+    for (size_t j = 0; j < bounds.size(); j++) {
+        const TokenRange range{bounds[j], bounds[(j + 1) % bounds.size()]};
+        auto before = from.size() ? from.replicas_at(range.start, replication_factor)
+                                  : ReplicaList{};
+        auto after  = to.replicas_at(range.start, replication_factor);
+
+        for (const auto& target : after) {
+            bool had = std::any_of(before.begin(), before.end(),
+                                   [&](const NodeInfo& n) {
+                                       return n.node_id == target.node_id;
+                                   });
+            if (had) continue;
+
+            std::vector<NodeInfo> sources(before.begin(), before.end());
+            auto it = last.find(target.node_id);
+            if (it != last.end()) {
+                Transfer& prev = out[it->second];
+                if (prev.range.end == range.start && same_nodes(prev.sources, sources)) {
+                    prev.range.end = range.end;
+                    continue;
+                }
+            }
+            last[target.node_id] = out.size();
+            out.push_back(Transfer{range, target, std::move(sources)});
+        }
+    }
+    return out;
+}
+
+// ── Driving a change ─────────────────────────────────────────────────────────
+
+Rebalancer::Outcome Rebalancer::join(const std::string& self_address) {
+    Change change{true, node_id_, self_address, options_.vnodes};
+    return run_change(change, [this](const std::vector<Transfer>& transfers) {
+        // Group our ranges by the replica we pull them from.
+        std::map<uint32_t, std::pair<NodeInfo, std::vector<TokenRange>>> by_source;
+        for (const auto& t : transfers) {
+            if (t.target.node_id != node_id_) continue;
+            const NodeInfo* source = nullptr;
+            for (const auto& n : t.sources) {
+                if (n.node_id == node_id_) continue;
+                if (available_ && !available_(n.node_id)) continue;
+                source = &n;
+                break;
+            }
+            if (!source) {
+                std::cerr << "[REBALANCE] No live replica for range ["
+                          << t.range.start << ", " << t.range.end << ")\n";
+                return false;
+            }
+            auto& entry = by_source[source->node_id];
+            entry.first = *source;
+            entry.second.push_back(t.range);
+        }
+        for (const auto& [id, entry] : by_source) {
+            if (!pull(entry.first, entry.second)) return false;
+        }
+        return true;
+    });
+}
+
+Rebalancer::Outcome Rebalancer::leave() {
+    Change change{false, node_id_, {}, 0};
+    return run_change(change, [this](const std::vector<Transfer>& transfers) {
+        // We replicate every range that gains a node: push each to it.
+        std::map<uint32_t, std::pair<NodeInfo, std::vector<TokenRange>>> by_target;
+        for (const auto& t : transfers) {
+            bool ours = std::any_of(t.sources.begin(), t.sources.end(),
+                                    [this](const NodeInfo& n) {
+                                        return n.node_id == node_id_;
+                                    });
+            if (!ours) continue;
+            auto& entry = by_target[t.target.node_id];
+            entry.first = t.target;
+            entry.second.push_back(t.range);
+        }
+        for (const auto& [id, entry] : by_target) {
+            if (!push(entry.first, entry.second)) return false;
+        }
+        return true;
+    });
+}
+
+Rebalancer::Outcome Rebalancer::run_change(
+    const Change& change,
+    const std::function<bool(const std::vector<Transfer>&)>& move) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ || stopping_) return Outcome::FAILED;
+        if (!lagging_.empty()) {
+            // Staging now would replace the change they have yet to commit.
+            std::cerr << "[REBALANCE] " << lagging_.size()
+                      << " nodes have not committed the last change yet\n";
+            return Outcome::FAILED;
+        }
+        running_ = true;
+    }
+    auto finish = [this](Outcome outcome) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        if (outcome != Outcome::FAILED) ++stats_.changes;
+        return outcome;
+    };
+
+    // Everyone in the current ring takes part (a leaving node included).
+    const std::vector<NodeInfo> members = ring_.nodes();
+    std::cout << "[REBALANCE] " << (change.add ? "Adding" : "Removing")
+              << " node " << change.node_id << " (" << members.size()
+              << " nodes in the ring)\n";
+
+    // 1. Stage everywhere; from here on writes also reach the new replicas.
+    auto abort_all = [&]() {
+        broadcast("ABORT", change, members);
+        apply_ring("ABORT", change);
+    };
+    if (!apply_ring("STAGE", change) || !broadcast("STAGE", change, members)) {
+        std::cerr << "[REBALANCE] Could not stage the change; aborting\n";
+        abort_all();
+        return finish(Outcome::FAILED);
+    }
+
+    // 2. Move the data.
+    const RingSnapshot* next = ring_.pending();
+    auto transfers = plan(ring_.snapshot(), *next, replication_factor_);
+    const auto started = Clock::now();
+    if (!move(transfers)) {
+        std::cerr << "[REBALANCE] Transfer failed; aborting\n";
+        abort_all();
+        return finish(Outcome::FAILED);
+    }
+
+    // 3. Flip ownership everywhere, the node driving the change last.  The
+    // data is in place, so the change stands even if some nodes miss it.
+    std::vector<NodeInfo> lagging;
+    for (const auto& n : members) {
+        if (n.node_id == node_id_) continue;
+        bool ok = false;
+        for (int attempt = 0; attempt < COMMIT_RETRIES && !ok; attempt++) {
+            ok = broadcast("COMMIT", change, {n});
+        }
+        if (!ok) {
+            std::cerr << "[REBALANCE] Node " << n.node_id
+                      << " did not acknowledge COMMIT; retrying in the background\n";
+            lagging.push_back(n);
+        }
+    }
+    apply_ring("COMMIT", change);
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        Clock::now() - started).count();
+    Stats s = stats();
+    std::cout << "[REBALANCE] Node " << change.node_id
+              << (change.add ? " joined" : " left") << " in " << ms << " ms: "
+              << s.ranges << " ranges, " << s.keys_streamed << " keys, "
+              << s.bytes_streamed << " bytes streamed\n";
+    if (lagging.empty()) return finish(Outcome::COMMITTED);
+    retry_commit(change, std::move(lagging));
+    return finish(Outcome::LAGGING);
+}
+
+void Rebalancer::retry_commit(const Change& change, std::vector<NodeInfo> peers) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lagging_change_      = change;
+        lagging_             = std::move(peers);
+        stats_.lagging_peers = lagging_.size();
+        if (!resync_thread_.joinable() && !stopping_) {
+            resync_thread_ = std::thread(&Rebalancer::resync_loop, this);
+        }
+    }
+    cv_.notify_all();
+}
+
+void Rebalancer::resync_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto backoff = std::chrono::duration_cast<Clock::duration>(RESYNC_MIN_BACKOFF);
+    while (!stopping_) {
+        if (lagging_.empty()) {
+            cv_.wait(lock, [this]() { return stopping_ || !lagging_.empty(); });
+            backoff = RESYNC_MIN_BACKOFF;
+            continue;
+        }
+        if (cv_.wait_for(lock, backoff, [this]() { return stopping_; })) break;
+
+        const Change change = lagging_change_;
+        const std::vector<NodeInfo> peers = lagging_;
+        lock.unlock();
+        std::vector<NodeInfo> still;
+        for (const auto& n : peers) {
+            if (!broadcast("COMMIT", change, {n})) still.push_back(n);
+        }
+        lock.lock();
+
+        for (const auto& n : peers) {
+            bool caught_up = std::none_of(still.begin(), still.end(),
+                                          [&](const NodeInfo& s) {
+                                              return s.node_id == n.node_id;
+                                          });
+            if (caught_up) {
+                std::cout << "[REBALANCE] Node " << n.node_id
+                          << " committed the change late\n";
+            }
+        }
+        lagging_             = std::move(still);
+        stats_.lagging_peers = lagging_.size();
+        backoff = std::min<Clock::duration>(backoff * 2, RESYNC_MAX_BACKOFF);
+    }
+}
+
+bool Rebalancer::broadcast(std::string_view verb, const Change& change,
+                           const std::vector<NodeInfo>& nodes) {
+    struct Pending {
+        std::mutex              mutex;
+        std::condition_variable cv;
+        size_t                  remaining = 0;
+        bool                    ok        = true;
+    };
+    auto pending = std::make_shared<Pending>();
+    auto frame = RpcClient::encode(BinaryOpcode::RING, {}, {},
+                                   encode_ring(verb, change));
+
+    std::vector<const NodeInfo*> targets;
+    for (const auto& n : nodes) {
+        if (n.node_id != node_id_) targets.push_back(&n);
+    }
+    pending->remaining = targets.size();
+    for (const NodeInfo* n : targets) {
+        rpc_.call(n->address, frame, [pending](RpcResult r) {
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            pending->ok &= r.status == RpcStatus::OK &&
+                           r.opcode == BinaryOpcode::OK;
+            if (--pending->remaining == 0) pending->cv.notify_one();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(pending->mutex);
+    pending->cv.wait(lock, [&]() { return pending->remaining == 0; });
+    return pending->ok;
+}
+
+bool Rebalancer::apply_ring(std::string_view verb, const Change& change) {
+    std::unique_lock<std::mutex> lock(staged_mutex_);
+    if (verb == "STAGE") {
+        bool ok = change.add
+                      ? ring_.stage_add(change.node_id, change.address, change.vnodes)
+                      : ring_.stage_remove(change.node_id);
+        if (!ok) return false;
+        staged_     = change;
+        has_staged_ = true;
+        return true;
+    }
+
+    const bool matches = has_staged_ && staged_.add == change.add &&
+                         staged_.node_id == change.node_id;
+    if (verb == "ABORT") {
+        if (matches) {
+            ring_.abort_pending();
+            has_staged_ = false;
+        }
+        return true;
+    }
+    if (verb == "COMMIT") {
+        if (!matches) {
+            // A repeated COMMIT is fine if the ring already reflects it.
+            bool present = false;
+            for (const auto& n : ring_.snapshot().nodes()) {
+                present |= n.node_id == change.node_id;
+            }
+            if (present == change.add) return true;
+            // We lost the staged change (restarted, or missed STAGE's
+            // effect): COMMIT carries all of it, so apply it now.  Not over
+            // a different staged change; the driver retries.
+            if (has_staged_) return false;
+            bool ok = change.add
+                          ? ring_.stage_add(change.node_id, change.address, change.vnodes)
+                          : ring_.stage_remove(change.node_id);
+            if (!ok) return false;
+        }
+        ring_.commit_pending();
+        has_staged_ = false;
+        lock.unlock();
+        if (on_commit_) on_commit_(change);
+        return true;
+    }
+    return false;
+}
+
+// ── Transfer ─────────────────────────────────────────────────────────────────
+
+bool Rebalancer::pull(const NodeInfo& source, const std::vector<TokenRange>& ranges) {
+    std::cout << "[REBALANCE] Pulling " << ranges.size() << " ranges from node "
+              << source.node_id << "\n";
+    std::vector<std::pair<std::string, ValueEntry>> entries;
+    for (size_t shard = 0; shard < StorageEngine::shard_count(); shard++) {
+        std::string cursor;
+        bool more = true;
+        while (more) {
+            const std::string request =
+                encode_scan(shard, options_.chunk_bytes, cursor, ranges);
+            bool decoded = false;
+            RpcResult r;
+            for (int attempt = 0; attempt < CHUNK_RETRIES && !decoded; attempt++) {
+                r = rpc_.call_sync(source.address, BinaryOpcode::RSCAN, {}, {},
+                                   request);
+                if (r.status != RpcStatus::OK || r.opcode != BinaryOpcode::VALUE) {
+                    return false;
+                }
+                decoded = decode_chunk(r.value, entries, more);
+                if (!decoded) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++stats_.checksum_failures;
+                }
+            }
+            if (!decoded) return false;
+            if (entries.empty()) break;
+            cursor = entries.back().first;
+            apply(entries, r.value.size());
+            throttle(r.value.size());
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.ranges += ranges.size();
+    return !stopping_;
+}
+
+bool Rebalancer::push(const NodeInfo& target, const std::vector<TokenRange>& ranges) {
+    std::cout << "[REBALANCE] Pushing " << ranges.size() << " ranges to node "
+              << target.node_id << "\n";
+    for (size_t shard = 0; shard < StorageEngine::shard_count(); shard++) {
+        const std::vector<std::string> keys = engine_.keys_in_ranges(ranges, shard);
+        size_t next = 0;
+        while (next < keys.size()) {
+            auto entries = engine_.entries_for_keys(shard, keys, next,
+                                                    options_.chunk_bytes, next);
+            if (entries.empty()) break;
+            const bool more = next < keys.size();
+            const std::string chunk = encode_chunk(entries, more);
+
+            bool ok = false;
+            for (int attempt = 0; attempt < CHUNK_RETRIES && !ok; attempt++) {
+                RpcResult r = rpc_.call_sync(target.address, BinaryOpcode::RLOAD,
+                                             {}, {}, chunk);
+                if (r.status != RpcStatus::OK) return false;
+                ok = r.opcode == BinaryOpcode::OK;
+                if (!ok) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++stats_.checksum_failures;
+                }
+            }
+            if (!ok) return false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++stats_.chunks;
+                stats_.keys_streamed += entries.size();
+                stats_.bytes_streamed += chunk.size();
+            }
+            throttle(chunk.size());
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.ranges += ranges.size();
+    return !stopping_;
+}
+
+void Rebalancer::apply(const std::vector<std::pair<std::string, ValueEntry>>& entries,
+                       size_t wire_bytes) {
+    for (const auto& [key, e] : entries) {
+        writer_(key, e.value, e.is_tombstone, e.version);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.chunks;
+    stats_.keys_streamed += entries.size();
+    stats_.bytes_streamed += wire_bytes;
+}
+
+void Rebalancer::throttle(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bucket_.consume(bytes);
+    bucket_.wait(lock, cv_, [this] { return stopping_; });
+}
+
+// ── Serving peers ────────────────────────────────────────────────────────────
+
+std::string Rebalancer::serve(const Command& cmd) {
+    if (cmd.type == CommandType::RING) {
+        std::string verb;
+        Change change;
+        if (!decode_ring(cmd.value, verb, change)) return format_error("BAD_RING_CHANGE");
+        return apply_ring(verb, change) ? format_ok()
+                                        : format_error("RING_CHANGE_REJECTED");
+    }
+
+    if (cmd.type == CommandType::RLOAD) {
+        std::vector<std::pair<std::string, ValueEntry>> entries;
+        bool more = false;
+        if (!decode_chunk(cmd.value, entries, more)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.checksum_failures;
+            return format_error("CHECKSUM_MISMATCH");
+        }
+        apply(entries, cmd.value.size());
+        return format_ok();
+    }
+
+    if (cmd.type == CommandType::RSCAN) {
+        const std::string_view req = cmd.value;
+        if (req.size() < 12) return format_error("BAD_SCAN");
+        const uint32_t shard     = read_u32(req.data());
+        const uint32_t max_bytes = read_u32(req.data() + 4);
+        const uint32_t cur_len   = read_u32(req.data() + 8);
+        if (req.size() < 16 + static_cast<size_t>(cur_len)) return format_error("BAD_SCAN");
+        std::string cursor(req.substr(12, cur_len));
+        const char* p = req.data() + 12 + cur_len;
+        const uint32_t count = read_u32(p);
+        p += 4;
+        if (static_cast<size_t>(req.data() + req.size() - p) != count * 16ull) {
+            return format_error("BAD_SCAN");
+        }
+        const std::string_view encoded_ranges = req.substr(12 + cur_len);
+        std::vector<TokenRange> ranges(count);
+        for (auto& r : ranges) {
+            r.start = read_u64(p);
+            r.end   = read_u64(p + 8);
+            p += 16;
+        }
+        auto keys = scan_keys(shard, encoded_ranges, ranges, cursor.empty());
+        const size_t begin = static_cast<size_t>(
+            std::upper_bound(keys->begin(), keys->end(), cursor) - keys->begin());
+        size_t next = 0;
+        auto entries = engine_.entries_for_keys(shard, *keys, begin, max_bytes, next);
+        const bool more = next < keys->size();
+        if (!more) end_scan(shard, encoded_ranges);
+        return format_value(encode_chunk(entries, more));
+    }
+
+    return format_error("INTERNAL");
+}
+
+std::shared_ptr<const std::vector<std::string>> Rebalancer::scan_keys(
+    uint32_t shard, std::string_view encoded_ranges,
+    const std::vector<TokenRange>& ranges, bool first_chunk) {
+    const auto now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(scans_mutex_);
+        std::erase_if(scans_, [now](const ScanState& s) { return now - s.used > SCAN_IDLE; });
+        for (auto& s : scans_) {
+            if (s.shard == shard && s.ranges == encoded_ranges && !first_chunk) {
+                s.used = now;
+                return s.keys;
+            }
+        }
+    }
+
+    // A new shard transfer (or one whose list was dropped: the cursor still
+    // says where to resume).  Listed outside the lock.
+    auto keys = std::make_shared<const std::vector<std::string>>(
+        engine_.keys_in_ranges(ranges, shard));
+
+    std::lock_guard<std::mutex> lock(scans_mutex_);
+    std::erase_if(scans_, [&](const ScanState& s) {
+        return s.shard == shard && s.ranges == encoded_ranges;
+    });
+    if (scans_.size() >= MAX_SCANS) {
+        scans_.erase(std::min_element(scans_.begin(), scans_.end(),
+            [](const ScanState& a, const ScanState& b) { return a.used < b.used; }));
+    }
+    scans_.push_back(ScanState{shard, std::string(encoded_ranges), keys, now});
+    return keys;
+}
+
+void Rebalancer::end_scan(uint32_t shard, std::string_view encoded_ranges) {
+    std::lock_guard<std::mutex> lock(scans_mutex_);
+    std::erase_if(scans_, [&](const ScanState& s) {
+        return s.shard == shard && s.ranges == encoded_ranges;
+    });
+}
+
+// ── Wire formats ─────────────────────────────────────────────────────────────
+
+std::string Rebalancer::encode_ring(std::string_view verb, const Change& change) {
+    std::string out(verb);
+    if (change.add) {
+        out += " ADD " + std::to_string(change.node_id) + " " + change.address +
+               " " + std::to_string(change.vnodes);
+    } else {
+        out += " REMOVE " + std::to_string(change.node_id);
+    }
+    return out;
+}
+
+bool Rebalancer::decode_ring(std::string_view payload, std::string& verb,
+                             Change& change) {
+    verb = std::string(next_field(payload));
+    if (verb != "STAGE" && verb != "COMMIT" && verb != "ABORT") return false;
+    std::string_view kind = next_field(payload);
+    change = Change{};
+    if (kind == "ADD") {
+        change.add = true;
+        if (!next_u32(payload, change.node_id)) return false;
+        change.address = std::string(next_field(payload));
+        if (change.address.empty() || !next_u32(payload, change.vnodes)) return false;
+    } else if (kind == "REMOVE") {
+        change.add = false;
+        if (!next_u32(payload, change.node_id)) return false;
+    } else {
+        return false;
+    }
+    return next_field(payload).empty();
+}
+
+std::string Rebalancer::encode_scan(size_t shard, size_t max_bytes,
+                                    const std::string& cursor,
+                                    const std::vector<TokenRange>& ranges) {
+    std::string out;
+    out.reserve(16 + cursor.size() + ranges.size() * 16);
+    put_u32(out, static_cast<uint32_t>(shard));
+    put_u32(out, static_cast<uint32_t>(max_bytes));
+    put_u32(out, static_cast<uint32_t>(cursor.size()));
+    out += cursor;
+    put_u32(out, static_cast<uint32_t>(ranges.size()));
+    for (const auto& r : ranges) {
+        put_u64(out, r.start);
+        put_u64(out, r.end);
+    }
+    return out;
+}
+
+std::string Rebalancer::encode_chunk(
+    const std::vector<std::pair<std::string, ValueEntry>>& entries, bool more) {
+    size_t size = 9;
+    for (const auto& [key, e] : entries) size += 21 + key.size() + e.value.size();
+
+    std::string out;
+    out.reserve(size);
+    put_u32(out, 0);  // checksum, filled in below
+    out.push_back(more ? 1 : 0);
+    put_u32(out, static_cast<uint32_t>(entries.size()));
+    for (const auto& [key, e] : entries) {
+        put_u32(out, static_cast<uint32_t>(key.size()));
+        out += key;
+        put_u32(out, static_cast<uint32_t>(e.value.size()));
+        out += e.value;
+        put_u64(out, e.version.timestamp_ms);
+        put_u32(out, e.version.node_id);
+        out.push_back(e.is_tombstone ? 1 : 0);
+    }
+    const uint32_t crc = crc32(out.data() + 4, out.size() - 4);
+    std::memcpy(out.data(), &crc, 4);
+    return out;
+}
+
+bool Rebalancer::decode_chunk(std::string_view chunk,
+                              std::vector<std::pair<std::string, ValueEntry>>& out,
+                              bool& more) {
+    out.clear();
+    if (chunk.size() < 9) return false;
+    if (read_u32(chunk.data()) != crc32(chunk.data() + 4, chunk.size() - 4)) {
+        return false;
+    }
+    more = chunk[4] != 0;
+    const uint32_t count = read_u32(chunk.data() + 5);
+
+    const char* p   = chunk.data() + 9;
+    const char* end = chunk.data() + chunk.size();
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        if (end - p < 4) return false;
+        const uint32_t klen = read_u32(p);
+        if (static_cast<size_t>(end - p) < 8ull + klen) return false;
+        std::string key(p + 4, klen);
+        p += 4 + klen;
+        const uint32_t vlen = read_u32(p);
+        if (static_cast<size_t>(end - p) < 4ull + vlen + 13) return false;
+        ValueEntry e;
+        e.value.assign(p + 4, vlen);
+        p += 4 + vlen;
+        e.version      = Version{read_u64(p), read_u32(p + 8)};
+        e.is_tombstone = p[12] != 0;
+        p += 13;
+        out.emplace_back(std::move(key), std::move(e));
+    }
+    return p == end;
+}
+
+}  // namespace dkv
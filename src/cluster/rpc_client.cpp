@@ -0,0 +1,746 @@
+#include "cluster/rpc_client.h"
+#include "utils/metrics.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace dkv {
+
+namespace {
+
+/// Upper bound on one poll() so stop() and new deadlines are noticed
+/// promptly even when no deadline is pending.
+constexpr int MAX_POLL_MS = 100;
+
+/// Minimum free space in a read buffer before each recv() call.
+constexpr size_t READ_CHUNK = 16 * 1024;
+
+/// Read buffer capacity kept once its frames are parsed; a large value
+/// grows it past this only until it has been delivered.
+constexpr size_t READ_BUF_KEEP = 4 * READ_CHUNK;
+
+/// Completed request frames (an RBATCH counts once) by outcome.
+Counter& requests_completed(RpcStatus status) {
+    static Counter* counters[] = {
+        &Metrics::instance().counter("dkv_rpc_requests_total",
+                                     "Inter-node request frames by outcome", "status=\"ok\""),
+        &Metrics::instance().counter("dkv_rpc_requests_total",
+                                     "Inter-node request frames by outcome",
+                                     "status=\"connect_failed\""),
+        &Metrics::instance().counter("dkv_rpc_requests_total",
+                                     "Inter-node request frames by outcome", "status=\"timeout\""),
+        &Metrics::instance().counter("dkv_rpc_requests_total",
+                                     "Inter-node request frames by outcome",
+                                     "status=\"disconnected\""),
+        &Metrics::instance().counter("dkv_rpc_requests_total",
+                                     "Inter-node request frames by outcome",
+                                     "status=\"shutdown\""),
+    };
+    return *counters[static_cast<size_t>(status)];
+}
+
+Counter& connects_started() {
+    static Counter& c = Metrics::instance().counter(
+        "dkv_rpc_connects_total", "Inter-node connections opened");
+    return c;
+}
+
+Counter& connections_failed() {
+    static Counter& c = Metrics::instance().counter(
+        "dkv_rpc_connection_failures_total",
+        "Inter-node connections dropped with requests outstanding, or that never connected");
+    return c;
+}
+
+/// Overwrite the request id (header bytes 4..8, little-endian) of an
+/// encoded frame that has just been appended to `buf` at `pos`.
+void patch_request_id(std::string& buf, size_t pos, uint32_t id) {
+    for (size_t i = 0; i < 4; i++) {
+        buf[pos + 4 + i] = static_cast<char>((id >> (8 * i)) & 0xFF);
+    }
+}
+
+/// Copy a response frame out of the read buffer into an RpcResult.
+RpcResult result_from_frame(const BinaryFrame& f) {
+    RpcResult r;
+    r.status = RpcStatus::OK;
+    r.opcode = f.opcode;
+    r.value.assign(f.value.data(), f.value.size());
+    r.has_version = decode_version_extras(f.extras, r.timestamp_ms, r.node_id);
+    r.busy        = (f.flags & BINARY_FLAG_BUSY) != 0;
+    return r;
+}
+
+/// Hand each write of a completed RBATCH its own result.  The batch reply's
+/// value holds one response frame per write, keyed by inner request id;
+/// writes the reply does not mention inherit the batch's failure.
+void resolve_batch(const std::vector<RpcClient::Callback>& callbacks,
+                   const RpcResult& batch) {
+    std::vector<bool> answered(callbacks.size(), false);
+
+    if (batch.status == RpcStatus::OK && batch.opcode == BinaryOpcode::VALUE) {
+        const std::string& acks = batch.value;
+        size_t offset = 0;
+        while (offset < acks.size()) {
+            auto res = try_parse_binary(acks.data() + offset, acks.size() - offset);
+            if (res.status != ParseStatus::OK) break;
+            offset += res.bytes_consumed;
+
+            uint32_t id = res.frame.request_id;
+            if (id >= callbacks.size() || answered[id]) continue;
+            answered[id] = true;
+            RpcResult r = result_from_frame(res.frame);
+            r.busy = batch.busy;  // inner frames carry no flags
+            callbacks[id](std::move(r));
+        }
+    }
+
+    for (size_t i = 0; i < callbacks.size(); i++) {
+        if (answered[i]) continue;
+        RpcResult r;
+        r.status = batch.status;
+        r.opcode = BinaryOpcode::ERROR;
+        r.value  = batch.opcode == BinaryOpcode::ERROR ? batch.value
+                                                       : "MISSING_BATCH_ACK";
+        callbacks[i](std::move(r));
+    }
+}
+
+}  // namespace
+
+// ── Construction / shutdown ─────────────────────────────────────────────────
+
+RpcClient::RpcClient(int timeout_ms, size_t conns_per_peer)
+    : timeout_ms_(timeout_ms),
+      conns_per_peer_(conns_per_peer == 0 ? 1 : conns_per_peer),
+      poller_(Poller::create()) {
+    if (!wakeup_.open() || !poller_->add_fd(wakeup_.read_fd(), POLL_READ)) {
+        std::cerr << "[RPC] Failed to set up event loop wakeup\n";
+        stopped_ = true;
+        return;
+    }
+    running_     = true;
+    loop_thread_ = std::thread(&RpcClient::run_loop, this);
+}
+
+RpcClient::~RpcClient() {
+    stop();
+}
+
+void RpcClient::stop() {
+    if (stopped_.exchange(true, std::memory_order_seq_cst)) {
+        if (loop_thread_.joinable()) loop_thread_.join();
+        return;
+    }
+    // Wait out call()s that passed the stopped_ check before it flipped, so
+    // nothing can be queued after the final drain below.
+    while (submitters_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+
+    running_ = false;
+    wakeup_.signal();
+    if (loop_thread_.joinable()) loop_thread_.join();
+
+    // The loop has exited: this thread now owns its state.
+    for (auto& [id, p] : pending_) {
+        RpcResult r;
+        r.status = RpcStatus::SHUTDOWN;
+        p.done(std::move(r));
+    }
+    pending_.clear();
+
+    Submission sub;
+    while (submissions_.try_pop(sub)) {
+        RpcResult r;
+        r.status = RpcStatus::SHUTDOWN;
+        sub.done(std::move(r));
+    }
+
+    TimerSubmission timer;
+    while (timer_submissions_.try_pop(timer)) {}
+    timers_.clear();
+
+    for (auto& [addr, batch] : batches_) {
+        for (auto& done : batch.callbacks) {
+            RpcResult r;
+            r.status = RpcStatus::SHUTDOWN;
+            done(std::move(r));
+        }
+    }
+    batches_.clear();
+
+    for (auto& [fd, conn] : by_fd_) {
+        poller_->remove_fd(fd);
+        ::close(fd);
+    }
+    by_fd_.clear();
+    peers_.clear();
+}
+
+// ── Caller API ──────────────────────────────────────────────────────────────
+
+std::shared_ptr<const std::string> RpcClient::encode(BinaryOpcode op,
+                                                     std::string_view extras,
+                                                     std::string_view key,
+                                                     std::string_view value) {
+    auto frame = std::make_shared<std::string>();
+    append_binary_frame(*frame, op, /*request_id=*/0, extras, key, value);
+    return frame;
+}
+
+void RpcClient::call(const std::string& address,
+                     std::shared_ptr<const std::string> frame, Callback done) {
+    submit(address, std::move(frame), std::move(done), /*batchable=*/false);
+}
+
+void RpcClient::call(const std::string& address,
+                     std::shared_ptr<const std::string> frame, Callback done,
+                     std::chrono::milliseconds timeout) {
+    submit(address, std::move(frame), std::move(done), /*batchable=*/false, timeout);
+}
+
+void RpcClient::call_batched(const std::string& address,
+                             std::shared_ptr<const std::string> frame,
+                             Callback done) {
+    submit(address, std::move(frame), std::move(done), /*batchable=*/true);
+}
+
+void RpcClient::submit(const std::string& address,
+                       std::shared_ptr<const std::string> frame, Callback done,
+                       bool batchable, std::chrono::milliseconds timeout) {
+    submitters_.fetch_add(1, std::memory_order_seq_cst);
+    if (stopped_.load(std::memory_order_seq_cst)) {
+        submitters_.fetch_sub(1, std::memory_order_release);
+        RpcResult r;
+        r.status = RpcStatus::SHUTDOWN;
+        done(std::move(r));
+        return;
+    }
+
+    submissions_.push(Submission{address, std::move(frame), std::move(done),
+                                 batchable, timeout});
+    submitters_.fetch_sub(1, std::memory_order_release);
+
+    // Same coalescing as TCPServer::post_response: only the caller that
+    // flips the flag pays for the wakeup syscall.
+    if (!wakeup_pending_.exchange(true, std::memory_order_seq_cst)) {
+        wakeup_.signal();
+    }
+}
+
+void RpcClient::run_after(std::chrono::microseconds delay,
+                          std::function<void()> fn) {
+    submitters_.fetch_add(1, std::memory_order_seq_cst);
+    if (stopped_.load(std::memory_order_seq_cst)) {
+        submitters_.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+    timer_submissions_.push(TimerSubmission{Clock::now() + delay, std::move(fn)});
+    submitters_.fetch_sub(1, std::memory_order_release);
+
+    if (!wakeup_pending_.exchange(true, std::memory_order_seq_cst)) {
+        wakeup_.signal();
+    }
+}
+
+void RpcClient::set_batching(size_t max_bytes, uint32_t linger_us) {
+    batch_linger_us_.store(linger_us, std::memory_order_relaxed);
+    batch_max_bytes_.store(max_bytes, std::memory_order_relaxed);
+}
+
+RpcClient::BatchStats RpcClient::batch_stats() const {
+    BatchStats s;
+    s.batches        = batches_sent_.load(std::memory_order_relaxed);
+    s.batched_writes = batched_writes_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void RpcClient::call(const std::string& address, BinaryOpcode op,
+                     std::string_view extras, std::string_view key,
+                     std::string_view value, Callback done) {
+    call(address, encode(op, extras, key, value), std::move(done));
+}
+
+RpcResult RpcClient::call_sync(const std::string& address, BinaryOpcode op,
+                               std::string_view extras, std::string_view key,
+                               std::string_view value) {
+    // Must not be called from a completion callback: the loop thread would
+    // wait on itself.
+    auto promise = std::make_shared<std::promise<RpcResult>>();
+    auto future  = promise->get_future();
+    call(address, op, extras, key, value, [promise](RpcResult r) {
+        promise->set_value(std::move(r));
+    });
+    return future.get();
+}
+
+// ── Event loop ──────────────────────────────────────────────────────────────
+
+void RpcClient::run_loop() {
+    const int wake_fd = wakeup_.read_fd();
+    int timeout = MAX_POLL_MS;
+
+    while (running_.load(std::memory_order_acquire)) {
+        auto events = poller_->poll(timeout);
+
+        for (const auto& ev : events) {
+            if (ev.fd == wake_fd) {
+                wakeup_.clear();
+                drain_submissions();
+                continue;
+            }
+
+            auto it = by_fd_.find(ev.fd);
+            if (it == by_fd_.end()) continue;  // closed earlier in this batch
+            PeerConn* conn = it->second;
+
+            if (ev.writable || ev.error) {
+                if (!conn->connected) {
+                    int err = 0;
+                    socklen_t len = sizeof(err);
+                    ::getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                    if (err != 0) {
+                        fail_connection(conn, RpcStatus::CONNECT_FAILED);
+                        continue;
+                    }
+                    conn->connected = true;
+                }
+                handle_writable(conn);
+                if (by_fd_.find(ev.fd) == by_fd_.end()) continue;
+            }
+            if (ev.readable) {
+                handle_readable(conn);
+                if (by_fd_.find(ev.fd) == by_fd_.end()) continue;
+            }
+            if (ev.error) {
+                fail_connection(conn, RpcStatus::DISCONNECTED);
+            }
+        }
+
+        // Submissions can also arrive while the loop is busy; checking here
+        // keeps them from waiting for the next wakeup edge.
+        if (!submissions_.empty() || !timer_submissions_.empty()) {
+            drain_submissions();
+        }
+
+        // Batches whose linger time is up go out now.
+        int until_batch = flush_batches(/*all=*/false);
+        flush_connections();
+
+        int until_timer = fire_timers();
+        // A timer may have issued requests (e.g. a hedge): send them now.
+        if (!submissions_.empty()) drain_submissions();
+
+        int until_deadline = expire_deadlines();
+        timeout = MAX_POLL_MS;
+        for (int t : {until_deadline, until_batch, until_timer}) {
+            if (t >= 0 && t < timeout) timeout = t;
+        }
+    }
+}
+
+void RpcClient::drain_submissions() {
+    wakeup_pending_.store(false, std::memory_order_seq_cst);
+
+    const auto now      = Clock::now();
+    const auto deadline = now + std::chrono::milliseconds(timeout_ms_);
+    const bool batching = batch_max_bytes_.load(std::memory_order_relaxed) > 0;
+
+    TimerSubmission timer;
+    while (timer_submissions_.try_pop(timer)) {
+        timers_.emplace(timer.fire_at, std::move(timer.fn));
+    }
+
+    Submission sub;
+    while (submissions_.try_pop(sub)) {
+        if (sub.batchable && batching) {
+            add_to_batch(sub.address, *sub.frame, std::move(sub.done));
+        } else {
+            enqueue(sub.address, *sub.frame, {}, std::move(sub.done),
+                    sub.timeout.count() > 0 ? now + sub.timeout : deadline);
+        }
+    }
+
+    // Without a linger time a batch is whatever queued up while the loop
+    // was busy: send it now.
+    if (batch_linger_us_.load(std::memory_order_relaxed) == 0) {
+        flush_batches(/*all=*/true);
+    }
+    flush_connections();
+}
+
+void RpcClient::flush_connections() {
+    // One send() per connection, however many requests it got.  Collect
+    // first: a failed flush removes the connection from by_fd_.
+    std::vector<int> to_flush;
+    for (auto& [fd, conn] : by_fd_) {
+        if (conn->connected && conn->write_buf.size() > conn->write_off) {
+            to_flush.push_back(fd);
+        }
+    }
+    for (int fd : to_flush) {
+        auto it = by_fd_.find(fd);
+        if (it != by_fd_.end()) flush(it->second);
+    }
+}
+
+void RpcClient::enqueue(const std::string& address, std::string_view frame,
+                        std::string_view tail, Callback done,
+                        Clock::time_point deadline) {
+    PeerConn* conn = connection_for(address);
+    if (!conn) {
+        RpcResult r;
+        r.status = RpcStatus::CONNECT_FAILED;
+        requests_completed(r.status).add();
+        done(std::move(r));
+        return;
+    }
+
+    uint32_t id = next_request_id_++;
+    if (next_request_id_ == 0) next_request_id_ = 1;  // 0 is "unpatched"
+
+    conn->outstanding.insert(id);
+    pending_.emplace(id, Pending{std::move(done), conn});
+    deadlines_.emplace(deadline, id);
+
+    size_t pos = conn->write_buf.size();
+    conn->write_buf.append(frame);
+    patch_request_id(conn->write_buf, pos, id);
+    if (tail.empty()) return;
+
+    if (!conn->connected || pos != conn->write_off) {
+        // Output already waiting ahead of us: queue behind it.
+        conn->write_buf.append(tail);
+        return;
+    }
+
+    // Idle connection: send header and body with one writev() instead of
+    // first copying the body into write_buf.
+    const size_t frame_len = conn->write_buf.size() - pos;
+    struct iovec iov[2];
+    iov[0].iov_base = conn->write_buf.data() + pos;
+    iov[0].iov_len  = frame_len;
+    iov[1].iov_base = const_cast<char*>(tail.data());
+    iov[1].iov_len  = tail.size();
+
+    ssize_t n;
+    do {
+        n = ::writev(conn->fd, iov, 2);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            conn->write_buf.append(tail);
+        } else {
+            fail_connection(conn, RpcStatus::DISCONNECTED);
+        }
+        return;
+    }
+
+    auto sent = static_cast<size_t>(n);
+    if (sent < frame_len) {
+        conn->write_off = pos + sent;
+        conn->write_buf.append(tail);
+    } else {
+        conn->write_buf.clear();
+        conn->write_off = 0;
+        conn->write_buf.append(tail.substr(sent - frame_len));
+    }
+}
+
+void RpcClient::add_to_batch(const std::string& address, std::string_view frame,
+                             Callback done) {
+    Batch& batch = batches_[address];
+    if (batch.callbacks.empty()) {
+        batch.deadline = Clock::now() + std::chrono::microseconds(
+            batch_linger_us_.load(std::memory_order_relaxed));
+    }
+
+    size_t pos = batch.body.size();
+    batch.body.append(frame);
+    patch_request_id(batch.body, pos, static_cast<uint32_t>(batch.callbacks.size()));
+    batch.callbacks.push_back(std::move(done));
+
+    if (batch.body.size() >= batch_max_bytes_.load(std::memory_order_relaxed)) {
+        flush_batch(address, batch);
+    }
+}
+
+void RpcClient::flush_batch(const std::string& address, Batch& batch) {
+    if (batch.callbacks.empty()) return;
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms_);
+
+    if (batch.callbacks.size() == 1) {
+        // Nothing to coalesce with: a plain frame is cheaper for both ends.
+        enqueue(address, batch.body, {}, std::move(batch.callbacks[0]), deadline);
+    } else {
+        batches_sent_.fetch_add(1, std::memory_order_relaxed);
+        batched_writes_.fetch_add(batch.callbacks.size(), std::memory_order_relaxed);
+
+        std::string header;
+        append_binary_header(header, BinaryOpcode::RBATCH, 0, 0, 0,
+                             batch.body.size());
+        enqueue(address, header, batch.body,
+                [callbacks = std::move(batch.callbacks)](RpcResult r) {
+                    resolve_batch(callbacks, r);
+                },
+                deadline);
+    }
+    batch.body.clear();
+    batch.callbacks.clear();
+}
+
+int RpcClient::flush_batches(bool all) {
+    const auto now = Clock::now();
+    int next = -1;
+
+    for (auto& [address, batch] : batches_) {
+        if (batch.callbacks.empty()) continue;
+        if (all || batch.deadline <= now) {
+            flush_batch(address, batch);
+            continue;
+        }
+        auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+            batch.deadline - now).count();
+        if (next < 0 || wait < next) next = static_cast<int>(wait);
+    }
+    return next;
+}
+
+RpcClient::PeerConn* RpcClient::connection_for(const std::string& address) {
+    auto& conns = peers_[address];
+
+    if (conns.size() < conns_per_peer_) {
+        int fd = start_connect(address);
+        if (fd >= 0) {
+            connects_started().add();
+            auto conn     = std::make_unique<PeerConn>();
+            conn->fd      = fd;
+            conn->address = address;
+            PeerConn* raw = conn.get();
+            conns.push_back(std::move(conn));
+            by_fd_[fd] = raw;
+            return raw;
+        }
+        if (conns.empty()) return nullptr;
+    }
+
+    size_t& cursor = next_conn_[address];
+    PeerConn* conn = conns[cursor % conns.size()].get();
+    cursor++;
+    return conn;
+}
+
+int RpcClient::start_connect(const std::string& address) {
+    auto colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        std::cerr << "[RPC] Invalid address: " << address << "\n";
+        return -1;
+    }
+
+    std::string host = address.substr(0, colon);
+    int port = 0;
+    try {
+        port = std::stoi(address.substr(colon + 1));
+    } catch (...) {
+        std::cerr << "[RPC] Invalid port in: " << address << "\n";
+        return -1;
+    }
+
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) <= 0) {
+        std::cerr << "[RPC] Invalid host: " << host << "\n";
+        return -1;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::cerr << "[RPC] socket() failed: " << strerror(errno) << "\n";
+        return -1;
+    }
+
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    // Requests are small and latency-bound; never let Nagle hold one back.
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    int ret = ::connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                        sizeof(addr));
+    if (ret < 0 && errno != EINPROGRESS) {
+        ::close(fd);
+        return -1;
+    }
+
+    // Writability signals connect completion (edge-triggered, so leaving
+    // POLL_WRITE registered costs nothing once the socket is idle).
+    if (!poller_->add_fd(fd, POLL_READ | POLL_WRITE)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// ── Connection I/O ──────────────────────────────────────────────────────────
+
+void RpcClient::handle_writable(PeerConn* conn) {
+    if (conn->write_buf.size() > conn->write_off) flush(conn);
+}
+
+void RpcClient::flush(PeerConn* conn) {
+    while (conn->write_off < conn->write_buf.size()) {
+        ssize_t n = ::send(conn->fd, conn->write_buf.data() + conn->write_off,
+                           conn->write_buf.size() - conn->write_off,
+                           MSG_NOSIGNAL);
+        if (n > 0) {
+            conn->write_off += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;  // rest goes out on the next POLL_WRITE edge
+        } else {
+            fail_connection(conn, RpcStatus::DISCONNECTED);
+            return;
+        }
+    }
+    conn->write_buf.clear();
+    conn->write_off = 0;
+}
+
+void RpcClient::handle_readable(PeerConn* conn) {
+    bool peer_closed = false;
+    while (true) {
+        char*   dst = conn->read_buf.prepare(READ_CHUNK);
+        ssize_t n   = ::recv(conn->fd, dst, conn->read_buf.spare(), 0);
+        if (n > 0) {
+            conn->read_buf.commit(static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        // Peer closed (0) or hard error: deliver what already arrived first.
+        peer_closed = true;
+        break;
+    }
+
+    size_t offset = 0;
+    bool   fatal  = false;
+    while (offset < conn->read_buf.size()) {
+        auto res = try_parse_binary(conn->read_buf.data() + offset,
+                                    conn->read_buf.size() - offset);
+        if (res.status == ParseStatus::INCOMPLETE) break;
+        if (res.status == ParseStatus::ERROR) {
+            std::cerr << "[RPC] Malformed response from " << conn->address
+                      << ": " << res.error_msg << "\n";
+            fatal = res.fatal;
+            offset += res.bytes_consumed;
+            if (fatal) break;
+            continue;
+        }
+        offset += res.bytes_consumed;
+
+        const BinaryFrame& f = res.frame;
+        if (conn->outstanding.erase(f.request_id) == 0) continue;  // timed out
+
+        complete(f.request_id, result_from_frame(f));
+    }
+
+    if (fatal || peer_closed) {
+        fail_connection(conn, RpcStatus::DISCONNECTED);
+        return;
+    }
+    conn->read_buf.consume(offset);
+    conn->read_buf.shrink(READ_BUF_KEEP);
+}
+
+void RpcClient::complete(uint32_t id, RpcResult result) {
+    auto it = pending_.find(id);
+    if (it == pending_.end()) return;
+    Callback done = std::move(it->second.done);
+    pending_.erase(it);
+    requests_completed(result.status).add();
+    done(std::move(result));
+}
+
+void RpcClient::fail_connection(PeerConn* conn, RpcStatus status) {
+    connections_failed().add();
+    const int fd = conn->fd;
+    std::unordered_set<uint32_t> ids = std::move(conn->outstanding);
+
+    poller_->remove_fd(fd);
+    ::close(fd);
+    by_fd_.erase(fd);
+
+    auto& conns = peers_[conn->address];
+    for (auto it = conns.begin(); it != conns.end(); ++it) {
+        if (it->get() == conn) {
+            conns.erase(it);  // destroys *conn
+            break;
+        }
+    }
+
+    for (uint32_t id : ids) {
+        RpcResult r;
+        r.status = status;
+        complete(id, std::move(r));
+    }
+}
+
+int RpcClient::fire_timers() {
+    const auto now = Clock::now();
+    while (!timers_.empty() && timers_.begin()->first <= now) {
+        auto fn = std::move(timers_.begin()->second);
+        timers_.erase(timers_.begin());
+        fn();
+    }
+    if (timers_.empty()) return -1;
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(
+        timers_.begin()->first - now).count());
+}
+
+int RpcClient::expire_deadlines() {
+    const auto now = Clock::now();
+
+    while (!deadlines_.empty()) {
+        auto [deadline, id] = deadlines_.top();
+        auto it = pending_.find(id);
+        if (it == pending_.end()) {  // already completed
+            deadlines_.pop();
+            continue;
+        }
+        if (deadline > now) {
+            return static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - now).count()) + 1;
+        }
+        deadlines_.pop();
+
+        PeerConn* conn = it->second.conn;
+        if (!conn->connected) {
+            // Still connecting after a full timeout: the peer is unreachable,
+            // so everything queued behind the handshake fails with it.
+            fail_connection(conn, RpcStatus::TIMEOUT);
+            continue;
+        }
+        conn->outstanding.erase(id);
+        RpcResult r;
+        r.status = RpcStatus::TIMEOUT;
+        complete(id, std::move(r));
+    }
+    return -1;
+}
+
+}  // namespace dkv
@@ -0,0 +1,117 @@
+#include "cluster/token_router.h"
+#include "utils/murmurhash3.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace dkv {
+
+namespace {
+
+/// Next space-separated field of `in`, or an empty view at the end.
+std::string_view next_field(std::string_view& in) {
+    size_t start = in.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        in = {};
+        return {};
+    }
+    in.remove_prefix(start);
+    size_t end = in.find(' ');
+    std::string_view field = in.substr(0, end);
+    in.remove_prefix(end == std::string_view::npos ? in.size() : end);
+    return field;
+}
+
+template <typename T>
+bool next_number(std::string_view& in, T& out) {
+    std::string_view f = next_field(in);
+    if (f.empty()) return false;
+    auto [ptr, ec] = std::from_chars(f.data(), f.data() + f.size(), out);
+    return ec == std::errc() && ptr == f.data() + f.size();
+}
+
+/// Every node ("<id> <host>:<port>") and token ("<token> <owner>") entry
+/// takes at least two space-separated fields of one character each, so a
+/// count above this cannot be genuine; checked before allocating for it.
+size_t max_entries(std::string_view rest) {
+    return rest.size() / 4;
+}
+
+}  // namespace
+
+bool TokenRouter::update(std::string_view payload) {
+    uint64_t version = 0;
+    uint32_t rf = 0;
+    size_t node_count = 0;
+    if (!next_number(payload, version) || !next_number(payload, rf) ||
+        !next_number(payload, node_count) || node_count == 0 ||
+        node_count > max_entries(payload)) {
+        return false;
+    }
+
+    std::vector<Node> nodes;
+    nodes.reserve(node_count);
+    for (size_t i = 0; i < node_count; i++) {
+        Node n;
+        if (!next_number(payload, n.node_id)) return false;
+        std::string_view addr = next_field(payload);
+        size_t colon = addr.rfind(':');
+        if (colon == std::string_view::npos) return false;
+        std::string_view port = addr.substr(colon + 1);
+        auto [ptr, ec] = std::from_chars(port.data(), port.data() + port.size(), n.port);
+        if (ec != std::errc() || ptr != port.data() + port.size()) return false;
+        n.address = std::string(addr);
+        n.host    = std::string(addr.substr(0, colon));
+        nodes.push_back(std::move(n));
+    }
+
+    size_t token_count = 0;
+    if (!next_number(payload, token_count) || token_count == 0 ||
+        token_count > max_entries(payload)) {
+        return false;
+    }
+    std::vector<uint64_t> tokens(token_count);
+    std::vector<uint32_t> owners(token_count);
+    for (size_t i = 0; i < token_count; i++) {
+        if (!next_number(payload, tokens[i]) || !next_number(payload, owners[i]) ||
+            owners[i] >= node_count || (i > 0 && tokens[i] <= tokens[i - 1])) {
+            return false;
+        }
+    }
+    if (!next_field(payload).empty()) return false;  // trailing junk
+
+    version_            = version;
+    replication_factor_ = std::max<uint32_t>(rf, 1);
+    nodes_              = std::move(nodes);
+    tokens_             = std::move(tokens);
+    owners_             = std::move(owners);
+    return true;
+}
+
+size_t TokenRouter::first_token(const std::string& key) const {
+    // Same walk as HashRing: the first token strictly above the hash.
+    auto it = std::upper_bound(tokens_.begin(), tokens_.end(), murmurhash3(key));
+    return it == tokens_.end() ? 0 : static_cast<size_t>(it - tokens_.begin());
+}
+
+size_t TokenRouter::primary(const std::string& key) const {
+    return owners_[first_token(key)];
+}
+
+std::vector<size_t> TokenRouter::replicas(const std::string& key) const {
+    std::vector<size_t> out;
+    if (tokens_.empty()) return out;
+
+    const size_t want = std::min<size_t>(replication_factor_, nodes_.size());
+    size_t t = first_token(key);
+    for (size_t visited = 0; visited < tokens_.size() && out.size() < want; visited++) {
+        size_t owner = owners_[t];
+        if (std::find(out.begin(), out.end(), owner) == out.end()) {
+            out.push_back(owner);
+        }
+        if (++t == tokens_.size()) t = 0;
+    }
+    return out;
+}
+
+}  // namespace dkv
@@ -2,6 +2,7 @@
 
 #include <cstring>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 namespace dkv {
@@ -20,6 +21,12 @@ Config parse_args(int argc, char* argv[]) {
             cfg.node_id = static_cast<uint32_t>(std::stoul(argv[++i]));
         } else if (match("--cluster-conf")) {
             cfg.cluster_conf = argv[++i];
+        } else if (match("--join")) {
+            cfg.join = argv[++i];
+        } else if (match("--advertise-address")) {
+            cfg.advertise_address = argv[++i];
+        } else if (match("--metrics-port")) {
+            cfg.metrics_port = static_cast<uint16_t>(std::stoi(argv[++i]));
         } else if (match("--replication-factor")) {
             cfg.replication_factor = static_cast<uint32_t>(std::stoul(argv[++i]));
         } else if (match("--write-quorum")) {
@@ -38,12 +45,70 @@ Config parse_args(int argc, char* argv[]) {
             cfg.fsync_interval_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
         } else if (match("--worker-threads")) {
             cfg.worker_threads = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--output-high-water")) {
+            cfg.output_high_water = std::stoull(argv[++i]);
+        } else if (match("--output-low-water")) {
+            cfg.output_low_water = std::stoull(argv[++i]);
+        } else if (match("--output-hard-limit")) {
+            cfg.output_hard_limit = std::stoull(argv[++i]);
+        } else if (match("--output-global-high-water")) {
+            cfg.output_global_high_water = std::stoull(argv[++i]);
+        } else if (match("--replication-batch-bytes")) {
+            cfg.replication_batch_bytes = std::stoull(argv[++i]);
+        } else if (match("--replication-batch-linger-us")) {
+            cfg.replication_batch_linger_us = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--digest-reads")) {
+            cfg.digest_reads = std::stoul(argv[++i]) != 0;
+        } else if (match("--hedged-reads")) {
+            cfg.hedged_reads = std::stoul(argv[++i]) != 0;
+        } else if (match("--hedge-min-delay-us")) {
+            cfg.hedge_min_delay_us = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--dynamic-snitch")) {
+            cfg.dynamic_snitch = std::stoul(argv[++i]) != 0;
+        } else if (match("--hot-cache-keys")) {
+            cfg.hot_cache_keys = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--hot-cache-lease-ms")) {
+            cfg.hot_cache_lease_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--repair-queue-bytes")) {
+            cfg.repair_queue_bytes = std::stoull(argv[++i]);
+        } else if (match("--repair-rate-bytes")) {
+            cfg.repair_rate_bytes = std::stoull(argv[++i]);
+        } else if (match("--repair-batch")) {
+            cfg.repair_batch = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--anti-entropy-interval-ms")) {
+            cfg.anti_entropy_interval_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--anti-entropy-rate-bytes")) {
+            cfg.anti_entropy_rate_bytes = std::stoull(argv[++i]);
+        } else if (match("--anti-entropy-max-leaves")) {
+            cfg.anti_entropy_max_leaves = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--rebalance-rate-bytes")) {
+            cfg.rebalance_rate_bytes = std::stoull(argv[++i]);
+        } else if (match("--rebalance-chunk-bytes")) {
+            cfg.rebalance_chunk_bytes = std::stoull(argv[++i]);
         } else if (match("--heartbeat-interval-ms")) {
             cfg.heartbeat_interval_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
         } else if (match("--heartbeat-timeout-ms")) {
             cfg.heartbeat_timeout_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--phi-suspect-threshold")) {
+            cfg.phi_suspect_threshold = std::stod(argv[++i]);
+        } else if (match("--phi-convict-threshold")) {
+            cfg.phi_convict_threshold = std::stod(argv[++i]);
+        } else if (match("--phi-acceptable-pause-ms")) {
+            cfg.phi_acceptable_pause_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--gossip")) {
+            cfg.gossip = std::stoul(argv[++i]) != 0;
+        } else if (match("--gossip-indirect-probes")) {
+            cfg.gossip_indirect_probes = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (match("--gossip-suspicion-mult")) {
+            cfg.gossip_suspicion_mult = static_cast<uint32_t>(std::stoul(argv[++i]));
         } else if (match("--hints-dir")) {
             cfg.hints_dir = argv[++i];
+        } else if (match("--hint-max-bytes")) {
+            cfg.hint_max_bytes = std::stoull(argv[++i]);
+        } else if (match("--hint-max-age-ms")) {
+            cfg.hint_max_age_ms = std::stoull(argv[++i]);
+        } else if (match("--hint-sync-interval-ms")) {
+            cfg.hint_sync_interval_ms = static_cast<uint32_t>(std::stoul(argv[++i]));
         } else if (match("--log-level")) {
             cfg.log_level = argv[++i];
         } else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
@@ -52,6 +117,13 @@ Config parse_args(int argc, char* argv[]) {
                       << "  --port <PORT>                Listen port (default: 7001)\n"
                       << "  --node-id <ID>               Unique node identifier (default: 1)\n"
                       << "  --cluster-conf <PATH>        Cluster config file (default: cluster.conf)\n"
+                      << "  --join <HOST:PORT>           Join a running cluster through this node\n"
+                      << "                               instead of reading --cluster-conf\n"
+                      << "  --advertise-address <HOST:PORT>\n"
+                      << "                               Address peers reach this node at\n"
+                      << "                               (default: 127.0.0.1:<port>)\n"
+                      << "  --metrics-port <PORT>        Serve Prometheus metrics at\n"
+                      << "                               http://<host>:<PORT>/metrics (default: 0 = off)\n"
                       << "  --replication-factor <N>     Replication factor (default: 3)\n"
                       << "  --write-quorum <W>           Write quorum (default: 2)\n"
                       << "  --read-quorum <R>            Read quorum (default: 2)\n"
@@ -61,9 +133,78 @@ Config parse_args(int argc, char* argv[]) {
                       << "  --snapshot-interval <OPS>    Ops between snapshots (default: 100000)\n"
                       << "  --fsync-interval-ms <MS>     Max ms between fsyncs (default: 10)\n"
                       << "  --worker-threads <N>         Worker threads (default: 4)\n"
+                      << "  --output-high-water <BYTES>  Pause reading from a client above this much\n"
+                      << "                               unsent output (default: 1048576, 0 = off)\n"
+                      << "  --output-low-water <BYTES>   Resume reading at this much (default: 262144)\n"
+                      << "  --output-hard-limit <BYTES>  Disconnect a client above this much\n"
+                      << "                               (default: 268435456, 0 = off)\n"
+                      << "  --output-global-high-water <BYTES>\n"
+                      << "                               Pause all clients with output pending above\n"
+                      << "                               this total (default: 1073741824, 0 = off)\n"
+                      << "  --replication-batch-bytes <BYTES>\n"
+                      << "                               Coalesce replica writes into batches of up\n"
+                      << "                               to this size (default: 65536, 0 = off)\n"
+                      << "  --replication-batch-linger-us <US>\n"
+                      << "                               Max time a write waits for a batch to fill\n"
+                      << "                               (default: 0 = send when the loop is idle)\n"
+                      << "  --digest-reads <0|1>         Read the value from one replica and only\n"
+                      << "                               versions from the rest (default: 1)\n"
+                      << "  --hedged-reads <0|1>         Send a GET to one more replica when it is\n"
+                      << "                               slower than the p95 read (default: 0)\n"
+                      << "  --hedge-min-delay-us <US>    Minimum wait before hedging (default: 1000)\n"
+                      << "  --dynamic-snitch <0|1>       Read from the replicas with the lowest\n"
+                      << "                               latency and load rather than in ring\n"
+                      << "                               order (default: 1)\n"
+                      << "  --hot-cache-keys <N>         Serve reads of up to N hot keys from this\n"
+                      << "                               coordinator (default: 0 = detect only)\n"
+                      << "  --hot-cache-lease-ms <MS>    How long a cached read is served; bounds\n"
+                      << "                               staleness (default: 100)\n"
+                      << "  --repair-queue-bytes <BYTES> Max queued read-repair data; more is dropped\n"
+                      << "                               (default: 67108864)\n"
+                      << "  --repair-rate-bytes <BYTES>  Read-repair bandwidth per second\n"
+                      << "                               (default: 16777216, 0 = unlimited)\n"
+                      << "  --repair-batch <N>           Repairs sent to a replica at once (default: 64)\n"
+                      << "  --anti-entropy-interval-ms <MS>\n"
+                      << "                               Merkle-tree sync with one replica every MS\n"
+                      << "                               (default: 10000, 0 = off)\n"
+                      << "  --anti-entropy-rate-bytes <BYTES>\n"
+                      << "                               Anti-entropy bandwidth per second\n"
+                      << "                               (default: 4194304, 0 = unlimited)\n"
+                      << "  --anti-entropy-max-leaves <N>\n"
+                      << "                               Differing leaves repaired per round (default: 256)\n"
+                      << "  --rebalance-rate-bytes <BYTES>\n"
+                      << "                               Range transfer bandwidth per second when a\n"
+                      << "                               node joins or leaves (default: 33554432,\n"
+                      << "                               0 = unlimited)\n"
+                      << "  --rebalance-chunk-bytes <BYTES>\n"
+                      << "                               Data per transfer request (default: 1048576)\n"
                       << "  --heartbeat-interval-ms <MS> Heartbeat period (default: 1000)\n"
-                      << "  --heartbeat-timeout-ms <MS>  Down detection timeout (default: 5000)\n"
+                      << "  --heartbeat-timeout-ms <MS>  Down detection timeout of the fixed\n"
+                      << "                               detector (default: 5000)\n"
+                      << "  --phi-suspect-threshold <PHI>\n"
+                      << "                               Suspicion at which a peer is SUSPECTED and\n"
+                      << "                               read last (default: 5)\n"
+                      << "  --phi-convict-threshold <PHI>\n"
+                      << "                               Suspicion at which a peer is DOWN\n"
+                      << "                               (default: 8, 0 = fixed detector: 3 missed\n"
+                      << "                               PINGs, then --heartbeat-timeout-ms)\n"
+                      << "  --phi-acceptable-pause-ms <MS>\n"
+                      << "                               Silence past the usual interval that is not\n"
+                      << "                               suspicious at all (default: 1000)\n"
+                      << "  --gossip <0|1>               SWIM gossip: probe one random peer per\n"
+                      << "                               heartbeat interval and spread state changes\n"
+                      << "                               on the probes, instead of pinging every\n"
+                      << "                               peer (default: 1; replaces the phi detector)\n"
+                      << "  --gossip-indirect-probes <K> Peers asked to probe a node that missed an\n"
+                      << "                               ACK (default: 3)\n"
+                      << "  --gossip-suspicion-mult <M>  Intervals (times log10 of the cluster size)\n"
+                      << "                               a suspect has to refute (default: 4)\n"
                       << "  --hints-dir <PATH>           Hinted handoff directory (default: ./data/hints/)\n"
+                      << "  --hint-max-bytes <BYTES>     Hints kept per down node; more are dropped\n"
+                      << "                               (default: 1073741824, 0 = no cap)\n"
+                      << "  --hint-max-age-ms <MS>       Discard hints older than this\n"
+                      << "                               (default: 10800000, 0 = never)\n"
+                      << "  --hint-sync-interval-ms <MS> Max ms between hint log fsyncs (default: 1000)\n"
                       << "  --log-level <LEVEL>          Log level: DEBUG|INFO|WARN|ERROR|FATAL (default: INFO)\n"
                       << "  -h, --help                   Show this help\n";
             std::exit(0);
@@ -76,12 +217,35 @@ Config parse_args(int argc, char* argv[]) {
 }
 
 void print_config(const Config& cfg) {
+    std::ostringstream detector;
+    if (cfg.gossip) {
+        detector << "gossip, k " << cfg.gossip_indirect_probes << ", suspicion x"
+                 << cfg.gossip_suspicion_mult;
+    } else if (cfg.phi_convict_threshold > 0) {
+        detector << "phi " << cfg.phi_suspect_threshold << "/"
+                 << cfg.phi_convict_threshold << ", pause "
+                 << cfg.phi_acceptable_pause_ms << " ms";
+    } else {
+        detector << "fixed";
+    }
+
+    std::ostringstream hot_cache;
+    if (cfg.hot_cache_keys > 0) {
+        hot_cache << cfg.hot_cache_keys << " keys, " << cfg.hot_cache_lease_ms
+                  << " ms lease";
+    } else {
+        hot_cache << "off (detect only)";
+    }
+
     std::cout << "┌──────────────────────────────────────────┐\n"
               << "│         DKV Node Configuration           │\n"
               << "├──────────────────────────────────────────┤\n"
               << "│  Node ID:              " << cfg.node_id << "\n"
               << "│  Port:                 " << cfg.port << "\n"
-              << "│  Cluster Config:       " << cfg.cluster_conf << "\n"
+              << "│  Metrics Port:         "
+              << (cfg.metrics_port ? std::to_string(cfg.metrics_port) : "off") << "\n"
+              << "│  Cluster Config:       "
+              << (cfg.join.empty() ? cfg.cluster_conf : "join via " + cfg.join) << "\n"
               << "│  Replication Factor:   " << cfg.replication_factor << "\n"
               << "│  Write Quorum (W):     " << cfg.write_quorum << "\n"
               << "│  Read Quorum (R):      " << cfg.read_quorum << "\n"
@@ -91,9 +255,32 @@ void print_config(const Config& cfg) {
               << "│  Snapshot Interval:    " << cfg.snapshot_interval << " ops\n"
               << "│  Fsync Interval:       " << cfg.fsync_interval_ms << " ms\n"
               << "│  Worker Threads:       " << cfg.worker_threads << "\n"
+              << "│  Output High/Low:      " << cfg.output_high_water << " / "
+              << cfg.output_low_water << " B\n"
+              << "│  Output Hard Limit:    " << cfg.output_hard_limit << " B\n"
+              << "│  Output Global HWM:    " << cfg.output_global_high_water << " B\n"
+              << "│  Replication Batch:    " << cfg.replication_batch_bytes << " B, "
+              << cfg.replication_batch_linger_us << " us linger\n"
+              << "│  Digest Reads:         " << (cfg.digest_reads ? "on" : "off") << "\n"
+              << "│  Hedged Reads:         " << (cfg.hedged_reads ? "on" : "off")
+              << ", min " << cfg.hedge_min_delay_us << " us\n"
+              << "│  Replica Selection:    "
+              << (cfg.dynamic_snitch ? "dynamic snitch" : "ring order") << "\n"
+              << "│  Hot-Key Cache:        " << hot_cache.str() << "\n"
+              << "│  Read Repair:          " << cfg.repair_queue_bytes << " B queue, "
+              << cfg.repair_rate_bytes << " B/s, batch " << cfg.repair_batch << "\n"
+              << "│  Anti-Entropy:         every " << cfg.anti_entropy_interval_ms
+              << " ms, " << cfg.anti_entropy_rate_bytes << " B/s, "
+              << cfg.anti_entropy_max_leaves << " leaves\n"
+              << "│  Rebalance:            " << cfg.rebalance_rate_bytes << " B/s, "
+              << cfg.rebalance_chunk_bytes << " B chunks\n"
               << "│  Heartbeat Interval:   " << cfg.heartbeat_interval_ms << " ms\n"
               << "│  Heartbeat Timeout:    " << cfg.heartbeat_timeout_ms << " ms\n"
+              << "│  Failure Detector:     " << detector.str() << "\n"
               << "│  Hints Directory:      " << cfg.hints_dir << "\n"
+              << "│  Hint Limits:          " << cfg.hint_max_bytes << " B, "
+              << cfg.hint_max_age_ms << " ms max age, sync "
+              << cfg.hint_sync_interval_ms << " ms\n"
               << "│  Log Level:            " << cfg.log_level << "\n"
               << "└──────────────────────────────────────────┘\n";
 }
@@ -4,16 +4,23 @@
 #include "cluster/hash_ring.h"
 #include "cluster/heartbeat.h"
 #include "cluster/membership.h"
+#include "cluster/token_router.h"
 #include "config/config.h"
+#include "network/metrics_http.h"
 #include "network/tcp_server.h"
 #include "storage/snapshot.h"
 #include "storage/storage_engine.h"
 #include "storage/wal.h"
 
 #include "utils/logger.h"
+#include "utils/metrics.h"
 
+#include <algorithm>
 #include <csignal>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <vector>
 
 static dkv::TCPServer* g_server = nullptr;
 
@@ -40,29 +47,59 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // ── Parse cluster configuration ─────────────────────────────────────────
-    auto cluster_entries = dkv::parse_cluster_config(cfg.cluster_conf);
-    LOG_INFO("[BOOT] Loaded " << cluster_entries.size()
-             << " nodes from " << cfg.cluster_conf);
-
     // ── Build hash ring ─────────────────────────────────────────────────────
     dkv::HashRing ring;
-    for (const auto& entry : cluster_entries) {
-        // Derive node_id from the name (e.g. "node1" -> 1, "node2" -> 2)
-        uint32_t id = 0;
-        for (char c : entry.name) {
-            if (c >= '0' && c <= '9') {
-                id = id * 10 + static_cast<uint32_t>(c - '0');
+    std::vector<dkv::NodeInfo> peers;  // every other node, for membership
+    if (cfg.join.empty()) {
+        auto cluster_entries = dkv::parse_cluster_config(cfg.cluster_conf);
+        LOG_INFO("[BOOT] Loaded " << cluster_entries.size()
+                 << " nodes from " << cfg.cluster_conf);
+
+        for (const auto& entry : cluster_entries) {
+            // Derive node_id from the name (e.g. "node1" -> 1, "node2" -> 2)
+            uint32_t id = 0;
+            for (char c : entry.name) {
+                if (c >= '0' && c <= '9') {
+                    id = id * 10 + static_cast<uint32_t>(c - '0');
+                }
+            }
+            if (id == 0) {
+                id = static_cast<uint32_t>(std::hash<std::string>{}(entry.name) & 0xFFFFFFFF);
+            }
+
+            std::string address = entry.host + ":" + std::to_string(entry.port);
+            ring.add_node(id, address, cfg.vnodes);
+            if (id != cfg.node_id) peers.push_back(dkv::NodeInfo{id, address});
+            LOG_DEBUG("[BOOT] Ring: " << entry.name << " (id=" << id
+                      << ") -> " << address);
+        }
+    } else {
+        // Joining a running cluster: start from its current ring.  This node
+        // is added to it (everywhere at once) after its ranges are copied.
+        dkv::RpcClient seed(2000);
+        dkv::RpcResult r = seed.call_sync(cfg.join, dkv::BinaryOpcode::TOPOLOGY);
+        dkv::TokenRouter topology;
+        if (r.status != dkv::RpcStatus::OK || r.opcode != dkv::BinaryOpcode::VALUE ||
+            !topology.update(r.value)) {
+            LOG_FATAL("Could not fetch the ring from " << cfg.join);
+            return 1;
+        }
+        for (const auto& n : topology.nodes()) {
+            if (n.node_id == cfg.node_id) {
+                LOG_FATAL("Node " << cfg.node_id << " is already in the ring");
+                return 1;
             }
+            ring.add_node(n.node_id, n.address, cfg.vnodes);
+            peers.push_back(dkv::NodeInfo{n.node_id, n.address});
         }
-        if (id == 0) {
-            id = static_cast<uint32_t>(std::hash<std::string>{}(entry.name) & 0xFFFFFFFF);
+        if (ring.size() != topology.token_count()) {
+            LOG_FATAL("Ring from " << cfg.join << " has " << topology.token_count()
+                      << " tokens; --vnodes " << cfg.vnodes << " gives "
+                      << ring.size());
+            return 1;
         }
-
-        std::string address = entry.host + ":" + std::to_string(entry.port);
-        ring.add_node(id, address, cfg.vnodes);
-        LOG_DEBUG("[BOOT] Ring: " << entry.name << " (id=" << id
-                  << ") -> " << address);
+        LOG_INFO("[BOOT] Joining via " << cfg.join << " (ring version "
+                 << topology.version() << ")");
     }
 
     LOG_INFO("[BOOT] Hash ring: " << ring.node_count() << " physical nodes, "
@@ -131,21 +168,23 @@ int main(int argc, char* argv[]) {
 
     // Phase 6: Build membership tracker
     dkv::Membership membership(3, static_cast<int>(cfg.heartbeat_timeout_ms));
+    if (!cfg.gossip && cfg.phi_convict_threshold > 0) {
+        dkv::Membership::PhiOptions phi_opts;
+        phi_opts.enabled              = true;
+        phi_opts.suspect_phi          = cfg.phi_suspect_threshold;
+        phi_opts.down_phi             = cfg.phi_convict_threshold;
+        phi_opts.acceptable_pause_ms  = cfg.phi_acceptable_pause_ms;
+        phi_opts.expected_interval_ms = cfg.heartbeat_interval_ms;
+        membership.set_phi_accrual(phi_opts);
+    }
 
-    for (const auto& entry : cluster_entries) {
-        uint32_t id = 0;
-        for (char c : entry.name) {
-            if (c >= '0' && c <= '9') id = id * 10 + static_cast<uint32_t>(c - '0');
-        }
-        if (id == 0) id = static_cast<uint32_t>(std::hash<std::string>{}(entry.name) & 0xFFFFFFFF);
-        if (id == cfg.node_id) continue;
-        std::string addr = entry.host + ":" + std::to_string(entry.port);
-        membership.add_peer(id, addr);
+    for (const auto& peer : peers) {
+        membership.add_peer(peer.node_id, peer.address);
     }
 
     membership.set_rejoin_callback([&coordinator](uint32_t node_id, const std::string& addr) {
         LOG_INFO("[MEMBERSHIP] Node " << node_id << " at " << addr << " is UP - replaying hints");
-        coordinator.replay_hints_for(node_id, addr);
+        coordinator.schedule_hint_replay(node_id, addr);
     });
 
     membership.set_down_callback([](uint32_t node_id, const std::string& addr) {
@@ -154,22 +193,128 @@ int main(int argc, char* argv[]) {
 
     // Wire membership into coordinator so DOWN nodes are skipped in quorum ops.
     coordinator.set_membership(&membership);
+    coordinator.set_replication_batching(cfg.replication_batch_bytes,
+                                         cfg.replication_batch_linger_us);
+    coordinator.set_digest_reads(cfg.digest_reads);
+    dkv::RepairQueue::Options repair_opts;
+    repair_opts.max_bytes          = cfg.repair_queue_bytes;
+    repair_opts.rate_bytes_per_sec = cfg.repair_rate_bytes;
+    repair_opts.batch_max          = cfg.repair_batch;
+    coordinator.set_read_repair_limits(repair_opts);
+    coordinator.set_read_hedging(cfg.hedged_reads, cfg.hedge_min_delay_us);
+    coordinator.set_dynamic_snitch(cfg.dynamic_snitch);
+    coordinator.set_hot_key_cache(cfg.hot_cache_keys, cfg.hot_cache_lease_ms);
+    dkv::HintStore::Options hint_opts;
+    hint_opts.max_bytes        = cfg.hint_max_bytes;
+    hint_opts.max_age_ms       = cfg.hint_max_age_ms;
+    hint_opts.sync_interval_ms = cfg.hint_sync_interval_ms;
+    coordinator.set_hint_limits(hint_opts);
+    if (cfg.anti_entropy_interval_ms > 0) {
+        dkv::AntiEntropy::Options ae_opts;
+        ae_opts.interval_ms          = cfg.anti_entropy_interval_ms;
+        ae_opts.rate_bytes_per_sec   = cfg.anti_entropy_rate_bytes;
+        ae_opts.max_leaves_per_round = cfg.anti_entropy_max_leaves;
+        coordinator.start_anti_entropy(ae_opts);
+    }
+    dkv::Rebalancer::Options rebalance_opts;
+    rebalance_opts.rate_bytes_per_sec = cfg.rebalance_rate_bytes;
+    rebalance_opts.chunk_bytes        = cfg.rebalance_chunk_bytes;
+    rebalance_opts.vnodes             = cfg.vnodes;
+    coordinator.start_rebalancer(rebalance_opts);
 
-    // Phase 6: Start heartbeat
+    // Phase 6: Start failure detection (SWIM gossip, or heartbeat to all)
     dkv::Heartbeat heartbeat(membership, cfg.node_id,
                              static_cast<int>(cfg.heartbeat_interval_ms), 500);
-    heartbeat.start();
-    LOG_INFO("[BOOT] Heartbeat started (interval=" << cfg.heartbeat_interval_ms
-             << "ms, timeout=" << cfg.heartbeat_timeout_ms << "ms)");
+    if (cfg.gossip) {
+        dkv::Gossip::Options gossip_opts;
+        gossip_opts.period_ms        = cfg.heartbeat_interval_ms;
+        gossip_opts.probe_timeout_ms = std::min<uint32_t>(500, cfg.heartbeat_interval_ms / 4);
+        gossip_opts.indirect_probes  = cfg.gossip_indirect_probes;
+        gossip_opts.suspicion_mult   = cfg.gossip_suspicion_mult;
+        coordinator.start_gossip(gossip_opts);
+        LOG_INFO("[BOOT] Gossip started (interval=" << cfg.heartbeat_interval_ms
+                 << "ms, indirect probes=" << cfg.gossip_indirect_probes << ")");
+    } else {
+        heartbeat.start();
+        LOG_INFO("[BOOT] Heartbeat started (interval=" << cfg.heartbeat_interval_ms
+                 << "ms, timeout=" << cfg.heartbeat_timeout_ms << "ms)");
+    }
 
     // Create TCP server in cluster mode (routes through coordinator)
     dkv::TCPServer server(engine, coordinator, cfg.port,
                           cfg.worker_threads, cfg.node_id);
+    dkv::TCPServer::OutputLimits limits;
+    limits.high_water        = cfg.output_high_water;
+    limits.low_water         = cfg.output_low_water;
+    limits.hard_limit        = cfg.output_hard_limit;
+    limits.global_high_water = cfg.output_global_high_water;
+    server.set_output_limits(limits);
     g_server = &server;
 
+    // ── Metrics: callbacks over state the components already track ──────────
+    // Declared after everything they read, so the guard unregisters them
+    // (and the HTTP server stops) before any of it is destroyed.
+    struct CallbackGuard {
+        std::vector<std::string> gauges;
+        std::vector<std::string> counters;
+        ~CallbackGuard() {
+            for (const auto& n : gauges) dkv::Metrics::instance().remove_gauge(n);
+            for (const auto& n : counters) dkv::Metrics::instance().remove_counter_callback(n);
+        }
+    } callbacks;
+    auto gauge = [&callbacks](const char* name, const char* help,
+                              std::function<double()> fn) {
+        dkv::Metrics::instance().set_gauge(name, help, std::move(fn));
+        callbacks.gauges.emplace_back(name);
+    };
+    auto counter = [&callbacks](const char* name, const char* help,
+                                std::function<uint64_t()> fn) {
+        dkv::Metrics::instance().set_counter_callback(name, help, std::move(fn));
+        callbacks.counters.emplace_back(name);
+    };
+    gauge("dkv_in_flight_requests", "Commands handed to a worker and not yet answered",
+          [&server] { return static_cast<double>(server.in_flight()); });
+    gauge("dkv_output_queued_bytes", "Reply bytes queued across all client connections",
+          [&server] { return static_cast<double>(server.output_stats().output_bytes); });
+    gauge("dkv_paused_connections", "Client connections paused by output backpressure",
+          [&server] { return static_cast<double>(server.output_stats().paused_connections); });
+    counter("dkv_slow_client_disconnects_total", "Clients dropped at the output hard limit",
+            [&server] { return server.output_stats().slow_client_disconnects; });
+    gauge("dkv_pool_idle_connections", "Idle peer connections in the connection pool",
+          [&conn_pool] { return static_cast<double>(conn_pool.idle_connections()); });
+    gauge("dkv_hints_pending", "Hinted writes waiting for replay",
+          [&coordinator] { return static_cast<double>(coordinator.hint_stats().pending); });
+    gauge("dkv_hints_queued_bytes", "Bytes held by pending hints",
+          [&coordinator] { return static_cast<double>(coordinator.hint_stats().queued_bytes); });
+    counter("dkv_hints_delivered_total", "Hints delivered",
+            [&coordinator] { return coordinator.hint_stats().delivered; });
+    counter("dkv_hints_dropped_total", "Hints rejected by the size cap",
+            [&coordinator] { return coordinator.hint_stats().dropped; });
+    gauge("dkv_read_repair_queue_depth", "Read repairs waiting to be sent",
+          [&coordinator] { return static_cast<double>(coordinator.read_repair_stats().depth); });
+    counter("dkv_read_repairs_dropped_total", "Read repairs rejected by the memory cap",
+            [&coordinator] { return coordinator.read_repair_stats().dropped; });
+    counter("dkv_hedged_reads_total", "Quorum reads that sent a hedge request",
+            [&coordinator] { return coordinator.hedged_reads(); });
+    counter("dkv_digest_mismatches_total", "Digest reads that needed a full read",
+            [&coordinator] { return coordinator.digest_mismatches(); });
+    counter("dkv_replication_batches_total", "Replication batch frames sent",
+            [&coordinator] { return coordinator.replication_batch_stats().batches; });
+
+    dkv::MetricsHttpServer metrics_http(cfg.metrics_port);
+    if (cfg.metrics_port > 0 && !metrics_http.start()) {
+        LOG_WARN("[BOOT] Metrics endpoint disabled");
+    }
+
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
+    if (!cfg.join.empty()) {
+        coordinator.join_cluster_async(cfg.advertise_address.empty()
+            ? "127.0.0.1:" + std::to_string(cfg.port)
+            : cfg.advertise_address);
+    }
+
     LOG_INFO("[BOOT] Server running in cluster mode");
     server.run();
     heartbeat.stop();
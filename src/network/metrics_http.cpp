@@ -0,0 +1,140 @@
+#include "network/metrics_http.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace dkv {
+
+namespace {
+constexpr int    ACCEPT_POLL_MS    = 200;  // how often the loop checks running_
+constexpr int    CLIENT_TIMEOUT_MS = 2000;
+constexpr size_t MAX_REQUEST_BYTES = 8192;
+
+void send_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+}
+
+std::string http_response(std::string_view status, std::string_view content_type,
+                          std::string_view body) {
+    std::string out = "HTTP/1.1 ";
+    out += status;
+    out += "\r\nContent-Type: ";
+    out += content_type;
+    out += "\r\nContent-Length: " + std::to_string(body.size());
+    out += "\r\nConnection: close\r\n\r\n";
+    out += body;
+    return out;
+}
+}  // namespace
+
+MetricsHttpServer::MetricsHttpServer(uint16_t port) : port_(port) {}
+
+MetricsHttpServer::~MetricsHttpServer() { stop(); }
+
+bool MetricsHttpServer::start() {
+    if (running_.load()) return true;
+
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        LOG_ERROR("[METRICS] socket() failed: " << strerror(errno));
+        return false;
+    }
+    int opt = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port        = htons(port_);
+    if (::bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd_, 16) < 0) {
+        LOG_ERROR("[METRICS] Could not listen on port " << port_ << ": " << strerror(errno));
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    if (::getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), &len) == 0) {
+        port_ = ntohs(addr.sin_port);
+    }
+
+    running_.store(true);
+    thread_ = std::thread([this] { serve_loop(); });
+    LOG_INFO("[METRICS] Serving http://0.0.0.0:" << port_ << "/metrics");
+    return true;
+}
+
+void MetricsHttpServer::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+void MetricsHttpServer::serve_loop() {
+    while (running_.load(std::memory_order_relaxed)) {
+        struct pollfd pfd{listen_fd_, POLLIN, 0};
+        int n = ::poll(&pfd, 1, ACCEPT_POLL_MS);
+        if (n <= 0) continue;
+
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) continue;
+        struct timeval tv{CLIENT_TIMEOUT_MS / 1000, (CLIENT_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        serve_client(fd);
+        ::close(fd);
+    }
+}
+
+void MetricsHttpServer::serve_client(int fd) {
+    // Read up to the end of the headers; only the request line matters.
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.find("\n\n") == std::string::npos) {
+        if (request.size() >= MAX_REQUEST_BYTES) return;
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        request.append(buf, static_cast<size_t>(n));
+    }
+
+    std::string_view line(request);
+    line = line.substr(0, line.find_first_of("\r\n"));
+    const size_t method_end = line.find(' ');
+    const std::string_view method = line.substr(0, method_end);
+    std::string_view target =
+        method_end == std::string_view::npos ? std::string_view{} : line.substr(method_end + 1);
+    target = target.substr(0, target.find(' '));
+    target = target.substr(0, target.find('?'));
+
+    if ((method == "GET" || method == "HEAD") && target == "/metrics") {
+        std::string body = Metrics::instance().render(/*help=*/true);
+        std::string reply = http_response("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                                          body);
+        if (method == "HEAD") reply.resize(reply.size() - body.size());
+        send_all(fd, reply);
+    } else {
+        send_all(fd, http_response("404 Not Found", "text/plain", "not found\n"));
+    }
+}
+
+}  // namespace dkv
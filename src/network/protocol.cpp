@@ -47,12 +47,12 @@ bool parse_u64(const char* data, size_t end, size_t& pos, uint64_t& out) {
     return ec == std::errc{};
 }
 
-/// Read exactly `count` bytes starting at data[pos] into `out`.
+/// Point `out` at exactly `count` bytes starting at data[pos] (no copy).
 /// Advances `pos` by `count`.
 bool read_bytes(const char* data, size_t end, size_t& pos,
-                size_t count, std::string& out) {
+                size_t count, std::string_view& out) {
     if (pos + count > end) return false;
-    out.assign(data + pos, count);
+    out = std::string_view(data + pos, count);
     pos += count;
     return true;
 }
@@ -61,19 +61,19 @@ bool read_bytes(const char* data, size_t end, size_t& pos,
 
 // ── Parser ───────────────────────────────────────────────────────────────────
 
-ParseResult try_parse(const char* data, size_t len) {
+ParseViewResult try_parse_view(const char* data, size_t len) {
     // Find the first newline – that marks the end of this frame
     const char* nl = static_cast<const char*>(std::memchr(data, '\n', len));
     if (!nl) {
-        return {ParseStatus::INCOMPLETE, {}, 0, ""};
+        return {ParseStatus::INCOMPLETE, {}, 0, {}};
     }
 
     size_t frame_end  = static_cast<size_t>(nl - data);      // index of \n
     size_t total_size = frame_end + 1;                        // include \n
     size_t pos = 0;
 
-    // Macro-like helper: return an ERROR ParseResult
-    auto make_error = [&](const char* msg) -> ParseResult {
+    // Macro-like helper: return an ERROR ParseViewResult
+    auto make_error = [&](const char* msg) -> ParseViewResult {
         return {ParseStatus::ERROR, {}, total_size, msg};
     };
 
@@ -83,10 +83,10 @@ ParseResult try_parse(const char* data, size_t len) {
         ++cmd_end;
     }
 
-    std::string cmd_word(data + pos, cmd_end - pos);
+    std::string_view cmd_word(data + pos, cmd_end - pos);
     pos = cmd_end;
 
-    Command cmd{};
+    CommandView cmd{};
 
     // ── PING ────────────────────────────────────────────────────────────
     if (cmd_word == "PING") {
@@ -94,7 +94,58 @@ ParseResult try_parse(const char* data, size_t len) {
             return make_error("PING takes no arguments");
         }
         cmd.type = CommandType::PING;
-        return {ParseStatus::OK, cmd, total_size, ""};
+        return {ParseStatus::OK, cmd, total_size, {}};
+    }
+
+    // ── TOPOLOGY ────────────────────────────────────────────────────────
+    if (cmd_word == "TOPOLOGY") {
+        if (pos != frame_end) {
+            return make_error("TOPOLOGY takes no arguments");
+        }
+        cmd.type = CommandType::TOPOLOGY;
+        return {ParseStatus::OK, cmd, total_size, {}};
+    }
+
+    // ── DECOMMISSION ────────────────────────────────────────────────────
+    if (cmd_word == "DECOMMISSION") {
+        if (pos != frame_end) {
+            return make_error("DECOMMISSION takes no arguments");
+        }
+        cmd.type = CommandType::DECOMMISSION;
+        return {ParseStatus::OK, cmd, total_size, {}};
+    }
+
+    // ── HOTKEYS ─────────────────────────────────────────────────────────
+    if (cmd_word == "HOTKEYS") {
+        if (pos != frame_end) {
+            return make_error("HOTKEYS takes no arguments");
+        }
+        cmd.type = CommandType::HOTKEYS;
+        return {ParseStatus::OK, cmd, total_size, {}};
+    }
+
+    // ── STATS ───────────────────────────────────────────────────────────
+    if (cmd_word == "STATS") {
+        if (pos != frame_end) {
+            return make_error("STATS takes no arguments");
+        }
+        cmd.type = CommandType::STATS;
+        return {ParseStatus::OK, cmd, total_size, {}};
+    }
+
+    // ── MGET / MSET ─────────────────────────────────────────────────────
+    // The argument list stays in `value` and is split by the executor.
+    if (cmd_word == "MGET" || cmd_word == "MSET") {
+        cmd.type = cmd_word == "MGET" ? CommandType::MGET : CommandType::MSET;
+
+        if (!consume_space(data, frame_end, pos))
+            return make_error("expected space after command");
+
+        cmd.value = std::string_view(data + pos, frame_end - pos);
+        if (!valid_multi_args(cmd.value, cmd.type == CommandType::MSET))
+            return make_error("malformed key list");
+
+        return {ParseStatus::OK, cmd, total_size, {}};
     }
 
     // ── GET / DEL ───────────────────────────────────────────────────────
@@ -117,7 +168,7 @@ ParseResult try_parse(const char* data, size_t len) {
         if (pos != frame_end)
             return make_error("trailing data after key");
 
-        return {ParseStatus::OK, cmd, total_size, ""};
+        return {ParseStatus::OK, cmd, total_size, {}};
     }
 
     // ── SET ─────────────────────────────────────────────────────────────
@@ -153,7 +204,7 @@ ParseResult try_parse(const char* data, size_t len) {
         if (pos != frame_end)
             return make_error("trailing data after value");
 
-        return {ParseStatus::OK, cmd, total_size, ""};
+        return {ParseStatus::OK, cmd, total_size, {}};
     }
 
     // ── FWD (internal forwarding) ────────────────────────────────────────
@@ -174,18 +225,22 @@ ParseResult try_parse(const char* data, size_t len) {
         // Store the rest of the line as an opaque inner command string
         if (pos >= frame_end)
             return make_error("missing inner command");
-        cmd.inner_line.assign(data + pos, frame_end - pos);
+        cmd.inner_line = std::string_view(data + pos, frame_end - pos);
 
-        return {ParseStatus::OK, cmd, total_size, ""};
+        return {ParseStatus::OK, cmd, total_size, {}};
     }
 
-    // ── RGET (internal versioned GET) ────────────────────────────────────
+    // ── RGET / RDIGEST (internal versioned GET) ──────────────────────────
     // Wire: RGET <key_len> <key>\n  — response: $V ... or -NOT_FOUND\n
-    if (cmd_word == "RGET") {
-        cmd.type = CommandType::RGET;
+    // RDIGEST takes the same arguments; its $V response has an empty value.
+    if (cmd_word == "RGET" || cmd_word == "RDIGEST") {
+        cmd.type = cmd_word == "RGET" ? CommandType::RGET
+                                      : CommandType::RDIGEST;
 
         if (!consume_space(data, frame_end, pos))
-            return make_error("expected space after RGET");
+            return make_error(cmd_word == "RGET"
+                                  ? "expected space after RGET"
+                                  : "expected space after RDIGEST");
 
         uint32_t key_len = 0;
         if (!parse_u32(data, frame_end, pos, key_len))
@@ -200,7 +255,7 @@ ParseResult try_parse(const char* data, size_t len) {
         if (pos != frame_end)
             return make_error("trailing data after key");
 
-        return {ParseStatus::OK, cmd, total_size, ""};
+        return {ParseStatus::OK, cmd, total_size, {}};
     }
 
     // ── RSET (internal replicated SET with explicit version) ─────────────
@@ -249,7 +304,7 @@ ParseResult try_parse(const char* data, size_t len) {
         if (pos != frame_end)
             return make_error("trailing data after node_id");
 
-        return {ParseStatus::OK, cmd, total_size, ""};
+        return {ParseStatus::OK, cmd, total_size, {}};
     }
 
     // ── RDEL (internal replicated DEL with explicit version) ─────────────
@@ -285,20 +340,79 @@ ParseResult try_parse(const char* data, size_t len) {
         if (pos != frame_end)
             return make_error("trailing data after node_id");
 
-        return {ParseStatus::OK, cmd, total_size, ""};
+        return {ParseStatus::OK, cmd, total_size, {}};
     }
 
     return make_error("unknown command");
 }
 
+ParseResult try_parse(const char* data, size_t len) {
+    ParseViewResult view = try_parse_view(data, len);
+    ParseResult result{view.status, {}, view.bytes_consumed,
+                       std::string(view.error_msg)};
+    if (view.status == ParseStatus::OK) {
+        result.command = view.command.to_command();
+    }
+    return result;
+}
+
+Command CommandView::to_command() const {
+    Command cmd{};
+    cmd.type           = type;
+    cmd.key            = std::string(key);
+    cmd.value          = std::string(value);
+    cmd.timestamp_ms   = timestamp_ms;
+    cmd.node_id        = node_id;
+    cmd.hops_remaining = hops_remaining;
+    cmd.inner_line     = std::string(inner_line);
+    return cmd;
+}
+
 // ── Response formatters ──────────────────────────────────────────────────────
 
 std::string format_ok() {
     return "+OK\n";
 }
 
-std::string format_value(const std::string& value) {
-    return "$" + std::to_string(value.size()) + " " + value + "\n";
+std::string format_value(std::string_view value) {
+    // Single allocation: large values are copied exactly once.
+    std::string len = std::to_string(value.size());
+    std::string out;
+    out.reserve(1 + len.size() + 1 + value.size() + 1);
+    out += '$';
+    out += len;
+    out += ' ';
+    out += value;
+    out += '\n';
+    return out;
+}
+
+const char* command_name(CommandType type) {
+    switch (type) {
+        case CommandType::SET:          return "SET";
+        case CommandType::GET:          return "GET";
+        case CommandType::DEL:          return "DEL";
+        case CommandType::PING:         return "PING";
+        case CommandType::FWD:          return "FWD";
+        case CommandType::TOPOLOGY:     return "TOPOLOGY";
+        case CommandType::DECOMMISSION: return "DECOMMISSION";
+        case CommandType::HOTKEYS:      return "HOTKEYS";
+        case CommandType::STATS:        return "STATS";
+        case CommandType::MGET:         return "MGET";
+        case CommandType::MSET:         return "MSET";
+        case CommandType::RSET:         return "RSET";
+        case CommandType::RDEL:         return "RDEL";
+        case CommandType::RGET:         return "RGET";
+        case CommandType::RDIGEST:      return "RDIGEST";
+        case CommandType::RBATCH:       return "RBATCH";
+        case CommandType::AEHASH:       return "AEHASH";
+        case CommandType::AEKEYS:       return "AEKEYS";
+        case CommandType::RSCAN:        return "RSCAN";
+        case CommandType::RLOAD:        return "RLOAD";
+        case CommandType::RING:         return "RING";
+        case CommandType::GOSSIP:       return "GOSSIP";
+    }
+    return "UNKNOWN";
 }
 
 std::string format_error(const std::string& message) {
@@ -317,70 +431,526 @@ std::string format_forward(uint32_t hops, const std::string& inner_line) {
     return "FWD " + std::to_string(hops) + " " + inner_line + "\n";
 }
 
-std::string format_versioned_value(const std::string& value,
+std::string format_versioned_value(std::string_view value,
                                    uint64_t timestamp_ms, uint32_t node_id) {
-    return "$V " + std::to_string(value.size()) + " " + value + " "
-         + std::to_string(timestamp_ms) + " "
-         + std::to_string(node_id) + "\n";
+    std::string len  = std::to_string(value.size());
+    std::string ts   = std::to_string(timestamp_ms);
+    std::string node = std::to_string(node_id);
+    std::string out;
+    out.reserve(3 + len.size() + 1 + value.size() + 1 + ts.size() + 1
+                + node.size() + 1);
+    out += "$V ";
+    out += len;
+    out += ' ';
+    out += value;
+    out += ' ';
+    out += ts;
+    out += ' ';
+    out += node;
+    out += '\n';
+    return out;
 }
 
-VersionedGetResult parse_versioned_response(const std::string& resp) {
-    VersionedGetResult result;
-
-    // -NOT_FOUND\n
-    if (resp == "-NOT_FOUND\n") {
-        return result;  // found=false
-    }
-
-    // $V <val_len> <value> <timestamp_ms> <node_id>\n
-    if (resp.size() < 4 || resp[0] != '$' || resp[1] != 'V' || resp[2] != ' ') {
-        return result;  // unrecognised / error response
-    }
+namespace {
 
-    // Work on the content between "$V " and the trailing '\n'
-    const char* p   = resp.data() + 3;             // after "$V "
-    const char* end = resp.data() + resp.size() - 1; // points at '\n'
+/// Split "$V <val_len> <value> <timestamp_ms> <node_id>" (no trailing
+/// newline) without copying; `value` points into `text`.
+bool split_versioned_value(std::string_view text, std::string_view& value,
+                           uint64_t& timestamp_ms, uint32_t& node_id) {
+    if (text.size() < 3 || text.compare(0, 3, "$V ") != 0) return false;
 
-    if (p >= end) return result;
+    const char* p   = text.data() + 3;  // after "$V "
+    const char* end = text.data() + text.size();
+    if (p >= end) return false;
 
     // Parse val_len
     uint32_t val_len = 0;
     {
         const char* sp = static_cast<const char*>(std::memchr(p, ' ',
                              static_cast<size_t>(end - p)));
-        if (!sp) return result;
+        if (!sp) return false;
         auto [ptr, ec] = std::from_chars(p, sp, val_len);
-        if (ec != std::errc{}) return result;
+        if (ec != std::errc{}) return false;
         p = sp + 1;
     }
 
-    // Read val_len bytes of value
-    if (p + val_len > end) return result;
-    result.value.assign(p, val_len);
+    // val_len bytes of value, then a space before timestamp_ms
+    if (val_len > static_cast<size_t>(end - p)) return false;
+    value = std::string_view(p, val_len);
     p += val_len;
-
-    // Expect space before timestamp_ms
-    if (p >= end || *p != ' ') return result;
+    if (p >= end || *p != ' ') return false;
     ++p;
 
     // Parse timestamp_ms (u64)
     {
         const char* sp = static_cast<const char*>(std::memchr(p, ' ',
                              static_cast<size_t>(end - p)));
-        if (!sp) return result;
-        auto [ptr, ec] = std::from_chars(p, sp, result.timestamp_ms);
-        if (ec != std::errc{}) return result;
+        if (!sp) return false;
+        auto [ptr, ec] = std::from_chars(p, sp, timestamp_ms);
+        if (ec != std::errc{}) return false;
         p = sp + 1;
     }
 
     // Parse node_id (u32)
-    {
-        auto [ptr, ec] = std::from_chars(p, end, result.node_id);
-        if (ec != std::errc{}) return result;
-    }
+    auto [ptr, ec] = std::from_chars(p, end, node_id);
+    return ec == std::errc{} && ptr == end;
+}
 
+}  // namespace
+
+VersionedGetResult parse_versioned_response(const std::string& resp) {
+    VersionedGetResult result;
+
+    // -NOT_FOUND\n, an error, or anything unrecognised: not found.
+    if (resp.empty() || resp.back() != '\n') return result;
+
+    std::string_view value;
+    if (!split_versioned_value(std::string_view(resp).substr(0, resp.size() - 1),
+                               value, result.timestamp_ms, result.node_id)) {
+        return result;
+    }
+    result.value.assign(value);
     result.found = true;
     return result;
 }
 
+// ── Multi-key commands ───────────────────────────────────────────────────────
+
+namespace {
+
+/// Walk an MGET/MSET argument list, calling on_count(count) once and then
+/// on_arg(arg) for every key.  Returns false if it is malformed.
+template <typename OnCount, typename OnArg>
+bool walk_multi_args(std::string_view args, bool with_values, OnCount&& on_count,
+                     OnArg&& on_arg) {
+    const char* data = args.data();
+    const size_t end = args.size();
+    size_t pos = 0;
+
+    uint32_t count = 0;
+    if (!parse_u32(data, end, pos, count) || count == 0 || count > MAX_MULTI_KEYS) {
+        return false;
+    }
+    on_count(count);
+    for (uint32_t i = 0; i < count; i++) {
+        MultiKeyArg arg;
+        uint32_t key_len = 0;
+        if (!consume_space(data, end, pos) || !parse_u32(data, end, pos, key_len) ||
+            key_len == 0 || !consume_space(data, end, pos) ||
+            !read_bytes(data, end, pos, key_len, arg.key)) {
+            return false;
+        }
+        if (with_values) {
+            uint32_t val_len = 0;
+            if (!consume_space(data, end, pos) || !parse_u32(data, end, pos, val_len) ||
+                !consume_space(data, end, pos) ||
+                !read_bytes(data, end, pos, val_len, arg.value)) {
+                return false;
+            }
+        }
+        on_arg(arg);
+    }
+    return pos == end;
+}
+
+}  // namespace
+
+bool parse_multi_args(std::string_view args, bool with_values,
+                      std::vector<MultiKeyArg>& out) {
+    out.clear();
+    return walk_multi_args(
+        args, with_values, [&out](uint32_t count) { out.reserve(count); },
+        [&out](const MultiKeyArg& arg) { out.push_back(arg); });
+}
+
+bool valid_multi_args(std::string_view args, bool with_values) {
+    return walk_multi_args(args, with_values, [](uint32_t) {}, [](const MultiKeyArg&) {});
+}
+
+std::string format_multi_args(const std::vector<std::string>& keys,
+                              const std::vector<std::string>& values) {
+    std::string out = std::to_string(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        out += ' ';
+        out += std::to_string(keys[i].size());
+        out += ' ';
+        out += keys[i];
+        if (!values.empty()) {
+            out += ' ';
+            out += std::to_string(values[i].size());
+            out += ' ';
+            out += values[i];
+        }
+    }
+    return out;
+}
+
+std::string format_multi_get(const std::vector<MultiGetItem>& items) {
+    std::string payload = std::to_string(items.size());
+    for (const auto& item : items) {
+        switch (item.status) {
+            case MultiGetItem::Status::FOUND:
+                payload += ' ';
+                payload += std::to_string(item.value.size());
+                payload += ' ';
+                payload += item.value;
+                break;
+            case MultiGetItem::Status::NOT_FOUND: payload += " -1"; break;
+            case MultiGetItem::Status::FAILED:    payload += " -2"; break;
+        }
+    }
+    return format_value(payload);
+}
+
+bool parse_multi_get(std::string_view payload, std::vector<MultiGetItem>& out) {
+    const char* data = payload.data();
+    const size_t end = payload.size();
+    size_t pos = 0;
+
+    uint32_t count = 0;
+    if (!parse_u32(data, end, pos, count) || count > MAX_MULTI_KEYS) return false;
+    out.clear();
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        MultiGetItem item;
+        if (!consume_space(data, end, pos)) return false;
+        if (pos < end && data[pos] == '-') {
+            if (pos + 2 > end || (data[pos + 1] != '1' && data[pos + 1] != '2')) {
+                return false;
+            }
+            item.status = data[pos + 1] == '1' ? MultiGetItem::Status::NOT_FOUND
+                                               : MultiGetItem::Status::FAILED;
+            pos += 2;
+        } else {
+            uint32_t val_len = 0;
+            std::string_view value;
+            if (!parse_u32(data, end, pos, val_len) || !consume_space(data, end, pos) ||
+                !read_bytes(data, end, pos, val_len, value)) {
+                return false;
+            }
+            item.status = MultiGetItem::Status::FOUND;
+            item.value.assign(value);
+        }
+        out.push_back(std::move(item));
+    }
+    return pos == end;
+}
+
+// ── Binary wire protocol ─────────────────────────────────────────────────────
+
+namespace {
+
+void put_u32(char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<char>((v >> (i * 8)) & 0xFF);
+}
+
+void put_u64(char* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = static_cast<char>((v >> (i * 8)) & 0xFF);
+}
+
+uint32_t get_u32(const char* p) {
+    uint32_t v = 0;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+uint64_t get_u64(const char* p) {
+    uint64_t v = 0;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+bool is_request_opcode(uint8_t op) {
+    switch (static_cast<BinaryOpcode>(op)) {
+        case BinaryOpcode::GET:
+        case BinaryOpcode::SET:
+        case BinaryOpcode::DEL:
+        case BinaryOpcode::PING:
+        case BinaryOpcode::TOPOLOGY:
+        case BinaryOpcode::DECOMMISSION:
+        case BinaryOpcode::HOTKEYS:
+        case BinaryOpcode::STATS:
+        case BinaryOpcode::MGET:
+        case BinaryOpcode::MSET:
+        case BinaryOpcode::RGET:
+        case BinaryOpcode::RDIGEST:
+        case BinaryOpcode::RSET:
+        case BinaryOpcode::RDEL:
+        case BinaryOpcode::FWD:
+        case BinaryOpcode::RBATCH:
+        case BinaryOpcode::AEHASH:
+        case BinaryOpcode::AEKEYS:
+        case BinaryOpcode::RSCAN:
+        case BinaryOpcode::RLOAD:
+        case BinaryOpcode::RING:
+        case BinaryOpcode::GOSSIP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool is_response_opcode(uint8_t op) {
+    return op >= static_cast<uint8_t>(BinaryOpcode::OK) &&
+           op <= static_cast<uint8_t>(BinaryOpcode::PONG);
+}
+
+}  // namespace
+
+BinaryParseResult try_parse_binary(const char* data, size_t len) {
+    if (len < BINARY_HEADER_SIZE) {
+        if (len > 0 && static_cast<uint8_t>(data[0]) != BINARY_MAGIC) {
+            return {ParseStatus::ERROR, {}, len, "bad magic", true};
+        }
+        return {ParseStatus::INCOMPLETE, {}, 0, "", false};
+    }
+
+    if (static_cast<uint8_t>(data[0]) != BINARY_MAGIC) {
+        return {ParseStatus::ERROR, {}, len, "bad magic", true};
+    }
+
+    BinaryFrame frame;
+    uint8_t  op         = static_cast<uint8_t>(data[1]);
+    frame.flags         = static_cast<uint8_t>(data[2]);
+    uint8_t  extras_len = static_cast<uint8_t>(data[3]);
+    frame.request_id    = get_u32(data + 4);
+    uint32_t key_len    = get_u32(data + 8);
+    uint32_t val_len    = get_u32(data + 12);
+
+    if (key_len > BINARY_MAX_KEY_LEN || val_len > BINARY_MAX_VAL_LEN) {
+        return {ParseStatus::ERROR, frame, len, "frame too large", true};
+    }
+
+    size_t total = BINARY_HEADER_SIZE + extras_len + key_len + val_len;
+    if (len < total) {
+        return {ParseStatus::INCOMPLETE, {}, 0, "", false};
+    }
+
+    const char* p = data + BINARY_HEADER_SIZE;
+    frame.extras = std::string_view(p, extras_len);
+    p += extras_len;
+    frame.key    = std::string_view(p, key_len);
+    p += key_len;
+    frame.value  = std::string_view(p, val_len);
+
+    if (!is_request_opcode(op) && !is_response_opcode(op)) {
+        return {ParseStatus::ERROR, frame, total, "unknown opcode", false};
+    }
+    frame.opcode = static_cast<BinaryOpcode>(op);
+
+    return {ParseStatus::OK, frame, total, "", false};
+}
+
+void append_binary_header(std::string& out, BinaryOpcode opcode,
+                          uint32_t request_id, size_t extras_len,
+                          size_t key_len, size_t value_len, uint8_t flags) {
+    char hdr[BINARY_HEADER_SIZE];
+    hdr[0] = static_cast<char>(BINARY_MAGIC);
+    hdr[1] = static_cast<char>(opcode);
+    hdr[2] = static_cast<char>(flags);
+    hdr[3] = static_cast<char>(extras_len);
+    put_u32(hdr + 4,  request_id);
+    put_u32(hdr + 8,  static_cast<uint32_t>(key_len));
+    put_u32(hdr + 12, static_cast<uint32_t>(value_len));
+    out.append(hdr, sizeof(hdr));
+}
+
+void append_binary_frame(std::string& out, BinaryOpcode opcode,
+                         uint32_t request_id, std::string_view extras,
+                         std::string_view key, std::string_view value,
+                         uint8_t flags) {
+    out.reserve(out.size() + BINARY_HEADER_SIZE + extras.size() + key.size()
+                + value.size());
+    append_binary_header(out, opcode, request_id, extras.size(), key.size(),
+                         value.size(), flags);
+    out.append(extras);
+    out.append(key);
+    out.append(value);
+}
+
+std::string encode_version_extras(uint64_t timestamp_ms, uint32_t node_id) {
+    std::string out(BINARY_VERSION_SIZE, '\0');
+    put_u64(out.data(), timestamp_ms);
+    put_u32(out.data() + 8, node_id);
+    return out;
+}
+
+bool decode_version_extras(std::string_view extras,
+                           uint64_t& timestamp_ms, uint32_t& node_id) {
+    if (extras.size() != BINARY_VERSION_SIZE) return false;
+    timestamp_ms = get_u64(extras.data());
+    node_id      = get_u32(extras.data() + 8);
+    return true;
+}
+
+bool binary_frame_to_view(const BinaryFrame& frame, CommandView& out,
+                          std::string_view& error) {
+    out = CommandView{};
+    switch (frame.opcode) {
+        case BinaryOpcode::PING: out.type = CommandType::PING; return true;
+        case BinaryOpcode::TOPOLOGY:
+            out.type = CommandType::TOPOLOGY;
+            return true;
+        case BinaryOpcode::DECOMMISSION:
+            out.type = CommandType::DECOMMISSION;
+            return true;
+        case BinaryOpcode::HOTKEYS:
+            out.type = CommandType::HOTKEYS;
+            return true;
+        case BinaryOpcode::STATS:
+            out.type = CommandType::STATS;
+            return true;
+        case BinaryOpcode::GET:  out.type = CommandType::GET;  break;
+        case BinaryOpcode::DEL:  out.type = CommandType::DEL;  break;
+        case BinaryOpcode::RGET: out.type = CommandType::RGET; break;
+        case BinaryOpcode::RDIGEST: out.type = CommandType::RDIGEST; break;
+        case BinaryOpcode::SET:
+            out.type  = CommandType::SET;
+            out.value = frame.value;
+            break;
+        case BinaryOpcode::RSET:
+        case BinaryOpcode::RDEL:
+            out.type = frame.opcode == BinaryOpcode::RSET ? CommandType::RSET
+                                                          : CommandType::RDEL;
+            if (!decode_version_extras(frame.extras, out.timestamp_ms,
+                                       out.node_id)) {
+                error = "missing version extras";
+                return false;
+            }
+            if (out.type == CommandType::RSET) out.value = frame.value;
+            break;
+        case BinaryOpcode::MGET:
+        case BinaryOpcode::MSET: {
+            out.type  = frame.opcode == BinaryOpcode::MGET ? CommandType::MGET
+                                                           : CommandType::MSET;
+            out.value = frame.value;
+            if (!valid_multi_args(out.value, out.type == CommandType::MSET)) {
+                error = "malformed key list";
+                return false;
+            }
+            return true;
+        }
+        case BinaryOpcode::RBATCH:
+            out.type  = CommandType::RBATCH;
+            out.value = frame.value;
+            return true;
+        case BinaryOpcode::AEHASH:
+        case BinaryOpcode::AEKEYS:
+            out.type  = frame.opcode == BinaryOpcode::AEHASH ? CommandType::AEHASH
+                                                             : CommandType::AEKEYS;
+            out.value = frame.value;
+            return true;
+        case BinaryOpcode::RSCAN:
+            out.type  = CommandType::RSCAN;
+            out.value = frame.value;
+            return true;
+        case BinaryOpcode::RLOAD:
+            out.type  = CommandType::RLOAD;
+            out.value = frame.value;
+            return true;
+        case BinaryOpcode::RING:
+            out.type  = CommandType::RING;
+            out.value = frame.value;
+            return true;
+        case BinaryOpcode::GOSSIP:
+            out.type  = CommandType::GOSSIP;
+            out.value = frame.value;
+            return true;
+        case BinaryOpcode::FWD:
+            if (frame.extras.size() != 1) {
+                error = "missing hops extras";
+                return false;
+            }
+            out.type           = CommandType::FWD;
+            out.hops_remaining = static_cast<uint8_t>(frame.extras[0]);
+            out.inner_line     = frame.value;
+            return true;
+        default:
+            error = "not a request opcode";
+            return false;
+    }
+    out.key = frame.key;
+    return true;
+}
+
+std::string binary_response_to_text(const BinaryFrame& frame) {
+    switch (frame.opcode) {
+        case BinaryOpcode::OK:        return format_ok();
+        case BinaryOpcode::PONG:      return format_pong();
+        case BinaryOpcode::NOT_FOUND: return format_not_found();
+        case BinaryOpcode::ERROR:     return format_error(std::string(frame.value));
+        case BinaryOpcode::VALUE: {
+            uint64_t ts = 0;
+            uint32_t node = 0;
+            if (decode_version_extras(frame.extras, ts, node)) {
+                return format_versioned_value(frame.value, ts, node);
+            }
+            return format_value(frame.value);
+        }
+        default:
+            return format_error("MALFORMED_RESPONSE");
+    }
+}
+
+bool binary_frame_to_command(const BinaryFrame& frame, Command& out,
+                             std::string& error) {
+    CommandView view;
+    std::string_view err;
+    if (!binary_frame_to_view(frame, view, err)) {
+        error = std::string(err);
+        return false;
+    }
+    out = view.to_command();
+    return true;
+}
+
+std::string text_to_binary_response(uint32_t request_id,
+                                    std::string_view text, uint8_t flags) {
+    std::string out;
+
+    // Strip the trailing newline so the payload views below exclude it.
+    if (!text.empty() && text.back() == '\n') text.remove_suffix(1);
+
+    if (text == "+OK") {
+        append_binary_frame(out, BinaryOpcode::OK, request_id, {}, {}, {}, flags);
+    } else if (text == "+PONG") {
+        append_binary_frame(out, BinaryOpcode::PONG, request_id, {}, {}, {}, flags);
+    } else if (text == "-NOT_FOUND") {
+        append_binary_frame(out, BinaryOpcode::NOT_FOUND, request_id, {}, {}, {}, flags);
+    } else if (text.rfind("-ERR ", 0) == 0) {
+        append_binary_frame(out, BinaryOpcode::ERROR, request_id, {}, {},
+                            text.substr(5), flags);
+    } else if (text.rfind("$V ", 0) == 0) {
+        std::string_view value;
+        uint64_t ts = 0;
+        uint32_t node = 0;
+        if (!split_versioned_value(text, value, ts, node)) {
+            append_binary_frame(out, BinaryOpcode::ERROR, request_id, {}, {},
+                                "MALFORMED_RESPONSE", flags);
+        } else {
+            append_binary_frame(out, BinaryOpcode::VALUE, request_id,
+                                encode_version_extras(ts, node), {}, value, flags);
+        }
+    } else if (!text.empty() && text[0] == '$') {
+        // $<len> <value>
+        size_t sp = text.find(' ');
+        uint32_t val_len = 0;
+        auto [ptr, ec] = std::from_chars(text.data() + 1,
+                                         text.data() + (sp == std::string_view::npos
+                                                            ? text.size() : sp),
+                                         val_len);
+        if (sp == std::string_view::npos || ec != std::errc{} ||
+            sp + 1 + val_len != text.size()) {
+            append_binary_frame(out, BinaryOpcode::ERROR, request_id, {}, {},
+                                "MALFORMED_RESPONSE", flags);
+        } else {
+            append_binary_frame(out, BinaryOpcode::VALUE, request_id, {}, {},
+                                text.substr(sp + 1), flags);
+        }
+    } else {
+        append_binary_frame(out, BinaryOpcode::ERROR, request_id, {}, {}, text, flags);
+    }
+    return out;
+}
+
 }  // namespace dkv
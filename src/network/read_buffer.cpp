@@ -0,0 +1,48 @@
+#include "network/read_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dkv {
+
+char* ReadBuffer::prepare(size_t min) {
+    if (cap_ - end_ >= min) return buf_.get() + end_;
+
+    const size_t used = size();
+    if (cap_ - used >= min) {
+        // Enough room once the consumed prefix is reclaimed.
+        std::memmove(buf_.get(), buf_.get() + begin_, used);
+        begin_ = 0;
+        end_   = used;
+    } else {
+        reallocate(std::max(cap_ * 2, used + min));
+    }
+    return buf_.get() + end_;
+}
+
+void ReadBuffer::consume(size_t n) {
+    begin_ += std::min(n, size());
+    if (begin_ == end_) begin_ = end_ = 0;
+}
+
+void ReadBuffer::shrink(size_t keep) {
+    if (cap_ <= keep || size() > keep) return;
+    if (empty()) {
+        buf_.reset();
+        cap_ = begin_ = end_ = 0;
+        return;
+    }
+    reallocate(keep);
+}
+
+void ReadBuffer::reallocate(size_t cap) {
+    const size_t used = size();
+    auto fresh = std::make_unique_for_overwrite<char[]>(cap);
+    if (used > 0) std::memcpy(fresh.get(), buf_.get() + begin_, used);
+    buf_   = std::move(fresh);
+    cap_   = cap;
+    begin_ = 0;
+    end_   = used;
+}
+
+}  // namespace dkv
@@ -1,12 +1,17 @@
 #include "network/tcp_server.h"
 #include "cluster/coordinator.h"
+#include "utils/metrics.h"
 
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+
+#include <algorithm>
+#include <array>
 #include <cerrno>
 #include <chrono>
 #include <cstring>
@@ -24,6 +29,51 @@ bool set_nonblocking(int fd) {
     return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
 }
 
+/// Requests, error replies and latency (dispatch to reply queued) of one
+/// command type.  PING, answered on the event loop, is only counted.
+struct CommandMetrics {
+    Counter*       requests = nullptr;
+    Counter*       errors   = nullptr;
+    LatencyMetric* latency  = nullptr;
+};
+
+const CommandMetrics& command_metrics(CommandType type) {
+    static const auto table = [] {
+        auto& m = Metrics::instance();
+        std::array<CommandMetrics, COMMAND_TYPE_COUNT> t;
+        for (size_t i = 0; i < t.size(); i++) {
+            const std::string labels =
+                std::string("cmd=\"") + command_name(static_cast<CommandType>(i)) + '"';
+            t[i].requests = &m.counter("dkv_commands_total", "Commands received", labels);
+            t[i].errors   = &m.counter("dkv_command_errors_total",
+                                       "Commands answered with an error", labels);
+            t[i].latency  = &m.latency("dkv_command_duration_seconds",
+                                       "Time from dispatch to the reply being queued",
+                                       labels);
+        }
+        return t;
+    }();
+    return table[static_cast<size_t>(type)];
+}
+
+Counter& protocol_errors() {
+    static Counter& c = Metrics::instance().counter(
+        "dkv_protocol_errors_total", "Frames that could not be parsed");
+    return c;
+}
+
+Counter& connections_accepted() {
+    static Counter& c = Metrics::instance().counter(
+        "dkv_connections_accepted_total", "Client connections accepted");
+    return c;
+}
+
+Counter& connections_closed() {
+    static Counter& c = Metrics::instance().counter(
+        "dkv_connections_closed_total", "Client connections closed");
+    return c;
+}
+
 }  // namespace
 
 // ── Constructor / Destructor ─────────────────────────────────────────────────
@@ -41,8 +91,6 @@ TCPServer::TCPServer(StorageEngine& engine, Coordinator& coordinator,
 TCPServer::~TCPServer() {
     stop();
     if (listen_fd_ >= 0) ::close(listen_fd_);
-    if (wakeup_read_fd_ >= 0) ::close(wakeup_read_fd_);
-    if (wakeup_write_fd_ >= 0) ::close(wakeup_write_fd_);
     for (auto& [fd, conn] : connections_) {
         ::close(fd);
     }
@@ -81,17 +129,22 @@ bool TCPServer::setup_listener() {
     return true;
 }
 
-bool TCPServer::setup_wakeup() {
-    int fds[2];
-    if (::pipe(fds) < 0) {
-        std::cerr << "[TCP] pipe() failed: " << strerror(errno) << "\n";
-        return false;
+// ── Output limits ────────────────────────────────────────────────────────────
+
+void TCPServer::set_output_limits(const OutputLimits& limits) {
+    limits_ = limits;
+    if (limits_.low_water > limits_.high_water) {
+        limits_.low_water = limits_.high_water;
     }
-    wakeup_read_fd_  = fds[0];
-    wakeup_write_fd_ = fds[1];
-    set_nonblocking(wakeup_read_fd_);
-    set_nonblocking(wakeup_write_fd_);
-    return true;
+}
+
+TCPServer::OutputStats TCPServer::output_stats() const {
+    OutputStats s;
+    s.paused_connections      = paused_connections_.load(std::memory_order_relaxed);
+    s.pause_events            = pause_events_.load(std::memory_order_relaxed);
+    s.slow_client_disconnects = slow_client_disconnects_.load(std::memory_order_relaxed);
+    s.output_bytes            = output_bytes_.load(std::memory_order_relaxed);
+    return s;
 }
 
 // ── Event Loop ───────────────────────────────────────────────────────────────
@@ -100,10 +153,10 @@ void TCPServer::run() {
     poller_ = Poller::create();
 
     if (!setup_listener()) return;
-    if (!setup_wakeup()) return;
+    if (!wakeup_.open()) return;
 
     poller_->add_fd(listen_fd_, POLL_READ);
-    poller_->add_fd(wakeup_read_fd_, POLL_READ);
+    poller_->add_fd(wakeup_.read_fd(), POLL_READ);
 
     running_ = true;
     std::cout << "[TCP] Listening on port " << port_ << "\n";
@@ -117,10 +170,8 @@ void TCPServer::run() {
         for (const auto& ev : events) {
             if (ev.fd == listen_fd_) {
                 if (!draining_.load()) handle_accept();  // no new conns during drain
-            } else if (ev.fd == wakeup_read_fd_) {
-                // Drain the wakeup pipe
-                char buf[64];
-                while (::read(wakeup_read_fd_, buf, sizeof(buf)) > 0) {}
+            } else if (ev.fd == wakeup_.read_fd()) {
+                wakeup_.clear();
                 drain_responses();
             } else {
                 if (ev.error) {
@@ -136,6 +187,10 @@ void TCPServer::run() {
             }
         }
 
+        // Connections whose output drained below the low-water mark during
+        // this iteration start reading again.
+        if (!resume_list_.empty()) resume_paused();
+
         // ── Graceful shutdown drain check (after processing all events) ───────
         if (draining_.load(std::memory_order_acquire)) {
             if (!drain_started) {
@@ -166,9 +221,8 @@ void TCPServer::run() {
 void TCPServer::stop() {
     if (draining_.exchange(true)) return;  // already stopping
     // Wake up the event loop so it starts the drain sequence
-    if (wakeup_write_fd_ >= 0) {
-        char c = 1;
-        ::write(wakeup_write_fd_, &c, 1);
+    if (wakeup_.is_open()) {
+        wakeup_.signal();
     } else {
         running_ = false;  // never started
     }
@@ -191,8 +245,18 @@ void TCPServer::handle_accept() {
         }
 
         set_nonblocking(client_fd);
+
+        // Responses are already coalesced per drain; don't let Nagle hold
+        // back the tail of a pipelined batch waiting for the client's ACK.
+        int one = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
         poller_->add_fd(client_fd, POLL_READ);
-        connections_[client_fd] = Connection{client_fd, "", ""};
+        connections_accepted().add();
+        Connection conn;
+        conn.fd = client_fd;
+        conn.id = next_conn_id_++;
+        connections_[client_fd] = std::move(conn);
     }
 }
 
@@ -201,13 +265,21 @@ void TCPServer::handle_accept() {
 void TCPServer::handle_read(int fd) {
     auto it = connections_.find(fd);
     if (it == connections_.end()) return;
+    if (it->second.read_paused) return;  // backpressure: leave it in the socket
 
-    char buf[4096];
-    // Edge-triggered: read as much as possible
+    auto& read_buf = it->second.read_buf;
+
+    // Edge-triggered: read as much as possible.  Bytes land directly in the
+    // connection buffer's spare capacity (no bounce through a stack buffer,
+    // no zero fill), so a large value is copied exactly once more — into its
+    // Command — before it is stored.
     while (true) {
-        ssize_t n = ::read(fd, buf, sizeof(buf));
+        char*   dst = read_buf.prepare(READ_CHUNK);
+        ssize_t n   = ::read(fd, dst, read_buf.spare());
+
         if (n > 0) {
-            it->second.read_buf.append(buf, static_cast<size_t>(n));
+            read_buf.commit(static_cast<size_t>(n));
+            continue;
         } else if (n == 0) {
             // Client closed connection
             close_connection(fd);
@@ -228,58 +300,211 @@ void TCPServer::process_commands(int fd) {
     auto it = connections_.find(fd);
     if (it == connections_.end()) return;
 
-    auto& read_buf = it->second.read_buf;
+    Connection& conn = it->second;
+    if (conn.read_buf.empty() || conn.read_paused) return;
+
+    // The first byte of a connection selects its protocol for good.
+    if (conn.protocol == WireProtocol::UNKNOWN) {
+        conn.protocol = static_cast<uint8_t>(conn.read_buf.data()[0]) == BINARY_MAGIC
+                            ? WireProtocol::BINARY
+                            : WireProtocol::TEXT;
+    }
+
+    if (conn.protocol == WireProtocol::BINARY) {
+        if (!process_binary_commands(fd, conn)) return;  // connection closed
+    } else {
+        process_text_commands(conn);
+    }
 
-    while (!read_buf.empty()) {
-        ParseResult result = try_parse(read_buf.data(), read_buf.size());
+    // Every parsed command owns its bytes by now: give back what a large
+    // frame made the buffer grow to.
+    conn.read_buf.shrink(READ_BUF_KEEP);
+
+    // Flush responses produced inline (PING, parse errors) in one write
+    if (!conn.write_buf.empty()) handle_write(fd);
+}
+
+void TCPServer::process_text_commands(Connection& conn) {
+    auto& read_buf = conn.read_buf;
+
+    // Frames are parsed in place (views into read_buf) and the consumed
+    // prefix is erased once at the end rather than after every frame.
+    size_t offset = 0;
+    while (offset < read_buf.size() && !conn.read_paused) {
+        ParseViewResult result = try_parse_view(read_buf.data() + offset,
+                                                read_buf.size() - offset);
 
         if (result.status == ParseStatus::INCOMPLETE) {
             break;  // wait for more data
         }
 
+        offset += result.bytes_consumed;
+
         if (result.status == ParseStatus::ERROR) {
             // Send error response, consume the bad frame, and keep going
-            std::string resp = format_error(result.error_msg);
-            read_buf.erase(0, result.bytes_consumed);
-
-            // Write error directly (small, on event loop thread — acceptable)
-            std::lock_guard lock(response_mutex_);
-            response_queue_.push_back({fd, std::move(resp)});
-            char c = 1;
-            ::write(wakeup_write_fd_, &c, 1);
+            // (small, on event loop thread — acceptable)
+            protocol_errors().add();
+            queue_local_response(conn, format_error(std::string(result.error_msg)));
+            continue;
+        }
+
+        dispatch(conn, result.command, /*binary=*/false, 0);
+    }
+
+    read_buf.consume(offset);
+}
+
+bool TCPServer::process_binary_commands(int fd, Connection& conn) {
+    auto& read_buf = conn.read_buf;
+
+    size_t offset = 0;
+    while (offset < read_buf.size() && !conn.read_paused) {
+        BinaryParseResult result = try_parse_binary(read_buf.data() + offset,
+                                                    read_buf.size() - offset);
+
+        if (result.status == ParseStatus::INCOMPLETE) break;
+
+        if (result.status == ParseStatus::ERROR) {
+            protocol_errors().add();
+            std::string resp;
+            append_binary_frame(resp, BinaryOpcode::ERROR,
+                                result.frame.request_id, {}, {},
+                                result.error_msg);
+            if (result.fatal) {
+                // Bad header: the stream cannot be resynchronised.  Flush the
+                // error best-effort and drop the connection.
+                append_output(conn, resp);
+                read_buf.clear();
+                handle_write(fd);
+                if (connections_.count(fd)) close_connection(fd);
+                return false;
+            }
+            offset += result.bytes_consumed;
+            queue_local_response(conn, std::move(resp));
             continue;
         }
 
-        // status == OK — dispatch to worker
-        size_t consumed = result.bytes_consumed;
-        Command cmd = std::move(result.command);
-        read_buf.erase(0, consumed);
+        const BinaryFrame& frame = result.frame;
+        offset += result.bytes_consumed;
+
+        CommandView cmd;
+        std::string_view error;
+        if (!binary_frame_to_view(frame, cmd, error)) {
+            protocol_errors().add();
+            std::string resp;
+            append_binary_frame(resp, BinaryOpcode::ERROR, frame.request_id,
+                                {}, {}, error);
+            queue_local_response(conn, std::move(resp));
+            continue;
+        }
+
+        dispatch(conn, cmd, /*binary=*/true, frame.request_id);
+    }
+
+    read_buf.consume(offset);
+    return true;
+}
 
-        // Track this task so graceful shutdown can wait for it to finish
-        in_flight_.fetch_add(1, std::memory_order_relaxed);
+void TCPServer::dispatch(Connection& conn, const CommandView& view,
+                         bool binary, uint32_t request_id) {
+    command_metrics(view.type).requests->add();
 
-        // Capture fd by value for the worker lambda
-        pool_.submit([this, fd, cmd = std::move(cmd)]() {
-            std::string response = execute_command(cmd);
+    // PING needs no worker: answer it on the event loop without copying or
+    // crossing a thread boundary.
+    if (view.type == CommandType::PING) {
+        std::string resp;
+        if (binary) {
+            append_binary_frame(resp, BinaryOpcode::PONG, request_id);
+        } else {
+            resp = format_pong();
+        }
+        queue_local_response(conn, std::move(resp));
+        return;
+    }
 
-            // Push response to queue and wake event loop
-            {
-                std::lock_guard lock(response_mutex_);
-                response_queue_.push_back({fd, std::move(response)});
+    // The command is about to leave the event loop thread, and the views
+    // point into read_buf, which is erased once this batch is parsed: take
+    // ownership now.  This is the only copy of the key and value bytes.
+    Command cmd = view.to_command();
+
+    // Track this task so graceful shutdown can wait for it to finish
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+
+    // Capture fd and connection id by value for the worker lambda; the id
+    // keeps a late response from reaching a new connection that reused fd.
+    pool_.submit([this, fd = conn.fd, conn_id = conn.id, binary, request_id,
+                  start, cmd = std::move(cmd)]() mutable {
+        const CommandType type = cmd.type;
+        if (coordinator_ && binary) {
+            // Replication traffic from peers is answered here, with the
+            // response frame built straight from the engine's result.
+            uint8_t flags = coordinator_->busy() ? BINARY_FLAG_BUSY : 0;
+            std::string frame;
+            if (coordinator_->execute_binary(cmd, request_id, flags, frame)) {
+                const bool error = frame.size() > 1 &&
+                    static_cast<uint8_t>(frame[1]) ==
+                        static_cast<uint8_t>(BinaryOpcode::ERROR);
+                complete_request(fd, conn_id, type, start, error, std::move(frame));
+                return;
             }
-            in_flight_.fetch_sub(1, std::memory_order_release);
-            char c = 1;
-            ::write(wakeup_write_fd_, &c, 1);
-        });
+        }
+        if (coordinator_) {
+            // Cluster mode: the coordinator replies once the replicas have
+            // answered, from the RPC client's thread; this worker is free as
+            // soon as the requests are sent.
+            coordinator_->handle_command_async(
+                std::move(cmd),
+                [this, fd, conn_id, binary, request_id, type,
+                 start](std::string response) {
+                    finish_request(fd, conn_id, binary, request_id, type, start,
+                                   std::move(response));
+                });
+            return;
+        }
+        finish_request(fd, conn_id, binary, request_id, type, start,
+                       execute_command(cmd));
+    });
+}
+
+void TCPServer::finish_request(int fd, uint64_t conn_id, bool binary,
+                               uint32_t request_id, CommandType type,
+                               std::chrono::steady_clock::time_point start,
+                               std::string response) {
+    const bool error = response.compare(0, 4, "-ERR") == 0;
+    if (binary) {
+        uint8_t flags = coordinator_ && coordinator_->busy() ? BINARY_FLAG_BUSY : 0;
+        response = text_to_binary_response(request_id, response, flags);
     }
+    complete_request(fd, conn_id, type, start, error, std::move(response));
+}
+
+void TCPServer::complete_request(int fd, uint64_t conn_id, CommandType type,
+                                 std::chrono::steady_clock::time_point start,
+                                 bool error, std::string data) {
+    const CommandMetrics& metrics = command_metrics(type);
+    metrics.latency->record_since(start);
+    if (error) metrics.errors->add();
+    post_response(fd, conn_id, std::move(data));
+    in_flight_.fetch_sub(1, std::memory_order_release);
 }
 
-std::string TCPServer::execute_command(const Command& cmd) {
-    // If we have a coordinator, delegate all routing to it
-    if (coordinator_) {
-        return coordinator_->handle_command(cmd);
+void TCPServer::post_response(int fd, uint64_t conn_id, std::string data) {
+    response_queue_.push(PendingResponse{fd, conn_id, std::move(data)});
+
+    // Only the producer that flips the flag pays for the syscall.  The event
+    // loop clears the flag *before* draining, so anything pushed after the
+    // clear either is seen by that drain or flips the flag and wakes it again.
+    if (!wakeup_pending_.exchange(true, std::memory_order_seq_cst)) {
+        wakeup_.signal();
     }
+}
+
+void TCPServer::queue_local_response(Connection& conn, std::string resp) {
+    append_output(conn, resp);
+}
 
+std::string TCPServer::execute_command(Command& cmd) {
     // Local-only mode: execute directly on the storage engine
     auto now = static_cast<uint64_t>(
         std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -298,8 +523,10 @@ std::string TCPServer::execute_command(const Command& cmd) {
         }
 
         case CommandType::SET: {
+            // The command is owned by this task: move the value into the
+            // engine rather than copying it.
             Version v{now, node_id_};
-            engine_.set(cmd.key, cmd.value, v);
+            engine_.set(cmd.key, std::move(cmd.value), v);
             return format_ok();
         }
 
@@ -309,14 +536,62 @@ std::string TCPServer::execute_command(const Command& cmd) {
             return format_ok();
         }
 
+        case CommandType::MGET: {
+            std::vector<MultiKeyArg> args;
+            if (!parse_multi_args(cmd.value, false, args)) {
+                return format_error("malformed key list");
+            }
+            std::vector<MultiGetItem> items(args.size());
+            for (size_t i = 0; i < args.size(); i++) {
+                auto result = engine_.get(std::string(args[i].key));
+                if (!result.found) continue;
+                items[i].status = MultiGetItem::Status::FOUND;
+                items[i].value  = std::move(result.value);
+            }
+            return format_multi_get(items);
+        }
+
+        case CommandType::MSET: {
+            std::vector<MultiKeyArg> args;
+            if (!parse_multi_args(cmd.value, true, args)) {
+                return format_error("malformed key list");
+            }
+            Version v{now, node_id_};
+            for (const auto& arg : args) {
+                engine_.set(std::string(arg.key), std::string(arg.value), v);
+            }
+            return format_ok();
+        }
+
         case CommandType::FWD:
             // FWD is handled by the Coordinator, not directly by TCPServer.
             // If we get here, we're in local-only mode and FWD is unsupported.
             return format_error("FWD_NOT_SUPPORTED");
 
+        case CommandType::TOPOLOGY:
+            // No ring without a cluster; clients fall back to this node.
+            return format_error("TOPOLOGY_NOT_SUPPORTED");
+
+        case CommandType::DECOMMISSION:
+            return format_error("DECOMMISSION_NOT_SUPPORTED");
+
+        case CommandType::HOTKEYS:
+            return format_error("HOTKEYS_NOT_SUPPORTED");
+
+        case CommandType::STATS:
+            return format_value(Metrics::instance().render());
+
         case CommandType::RSET:
         case CommandType::RDEL:
         case CommandType::RGET:
+        case CommandType::RDIGEST:
+        case CommandType::RBATCH:
+        case CommandType::AEHASH:
+        case CommandType::AEKEYS:
+        case CommandType::RSCAN:
+        case CommandType::RLOAD:
+        case CommandType::RING:
+        case CommandType::GOSSIP:
             // Replication commands are cluster-mode-only; they are handled by
             // the Coordinator.  Reaching here means a client sent one in
             // local-only mode — reject it.
@@ -328,51 +603,161 @@ std::string TCPServer::execute_command(const Command& cmd) {
 // ── Write ────────────────────────────────────────────────────────────────────
 
 void TCPServer::drain_responses() {
-    std::vector<PendingResponse> batch;
-    {
-        std::lock_guard lock(response_mutex_);
-        batch.swap(response_queue_);
-    }
+    wakeup_pending_.store(false, std::memory_order_seq_cst);
 
-    for (auto& resp : batch) {
+    PendingResponse resp;
+    while (response_queue_.try_pop(resp)) {
         auto it = connections_.find(resp.fd);
         if (it == connections_.end()) continue;  // connection closed
+        if (it->second.id != resp.conn_id) continue;  // fd reused since
+
+        Connection& conn = it->second;
+        // A non-empty buffer is either already on the flush list or waiting
+        // for POLL_WRITE; either way it will be written.
+        if (conn.write_buf.empty()) flush_list_.push_back(resp.fd);
+        append_output(conn, resp.data);
+
+        // A client that stopped reading never becomes writable again, so
+        // its hard cap cannot wait for handle_write().
+        if (conn.write_blocked && limits_.hard_limit > 0 &&
+            conn.write_buf.size() > limits_.hard_limit) {
+            disconnect_slow_client(conn);
+        }
+    }
 
-        it->second.write_buf.append(resp.data);
-
-        // Try to write immediately
-        handle_write(resp.fd);
+    // One write() per connection per drain, however many responses it got
+    for (int fd : flush_list_) {
+        handle_write(fd);
     }
+    flush_list_.clear();
 }
 
 void TCPServer::handle_write(int fd) {
     auto it = connections_.find(fd);
     if (it == connections_.end()) return;
 
-    auto& write_buf = it->second.write_buf;
+    Connection& conn = it->second;
+    auto& write_buf = conn.write_buf;
 
-    while (!write_buf.empty()) {
-        ssize_t n = ::write(fd, write_buf.data(), write_buf.size());
+    size_t written = 0;
+    while (written < write_buf.size()) {
+        ssize_t n = ::write(fd, write_buf.data() + written,
+                            write_buf.size() - written);
         if (n > 0) {
-            write_buf.erase(0, static_cast<size_t>(n));
+            written += static_cast<size_t>(n);
         } else {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // Register for write readiness and try later
-                poller_->modify_fd(fd, POLL_READ | POLL_WRITE);
-                return;
-            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
             close_connection(fd);
             return;
         }
     }
+    write_buf.erase(0, written);
+    output_bytes_.fetch_sub(written, std::memory_order_relaxed);
+    conn.write_blocked = !write_buf.empty();
+
+    // Enforce the hard cap only after trying to write, so a burst that the
+    // socket can absorb right away does not count against the client.
+    if (limits_.hard_limit > 0 && write_buf.size() > limits_.hard_limit) {
+        disconnect_slow_client(conn);
+        return;
+    }
+
+    if (conn.read_paused) {
+        if (can_resume(conn)) resume_list_.push_back(fd);
+    } else if (should_pause(conn)) {
+        pause_reading(conn);
+    }
+
+    update_interest(conn);
+}
+
+void TCPServer::disconnect_slow_client(Connection& conn) {
+    std::cerr << "[TCP] Disconnecting slow client fd=" << conn.fd << " ("
+              << conn.write_buf.size() << " bytes of unread output)\n";
+    slow_client_disconnects_.fetch_add(1, std::memory_order_relaxed);
+    close_connection(conn.fd);
+}
+
+void TCPServer::append_output(Connection& conn, std::string_view data) {
+    conn.write_buf.append(data);
+    output_bytes_.fetch_add(data.size(), std::memory_order_relaxed);
+}
+
+void TCPServer::update_interest(Connection& conn) {
+    // Only watch for writability while output is pending (otherwise an
+    // edge-triggered socket reports EPOLLOUT on every read), and only watch
+    // for readability while not paused by backpressure.
+    uint32_t events = 0;
+    if (!conn.read_paused)      events |= POLL_READ;
+    if (!conn.write_buf.empty()) events |= POLL_WRITE;
+    poller_->modify_fd(conn.fd, events);
+}
+
+// ── Backpressure ─────────────────────────────────────────────────────────────
+
+bool TCPServer::should_pause(const Connection& conn) const {
+    size_t pending = conn.write_buf.size();
+    if (limits_.high_water > 0 && pending > limits_.high_water) return true;
+    // Over the global mark, any connection still owed output stops feeding
+    // the server more work until memory comes back down.
+    return limits_.global_high_water > 0 && pending > 0 &&
+           output_bytes_.load(std::memory_order_relaxed) > limits_.global_high_water;
+}
+
+bool TCPServer::can_resume(const Connection& conn) const {
+    if (conn.write_buf.size() > limits_.low_water) return false;
+    return limits_.global_high_water == 0 ||
+           output_bytes_.load(std::memory_order_relaxed) <= limits_.global_high_water;
+}
+
+void TCPServer::pause_reading(Connection& conn) {
+    conn.read_paused = true;
+    paused_fds_.insert(conn.fd);
+    paused_connections_.fetch_add(1, std::memory_order_relaxed);
+    pause_events_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TCPServer::resume_paused() {
+    // Going back under the global mark may release connections that have
+    // nothing left to write (and so never reach handle_write again).
+    if (limits_.global_high_water > 0 &&
+        output_bytes_.load(std::memory_order_relaxed) <= limits_.global_high_water) {
+        for (int fd : paused_fds_) resume_list_.push_back(fd);
+    }
 
-    // All data written — stop monitoring for write readiness
-    poller_->modify_fd(fd, POLL_READ);
+    std::vector<int> fds;
+    fds.swap(resume_list_);
+    for (int fd : fds) {
+        auto it = connections_.find(fd);
+        if (it == connections_.end()) continue;
+        Connection& conn = it->second;
+        if (!conn.read_paused || !can_resume(conn)) continue;
+
+        conn.read_paused = false;
+        paused_fds_.erase(fd);
+        paused_connections_.fetch_sub(1, std::memory_order_relaxed);
+        update_interest(conn);
+
+        // Commands buffered before the pause, then anything that arrived on
+        // the socket meanwhile — edge-triggered, so no new event will come.
+        process_commands(fd);
+        handle_read(fd);
+    }
 }
 
 // ── Cleanup ──────────────────────────────────────────────────────────────────
 
 void TCPServer::close_connection(int fd) {
+    auto it = connections_.find(fd);
+    if (it != connections_.end()) {
+        output_bytes_.fetch_sub(it->second.write_buf.size(),
+                                std::memory_order_relaxed);
+        if (it->second.read_paused) {
+            paused_fds_.erase(fd);
+            paused_connections_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        connections_closed().add();
+    }
     poller_->remove_fd(fd);
     ::close(fd);
     connections_.erase(fd);
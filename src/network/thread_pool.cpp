@@ -1,51 +1,373 @@
 #include "network/thread_pool.h"
 
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace dkv {
 
-ThreadPool::ThreadPool(size_t num_threads) {
-    workers_.reserve(num_threads);
-    for (size_t i = 0; i < num_threads; i++) {
-        workers_.emplace_back([this]() {
-            while (true) {
-                std::function<void()> task;
-                {
-                    std::unique_lock lock(mutex_);
-                    cv_.wait(lock, [this]() {
-                        return stopped_ || !tasks_.empty();
-                    });
-
-                    if (stopped_ && tasks_.empty()) {
-                        return;
-                    }
-
-                    task = std::move(tasks_.front());
-                    tasks_.pop();
+// ── Helpers ──────────────────────────────────────────────────────────────────
+
+namespace {
+
+/// Iterations an idle worker spends re-checking for work before parking.
+/// Kept short: yielding rather than burning a core matters more than the
+/// last microsecond of wake-up latency on small machines.
+constexpr int SPIN_ITERATIONS = 64;
+
+/// Capacity of each worker's deque and of the injection ring (powers of two).
+constexpr int64_t  DEQUE_CAPACITY     = 1024;
+constexpr uint64_t INJECTION_CAPACITY = 1024;
+
+/// The worker of *some* pool the current thread belongs to (if any), so
+/// submit() can tell a worker-local submission from an external one.
+struct WorkerIdentity {
+    const void* pool  = nullptr;
+    size_t      index = 0;
+};
+thread_local WorkerIdentity tls_worker;
+
+/// A Task queued on a worker's deque.  Nodes belong to that worker and are
+/// recycled (see ThreadPool::Worker), so a worker-local submit allocates
+/// nothing once the pool has warmed up.
+struct TaskNode {
+    Task      task;
+    TaskNode* next = nullptr;  // free-list link
+};
+
+/// Chase-Lev work-stealing deque of task nodes (fixed capacity),
+/// following Lê et al., "Correct and Efficient Work-Stealing for Weak
+/// Memory Models" (PPoPP'13).  The owner pushes and pops at the bottom;
+/// thieves steal from the top.
+class ChaseLevDeque {
+public:
+    /// Owner only.  Returns false if the deque is full.
+    bool push(TaskNode* task) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        if (b - t >= DEQUE_CAPACITY) return false;
+        slots_[static_cast<size_t>(b & (DEQUE_CAPACITY - 1))].store(
+            task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// Owner only.  Returns nullptr if empty.
+    TaskNode* pop() {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+
+        TaskNode* task = nullptr;
+        if (t <= b) {
+            task = slots_[static_cast<size_t>(b & (DEQUE_CAPACITY - 1))].load(
+                std::memory_order_relaxed);
+            if (t == b) {
+                // Last element: race against thieves for it.
+                if (!top_.compare_exchange_strong(t, t + 1,
+                                                  std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed)) {
+                    task = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    /// Any thread.  Returns nullptr if empty or if another thief won.
+    TaskNode* steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+
+        TaskNode* task = slots_[static_cast<size_t>(t & (DEQUE_CAPACITY - 1))].load(
+            std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return task;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<TaskNode*> slots_[DEQUE_CAPACITY] = {};
+};
+
+}  // namespace
+
+// ── Internal types ───────────────────────────────────────────────────────────
+
+struct ThreadPool::Worker {
+    ChaseLevDeque deque;
+    std::thread   thread;
+
+    // Node recycling.  The owner takes nodes from `free_nodes` and puts back
+    // the ones it pops itself; thieves push theirs onto `returned`, which
+    // the owner takes over in one exchange (a single consumer, so no ABA).
+    TaskNode*                              free_nodes = nullptr;
+    alignas(64) std::atomic<TaskNode*>     returned{nullptr};
+    std::vector<std::unique_ptr<TaskNode>> nodes;  // every node allocated
+
+    /// Owner only: a node holding `task`.
+    TaskNode* acquire(Task&& task) {
+        if (!free_nodes) free_nodes = returned.exchange(nullptr, std::memory_order_acquire);
+        TaskNode* node = free_nodes;
+        if (node) {
+            free_nodes = node->next;
+        } else {
+            node = nodes.emplace_back(std::make_unique<TaskNode>()).get();
+        }
+        node->task = std::move(task);
+        return node;
+    }
+
+    /// Owner only.
+    void release_local(TaskNode* node) {
+        node->next = free_nodes;
+        free_nodes = node;
+    }
+
+    /// Any thread (a thief handing a stolen node back).
+    void release_remote(TaskNode* node) {
+        TaskNode* head = returned.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!returned.compare_exchange_weak(head, node, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+    }
+};
+
+/// Vyukov bounded MPMC queue holding Tasks by value, so an external submit
+/// is one CAS and a move into a pre-allocated slot.  When the ring is full
+/// tasks spill into a mutex-protected deque instead of failing.
+class ThreadPool::InjectionQueue {
+public:
+    InjectionQueue() {
+        for (uint64_t i = 0; i < INJECTION_CAPACITY; i++) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    void push(Task&& task) {
+        if (try_push_ring(task)) return;
+        std::lock_guard lock(overflow_mutex_);
+        overflow_.push_back(std::move(task));
+        overflow_size_.fetch_add(1, std::memory_order_release);
+    }
+
+    bool try_pop(Task& out) {
+        if (try_pop_ring(out)) return true;
+        if (overflow_size_.load(std::memory_order_acquire) == 0) return false;
+
+        std::lock_guard lock(overflow_mutex_);
+        if (overflow_.empty()) return false;
+        out = std::move(overflow_.front());
+        overflow_.pop_front();
+        overflow_size_.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> seq{0};
+        Task                  task;
+    };
+
+    bool try_push_ring(Task& task) {
+        uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & (INJECTION_CAPACITY - 1)];
+            uint64_t seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+                    cell.task = std::move(task);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop_ring(Task& out) {
+        uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & (INJECTION_CAPACITY - 1)];
+            uint64_t seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+                    out = std::move(cell.task);
+                    cell.seq.store(pos + INJECTION_CAPACITY,
+                                   std::memory_order_release);
+                    return true;
                 }
-                task();
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
             }
-        });
+        }
+    }
+
+    Cell cells_[INJECTION_CAPACITY];
+    alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+    alignas(64) std::atomic<uint64_t> dequeue_pos_{0};
+
+    std::mutex            overflow_mutex_;
+    std::deque<Task>      overflow_;
+    std::atomic<uint64_t> overflow_size_{0};
+};
+
+// ── ThreadPool ───────────────────────────────────────────────────────────────
+
+ThreadPool::ThreadPool(size_t num_threads)
+    : injection_(std::make_unique<InjectionQueue>()) {
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    // Start threads only once every deque exists: workers steal from each other.
+    for (size_t i = 0; i < num_threads; i++) {
+        workers_[i]->thread = std::thread([this, i]() { worker_loop(i); });
     }
 }
 
-bool ThreadPool::submit(std::function<void()> task) {
-    {
-        std::lock_guard lock(mutex_);
-        if (stopped_) return false;
-        tasks_.push(std::move(task));
+bool ThreadPool::submit(Task task) {
+    // Announce the submission before checking stopped_, so shutdown() can
+    // wait for in-progress submits and then know nothing more will arrive.
+    submitters_.fetch_add(1, std::memory_order_seq_cst);
+    if (stopped_.load(std::memory_order_seq_cst)) {
+        submitters_.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    bool queued = false;
+    if (tls_worker.pool == this) {
+        // Submitted by one of our own workers: keep it local (cache-warm);
+        // idle workers will steal it if this one stays busy.
+        Worker&   self = *workers_[tls_worker.index];
+        TaskNode* node = self.acquire(std::move(task));
+        if (self.deque.push(node)) {
+            queued = true;
+        } else {
+            task = std::move(node->task);
+            self.release_local(node);
+        }
     }
-    cv_.notify_one();
+    if (!queued) injection_->push(std::move(task));
+
+    submitters_.fetch_sub(1, std::memory_order_release);
+    wake_one();
     return true;
 }
 
+void ThreadPool::wake_one() {
+    // Pairs with the fence in worker_loop(): either this load sees the
+    // parking worker, or that worker's final re-check sees the new task.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) == 0) return;
+    wake_epoch_.fetch_add(1, std::memory_order_release);
+    wake_epoch_.notify_one();
+}
+
+bool ThreadPool::find_task(size_t index, Task& out) {
+    Worker& self = *workers_[index];
+    if (TaskNode* node = self.deque.pop()) {
+        out = std::move(node->task);
+        self.release_local(node);
+        return true;
+    }
+
+    if (injection_->try_pop(out)) return true;
+
+    // Steal, starting after ourselves so thieves spread across victims.
+    const size_t n = workers_.size();
+    for (size_t k = 1; k < n; k++) {
+        Worker& victim = *workers_[(index + k) % n];
+        if (TaskNode* node = victim.deque.steal()) {
+            out = std::move(node->task);
+            victim.release_remote(node);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    tls_worker = WorkerIdentity{this, index};
+
+    Task task;
+    while (true) {
+        bool found = false;
+        for (int spin = 0; spin < SPIN_ITERATIONS && !found; spin++) {
+            found = find_task(index, task);
+            if (!found) std::this_thread::yield();
+        }
+
+        if (found) {
+            task();
+            task.reset();
+            continue;
+        }
+
+        // Park.  Register as a sleeper *before* the final re-check, so a
+        // submitter that pushes after the re-check is guaranteed to see us.
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t epoch = wake_epoch_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (find_task(index, task)) {
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task.reset();
+            continue;
+        }
+
+        if (drain_ready_.load(std::memory_order_acquire)) {
+            // No task can arrive any more and none was found: done.  Our own
+            // deque is empty, and other workers drain their own before
+            // exiting.
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+
+        wake_epoch_.wait(epoch, std::memory_order_acquire);
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
 void ThreadPool::shutdown() {
-    {
-        std::lock_guard lock(mutex_);
-        stopped_ = true;
+    if (joined_.exchange(true)) return;
+
+    stopped_.store(true, std::memory_order_seq_cst);
+    // Wait out submit() calls that passed the stopped_ check before it flipped.
+    while (submitters_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
     }
-    cv_.notify_all();
+    drain_ready_.store(true, std::memory_order_release);
+
+    wake_epoch_.fetch_add(1, std::memory_order_release);
+    wake_epoch_.notify_all();
+
     for (auto& w : workers_) {
-        if (w.joinable()) {
-            w.join();
+        if (w->thread.joinable()) {
+            w->thread.join();
         }
     }
 }
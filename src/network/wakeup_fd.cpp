@@ -0,0 +1,75 @@
+#include "network/wakeup_fd.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef PLATFORM_LINUX
+#include <sys/eventfd.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace dkv {
+
+WakeupFd::~WakeupFd() {
+    close();
+}
+
+bool WakeupFd::open() {
+#ifdef PLATFORM_LINUX
+    // eventfd: one fd, an 8-byte counter, and any number of writes collapse
+    // into a single readable event.
+    int efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd < 0) {
+        std::cerr << "[WAKEUP] eventfd() failed: " << strerror(errno) << "\n";
+        return false;
+    }
+    write_fd_ = efd;
+    read_fd_.store(efd, std::memory_order_release);
+#else
+    int fds[2];
+    if (::pipe(fds) < 0) {
+        std::cerr << "[WAKEUP] pipe() failed: " << strerror(errno) << "\n";
+        return false;
+    }
+    for (int fd : fds) {
+        int flags = ::fcntl(fd, F_GETFL, 0);
+        ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+    write_fd_ = fds[1];
+    read_fd_.store(fds[0], std::memory_order_release);
+#endif
+    return true;
+}
+
+void WakeupFd::close() {
+    int rfd = read_fd_.exchange(-1, std::memory_order_acq_rel);
+    if (rfd >= 0) ::close(rfd);
+    if (write_fd_ >= 0 && write_fd_ != rfd) ::close(write_fd_);
+    write_fd_ = -1;
+}
+
+void WakeupFd::signal() {
+#ifdef PLATFORM_LINUX
+    uint64_t one = 1;
+    ::write(write_fd_, &one, sizeof(one));
+#else
+    char c = 1;
+    ::write(write_fd_, &c, 1);
+#endif
+}
+
+void WakeupFd::clear() {
+#ifdef PLATFORM_LINUX
+    uint64_t count;
+    ::read(read_fd(), &count, sizeof(count));
+#else
+    char buf[64];
+    while (::read(read_fd(), buf, sizeof(buf)) > 0) {}
+#endif
+}
+
+}  // namespace dkv
@@ -1,9 +1,18 @@
 #include "replication/hint_store.h"
+#include "utils/crc32.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <sstream>
 
 namespace dkv {
 
@@ -11,35 +20,143 @@ namespace dkv {
 
 namespace {
 
-void write_u32(std::ostream& os, uint32_t v) {
-    os.write(reinterpret_cast<const char*>(&v), 4);
+/// Compact once at least this many finished hints are still queued (and
+/// they outnumber the live ones).
+constexpr size_t COMPACT_MIN_GARBAGE = 1024;
+
+/// Hints the writer takes from a target's queue per hold of the lock.
+constexpr size_t WRITE_BATCH = 256;
+
+/// Bytes of hints per target waiting for the writer; past this the disk has
+/// fallen behind and new hints are dropped rather than held in memory.
+constexpr uint64_t MAX_UNWRITTEN_BYTES = 64ull << 20;
+
+/// How often an idle writer wakes to fsync when sync_interval_ms is 0.
+constexpr uint32_t WRITER_IDLE_MS = 1000;
+
+/// Record header: [payload_len u32][crc32(payload) u32].
+constexpr size_t RECORD_HEADER = 8;
+
+uint64_t wall_ms() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
 }
-void write_u64(std::ostream& os, uint64_t v) {
-    os.write(reinterpret_cast<const char*>(&v), 8);
+
+void put_u32(std::string& out, uint32_t v) {
+    out.append(reinterpret_cast<const char*>(&v), 4);
 }
-void write_u8(std::ostream& os, uint8_t v) {
-    os.write(reinterpret_cast<const char*>(&v), 1);
+void put_u64(std::string& out, uint64_t v) {
+    out.append(reinterpret_cast<const char*>(&v), 8);
 }
-void write_str(std::ostream& os, const std::string& s) {
-    uint32_t len = static_cast<uint32_t>(s.size());
-    write_u32(os, len);
-    os.write(s.data(), len);
+void put_str(std::string& out, const std::string& s) {
+    put_u32(out, static_cast<uint32_t>(s.size()));
+    out += s;
 }
 
-bool read_u32(std::istream& is, uint32_t& v) {
-    return static_cast<bool>(is.read(reinterpret_cast<char*>(&v), 4));
-}
-bool read_u64(std::istream& is, uint64_t& v) {
-    return static_cast<bool>(is.read(reinterpret_cast<char*>(&v), 8));
+/// Bounds-checked cursor over a mapped record.
+struct Cursor {
+    const char* p;
+    const char* end;
+
+    bool u32(uint32_t& v) { return take(&v, 4); }
+    bool u64(uint64_t& v) { return take(&v, 8); }
+    bool u8(uint8_t& v)   { return take(&v, 1); }
+    bool str(std::string& s) {
+        uint32_t len = 0;
+        if (!u32(len) || static_cast<size_t>(end - p) < len) return false;
+        s.assign(p, len);
+        p += len;
+        return true;
+    }
+
+private:
+    bool take(void* out, size_t n) {
+        if (static_cast<size_t>(end - p) < n) return false;
+        std::memcpy(out, p, n);
+        p += n;
+        return true;
+    }
+};
+
+/// Read-only mapping of a whole file; empty if it cannot be mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st{};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size),
+                             PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = static_cast<const char*>(p);
+                size_ = static_cast<size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+    }
+    ~MappedFile() {
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+    }
+    MappedFile(MappedFile&& o) noexcept : data_(o.data_), size_(o.size_) {
+        o.data_ = nullptr;
+        o.size_ = 0;
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t      size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t      size_ = 0;
+};
+
+/// Record layout:
+///   [payload_len u32][crc32 u32]
+///   payload: [target_node_id u32][addr][key][value]   (strings: u32 len + bytes)
+///            [timestamp_ms u64][node_id u32][is_del u8][stored_ms u64]
+/// `value_pos` receives the offset of the value bytes within the record.
+std::string encode_record(const Hint& h, uint64_t stored_ms, size_t& value_pos) {
+    std::string payload;
+    payload.reserve(4 + 4 + h.target_address.size() + 4 + h.key.size() + 4 +
+                    h.value.size() + 25);
+    put_u32(payload, h.target_node_id);
+    put_str(payload, h.target_address);
+    put_str(payload, h.key);
+    value_pos = RECORD_HEADER + payload.size() + 4;
+    put_str(payload, h.value);
+    put_u64(payload, h.version.timestamp_ms);
+    put_u32(payload, h.version.node_id);
+    payload.push_back(h.is_del ? 1 : 0);
+    put_u64(payload, stored_ms);
+
+    std::string rec;
+    rec.reserve(RECORD_HEADER + payload.size());
+    put_u32(rec, static_cast<uint32_t>(payload.size()));
+    put_u32(rec, crc32(payload.data(), payload.size()));
+    rec += payload;
+    return rec;
 }
-bool read_u8(std::istream& is, uint8_t& v) {
-    return static_cast<bool>(is.read(reinterpret_cast<char*>(&v), 1));
+
+size_t record_size(const Hint& h) {
+    return RECORD_HEADER + 4 + 4 + h.target_address.size() + 4 + h.key.size() +
+           4 + h.value.size() + 8 + 4 + 1 + 8;
 }
-bool read_str(std::istream& is, std::string& s) {
-    uint32_t len = 0;
-    if (!read_u32(is, len)) return false;
-    s.resize(len);
-    return static_cast<bool>(is.read(s.data(), len));
+
+bool write_all(int fd, const std::string& buf) {
+    size_t done = 0;
+    while (done < buf.size()) {
+        ssize_t n = ::write(fd, buf.data() + done, buf.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
 }
 
 }  // namespace
@@ -47,119 +164,776 @@ bool read_str(std::istream& is, std::string& s) {
 // ── HintStore public API ──────────────────────────────────────────────────────
 
 HintStore::HintStore(const std::string& hints_dir)
-    : hints_dir_(hints_dir) {}
+    : HintStore(hints_dir, Options{}) {}
 
-void HintStore::store(const Hint& hint) {
+HintStore::HintStore(const std::string& hints_dir, Options options)
+    : hints_dir_(hints_dir), options_(options) {}
+
+HintStore::~HintStore() {
     {
         std::lock_guard lock(mutex_);
-        hints_[hint.target_node_id].push_back(hint);
+        writer_stop_ = true;
     }
-    // Append to disk outside the lock (file I/O can be slow).
-    if (!hints_dir_.empty()) {
-        append_to_disk(hint);
+    writer_cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+
+    std::lock_guard io(io_mutex_);
+    flush_io(/*sync_all=*/true);
+    for (auto& [id, t] : hints_) {
+        if (t.fd >= 0) ::close(t.fd);
     }
 }
 
-std::vector<Hint> HintStore::get_hints_for(uint32_t target_node_id) const {
+void HintStore::set_options(const Options& options) {
     std::lock_guard lock(mutex_);
-    auto it = hints_.find(target_node_id);
-    if (it == hints_.end()) return {};
-    return it->second;
+    options_ = options;
 }
 
-void HintStore::clear_hints_for(uint32_t target_node_id) {
+void HintStore::finish_locked(TargetHints& t, const Entry& e) {
+    --t.pending;
+    t.live_bytes -= e.record_bytes;
+}
+
+bool HintStore::insert_locked(TargetHints& t, Entry entry) {
+    auto it = t.latest.find(entry.key);
+    if (it != t.latest.end()) {
+        Entry& prev = t.entries[it->second - t.first_seq];
+        if (!is_newer(entry.version, prev.version)) {
+            ++stats_.coalesced;
+            return false;
+        }
+        // The newer hint makes the queued one moot.
+        if (!prev.delivered && !prev.superseded) finish_locked(t, prev);
+        prev.superseded = true;
+        std::string().swap(prev.value);
+        ++stats_.coalesced;
+    }
+
+    const uint64_t seq = t.first_seq + t.entries.size();
+    t.latest[entry.key] = seq;
+    t.bytes      += entry.record_bytes;
+    t.live_bytes += entry.record_bytes;
+    t.entries.push_back(std::move(entry));
+    ++t.pending;
+    return true;
+}
+
+void HintStore::store(const Hint& hint) {
     std::lock_guard lock(mutex_);
-    hints_.erase(target_node_id);
+    auto& t = hints_[hint.target_node_id];
+    t.address = hint.target_address;
+    ++stats_.stored;
+    drop_finished_locked(t);  // expire old hints first
+
+    auto it = t.latest.find(hint.key);
+    if (it != t.latest.end() &&
+        !is_newer(hint.version, t.entries[it->second - t.first_seq].version)) {
+        ++stats_.coalesced;
+        return;  // an equal or newer version is already queued
+    }
+
+    Entry e;
+    e.key          = hint.key;
+    e.version      = hint.version;
+    e.is_del       = hint.is_del;
+    e.value        = hint.value;
+    e.value_len    = static_cast<uint32_t>(hint.value.size());
+    e.stored_ms    = wall_ms();
+    e.record_bytes = static_cast<uint32_t>(record_size(hint));
 
-    // Remove the on-disk file (best-effort).
+    // Size caps: pending hints per target (superseded ones only count until
+    // the writer compacts them away), and hints the writer has not reached.
+    if (options_.max_bytes > 0 && t.live_bytes + e.record_bytes > options_.max_bytes) {
+        ++stats_.dropped;
+        return;
+    }
     if (!hints_dir_.empty()) {
-        std::string path = hint_file_path(target_node_id);
-        std::error_code ec;
-        std::filesystem::remove(path, ec);
+        if (t.unwritten_bytes + e.record_bytes > MAX_UNWRITTEN_BYTES) {
+            ++stats_.dropped;
+            return;
+        }
+        t.unwritten_bytes += e.record_bytes;
+    }
+    insert_locked(t, std::move(e));
+
+    const size_t garbage = t.entries.size() - t.pending;
+    const bool   over_cap = options_.max_bytes > 0 && t.bytes > options_.max_bytes;
+    if ((garbage >= COMPACT_MIN_GARBAGE && garbage > t.pending) ||
+        (over_cap && garbage > 0)) {
+        t.compact_wanted = true;
+    }
+    if (hints_dir_.empty() && !t.compact_wanted) return;  // nothing to write
+
+    writer_work_ = true;
+    if (!writer_.joinable()) writer_ = std::thread([this] { writer_loop(); });
+    writer_cv_.notify_one();
+}
+
+void HintStore::flush() {
+    std::lock_guard io(io_mutex_);
+    flush_io(/*sync_all=*/true);
+}
+
+std::vector<Hint> HintStore::get_hints_for(uint32_t target_node_id) const {
+    std::lock_guard io(io_mutex_);
+    std::vector<Entry> live;
+    std::string address;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = hints_.find(target_node_id);
+        if (it == hints_.end()) return {};
+        address = it->second.address;
+        for (const auto& e : it->second.entries) {
+            if (!e.superseded && !e.delivered) live.push_back(e);
+        }
     }
+
+    std::vector<const Entry*> ptrs;
+    ptrs.reserve(live.size());
+    for (const auto& e : live) ptrs.push_back(&e);
+    auto values = read_values(target_node_id, ptrs);
+
+    std::vector<Hint> out;
+    out.reserve(live.size());
+    for (size_t i = 0; i < live.size(); i++) {
+        out.push_back(Hint{address, target_node_id, live[i].key,
+                           std::move(values[i]), live[i].is_del, live[i].version});
+    }
+    return out;
+}
+
+void HintStore::clear_hints_for(uint32_t target_node_id) {
+    std::lock_guard io(io_mutex_);
+    TargetHints* t = nullptr;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = hints_.find(target_node_id);
+        if (it == hints_.end()) return;
+        t = &it->second;
+    }
+    remove_files(target_node_id, *t);
+
+    std::lock_guard lock(mutex_);
+    hints_.erase(target_node_id);
 }
 
 size_t HintStore::size() const {
     std::lock_guard lock(mutex_);
     size_t total = 0;
-    for (const auto& [id, vec] : hints_) total += vec.size();
+    for (const auto& [id, t] : hints_) total += t.pending;
     return total;
 }
 
+size_t HintStore::size_for(uint32_t target_node_id) const {
+    std::lock_guard lock(mutex_);
+    auto it = hints_.find(target_node_id);
+    return it == hints_.end() ? 0 : it->second.pending;
+}
+
+HintStore::Stats HintStore::stats() const {
+    std::lock_guard lock(mutex_);
+    Stats s = stats_;
+    for (const auto& [id, t] : hints_) {
+        s.pending      += t.pending;
+        s.queued_bytes += t.bytes;
+    }
+    s.segments = segment_files_.load(std::memory_order_relaxed);
+    return s;
+}
+
+bool HintStore::begin_replay(uint32_t target_node_id) {
+    std::lock_guard lock(mutex_);
+    auto& t = hints_[target_node_id];
+    if (t.replaying) return false;
+    t.replaying = true;
+    return true;
+}
+
+void HintStore::end_replay(uint32_t target_node_id) {
+    std::lock_guard lock(mutex_);
+    auto it = hints_.find(target_node_id);
+    if (it != hints_.end()) it->second.replaying = false;
+}
+
+std::vector<ReplayItem> HintStore::next_for_replay(uint32_t target_node_id,
+                                                   uint64_t from_seq,
+                                                   size_t max,
+                                                   uint64_t& next_seq) {
+    std::lock_guard io(io_mutex_);
+    std::vector<ReplayItem> out;
+    next_seq = from_seq;
+
+    TargetHints*          t = nullptr;
+    std::vector<Entry>    batch;
+    std::vector<uint64_t> seqs;
+    std::string           address;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = hints_.find(target_node_id);
+        if (it == hints_.end()) return out;
+        t = &it->second;
+        drop_finished_locked(*t);  // don't replay expired hints
+
+        address = t->address;
+        uint64_t seq = std::max(from_seq, t->first_seq);
+        const uint64_t end = t->first_seq + t->entries.size();
+        for (; seq < end && batch.size() < max; ++seq) {
+            const Entry& e = t->entries[seq - t->first_seq];
+            if (e.superseded || e.delivered) continue;
+            batch.push_back(e);
+            seqs.push_back(seq);
+        }
+        next_seq = seq;
+    }
+    trim_files(target_node_id, *t);
+
+    std::vector<const Entry*> ptrs;
+    ptrs.reserve(batch.size());
+    for (const auto& e : batch) ptrs.push_back(&e);
+    auto values = read_values(target_node_id, ptrs);
+    out.reserve(batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+        out.push_back(ReplayItem{
+            seqs[i], Hint{address, target_node_id, batch[i].key,
+                          std::move(values[i]), batch[i].is_del,
+                          batch[i].version}});
+    }
+    return out;
+}
+
+void HintStore::ack(uint32_t target_node_id, const std::vector<uint64_t>& seqs) {
+    std::lock_guard io(io_mutex_);
+    TargetHints* t = nullptr;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = hints_.find(target_node_id);
+        if (it == hints_.end()) return;
+        t = &it->second;
+
+        for (uint64_t seq : seqs) {
+            if (seq < t->first_seq || seq >= t->first_seq + t->entries.size()) continue;
+            Entry& e = t->entries[seq - t->first_seq];
+            if (e.delivered) continue;
+            if (!e.superseded) finish_locked(*t, e);
+            e.delivered = true;
+            ++stats_.delivered;
+        }
+        drop_finished_locked(*t);
+    }
+    trim_files(target_node_id, *t);
+}
+
 void HintStore::load() {
     if (hints_dir_.empty()) return;
 
     std::error_code ec;
     if (!std::filesystem::exists(hints_dir_, ec)) return;
 
+    std::lock_guard io(io_mutex_);
+
+    // Segments are named "hints_<target>.<segment>.log".
+    std::map<uint32_t, std::vector<uint32_t>> found;
     for (const auto& entry : std::filesystem::directory_iterator(hints_dir_, ec)) {
         const std::string fname = entry.path().filename().string();
-        // Only process files named "hints_<id>.dat"
         if (fname.rfind("hints_", 0) != 0) continue;
-        if (fname.size() < 11) continue;  // "hints_X.dat" minimum
+        if (entry.path().extension() != ".log") continue;
+        unsigned long target = 0, segment = 0;
+        char dot = 0;
+        std::istringstream in(fname.substr(6));
+        if (!(in >> target >> dot >> segment) || dot != '.') continue;
+        found[static_cast<uint32_t>(target)].push_back(static_cast<uint32_t>(segment));
+    }
 
-        auto hints = load_file(entry.path().string());
+    for (auto& [target, segments] : found) {
+        std::sort(segments.begin(), segments.end());
+
+        // Resume after the hints a previous replay already delivered.
+        uint32_t ckpt_segment = 0;
+        uint64_t ckpt_offset  = 0;
+        {
+            std::ifstream ckpt(checkpoint_path(target), std::ios::binary);
+            if (ckpt) {
+                ckpt.read(reinterpret_cast<char*>(&ckpt_segment), 4);
+                ckpt.read(reinterpret_cast<char*>(&ckpt_offset), 8);
+                if (!ckpt) ckpt_segment = 0, ckpt_offset = 0;
+            }
+        }
+
+        for (uint32_t seg : segments) {
+            if (seg < ckpt_segment) {
+                std::filesystem::remove(segment_path(target, seg), ec);
+                continue;
+            }
+            load_segment(target, seg, seg == ckpt_segment ? ckpt_offset : 0);
+        }
+
+        TargetHints* t = nullptr;
+        {
+            std::lock_guard lock(mutex_);
+            t = &hints_[target];
+            t->next_segment = segments.back() + 1;
+            t->write_seq    = t->first_seq + t->entries.size();  // all on disk
+            drop_finished_locked(*t);
+        }
+        trim_files(target, *t);
+    }
+}
+
+// ── Writer ───────────────────────────────────────────────────────────────────
+
+void HintStore::writer_loop() {
+    std::unique_lock lock(mutex_);
+    while (!writer_stop_) {
+        // Wake for new work, or to fsync what the last round appended.
+        const uint32_t sync_ms = options_.sync_interval_ms;
+        writer_cv_.wait_for(lock,
+                            std::chrono::milliseconds(sync_ms > 0 ? sync_ms : WRITER_IDLE_MS),
+                            [this] { return writer_stop_ || writer_work_; });
+        if (writer_stop_) break;
+        lock.unlock();
+        {
+            std::lock_guard io(io_mutex_);
+            flush_io(/*sync_all=*/false);
+        }
+        lock.lock();
+    }
+}
+
+void HintStore::flush_io(bool sync_all) {
+    std::vector<std::pair<uint32_t, TargetHints*>> targets;
+    uint32_t sync_ms = 0;
+    {
         std::lock_guard lock(mutex_);
-        for (auto& h : hints) {
-            hints_[h.target_node_id].push_back(std::move(h));
+        writer_work_ = false;
+        sync_ms      = options_.sync_interval_ms;
+        for (auto& [id, t] : hints_) targets.emplace_back(id, &t);
+    }
+    // Targets are only erased under io_mutex_, so the pointers stay valid.
+    for (auto& [id, t] : targets) {
+        write_pending(id, *t);
+        compact(id, *t);
+        trim_files(id, *t);
+        sync_segment(*t, sync_ms, sync_all);
+    }
+}
+
+void HintStore::write_pending(uint32_t target, TargetHints& t) {
+    if (hints_dir_.empty()) return;
+
+    while (true) {
+        // Take a batch under mutex_ (moving the values out), write it
+        // without.  Readers of values hold io_mutex_, so none sees a hint
+        // in flight.
+        std::vector<uint64_t> seqs;
+        std::vector<Hint>     batch;
+        std::vector<Entry>    placed;
+        uint64_t              segment_bytes = 0;
+        {
+            std::lock_guard lock(mutex_);
+            t.write_seq = std::max(t.write_seq, t.first_seq);
+            const uint64_t end = t.first_seq + t.entries.size();
+            if (t.write_seq == end) return;
+            segment_bytes = options_.segment_bytes;
+            for (; t.write_seq < end && batch.size() < WRITE_BATCH; ++t.write_seq) {
+                Entry& e = t.entries[t.write_seq - t.first_seq];
+                t.unwritten_bytes -= e.record_bytes;
+                if (e.superseded || e.delivered) continue;  // never needed on disk
+                seqs.push_back(t.write_seq);
+                batch.push_back(Hint{t.address, target, e.key, std::move(e.value),
+                                     e.is_del, e.version});
+                placed.emplace_back().stored_ms = e.stored_ms;
+            }
+        }
+
+        std::vector<bool> ok(batch.size());
+        for (size_t i = 0; i < batch.size(); i++) {
+            ok[i] = append_record(target, t, batch[i], segment_bytes, placed[i]);
+        }
+
+        std::lock_guard lock(mutex_);
+        for (size_t i = 0; i < seqs.size(); i++) {
+            if (seqs[i] < t.first_seq) continue;  // expired meanwhile
+            Entry& e = t.entries[seqs[i] - t.first_seq];
+            if (ok[i]) {
+                e.segment      = placed[i].segment;
+                e.offset       = placed[i].offset;
+                e.value_offset = placed[i].value_offset;
+                continue;
+            }
+            // Lost: the value is gone with the failed write.
+            if (!e.superseded && !e.delivered) finish_locked(t, e);
+            e.superseded = true;
+            auto latest = t.latest.find(e.key);
+            if (latest != t.latest.end() && latest->second == seqs[i]) {
+                t.latest.erase(latest);
+            }
+            ++stats_.dropped;
         }
     }
 }
 
 // ── Private helpers ──────────────────────────────────────────────────────────
 
-void HintStore::append_to_disk(const Hint& hint) const {
-    std::string path = hint_file_path(hint.target_node_id);
+bool HintStore::append_record(uint32_t target, TargetHints& t, const Hint& hint,
+                              uint64_t segment_bytes, Entry& entry) {
+    size_t value_pos = 0;
+    const std::string rec = encode_record(hint, entry.stored_ms, value_pos);
 
-    // Ensure directory exists.
-    std::error_code ec;
-    std::filesystem::create_directories(hints_dir_, ec);
+    const bool full = !t.segments.empty() && t.segments.back().size > 0 &&
+                      t.segments.back().size + rec.size() > segment_bytes;
+    if (t.fd < 0 || full) {
+        if (t.fd >= 0) {
+            ::fsync(t.fd);
+            ::close(t.fd);
+            t.fd = -1;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(hints_dir_, ec);
+        const uint32_t id = t.next_segment++;
+        const std::string path = segment_path(target, id);
+        t.fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (t.fd < 0) {
+            std::cerr << "[HINT] Cannot open hint segment: " << path << "\n";
+            return false;
+        }
+        t.segments.push_back(Segment{id, 0});
+        segment_files_.fetch_add(1, std::memory_order_relaxed);
+        t.last_sync = Clock::now();
+        t.dirty     = false;
+    }
+
+    Segment& seg = t.segments.back();
+    if (!write_all(t.fd, rec)) {
+        std::cerr << "[HINT] Write failed on segment " << seg.id
+                  << " for node " << target << "\n";
+        return false;
+    }
+    entry.segment      = seg.id;
+    entry.offset       = seg.size;
+    entry.value_offset = seg.size + value_pos;
+    entry.value_len    = static_cast<uint32_t>(hint.value.size());
+    seg.size += rec.size();
+    t.dirty = true;
+    return true;
+}
+
+void HintStore::sync_segment(TargetHints& t, uint32_t sync_interval_ms, bool force) {
+    if (t.fd < 0 || !t.dirty) return;
+    auto now = Clock::now();
+    if (force || sync_interval_ms == 0 ||
+        now - t.last_sync >= std::chrono::milliseconds(sync_interval_ms)) {
+        ::fsync(t.fd);
+        t.last_sync = now;
+        t.dirty     = false;
+    }
+}
+
+void HintStore::drop_finished_locked(TargetHints& t) {
+    const uint64_t now = wall_ms();
+    bool advanced = false;
+    while (!t.entries.empty()) {
+        Entry& e = t.entries.front();
+        if (!e.superseded && !e.delivered) {
+            // Live: only an expired hint can go.  The node has been away
+            // longer than hints are worth keeping; anti-entropy takes over.
+            if (options_.max_age_ms == 0 || now < e.stored_ms ||
+                now - e.stored_ms <= options_.max_age_ms) {
+                break;
+            }
+            finish_locked(t, e);
+            ++stats_.expired;
+        }
+        auto latest = t.latest.find(e.key);
+        if (latest != t.latest.end() && latest->second == t.first_seq) {
+            t.latest.erase(latest);
+        }
+        t.bytes -= e.record_bytes;
+        if (!hints_dir_.empty() && t.first_seq >= t.write_seq) {
+            t.unwritten_bytes -= e.record_bytes;  // never reached the writer
+        }
+        t.entries.pop_front();
+        ++t.first_seq;
+        advanced = true;
+    }
+    if (advanced && !hints_dir_.empty()) t.files_stale = true;
+}
 
-    std::ofstream f(path, std::ios::binary | std::ios::app);
-    if (!f) {
-        std::cerr << "[HINT] Cannot open hint file: " << path << "\n";
+void HintStore::trim_files(uint32_t target, TargetHints& t) {
+    if (hints_dir_.empty()) return;
+
+    // Where the first hint still on disk starts.  Hints not written yet
+    // (from write_seq on) go to later segments.
+    bool     drained       = true;
+    uint32_t first_segment = 0;
+    uint64_t first_offset  = 0;
+    {
+        std::lock_guard lock(mutex_);
+        if (!t.files_stale) return;
+        t.files_stale = false;
+        const uint64_t end = std::min<uint64_t>(t.write_seq,
+                                                t.first_seq + t.entries.size());
+        for (uint64_t seq = t.first_seq; seq < end; ++seq) {
+            const Entry& e = t.entries[seq - t.first_seq];
+            if (e.segment == NO_SEGMENT) continue;
+            drained       = false;
+            first_segment = e.segment;
+            first_offset  = e.offset;
+            break;
+        }
+    }
+
+    if (drained) {
+        remove_files(target, t);
         return;
     }
 
-    // Record format (all fields little-endian on this platform):
-    //   [target_node_id u32][addr_len u32][addr bytes]
-    //   [key_len u32][key bytes][val_len u32][val bytes]
-    //   [timestamp_ms u64][node_id u32][is_del u8]
-    write_u32(f, hint.target_node_id);
-    write_str(f, hint.target_address);
-    write_str(f, hint.key);
-    write_str(f, hint.value);
-    write_u64(f, hint.version.timestamp_ms);
-    write_u32(f, hint.version.node_id);
-    write_u8 (f, hint.is_del ? 1 : 0);
+    // Segments wholly before the first remaining hint are done.
+    std::error_code ec;
+    while (!t.segments.empty() && t.segments.front().id < first_segment) {
+        std::filesystem::remove(segment_path(target, t.segments.front().id), ec);
+        t.segments.pop_front();
+        segment_files_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Write-then-rename so a crash never leaves a torn checkpoint.
+    const std::string path = checkpoint_path(target);
+    const std::string tmp  = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            std::cerr << "[HINT] Cannot write checkpoint: " << tmp << "\n";
+            return;
+        }
+        f.write(reinterpret_cast<const char*>(&first_segment), 4);
+        f.write(reinterpret_cast<const char*>(&first_offset), 8);
+    }
+    std::filesystem::rename(tmp, path, ec);
+}
+
+void HintStore::reindex_locked(TargetHints& t) {
+    t.latest.clear();
+    t.bytes      = 0;
+    t.live_bytes = 0;
+    t.pending    = 0;
+    for (size_t i = 0; i < t.entries.size(); i++) {
+        const Entry& e = t.entries[i];
+        t.bytes += e.record_bytes;
+        if (e.superseded) continue;
+        t.latest[e.key] = t.first_seq + i;
+        if (e.delivered) continue;
+        t.live_bytes += e.record_bytes;
+        ++t.pending;
+    }
+}
+
+void HintStore::compact(uint32_t target, TargetHints& t) {
+    {
+        std::lock_guard lock(mutex_);
+        if (!t.compact_wanted || t.replaying) return;
+        if (hints_dir_.empty()) {
+            // Values are in memory: just drop the finished entries.
+            std::deque<Entry> entries;
+            for (auto& e : t.entries) {
+                if (!e.superseded && !e.delivered) entries.push_back(std::move(e));
+            }
+            t.first_seq += t.entries.size();
+            t.entries.swap(entries);
+            reindex_locked(t);
+            t.compact_wanted = false;
+            ++stats_.compactions;
+            return;
+        }
+    }
+
+    write_pending(target, t);  // everything in the snapshot is on disk
+
+    // Snapshot the live hints written so far; new ones keep arriving while
+    // the log is rewritten and are carried over unwritten.
+    std::vector<Entry>    live;
+    std::vector<uint64_t> seqs;
+    std::string           address;
+    uint64_t              snap_end      = 0;
+    uint64_t              segment_bytes = 0;
+    {
+        std::lock_guard lock(mutex_);
+        t.compact_wanted = false;
+        address          = t.address;
+        segment_bytes    = options_.segment_bytes;
+        snap_end         = std::max(t.write_seq, t.first_seq);
+        for (uint64_t seq = t.first_seq; seq < snap_end; ++seq) {
+            const Entry& e = t.entries[seq - t.first_seq];
+            if (e.superseded || e.delivered) continue;
+            live.push_back(e);
+            seqs.push_back(seq);
+        }
+    }
+
+    std::vector<const Entry*> ptrs;
+    ptrs.reserve(live.size());
+    for (const auto& e : live) ptrs.push_back(&e);
+    auto values = read_values(target, ptrs);
+
+    // Rewrite the log: new segments first, then drop the old ones, so a
+    // crash in between leaves duplicates (coalesced on load), never gaps.
+    if (t.fd >= 0) {
+        ::close(t.fd);
+        t.fd = -1;
+    }
+    std::deque<Segment> old_segments;
+    old_segments.swap(t.segments);
+    std::vector<bool> ok(live.size());
+    for (size_t i = 0; i < live.size(); i++) {
+        Hint h{address, target, live[i].key, std::move(values[i]),
+               live[i].is_del, live[i].version};
+        ok[i] = append_record(target, t, h, segment_bytes, live[i]);
+    }
+    sync_segment(t, 0, /*force=*/true);
+
+    {
+        std::lock_guard lock(mutex_);
+        std::deque<Entry> entries;
+        for (size_t i = 0; i < live.size(); i++) {
+            if (seqs[i] < t.first_seq) continue;  // expired meanwhile
+            Entry& e = t.entries[seqs[i] - t.first_seq];
+            if (e.superseded || e.delivered) continue;  // superseded meanwhile
+            if (!ok[i]) {
+                ++stats_.dropped;
+                continue;
+            }
+            e.segment      = live[i].segment;
+            e.offset       = live[i].offset;
+            e.value_offset = live[i].value_offset;
+            entries.push_back(std::move(e));
+        }
+        const size_t written = entries.size();
+        const uint64_t end = t.first_seq + t.entries.size();
+        for (uint64_t seq = std::max(snap_end, t.first_seq); seq < end; ++seq) {
+            entries.push_back(std::move(t.entries[seq - t.first_seq]));
+        }
+
+        // Fresh sequence numbers: anything handed out before is stale now.
+        t.first_seq += t.entries.size();
+        t.entries.swap(entries);
+        t.write_seq = t.first_seq + written;
+        reindex_locked(t);
+        ++stats_.compactions;
+    }
+
+    std::error_code ec;
+    for (const auto& seg : old_segments) {
+        std::filesystem::remove(segment_path(target, seg.id), ec);
+    }
+    segment_files_.fetch_sub(old_segments.size(), std::memory_order_relaxed);
+    std::filesystem::remove(checkpoint_path(target), ec);
+}
+
+std::vector<std::string> HintStore::read_values(
+    uint32_t target, const std::vector<const Entry*>& entries) const {
+    std::vector<std::string> out(entries.size());
+    std::map<uint32_t, MappedFile> maps;
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& e = *entries[i];
+        if (e.segment == NO_SEGMENT) {
+            out[i] = e.value;  // in-memory mode, or not written yet
+            continue;
+        }
+        auto it = maps.find(e.segment);
+        if (it == maps.end()) {
+            it = maps.emplace(e.segment,
+                              MappedFile(segment_path(target, e.segment))).first;
+        }
+        const MappedFile& m = it->second;
+        if (m.data() && e.value_offset + e.value_len <= m.size()) {
+            out[i].assign(m.data() + e.value_offset, e.value_len);
+        }
+    }
+    return out;
+}
+
+void HintStore::remove_files(uint32_t target, TargetHints& t) {
+    if (hints_dir_.empty()) return;
+    if (t.fd >= 0) {
+        ::close(t.fd);
+        t.fd = -1;
+    }
+    t.dirty = false;
+    std::error_code ec;
+    for (const auto& seg : t.segments) {
+        std::filesystem::remove(segment_path(target, seg.id), ec);
+    }
+    segment_files_.fetch_sub(t.segments.size(), std::memory_order_relaxed);
+    t.segments.clear();
+    std::filesystem::remove(checkpoint_path(target), ec);
 }
 
-std::string HintStore::hint_file_path(uint32_t target_node_id) const {
-    return hints_dir_ + "/hints_" + std::to_string(target_node_id) + ".dat";
+std::string HintStore::segment_path(uint32_t target, uint32_t segment) const {
+    return hints_dir_ + "/hints_" + std::to_string(target) + "." +
+           std::to_string(segment) + ".log";
 }
 
-std::vector<Hint> HintStore::load_file(const std::string& path) const {
-    std::vector<Hint> result;
-    std::ifstream f(path, std::ios::binary);
-    if (!f) return result;
+std::string HintStore::checkpoint_path(uint32_t target) const {
+    return hints_dir_ + "/hints_" + std::to_string(target) + ".ckpt";
+}
 
-    while (f.peek() != EOF) {
-        Hint h;
-        uint8_t is_del_byte = 0;
+void HintStore::load_segment(uint32_t target, uint32_t segment, uint64_t offset) {
+    const std::string path = segment_path(target, segment);
+    uint64_t valid = offset;
+    {
+        MappedFile m(path);
+        const char* base = m.data();
+        while (base && valid + RECORD_HEADER <= m.size()) {
+            uint32_t len = 0, crc = 0;
+            std::memcpy(&len, base + valid, 4);
+            std::memcpy(&crc, base + valid + 4, 4);
+            if (m.size() - valid - RECORD_HEADER < len) break;  // torn tail
+            const char* payload = base + valid + RECORD_HEADER;
+            if (crc32(payload, len) != crc) break;              // corrupt
 
-        if (!read_u32(f, h.target_node_id))   break;
-        if (!read_str(f, h.target_address))    break;
-        if (!read_str(f, h.key))               break;
-        if (!read_str(f, h.value))             break;
-        if (!read_u64(f, h.version.timestamp_ms)) break;
-        if (!read_u32(f, h.version.node_id))   break;
-        if (!read_u8 (f, is_del_byte))         break;
+            Cursor c{payload, payload + len};
+            Hint h;
+            uint8_t del = 0;
+            uint64_t stored_ms = 0;
+            if (!c.u32(h.target_node_id) || !c.str(h.target_address) ||
+                !c.str(h.key)) {
+                break;
+            }
+            const uint64_t value_offset = valid + RECORD_HEADER +
+                                          static_cast<uint64_t>(c.p - payload) + 4;
+            if (!c.str(h.value) || !c.u64(h.version.timestamp_ms) ||
+                !c.u32(h.version.node_id) || !c.u8(del) || !c.u64(stored_ms)) {
+                break;
+            }
 
-        h.is_del = (is_del_byte != 0);
-        result.push_back(std::move(h));
+            Entry e;
+            e.key          = std::move(h.key);
+            e.version      = h.version;
+            e.is_del       = del != 0;
+            e.segment      = segment;
+            e.offset       = valid;
+            e.value_offset = value_offset;
+            e.value_len    = static_cast<uint32_t>(h.value.size());
+            e.record_bytes = static_cast<uint32_t>(RECORD_HEADER + len);
+            e.stored_ms    = stored_ms;
+
+            std::lock_guard lock(mutex_);
+            auto& t = hints_[target];
+            t.address = h.target_address;
+            insert_locked(t, std::move(e));
+            valid += RECORD_HEADER + len;
+        }
+    }
+
+    // Cut off a torn or corrupt tail so later reads never run into it.
+    std::error_code ec;
+    if (std::filesystem::file_size(path, ec) != valid && !ec) {
+        std::cerr << "[HINT] Truncating damaged hint segment " << path
+                  << " at offset " << valid << "\n";
+        std::filesystem::resize_file(path, valid, ec);
     }
 
-    return result;
+    std::lock_guard lock(mutex_);
+    hints_[target].segments.push_back(Segment{segment, valid});
+    segment_files_.fetch_add(1, std::memory_order_relaxed);
 }
 
 }  // namespace dkv
@@ -0,0 +1,163 @@
+#include "replication/repair_queue.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace dkv {
+
+namespace {
+/// How often the worker logs a summary while repairs are flowing.
+constexpr auto REPORT_INTERVAL = std::chrono::seconds(10);
+}  // namespace
+
+RepairQueue::RepairQueue(Sender sender)
+    : RepairQueue(std::move(sender), Options{}) {}
+
+RepairQueue::RepairQueue(Sender sender, Options options)
+    : sender_(std::move(sender)), options_(options), bucket_(options.rate_bytes_per_sec) {
+    auto now      = Clock::now();
+    window_start_ = now;
+    last_report_  = now;
+    worker_       = std::thread(&RepairQueue::run, this);
+}
+
+RepairQueue::~RepairQueue() {
+    stop();
+}
+
+bool RepairQueue::enqueue(const NodeInfo& target, const std::string& key,
+                          std::shared_ptr<const std::string> value,
+                          const Version& version) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& tq = targets_[target.node_id];
+        tq.target = target;
+
+        auto it = tq.items.find(key);
+        if (it != tq.items.end()) {
+            // Already pending: keep whichever version is newer.
+            ++stats_.deduplicated;
+            if (!is_newer(version, it->second.version)) return true;
+            stats_.queued_bytes -= item_bytes(it->second);
+            it->second.value   = std::move(value);
+            it->second.version = version;
+            stats_.queued_bytes += item_bytes(it->second);
+            return true;
+        }
+
+        RepairItem item{key, std::move(value), version};
+        size_t bytes = item_bytes(item);
+        if (stats_.queued_bytes + bytes > options_.max_bytes) {
+            ++stats_.dropped;
+            if (tq.items.empty()) targets_.erase(target.node_id);
+            return false;
+        }
+
+        tq.order.push_back(key);
+        tq.items.emplace(key, std::move(item));
+        stats_.queued_bytes += bytes;
+        ++stats_.depth;
+        ++stats_.enqueued;
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void RepairQueue::set_options(const Options& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    bucket_.set_rate(options_.rate_bytes_per_sec);
+}
+
+void RepairQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_one();
+    if (worker_.joinable()) worker_.join();
+}
+
+RepairQueue::Stats RepairQueue::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = stats_;
+    // The worker only rolls the window when it sends; an idle queue would
+    // otherwise keep reporting its last busy second.
+    auto elapsed = std::chrono::duration<double>(Clock::now() - window_start_);
+    if (elapsed.count() >= 1.0) {
+        s.repairs_per_sec = static_cast<double>(window_repaired_) /
+                            elapsed.count();
+    }
+    return s;
+}
+
+bool RepairQueue::take_batch(NodeInfo& target, std::vector<RepairItem>& batch,
+                             size_t& bytes) {
+    if (targets_.empty()) return false;
+
+    // Round-robin: the first target after the one served last.
+    auto it = targets_.upper_bound(last_target_);
+    if (it == targets_.end()) it = targets_.begin();
+    last_target_ = it->first;
+
+    TargetQueue& tq = it->second;
+    target = tq.target;
+    bytes  = 0;
+    const size_t limit = std::max<size_t>(options_.batch_max, 1);
+    while (!tq.order.empty() && batch.size() < limit) {
+        auto node = tq.items.extract(tq.order.front());
+        tq.order.pop_front();
+        bytes += item_bytes(node.mapped());
+        batch.push_back(std::move(node.mapped()));
+    }
+
+    stats_.depth        -= batch.size();
+    stats_.queued_bytes -= bytes;
+    if (tq.order.empty()) targets_.erase(it);
+    return true;
+}
+
+void RepairQueue::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this]() { return !targets_.empty() || !running_; });
+        if (targets_.empty()) return;  // stopped and drained
+
+        // Shutdown drains without pacing.
+        bucket_.wait(lock, cv_, [this] { return !running_; });
+
+        NodeInfo target;
+        std::vector<RepairItem> batch;
+        size_t bytes = 0;
+        if (!take_batch(target, batch, bytes)) continue;
+        bucket_.consume(bytes);
+
+        lock.unlock();
+        size_t ok = sender_(target, batch);
+        lock.lock();
+
+        ok = std::min(ok, batch.size());
+        stats_.repaired += ok;
+        stats_.failed   += batch.size() - ok;
+        window_repaired_ += ok;
+
+        auto now = Clock::now();
+        auto elapsed = std::chrono::duration<double>(now - window_start_).count();
+        if (elapsed >= 1.0) {
+            stats_.repairs_per_sec = static_cast<double>(window_repaired_) / elapsed;
+            window_repaired_ = 0;
+            window_start_    = now;
+        }
+        if (now - last_report_ >= REPORT_INTERVAL) {
+            last_report_ = now;
+            std::cerr << "[REPAIR] depth=" << stats_.depth
+                      << " repaired=" << stats_.repaired
+                      << " (" << static_cast<uint64_t>(stats_.repairs_per_sec)
+                      << "/s) deduplicated=" << stats_.deduplicated
+                      << " dropped=" << stats_.dropped
+                      << " failed=" << stats_.failed << "\n";
+        }
+    }
+}
+
+}  // namespace dkv
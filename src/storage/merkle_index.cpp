@@ -0,0 +1,65 @@
+#include "storage/merkle_index.h"
+#include "storage/storage_engine.h"
+#include "utils/murmurhash3.h"
+
+#include <algorithm>
+
+namespace dkv {
+
+MerkleIndex::MerkleIndex(std::vector<uint64_t> tokens)
+    : tokens_(std::move(tokens)) {
+    if (tokens_.empty()) tokens_.push_back(0);  // one range covering the ring
+    leaves_ = std::make_unique<std::atomic<uint64_t>[]>(leaf_count());
+    for (size_t i = 0; i < leaf_count(); i++) leaves_[i].store(0);
+    fingerprint_ = murmurhash3_x64_128(tokens_.data(),
+                                       tokens_.size() * sizeof(uint64_t)).h1;
+}
+
+uint64_t MerkleIndex::entry_hash(uint64_t key_hash, const Version& version,
+                                 bool tombstone) {
+    uint64_t buf[3] = {key_hash, version.timestamp_ms,
+                       (static_cast<uint64_t>(version.node_id) << 1) |
+                           (tombstone ? 1u : 0u)};
+    return murmurhash3_x64_128(buf, sizeof(buf)).h1;
+}
+
+uint64_t MerkleIndex::range_start(uint32_t range) const {
+    return range == 0 ? tokens_.back() : tokens_[range - 1];
+}
+
+uint32_t MerkleIndex::range_of(uint64_t position) const {
+    auto it = std::upper_bound(tokens_.begin(), tokens_.end(), position);
+    if (it == tokens_.end()) return 0;  // wraps to the first token
+    return static_cast<uint32_t>(it - tokens_.begin());
+}
+
+uint32_t MerkleIndex::leaf_of(uint64_t position) const {
+    uint32_t range = range_of(position);
+    // Unsigned wrap-around handles range 0 and the single-token ring
+    // (width 0 meaning the full 2^64).
+    uint64_t start  = range_start(range);
+    uint64_t width  = tokens_[range] - start;
+    uint64_t offset = position - start;
+    uint64_t step   = (width - 1) / LEAVES_PER_RANGE + 1;
+    return range * LEAVES_PER_RANGE + static_cast<uint32_t>(offset / step);
+}
+
+void MerkleIndex::update(uint64_t position, uint64_t old_hash,
+                         uint64_t new_hash) {
+    leaves_[leaf_of(position)].fetch_xor(old_hash ^ new_hash,
+                                         std::memory_order_relaxed);
+}
+
+uint64_t MerkleIndex::leaf_hash(uint32_t leaf) const {
+    return leaves_[leaf].load(std::memory_order_relaxed);
+}
+
+uint64_t MerkleIndex::range_hash(uint32_t range) const {
+    uint64_t h = 0;
+    for (uint32_t i = 0; i < LEAVES_PER_RANGE; i++) {
+        h ^= leaf_hash(range * LEAVES_PER_RANGE + i);
+    }
+    return h;
+}
+
+}  // namespace dkv
@@ -1,6 +1,8 @@
 #include "storage/snapshot.h"
+#include "utils/metrics.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
@@ -33,9 +35,7 @@ uint64_t read_u64(std::ifstream& in) {
     return v;
 }
 
-}  // namespace
-
-bool Snapshot::save(const StorageEngine& engine, uint64_t seq_no,
+bool write_snapshot(const StorageEngine& engine, uint64_t seq_no,
                     const std::string& directory) {
     std::filesystem::create_directories(directory);
 
@@ -72,6 +72,22 @@ bool Snapshot::save(const StorageEngine& engine, uint64_t seq_no,
     return out.good();
 }
 
+}  // namespace
+
+bool Snapshot::save(const StorageEngine& engine, uint64_t seq_no,
+                    const std::string& directory) {
+    static LatencyMetric& latency = Metrics::instance().latency(
+        "dkv_snapshot_save_seconds", "Time to write a snapshot");
+    static Counter& failures = Metrics::instance().counter(
+        "dkv_snapshot_failures_total", "Snapshots that could not be written");
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok    = write_snapshot(engine, seq_no, directory);
+    latency.record_since(start);
+    if (!ok) failures.add();
+    return ok;
+}
+
 std::optional<SnapshotData> Snapshot::load(const std::string& filepath) {
     std::ifstream in(filepath, std::ios::binary);
     if (!in) {
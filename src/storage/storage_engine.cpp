@@ -1,6 +1,7 @@
 #include "storage/storage_engine.h"
 #include "utils/murmurhash3.h"
 
+#include <algorithm>
 #include <mutex>
 
 namespace dkv {
@@ -21,9 +22,22 @@ GetResult StorageEngine::get(const std::string& key) const {
     return {true, it->second.value, it->second.version};
 }
 
+std::optional<Version> StorageEngine::get_version(const std::string& key) const {
+    const auto& shard = shards_[shard_index(key)];
+    std::shared_lock lock(shard.mutex);
+
+    auto it = shard.data.find(key);
+    if (it == shard.data.end() || it->second.is_tombstone) {
+        return std::nullopt;
+    }
+    return it->second.version;
+}
+
 bool StorageEngine::set(const std::string& key, const std::string& value,
                         const Version& version) {
-    auto& shard = shards_[shard_index(key)];
+    // One hash serves both the shard choice and the Merkle leaf.
+    const auto hash = murmurhash3_x64_128(key.data(), key.size());
+    auto& shard = shards_[hash.h1 % NUM_SHARDS];
     std::unique_lock lock(shard.mutex);
 
     auto it = shard.data.find(key);
@@ -31,12 +45,42 @@ bool StorageEngine::set(const std::string& key, const std::string& value,
         return false;  // existing entry is same age or newer — reject
     }
 
-    shard.data[key] = ValueEntry{false, value, version};
+    track_write(hash, it != shard.data.end() ? &it->second : nullptr, version,
+                false);
+    if (it != shard.data.end()) {
+        it->second = ValueEntry{false, value, version};
+    } else {
+        shard.data.emplace(key, ValueEntry{false, value, version});
+    }
+    return true;
+}
+
+bool StorageEngine::set(const std::string& key, std::string&& value,
+                        const Version& version) {
+    // One hash serves both the shard choice and the Merkle leaf.
+    const auto hash = murmurhash3_x64_128(key.data(), key.size());
+    auto& shard = shards_[hash.h1 % NUM_SHARDS];
+    std::unique_lock lock(shard.mutex);
+
+    auto it = shard.data.find(key);
+    if (it != shard.data.end() && !is_newer(version, it->second.version)) {
+        return false;  // existing entry is same age or newer — reject
+    }
+
+    track_write(hash, it != shard.data.end() ? &it->second : nullptr, version,
+                false);
+    if (it != shard.data.end()) {
+        it->second = ValueEntry{false, std::move(value), version};
+    } else {
+        shard.data.emplace(key, ValueEntry{false, std::move(value), version});
+    }
     return true;
 }
 
 bool StorageEngine::del(const std::string& key, const Version& version) {
-    auto& shard = shards_[shard_index(key)];
+    // One hash serves both the shard choice and the Merkle leaf.
+    const auto hash = murmurhash3_x64_128(key.data(), key.size());
+    auto& shard = shards_[hash.h1 % NUM_SHARDS];
     std::unique_lock lock(shard.mutex);
 
     auto it = shard.data.find(key);
@@ -45,6 +89,8 @@ bool StorageEngine::del(const std::string& key, const Version& version) {
     }
 
     // Write tombstone instead of erasing.  Preserves version for read repair.
+    track_write(hash, it != shard.data.end() ? &it->second : nullptr, version,
+                true);
     shard.data[key] = ValueEntry{true, "", version};
     return true;
 }
@@ -72,4 +118,116 @@ StorageEngine::all_entries() const {
     // All 32 shared locks are released here when `locks` goes out of scope.
 }
 
+void StorageEngine::track_write(const MurmurHash3Result& h,
+                                const ValueEntry* old_entry,
+                                const Version& version, bool tombstone) {
+    if (!merkle_) return;
+    uint64_t old_hash = old_entry ? MerkleIndex::entry_hash(
+        h.h2, old_entry->version, old_entry->is_tombstone) : 0;
+    merkle_->update(h.h1, old_hash,
+                    MerkleIndex::entry_hash(h.h2, version, tombstone));
+}
+
+void StorageEngine::attach_merkle(std::shared_ptr<MerkleIndex> index) {
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(NUM_SHARDS);
+    for (auto& shard : shards_) {
+        locks.emplace_back(shard.mutex);
+    }
+
+    if (index) {
+        for (const auto& shard : shards_) {
+            for (const auto& [k, v] : shard.data) {
+                auto h = murmurhash3_x64_128(k.data(), k.size());
+                index->update(h.h1, 0, MerkleIndex::entry_hash(
+                    h.h2, v.version, v.is_tombstone));
+            }
+        }
+    }
+    merkle_ = std::move(index);
+}
+
+std::shared_ptr<MerkleIndex> StorageEngine::merkle() const {
+    std::shared_lock lock(shards_[0].mutex);
+    return merkle_;
+}
+
+std::vector<EntryVersion> StorageEngine::versions_in_leaves(
+    const std::vector<uint32_t>& leaves) const {
+    std::vector<EntryVersion> result;
+    auto index = merkle();
+    if (!index || leaves.empty()) return result;
+
+    for (const auto& shard : shards_) {
+        std::shared_lock lock(shard.mutex);
+        for (const auto& [k, v] : shard.data) {
+            uint32_t leaf = index->leaf_of(murmurhash3(k));
+            if (std::binary_search(leaves.begin(), leaves.end(), leaf)) {
+                result.push_back(EntryVersion{k, v.version, v.is_tombstone});
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> StorageEngine::keys_in_ranges(
+    const std::vector<TokenRange>& ranges, size_t shard) const {
+    std::vector<std::string> keys;
+    if (shard >= NUM_SHARDS || ranges.empty()) return keys;
+
+    // Flatten the (possibly wrapping) ranges into sorted, inclusive
+    // [lo, hi] spans so each key costs one binary search.
+    std::vector<std::pair<uint64_t, uint64_t>> spans;
+    for (const auto& r : ranges) {
+        if (r.start < r.end) {
+            spans.emplace_back(r.start, r.end - 1);
+        } else {
+            spans.emplace_back(r.start, UINT64_MAX);
+            if (r.end > 0) spans.emplace_back(0, r.end - 1);
+        }
+    }
+    std::sort(spans.begin(), spans.end());
+    auto in_ranges = [&spans](uint64_t pos) {
+        auto it = std::upper_bound(
+            spans.begin(), spans.end(), pos,
+            [](uint64_t p, const std::pair<uint64_t, uint64_t>& s) { return p < s.first; });
+        if (it == spans.begin()) return false;
+        --it;
+        return pos <= it->second;
+    };
+
+    {
+        const auto& s = shards_[shard];
+        std::shared_lock lock(s.mutex);
+        for (const auto& [k, v] : s.data) {
+            if (in_ranges(murmurhash3(k))) keys.push_back(k);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+std::vector<std::pair<std::string, ValueEntry>> StorageEngine::entries_for_keys(
+    size_t shard, const std::vector<std::string>& keys, size_t begin,
+    size_t max_bytes, size_t& next) const {
+    std::vector<std::pair<std::string, ValueEntry>> result;
+    next = keys.size();
+    if (shard >= NUM_SHARDS) return result;
+
+    const auto& s = shards_[shard];
+    std::shared_lock lock(s.mutex);
+    size_t bytes = 0;
+    for (size_t i = begin; i < keys.size(); i++) {
+        if (bytes >= max_bytes && !result.empty()) {
+            next = i;
+            break;
+        }
+        auto it = s.data.find(keys[i]);
+        if (it == s.data.end()) continue;
+        bytes += it->first.size() + it->second.value.size();
+        result.emplace_back(it->first, it->second);
+    }
+    return result;
+}
+
 }  // namespace dkv
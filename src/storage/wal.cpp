@@ -1,6 +1,8 @@
 #include "storage/wal.h"
 #include "utils/crc32.h"
+#include "utils/metrics.h"
 
+#include <chrono>
 #include <cstring>
 #include <filesystem>
 #include <iostream>
@@ -39,6 +41,27 @@ uint64_t read_u64(const uint8_t* p) {
     return v;
 }
 
+LatencyMetric& append_latency() {
+    static LatencyMetric& m = Metrics::instance().latency(
+        "dkv_wal_append_seconds", "WAL append latency, including lock wait and any inline fsync");
+    return m;
+}
+
+Counter& append_bytes() {
+    static Counter& c = Metrics::instance().counter(
+        "dkv_wal_append_bytes_total", "Bytes appended to the WAL");
+    return c;
+}
+
+/// fsync the WAL file, timing it.
+void timed_fsync(int fd) {
+    static LatencyMetric& m = Metrics::instance().latency(
+        "dkv_wal_fsync_seconds", "WAL fsync latency");
+    const auto start = std::chrono::steady_clock::now();
+    ::fsync(fd);
+    m.record_since(start);
+}
+
 }  // namespace
 
 // ── WAL public interface ─────────────────────────────────────────────────────
@@ -71,26 +94,30 @@ bool WAL::open(const std::string& directory,
 }
 
 uint64_t WAL::append(const WalRecord& record) {
+    const auto start = std::chrono::steady_clock::now();
     std::lock_guard lock(mutex_);
 
-    WalRecord rec = record;
-    rec.seq_no = next_seq_no_++;
+    // Serialize straight from the caller's record with the assigned sequence
+    // number, rather than copying the record (and its value) first.
+    uint64_t seq_no = next_seq_no_++;
 
-    auto buf = serialize(rec);
+    auto buf = serialize(record, seq_no);
     ::write(fd_, buf.data(), buf.size());
     dirty_ = true;
+    append_bytes().add(buf.size());
 
     // Check if we've hit the ops-based fsync threshold
     if (fsync_batch_ops_ > 0) {
         uint32_t ops = ++ops_since_sync_;
         if (ops >= fsync_batch_ops_) {
-            ::fsync(fd_);
+            timed_fsync(fd_);
             ops_since_sync_ = 0;
             dirty_ = false;
         }
     }
 
-    return rec.seq_no;
+    append_latency().record_since(start);
+    return seq_no;
 }
 
 std::vector<WalRecord> WAL::recover() {
@@ -140,7 +167,7 @@ std::vector<WalRecord> WAL::recover() {
 
 void WAL::sync() {
     if (fd_ >= 0) {
-        ::fsync(fd_);
+        timed_fsync(fd_);
     }
 }
 
@@ -244,7 +271,7 @@ void WAL::fsync_loop() {
         if (dirty_.exchange(false)) {
             std::lock_guard wal_lock(mutex_);
             if (fd_ >= 0) {
-                ::fsync(fd_);
+                timed_fsync(fd_);
                 ops_since_sync_ = 0;
             }
         }
@@ -254,29 +281,34 @@ void WAL::fsync_loop() {
 // ── Serialization ────────────────────────────────────────────────────────────
 
 std::vector<uint8_t> WAL::serialize(const WalRecord& record) {
+    return serialize(record, record.seq_no);
+}
+
+std::vector<uint8_t> WAL::serialize(const WalRecord& record, uint64_t seq_no) {
     // Layout: [CRC32 4B] [payload...]
     // Payload: [SeqNo 8B] [Timestamp 8B] [OpType 1B]
     //          [KeyLen 4B] [Key] [ValLen 4B] [Value]
+    //
+    // Built in a single exactly-sized buffer; the CRC slot is reserved up
+    // front and filled in once the payload is written.
 
-    std::vector<uint8_t> payload;
-    payload.reserve(64);
-
-    write_u64(payload, record.seq_no);
-    write_u64(payload, record.timestamp_ms);
-    payload.push_back(static_cast<uint8_t>(record.op_type));
-    write_u32(payload, static_cast<uint32_t>(record.key.size()));
-    payload.insert(payload.end(), record.key.begin(), record.key.end());
-    write_u32(payload, static_cast<uint32_t>(record.value.size()));
-    payload.insert(payload.end(), record.value.begin(), record.value.end());
-
-    // Compute CRC32 over the payload
-    uint32_t checksum = crc32(payload.data(), payload.size());
-
-    // Assemble final buffer: [CRC32] [payload]
     std::vector<uint8_t> buf;
-    buf.reserve(4 + payload.size());
-    write_u32(buf, checksum);
-    buf.insert(buf.end(), payload.begin(), payload.end());
+    buf.reserve(4 + 8 + 8 + 1 + 4 + record.key.size() + 4 + record.value.size());
+
+    write_u32(buf, 0);  // CRC32 placeholder
+    write_u64(buf, seq_no);
+    write_u64(buf, record.timestamp_ms);
+    buf.push_back(static_cast<uint8_t>(record.op_type));
+    write_u32(buf, static_cast<uint32_t>(record.key.size()));
+    buf.insert(buf.end(), record.key.begin(), record.key.end());
+    write_u32(buf, static_cast<uint32_t>(record.value.size()));
+    buf.insert(buf.end(), record.value.begin(), record.value.end());
+
+    // Compute CRC32 over the payload and patch it into the header
+    uint32_t checksum = crc32(buf.data() + 4, buf.size() - 4);
+    for (int i = 0; i < 4; i++) {
+        buf[static_cast<size_t>(i)] = static_cast<uint8_t>((checksum >> (i * 8)) & 0xFF);
+    }
 
     return buf;
 }
@@ -0,0 +1,215 @@
+#include "utils/histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace dkv {
+
+namespace {
+constexpr uint64_t NO_MIN = std::numeric_limits<uint64_t>::max();
+
+std::string format_scaled(uint64_t value, double scale) {
+    char buf[48];
+    if (scale == 1.0) {
+        std::snprintf(buf, sizeof(buf), "%" PRIu64, value);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.3f", static_cast<double>(value) / scale);
+    }
+    return buf;
+}
+}  // namespace
+
+Histogram::Histogram(uint64_t max_value, uint32_t precision_bits)
+    : bits_(std::clamp<uint32_t>(precision_bits, 1, 16)) {
+    max_value_ = std::max(max_value, uint64_t{1} << bits_);
+    buckets_   = index_of(max_value_) + 1;
+    counts_    = std::make_unique<std::atomic<uint64_t>[]>(buckets_);
+    for (size_t i = 0; i < buckets_; i++) counts_[i].store(0, std::memory_order_relaxed);
+    min_.store(NO_MIN, std::memory_order_relaxed);
+}
+
+Histogram::Histogram(const Histogram& other)
+    : max_value_(other.max_value_), bits_(other.bits_), buckets_(other.buckets_),
+      counts_(std::make_unique<std::atomic<uint64_t>[]>(other.buckets_)) {
+    copy_from(other);
+}
+
+Histogram& Histogram::operator=(const Histogram& other) {
+    if (this == &other) return *this;
+    if (buckets_ != other.buckets_) {
+        counts_ = std::make_unique<std::atomic<uint64_t>[]>(other.buckets_);
+    }
+    max_value_ = other.max_value_;
+    bits_      = other.bits_;
+    buckets_   = other.buckets_;
+    copy_from(other);
+    return *this;
+}
+
+void Histogram::copy_from(const Histogram& other) {
+    for (size_t i = 0; i < buckets_; i++) {
+        counts_[i].store(other.counts_[i].load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+    }
+    count_.store(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sum_.store(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    min_.store(other.min_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    max_.store(other.max_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+// ── Bucket layout ────────────────────────────────────────────────────────────
+//
+// Index i < 2^bits holds exactly the value i.  Above that, the power-of-two
+// range [2^e, 2^(e+1)) starts at index (e - bits + 1) << bits and is cut
+// into 2^bits buckets of width 2^(e - bits), addressed by the `bits` bits
+// after the leading one.
+
+size_t Histogram::index_of(uint64_t value) const {
+    value = std::min(value, max_value_);
+    if (value < (uint64_t{1} << bits_)) return static_cast<size_t>(value);
+    const uint32_t exp   = 63 - static_cast<uint32_t>(std::countl_zero(value));
+    const uint32_t shift = exp - bits_;
+    const uint64_t sub   = (value >> shift) & ((uint64_t{1} << bits_) - 1);
+    return static_cast<size_t>((uint64_t{shift + 1} << bits_) + sub);
+}
+
+uint64_t Histogram::lowest_of(size_t index) const {
+    if (index < (size_t{1} << bits_)) return index;
+    const uint32_t shift = static_cast<uint32_t>(index >> bits_) - 1;
+    const uint64_t sub   = index & ((size_t{1} << bits_) - 1);
+    return ((uint64_t{1} << bits_) | sub) << shift;
+}
+
+uint64_t Histogram::highest_of(size_t index) const {
+    if (index < (size_t{1} << bits_)) return index;
+    const uint32_t shift = static_cast<uint32_t>(index >> bits_) - 1;
+    return lowest_of(index) + ((uint64_t{1} << shift) - 1);
+}
+
+// ── Recording ────────────────────────────────────────────────────────────────
+
+void Histogram::record_n(uint64_t value, uint64_t n) {
+    if (n == 0) return;
+    counts_[index_of(value)].fetch_add(n, std::memory_order_relaxed);
+    count_.fetch_add(n, std::memory_order_relaxed);
+    sum_.fetch_add(value * n, std::memory_order_relaxed);
+
+    uint64_t cur = min_.load(std::memory_order_relaxed);
+    while (value < cur &&
+           !min_.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+    }
+    cur = max_.load(std::memory_order_relaxed);
+    while (value > cur &&
+           !max_.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::merge(const Histogram& other) {
+    if (other.count() == 0) return;
+    if (other.bits_ == bits_ && other.max_value_ == max_value_) {
+        for (size_t i = 0; i < buckets_; i++) {
+            uint64_t c = other.counts_[i].load(std::memory_order_relaxed);
+            if (c) counts_[i].fetch_add(c, std::memory_order_relaxed);
+        }
+    } else {
+        for (size_t i = 0; i < other.buckets_; i++) {
+            uint64_t c = other.counts_[i].load(std::memory_order_relaxed);
+            if (c) counts_[index_of(other.highest_of(i))].fetch_add(c, std::memory_order_relaxed);
+        }
+    }
+    count_.fetch_add(other.count(), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum(), std::memory_order_relaxed);
+
+    const uint64_t lo = other.min_.load(std::memory_order_relaxed);
+    uint64_t cur = min_.load(std::memory_order_relaxed);
+    while (lo < cur && !min_.compare_exchange_weak(cur, lo, std::memory_order_relaxed)) {
+    }
+    const uint64_t hi = other.max();
+    cur = max_.load(std::memory_order_relaxed);
+    while (hi > cur && !max_.compare_exchange_weak(cur, hi, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::reset() {
+    for (size_t i = 0; i < buckets_; i++) counts_[i].store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(NO_MIN, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+// ── Queries ──────────────────────────────────────────────────────────────────
+
+uint64_t Histogram::min() const {
+    uint64_t v = min_.load(std::memory_order_relaxed);
+    return v == NO_MIN ? 0 : v;
+}
+
+double Histogram::mean() const {
+    const uint64_t n = count();
+    return n ? static_cast<double>(sum()) / static_cast<double>(n) : 0.0;
+}
+
+uint64_t Histogram::percentile(double p) const {
+    const uint64_t n = count();
+    if (n == 0) return 0;
+    if (p <= 0) return min();
+    const double   frac   = std::min(p, 100.0) / 100.0;
+    const uint64_t target = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(frac * static_cast<double>(n))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_; i++) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= target) return i + 1 == buckets_ ? max() : std::min(highest_of(i), max());
+    }
+    return max();  // a concurrent record() bumped count_ before its bucket
+}
+
+void Histogram::for_each_bucket(
+    const std::function<void(uint64_t, uint64_t, uint64_t)>& fn) const {
+    for (size_t i = 0; i < buckets_; i++) {
+        uint64_t c = counts_[i].load(std::memory_order_relaxed);
+        if (!c) continue;
+        // The top bucket also holds everything above max_value.
+        fn(lowest_of(i), i + 1 == buckets_ ? std::max(highest_of(i), max()) : highest_of(i), c);
+    }
+}
+
+void Histogram::write_csv(std::ostream& os, double scale) const {
+    os << "value,percentile,count,total\n";
+    // Summed from the buckets, not count(), so the last row reads 100%.
+    uint64_t total = 0;
+    for_each_bucket([&](uint64_t, uint64_t, uint64_t c) { total += c; });
+    uint64_t seen = 0;
+    for_each_bucket([&](uint64_t, uint64_t highest, uint64_t c) {
+        seen += c;
+        char pct[32];
+        std::snprintf(pct, sizeof(pct), "%.6f",
+                      100.0 * static_cast<double>(seen) / static_cast<double>(total));
+        os << format_scaled(std::min(highest, max()), scale) << ',' << pct << ','
+           << c << ',' << seen << '\n';
+    });
+}
+
+std::string Histogram::to_json(double scale) const {
+    char mean_buf[48];
+    std::snprintf(mean_buf, sizeof(mean_buf), "%.3f", mean() / scale);
+    std::string out = "{\"count\":" + std::to_string(count()) +
+                      ",\"min\":" + format_scaled(min(), scale) +
+                      ",\"mean\":" + mean_buf;
+    const std::pair<const char*, double> points[] = {
+        {"p50", 50}, {"p90", 90}, {"p99", 99}, {"p99_9", 99.9}, {"p99_99", 99.99}};
+    for (const auto& [name, p] : points) {
+        out += ",\"";
+        out += name;
+        out += "\":" + format_scaled(percentile(p), scale);
+    }
+    out += ",\"max\":" + format_scaled(max(), scale) + "}";
+    return out;
+}
+
+}  // namespace dkv
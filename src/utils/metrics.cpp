@@ -0,0 +1,178 @@
+#include "utils/metrics.h"
+
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace dkv {
+
+namespace {
+// Latencies are recorded in ns; 2^36 ns is ~68 s.
+constexpr uint64_t LATENCY_MAX_NS         = uint64_t{1} << 36;
+constexpr uint32_t LATENCY_PRECISION_BITS = 5;
+
+std::atomic<size_t> g_next_shard{0};
+
+std::string format_number(double v) {
+    char buf[32];
+    if (std::isfinite(v) && v == std::floor(v) && std::fabs(v) < 1e15) {
+        std::snprintf(buf, sizeof(buf), "%.0f", v);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.9g", v);
+    }
+    return buf;
+}
+
+/// `name{labels}`, with `extra` (another label) appended to the set.
+std::string series(const std::string& name, const std::string& labels,
+                   std::string_view extra = {}) {
+    std::string out = name;
+    if (labels.empty() && extra.empty()) return out;
+    out += '{';
+    out += labels;
+    if (!labels.empty() && !extra.empty()) out += ',';
+    out += extra;
+    out += '}';
+    return out;
+}
+}  // namespace
+
+size_t metric_shard() {
+    thread_local const size_t shard =
+        g_next_shard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+// ── Counter / LatencyMetric ──────────────────────────────────────────────────
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& s : shards_) total += s.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+LatencyMetric::Shard::Shard() : hist(LATENCY_MAX_NS, LATENCY_PRECISION_BITS) {}
+
+LatencyMetric::LatencyMetric() : shards_(std::make_unique<Shard[]>(METRIC_SHARDS)) {}
+
+void LatencyMetric::record(std::chrono::nanoseconds elapsed) {
+    const auto ns = elapsed.count();
+    shards_[metric_shard()].hist.record(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+}
+
+Histogram LatencyMetric::snapshot() const {
+    Histogram out(LATENCY_MAX_NS, LATENCY_PRECISION_BITS);
+    for (size_t i = 0; i < METRIC_SHARDS; i++) out.merge(shards_[i].hist);
+    return out;
+}
+
+// ── Registry ─────────────────────────────────────────────────────────────────
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Entry& Metrics::entry_locked(std::string_view name, std::string_view help,
+                                      std::string_view labels, Kind kind) {
+    auto [it, inserted] = entries_.try_emplace(Key{std::string(name), std::string(labels)});
+    Entry& e = it->second;
+    if (inserted) {
+        e.kind = kind;
+        e.help = std::string(help);
+    } else if (e.kind != kind) {
+        throw std::logic_error("metric " + std::string(name) +
+                               " registered with two different types");
+    }
+    return e;
+}
+
+Counter& Metrics::counter(std::string_view name, std::string_view help,
+                          std::string_view labels) {
+    std::lock_guard lock(mutex_);
+    Entry& e = entry_locked(name, help, labels, Kind::COUNTER);
+    if (!e.counter) e.counter = std::make_unique<Counter>();
+    return *e.counter;
+}
+
+LatencyMetric& Metrics::latency(std::string_view name, std::string_view help,
+                                std::string_view labels) {
+    std::lock_guard lock(mutex_);
+    Entry& e = entry_locked(name, help, labels, Kind::LATENCY);
+    if (!e.latency) e.latency = std::make_unique<LatencyMetric>();
+    return *e.latency;
+}
+
+void Metrics::set_gauge(std::string_view name, std::string_view help,
+                        std::function<double()> sample, std::string_view labels) {
+    std::lock_guard lock(mutex_);
+    entry_locked(name, help, labels, Kind::GAUGE).gauge = std::move(sample);
+}
+
+void Metrics::remove_gauge(std::string_view name, std::string_view labels) {
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(Key{std::string(name), std::string(labels)});
+    if (it != entries_.end() && it->second.kind == Kind::GAUGE) entries_.erase(it);
+}
+
+void Metrics::set_counter_callback(std::string_view name, std::string_view help,
+                                   std::function<uint64_t()> sample,
+                                   std::string_view labels) {
+    std::lock_guard lock(mutex_);
+    entry_locked(name, help, labels, Kind::COUNTER_CALLBACK).counter_callback =
+        std::move(sample);
+}
+
+void Metrics::remove_counter_callback(std::string_view name, std::string_view labels) {
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(Key{std::string(name), std::string(labels)});
+    if (it != entries_.end() && it->second.kind == Kind::COUNTER_CALLBACK) entries_.erase(it);
+}
+
+std::string Metrics::render(bool help) const {
+    static constexpr std::pair<const char*, double> QUANTILES[] = {
+        {"quantile=\"0.5\"", 50},   {"quantile=\"0.9\"", 90},
+        {"quantile=\"0.99\"", 99},  {"quantile=\"0.999\"", 99.9},
+        {"quantile=\"1\"", 100}};
+
+    std::lock_guard lock(mutex_);
+    std::string out;
+    const std::string* last_name = nullptr;
+    for (const auto& [key, e] : entries_) {
+        const auto& [name, labels] = key;
+        if (help && (!last_name || *last_name != name)) {
+            const char* type = e.kind == Kind::GAUGE   ? "gauge"
+                             : e.kind == Kind::LATENCY ? "summary"
+                                                       : "counter";
+            out += "# HELP " + name + ' ' + e.help + '\n';
+            out += "# TYPE " + name + ' ' + type + '\n';
+        }
+        last_name = &name;
+
+        switch (e.kind) {
+            case Kind::COUNTER:
+                out += series(name, labels) + ' ' + std::to_string(e.counter->value()) + '\n';
+                break;
+            case Kind::COUNTER_CALLBACK:
+                out += series(name, labels) + ' ' + std::to_string(e.counter_callback()) + '\n';
+                break;
+            case Kind::GAUGE:
+                out += series(name, labels) + ' ' + format_number(e.gauge()) + '\n';
+                break;
+            case Kind::LATENCY: {
+                const Histogram h = e.latency->snapshot();
+                for (const auto& [quantile, p] : QUANTILES) {
+                    out += series(name, labels, quantile) + ' ' +
+                           format_number(static_cast<double>(h.percentile(p)) / 1e9) + '\n';
+                }
+                out += series(name + "_sum", labels) + ' ' +
+                       format_number(static_cast<double>(h.sum()) / 1e9) + '\n';
+                out += series(name + "_count", labels) + ' ' + std::to_string(h.count()) + '\n';
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+}  // namespace dkv
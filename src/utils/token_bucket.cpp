@@ -0,0 +1,40 @@
+#include "utils/token_bucket.h"
+
+#include <algorithm>
+
+namespace dkv {
+
+TokenBucket::TokenBucket(uint64_t rate_per_sec)
+    : rate_(rate_per_sec), tokens_(static_cast<double>(rate_per_sec)),
+      refilled_(Clock::now()) {}
+
+void TokenBucket::set_rate(uint64_t rate_per_sec) {
+    refill();
+    rate_   = rate_per_sec;
+    tokens_ = rate_ == 0 ? 0 : std::min(tokens_, static_cast<double>(rate_));
+}
+
+void TokenBucket::consume(size_t n) {
+    if (rate_ > 0) tokens_ -= static_cast<double>(n);
+}
+
+void TokenBucket::refill() {
+    const auto now = Clock::now();
+    if (rate_ > 0) {
+        const double rate = static_cast<double>(rate_);
+        tokens_ = std::min(rate, tokens_ + rate *
+            std::chrono::duration<double>(now - refilled_).count());
+    }
+    refilled_ = now;
+}
+
+TokenBucket::Clock::duration TokenBucket::time_to_refill() {
+    refill();
+    if (rate_ == 0 || tokens_ >= 0) return Clock::duration::zero();
+    const auto wait = std::chrono::duration<double>(-tokens_ / static_cast<double>(rate_));
+    // Round up so the wake-up never lands just short of the refill.
+    return std::max<Clock::duration>(
+        std::chrono::ceil<Clock::duration>(wait), Clock::duration(1));
+}
+
+}  // namespace dkv
@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 
+#include "network/metrics_http.h"
+#include "network/protocol.h"
 #include "network/tcp_server.h"
 #include "storage/storage_engine.h"
+#include "utils/metrics.h"
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -10,8 +13,10 @@
 
 #include <chrono>
 #include <cstring>
+#include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace {
 
@@ -19,9 +24,14 @@ namespace {
 
 class TestClient {
 public:
-    bool connect_to(uint16_t port) {
+    /// @param rcvbuf  If non-zero, shrink SO_RCVBUF so the kernel buffers
+    ///                little on the client side (simulates a slow reader).
+    bool connect_to(uint16_t port, int rcvbuf = 0) {
         fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
         if (fd_ < 0) return false;
+        if (rcvbuf > 0) {
+            setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        }
 
         struct sockaddr_in addr{};
         addr.sin_family      = AF_INET;
@@ -75,6 +85,32 @@ public:
         return result;
     }
 
+    /// Receive exactly `expected_count` binary response frames.
+    std::vector<std::string> recv_binary_frames(int expected_count,
+                                                int timeout_ms = 2000) {
+        struct timeval tv;
+        tv.tv_sec  = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        std::vector<std::string> frames;
+        std::string buf;
+        char chunk[4096];
+        while (static_cast<int>(frames.size()) < expected_count) {
+            auto r = dkv::try_parse_binary(buf.data(), buf.size());
+            if (r.status == dkv::ParseStatus::OK) {
+                frames.push_back(buf.substr(0, r.bytes_consumed));
+                buf.erase(0, r.bytes_consumed);
+                continue;
+            }
+            if (r.status == dkv::ParseStatus::ERROR) break;
+            ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+            if (n <= 0) break;
+            buf.append(chunk, static_cast<size_t>(n));
+        }
+        return frames;
+    }
+
     void close_conn() {
         if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
     }
@@ -105,6 +141,17 @@ protected:
         server_->stop();
         if (server_thread_.joinable()) server_thread_.join();
     }
+
+    /// Replace the default server with one using the given output limits.
+    void restart_with_limits(const dkv::TCPServer::OutputLimits& limits,
+                             uint16_t port) {
+        server_->stop();
+        if (server_thread_.joinable()) server_thread_.join();
+        server_ = std::make_unique<dkv::TCPServer>(engine_, port, 2);
+        server_->set_output_limits(limits);
+        server_thread_ = std::thread([this]() { server_->run(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
 };
 
 }  // namespace
@@ -166,6 +213,18 @@ TEST_F(TCPIntegrationTest, SetGetDel) {
     EXPECT_EQ(client.recv_responses(1), "-NOT_FOUND\n");
 }
 
+TEST_F(TCPIntegrationTest, MultiSetThenMultiGet) {
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(TEST_PORT));
+
+    ASSERT_TRUE(client.send_data("MSET 2 1 a 2 v1 1 b 2 v2\n"));
+    EXPECT_EQ(client.recv_responses(1), "+OK\n");
+
+    // Found, missing, found — in request order.
+    ASSERT_TRUE(client.send_data("MGET 3 1 b 1 x 1 a\n"));
+    EXPECT_EQ(client.recv_responses(1), "$14 3 2 v2 -1 2 v1\n");
+}
+
 TEST_F(TCPIntegrationTest, MalformedCommandReturnsError) {
     TestClient client;
     ASSERT_TRUE(client.connect_to(TEST_PORT));
@@ -291,3 +350,206 @@ TEST_F(TCPIntegrationTest, MultipleClients) {
     ASSERT_TRUE(c2.send_data("GET 9 sharedkey\n"));
     EXPECT_EQ(c2.recv_responses(1), "$6 value1\n");
 }
+
+// ── Binary protocol ───────────────────────────────────────────────────────────
+
+TEST_F(TCPIntegrationTest, BinarySetGetRoundTrip) {
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(TEST_PORT));
+
+    std::string req;
+    dkv::append_binary_frame(req, dkv::BinaryOpcode::SET, 100, {},
+                             "bkey", "line1\nline2");
+    ASSERT_TRUE(client.send_data(req));
+    auto set_resp = client.recv_binary_frames(1);
+    ASSERT_EQ(set_resp.size(), 1u);
+    auto s = dkv::try_parse_binary(set_resp[0].data(), set_resp[0].size());
+    EXPECT_EQ(s.frame.opcode, dkv::BinaryOpcode::OK);
+    EXPECT_EQ(s.frame.request_id, 100u);
+
+    req.clear();
+    dkv::append_binary_frame(req, dkv::BinaryOpcode::GET, 101, {}, "bkey");
+    ASSERT_TRUE(client.send_data(req));
+    auto get_resp = client.recv_binary_frames(1);
+    ASSERT_EQ(get_resp.size(), 1u);
+    auto g = dkv::try_parse_binary(get_resp[0].data(), get_resp[0].size());
+    EXPECT_EQ(g.frame.opcode, dkv::BinaryOpcode::VALUE);
+    EXPECT_EQ(g.frame.request_id, 101u);
+    EXPECT_EQ(g.frame.value, "line1\nline2");
+}
+
+TEST_F(TCPIntegrationTest, BinaryPipelinedRequestIdsEchoed) {
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(TEST_PORT));
+
+    std::string req;
+    for (uint32_t id = 1; id <= 20; ++id) {
+        dkv::append_binary_frame(req, dkv::BinaryOpcode::PING, id);
+    }
+    ASSERT_TRUE(client.send_data(req));
+
+    auto frames = client.recv_binary_frames(20);
+    ASSERT_EQ(frames.size(), 20u);
+
+    std::set<uint32_t> ids;
+    for (const auto& f : frames) {
+        auto r = dkv::try_parse_binary(f.data(), f.size());
+        EXPECT_EQ(r.frame.opcode, dkv::BinaryOpcode::PONG);
+        ids.insert(r.frame.request_id);
+    }
+    EXPECT_EQ(ids.size(), 20u);
+    EXPECT_EQ(*ids.begin(), 1u);
+    EXPECT_EQ(*ids.rbegin(), 20u);
+}
+
+TEST_F(TCPIntegrationTest, BinaryBadFrameClosesConnection) {
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(TEST_PORT));
+
+    // Valid magic, then an oversized key length: cannot resynchronise.
+    std::string req;
+    dkv::append_binary_frame(req, dkv::BinaryOpcode::GET, 5, {}, "k");
+    uint32_t huge = dkv::BINARY_MAX_KEY_LEN + 1;
+    std::memcpy(req.data() + 8, &huge, 4);
+    ASSERT_TRUE(client.send_data(req));
+
+    auto frames = client.recv_binary_frames(1);
+    ASSERT_EQ(frames.size(), 1u);
+    auto r = dkv::try_parse_binary(frames[0].data(), frames[0].size());
+    EXPECT_EQ(r.frame.opcode, dkv::BinaryOpcode::ERROR);
+
+    // The server hangs up afterwards.
+    EXPECT_EQ(client.recv_data(), "");
+}
+
+TEST_F(TCPIntegrationTest, TextClientUnaffectedByBinaryClient) {
+    TestClient bin, text;
+    ASSERT_TRUE(bin.connect_to(TEST_PORT));
+    ASSERT_TRUE(text.connect_to(TEST_PORT));
+
+    std::string req;
+    dkv::append_binary_frame(req, dkv::BinaryOpcode::SET, 1, {}, "mix", "ed");
+    ASSERT_TRUE(bin.send_data(req));
+    ASSERT_EQ(bin.recv_binary_frames(1).size(), 1u);
+
+    ASSERT_TRUE(text.send_data("GET 3 mix\n"));
+    EXPECT_EQ(text.recv_responses(1), "$2 ed\n");
+}
+
+// ── Backpressure ──────────────────────────────────────────────────────────────
+
+TEST_F(TCPIntegrationTest, SlowReaderIsPausedAndResumed) {
+    dkv::TCPServer::OutputLimits limits;
+    limits.high_water = 256 * 1024;
+    limits.low_water  = 64 * 1024;
+    const uint16_t port = TEST_PORT + 2;
+    restart_with_limits(limits, port);
+
+    const std::string value(64 * 1024, 'v');
+    engine_.set("big", value, {1, 1});
+
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(port, 4096));
+
+    // Keep requesting a large value without reading any of the replies.
+    constexpr int REQUESTS = 150;
+    for (int i = 0; i < REQUESTS; i++) {
+        ASSERT_TRUE(client.send_data("GET 3 big\n"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto paused = server_->output_stats();
+    EXPECT_EQ(paused.paused_connections, 1u);
+    EXPECT_GE(paused.pause_events, 1u);
+    // Bounded by the high-water mark plus the replies already in flight,
+    // not by the ~10 MB the client asked for.
+    EXPECT_LT(paused.output_bytes, 2u * 1024 * 1024);
+
+    // Once the client drains its replies, every request is answered.
+    std::string expected = "$" + std::to_string(value.size()) + " " + value + "\n";
+    std::string resp = client.recv_responses(REQUESTS, 5000);
+    EXPECT_EQ(resp.size(), expected.size() * REQUESTS);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto resumed = server_->output_stats();
+    EXPECT_EQ(resumed.paused_connections, 0u);
+    EXPECT_EQ(resumed.output_bytes, 0u);
+    EXPECT_EQ(resumed.slow_client_disconnects, 0u);
+}
+
+TEST_F(TCPIntegrationTest, ClientOverHardLimitIsDisconnected) {
+    dkv::TCPServer::OutputLimits limits;
+    limits.high_water = 0;  // no pausing: go straight to the hard cap
+    limits.hard_limit = 1024 * 1024;
+    const uint16_t port = TEST_PORT + 3;
+    restart_with_limits(limits, port);
+
+    engine_.set("big", std::string(64 * 1024, 'v'), {1, 1});
+
+    TestClient slow, other;
+    ASSERT_TRUE(slow.connect_to(port, 4096));
+    ASSERT_TRUE(other.connect_to(port));
+
+    std::string pipeline;
+    for (int i = 0; i < 200; i++) pipeline += "GET 3 big\n";
+    ASSERT_TRUE(slow.send_data(pipeline));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    auto stats = server_->output_stats();
+    EXPECT_EQ(stats.slow_client_disconnects, 1u);
+    EXPECT_EQ(stats.output_bytes, 0u);
+
+    // Other clients are unaffected.
+    ASSERT_TRUE(other.send_data("PING\n"));
+    EXPECT_EQ(other.recv_responses(1), "+PONG\n");
+}
+
+TEST_F(TCPIntegrationTest, StatsReportsCommandMetrics) {
+    TestClient client;
+    ASSERT_TRUE(client.connect_to(TEST_PORT));
+
+    ASSERT_TRUE(client.send_data("SET 1 a 1 b\nGET 1 a\nGET 2 zz\n"));
+    ASSERT_EQ(client.recv_responses(3), "+OK\n$1 b\n-NOT_FOUND\n");
+
+    // One multi-line payload: read until the reply's declared length arrives.
+    ASSERT_TRUE(client.send_data("STATS\n"));
+    std::string resp = client.recv_responses(1);
+    ASSERT_EQ(resp.rfind("$", 0), 0u) << resp;
+    const size_t len = std::stoul(resp.substr(1));
+    const size_t body = resp.find(' ') + 1;
+    while (resp.size() < body + len + 1) {
+        std::string more = client.recv_data(body + len + 1 - resp.size(), 500);
+        if (more.empty()) break;
+        resp += more;
+    }
+    EXPECT_NE(resp.find("dkv_commands_total{cmd=\"GET\"} "), std::string::npos) << resp;
+    EXPECT_NE(resp.find("dkv_command_duration_seconds{cmd=\"SET\",quantile=\"0.99\"} "),
+              std::string::npos);
+    EXPECT_NE(resp.find("dkv_connections_accepted_total "), std::string::npos);
+}
+
+TEST(MetricsHttp, ServesMetricsAndRejectsOtherPaths) {
+    dkv::Metrics::instance().counter("test_http_scrapes_total", "test").add(7);
+    dkv::MetricsHttpServer http(0);
+    ASSERT_TRUE(http.start());
+    ASSERT_NE(http.port(), 0);
+
+    TestClient scrape;
+    ASSERT_TRUE(scrape.connect_to(http.port()));
+    ASSERT_TRUE(scrape.send_data("GET /metrics?x=1 HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+    std::string resp = scrape.recv_data(1 << 20);
+    EXPECT_EQ(resp.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << resp;
+    EXPECT_NE(resp.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+    EXPECT_NE(resp.find("# TYPE test_http_scrapes_total counter\n"
+                        "test_http_scrapes_total 7\n"),
+              std::string::npos)
+        << resp;
+
+    TestClient other;
+    ASSERT_TRUE(other.connect_to(http.port()));
+    ASSERT_TRUE(other.send_data("GET / HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(other.recv_data().rfind("HTTP/1.1 404", 0), 0u);
+
+    http.stop();
+}
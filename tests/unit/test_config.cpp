@@ -52,6 +52,181 @@ TEST(Config, ParseMultipleFlags) {
     EXPECT_EQ(cfg.write_quorum, 1u);
 }
 
+TEST(Config, ParseOutputLimits) {
+    char prog[] = "dkv_node";
+    char f1[]   = "--output-high-water";
+    char v1[]   = "65536";
+    char f2[]   = "--output-hard-limit";
+    char v2[]   = "0";
+    char* argv[] = {prog, f1, v1, f2, v2};
+    auto cfg = dkv::parse_args(5, argv);
+
+    EXPECT_EQ(cfg.output_high_water, 65536u);
+    EXPECT_EQ(cfg.output_hard_limit, 0u);
+    EXPECT_EQ(cfg.output_low_water, 256u * 1024);  // default kept
+}
+
+TEST(Config, ParseReplicationBatching) {
+    char prog[] = "dkv_node";
+    char f1[]   = "--replication-batch-bytes";
+    char v1[]   = "0";
+    char f2[]   = "--replication-batch-linger-us";
+    char v2[]   = "250";
+    char* argv[] = {prog, f1, v1, f2, v2};
+    auto cfg = dkv::parse_args(5, argv);
+
+    EXPECT_EQ(cfg.replication_batch_bytes, 0u);
+    EXPECT_EQ(cfg.replication_batch_linger_us, 250u);
+}
+
+TEST(Config, ParseQuorumReadOptions) {
+    char prog[] = "dkv_node";
+    char f1[]   = "--hedged-reads";
+    char v1[]   = "1";
+    char f2[]   = "--hedge-min-delay-us";
+    char v2[]   = "500";
+    char f3[]   = "--digest-reads";
+    char v3[]   = "0";
+    char f4[]   = "--dynamic-snitch";
+    char v4[]   = "0";
+    char* argv[] = {prog, f1, v1, f2, v2, f3, v3, f4, v4};
+    auto cfg = dkv::parse_args(9, argv);
+
+    EXPECT_TRUE(cfg.hedged_reads);
+    EXPECT_FALSE(cfg.digest_reads);
+    EXPECT_EQ(cfg.hedge_min_delay_us, 500u);
+    EXPECT_FALSE(cfg.dynamic_snitch);
+}
+
+TEST(Config, ParseHotKeyCache) {
+    char prog[] = "dkv_node";
+    char f1[]   = "--hot-cache-keys";
+    char v1[]   = "256";
+    char f2[]   = "--hot-cache-lease-ms";
+    char v2[]   = "20";
+    char* argv[] = {prog, f1, v1, f2, v2};
+    auto cfg = dkv::parse_args(5, argv);
+
+    EXPECT_EQ(cfg.hot_cache_keys, 256u);
+    EXPECT_EQ(cfg.hot_cache_lease_ms, 20u);
+    EXPECT_EQ(dkv::Config{}.hot_cache_keys, 0u);  // detect only by default
+}
+
+TEST(Config, ParseMetricsPort) {
+    char prog[] = "dkv_node";
+    char flag[] = "--metrics-port";
+    char val[]  = "9100";
+    char* argv[] = {prog, flag, val};
+    auto cfg = dkv::parse_args(3, argv);
+
+    EXPECT_EQ(cfg.metrics_port, 9100);
+    EXPECT_EQ(dkv::Config{}.metrics_port, 0);  // off by default
+}
+
+TEST(Config, ParseReadRepairLimits) {
+    char prog[] = "dkv_node";
+    char f1[]   = "--repair-queue-bytes";
+    char v1[]   = "1024";
+    char f2[]   = "--repair-rate-bytes";
+    char v2[]   = "0";
+    char f3[]   = "--repair-batch";
+    char v3[]   = "8";
+    char* argv[] = {prog, f1, v1, f2, v2, f3, v3};
+    auto cfg = dkv::parse_args(7, argv);
+
+    EXPECT_EQ(cfg.repair_queue_bytes, 1024u);
+    EXPECT_EQ(cfg.repair_rate_bytes, 0u);
+    EXPECT_EQ(cfg.repair_batch, 8u);
+}
+
+TEST(Config, ParseAntiEntropyOptions) {
+    char prog[] = "dkv_node";
+    char f1[]   = "--anti-entropy-interval-ms";
+    char v1[]   = "0";
+    char f2[]   = "--anti-entropy-rate-bytes";
+    char v2[]   = "65536";
+    char f3[]   = "--anti-entropy-max-leaves";
+    char v3[]   = "32";
+    char* argv[] = {prog, f1, v1, f2, v2, f3, v3};
+    auto cfg = dkv::parse_args(7, argv);
+
+    EXPECT_EQ(cfg.anti_entropy_interval_ms, 0u);
+    EXPECT_EQ(cfg.anti_entropy_rate_bytes, 65536u);
+    EXPECT_EQ(cfg.anti_entropy_max_leaves, 32u);
+}
+
+TEST(Config, ParseHintLimits) {
+    char prog[] = "dkv_node";
+    char f1[]   = "--hint-max-bytes";
+    char v1[]   = "1048576";
+    char f2[]   = "--hint-max-age-ms";
+    char v2[]   = "60000";
+    char f3[]   = "--hint-sync-interval-ms";
+    char v3[]   = "0";
+    char* argv[] = {prog, f1, v1, f2, v2, f3, v3};
+    auto cfg = dkv::parse_args(7, argv);
+
+    EXPECT_EQ(cfg.hint_max_bytes, 1048576u);
+    EXPECT_EQ(cfg.hint_max_age_ms, 60000u);
+    EXPECT_EQ(cfg.hint_sync_interval_ms, 0u);
+}
+
+TEST(Config, ParseRebalancing) {
+    char prog[] = "dkv_node";
+    char f1[]   = "--join";
+    char v1[]   = "10.0.0.1:7001";
+    char f2[]   = "--advertise-address";
+    char v2[]   = "10.0.0.4:7004";
+    char f3[]   = "--rebalance-rate-bytes";
+    char v3[]   = "0";
+    char f4[]   = "--rebalance-chunk-bytes";
+    char v4[]   = "65536";
+    char* argv[] = {prog, f1, v1, f2, v2, f3, v3, f4, v4};
+    auto cfg = dkv::parse_args(9, argv);
+
+    EXPECT_EQ(cfg.join, "10.0.0.1:7001");
+    EXPECT_EQ(cfg.advertise_address, "10.0.0.4:7004");
+    EXPECT_EQ(cfg.rebalance_rate_bytes, 0u);
+    EXPECT_EQ(cfg.rebalance_chunk_bytes, 65536u);
+}
+
+TEST(Config, ParseFailureDetector) {
+    char prog[] = "dkv_node";
+    char f1[]   = "--phi-suspect-threshold";
+    char v1[]   = "3.5";
+    char f2[]   = "--phi-convict-threshold";
+    char v2[]   = "0";
+    char f3[]   = "--phi-acceptable-pause-ms";
+    char v3[]   = "2500";
+    char* argv[] = {prog, f1, v1, f2, v2, f3, v3};
+    auto cfg = dkv::parse_args(7, argv);
+
+    EXPECT_DOUBLE_EQ(cfg.phi_suspect_threshold, 3.5);
+    EXPECT_DOUBLE_EQ(cfg.phi_convict_threshold, 0.0);
+    EXPECT_EQ(cfg.phi_acceptable_pause_ms, 2500u);
+}
+
+TEST(Config, ParseGossip) {
+    char prog[] = "dkv_node";
+    char* defaults_argv[] = {prog};
+    auto defaults = dkv::parse_args(1, defaults_argv);
+    EXPECT_TRUE(defaults.gossip);
+    EXPECT_EQ(defaults.gossip_indirect_probes, 3u);
+
+    char f1[]   = "--gossip";
+    char v1[]   = "0";
+    char f2[]   = "--gossip-indirect-probes";
+    char v2[]   = "5";
+    char f3[]   = "--gossip-suspicion-mult";
+    char v3[]   = "6";
+    char* argv[] = {prog, f1, v1, f2, v2, f3, v3};
+    auto cfg = dkv::parse_args(7, argv);
+
+    EXPECT_FALSE(cfg.gossip);
+    EXPECT_EQ(cfg.gossip_indirect_probes, 5u);
+    EXPECT_EQ(cfg.gossip_suspicion_mult, 6u);
+}
+
 TEST(Config, QuorumInvariant) {
     // W + R > N should hold with defaults (2 + 2 > 3)
     char prog[] = "dkv_node";
@@ -37,6 +37,79 @@ TEST_F(CoordinatorTest, PingAlwaysLocal) {
     EXPECT_EQ(resp, "+PONG\n");
 }
 
+TEST_F(CoordinatorTest, TopologyDescribesRing) {
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE);
+    dkv::Command cmd{};
+    cmd.type = dkv::CommandType::TOPOLOGY;
+
+    std::string resp = coord.handle_command(cmd);
+    std::string expected = dkv::format_value(ring_.encode_topology(1));
+    EXPECT_EQ(resp, expected);
+    EXPECT_EQ(resp.rfind("$", 0), 0u);
+}
+
+// A hot key is served from the coordinator's cache; writes through this
+// node invalidate it, and HOTKEYS reports it.
+TEST_F(CoordinatorTest, HotKeyReadsServedFromCache) {
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE);
+    coord.set_hot_key_cache(16, 60000);
+
+    dkv::Command set_cmd{};
+    set_cmd.type  = dkv::CommandType::SET;
+    set_cmd.key   = "hot";
+    set_cmd.value = "v1";
+    ASSERT_EQ(coord.handle_command(set_cmd), "+OK\n");
+
+    dkv::Command get_cmd{};
+    get_cmd.type = dkv::CommandType::GET;
+    get_cmd.key  = "hot";
+    for (int i = 0; i < 64; ++i) ASSERT_EQ(coord.handle_command(get_cmd), "$2 v1\n");
+    EXPECT_GT(coord.hot_keys().stats().hits, 0u);
+
+    // A write that bypasses this coordinator is hidden until the lease ends...
+    engine_.set("hot", "behind", dkv::Version{1, 9});
+    EXPECT_EQ(coord.handle_command(get_cmd), "$2 v1\n");
+
+    // ...one through it is seen at once.
+    set_cmd.value = "v2";
+    ASSERT_EQ(coord.handle_command(set_cmd), "+OK\n");
+    EXPECT_EQ(coord.handle_command(get_cmd), "$2 v2\n");
+    EXPECT_GE(coord.hot_keys().stats().invalidations, 1u);
+
+    dkv::Command report{};
+    report.type = dkv::CommandType::HOTKEYS;
+    std::string resp = coord.handle_command(report);
+    ASSERT_EQ(resp.rfind("$", 0), 0u);
+    dkv::HotKeyCache::Stats stats;
+    std::vector<dkv::HotKeyCache::HotKey> keys;
+    ASSERT_TRUE(dkv::HotKeyCache::decode_report(
+        std::string_view(resp).substr(resp.find(' ') + 1, resp.size() - resp.find(' ') - 2),
+        stats, keys));
+    ASSERT_FALSE(keys.empty());
+    EXPECT_EQ(keys[0].key, "hot");
+    EXPECT_TRUE(keys[0].cached);
+}
+
+// STATS answers locally with the metrics registry, which the quorum paths
+// record into.
+TEST_F(CoordinatorTest, StatsReportsQuorumLatency) {
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE);
+
+    dkv::Command set_cmd{};
+    set_cmd.type  = dkv::CommandType::SET;
+    set_cmd.key   = "k";
+    set_cmd.value = "v";
+    ASSERT_EQ(coord.handle_command(set_cmd), "+OK\n");
+
+    dkv::Command stats{};
+    stats.type = dkv::CommandType::STATS;
+    std::string resp = coord.handle_command(stats);
+    ASSERT_EQ(resp.rfind("$", 0), 0u);
+    EXPECT_NE(resp.find("dkv_quorum_write_seconds_count "), std::string::npos) << resp;
+    EXPECT_NE(resp.find("dkv_quorum_write_seconds{quantile=\"0.99\"} "), std::string::npos);
+    EXPECT_EQ(resp.find("# TYPE"), std::string::npos);  // no HELP/TYPE lines
+}
+
 // ── SET/GET/DEL to local node ────────────────────────────────────────────────
 
 TEST_F(CoordinatorTest, SetAndGetLocal) {
@@ -257,6 +330,19 @@ TEST_F(CoordinatorTest, RgetReturnsVersionedResponse) {
     EXPECT_EQ(coord.handle_command(rget), "$V 4 vval 42000 7\n");
 }
 
+TEST_F(CoordinatorTest, RdigestReturnsVersionOnly) {
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE);
+    engine_.set("dkey", "a fairly long value", dkv::Version{42000, 7});
+
+    dkv::Command rdigest{};
+    rdigest.type = dkv::CommandType::RDIGEST;
+    rdigest.key  = "dkey";
+    EXPECT_EQ(coord.handle_command(rdigest), "$V 0  42000 7\n");
+
+    rdigest.key = "missing";
+    EXPECT_EQ(coord.handle_command(rdigest), "-NOT_FOUND\n");
+}
+
 TEST_F(CoordinatorTest, RgetNotFound) {
     dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE);
 
@@ -437,7 +523,7 @@ TEST_F(CoordinatorTest, QuorumPoolConcurrentWrites) {
 
 TEST_F(CoordinatorTest, QuorumPoolCleanShutdown) {
     // Submit a burst of writes then immediately destroy the coordinator —
-    // the destructor must call quorum_pool_.reset() before returning.
+    // the destructor must stop the RPC client and join the repair worker.
     {
         dkv::StorageEngine local_engine;
         dkv::HashRing local_ring;
@@ -454,11 +540,150 @@ TEST_F(CoordinatorTest, QuorumPoolCleanShutdown) {
             sc.value = "v";
             coord.handle_command(sc);
         }
-        // ~Coordinator(): quorum_pool_.reset() + repair_thread_.join()
+        // ~Coordinator(): rpc_->stop() + repair_thread_.join()
     }
     SUCCEED();
 }
 
+// ── RBATCH: every inner write is applied and acked under its own id ─────────
+
+TEST_F(CoordinatorTest, ReplicationBatchAppliesEachWrite) {
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE);
+
+    std::string payload;
+    dkv::append_binary_frame(payload, dkv::BinaryOpcode::RSET, 0,
+                             dkv::encode_version_extras(500, 3), "a", "1");
+    dkv::append_binary_frame(payload, dkv::BinaryOpcode::RDEL, 1,
+                             dkv::encode_version_extras(600, 3), "gone");
+    dkv::append_binary_frame(payload, dkv::BinaryOpcode::GET, 2, {}, "a");
+
+    dkv::Command cmd{};
+    cmd.type  = dkv::CommandType::RBATCH;
+    cmd.value = payload;
+    std::string resp = coord.handle_command(cmd);
+
+    // "$<len> <acks>\n": one response frame per inner write.
+    size_t sp = resp.find(' ');
+    ASSERT_NE(sp, std::string::npos);
+    std::string acks = resp.substr(sp + 1, resp.size() - sp - 2);
+
+    std::vector<std::pair<uint32_t, dkv::BinaryOpcode>> got;
+    size_t off = 0;
+    while (off < acks.size()) {
+        auto r = dkv::try_parse_binary(acks.data() + off, acks.size() - off);
+        ASSERT_EQ(r.status, dkv::ParseStatus::OK);
+        got.emplace_back(r.frame.request_id, r.frame.opcode);
+        off += r.bytes_consumed;
+    }
+    ASSERT_EQ(got.size(), 3u);
+    EXPECT_EQ(got[0], std::make_pair(0u, dkv::BinaryOpcode::OK));
+    EXPECT_EQ(got[1], std::make_pair(1u, dkv::BinaryOpcode::OK));
+    EXPECT_EQ(got[2], std::make_pair(2u, dkv::BinaryOpcode::ERROR));
+
+    auto a = engine_.get("a");
+    ASSERT_TRUE(a.found);
+    EXPECT_EQ(a.value, "1");
+    EXPECT_EQ(a.version.timestamp_ms, 500u);
+}
+
+// Binary replication requests are answered with frames built directly.
+TEST_F(CoordinatorTest, BinaryReplicationRequestsAnswerWithFrames) {
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE);
+    engine_.set("k", "value", dkv::Version{700, 2});
+
+    dkv::Command get{};
+    get.type = dkv::CommandType::RGET;
+    get.key  = "k";
+    std::string out;
+    ASSERT_TRUE(coord.execute_binary(get, 41, dkv::BINARY_FLAG_BUSY, out));
+    auto r = dkv::try_parse_binary(out.data(), out.size());
+    ASSERT_EQ(r.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(r.bytes_consumed, out.size());
+    EXPECT_EQ(r.frame.opcode, dkv::BinaryOpcode::VALUE);
+    EXPECT_EQ(r.frame.request_id, 41u);
+    EXPECT_EQ(r.frame.flags, dkv::BINARY_FLAG_BUSY);
+    EXPECT_EQ(r.frame.value, "value");
+    uint64_t ts = 0;
+    uint32_t node = 0;
+    ASSERT_TRUE(dkv::decode_version_extras(r.frame.extras, ts, node));
+    EXPECT_EQ(ts, 700u);
+    EXPECT_EQ(node, 2u);
+
+    // An RBATCH reply is one VALUE frame wrapping the inner responses.
+    std::string payload;
+    dkv::append_binary_frame(payload, dkv::BinaryOpcode::RGET, 5, {}, "k");
+    dkv::append_binary_frame(payload, dkv::BinaryOpcode::RGET, 6, {}, "missing");
+    dkv::Command batch{};
+    batch.type  = dkv::CommandType::RBATCH;
+    batch.value = payload;
+    out.clear();
+    ASSERT_TRUE(coord.execute_binary(batch, 42, 0, out));
+    r = dkv::try_parse_binary(out.data(), out.size());
+    ASSERT_EQ(r.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(r.bytes_consumed, out.size());
+    EXPECT_EQ(r.frame.opcode, dkv::BinaryOpcode::VALUE);
+    EXPECT_EQ(r.frame.request_id, 42u);
+    auto first = dkv::try_parse_binary(r.frame.value.data(), r.frame.value.size());
+    ASSERT_EQ(first.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(first.frame.request_id, 5u);
+    EXPECT_EQ(first.frame.value, "value");
+    auto second = dkv::try_parse_binary(r.frame.value.data() + first.bytes_consumed,
+                                        r.frame.value.size() - first.bytes_consumed);
+    ASSERT_EQ(second.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(second.frame.request_id, 6u);
+    EXPECT_EQ(second.frame.opcode, dkv::BinaryOpcode::NOT_FOUND);
+
+    // Client commands still go through handle_command_async().
+    dkv::Command client{};
+    client.type = dkv::CommandType::GET;
+    client.key  = "k";
+    out.clear();
+    EXPECT_FALSE(coord.execute_binary(client, 43, 0, out));
+    EXPECT_TRUE(out.empty());
+}
+
+// An RBATCH reply never outgrows a frame: responses past the budget become
+// REPLY_TOO_LARGE errors for the caller to ask again.
+TEST_F(CoordinatorTest, ReplicationBatchReplyFitsInOneFrame) {
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE);
+    const std::string big(8 << 20, 'v');
+    std::string payload;
+    for (uint32_t i = 0; i < 10; i++) {
+        engine_.set("big" + std::to_string(i), big, dkv::Version{1, 1});
+        dkv::append_binary_frame(payload, dkv::BinaryOpcode::RGET, i, {},
+                                 "big" + std::to_string(i));
+    }
+
+    dkv::Command batch{};
+    batch.type  = dkv::CommandType::RBATCH;
+    batch.value = payload;
+    std::string out;
+    ASSERT_TRUE(coord.execute_binary(batch, 1, 0, out));
+    auto r = dkv::try_parse_binary(out.data(), out.size());
+    ASSERT_EQ(r.status, dkv::ParseStatus::OK);
+    ASSERT_LE(r.frame.value.size(), dkv::BINARY_MAX_VAL_LEN);
+
+    size_t off = 0, values = 0, errors = 0;
+    uint32_t next_id = 0;
+    while (off < r.frame.value.size()) {
+        auto inner = dkv::try_parse_binary(r.frame.value.data() + off,
+                                           r.frame.value.size() - off);
+        ASSERT_EQ(inner.status, dkv::ParseStatus::OK);
+        EXPECT_EQ(inner.frame.request_id, next_id++);
+        if (inner.frame.opcode == dkv::BinaryOpcode::VALUE) {
+            EXPECT_EQ(errors, 0u);  // values first, then the overflow
+            values++;
+        } else {
+            EXPECT_EQ(inner.frame.opcode, dkv::BinaryOpcode::ERROR);
+            EXPECT_EQ(inner.frame.value, "REPLY_TOO_LARGE");
+            errors++;
+        }
+        off += inner.bytes_consumed;
+    }
+    EXPECT_EQ(values, 7u);
+    EXPECT_EQ(errors, 3u);
+}
+
 // ── Phase 6: Membership-aware quorum ─────────────────────────────────────────
 
 // Helper: drive a peer to DOWN in a Membership object.
@@ -495,6 +720,50 @@ TEST_F(CoordinatorTest, DownReplicaSkippedInWrite) {
     EXPECT_EQ(coord.handle_command(set_cmd), "+OK\n");
 }
 
+// MSET/MGET with N=2, W=1, R=1 and node 2 DOWN: every key is written and
+// read through this node, whichever node is its primary.
+TEST_F(CoordinatorTest, MultiKeyCommandsPassOverDownReplica) {
+    ring_.add_node(2, "127.0.0.1:9999", 128);
+
+    dkv::Membership membership(1, 10);
+    membership.add_peer(2, "127.0.0.1:9999");
+    drive_to_down(membership, 2);
+    ASSERT_EQ(membership.get_state(2), dkv::NodeState::DOWN);
+
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE,
+                           nullptr, "", 100000, 2, 1, 1);
+    coord.set_membership(&membership);
+
+    std::vector<std::string> keys, values;
+    for (int i = 0; i < 20; ++i) {
+        keys.push_back("mkey" + std::to_string(i));
+        values.push_back("v" + std::to_string(i));
+    }
+    dkv::Command mset{};
+    mset.type  = dkv::CommandType::MSET;
+    mset.value = dkv::format_multi_args(keys, values);
+    ASSERT_EQ(coord.handle_command(mset), "+OK\n");
+    EXPECT_EQ(coord.hint_stats().stored, 20u);  // one hint per key for node 2
+
+    keys.push_back("absent");
+    dkv::Command mget{};
+    mget.type  = dkv::CommandType::MGET;
+    mget.value = dkv::format_multi_args(keys);
+    std::string resp = coord.handle_command(mget);
+    ASSERT_EQ(resp.rfind("$", 0), 0u);
+
+    std::vector<dkv::MultiGetItem> items;
+    ASSERT_TRUE(dkv::parse_multi_get(
+        std::string_view(resp).substr(resp.find(' ') + 1, resp.size() - resp.find(' ') - 2),
+        items));
+    ASSERT_EQ(items.size(), 21u);
+    for (size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(items[i].status, dkv::MultiGetItem::Status::FOUND) << keys[i];
+        EXPECT_EQ(items[i].value, values[i]);
+    }
+    EXPECT_EQ(items[20].status, dkv::MultiGetItem::Status::NOT_FOUND);
+}
+
 // With R=1, a GET whose primary replica is DOWN returns QUORUM_FAILED
 // immediately (replica skipped without a TCP attempt).
 TEST_F(CoordinatorTest, DownReplicaSkippedInRead) {
@@ -508,6 +777,7 @@ TEST_F(CoordinatorTest, DownReplicaSkippedInRead) {
     dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE,
                            nullptr, "", 100000, 2, 1, 1);
     coord.set_membership(&membership);
+    coord.set_dynamic_snitch(false);  // keep the ring order
 
     // Find a key whose primary replica (R=1) is the DOWN node 2.
     std::string down_key;
@@ -529,6 +799,75 @@ TEST_F(CoordinatorTest, DownReplicaSkippedInRead) {
     EXPECT_EQ(coord.handle_command(get_cmd), "-ERR QUORUM_FAILED\n");
 }
 
+// A SUSPECTED (not yet DOWN) primary is asked last: with R=1 the read is
+// served by the healthy replica instead of waiting on the suspect one.
+TEST_F(CoordinatorTest, SuspectReplicaDeprioritisedInRead) {
+    ring_.add_node(2, "127.0.0.1:9999", 128);
+
+    dkv::Membership membership(1, 60000);
+    membership.add_peer(2, "127.0.0.1:9999");
+    membership.record_failure(2);
+    ASSERT_EQ(membership.get_state(2), dkv::NodeState::SUSPECTED);
+    ASSERT_TRUE(membership.is_suspect(2));
+
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE,
+                           nullptr, "", 100000, 2, 1, 1);
+    coord.set_membership(&membership);
+    coord.set_dynamic_snitch(false);  // keep the ring order
+
+    std::string key;
+    for (int i = 0; i < 2000; ++i) {
+        std::string candidate = "skey" + std::to_string(i);
+        auto replicas = ring_.get_replica_nodes(candidate, 1);
+        if (!replicas.empty() && replicas[0].node_id == 2) {
+            key = candidate;
+            break;
+        }
+    }
+    ASSERT_FALSE(key.empty()) << "Could not find a key owned by node 2";
+    engine_.set(key, "local", dkv::Version{1, THIS_NODE});
+
+    dkv::Command get_cmd{};
+    get_cmd.type = dkv::CommandType::GET;
+    get_cmd.key  = key;
+    // Node 2 would refuse the connection: only the local replica can answer.
+    EXPECT_EQ(coord.handle_command(get_cmd), "$5 local\n");
+
+    // Back to healthy: node 2 is the first choice again.
+    membership.record_success(2);
+    EXPECT_EQ(coord.handle_command(get_cmd), "-ERR QUORUM_FAILED\n");
+}
+
+// With the dynamic snitch on, R=1 reads are served by this node (no hop)
+// even where the ring lists the unreachable node 2 first.
+TEST_F(CoordinatorTest, DynamicSnitchPrefersLocalReplica) {
+    ring_.add_node(2, "127.0.0.1:9999", 128);
+
+    dkv::Coordinator coord(engine_, ring_, pool_, THIS_NODE,
+                           nullptr, "", 100000, 2, 1, 1);
+
+    std::string key;
+    for (int i = 0; i < 2000; ++i) {
+        std::string candidate = "dkey" + std::to_string(i);
+        auto replicas = ring_.get_replica_nodes(candidate, 1);
+        if (!replicas.empty() && replicas[0].node_id == 2) {
+            key = candidate;
+            break;
+        }
+    }
+    ASSERT_FALSE(key.empty()) << "Could not find a key owned by node 2";
+    engine_.set(key, "local", dkv::Version{1, THIS_NODE});
+
+    dkv::Command get_cmd{};
+    get_cmd.type = dkv::CommandType::GET;
+    get_cmd.key  = key;
+    EXPECT_EQ(coord.handle_command(get_cmd), "$5 local\n");
+    EXPECT_EQ(coord.snitch().stats().reorders, 1u);
+
+    coord.set_dynamic_snitch(false);
+    EXPECT_EQ(coord.handle_command(get_cmd), "-ERR QUORUM_FAILED\n");
+}
+
 // After a DOWN node recovers (record_success), writes attempt it again.
 TEST_F(CoordinatorTest, RecoveredReplicaParticipatesAgain) {
     ring_.add_node(2, "127.0.0.1:9999", 128);
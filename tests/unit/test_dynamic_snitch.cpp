@@ -0,0 +1,143 @@
+#include "cluster/dynamic_snitch.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace dkv;
+
+// ---------------------------------------------------------------------------
+// DynamicSnitch: latency-aware replica ranking
+// ---------------------------------------------------------------------------
+
+namespace {
+
+std::vector<NodeInfo> nodes(std::initializer_list<uint32_t> ids) {
+    std::vector<NodeInfo> out;
+    for (uint32_t id : ids) out.push_back(NodeInfo{id, "127.0.0.1:" + std::to_string(7000 + id)});
+    return out;
+}
+
+void sample(DynamicSnitch& s, uint32_t node, int64_t us, int times = 1, bool busy = false) {
+    for (int i = 0; i < times; i++) {
+        s.begin(node);
+        s.end(node, std::chrono::microseconds(us), true, busy);
+    }
+}
+
+std::vector<uint32_t> ids(dkv::ReplicaList ranked) {
+    std::vector<uint32_t> out;
+    for (const auto& n : ranked) out.push_back(n.node_id);
+    return out;
+}
+
+DynamicSnitch::Options no_explore() {
+    DynamicSnitch::Options o;
+    o.explore_every = 0;
+    return o;
+}
+
+}  // namespace
+
+TEST(DynamicSnitch, PrefersFasterReplicas) {
+    DynamicSnitch snitch(no_explore());
+    sample(snitch, 1, 5000);
+    sample(snitch, 2, 500);
+    sample(snitch, 3, 600);
+
+    auto replicas = nodes({1, 2, 3});
+    std::vector<NodeInfo> buf;
+    auto ranked = snitch.rank(replicas, 2, 0, buf);
+    EXPECT_EQ(ids(ranked), (std::vector<uint32_t>{2, 3, 1}));
+    EXPECT_EQ(snitch.stats().reorders, 1u);
+
+    // This node needs no hop: it always ranks first.
+    ranked = snitch.rank(replicas, 2, 1, buf);
+    EXPECT_EQ(ids(ranked).front(), 1u);
+
+    // A peer never measured ranks ahead of a measured one, so it gets a sample.
+    auto with_new = nodes({2, 4});
+    ranked = snitch.rank(with_new, 1, 0, buf);
+    EXPECT_EQ(ids(ranked).front(), 4u);
+}
+
+TEST(DynamicSnitch, KeepsRingOrderWhenReplicasAreClose) {
+    DynamicSnitch snitch(no_explore());
+    sample(snitch, 1, 1050);
+    sample(snitch, 2, 1000);
+    sample(snitch, 3, 1020);
+
+    auto replicas = nodes({1, 2, 3});
+    std::vector<NodeInfo> buf;
+    auto ranked = snitch.rank(replicas, 2, 0, buf);
+    EXPECT_EQ(&ranked[0], &replicas[0]);  // within the 10% threshold
+    EXPECT_EQ(snitch.stats().reorders, 0u);
+}
+
+TEST(DynamicSnitch, OutstandingRequestsAndBusyFlagCount) {
+    DynamicSnitch::Clock::time_point now{};
+    DynamicSnitch snitch(no_explore());
+    snitch.set_clock([&] { return now; });
+    sample(snitch, 1, 1000);
+    sample(snitch, 2, 1000);
+    auto replicas = nodes({1, 2});
+    std::vector<NodeInfo> buf;
+
+    // Requests piling up on a peer (it stalls) move reads away before any
+    // slow answer arrives.
+    snitch.begin(1);
+    snitch.begin(1);
+    EXPECT_EQ(snitch.score(1).outstanding, 2u);
+    EXPECT_EQ(ids(snitch.rank(replicas, 1, 0, buf)).front(), 2u);
+    snitch.end(1, std::chrono::microseconds(1000), true, false);
+    snitch.end(1, std::chrono::microseconds(1000), true, false);
+    EXPECT_EQ(&snitch.rank(replicas, 1, 0, buf)[0], &replicas[0]);
+
+    // A peer that flags itself busy (snapshotting) is read last until the
+    // flag clears or expires.
+    sample(snitch, 1, 1000, 1, /*busy=*/true);
+    EXPECT_TRUE(snitch.score(1).busy);
+    EXPECT_EQ(ids(snitch.rank(replicas, 1, 0, buf)).front(), 2u);
+    now += std::chrono::milliseconds(2500);
+    EXPECT_FALSE(snitch.score(1).busy);
+    EXPECT_EQ(&snitch.rank(replicas, 1, 0, buf)[0], &replicas[0]);
+
+    // A failure weighs at least twice the average.
+    snitch.begin(2);
+    snitch.end(2, std::chrono::microseconds(10), false, false);
+    EXPECT_GE(snitch.score(2).ewma_us, 1000.0);
+}
+
+TEST(DynamicSnitch, ExplorationLetsASlowReplicaRecover) {
+    // Node 1 is the ring's first choice.  It turns slow (5 ms instead of
+    // 0.5 ms) for 2000 reads, then recovers; R = 1 of 3 replicas.
+    DynamicSnitch::Options o;
+    o.explore_every = 32;
+    DynamicSnitch snitch(o);
+    auto replicas = nodes({1, 2, 3});
+    std::vector<NodeInfo> buf;
+
+    auto run = [&](int reads, bool slow) {
+        int to_node1 = 0;
+        for (int i = 0; i < reads; i++) {
+            uint32_t chosen = snitch.rank(replicas, 1, 0, buf).front().node_id;
+            if (chosen == 1) to_node1++;
+            sample(snitch, chosen, chosen == 1 && slow ? 5000 : 500 + 10 * chosen);
+        }
+        return to_node1;
+    };
+
+    int warm  = run(500, false);
+    int slow  = run(2000, true);
+    int after = run(2000, false);
+    int last  = run(500, false);
+    std::printf("[SIM] reads to the first replica: %d/500 healthy, %d/2000 slow, "
+                "%d/2000 recovering, %d/500 recovered\n", warm, slow, after, last);
+
+    EXPECT_GT(warm, 400);
+    EXPECT_LT(slow, 2000 / 32 + 20);  // little more than the exploration reads
+    EXPECT_GT(last, 400);             // back to the ring order
+    EXPECT_GT(snitch.stats().explorations, 0u);
+}
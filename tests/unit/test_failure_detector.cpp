@@ -0,0 +1,299 @@
+#include "cluster/membership.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace dkv;
+
+// ---------------------------------------------------------------------------
+// ArrivalWindow
+// ---------------------------------------------------------------------------
+
+TEST(ArrivalWindow, TracksMeanAndDeviationOverASlidingWindow) {
+    ArrivalWindow w(4, 1000.0);  // seeded with 750 and 1250
+    EXPECT_DOUBLE_EQ(w.mean(), 1000.0);
+    EXPECT_DOUBLE_EQ(w.std_dev(), 250.0);
+
+    for (int i = 0; i < 4; i++) w.add(500.0);  // evicts both seeds
+    EXPECT_EQ(w.size(), 4u);
+    EXPECT_DOUBLE_EQ(w.mean(), 500.0);
+    EXPECT_NEAR(w.std_dev(), 0.0, 1e-6);
+}
+
+TEST(ArrivalWindow, PhiRisesWithSilence) {
+    ArrivalWindow w(100, 1000.0);
+    for (int i = 0; i < 100; i++) w.add(i % 2 ? 950.0 : 1050.0);  // std 50
+
+    EXPECT_LT(w.phi(500, 10, 0), 0.01);
+    EXPECT_NEAR(w.phi(1000, 10, 0), -std::log10(0.5), 0.01);  // at the mean
+    double prev = 0;
+    for (double t = 1000; t <= 1400; t += 50) {
+        double phi = w.phi(t, 10, 0);
+        EXPECT_GT(phi, prev);
+        prev = phi;
+    }
+    EXPECT_GT(w.phi(1400, 10, 0), 8.0);           // 8 std devs late
+    EXPECT_LT(w.phi(1400, 10, 1000), 0.01);       // ...but within the pause
+    EXPECT_LT(w.phi(1400, 200, 0), w.phi(1400, 10, 0));  // floored std dev
+}
+
+// ---------------------------------------------------------------------------
+// Membership with phi accrual
+// ---------------------------------------------------------------------------
+
+namespace {
+
+/// Membership driven by a virtual clock.
+struct VirtualClock {
+    Membership::Clock::time_point now{};
+    void advance(int64_t ms) { now += std::chrono::milliseconds(ms); }
+    void attach(Membership& m) {
+        m.set_clock([this] { return now; });
+    }
+};
+
+Membership::PhiOptions phi_options(double suspect, double down, double pause_ms) {
+    Membership::PhiOptions o;
+    o.enabled             = true;
+    o.suspect_phi         = suspect;
+    o.down_phi            = down;
+    o.acceptable_pause_ms = pause_ms;
+    o.min_std_dev_ms      = 100;
+    o.expected_interval_ms = 1000;
+    return o;
+}
+
+}  // namespace
+
+TEST(PhiAccrual, SuspicionIsContinuousAndDrivesTransitions) {
+    VirtualClock clock;
+    Membership m;
+    clock.attach(m);
+    m.set_phi_accrual(phi_options(3.0, 8.0, 0));
+    m.add_peer(1, "127.0.0.1:7001");
+
+    for (int i = 0; i < 20; i++) {
+        clock.advance(1000);
+        m.record_success(1);
+    }
+    EXPECT_LT(m.suspicion(1), 0.5);
+    EXPECT_FALSE(m.is_suspect(1));
+
+    // Late, but no missed PING reported yet: suspicious, still UP.
+    clock.advance(1350);
+    EXPECT_GT(m.suspicion(1), 3.0);
+    EXPECT_TRUE(m.is_suspect(1));
+    EXPECT_EQ(m.get_state(1), NodeState::UP);
+
+    m.record_failure(1);
+    EXPECT_EQ(m.get_state(1), NodeState::SUSPECTED);
+    EXPECT_TRUE(m.is_available(1));
+
+    clock.advance(400);
+    m.record_failure(1);
+    EXPECT_EQ(m.get_state(1), NodeState::DOWN);
+
+    clock.advance(10000);
+    m.record_success(1);  // the outage is not an inter-arrival sample
+    EXPECT_EQ(m.get_state(1), NodeState::UP);
+    clock.advance(1000);
+    EXPECT_LT(m.suspicion(1), 0.5);
+}
+
+TEST(PhiAccrual, JitteryPeersEarnMoreSlack) {
+    VirtualClock clock;
+    Membership m;
+    clock.attach(m);
+    m.set_phi_accrual(phi_options(5.0, 8.0, 0));
+    m.add_peer(1, "127.0.0.1:7001");  // regular
+    m.add_peer(2, "127.0.0.1:7002");  // jittery
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> jitter(-400, 400);
+    auto t1 = clock.now, t2 = clock.now;
+    for (int i = 0; i < 100; i++) {
+        // Deliver the two peers' heartbeats in time order.
+        auto next1 = t1 + std::chrono::milliseconds(1000);
+        auto next2 = t2 + std::chrono::milliseconds(1000 + jitter(rng));
+        for (auto [at, id] : {std::pair{std::min(next1, next2), next1 <= next2 ? 1u : 2u},
+                              std::pair{std::max(next1, next2), next1 <= next2 ? 2u : 1u}}) {
+            clock.now = at;
+            m.record_success(id);
+        }
+        t1 = next1;
+        t2 = next2;
+    }
+    // The same silence means less for the peer that is often late.
+    clock.now = std::max(t1, t2);
+    auto last1 = t1, last2 = t2;
+    clock.now = last1 + std::chrono::milliseconds(1600);
+    double phi1 = m.suspicion(1);
+    clock.now = last2 + std::chrono::milliseconds(1600);
+    double phi2 = m.suspicion(2);
+    EXPECT_GT(phi1, phi2);
+}
+
+// ---------------------------------------------------------------------------
+// Trace replay: detection time vs false positives
+// ---------------------------------------------------------------------------
+//
+// A heartbeat round every INTERVAL_MS probes the peer with a TIMEOUT_MS
+// deadline, like Heartbeat.  A trace gives each probe's latency; latencies
+// include stop-the-world pauses (the peer answers nothing until the pause
+// ends) and, after DEATH_MS, no answers at all.  Each detector is fed the
+// same results in virtual time and scored on:
+//   - false DOWNs / false SUSPECTs: transitions while the peer was alive;
+//   - detection: ms from death to DOWN.
+
+namespace {
+
+constexpr int64_t INTERVAL_MS = 1000;
+constexpr int64_t TIMEOUT_MS  = 500;
+constexpr int64_t DEATH_MS    = 600'000;
+constexpr int64_t END_MS      = DEATH_MS + 60'000;
+constexpr int64_t NEVER       = -1;
+
+/// Probe latency per round (ms); NEVER = no answer.
+std::vector<int64_t> make_trace(uint32_t seed, double pause_rate,
+                                int64_t max_pause_ms) {
+    std::mt19937_64 rng(seed);
+    std::lognormal_distribution<double> net(std::log(2.0), 0.8);  // ~2ms, long tail
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::uniform_int_distribution<int64_t> pause_len(200, max_pause_ms);
+
+    std::vector<int64_t> trace;
+    int64_t paused_until = 0;
+    for (int64_t t = INTERVAL_MS; t < END_MS; t += INTERVAL_MS) {
+        if (t >= DEATH_MS) {
+            trace.push_back(NEVER);
+            continue;
+        }
+        // A pause may start anywhere in the interval before this probe.
+        if (unit(rng) < pause_rate) {
+            int64_t start = t - static_cast<int64_t>(unit(rng) * INTERVAL_MS);
+            paused_until = std::max(paused_until, start + pause_len(rng));
+        }
+        int64_t latency = static_cast<int64_t>(net(rng));
+        if (paused_until > t) latency = std::max(latency, paused_until - t);
+        trace.push_back(latency);
+    }
+    return trace;
+}
+
+struct Score {
+    int     false_downs    = 0;
+    int     false_suspects = 0;
+    int64_t detection_ms   = NEVER;
+};
+
+Score replay(const std::vector<int64_t>& trace, Membership& m, VirtualClock& clock) {
+    Score score;
+    auto origin = clock.now;
+    auto at = [&](int64_t ms) { return origin + std::chrono::milliseconds(ms); };
+    m.set_down_callback([&](uint32_t, const std::string&) {
+        int64_t t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        clock.now - origin).count();
+        if (t < DEATH_MS) {
+            score.false_downs++;
+        } else if (score.detection_ms == NEVER) {
+            score.detection_ms = t - DEATH_MS;
+        }
+    });
+    m.add_peer(1, "sim");
+
+    NodeState prev = NodeState::UP;
+    int64_t round_at = INTERVAL_MS;
+    for (int64_t latency : trace) {
+        if (latency != NEVER && latency < TIMEOUT_MS) {
+            clock.now = at(round_at + latency);
+            m.record_success(1);
+        } else {
+            clock.now = at(round_at + TIMEOUT_MS);
+            m.record_failure(1);
+        }
+        NodeState s = m.get_state(1);
+        if (round_at < DEATH_MS && s == NodeState::SUSPECTED && prev == NodeState::UP) {
+            score.false_suspects++;
+        }
+        prev = s;
+        round_at += INTERVAL_MS;
+    }
+    return score;
+}
+
+struct Detector {
+    const char*              name;
+    bool                     phi;
+    Membership::PhiOptions   options;
+};
+
+/// Replay `seeds` traces through `d`; totals false positives, averages
+/// detection time (NEVER if any death went undetected).
+Score evaluate(const Detector& d, double pause_rate, int64_t max_pause_ms, int seeds) {
+    Score total;
+    int64_t detection_sum = 0;
+    bool    all_detected  = true;
+    for (int seed = 1; seed <= seeds; seed++) {
+        VirtualClock clock;
+        Membership m(3, 5000);  // the fixed thresholds dkv_node uses
+        clock.attach(m);
+        if (d.phi) m.set_phi_accrual(d.options);
+        Score s = replay(make_trace(static_cast<uint32_t>(seed), pause_rate, max_pause_ms),
+                         m, clock);
+        total.false_downs    += s.false_downs;
+        total.false_suspects += s.false_suspects;
+        if (s.detection_ms == NEVER) all_detected = false;
+        detection_sum += s.detection_ms;
+    }
+    total.detection_ms = all_detected ? detection_sum / seeds : NEVER;
+    return total;
+}
+
+}  // namespace
+
+TEST(PhiAccrual, TraceReplayDetectionVersusFalsePositives) {
+    const int seeds = 10;  // 10 x 10 minutes of heartbeats per detector
+    std::vector<Detector> detectors = {
+        {"fixed 3 misses / 5000ms", false, {}},
+        {"phi 3/5,  pause 0",    true, phi_options(3, 5, 0)},
+        {"phi 5/8,  pause 0",    true, phi_options(5, 8, 0)},
+        {"phi 5/8,  pause 1000", true, phi_options(5, 8, 1000)},
+        {"phi 5/12, pause 1000", true, phi_options(5, 12, 1000)},
+        {"phi 5/8,  pause 2000", true, phi_options(5, 8, 2000)},
+    };
+
+    std::printf("[SIM] %-26s %12s %12s %10s\n", "detector", "false DOWN",
+                "false SUSP", "detect ms");
+    std::vector<Score> scores;
+    for (const auto& d : detectors) {
+        // 1% of intervals start a pause of up to 2.5s.
+        scores.push_back(evaluate(d, 0.01, 2500, seeds));
+        std::printf("[SIM] %-26s %12d %12d %10lld\n", d.name, scores.back().false_downs,
+                    scores.back().false_suspects,
+                    static_cast<long long>(scores.back().detection_ms));
+    }
+
+    // Every detector eventually notices the death.
+    for (const auto& s : scores) EXPECT_NE(s.detection_ms, NEVER);
+
+    // Raising the thresholds or the acceptable pause trades detection time
+    // for fewer false positives.
+    EXPECT_GE(scores[1].false_downs, scores[2].false_downs);
+    EXPECT_LE(scores[1].detection_ms, scores[2].detection_ms);
+    EXPECT_GE(scores[2].false_downs, scores[3].false_downs);
+    EXPECT_LE(scores[2].detection_ms, scores[3].detection_ms);
+    EXPECT_LE(scores[3].detection_ms, scores[4].detection_ms);
+
+    // The default phi settings (5/8, 1s pause) ride out the pauses that the
+    // fixed detector also survives, and convict a dead peer sooner.
+    const Score& fixed = scores[0];
+    const Score& phi   = scores[3];
+    EXPECT_EQ(phi.false_downs, 0);
+    EXPECT_LE(phi.false_downs, fixed.false_downs);
+    EXPECT_LT(phi.detection_ms, fixed.detection_ms);
+}
@@ -0,0 +1,324 @@
+#include "cluster/gossip.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dkv;
+
+// ---------------------------------------------------------------------------
+// Wire format
+// ---------------------------------------------------------------------------
+
+TEST(Gossip, MessageRoundTripAndMalformedInput) {
+    Gossip::Message m;
+    m.type        = Gossip::Type::PINGREQ;
+    m.sender      = 7;
+    m.incarnation = 3;
+    m.target      = 9;
+    m.updates.push_back({1, Gossip::State::ALIVE, 4});
+    m.updates.push_back({2, Gossip::State::SUSPECT, 0});
+    m.updates.push_back({3, Gossip::State::DEAD, 12});
+
+    std::string wire = Gossip::encode(m);
+    Gossip::Message out;
+    ASSERT_TRUE(Gossip::decode(wire, out));
+    EXPECT_EQ(out.type, Gossip::Type::PINGREQ);
+    EXPECT_EQ(out.sender, 7u);
+    EXPECT_EQ(out.incarnation, 3u);
+    EXPECT_EQ(out.target, 9u);
+    ASSERT_EQ(out.updates.size(), 3u);
+    EXPECT_EQ(out.updates[1].state, Gossip::State::SUSPECT);
+    EXPECT_EQ(out.updates[2].node_id, 3u);
+    EXPECT_EQ(out.updates[2].incarnation, 12u);
+
+    EXPECT_FALSE(Gossip::decode(wire.substr(0, wire.size() - 1), out));
+    EXPECT_FALSE(Gossip::decode(wire + "x", out));
+    std::string bad_type = wire;
+    bad_type[0] = 9;
+    EXPECT_FALSE(Gossip::decode(bad_type, out));
+    std::string bad_state = wire;
+    bad_state[15 + 4] = 3;  // first update's state
+    EXPECT_FALSE(Gossip::decode(bad_state, out));
+}
+
+// ---------------------------------------------------------------------------
+// Simulated cluster: a lossy in-process network in virtual time
+// ---------------------------------------------------------------------------
+
+namespace {
+
+class Sim;
+
+class SimTransport : public GossipTransport {
+public:
+    explicit SimTransport(Sim& sim) : sim_(sim) {}
+    void request(const std::string& address, std::string payload,
+                 std::chrono::milliseconds timeout, Done done) override;
+
+private:
+    Sim& sim_;
+};
+
+class Sim {
+public:
+    struct Node {
+        std::unique_ptr<Membership>   membership;
+        std::unique_ptr<SimTransport> transport;
+        std::unique_ptr<Gossip>       gossip;
+        bool                          up = true;
+    };
+
+    Sim(size_t n, double loss, uint64_t seed, Gossip::Options options)
+        : loss_(loss), rng_(seed), options_(options) {
+        nodes_.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            boot(i);
+            // Spread the nodes' periods out.
+            int64_t phase = std::uniform_int_distribution<int64_t>(
+                0, options_.period_ms - 1)(rng_);
+            schedule_tick(i, phase);
+        }
+    }
+
+    static std::string address(size_t i) { return "n" + std::to_string(i); }
+
+    /// (Re)start node `i` with fresh state, as after a process restart.
+    void boot(size_t i) {
+        Node& n = nodes_[i];
+        if (n.gossip) retired_.push_back(std::move(n));  // callbacks may be in flight
+        n = Node{};
+        n.membership = std::make_unique<Membership>();
+        n.membership->set_clock([this] { return clock(); });
+        for (size_t j = 0; j < nodes_.size(); j++) {
+            if (j != i) n.membership->add_peer(static_cast<uint32_t>(j), address(j));
+        }
+        n.membership->set_down_callback([this, i](uint32_t id, const std::string&) {
+            if (nodes_[i].up) downs.push_back({i, id, now_});
+        });
+        n.membership->set_rejoin_callback([this, i](uint32_t id, const std::string&) {
+            if (nodes_[i].up) rejoins.push_back({i, id, now_});
+        });
+        n.transport = std::make_unique<SimTransport>(*this);
+        Gossip::Options o = options_;
+        o.seed = rng_();
+        n.gossip = std::make_unique<Gossip>(*n.membership, *n.transport,
+                                            static_cast<uint32_t>(i), o);
+        n.gossip->set_clock([this] { return clock(); });
+        n.up = true;
+    }
+
+    void kill(size_t i) { nodes_[i].up = false; }
+
+    void at(int64_t t, std::function<void()> fn) {
+        events_.push(Event{t, seq_++, std::move(fn)});
+    }
+
+    /// Run events up to virtual time `t` (ms), or until `stop` holds.
+    void run_until(int64_t t, const std::function<bool()>& stop = {}) {
+        while (!events_.empty() && events_.top().t <= t) {
+            Event e = events_.top();
+            events_.pop();
+            now_ = e.t;
+            e.fn();
+            if (stop && stop()) return;
+        }
+        now_ = t;
+    }
+
+    bool lost() { return std::bernoulli_distribution(loss_)(rng_); }
+    int64_t latency() { return std::uniform_int_distribution<int64_t>(1, 5)(rng_); }
+
+    int64_t now() const { return now_; }
+    Node&   node(size_t i) { return nodes_[i]; }
+    size_t  size() const { return nodes_.size(); }
+
+    struct Change {
+        size_t   observer;
+        uint32_t node;
+        int64_t  at_ms;
+    };
+    std::vector<Change> downs;
+    std::vector<Change> rejoins;
+
+private:
+    struct Event {
+        int64_t               t;
+        uint64_t              seq;
+        std::function<void()> fn;
+        bool operator>(const Event& o) const {
+            return t != o.t ? t > o.t : seq > o.seq;
+        }
+    };
+
+    double          loss_;
+    std::mt19937_64 rng_;
+    Gossip::Options options_;
+    int64_t         now_ = 0;
+    uint64_t        seq_ = 0;
+    std::vector<Node> nodes_;
+    std::vector<Node> retired_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<>> events_;
+
+    Membership::Clock::time_point clock() const {
+        return Membership::Clock::time_point{} + std::chrono::milliseconds(now_);
+    }
+
+    void schedule_tick(size_t i, int64_t t) {
+        at(t, [this, i, t] {
+            if (nodes_[i].up) nodes_[i].gossip->tick();
+            schedule_tick(i, t + options_.period_ms);
+        });
+    }
+};
+
+void SimTransport::request(const std::string& address, std::string payload,
+                           std::chrono::milliseconds timeout, Done done) {
+    size_t to = std::stoul(address.substr(1));
+    auto answered = std::make_shared<bool>(false);
+    auto cb = std::make_shared<Done>(std::move(done));
+    Sim& sim = sim_;
+
+    sim.at(sim.now() + timeout.count(), [answered, cb] {
+        if (*answered) return;
+        *answered = true;
+        (*cb)(false, {});
+    });
+    if (sim.lost()) return;
+    sim.at(sim.now() + sim.latency(), [&sim, to, payload, answered, cb] {
+        if (!sim.node(to).up) return;
+        sim.node(to).gossip->serve(payload, [&sim, answered, cb](std::string reply) {
+            if (reply.empty() || sim.lost()) return;
+            sim.at(sim.now() + sim.latency(), [answered, cb, reply] {
+                if (*answered) return;
+                *answered = true;
+                (*cb)(true, reply);
+            });
+        });
+    });
+}
+
+Gossip::Options sim_options() {
+    Gossip::Options o;
+    o.period_ms        = 1000;
+    o.probe_timeout_ms = 200;
+    return o;
+}
+
+/// Whether every live node other than `dead` has Membership DOWN for it.
+bool all_see_down(Sim& sim, uint32_t dead) {
+    for (size_t i = 0; i < sim.size(); i++) {
+        if (i == dead || !sim.node(i).up) continue;
+        if (sim.node(i).membership->get_state(dead) != NodeState::DOWN) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST(Gossip, RefutesASuspicionAboutItself) {
+    Sim sim(3, 0.0, 1, sim_options());
+    Gossip& g = *sim.node(0).gossip;
+
+    Gossip::Message ping;
+    ping.type   = Gossip::Type::PING;
+    ping.sender = 1;
+    ping.updates.push_back({0, Gossip::State::SUSPECT, 0});
+    std::string reply;
+    g.serve(Gossip::encode(ping), [&](std::string r) { reply = std::move(r); });
+
+    Gossip::Message ack;
+    ASSERT_TRUE(Gossip::decode(reply, ack));
+    EXPECT_EQ(ack.type, Gossip::Type::ACK);
+    EXPECT_EQ(ack.incarnation, 1u);  // "alive, incarnation 1" beats "suspect, 0"
+    EXPECT_EQ(g.incarnation(), 1u);
+    EXPECT_EQ(g.stats().refutations, 1u);
+    bool carried = false;
+    for (const auto& u : ack.updates) {
+        carried |= u.node_id == 0 && u.state == Gossip::State::ALIVE && u.incarnation == 1;
+    }
+    EXPECT_TRUE(carried);
+
+    // An older rumour is ignored; garbage gets an empty reply.
+    g.serve(Gossip::encode(ping), [&](std::string r) { reply = std::move(r); });
+    EXPECT_EQ(g.incarnation(), 1u);
+    g.serve("junk", [&](std::string r) { reply = std::move(r); });
+    EXPECT_TRUE(reply.empty());
+}
+
+TEST(Gossip, DeadNodeIsDetectedAndRestartRejoins) {
+    Sim sim(8, 0.05, 42, sim_options());
+    sim.run_until(5000);
+    EXPECT_TRUE(sim.downs.empty());
+
+    sim.kill(3);
+    sim.run_until(60000, [&] { return all_see_down(sim, 3); });
+    ASSERT_TRUE(all_see_down(sim, 3)) << "at " << sim.now() << " ms";
+    for (const auto& d : sim.downs) EXPECT_EQ(d.node, 3u);
+    for (size_t i = 0; i < sim.size(); i++) {
+        if (i == 3) continue;
+        EXPECT_EQ(sim.node(i).gossip->state_of(3), Gossip::State::DEAD);
+    }
+
+    // The restarted node learns it was declared dead and refutes.
+    sim.boot(3);
+    int64_t restarted = sim.now();
+    auto all_up = [&] {
+        for (size_t i = 0; i < sim.size(); i++) {
+            if (i != 3 && sim.node(i).membership->get_state(3) != NodeState::UP) return false;
+        }
+        return true;
+    };
+    sim.run_until(restarted + 30000, all_up);
+    ASSERT_TRUE(all_up());
+    EXPECT_GE(sim.node(3).gossip->incarnation(), 1u);
+    EXPECT_EQ(sim.rejoins.size(), sim.size() - 1);
+}
+
+TEST(Gossip, ConvergenceAgainstClusterSize) {
+    // One node dies in clusters of growing size on a network dropping 5% of
+    // messages in each direction.  Detection and dissemination should grow
+    // with log N while each node's message rate stays flat.
+    std::printf("[SIM] %6s %14s %14s %16s %12s\n", "nodes", "first DOWN ms",
+                "all DOWN ms", "msgs/node/period", "false DOWN");
+    for (size_t n : {8, 16, 32, 64, 128}) {
+        Sim sim(n, 0.05, 1000 + n, sim_options());
+        const int64_t warmup = 5000;
+        sim.run_until(warmup);
+
+        const uint32_t dead = static_cast<uint32_t>(n / 2);
+        sim.kill(dead);
+        sim.run_until(warmup + 120000, [&] { return all_see_down(sim, dead); });
+        ASSERT_TRUE(all_see_down(sim, dead)) << n << " nodes";
+
+        int64_t first = INT64_MAX;
+        size_t  false_downs = 0;
+        for (const auto& d : sim.downs) {
+            if (d.node == dead) {
+                first = std::min(first, d.at_ms - warmup);
+            } else {
+                false_downs++;
+            }
+        }
+        uint64_t messages = 0;
+        for (size_t i = 0; i < n; i++) messages += sim.node(i).gossip->stats().messages_sent;
+        double periods = static_cast<double>(sim.now()) / 1000.0;
+        std::printf("[SIM] %6zu %14lld %14lld %16.2f %12zu\n", n,
+                    static_cast<long long>(first),
+                    static_cast<long long>(sim.now() - warmup),
+                    static_cast<double>(messages) / static_cast<double>(n) / periods,
+                    false_downs);
+
+        EXPECT_EQ(false_downs, 0u) << n << " nodes";
+        // Heartbeat to all would send n - 1 PINGs per node per period.
+        EXPECT_LT(static_cast<double>(messages) / static_cast<double>(n) / periods, 4.0);
+    }
+}
@@ -2,9 +2,14 @@
 
 #include "cluster/hash_ring.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 TEST(HashRing, DeterministicLookup) {
     dkv::HashRing ring;
@@ -117,3 +122,193 @@ TEST(HashRing, EmptyRing) {
     auto replicas = ring.get_replica_nodes("key", 3);
     EXPECT_TRUE(replicas.empty());
 }
+
+// ---------------------------------------------------------------------------
+// Flat snapshot: Eytzinger search + precomputed preference lists
+// ---------------------------------------------------------------------------
+
+TEST(HashRing, SnapshotMatchesSortedWalk) {
+    dkv::HashRing ring;
+    for (uint32_t id = 1; id <= 5; id++) {
+        ring.add_node(id, "127.0.0.1:" + std::to_string(7000 + id), 37);
+    }
+    const auto& snap   = ring.snapshot();
+    const auto& tokens = snap.tokens();
+
+    // Reference: std::upper_bound + clockwise walk over distinct owners.
+    auto reference = [&](uint64_t pos, size_t count) {
+        std::vector<uint32_t> out;
+        size_t i = std::upper_bound(tokens.begin(), tokens.end(), pos) - tokens.begin();
+        for (size_t walked = 0; walked < tokens.size() && out.size() < count; walked++) {
+            if (i == tokens.size()) i = 0;
+            uint32_t id = snap.nodes()[snap.owners()[i]].node_id;
+            if (std::find(out.begin(), out.end(), id) == out.end()) out.push_back(id);
+            ++i;
+        }
+        return out;
+    };
+
+    std::vector<uint64_t> positions = {0, 1, UINT64_MAX, tokens.front(),
+                                       tokens.back(), tokens.back() - 1};
+    for (size_t i = 0; i < tokens.size(); i += 7) positions.push_back(tokens[i]);
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 5000; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        positions.push_back(x);
+    }
+
+    for (uint64_t pos : positions) {
+        for (size_t count : {1u, 3u, 5u, 9u}) {
+            auto got = ring.replicas_at(pos, count);
+            auto want = reference(pos, count);
+            ASSERT_EQ(got.size(), want.size()) << pos;
+            for (size_t r = 0; r < got.size(); r++) {
+                EXPECT_EQ(got[r].node_id, want[r]) << pos << " #" << r;
+            }
+        }
+    }
+}
+
+TEST(HashRing, OldSnapshotsStayValidAcrossUpdates) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:7001", 32);
+    ring.add_node(2, "127.0.0.1:7002", 32);
+    ring.add_node(3, "127.0.0.1:7003", 32);
+    const uint64_t v = ring.version();
+
+    auto before = ring.get_replica_nodes("key", 3);
+    ASSERT_EQ(before.size(), 3u);
+    std::vector<uint32_t> ids;
+    for (const auto& n : before) ids.push_back(n.node_id);
+
+    ring.remove_node(2);
+    EXPECT_GT(ring.version(), v);
+    EXPECT_EQ(ring.get_replica_nodes("key", 3).size(), 2u);
+
+    // The list handed out earlier still reads the old ring.
+    for (size_t i = 0; i < ids.size(); i++) EXPECT_EQ(before[i].node_id, ids[i]);
+}
+
+TEST(HashRing, RetiredSnapshotsAreKeptForTheGracePeriod) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:7001", 32);
+    ring.add_node(2, "127.0.0.1:7002", 32);
+
+    auto before = ring.get_replica_nodes("key", 2);
+    std::vector<uint32_t> ids;
+    for (const auto& n : before) ids.push_back(n.node_id);
+
+    // A burst of changes, staged ones included, within the grace period
+    // frees nothing: the old list still reads the old ring.
+    for (uint32_t i = 0; i < 20; i++) {
+        ring.add_node(10 + i, "127.0.0.1:7100", 4);
+        ASSERT_TRUE(ring.stage_add(100 + i, "127.0.0.1:7101", 4));
+        ring.abort_pending();
+    }
+    EXPECT_EQ(ring.retired_count(), 2u + 40u);
+    for (size_t i = 0; i < ids.size(); i++) EXPECT_EQ(before[i].node_id, ids[i]);
+}
+
+TEST(HashRing, RetiredSnapshotsAreReclaimedAfterTheGracePeriod) {
+    dkv::HashRing ring(std::chrono::milliseconds(0));
+    for (uint32_t i = 0; i < 100; i++) {
+        ring.add_node(i, "127.0.0.1:7000", 4);
+        if (ring.stage_remove(i)) ring.commit_pending();
+    }
+    // Only the newest retired snapshots remain.
+    EXPECT_EQ(ring.retired_count(), dkv::HashRing::RETIRED_SNAPSHOTS);
+    EXPECT_EQ(ring.node_count(), 0u);
+
+    ring.add_node(1, "127.0.0.1:7001", 16);
+    EXPECT_EQ(ring.get_replica_nodes("key", 3).size(), 1u);
+}
+
+TEST(HashRing, ReplicaListsHoldDistinctOwnersInRingOrder) {
+    dkv::HashRing ring;
+    for (uint32_t id = 1; id <= 5; id++) {
+        ring.add_node(id, "127.0.0.1:" + std::to_string(7000 + id), 16);
+    }
+    const auto& snap = ring.snapshot();
+    for (size_t t = 0; t < snap.size(); t++) {
+        auto list = snap.replicas_at(snap.tokens()[t] - 1, 3);
+        ASSERT_EQ(list.size(), 3u);
+        // The token's own owner comes first.
+        EXPECT_EQ(list.front().node_id, snap.nodes()[snap.owners()[t]].node_id);
+        std::vector<uint32_t> seen;
+        for (const auto& n : list) {
+            EXPECT_EQ(std::count(seen.begin(), seen.end(), n.node_id), 0);
+            seen.push_back(n.node_id);
+        }
+        EXPECT_EQ(list.first(2).size(), 2u);
+        EXPECT_EQ(&list.first(2)[1], &list[1]);
+    }
+}
+
+TEST(HashRing, LookupsDuringMembershipChanges) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:7001", 64);
+    ring.add_node(2, "127.0.0.1:7002", 64);
+    ring.add_node(3, "127.0.0.1:7003", 64);
+
+    std::atomic<bool> stop{false};
+    std::atomic<int>  bad{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&, t]() {
+            for (int i = 0; !stop.load(std::memory_order_relaxed); i++) {
+                auto replicas = ring.get_replica_nodes(
+                    "k" + std::to_string(t * 1000000 + i), 3);
+                std::set<uint32_t> ids;
+                for (const auto& n : replicas) ids.insert(n.node_id);
+                if (replicas.size() != 3 || ids.size() != 3) bad.fetch_add(1);
+            }
+        });
+    }
+    for (int i = 0; i < 50; i++) {
+        ring.add_node(4, "127.0.0.1:7004", 64);
+        ring.remove_node(4);
+    }
+    stop.store(true);
+    for (auto& r : readers) r.join();
+    EXPECT_EQ(bad.load(), 0);
+}
+
+TEST(HashRing, StagedChangeIsPendingUntilCommit) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:7001", 64);
+    ring.add_node(2, "127.0.0.1:7002", 64);
+    const uint64_t version = ring.version();
+
+    EXPECT_EQ(ring.pending(), nullptr);
+    ASSERT_TRUE(ring.stage_add(3, "127.0.0.1:7003", 64));
+    EXPECT_FALSE(ring.stage_add(2, "127.0.0.1:7002", 64));  // already a member
+    ASSERT_NE(ring.pending(), nullptr);
+    EXPECT_EQ(ring.node_count(), 2u);
+    EXPECT_EQ(ring.pending()->node_count(), 3u);
+    EXPECT_EQ(ring.pending()->size(), 192u);
+
+    // The staged ring places keys exactly as adding the node would.
+    dkv::HashRing direct;
+    direct.add_node(1, "127.0.0.1:7001", 64);
+    direct.add_node(2, "127.0.0.1:7002", 64);
+    direct.add_node(3, "127.0.0.1:7003", 64);
+    EXPECT_EQ(ring.pending()->tokens(), direct.tokens());
+
+    ring.abort_pending();
+    EXPECT_EQ(ring.pending(), nullptr);
+    EXPECT_EQ(ring.version(), version);
+
+    ASSERT_TRUE(ring.stage_remove(1));
+    ASSERT_TRUE(ring.commit_pending());
+    EXPECT_FALSE(ring.commit_pending());
+    EXPECT_EQ(ring.pending(), nullptr);
+    EXPECT_EQ(ring.node_count(), 1u);
+    EXPECT_EQ(ring.size(), 64u);
+    EXPECT_EQ(ring.version(), version + 1);
+    EXPECT_EQ(ring.get_node("any")->node_id, 2u);
+
+    // Writers carry on from the committed state.
+    ring.add_node(4, "127.0.0.1:7004", 64);
+    EXPECT_EQ(ring.node_count(), 2u);
+    EXPECT_EQ(ring.version(), version + 2);
+}
@@ -55,6 +55,29 @@ static void run_pong_server(int listen_fd, std::atomic<bool>& running) {
     }
 }
 
+// Accept one connection and answer every PING line on it until `running` is
+// false (like a real node: the connection stays open between rounds).
+static void run_persistent_pong_server(int listen_fd, std::atomic<bool>& running) {
+    ::fcntl(listen_fd, F_SETFL, O_NONBLOCK);
+    int client = -1;
+    while (running.load() && client < 0) {
+        client = ::accept(listen_fd, nullptr, nullptr);
+        if (client < 0) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    if (client < 0) return;
+    struct timeval tv{0, 20000};
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    while (running.load()) {
+        char buf[64];
+        ssize_t n = ::recv(client, buf, sizeof(buf), 0);
+        if (n == 0) break;
+        for (ssize_t i = 0; i < n; i++) {
+            if (buf[i] == '\n') ::send(client, "+PONG\n", 6, 0);
+        }
+    }
+    ::close(client);
+}
+
 // ── Tests ─────────────────────────────────────────────────────────────────────
 
 // start() / stop() can be called multiple times without crashing or deadlocking.
@@ -198,3 +221,61 @@ TEST(HeartbeatTest, LivePeerTriggersRejoinCallback) {
     srv.join();
     ::close(listen_fd);
 }
+
+// A live peer is pinged over one persistent connection, and its RTT is
+// recorded.
+TEST(HeartbeatTest, ReusesConnectionAndRecordsRtt) {
+    uint16_t port = 0;
+    int listen_fd = start_pong_server(port);
+
+    std::atomic<bool> srv_running{true};
+    std::thread srv([&] { run_persistent_pong_server(listen_fd, srv_running); });
+
+    Membership m;
+    m.add_peer(1, "127.0.0.1:" + std::to_string(port));
+
+    Heartbeat hb(m, /*node_id=*/99, /*interval_ms=*/30, /*timeout_ms=*/200);
+    hb.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    hb.stop();
+
+    auto s = hb.stats();
+    EXPECT_GE(s.rounds, 4u);
+    EXPECT_EQ(s.connects, 1u);
+    EXPECT_EQ(s.failures, 0u);
+    auto peers = m.all_peers();
+    ASSERT_EQ(peers.size(), 1u);
+    EXPECT_GT(peers[0].srtt_us, 0u);
+    EXPECT_EQ(m.get_state(1), NodeState::UP);
+
+    srv_running.store(false);
+    srv.join();
+    ::close(listen_fd);
+}
+
+// Peers that accept but never answer are probed in parallel: one round
+// takes about one timeout, not one timeout per peer.
+TEST(HeartbeatTest, SilentPeersCostOneTimeoutPerRound) {
+    uint16_t port = 0;
+    int listen_fd = start_pong_server(port);  // never accepts: connects queue
+
+    Membership m(2, 60000);
+    for (uint32_t id = 1; id <= 8; id++) {
+        m.add_peer(id, "127.0.0.1:" + std::to_string(port));
+    }
+
+    Heartbeat hb(m, /*node_id=*/99, /*interval_ms=*/10, /*timeout_ms=*/100);
+    hb.start();
+    // Sequential probing would need 8 * 100ms for a single round.
+    std::this_thread::sleep_for(std::chrono::milliseconds(450));
+    hb.stop();
+
+    auto s = hb.stats();
+    EXPECT_GE(s.rounds, 2u);
+    EXPECT_LT(s.last_round_us, 300000u);
+    for (uint32_t id = 1; id <= 8; id++) {
+        EXPECT_EQ(m.get_state(id), NodeState::SUSPECTED) << id;
+    }
+
+    ::close(listen_fd);
+}
@@ -5,7 +5,9 @@
 
 #include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <string>
+#include <thread>
 
 // ---------------------------------------------------------------------------
 // HintStore unit tests: in-memory operations + disk persistence / recovery
@@ -250,3 +252,259 @@ TEST(HintStore, HintFieldsRoundTrip) {
     EXPECT_EQ(hints[0].version.node_id,      nid);
     EXPECT_FALSE(hints[0].is_del);
 }
+
+// ── Coalescing and streamed replay ───────────────────────────────────────────
+
+TEST(HintStore, CoalescesByKeyToLatestVersion) {
+    dkv::HintStore store;
+
+    store.store(make_hint(2, "h:7002", "hot", "v1", false, 100, 1));
+    store.store(make_hint(2, "h:7002", "hot", "v3", false, 300, 1));
+    store.store(make_hint(2, "h:7002", "hot", "v2", false, 200, 1));  // older
+    store.store(make_hint(2, "h:7002", "cold", "c", false, 150, 1));
+    store.store(make_hint(2, "h:7002", "hot", "",  true,  400, 1));   // delete
+
+    auto hints = store.get_hints_for(2);
+    ASSERT_EQ(hints.size(), 2u);
+    EXPECT_EQ(hints[0].key, "cold");
+    EXPECT_EQ(hints[1].key, "hot");
+    EXPECT_TRUE(hints[1].is_del);
+    EXPECT_EQ(hints[1].version.timestamp_ms, 400u);
+    EXPECT_EQ(store.size(), 2u);
+    EXPECT_EQ(store.stats().coalesced, 3u);
+}
+
+TEST(HintStore, ReplayWindowsAndIndividualAcks) {
+    dkv::HintStore store;
+    for (int i = 0; i < 5; i++) {
+        store.store(make_hint(2, "h:7002", "k" + std::to_string(i), "v",
+                              false, 100 + i, 1));
+    }
+
+    ASSERT_TRUE(store.begin_replay(2));
+    EXPECT_FALSE(store.begin_replay(2));  // one replay per target
+
+    uint64_t next = 0;
+    auto first = store.next_for_replay(2, 0, 3, next);
+    ASSERT_EQ(first.size(), 3u);
+    EXPECT_EQ(first[0].hint.key, "k0");
+
+    // k1 fails; k0 and k2 are delivered.
+    store.ack(2, {first[0].seq, first[2].seq});
+    EXPECT_EQ(store.size_for(2), 3u);
+
+    auto second = store.next_for_replay(2, next, 3, next);
+    ASSERT_EQ(second.size(), 2u);
+    EXPECT_EQ(second[0].hint.key, "k3");
+
+    // A new replay starts from the front and only sees what is left.
+    uint64_t again = 0;
+    auto retry = store.next_for_replay(2, 0, 10, again);
+    ASSERT_EQ(retry.size(), 3u);
+    EXPECT_EQ(retry[0].hint.key, "k1");
+    store.end_replay(2);
+    EXPECT_TRUE(store.begin_replay(2));
+}
+
+TEST(HintStore, CheckpointResumesAfterRestart) {
+    TempDir tmp("hint_ckpt");
+
+    {
+        dkv::HintStore store(tmp.path);
+        for (int i = 0; i < 4; i++) {
+            store.store(make_hint(6, "h:7006", "k" + std::to_string(i), "v",
+                                  false, 10 + i, 1));
+        }
+        store.flush();
+        uint64_t next = 0;
+        auto items = store.next_for_replay(6, 0, 4, next);
+        ASSERT_EQ(items.size(), 4u);
+        // k0, k1 and k3 delivered; k2 not.  The checkpoint can only move
+        // past the contiguous prefix (k0, k1).
+        store.ack(6, {items[0].seq, items[1].seq, items[3].seq});
+        EXPECT_EQ(store.size_for(6), 1u);
+    }
+
+    dkv::HintStore store2(tmp.path);
+    store2.load();
+    auto hints = store2.get_hints_for(6);
+    ASSERT_EQ(hints.size(), 2u);  // k2, plus k3 (delivered but past the checkpoint)
+    EXPECT_EQ(hints[0].key, "k2");
+
+    // Delivering the rest removes the files.
+    uint64_t next = 0;
+    auto items = store2.next_for_replay(6, 0, 10, next);
+    store2.ack(6, {items[0].seq, items[1].seq});
+    EXPECT_EQ(store2.size(), 0u);
+
+    dkv::HintStore store3(tmp.path);
+    store3.load();
+    EXPECT_EQ(store3.size(), 0u);
+    EXPECT_TRUE(std::filesystem::is_empty(tmp.path));
+}
+
+// ── Segmented log: bounds, compaction, recovery ──────────────────────────────
+
+TEST(HintStore, SizeCapDropsNewHints) {
+    dkv::HintStore::Options opts;
+    opts.max_bytes = 400;
+    dkv::HintStore store("", opts);
+
+    for (int i = 0; i < 20; i++) {
+        store.store(make_hint(2, "h:7002", "k" + std::to_string(i),
+                              std::string(32, 'x'), false, 100 + i, 1));
+    }
+    auto stats = store.stats();
+    EXPECT_GT(stats.dropped, 0u);
+    EXPECT_LE(stats.queued_bytes, 400u);
+    EXPECT_EQ(stats.pending + stats.dropped, 20u);
+    EXPECT_EQ(store.get_hints_for(2)[0].key, "k0");  // oldest are kept
+
+    // Other targets have their own budget.
+    store.store(make_hint(3, "h:7003", "k", "v", false, 1, 1));
+    EXPECT_EQ(store.size_for(3), 1u);
+}
+
+TEST(HintStore, OldHintsExpire) {
+    dkv::HintStore::Options opts;
+    opts.max_age_ms = 20;
+    dkv::HintStore store("", opts);
+
+    store.store(make_hint(2, "h:7002", "old", "v", false, 1, 1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    store.store(make_hint(2, "h:7002", "new", "v", false, 2, 1));
+
+    auto hints = store.get_hints_for(2);
+    ASSERT_EQ(hints.size(), 1u);
+    EXPECT_EQ(hints[0].key, "new");
+    EXPECT_EQ(store.stats().expired, 1u);
+}
+
+TEST(HintStore, CompactsWhenSupersededHintsDominate) {
+    TempDir tmp("hint_compact");
+    dkv::HintStore::Options opts;
+    opts.segment_bytes = 4096;
+    {
+        dkv::HintStore store(tmp.path, opts);
+        store.store(make_hint(2, "h:7002", "keep", "first", false, 1, 1));
+        for (int i = 0; i < 3000; i++) {
+            store.store(make_hint(2, "h:7002", "hot", "v" + std::to_string(i),
+                                  false, 10 + i, 1));
+        }
+        store.flush();
+        auto stats = store.stats();
+        EXPECT_GT(stats.compactions, 0u);
+        EXPECT_EQ(stats.pending, 2u);
+        EXPECT_LT(stats.segments, 30u);  // superseded records reclaimed
+    }
+
+    dkv::HintStore store2(tmp.path, opts);
+    store2.load();
+    auto hints = store2.get_hints_for(2);
+    ASSERT_EQ(hints.size(), 2u);
+    EXPECT_EQ(hints[0].key, "keep");
+    EXPECT_EQ(hints[0].value, "first");
+    EXPECT_EQ(hints[1].value, "v2999");
+}
+
+TEST(HintStore, RollsSegmentsAndReplaysFromThem) {
+    TempDir tmp("hint_segments");
+    dkv::HintStore::Options opts;
+    opts.segment_bytes    = 256;
+    opts.sync_interval_ms = 0;
+
+    dkv::HintStore store(tmp.path, opts);
+    for (int i = 0; i < 20; i++) {
+        store.store(make_hint(4, "h:7004", "k" + std::to_string(i),
+                              "value-" + std::to_string(i), false, 100 + i, 1));
+    }
+    store.flush();
+    EXPECT_GE(store.stats().segments, 4u);
+
+    // Deliver the first half: the segments holding only those go away.
+    uint64_t next = 0;
+    auto items = store.next_for_replay(4, 0, 10, next);
+    ASSERT_EQ(items.size(), 10u);
+    EXPECT_EQ(items[9].hint.value, "value-9");
+    std::vector<uint64_t> seqs;
+    for (const auto& it : items) seqs.push_back(it.seq);
+    const size_t before = store.stats().segments;
+    store.ack(4, seqs);
+    EXPECT_LT(store.stats().segments, before);
+
+    dkv::HintStore store2(tmp.path, opts);
+    store2.load();
+    auto hints = store2.get_hints_for(4);
+    ASSERT_EQ(hints.size(), 10u);
+    EXPECT_EQ(hints[0].key,   "k10");
+    EXPECT_EQ(hints[9].value, "value-19");
+}
+
+TEST(HintStore, LoadTruncatesTornTail) {
+    TempDir tmp("hint_torn");
+    {
+        dkv::HintStore store(tmp.path);
+        store.store(make_hint(2, "h:7002", "a", "va", false, 1, 1));
+        store.store(make_hint(2, "h:7002", "b", "vb", false, 2, 1));
+    }
+    // Simulate a crash mid-append.
+    std::string segment;
+    for (const auto& e : std::filesystem::directory_iterator(tmp.path)) {
+        segment = e.path().string();
+    }
+    {
+        std::ofstream f(segment, std::ios::binary | std::ios::app);
+        f << "\x40\x00\x00\x00garbage";
+    }
+
+    dkv::HintStore store2(tmp.path);
+    store2.load();
+    EXPECT_EQ(store2.size(), 2u);
+
+    // New hints land after the good records and survive another restart.
+    store2.store(make_hint(2, "h:7002", "c", "vc", false, 3, 1));
+    store2.flush();
+    dkv::HintStore store3(tmp.path);
+    store3.load();
+    auto hints = store3.get_hints_for(2);
+    ASSERT_EQ(hints.size(), 3u);
+    EXPECT_EQ(hints[2].value, "vc");
+}
+
+// store() only queues; the writer thread (or flush()) puts hints on disk, and
+// replay reads them whether or not they got there yet.
+TEST(HintStore, StoreQueuesAndTheWriterPersists) {
+    TempDir tmp("hint_writer");
+    dkv::HintStore store(tmp.path);
+    for (int i = 0; i < 100; i++) {
+        store.store(make_hint(2, "h:7002", "k" + std::to_string(i),
+                              "v" + std::to_string(i), false, 1 + i, 1));
+    }
+    uint64_t next = 0;
+    auto items = store.next_for_replay(2, 0, 200, next);
+    ASSERT_EQ(items.size(), 100u);
+    EXPECT_EQ(items[99].hint.value, "v99");
+
+    store.flush();
+    EXPECT_GE(store.stats().segments, 1u);
+    dkv::HintStore other(tmp.path);
+    other.load();
+    auto hints = other.get_hints_for(2);
+    ASSERT_EQ(hints.size(), 100u);
+    EXPECT_EQ(hints[42].value, "v42");
+}
+
+TEST(HintStore, CompactsInMemoryModeToo) {
+    dkv::HintStore store;
+    store.store(make_hint(2, "h:7002", "keep", "first", false, 1, 1));
+    for (int i = 0; i < 3000; i++) {
+        store.store(make_hint(2, "h:7002", "hot", "v" + std::to_string(i),
+                              false, 10 + i, 1));
+    }
+    store.flush();
+    EXPECT_GT(store.stats().compactions, 0u);
+    auto hints = store.get_hints_for(2);
+    ASSERT_EQ(hints.size(), 2u);
+    EXPECT_EQ(hints[0].value, "first");
+    EXPECT_EQ(hints[1].value, "v2999");
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include "utils/histogram.h"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using dkv::Histogram;
+
+TEST(Histogram, EmptyReportsZero) {
+    Histogram h;
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.min(), 0u);
+    EXPECT_EQ(h.max(), 0u);
+    EXPECT_EQ(h.percentile(50), 0u);
+    EXPECT_DOUBLE_EQ(h.mean(), 0.0);
+}
+
+TEST(Histogram, SmallValuesAreExact) {
+    Histogram h;
+    for (uint64_t v = 1; v <= 100; v++) h.record(v);
+    EXPECT_EQ(h.count(), 100u);
+    EXPECT_EQ(h.min(), 1u);
+    EXPECT_EQ(h.max(), 100u);
+    EXPECT_EQ(h.percentile(50), 50u);
+    EXPECT_EQ(h.percentile(99), 99u);
+    EXPECT_EQ(h.percentile(100), 100u);
+    EXPECT_DOUBLE_EQ(h.mean(), 50.5);
+}
+
+TEST(Histogram, LargeValuesWithinPrecision) {
+    Histogram h;
+    for (uint64_t v = 1; v <= 1'000'000; v += 7) h.record(v * 1000);
+    const double bound = 1.0 / (1 << h.precision_bits());
+    for (double p : {10.0, 50.0, 90.0, 99.0, 99.9}) {
+        const double exact = p / 100.0 * 1'000'000'000.0;
+        const double got   = static_cast<double>(h.percentile(p));
+        EXPECT_NEAR(got, exact, exact * bound + 7000) << "p" << p;
+    }
+    EXPECT_EQ(h.percentile(100), h.max());
+}
+
+TEST(Histogram, MemoryIsFixed) {
+    Histogram h;
+    const size_t buckets = h.bucket_count();
+    for (uint64_t v = 0; v < 100'000; v++) h.record(v * 997);
+    EXPECT_EQ(h.bucket_count(), buckets);
+    EXPECT_LT(buckets * sizeof(uint64_t), 64u << 10);
+}
+
+TEST(Histogram, ValuesAboveMaxSaturate) {
+    Histogram h(1 << 20);
+    h.record(uint64_t{1} << 30);
+    h.record(5);
+    EXPECT_EQ(h.max(), uint64_t{1} << 30);
+    EXPECT_EQ(h.percentile(100), uint64_t{1} << 30);
+    EXPECT_GE(h.percentile(99), uint64_t{1} << 20);
+    EXPECT_EQ(h.percentile(1), 5u);
+}
+
+TEST(Histogram, MergeMatchesSingleHistogram) {
+    Histogram all, a, b;
+    for (uint64_t v = 0; v < 10'000; v++) {
+        all.record(v * 31);
+        (v % 2 ? a : b).record(v * 31);
+    }
+    a.merge(b);
+    EXPECT_EQ(a.count(), all.count());
+    EXPECT_EQ(a.sum(), all.sum());
+    EXPECT_EQ(a.min(), all.min());
+    EXPECT_EQ(a.max(), all.max());
+    for (double p : {1.0, 50.0, 99.0, 99.99}) EXPECT_EQ(a.percentile(p), all.percentile(p));
+}
+
+TEST(Histogram, MergeAcrossShapes) {
+    Histogram coarse(1 << 20, 4), fine;
+    for (uint64_t v = 1; v <= 1000; v++) fine.record(v * 100);
+    coarse.merge(fine);
+    EXPECT_EQ(coarse.count(), 1000u);
+    EXPECT_EQ(coarse.max(), 100'000u);
+    EXPECT_NEAR(static_cast<double>(coarse.percentile(50)), 50'000.0, 50'000.0 / 16 + 100);
+}
+
+TEST(Histogram, ConcurrentRecordLosesNothing) {
+    Histogram h;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&h, t] {
+            for (uint64_t i = 0; i < 50'000; i++) h.record(i + static_cast<uint64_t>(t));
+        });
+    }
+    for (auto& th : threads) th.join();
+    EXPECT_EQ(h.count(), 200'000u);
+    uint64_t buckets = 0;
+    h.for_each_bucket([&](uint64_t, uint64_t, uint64_t c) { buckets += c; });
+    EXPECT_EQ(buckets, 200'000u);
+    EXPECT_EQ(h.min(), 0u);
+    EXPECT_EQ(h.max(), 50'002u);
+}
+
+TEST(Histogram, CopyAndReset) {
+    Histogram h;
+    h.record(42);
+    Histogram copy = h;
+    h.reset();
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.min(), 0u);
+    EXPECT_EQ(copy.count(), 1u);
+    EXPECT_EQ(copy.percentile(50), 42u);
+}
+
+TEST(Histogram, CsvAndJsonOutput) {
+    Histogram h;
+    h.record(10);
+    h.record(20);
+    h.record(20);
+
+    std::ostringstream csv;
+    h.write_csv(csv, 10.0);
+    EXPECT_EQ(csv.str(),
+              "value,percentile,count,total\n"
+              "1.000,33.333333,1,1\n"
+              "2.000,100.000000,2,3\n");
+
+    const std::string json = h.to_json(10.0);
+    EXPECT_NE(json.find("\"count\":3"), std::string::npos) << json;
+    EXPECT_NE(json.find("\"min\":1.000"), std::string::npos) << json;
+    EXPECT_NE(json.find("\"p50\":2.000"), std::string::npos) << json;
+    EXPECT_NE(json.find("\"max\":2.000"), std::string::npos) << json;
+}
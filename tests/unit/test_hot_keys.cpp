@@ -0,0 +1,174 @@
+#include "cluster/hot_keys.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dkv;
+
+// ---------------------------------------------------------------------------
+// HotKeyCache: heavy-hitter detection and the coordinator read cache
+// ---------------------------------------------------------------------------
+
+namespace {
+
+HotKeyCache::Options small_options() {
+    HotKeyCache::Options o;
+    o.capacity  = 4;
+    o.lease_ms  = 100;
+    o.top_k     = 8;
+    o.min_count = 4;
+    return o;
+}
+
+// Read `key` until the detector calls it hot; returns the last lookup.
+HotKeyCache::Lookup warm(HotKeyCache& cache, const std::string& key) {
+    HotKeyCache::Lookup l;
+    for (int i = 0; i < 16 && !l.hot; i++) l = cache.read(key);
+    return l;
+}
+
+}  // namespace
+
+TEST(HotKeyCache, FindsTheHeavyHittersOfASkewedStream) {
+    // zipf(1.1) over 100k keys: the first few ranks dominate.
+    const int keys = 100000;
+    std::vector<double> cdf(keys);
+    double sum = 0;
+    for (int i = 0; i < keys; i++) cdf[i] = sum += 1.0 / std::pow(i + 1, 1.1);
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> u(0, sum);
+
+    HotKeyCache cache;  // defaults: detect only
+    for (int i = 0; i < 200000; i++) {
+        size_t rank = std::lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin();
+        auto l = cache.read("k" + std::to_string(rank));
+        EXPECT_FALSE(l.hit);
+    }
+
+    auto top = cache.top(10);
+    ASSERT_EQ(top.size(), 10u);
+    int found = 0;
+    for (const auto& k : top) {
+        for (int r = 0; r < 10; r++) found += k.key == "k" + std::to_string(r);
+    }
+    EXPECT_GE(found, 9);
+    EXPECT_EQ(top.front().key, "k0");
+    EXPECT_GE(top.front().count, top.back().count);
+}
+
+TEST(HotKeyCache, ColdKeysAreNotCached) {
+    HotKeyCache cache(small_options());
+    auto l = cache.read("cold");
+    EXPECT_FALSE(l.hot);
+    cache.fill("cold", l.ticket, true, "v", Version{1, 1});  // callers skip this
+    EXPECT_TRUE(cache.top(8).empty());
+}
+
+TEST(HotKeyCache, ServesHotKeysForTheLease) {
+    HotKeyCache::Clock::time_point now{};
+    HotKeyCache cache(small_options());
+    cache.set_clock([&] { return now; });
+
+    auto l = warm(cache, "hot");
+    ASSERT_TRUE(l.hot);
+    cache.fill("hot", l.ticket, true, "v1", Version{10, 1});
+
+    auto hit = cache.read("hot");
+    EXPECT_TRUE(hit.hit);
+    EXPECT_TRUE(hit.found);
+    EXPECT_EQ(hit.value, "v1");
+
+    // Misses are cached too.
+    auto m = warm(cache, "gone");
+    cache.fill("gone", m.ticket, false, {}, Version{});
+    hit = cache.read("gone");
+    EXPECT_TRUE(hit.hit);
+    EXPECT_FALSE(hit.found);
+
+    now += std::chrono::milliseconds(150);
+    EXPECT_FALSE(cache.read("hot").hit);
+    EXPECT_GE(cache.stats().expirations, 1u);
+    EXPECT_EQ(cache.stats().hits, 2u);
+}
+
+TEST(HotKeyCache, WritesInvalidateByVersion) {
+    HotKeyCache cache(small_options());
+    auto l = warm(cache, "k");
+    cache.fill("k", l.ticket, true, "v2", Version{20, 1});
+
+    // An older write (e.g. a late replica write) leaves the entry alone.
+    cache.invalidate("k", Version{15, 2});
+    EXPECT_TRUE(cache.read("k").hit);
+
+    cache.invalidate("k", Version{30, 1});
+    EXPECT_FALSE(cache.read("k").hit);
+    EXPECT_EQ(cache.stats().invalidations, 1u);
+}
+
+TEST(HotKeyCache, ReadRacingAWriteDoesNotFill) {
+    HotKeyCache cache(small_options());
+    auto l = warm(cache, "k");
+    ASSERT_TRUE(l.hot);
+
+    // The write lands while the read is out at the replicas: whatever the
+    // read found may predate it.
+    cache.invalidate("k", Version{50, 1});
+    cache.fill("k", l.ticket, true, "old", Version{40, 1});
+    EXPECT_FALSE(cache.read("k").hit);
+    EXPECT_EQ(cache.stats().stale_fills, 1u);
+}
+
+TEST(HotKeyCache, CapacityEvictsAndDetectOnlyNeverCaches) {
+    HotKeyCache cache(small_options());
+    for (int i = 0; i < 6; i++) {
+        std::string key = "k" + std::to_string(i);
+        auto l = warm(cache, key);
+        cache.fill(key, l.ticket, true, "v", Version{1, 1});
+    }
+    EXPECT_EQ(cache.stats().cached, 4u);
+    EXPECT_EQ(cache.stats().evictions, 2u);
+
+    cache.set_cache(0, 100);
+    EXPECT_EQ(cache.stats().cached, 0u);
+    auto l = cache.read("k5");
+    EXPECT_FALSE(l.hit);
+    cache.fill("k5", l.ticket, true, "v", Version{1, 1});
+    EXPECT_FALSE(cache.read("k5").hit);
+}
+
+TEST(HotKeyCache, DecayForgetsKeysThatCooled) {
+    HotKeyCache::Options o = small_options();
+    o.decay_every = 64;
+    HotKeyCache cache(o);
+    warm(cache, "once-hot");
+    ASSERT_EQ(cache.top(8).size(), 1u);
+    for (int i = 0; i < 64 * 4; i++) cache.read("other" + std::to_string(i));
+    for (const auto& k : cache.top(8)) EXPECT_NE(k.key, "once-hot");
+}
+
+TEST(HotKeyCache, ReportRoundTrips) {
+    HotKeyCache cache(small_options());
+    auto l = warm(cache, "a key");
+    cache.fill("a key", l.ticket, true, "v", Version{1, 1});
+    warm(cache, "b");
+    cache.read("a key");
+
+    HotKeyCache::Stats stats;
+    std::vector<HotKeyCache::HotKey> keys;
+    ASSERT_TRUE(HotKeyCache::decode_report(cache.encode_report(10), stats, keys));
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.cached, 1u);
+    ASSERT_EQ(keys.size(), 2u);
+    EXPECT_EQ(keys[0].key, "a key");  // spaces survive the length prefix
+    EXPECT_TRUE(keys[0].cached);
+    EXPECT_EQ(keys[1].key, "b");
+    EXPECT_FALSE(keys[1].cached);
+
+    EXPECT_FALSE(HotKeyCache::decode_report("1 2 3", stats, keys));
+    EXPECT_FALSE(HotKeyCache::decode_report("0 0 0 0 0 0 0 0 1 5 0 9 x", stats, keys));
+}
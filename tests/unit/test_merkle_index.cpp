@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include "cluster/anti_entropy.h"
+#include "storage/merkle_index.h"
+#include "storage/storage_engine.h"
+#include "utils/murmurhash3.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// MerkleIndex unit tests: range/leaf layout and incremental maintenance
+// ---------------------------------------------------------------------------
+
+namespace {
+
+std::vector<uint64_t> test_tokens() {
+    return {1ull << 60, 1ull << 62, 1ull << 63, 3ull << 62};
+}
+
+std::vector<uint64_t> all_leaves(const dkv::MerkleIndex& index) {
+    std::vector<uint64_t> out;
+    for (uint32_t i = 0; i < index.leaf_count(); i++) out.push_back(index.leaf_hash(i));
+    return out;
+}
+
+}  // namespace
+
+TEST(MerkleIndex, PositionsMapToOwningRange) {
+    dkv::MerkleIndex index({160, 320, 1000});
+    ASSERT_EQ(index.range_count(), 3u);
+    ASSERT_EQ(index.leaf_count(), 3u * dkv::MerkleIndex::LEAVES_PER_RANGE);
+
+    // Same rule as HashRing: the first token strictly greater owns it.
+    EXPECT_EQ(index.range_of(50), 0u);
+    EXPECT_EQ(index.range_of(160), 1u);
+    EXPECT_EQ(index.range_of(319), 1u);
+    EXPECT_EQ(index.range_of(320), 2u);
+    EXPECT_EQ(index.range_of(1000), 0u);   // wraps
+    EXPECT_EQ(index.range_of(UINT64_MAX), 0u);
+
+    EXPECT_EQ(index.leaf_of(160), 16u);      // first leaf of range 1
+    EXPECT_EQ(index.leaf_of(175), 17u);      // 160 positions, 10 per leaf
+    EXPECT_EQ(index.leaf_of(319), 31u);      // last leaf of range 1
+    EXPECT_EQ(index.leaf_of(1000), 0u);      // start of the wrapping range
+    EXPECT_EQ(index.leaf_of(159), 15u);      // end of the wrapping range
+    for (uint32_t r = 0; r < 3; r++) {
+        EXPECT_EQ(index.range_of(index.range_position(r)), r);
+    }
+}
+
+TEST(MerkleIndex, SingleTokenCoversWholeRing) {
+    dkv::MerkleIndex index({12345});
+    EXPECT_EQ(index.leaf_of(12345), 0u);
+    EXPECT_EQ(index.leaf_of(12344), 15u);
+    EXPECT_EQ(index.leaf_of(0), 15u);
+}
+
+TEST(MerkleIndex, SameContentSameHashesRegardlessOfOrder) {
+    dkv::StorageEngine a, b;
+    a.attach_merkle(std::make_shared<dkv::MerkleIndex>(test_tokens()));
+    b.attach_merkle(std::make_shared<dkv::MerkleIndex>(test_tokens()));
+
+    for (int i = 0; i < 200; i++) {
+        a.set("k" + std::to_string(i), "v", dkv::Version{1, 1});
+    }
+    // b sees older versions first, then the same final state.
+    for (int i = 199; i >= 0; i--) {
+        b.set("k" + std::to_string(i), "old", dkv::Version{0, 9});
+        b.set("k" + std::to_string(i), "v", dkv::Version{1, 1});
+    }
+    EXPECT_EQ(all_leaves(*a.merkle()), all_leaves(*b.merkle()));
+
+    // One delete shows up in exactly one leaf.
+    a.del("k7", dkv::Version{2, 1});
+    auto la = all_leaves(*a.merkle());
+    auto lb = all_leaves(*b.merkle());
+    size_t differing = 0;
+    for (size_t i = 0; i < la.size(); i++) differing += la[i] != lb[i];
+    EXPECT_EQ(differing, 1u);
+
+    // Rejected (older) writes change nothing.
+    b.del("k7", dkv::Version{2, 1});
+    b.set("k7", "stale", dkv::Version{1, 5});
+    EXPECT_EQ(all_leaves(*a.merkle()), all_leaves(*b.merkle()));
+}
+
+TEST(MerkleIndex, AttachAfterWritesMatchesIncremental) {
+    dkv::StorageEngine live, late;
+    live.attach_merkle(std::make_shared<dkv::MerkleIndex>(test_tokens()));
+    for (int i = 0; i < 100; i++) {
+        std::string k = "key" + std::to_string(i);
+        live.set(k, "x", dkv::Version{10, 1});
+        late.set(k, "x", dkv::Version{10, 1});
+        if (i % 3 == 0) {
+            live.del(k, dkv::Version{11, 1});
+            late.del(k, dkv::Version{11, 1});
+        }
+    }
+    late.attach_merkle(std::make_shared<dkv::MerkleIndex>(test_tokens()));
+    EXPECT_EQ(all_leaves(*live.merkle()), all_leaves(*late.merkle()));
+}
+
+TEST(MerkleIndex, VersionsInLeavesListsOnlyThoseLeaves) {
+    dkv::StorageEngine engine;
+    auto index = std::make_shared<dkv::MerkleIndex>(test_tokens());
+    engine.attach_merkle(index);
+    engine.set("alpha", "1", dkv::Version{5, 2});
+    engine.set("beta", "2", dkv::Version{6, 2});
+    engine.del("gamma", dkv::Version{7, 2});
+
+    uint32_t leaf = index->leaf_of(dkv::murmurhash3("gamma"));
+    auto listed = engine.versions_in_leaves({leaf});
+    auto it = std::find_if(listed.begin(), listed.end(),
+                           [](const dkv::EntryVersion& e) { return e.key == "gamma"; });
+    ASSERT_NE(it, listed.end());
+    EXPECT_TRUE(it->is_tombstone);
+    EXPECT_EQ(it->version.timestamp_ms, 7u);
+    for (const auto& e : listed) {
+        EXPECT_EQ(index->leaf_of(dkv::murmurhash3(e.key)), leaf);
+    }
+}
+
+TEST(MerkleIndex, ServeRejectsOtherRings) {
+    dkv::StorageEngine engine;
+    dkv::Command cmd{};
+    cmd.type = dkv::CommandType::AEHASH;
+    EXPECT_EQ(dkv::AntiEntropy::serve(engine, cmd),
+              "-ERR ANTI_ENTROPY_DISABLED\n");
+
+    engine.attach_merkle(std::make_shared<dkv::MerkleIndex>(test_tokens()));
+    cmd.value = std::string(8, '\0') + std::string(1, '\1');  // fingerprint 0
+    EXPECT_EQ(dkv::AntiEntropy::serve(engine, cmd), "-ERR RING_MISMATCH\n");
+}
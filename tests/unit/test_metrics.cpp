@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include "utils/metrics.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using dkv::Metrics;
+
+// The registry is process-wide, so every test uses its own metric names.
+
+TEST(Metrics, CounterSumsAcrossThreads) {
+    dkv::Counter& c = Metrics::instance().counter("test_counter_threads_total", "test");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&c] {
+            for (int i = 0; i < 10'000; i++) c.add();
+        });
+    }
+    for (auto& th : threads) th.join();
+    EXPECT_EQ(c.value(), 80'000u);
+
+    // The same name and labels return the same counter.
+    EXPECT_EQ(&Metrics::instance().counter("test_counter_threads_total", "test"), &c);
+    EXPECT_NE(&Metrics::instance().counter("test_counter_threads_total", "test", "x=\"1\""), &c);
+}
+
+TEST(Metrics, LatencySnapshotMergesShards) {
+    dkv::LatencyMetric& l = Metrics::instance().latency("test_latency_seconds", "test");
+    std::vector<std::thread> threads;
+    for (int t = 1; t <= 4; t++) {
+        threads.emplace_back([&l, t] {
+            for (int i = 0; i < 1000; i++) l.record(std::chrono::microseconds(t * 100));
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    dkv::Histogram h = l.snapshot();
+    EXPECT_EQ(h.count(), 4000u);
+    EXPECT_EQ(h.min(), 100'000u);
+    EXPECT_EQ(h.max(), 400'000u);
+    EXPECT_NEAR(static_cast<double>(h.percentile(50)), 200'000.0, 200'000.0 / 32);
+}
+
+TEST(Metrics, RenderSamples) {
+    Metrics::instance().counter("test_render_total", "Requests", "cmd=\"GET\"").add(3);
+    Metrics::instance().latency("test_render_seconds", "Latency").record(
+        std::chrono::milliseconds(2));
+
+    const std::string plain = Metrics::instance().render();
+    EXPECT_NE(plain.find("test_render_total{cmd=\"GET\"} 3\n"), std::string::npos) << plain;
+    EXPECT_NE(plain.find("test_render_seconds{quantile=\"1\"} 0.002\n"), std::string::npos)
+        << plain;
+    EXPECT_NE(plain.find("test_render_seconds_sum 0.002\n"), std::string::npos) << plain;
+    EXPECT_NE(plain.find("test_render_seconds_count 1\n"), std::string::npos) << plain;
+    EXPECT_EQ(plain.find("# HELP"), std::string::npos);
+
+    const std::string prom = Metrics::instance().render(/*help=*/true);
+    EXPECT_NE(prom.find("# HELP test_render_total Requests\n"
+                        "# TYPE test_render_total counter\n"
+                        "test_render_total{cmd=\"GET\"} 3\n"),
+              std::string::npos)
+        << prom;
+    EXPECT_NE(prom.find("# TYPE test_render_seconds summary\n"), std::string::npos);
+}
+
+TEST(Metrics, GaugesAreSampledAndRemovable) {
+    double depth = 5;
+    Metrics::instance().set_gauge("test_gauge_depth", "Depth", [&depth] { return depth; });
+    EXPECT_NE(Metrics::instance().render().find("test_gauge_depth 5\n"), std::string::npos);
+    depth = 0.25;
+    EXPECT_NE(Metrics::instance().render().find("test_gauge_depth 0.25\n"), std::string::npos);
+
+    Metrics::instance().remove_gauge("test_gauge_depth");
+    EXPECT_EQ(Metrics::instance().render().find("test_gauge_depth"), std::string::npos);
+}
+
+TEST(Metrics, CounterCallbacksRenderAsCounters) {
+    uint64_t delivered = 12;
+    Metrics::instance().set_counter_callback("test_callback_total", "Delivered",
+                                             [&delivered] { return delivered; });
+    const std::string prom = Metrics::instance().render(/*help=*/true);
+    EXPECT_NE(prom.find("# TYPE test_callback_total counter\n"
+                        "test_callback_total 12\n"),
+              std::string::npos)
+        << prom;
+
+    Metrics::instance().remove_gauge("test_callback_total");  // wrong kind: kept
+    EXPECT_NE(Metrics::instance().render().find("test_callback_total 12\n"), std::string::npos);
+    Metrics::instance().remove_counter_callback("test_callback_total");
+    EXPECT_EQ(Metrics::instance().render().find("test_callback_total"), std::string::npos);
+}
+
+TEST(Metrics, OneTypePerName) {
+    Metrics::instance().counter("test_kind_total", "test");
+    EXPECT_THROW(Metrics::instance().latency("test_kind_total", "test"), std::logic_error);
+    EXPECT_THROW(Metrics::instance().set_gauge("test_kind_total", "test", [] { return 1.0; }),
+                 std::logic_error);
+}
@@ -2,6 +2,9 @@
 
 #include "network/protocol.h"
 
+#include <cstring>
+#include <deque>
+
 // ---------------------------------------------------------------------------
 // Parsing valid commands
 // ---------------------------------------------------------------------------
@@ -15,6 +18,133 @@ TEST(Protocol, ParsePing) {
     EXPECT_EQ(result.bytes_consumed, buf.size());
 }
 
+TEST(Protocol, ParseTopology) {
+    std::string buf = "TOPOLOGY\n";
+    auto result = dkv::try_parse(buf.data(), buf.size());
+
+    EXPECT_EQ(result.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(result.command.type, dkv::CommandType::TOPOLOGY);
+
+    std::string bin;
+    dkv::append_binary_frame(bin, dkv::BinaryOpcode::TOPOLOGY, 7);
+    auto parsed = dkv::try_parse_binary(bin.data(), bin.size());
+    ASSERT_EQ(parsed.status, dkv::ParseStatus::OK);
+    dkv::Command cmd;
+    std::string error;
+    ASSERT_TRUE(dkv::binary_frame_to_command(parsed.frame, cmd, error));
+    EXPECT_EQ(cmd.type, dkv::CommandType::TOPOLOGY);
+}
+
+TEST(Protocol, ParseHotKeys) {
+    std::string buf = "HOTKEYS\n";
+    auto result = dkv::try_parse(buf.data(), buf.size());
+    EXPECT_EQ(result.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(result.command.type, dkv::CommandType::HOTKEYS);
+
+    buf = "HOTKEYS 10\n";
+    EXPECT_EQ(dkv::try_parse(buf.data(), buf.size()).status, dkv::ParseStatus::ERROR);
+
+    std::string bin;
+    dkv::append_binary_frame(bin, dkv::BinaryOpcode::HOTKEYS, 3);
+    auto parsed = dkv::try_parse_binary(bin.data(), bin.size());
+    ASSERT_EQ(parsed.status, dkv::ParseStatus::OK);
+    dkv::Command cmd;
+    std::string error;
+    ASSERT_TRUE(dkv::binary_frame_to_command(parsed.frame, cmd, error));
+    EXPECT_EQ(cmd.type, dkv::CommandType::HOTKEYS);
+}
+
+TEST(Protocol, ParseStats) {
+    std::string buf = "STATS\n";
+    auto result = dkv::try_parse(buf.data(), buf.size());
+    EXPECT_EQ(result.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(result.command.type, dkv::CommandType::STATS);
+
+    buf = "STATS all\n";
+    EXPECT_EQ(dkv::try_parse(buf.data(), buf.size()).status, dkv::ParseStatus::ERROR);
+
+    std::string bin;
+    dkv::append_binary_frame(bin, dkv::BinaryOpcode::STATS, 4);
+    auto parsed = dkv::try_parse_binary(bin.data(), bin.size());
+    ASSERT_EQ(parsed.status, dkv::ParseStatus::OK);
+    dkv::Command cmd;
+    std::string error;
+    ASSERT_TRUE(dkv::binary_frame_to_command(parsed.frame, cmd, error));
+    EXPECT_EQ(cmd.type, dkv::CommandType::STATS);
+}
+
+TEST(Protocol, ParseMultiKeyCommands) {
+    std::string buf = "MSET 2 1 a 3 one 2 bb 0 \n";
+    auto result = dkv::try_parse(buf.data(), buf.size());
+    ASSERT_EQ(result.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(result.command.type, dkv::CommandType::MSET);
+
+    std::vector<dkv::MultiKeyArg> args;
+    ASSERT_TRUE(dkv::parse_multi_args(result.command.value, true, args));
+    ASSERT_EQ(args.size(), 2u);
+    EXPECT_EQ(args[0].key, "a");
+    EXPECT_EQ(args[0].value, "one");
+    EXPECT_EQ(args[1].key, "bb");
+    EXPECT_EQ(args[1].value, "");
+    EXPECT_EQ(dkv::format_multi_args({"a", "bb"}, {"one", ""}), "2 1 a 3 one 2 bb 0 ");
+
+    buf = "MGET " + dkv::format_multi_args({"k1", "k 2"}) + "\n";
+    result = dkv::try_parse(buf.data(), buf.size());
+    ASSERT_EQ(result.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(result.command.type, dkv::CommandType::MGET);
+    ASSERT_TRUE(dkv::parse_multi_args(result.command.value, false, args));
+    ASSERT_EQ(args.size(), 2u);
+    EXPECT_EQ(args[1].key, "k 2");
+
+    // Count disagrees with the list, empty list, trailing bytes, too many keys
+    for (std::string bad : {"MGET 2 1 a\n", "MGET 0\n", "MGET 1 1 ab\n",
+                            "MSET 1 1 a\n", "MGET 5000 1 a\n"}) {
+        EXPECT_EQ(dkv::try_parse(bad.data(), bad.size()).status,
+                  dkv::ParseStatus::ERROR) << bad;
+    }
+
+    // Binary: the same argument list travels in the value.
+    std::string bin;
+    dkv::append_binary_frame(bin, dkv::BinaryOpcode::MGET, 4, {}, {},
+                             dkv::format_multi_args({"x", "y"}));
+    auto parsed = dkv::try_parse_binary(bin.data(), bin.size());
+    ASSERT_EQ(parsed.status, dkv::ParseStatus::OK);
+    dkv::Command cmd;
+    std::string error;
+    ASSERT_TRUE(dkv::binary_frame_to_command(parsed.frame, cmd, error));
+    EXPECT_EQ(cmd.type, dkv::CommandType::MGET);
+    EXPECT_EQ(cmd.value, "2 1 x 1 y");
+
+    bin.clear();
+    dkv::append_binary_frame(bin, dkv::BinaryOpcode::MSET, 5, {}, {}, "1 1 x");
+    parsed = dkv::try_parse_binary(bin.data(), bin.size());
+    ASSERT_EQ(parsed.status, dkv::ParseStatus::OK);
+    EXPECT_FALSE(dkv::binary_frame_to_command(parsed.frame, cmd, error));
+}
+
+TEST(Protocol, MultiGetReplyRoundTrip) {
+    std::vector<dkv::MultiGetItem> items(3);
+    items[0].status = dkv::MultiGetItem::Status::FOUND;
+    items[0].value  = "a b";
+    items[1].status = dkv::MultiGetItem::Status::NOT_FOUND;
+    items[2].status = dkv::MultiGetItem::Status::FAILED;
+
+    std::string reply = dkv::format_multi_get(items);
+    EXPECT_EQ(reply, "$13 3 3 a b -1 -2\n");
+
+    std::vector<dkv::MultiGetItem> out;
+    ASSERT_TRUE(dkv::parse_multi_get(std::string_view(reply).substr(4, 13), out));
+    ASSERT_EQ(out.size(), 3u);
+    EXPECT_EQ(out[0].status, dkv::MultiGetItem::Status::FOUND);
+    EXPECT_EQ(out[0].value, "a b");
+    EXPECT_EQ(out[1].status, dkv::MultiGetItem::Status::NOT_FOUND);
+    EXPECT_EQ(out[2].status, dkv::MultiGetItem::Status::FAILED);
+
+    EXPECT_FALSE(dkv::parse_multi_get("2 -1", out));
+    EXPECT_FALSE(dkv::parse_multi_get("1 -3", out));
+    EXPECT_FALSE(dkv::parse_multi_get("1 5 abc", out));
+}
+
 TEST(Protocol, ParseGet) {
     std::string buf = "GET 5 hello\n";
     auto result = dkv::try_parse(buf.data(), buf.size());
@@ -247,6 +377,32 @@ TEST(Protocol, ParseRget) {
     EXPECT_EQ(result.bytes_consumed, buf.size());
 }
 
+TEST(Protocol, ParseRdigest) {
+    std::string buf = "RDIGEST 5 mykey\n";
+    auto result = dkv::try_parse(buf.data(), buf.size());
+
+    EXPECT_EQ(result.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(result.command.type, dkv::CommandType::RDIGEST);
+    EXPECT_EQ(result.command.key, "mykey");
+
+    // Binary form, and the empty versioned value it is answered with.
+    std::string frame;
+    dkv::append_binary_frame(frame, dkv::BinaryOpcode::RDIGEST, 3, {}, "mykey");
+    auto bin = dkv::try_parse_binary(frame.data(), frame.size());
+    ASSERT_EQ(bin.status, dkv::ParseStatus::OK);
+    dkv::Command cmd;
+    std::string err;
+    ASSERT_TRUE(dkv::binary_frame_to_command(bin.frame, cmd, err));
+    EXPECT_EQ(cmd.type, dkv::CommandType::RDIGEST);
+
+    auto parsed = dkv::parse_versioned_response(
+        dkv::format_versioned_value({}, 1234, 5));
+    EXPECT_TRUE(parsed.found);
+    EXPECT_TRUE(parsed.value.empty());
+    EXPECT_EQ(parsed.timestamp_ms, 1234u);
+    EXPECT_EQ(parsed.node_id, 5u);
+}
+
 TEST(Protocol, ParseRset) {
     // RSET <key_len> <key> <val_len> <value> <timestamp_ms> <node_id>
     std::string buf = "RSET 3 foo 3 bar 1700000000000 42\n";
@@ -355,3 +511,250 @@ TEST(Protocol, VersionedValueRoundTrip) {
     EXPECT_EQ(r.timestamp_ms, 999000111ULL);
     EXPECT_EQ(r.node_id, 5u);
 }
+
+// ---------------------------------------------------------------------------
+// Binary wire protocol
+// ---------------------------------------------------------------------------
+
+TEST(Protocol, BinaryParseSet) {
+    std::string buf;
+    dkv::append_binary_frame(buf, dkv::BinaryOpcode::SET, 42, {}, "foo", "bar\nbaz");
+
+    auto result = dkv::try_parse_binary(buf.data(), buf.size());
+    ASSERT_EQ(result.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(result.frame.opcode, dkv::BinaryOpcode::SET);
+    EXPECT_EQ(result.frame.request_id, 42u);
+    EXPECT_EQ(result.frame.key, "foo");
+    EXPECT_EQ(result.frame.value, "bar\nbaz");
+    EXPECT_EQ(result.bytes_consumed, buf.size());
+
+    // Zero-copy: the views point into the caller's buffer.
+    EXPECT_GE(result.frame.key.data(), buf.data());
+    EXPECT_LT(result.frame.key.data(), buf.data() + buf.size());
+}
+
+TEST(Protocol, BinaryIncompleteHeaderAndBody) {
+    std::string buf;
+    dkv::append_binary_frame(buf, dkv::BinaryOpcode::GET, 1, {}, "hello");
+
+    auto r1 = dkv::try_parse_binary(buf.data(), 5);
+    EXPECT_EQ(r1.status, dkv::ParseStatus::INCOMPLETE);
+
+    auto r2 = dkv::try_parse_binary(buf.data(), buf.size() - 1);
+    EXPECT_EQ(r2.status, dkv::ParseStatus::INCOMPLETE);
+}
+
+TEST(Protocol, BinaryTwoFramesInBuffer) {
+    std::string buf;
+    dkv::append_binary_frame(buf, dkv::BinaryOpcode::PING, 1);
+    dkv::append_binary_frame(buf, dkv::BinaryOpcode::DEL, 2, {}, "k");
+
+    auto r1 = dkv::try_parse_binary(buf.data(), buf.size());
+    ASSERT_EQ(r1.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(r1.frame.opcode, dkv::BinaryOpcode::PING);
+    EXPECT_EQ(r1.bytes_consumed, dkv::BINARY_HEADER_SIZE);
+
+    auto r2 = dkv::try_parse_binary(buf.data() + r1.bytes_consumed,
+                                    buf.size() - r1.bytes_consumed);
+    ASSERT_EQ(r2.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(r2.frame.opcode, dkv::BinaryOpcode::DEL);
+    EXPECT_EQ(r2.frame.request_id, 2u);
+    EXPECT_EQ(r2.frame.key, "k");
+}
+
+TEST(Protocol, BinaryBadMagicIsFatal) {
+    std::string buf(dkv::BINARY_HEADER_SIZE, '\0');
+    buf[0] = 'X';
+    auto result = dkv::try_parse_binary(buf.data(), buf.size());
+    EXPECT_EQ(result.status, dkv::ParseStatus::ERROR);
+    EXPECT_TRUE(result.fatal);
+    EXPECT_EQ(result.bytes_consumed, buf.size());
+}
+
+TEST(Protocol, BinaryOversizedValueIsFatal) {
+    std::string buf;
+    dkv::append_binary_frame(buf, dkv::BinaryOpcode::SET, 7, {}, "k", "v");
+    // Patch val_len to exceed the limit.
+    uint32_t huge = dkv::BINARY_MAX_VAL_LEN + 1;
+    std::memcpy(buf.data() + 12, &huge, 4);
+
+    auto result = dkv::try_parse_binary(buf.data(), buf.size());
+    EXPECT_EQ(result.status, dkv::ParseStatus::ERROR);
+    EXPECT_TRUE(result.fatal);
+}
+
+TEST(Protocol, BinaryUnknownOpcodeConsumesFrame) {
+    std::string buf;
+    dkv::append_binary_frame(buf, dkv::BinaryOpcode::GET, 9, {}, "key");
+    buf[1] = static_cast<char>(0x7F);
+
+    auto result = dkv::try_parse_binary(buf.data(), buf.size());
+    EXPECT_EQ(result.status, dkv::ParseStatus::ERROR);
+    EXPECT_FALSE(result.fatal);
+    EXPECT_EQ(result.bytes_consumed, buf.size());
+    EXPECT_EQ(result.frame.request_id, 9u);
+}
+
+TEST(Protocol, BinaryRsetToCommand) {
+    std::string buf;
+    dkv::append_binary_frame(buf, dkv::BinaryOpcode::RSET, 3,
+                             dkv::encode_version_extras(1700000000000ULL, 4),
+                             "rk", "rv");
+    auto result = dkv::try_parse_binary(buf.data(), buf.size());
+    ASSERT_EQ(result.status, dkv::ParseStatus::OK);
+
+    dkv::Command cmd;
+    std::string err;
+    ASSERT_TRUE(dkv::binary_frame_to_command(result.frame, cmd, err));
+    EXPECT_EQ(cmd.type, dkv::CommandType::RSET);
+    EXPECT_EQ(cmd.key, "rk");
+    EXPECT_EQ(cmd.value, "rv");
+    EXPECT_EQ(cmd.timestamp_ms, 1700000000000ULL);
+    EXPECT_EQ(cmd.node_id, 4u);
+}
+
+TEST(Protocol, BinaryRsetWithoutVersionRejected) {
+    std::string buf;
+    dkv::append_binary_frame(buf, dkv::BinaryOpcode::RSET, 3, {}, "rk", "rv");
+    auto result = dkv::try_parse_binary(buf.data(), buf.size());
+    ASSERT_EQ(result.status, dkv::ParseStatus::OK);
+
+    dkv::Command cmd;
+    std::string err;
+    EXPECT_FALSE(dkv::binary_frame_to_command(result.frame, cmd, err));
+    EXPECT_FALSE(err.empty());
+}
+
+TEST(Protocol, TextToBinaryResponses) {
+    // Parsed frames point into their buffers: keep every one alive.
+    std::deque<std::string> frames;
+    auto parse = [&frames](std::string s) {
+        frames.push_back(std::move(s));
+        return dkv::try_parse_binary(frames.back().data(), frames.back().size());
+    };
+
+    auto ok = parse(dkv::text_to_binary_response(1, dkv::format_ok()));
+    ASSERT_EQ(ok.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(ok.frame.opcode, dkv::BinaryOpcode::OK);
+    EXPECT_EQ(ok.frame.request_id, 1u);
+
+    auto val = parse(dkv::text_to_binary_response(2, dkv::format_value("a b\nc")));
+    ASSERT_EQ(val.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(val.frame.opcode, dkv::BinaryOpcode::VALUE);
+    EXPECT_EQ(val.frame.value, "a b\nc");
+
+    auto nf = parse(dkv::text_to_binary_response(3, dkv::format_not_found()));
+    EXPECT_EQ(nf.frame.opcode, dkv::BinaryOpcode::NOT_FOUND);
+
+    auto err = parse(dkv::text_to_binary_response(4, dkv::format_error("BOOM")));
+    EXPECT_EQ(err.frame.opcode, dkv::BinaryOpcode::ERROR);
+    EXPECT_EQ(err.frame.value, "BOOM");
+
+    auto pong = parse(dkv::text_to_binary_response(5, dkv::format_pong()));
+    EXPECT_EQ(pong.frame.opcode, dkv::BinaryOpcode::PONG);
+    EXPECT_EQ(pong.frame.flags, 0u);
+
+    auto busy = parse(dkv::text_to_binary_response(6, dkv::format_value("v"),
+                                                    dkv::BINARY_FLAG_BUSY));
+    ASSERT_EQ(busy.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(busy.frame.flags, dkv::BINARY_FLAG_BUSY);
+    EXPECT_EQ(busy.frame.value, "v");
+}
+
+TEST(Protocol, TextToBinaryVersionedValue) {
+    std::string text = dkv::format_versioned_value("vv", 123456ULL, 9);
+    std::string bin  = dkv::text_to_binary_response(11, text);
+
+    auto r = dkv::try_parse_binary(bin.data(), bin.size());
+    ASSERT_EQ(r.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(r.frame.opcode, dkv::BinaryOpcode::VALUE);
+    EXPECT_EQ(r.frame.value, "vv");
+
+    uint64_t ts = 0;
+    uint32_t node = 0;
+    ASSERT_TRUE(dkv::decode_version_extras(r.frame.extras, ts, node));
+    EXPECT_EQ(ts, 123456ULL);
+    EXPECT_EQ(node, 9u);
+}
+
+TEST(Protocol, BinaryResponseBackToText) {
+    const std::string texts[] = {
+        dkv::format_ok(), dkv::format_pong(), dkv::format_not_found(),
+        dkv::format_error("QUORUM_FAILED"), dkv::format_value("x y"),
+        dkv::format_versioned_value("vv", 42ULL, 3),
+    };
+    for (const auto& text : texts) {
+        std::string bin = dkv::text_to_binary_response(5, text);
+        auto r = dkv::try_parse_binary(bin.data(), bin.size());
+        ASSERT_EQ(r.status, dkv::ParseStatus::OK);
+        EXPECT_EQ(dkv::binary_response_to_text(r.frame), text);
+    }
+}
+
+TEST(Protocol, BinaryFwdToCommand) {
+    std::string buf;
+    dkv::append_binary_frame(buf, dkv::BinaryOpcode::FWD, 8,
+                             std::string(1, '\x02'), {}, "GET 1 k");
+    auto r = dkv::try_parse_binary(buf.data(), buf.size());
+    ASSERT_EQ(r.status, dkv::ParseStatus::OK);
+
+    dkv::Command cmd;
+    std::string err;
+    ASSERT_TRUE(dkv::binary_frame_to_command(r.frame, cmd, err));
+    EXPECT_EQ(cmd.type, dkv::CommandType::FWD);
+    EXPECT_EQ(cmd.hops_remaining, 2u);
+    EXPECT_EQ(cmd.inner_line, "GET 1 k");
+}
+
+// ---------------------------------------------------------------------------
+// Zero-copy view parsing
+// ---------------------------------------------------------------------------
+
+TEST(Protocol, ParseViewPointsIntoBuffer) {
+    std::string buf = "SET 5 mykey 5 hello\nGET 5 other\n";
+
+    auto r1 = dkv::try_parse_view(buf.data(), buf.size());
+    ASSERT_EQ(r1.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(r1.command.type, dkv::CommandType::SET);
+    EXPECT_EQ(r1.command.key, "mykey");
+    EXPECT_EQ(r1.command.value, "hello");
+    // Views alias the input buffer rather than owning copies
+    EXPECT_GE(r1.command.value.data(), buf.data());
+    EXPECT_LT(r1.command.value.data(), buf.data() + buf.size());
+
+    auto r2 = dkv::try_parse_view(buf.data() + r1.bytes_consumed,
+                                  buf.size() - r1.bytes_consumed);
+    ASSERT_EQ(r2.status, dkv::ParseStatus::OK);
+    EXPECT_EQ(r2.command.type, dkv::CommandType::GET);
+    EXPECT_EQ(r2.command.key, "other");
+    EXPECT_EQ(r1.bytes_consumed + r2.bytes_consumed, buf.size());
+}
+
+TEST(Protocol, ParseViewMatchesOwningParse) {
+    std::string buf = "RSET 1 k 3 abc 1700000000000 3\n";
+
+    auto view  = dkv::try_parse_view(buf.data(), buf.size());
+    auto owned = dkv::try_parse(buf.data(), buf.size());
+    ASSERT_EQ(view.status, dkv::ParseStatus::OK);
+    ASSERT_EQ(owned.status, dkv::ParseStatus::OK);
+
+    dkv::Command cmd = view.command.to_command();
+    EXPECT_EQ(cmd.type, owned.command.type);
+    EXPECT_EQ(cmd.key, owned.command.key);
+    EXPECT_EQ(cmd.value, owned.command.value);
+    EXPECT_EQ(cmd.timestamp_ms, owned.command.timestamp_ms);
+    EXPECT_EQ(cmd.node_id, owned.command.node_id);
+    EXPECT_EQ(view.bytes_consumed, owned.bytes_consumed);
+}
+
+TEST(Protocol, ParseViewIncompleteAndError) {
+    std::string partial = "SET 1 k 10 hel";
+    EXPECT_EQ(dkv::try_parse_view(partial.data(), partial.size()).status,
+              dkv::ParseStatus::INCOMPLETE);
+
+    std::string bad = "BOGUS\n";
+    auto r = dkv::try_parse_view(bad.data(), bad.size());
+    EXPECT_EQ(r.status, dkv::ParseStatus::ERROR);
+    EXPECT_EQ(r.bytes_consumed, bad.size());
+    EXPECT_FALSE(r.error_msg.empty());
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "network/read_buffer.h"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+using dkv::ReadBuffer;
+
+namespace {
+
+void append(ReadBuffer& buf, std::string_view bytes) {
+    char* dst = buf.prepare(bytes.size());
+    ASSERT_GE(buf.spare(), bytes.size());
+    std::memcpy(dst, bytes.data(), bytes.size());
+    buf.commit(bytes.size());
+}
+
+std::string contents(const ReadBuffer& buf) {
+    return std::string(buf.data(), buf.size());
+}
+
+}  // namespace
+
+TEST(ReadBuffer, AppendAndConsume) {
+    ReadBuffer buf;
+    EXPECT_TRUE(buf.empty());
+    append(buf, "hello ");
+    append(buf, "world");
+    EXPECT_EQ(contents(buf), "hello world");
+
+    buf.consume(6);
+    EXPECT_EQ(contents(buf), "world");
+    buf.consume(5);
+    EXPECT_TRUE(buf.empty());
+}
+
+TEST(ReadBuffer, ReusesConsumedSpaceBeforeGrowing) {
+    ReadBuffer buf;
+    buf.prepare(64);
+    const size_t cap = buf.capacity();
+    append(buf, std::string(cap - 8, 'a'));
+    buf.consume(cap - 16);              // 8 bytes left, at the back
+    append(buf, std::string(32, 'b'));  // fits once they move down
+    EXPECT_EQ(buf.capacity(), cap);
+    EXPECT_EQ(contents(buf), std::string(8, 'a') + std::string(32, 'b'));
+}
+
+TEST(ReadBuffer, ShrinksAfterALargeFrame) {
+    ReadBuffer buf;
+    append(buf, std::string(1 << 20, 'x'));
+    EXPECT_GE(buf.capacity(), 1u << 20);
+
+    buf.shrink(4096);  // still holds the frame
+    EXPECT_GE(buf.capacity(), 1u << 20);
+
+    buf.consume((1 << 20) - 10);
+    buf.shrink(4096);  // the tail fits: back to the small size
+    EXPECT_EQ(buf.capacity(), 4096u);
+    EXPECT_EQ(contents(buf), std::string(10, 'x'));
+
+    buf.consume(10);
+    buf.shrink(1024);  // drained: the storage goes
+    EXPECT_EQ(buf.capacity(), 0u);
+    append(buf, "again");
+    EXPECT_EQ(contents(buf), "again");
+}
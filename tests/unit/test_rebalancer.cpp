@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include "cluster/hash_ring.h"
+#include "cluster/rebalancer.h"
+#include "utils/murmurhash3.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Rebalancer: transfer planning and wire formats
+// ---------------------------------------------------------------------------
+
+namespace {
+
+bool has_node(dkv::ReplicaList nodes, uint32_t id) {
+    return std::any_of(nodes.begin(), nodes.end(),
+                       [id](const dkv::NodeInfo& n) { return n.node_id == id; });
+}
+
+/// The transfer covering `pos` with `target`, or nullptr.
+const dkv::Rebalancer::Transfer* covering(
+    const std::vector<dkv::Rebalancer::Transfer>& plan, uint64_t pos, uint32_t target) {
+    for (const auto& t : plan) {
+        if (t.target.node_id == target && t.range.contains(pos)) return &t;
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+TEST(Rebalancer, PlanCoversExactlyTheGainedPositions) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:7001", 64);
+    ring.add_node(2, "127.0.0.1:7002", 64);
+    ring.add_node(3, "127.0.0.1:7003", 64);
+    ASSERT_TRUE(ring.stage_add(4, "127.0.0.1:7004", 64));
+    const auto& from = ring.snapshot();
+    const auto& to   = *ring.pending();
+
+    auto plan = dkv::Rebalancer::plan(from, to, 2);
+    ASSERT_FALSE(plan.empty());
+    for (const auto& t : plan) {
+        EXPECT_EQ(t.target.node_id, 4u);  // only the new node gains
+        EXPECT_EQ(t.sources.size(), 2u);
+        EXPECT_FALSE(has_node(t.sources, 4));
+    }
+    // Merged: fewer transfers than the new node has tokens times N.
+    EXPECT_LE(plan.size(), 2u * 64u);
+
+    for (int i = 0; i < 5000; i++) {
+        uint64_t pos = dkv::murmurhash3("key:" + std::to_string(i));
+        bool gains = has_node(to.replicas_at(pos, 2), 4);
+        const auto* t = covering(plan, pos, 4);
+        ASSERT_EQ(t != nullptr, gains) << pos;
+        if (!t) continue;
+        // The sources are the current replicas of every covered position.
+        auto current = from.replicas_at(pos, 2);
+        ASSERT_EQ(current.size(), t->sources.size());
+        for (size_t r = 0; r < current.size(); r++) {
+            EXPECT_EQ(current[r].node_id, t->sources[r].node_id);
+        }
+    }
+}
+
+TEST(Rebalancer, PlanForRemovalSendsRangesToNewReplicas) {
+    dkv::HashRing ring;
+    for (uint32_t id = 1; id <= 4; id++) {
+        ring.add_node(id, "127.0.0.1:700" + std::to_string(id), 64);
+    }
+    ASSERT_TRUE(ring.stage_remove(2));
+    const auto& from = ring.snapshot();
+    const auto& to   = *ring.pending();
+
+    auto plan = dkv::Rebalancer::plan(from, to, 3);
+    ASSERT_FALSE(plan.empty());
+    for (const auto& t : plan) {
+        EXPECT_NE(t.target.node_id, 2u);
+        EXPECT_TRUE(has_node(t.sources, 2));  // the leaving node held it
+    }
+    for (int i = 0; i < 5000; i++) {
+        uint64_t pos = dkv::murmurhash3("key:" + std::to_string(i));
+        for (const auto& n : to.replicas_at(pos, 3)) {
+            bool gained = !has_node(from.replicas_at(pos, 3), n.node_id);
+            ASSERT_EQ(covering(plan, pos, n.node_id) != nullptr, gained);
+        }
+    }
+}
+
+TEST(Rebalancer, ChunkRoundTripAndCorruption) {
+    std::vector<std::pair<std::string, dkv::ValueEntry>> entries;
+    entries.emplace_back("a", dkv::ValueEntry{false, "alpha", {100, 1}});
+    entries.emplace_back("b", dkv::ValueEntry{true, "", {200, 2}});
+    entries.emplace_back(std::string("c\0d", 3), dkv::ValueEntry{false, std::string(3000, 'x'), {300, 3}});
+
+    std::string chunk = dkv::Rebalancer::encode_chunk(entries, true);
+    std::vector<std::pair<std::string, dkv::ValueEntry>> out;
+    bool more = false;
+    ASSERT_TRUE(dkv::Rebalancer::decode_chunk(chunk, out, more));
+    EXPECT_TRUE(more);
+    ASSERT_EQ(out.size(), 3u);
+    EXPECT_EQ(out[0].second.value, "alpha");
+    EXPECT_TRUE(out[1].second.is_tombstone);
+    EXPECT_EQ(out[1].second.version.timestamp_ms, 200u);
+    EXPECT_EQ(out[2].first, std::string("c\0d", 3));
+    EXPECT_EQ(out[2].second.version.node_id, 3u);
+
+    std::string flipped = chunk;
+    flipped[flipped.size() / 2] ^= 0x01;
+    EXPECT_FALSE(dkv::Rebalancer::decode_chunk(flipped, out, more));
+    EXPECT_FALSE(dkv::Rebalancer::decode_chunk(chunk.substr(0, chunk.size() - 1),
+                                               out, more));
+
+    ASSERT_TRUE(dkv::Rebalancer::decode_chunk(dkv::Rebalancer::encode_chunk({}, false),
+                                              out, more));
+    EXPECT_TRUE(out.empty());
+    EXPECT_FALSE(more);
+}
+
+TEST(Rebalancer, RingChangesAreStagedAndCommitted) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:7001", 32);
+    dkv::StorageEngine engine;
+    dkv::RpcClient rpc;
+    std::vector<uint32_t> committed;
+    dkv::Rebalancer rebalancer(
+        engine, ring, rpc, 1, 1,
+        [](const std::string&, const std::string&, bool, const dkv::Version&) {},
+        [&](const dkv::Rebalancer::Change& c) { committed.push_back(c.node_id); },
+        nullptr, dkv::Rebalancer::Options{});
+
+    dkv::Rebalancer::Change add{true, 2, "127.0.0.1:7002", 32};
+    dkv::Command cmd{};
+    cmd.type  = dkv::CommandType::RING;
+    cmd.value = dkv::Rebalancer::encode_ring("STAGE", add);
+    EXPECT_EQ(cmd.value, "STAGE ADD 2 127.0.0.1:7002 32");
+    EXPECT_EQ(rebalancer.serve(cmd), "+OK\n");
+    ASSERT_NE(ring.pending(), nullptr);
+    EXPECT_EQ(ring.node_count(), 1u);
+
+    cmd.value = dkv::Rebalancer::encode_ring("COMMIT", add);
+    EXPECT_EQ(rebalancer.serve(cmd), "+OK\n");
+    EXPECT_EQ(ring.pending(), nullptr);
+    EXPECT_EQ(ring.node_count(), 2u);
+    EXPECT_EQ(committed, std::vector<uint32_t>{2});
+    // A repeated COMMIT is acknowledged without doing anything.
+    EXPECT_EQ(rebalancer.serve(cmd), "+OK\n");
+    EXPECT_EQ(committed.size(), 1u);
+
+    cmd.value = "STAGE MOVE 2";
+    EXPECT_EQ(rebalancer.serve(cmd), "-ERR BAD_RING_CHANGE\n");
+
+    dkv::Rebalancer::Change remove{false, 2, {}, 0};
+    cmd.value = dkv::Rebalancer::encode_ring("STAGE", remove);
+    EXPECT_EQ(rebalancer.serve(cmd), "+OK\n");
+    cmd.value = dkv::Rebalancer::encode_ring("ABORT", remove);
+    EXPECT_EQ(rebalancer.serve(cmd), "+OK\n");
+    EXPECT_EQ(ring.pending(), nullptr);
+    EXPECT_EQ(ring.node_count(), 2u);
+
+    // A node that lost the staged change (e.g. restarted) applies COMMIT
+    // directly, so a lagging node catches up on the driver's retry...
+    cmd.value = dkv::Rebalancer::encode_ring("COMMIT", remove);
+    EXPECT_EQ(rebalancer.serve(cmd), "+OK\n");
+    EXPECT_EQ(ring.node_count(), 1u);
+    EXPECT_EQ(committed, (std::vector<uint32_t>{2, 2}));
+
+    // ...but never over a different change it has staged.
+    dkv::Rebalancer::Change add3{true, 3, "127.0.0.1:7003", 32};
+    cmd.value = dkv::Rebalancer::encode_ring("STAGE", add3);
+    EXPECT_EQ(rebalancer.serve(cmd), "+OK\n");
+    cmd.value = dkv::Rebalancer::encode_ring("COMMIT", add);
+    EXPECT_NE(rebalancer.serve(cmd), "+OK\n");
+    EXPECT_EQ(ring.node_count(), 1u);
+    ASSERT_NE(ring.pending(), nullptr);
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include "replication/repair_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// RepairQueue unit tests: dedup, per-target batching, memory cap, pacing
+// ---------------------------------------------------------------------------
+
+namespace {
+
+dkv::NodeInfo node(uint32_t id) {
+    return dkv::NodeInfo{id, "127.0.0.1:" + std::to_string(9000 + id)};
+}
+
+std::shared_ptr<const std::string> val(const std::string& s) {
+    return std::make_shared<const std::string>(s);
+}
+
+/// Records every batch; blocks the worker on its first call until open().
+struct GatedSender {
+    struct Call {
+        uint32_t                     target;
+        std::vector<dkv::RepairItem> batch;
+    };
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    bool                    gate_open = false;
+    bool                    entered   = false;
+    std::vector<Call>       calls;
+    size_t                  fail_target = 0;  // node id whose sends fail
+
+    dkv::RepairQueue::Sender sender() {
+        return [this](const dkv::NodeInfo& target,
+                      const std::vector<dkv::RepairItem>& batch) -> size_t {
+            std::unique_lock<std::mutex> lock(mutex);
+            entered = true;
+            cv.notify_all();
+            cv.wait(lock, [this]() { return gate_open; });
+            calls.push_back(Call{target.node_id, batch});
+            return target.node_id == fail_target ? 0 : batch.size();
+        };
+    }
+
+    void wait_entered() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return entered; });
+    }
+
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex);
+        gate_open = true;
+        cv.notify_all();
+    }
+};
+
+/// Park the worker inside the sender so later enqueues accumulate.
+void park_worker(dkv::RepairQueue& queue, GatedSender& gate) {
+    queue.enqueue(node(99), "parked", val("p"), dkv::Version{1, 1});
+    gate.wait_entered();
+}
+
+}  // namespace
+
+TEST(RepairQueue, DeduplicatesByKeyKeepingNewestVersion) {
+    GatedSender gate;
+    dkv::RepairQueue queue(gate.sender());
+    park_worker(queue, gate);
+
+    queue.enqueue(node(1), "hot", val("v2"), dkv::Version{200, 1});
+    queue.enqueue(node(1), "hot", val("v1"), dkv::Version{100, 1});  // older
+    queue.enqueue(node(1), "hot", val("v3"), dkv::Version{300, 1});
+    queue.enqueue(node(2), "hot", val("v3"), dkv::Version{300, 1});  // other target
+
+    auto s = queue.stats();
+    EXPECT_EQ(s.depth, 2u);
+    EXPECT_EQ(s.deduplicated, 2u);
+
+    gate.open();
+    queue.stop();
+
+    ASSERT_EQ(gate.calls.size(), 3u);  // parked + one per target
+    for (const auto& call : gate.calls) {
+        if (call.target != 1) continue;
+        ASSERT_EQ(call.batch.size(), 1u);
+        EXPECT_EQ(*call.batch[0].value, "v3");
+        EXPECT_EQ(call.batch[0].version.timestamp_ms, 300u);
+    }
+    EXPECT_EQ(queue.stats().repaired, 3u);
+    EXPECT_EQ(queue.stats().depth, 0u);
+}
+
+TEST(RepairQueue, BatchesPerTargetUpToBatchMax) {
+    GatedSender gate;
+    dkv::RepairQueue::Options opts;
+    opts.batch_max = 4;
+    dkv::RepairQueue queue(gate.sender(), opts);
+    park_worker(queue, gate);
+
+    for (int i = 0; i < 10; i++) {
+        queue.enqueue(node(1), "a" + std::to_string(i), val("x"),
+                      dkv::Version{1, 1});
+    }
+    for (int i = 0; i < 3; i++) {
+        queue.enqueue(node(2), "b" + std::to_string(i), val("y"),
+                      dkv::Version{1, 1});
+    }
+
+    gate.open();
+    queue.stop();
+
+    std::vector<std::pair<uint32_t, size_t>> sizes;
+    for (const auto& call : gate.calls) {
+        if (call.target == 99) continue;
+        for (const auto& item : call.batch) {
+            EXPECT_EQ(item.key[0], call.target == 1 ? 'a' : 'b');
+        }
+        sizes.emplace_back(call.target, call.batch.size());
+    }
+    // Round-robin between the two replicas, at most 4 repairs per send.
+    std::vector<std::pair<uint32_t, size_t>> expected = {
+        {1, 4}, {2, 3}, {1, 4}, {1, 2}};
+    EXPECT_EQ(sizes, expected);
+    // FIFO within a target.
+    EXPECT_EQ(gate.calls[1].batch[0].key, "a0");
+}
+
+TEST(RepairQueue, MemoryCapDropsExcess) {
+    GatedSender gate;
+    dkv::RepairQueue::Options opts;
+    opts.max_bytes = 100;
+    dkv::RepairQueue queue(gate.sender(), opts);
+    park_worker(queue, gate);
+
+    // 1 + 40 bytes each: two fit, the third does not.
+    EXPECT_TRUE(queue.enqueue(node(1), "a", val(std::string(40, 'x')), {1, 1}));
+    EXPECT_TRUE(queue.enqueue(node(1), "b", val(std::string(40, 'x')), {1, 1}));
+    EXPECT_FALSE(queue.enqueue(node(1), "c", val(std::string(40, 'x')), {1, 1}));
+
+    auto s = queue.stats();
+    EXPECT_EQ(s.depth, 2u);
+    EXPECT_EQ(s.queued_bytes, 82u);
+    EXPECT_EQ(s.dropped, 1u);
+
+    gate.open();
+    queue.stop();
+    EXPECT_EQ(queue.stats().queued_bytes, 0u);
+}
+
+TEST(RepairQueue, RateLimitPacesSends) {
+    std::atomic<int> sent{0};
+    dkv::RepairQueue::Options opts;
+    opts.rate_bytes_per_sec = 100000;
+    opts.batch_max          = 1;
+    dkv::RepairQueue queue(
+        [&](const dkv::NodeInfo&, const std::vector<dkv::RepairItem>& batch) {
+            sent += static_cast<int>(batch.size());
+            return batch.size();
+        },
+        opts);
+
+    // 5 x ~50 KB against 100 KB/s with a one-second burst: three go at
+    // once, the other two wait about 0.5 s each.
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 5; i++) {
+        queue.enqueue(node(1), "k" + std::to_string(i),
+                      val(std::string(50000, 'x')), {1, 1});
+    }
+    while (sent.load() < 5 &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(sent.load(), 5);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(800));
+}
+
+TEST(RepairQueue, FailedSendsAreCounted) {
+    GatedSender gate;
+    gate.fail_target = 2;
+    dkv::RepairQueue queue(gate.sender());
+    park_worker(queue, gate);
+
+    queue.enqueue(node(1), "ok", val("v"), {1, 1});
+    queue.enqueue(node(2), "lost", val("v"), {1, 1});
+
+    gate.open();
+    queue.stop();
+
+    auto s = queue.stats();
+    EXPECT_EQ(s.enqueued, 3u);
+    EXPECT_EQ(s.repaired, 2u);
+    EXPECT_EQ(s.failed, 1u);
+}
@@ -0,0 +1,870 @@
+#include <gtest/gtest.h>
+
+#include "cluster/connection_pool.h"
+#include "cluster/coordinator.h"
+#include "cluster/gossip.h"
+#include "cluster/hash_ring.h"
+#include "cluster/rebalancer.h"
+#include "cluster/rpc_client.h"
+#include "network/protocol.h"
+#include "network/tcp_server.h"
+#include "storage/storage_engine.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// RpcClient tests: multiplexing against a real server, failure statuses
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr uint16_t SERVER_PORT = 19890;
+constexpr uint16_t SILENT_PORT = 19891;
+constexpr uint16_t REPLICA_PORT = 19892;
+
+std::string addr(uint16_t port) {
+    return "127.0.0.1:" + std::to_string(port);
+}
+
+/// A listener that accepts connections (via the kernel backlog) but never
+/// reads or replies — every request to it times out.
+class SilentListener {
+public:
+    explicit SilentListener(uint16_t port) {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in a{};
+        a.sin_family      = AF_INET;
+        a.sin_port        = htons(port);
+        a.sin_addr.s_addr = inet_addr("127.0.0.1");
+        ok_ = ::bind(fd_, reinterpret_cast<struct sockaddr*>(&a), sizeof(a)) == 0 &&
+              ::listen(fd_, 16) == 0;
+    }
+    ~SilentListener() { ::close(fd_); }
+    bool ok() const { return ok_; }
+
+private:
+    int  fd_ = -1;
+    bool ok_ = false;
+};
+
+/// Runs a TCPServer on a background thread for the lifetime of the object.
+class ServerRunner {
+public:
+    explicit ServerRunner(std::unique_ptr<dkv::TCPServer> server)
+        : server_(std::move(server)),
+          thread_([this]() { server_->run(); }) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ~ServerRunner() {
+        server_->stop();
+        thread_.join();
+    }
+
+private:
+    std::unique_ptr<dkv::TCPServer> server_;
+    std::thread                     thread_;
+};
+
+}  // namespace
+
+TEST(RpcClient, SetThenGetRoundTrip) {
+    dkv::StorageEngine engine;
+    ServerRunner server(std::make_unique<dkv::TCPServer>(engine, SERVER_PORT, 2));
+    dkv::RpcClient rpc(1000);
+
+    auto set = rpc.call_sync(addr(SERVER_PORT), dkv::BinaryOpcode::SET, {},
+                             "k", "value");
+    EXPECT_EQ(set.status, dkv::RpcStatus::OK);
+    EXPECT_EQ(set.opcode, dkv::BinaryOpcode::OK);
+
+    auto get = rpc.call_sync(addr(SERVER_PORT), dkv::BinaryOpcode::GET, {}, "k");
+    EXPECT_TRUE(get.ok());
+    EXPECT_EQ(get.opcode, dkv::BinaryOpcode::VALUE);
+    EXPECT_EQ(get.value, "value");
+
+    auto missing = rpc.call_sync(addr(SERVER_PORT), dkv::BinaryOpcode::GET, {},
+                                 "nope");
+    EXPECT_EQ(missing.opcode, dkv::BinaryOpcode::NOT_FOUND);
+}
+
+TEST(RpcClient, ManyConcurrentCallsAreMultiplexed) {
+    dkv::StorageEngine engine;
+    ServerRunner server(std::make_unique<dkv::TCPServer>(engine, SERVER_PORT, 2));
+    dkv::RpcClient rpc(2000);
+
+    constexpr int THREADS = 4;
+    constexpr int PER_THREAD = 250;
+    std::atomic<int> ok{0};
+    std::atomic<int> done{0};
+    std::mutex mu;
+    std::condition_variable cv;
+
+    std::vector<std::thread> callers;
+    for (int t = 0; t < THREADS; t++) {
+        callers.emplace_back([&, t]() {
+            for (int i = 0; i < PER_THREAD; i++) {
+                std::string key = "k" + std::to_string(t) + "_" + std::to_string(i);
+                rpc.call(addr(SERVER_PORT), dkv::BinaryOpcode::SET, {}, key, key,
+                         [&](dkv::RpcResult r) {
+                             if (r.ok()) ok.fetch_add(1);
+                             if (done.fetch_add(1) + 1 == THREADS * PER_THREAD) {
+                                 std::lock_guard lock(mu);
+                                 cv.notify_one();
+                             }
+                         });
+            }
+        });
+    }
+    for (auto& c : callers) c.join();
+
+    {
+        std::unique_lock lock(mu);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(10), [&]() {
+            return done.load() == THREADS * PER_THREAD;
+        }));
+    }
+    EXPECT_EQ(ok.load(), THREADS * PER_THREAD);
+    EXPECT_TRUE(engine.get("k0_0").found);
+    EXPECT_TRUE(engine.get("k3_249").found);
+}
+
+TEST(RpcClient, ConnectRefusedFails) {
+    dkv::RpcClient rpc(500);
+    // Nothing listens on port 1 on the loopback interface.
+    auto r = rpc.call_sync("127.0.0.1:1", dkv::BinaryOpcode::PING);
+    EXPECT_EQ(r.status, dkv::RpcStatus::CONNECT_FAILED);
+    EXPECT_FALSE(r.ok());
+}
+
+TEST(RpcClient, InvalidAddressFails) {
+    dkv::RpcClient rpc(500);
+    auto r = rpc.call_sync("not-an-address", dkv::BinaryOpcode::PING);
+    EXPECT_EQ(r.status, dkv::RpcStatus::CONNECT_FAILED);
+}
+
+TEST(RpcClient, SilentPeerTimesOut) {
+    SilentListener peer(SILENT_PORT);
+    ASSERT_TRUE(peer.ok());
+    dkv::RpcClient rpc(100);
+
+    auto start = std::chrono::steady_clock::now();
+    auto r = rpc.call_sync(addr(SILENT_PORT), dkv::BinaryOpcode::PING);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(r.status, dkv::RpcStatus::TIMEOUT);
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+}
+
+TEST(RpcClient, StopFailsOutstandingCalls) {
+    SilentListener peer(SILENT_PORT);
+    ASSERT_TRUE(peer.ok());
+    dkv::RpcClient rpc(10000);
+
+    std::atomic<int> shutdown_count{0};
+    for (int i = 0; i < 5; i++) {
+        rpc.call(addr(SILENT_PORT), dkv::BinaryOpcode::PING, {}, {}, {},
+                 [&](dkv::RpcResult r) {
+                     if (r.status == dkv::RpcStatus::SHUTDOWN) shutdown_count++;
+                 });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    rpc.stop();
+    EXPECT_EQ(shutdown_count.load(), 5);
+
+    // After stop(), calls complete immediately.
+    auto r = rpc.call_sync(addr(SILENT_PORT), dkv::BinaryOpcode::PING);
+    EXPECT_EQ(r.status, dkv::RpcStatus::SHUTDOWN);
+}
+
+// ── Coordinator over RpcClient: quorum write/read with a remote replica ─────
+
+TEST(RpcClient, CoordinatorReplicatesToRemoteNode) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:19899", 128);  // this node (never dialled)
+    ring.add_node(2, addr(REPLICA_PORT), 128);
+
+    // Node 2: a real cluster-mode server with its own coordinator.
+    dkv::StorageEngine remote_engine;
+    dkv::ConnectionPool remote_pool;
+    dkv::Coordinator remote_coord(remote_engine, ring, remote_pool, 2,
+                                  nullptr, "", 100000, 2, 2, 2);
+    ServerRunner remote(std::make_unique<dkv::TCPServer>(
+        remote_engine, remote_coord, REPLICA_PORT, 2, 2));
+
+    // Node 1: N=2, W=2, R=2 — every operation needs node 2's answer.
+    dkv::StorageEngine local_engine;
+    dkv::ConnectionPool pool;
+    dkv::Coordinator coord(local_engine, ring, pool, 1,
+                           nullptr, "", 100000, 2, 2, 2);
+
+    dkv::Command set{};
+    set.type  = dkv::CommandType::SET;
+    set.key   = "replicated";
+    set.value = "both";
+    EXPECT_EQ(coord.handle_command(set), "+OK\n");
+
+    auto remote_val = remote_engine.get("replicated");
+    ASSERT_TRUE(remote_val.found);
+    EXPECT_EQ(remote_val.value, "both");
+    EXPECT_EQ(remote_val.version.node_id, 1u);
+
+    dkv::Command get{};
+    get.type = dkv::CommandType::GET;
+    get.key  = "replicated";
+    EXPECT_EQ(coord.handle_command(get), "$4 both\n");
+
+    // Asynchronous form: the reply arrives via callback.
+    std::promise<std::string> reply;
+    auto fut = reply.get_future();
+    coord.handle_command_async(get, [&](std::string r) { reply.set_value(std::move(r)); });
+    ASSERT_EQ(fut.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(fut.get(), "$4 both\n");
+}
+
+// ── Replication batching ────────────────────────────────────────────────────
+
+TEST(RpcClient, BatchedWritesResolveIndividually) {
+    dkv::HashRing ring;
+    ring.add_node(2, addr(REPLICA_PORT), 128);
+    dkv::StorageEngine remote_engine;
+    dkv::ConnectionPool remote_pool;
+    dkv::Coordinator remote_coord(remote_engine, ring, remote_pool, 2);
+    ServerRunner remote(std::make_unique<dkv::TCPServer>(
+        remote_engine, remote_coord, REPLICA_PORT, 2, 2));
+
+    dkv::RpcClient rpc(2000);
+    rpc.set_batching(64 * 1024, 20000);  // long linger: everything below batches
+
+    constexpr int WRITES = 40;
+    std::vector<std::promise<dkv::RpcResult>> results(WRITES + 1);
+    const std::string version = dkv::encode_version_extras(1000, 7);
+    for (int i = 0; i < WRITES; i++) {
+        std::string key = "b" + std::to_string(i);
+        rpc.call_batched(addr(REPLICA_PORT),
+                         dkv::RpcClient::encode(dkv::BinaryOpcode::RSET, version,
+                                                key, "v" + std::to_string(i)),
+                         [&results, i](dkv::RpcResult r) {
+                             results[i].set_value(std::move(r));
+                         });
+    }
+    // A frame that is not a replication write fails on its own.
+    rpc.call_batched(addr(REPLICA_PORT),
+                     dkv::RpcClient::encode(dkv::BinaryOpcode::GET, {}, "b0", {}),
+                     [&results](dkv::RpcResult r) {
+                         results[WRITES].set_value(std::move(r));
+                     });
+
+    for (int i = 0; i < WRITES; i++) {
+        auto fut = results[i].get_future();
+        ASSERT_EQ(fut.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        auto r = fut.get();
+        EXPECT_EQ(r.status, dkv::RpcStatus::OK);
+        EXPECT_EQ(r.opcode, dkv::BinaryOpcode::OK) << "write " << i;
+    }
+    auto bad = results[WRITES].get_future().get();
+    EXPECT_EQ(bad.opcode, dkv::BinaryOpcode::ERROR);
+
+    auto stats = rpc.batch_stats();
+    EXPECT_GE(stats.batches, 1u);
+    EXPECT_EQ(stats.batched_writes, static_cast<uint64_t>(WRITES + 1));
+
+    auto v = remote_engine.get("b39");
+    ASSERT_TRUE(v.found);
+    EXPECT_EQ(v.value, "v39");
+    EXPECT_EQ(v.version.node_id, 7u);
+}
+
+TEST(RpcClient, BatchFailsEveryWriteWhenPeerIsDown) {
+    dkv::RpcClient rpc(500);
+    rpc.set_batching(64 * 1024, 5000);
+
+    std::atomic<int> failed{0};
+    std::atomic<int> done{0};
+    const std::string version = dkv::encode_version_extras(1, 1);
+    for (int i = 0; i < 5; i++) {
+        rpc.call_batched("127.0.0.1:1",
+                         dkv::RpcClient::encode(dkv::BinaryOpcode::RSET, version,
+                                                "k", "v"),
+                         [&](dkv::RpcResult r) {
+                             if (r.status == dkv::RpcStatus::CONNECT_FAILED) failed++;
+                             done++;
+                         });
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (done.load() < 5 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(failed.load(), 5);
+}
+
+// ── Early quorum completion and hedged reads ────────────────────────────────
+
+TEST(RpcClient, RunAfterFiresOnLoopThread) {
+    dkv::RpcClient rpc(500);
+    std::promise<std::chrono::steady_clock::time_point> fired;
+    auto start = std::chrono::steady_clock::now();
+    rpc.run_after(std::chrono::microseconds(20000), [&fired]() {
+        fired.set_value(std::chrono::steady_clock::now());
+    });
+    auto fut = fired.get_future();
+    ASSERT_EQ(fut.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_GE(fut.get() - start, std::chrono::milliseconds(20));
+}
+
+// N=2, W=1: the local ack decides the write; the silent replica is not
+// waited for.
+TEST(RpcClient, WriteRepliesOnceQuorumIsMet) {
+    SilentListener peer(SILENT_PORT);
+    ASSERT_TRUE(peer.ok());
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:19899", 128);
+    ring.add_node(2, addr(SILENT_PORT), 128);
+
+    dkv::StorageEngine engine;
+    dkv::ConnectionPool pool(4, 2000);
+    dkv::Coordinator coord(engine, ring, pool, 1,
+                           nullptr, "", 100000, 2, 1, 1);
+
+    dkv::Command set{};
+    set.type  = dkv::CommandType::SET;
+    set.key   = "early";
+    set.value = "v";
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(coord.handle_command(set), "+OK\n");
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(1000));
+}
+
+// N=2, R=1: the key's first replica never answers; with hedging on the read
+// is re-sent to the local replica after the hedge delay.
+TEST(RpcClient, HedgedReadAvoidsSilentReplica) {
+    SilentListener peer(SILENT_PORT);
+    ASSERT_TRUE(peer.ok());
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:19899", 128);
+    ring.add_node(2, addr(SILENT_PORT), 128);
+
+    std::string key;
+    for (int i = 0; i < 2000 && key.empty(); ++i) {
+        std::string candidate = "hedge" + std::to_string(i);
+        if (ring.get_replica_nodes(candidate, 1)[0].node_id == 2) key = candidate;
+    }
+    ASSERT_FALSE(key.empty());
+
+    dkv::StorageEngine engine;
+    engine.set(key, "local", dkv::Version{10, 1});
+    dkv::ConnectionPool pool(4, 2000);
+    dkv::Coordinator coord(engine, ring, pool, 1,
+                           nullptr, "", 100000, 2, 1, 1);
+    coord.set_read_hedging(true, 5000);
+    coord.set_dynamic_snitch(false);  // ask node 2 first, as the ring does
+
+    dkv::Command get{};
+    get.type = dkv::CommandType::GET;
+    get.key  = key;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(coord.handle_command(get), "$5 local\n");
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(1000));
+    EXPECT_EQ(coord.hedged_reads(), 1u);
+}
+
+// ── Digest reads ────────────────────────────────────────────────────────────
+
+// N=2, R=2: this node serves the value and node 2 only its version.  When
+// node 2 is ahead, the coordinator fetches the value from it and repairs
+// the local copy.
+TEST(RpcClient, DigestReadFetchesNewerValue) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:19899", 128);
+    ring.add_node(2, addr(REPLICA_PORT), 128);
+
+    dkv::StorageEngine remote_engine;
+    dkv::ConnectionPool remote_pool;
+    dkv::Coordinator remote_coord(remote_engine, ring, remote_pool, 2);
+    ServerRunner remote(std::make_unique<dkv::TCPServer>(
+        remote_engine, remote_coord, REPLICA_PORT, 2, 2));
+
+    dkv::StorageEngine local_engine;
+    dkv::ConnectionPool pool;
+    dkv::Coordinator coord(local_engine, ring, pool, 1,
+                           nullptr, "", 100000, 2, 2, 2);
+
+    dkv::Command get{};
+    get.type = dkv::CommandType::GET;
+
+    // In sync: one round trip, no mismatch.
+    local_engine.set("same", "v", dkv::Version{100, 1});
+    remote_engine.set("same", "v", dkv::Version{100, 1});
+    get.key = "same";
+    EXPECT_EQ(coord.handle_command(get), "$1 v\n");
+    EXPECT_EQ(coord.digest_mismatches(), 0u);
+
+    // Remote is newer: its digest wins and the value is fetched from it.
+    local_engine.set("diverged", "old", dkv::Version{100, 1});
+    remote_engine.set("diverged", "new", dkv::Version{200, 2});
+    get.key = "diverged";
+    EXPECT_EQ(coord.handle_command(get), "$3 new\n");
+    EXPECT_EQ(coord.digest_mismatches(), 1u);
+
+    // Read repair brings the local replica up to date.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (local_engine.get("diverged").value != "new" &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(local_engine.get("diverged").value, "new");
+
+    // Only the remote has it at all.
+    remote_engine.set("remote_only", "r", dkv::Version{300, 2});
+    get.key = "remote_only";
+    EXPECT_EQ(coord.handle_command(get), "$1 r\n");
+    EXPECT_EQ(coord.digest_mismatches(), 2u);
+}
+
+// MSET/MGET against a real peer: one RBATCH per node, keys answered in
+// request order, and a stale replica repaired per key.
+TEST(RpcClient, MultiKeyCommandsBatchPerReplica) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:19899", 128);
+    ring.add_node(2, addr(REPLICA_PORT), 128);
+
+    dkv::StorageEngine remote_engine;
+    dkv::ConnectionPool remote_pool;
+    dkv::Coordinator remote_coord(remote_engine, ring, remote_pool, 2);
+    ServerRunner remote(std::make_unique<dkv::TCPServer>(
+        remote_engine, remote_coord, REPLICA_PORT, 2, 2));
+
+    dkv::StorageEngine local_engine;
+    dkv::ConnectionPool pool;
+    dkv::Coordinator coord(local_engine, ring, pool, 1,
+                           nullptr, "", 100000, 2, 2, 2);
+
+    std::vector<std::string> keys, values;
+    for (int i = 0; i < 50; ++i) {
+        keys.push_back("mk" + std::to_string(i));
+        values.push_back("val" + std::to_string(i));
+    }
+    dkv::Command mset{};
+    mset.type  = dkv::CommandType::MSET;
+    mset.value = dkv::format_multi_args(keys, values);
+    ASSERT_EQ(coord.handle_command(mset), "+OK\n");
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto r = remote_engine.get(keys[i]);
+        ASSERT_TRUE(r.found) << keys[i];
+        EXPECT_EQ(r.value, values[i]);
+    }
+
+    // The remote copy of one key is newer; another exists nowhere.
+    remote_engine.set("mk7", "newer", dkv::Version{~0ull >> 1, 2});
+    keys.insert(keys.begin() + 3, "absent");
+
+    dkv::Command mget{};
+    mget.type  = dkv::CommandType::MGET;
+    mget.value = dkv::format_multi_args(keys);
+    std::string resp = coord.handle_command(mget);
+    ASSERT_EQ(resp.rfind("$", 0), 0u) << resp;
+    std::vector<dkv::MultiGetItem> items;
+    ASSERT_TRUE(dkv::parse_multi_get(
+        std::string_view(resp).substr(resp.find(' ') + 1, resp.size() - resp.find(' ') - 2),
+        items));
+    ASSERT_EQ(items.size(), 51u);
+    EXPECT_EQ(items[0].value, "val0");
+    EXPECT_EQ(items[3].status, dkv::MultiGetItem::Status::NOT_FOUND);
+    EXPECT_EQ(items[8].value, "newer");  // mk7, shifted by "absent"
+    EXPECT_EQ(items[50].value, "val49");
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (local_engine.get("mk7").value != "newer" &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(local_engine.get("mk7").value, "newer");
+}
+
+// An MGET whose values outgrow one frame: the replica answers what fits
+// and the coordinator asks again for the rest, on the same connection; a
+// reply too large for the client is refused rather than sent.
+TEST(RpcClient, MultiGetOfLargeValuesStaysWithinFrames) {
+    dkv::HashRing ring;
+    ring.add_node(2, addr(REPLICA_PORT), 32);
+
+    dkv::StorageEngine remote_engine;
+    dkv::ConnectionPool remote_pool;
+    dkv::Coordinator remote_coord(remote_engine, ring, remote_pool, 2);
+    ServerRunner remote(std::make_unique<dkv::TCPServer>(
+        remote_engine, remote_coord, REPLICA_PORT, 2, 2));
+
+    // Tens of MiB per reply: allow for slow (sanitizer) builds.
+    dkv::StorageEngine local_engine;
+    dkv::ConnectionPool pool(4, 10000);
+    dkv::Coordinator coord(local_engine, ring, pool, 1);
+
+    // 70 MiB in all: more than one RBATCH reply can carry.
+    const size_t value_size = 1 << 20;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 70; ++i) {
+        keys.push_back("big" + std::to_string(i));
+        remote_engine.set(keys.back(), std::string(value_size, static_cast<char>('a' + i % 26)),
+                          dkv::Version{100, 2});
+    }
+
+    dkv::Command mget{};
+    mget.type  = dkv::CommandType::MGET;
+    mget.value = dkv::format_multi_args(keys);
+    EXPECT_EQ(coord.handle_command(mget), "-ERR REPLY_TOO_LARGE\n");
+
+    // The same node still answers, and a smaller MGET goes through.
+    keys.resize(40);
+    mget.value = dkv::format_multi_args(keys);
+    std::string resp = coord.handle_command(mget);
+    ASSERT_EQ(resp.rfind("$", 0), 0u) << resp.substr(0, 64);
+    std::vector<dkv::MultiGetItem> items;
+    ASSERT_TRUE(dkv::parse_multi_get(
+        std::string_view(resp).substr(resp.find(' ') + 1, resp.size() - resp.find(' ') - 2),
+        items));
+    ASSERT_EQ(items.size(), 40u);
+    for (size_t i = 0; i < items.size(); ++i) {
+        ASSERT_EQ(items[i].status, dkv::MultiGetItem::Status::FOUND) << i;
+        EXPECT_EQ(items[i].value.size(), value_size);
+        EXPECT_EQ(items[i].value[0], static_cast<char>('a' + i % 26));
+    }
+}
+
+TEST(RpcClient, AntiEntropyConvergesDivergedReplicas) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:19899", 32);
+    ring.add_node(2, addr(REPLICA_PORT), 32);
+
+    dkv::AntiEntropy::Options opts;
+    opts.interval_ms        = 0;  // rounds run by hand below
+    opts.rate_bytes_per_sec = 0;
+
+    dkv::StorageEngine remote_engine;
+    dkv::ConnectionPool remote_pool;
+    dkv::Coordinator remote_coord(remote_engine, ring, remote_pool, 2,
+                                  nullptr, "", 100000, 2, 1, 1);
+    remote_coord.start_anti_entropy(opts);
+    ServerRunner remote(std::make_unique<dkv::TCPServer>(
+        remote_engine, remote_coord, REPLICA_PORT, 2, 2));
+
+    dkv::StorageEngine local_engine;
+    dkv::ConnectionPool pool;
+    dkv::Coordinator coord(local_engine, ring, pool, 1,
+                           nullptr, "", 100000, 2, 1, 1);
+    coord.start_anti_entropy(opts);
+
+    // N = 2 with two nodes: every range is shared.
+    for (int i = 0; i < 50; i++) {
+        std::string k = "same" + std::to_string(i);
+        local_engine.set(k, "v", dkv::Version{100, 1});
+        remote_engine.set(k, "v", dkv::Version{100, 1});
+    }
+    local_engine.set("local_newer", "new", dkv::Version{200, 1});
+    remote_engine.set("local_newer", "old", dkv::Version{100, 2});
+    remote_engine.set("remote_only", "r", dkv::Version{300, 2});
+    local_engine.set("deleted", "x", dkv::Version{100, 1});
+    remote_engine.del("deleted", dkv::Version{400, 2});
+    local_engine.set("local_only", "l", dkv::Version{500, 1});
+
+    dkv::NodeInfo peer{2, addr(REPLICA_PORT)};
+    ASSERT_TRUE(coord.anti_entropy()->sync_with(peer));
+
+    EXPECT_EQ(remote_engine.get("local_newer").value, "new");
+    EXPECT_EQ(remote_engine.get("local_only").value, "l");
+    EXPECT_EQ(local_engine.get("remote_only").value, "r");
+    EXPECT_FALSE(local_engine.get("deleted").found);
+
+    auto s = coord.anti_entropy()->stats();
+    EXPECT_EQ(s.keys_pulled, 2u);
+    EXPECT_EQ(s.keys_pushed, 2u);
+    EXPECT_LE(s.leaves_differing, 4u);
+
+    // Converged: the next round finds nothing to do.
+    ASSERT_TRUE(coord.anti_entropy()->sync_with(peer));
+    auto again = coord.anti_entropy()->stats();
+    EXPECT_EQ(again.leaves_differing, s.leaves_differing);
+    EXPECT_EQ(again.rounds, 2u);
+    EXPECT_EQ(again.failed_rounds, 0u);
+}
+
+// Writes made while the replica is down become hints (one per key, at its
+// latest version); replay streams them once it is back.
+TEST(RpcClient, HintReplayDeliversLatestVersions) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:19899", 32);
+    ring.add_node(2, addr(REPLICA_PORT), 32);
+
+    dkv::StorageEngine engine;
+    dkv::ConnectionPool pool;
+    dkv::Coordinator coord(engine, ring, pool, 1,
+                           nullptr, "", 100000, 2, 1, 1);
+
+    dkv::Command set{};
+    set.type = dkv::CommandType::SET;
+    for (int i = 0; i < 600; i++) {
+        set.key   = "k" + std::to_string(i);
+        set.value = "v" + std::to_string(i);
+        EXPECT_EQ(coord.handle_command(set), "+OK\n");
+    }
+    for (const char* v : {"h1", "h2", "h3"}) {
+        set.key   = "hot";
+        set.value = v;
+        EXPECT_EQ(coord.handle_command(set), "+OK\n");
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (coord.pending_hints() < 601 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(coord.pending_hints(), 601u);
+
+    dkv::StorageEngine remote_engine;
+    dkv::ConnectionPool remote_pool;
+    dkv::Coordinator remote_coord(remote_engine, ring, remote_pool, 2);
+    ServerRunner remote(std::make_unique<dkv::TCPServer>(
+        remote_engine, remote_coord, REPLICA_PORT, 2, 2));
+
+    coord.replay_hints_for(2, addr(REPLICA_PORT));
+    EXPECT_EQ(coord.pending_hints(), 0u);
+    EXPECT_EQ(remote_engine.get("hot").value, "h3");
+    for (int i = 0; i < 600; i += 97) {
+        EXPECT_EQ(remote_engine.get("k" + std::to_string(i)).value,
+                  "v" + std::to_string(i));
+    }
+}
+
+// The rejoin callback only queues the replay: the caller (the heartbeat or
+// gossip thread) returns at once and the worker streams the hints.
+TEST(RpcClient, ScheduledHintReplayRunsOffTheCaller) {
+    dkv::HashRing ring;
+    ring.add_node(1, "127.0.0.1:19899", 32);
+    ring.add_node(2, addr(REPLICA_PORT), 32);
+
+    dkv::StorageEngine engine;
+    dkv::ConnectionPool pool;
+    dkv::Coordinator coord(engine, ring, pool, 1,
+                           nullptr, "", 100000, 2, 1, 1);
+    dkv::Membership membership;
+    membership.add_peer(2, addr(REPLICA_PORT));
+    membership.set_rejoin_callback([&coord](uint32_t id, const std::string& a) {
+        coord.schedule_hint_replay(id, a);
+    });
+
+    dkv::Command set{};
+    set.type = dkv::CommandType::SET;
+    for (int i = 0; i < 50; i++) {
+        set.key   = "k" + std::to_string(i);
+        set.value = "v" + std::to_string(i);
+        EXPECT_EQ(coord.handle_command(set), "+OK\n");
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (coord.pending_hints() < 50 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(coord.pending_hints(), 50u);
+
+    dkv::StorageEngine remote_engine;
+    dkv::ConnectionPool remote_pool;
+    dkv::Coordinator remote_coord(remote_engine, ring, remote_pool, 2);
+    ServerRunner remote(std::make_unique<dkv::TCPServer>(
+        remote_engine, remote_coord, REPLICA_PORT, 2, 2));
+
+    membership.set_state(2, dkv::NodeState::DOWN);
+    membership.record_success(2);  // DOWN -> UP: queues the replay
+
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (coord.pending_hints() > 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(coord.pending_hints(), 0u);
+    EXPECT_EQ(remote_engine.get("k0").value, "v0");
+    EXPECT_EQ(remote_engine.get("k49").value, "v49");
+}
+
+// A node joins a one-node cluster: it pulls the ranges it gains, writes made
+// while the change is staged reach it, and decommissioning hands them back.
+TEST(RpcClient, RebalanceJoinAndDecommission) {
+    const std::string addr1 = addr(SERVER_PORT);
+    const std::string addr2 = addr(REPLICA_PORT);
+    dkv::Rebalancer::Options opts;
+    opts.chunk_bytes = 512;  // several chunks per shard
+    opts.vnodes      = 32;
+
+    dkv::HashRing ring1;
+    ring1.add_node(1, addr1, 32);
+    dkv::StorageEngine engine1;
+    dkv::ConnectionPool pool1;
+    dkv::Coordinator coord1(engine1, ring1, pool1, 1);
+    coord1.start_rebalancer(opts);
+    ServerRunner server1(std::make_unique<dkv::TCPServer>(
+        engine1, coord1, SERVER_PORT, 2, 1));
+
+    dkv::HashRing ring2;
+    ring2.add_node(1, addr1, 32);
+    dkv::StorageEngine engine2;
+    dkv::ConnectionPool pool2;
+    dkv::Coordinator coord2(engine2, ring2, pool2, 2);
+    coord2.start_rebalancer(opts);
+    ServerRunner server2(std::make_unique<dkv::TCPServer>(
+        engine2, coord2, REPLICA_PORT, 2, 2));
+
+    for (int i = 0; i < 3000; i++) {
+        engine1.set("k" + std::to_string(i), "v" + std::to_string(i), {100, 1});
+    }
+    engine1.del("k0", {200, 1});
+
+    ASSERT_EQ(coord2.rebalancer()->join(addr2), dkv::Rebalancer::Outcome::COMMITTED);
+    EXPECT_EQ(ring1.node_count(), 2u);
+    EXPECT_EQ(ring2.node_count(), 2u);
+    EXPECT_EQ(ring1.pending(), nullptr);
+    EXPECT_EQ(ring1.version(), ring2.version());
+
+    size_t moved = 0;
+    for (int i = 0; i < 3000; i++) {
+        std::string k = "k" + std::to_string(i);
+        if (ring1.get_node(k)->node_id != 2) continue;
+        ++moved;
+        if (i == 0) {
+            EXPECT_FALSE(engine2.get(k).found);
+            continue;
+        }
+        auto got = engine2.get(k);
+        ASSERT_TRUE(got.found) << k;
+        EXPECT_EQ(got.value, "v" + std::to_string(i));
+    }
+    EXPECT_GT(moved, 500u);
+    auto s = coord2.rebalancer()->stats();
+    EXPECT_EQ(s.keys_streamed, moved);
+    EXPECT_GT(s.chunks, 32u);
+    EXPECT_EQ(s.changes, 1u);
+
+    // Routed by the new ring from either node.
+    dkv::Command set{};
+    set.type = dkv::CommandType::SET;
+    std::string owned_by_2;
+    for (int i = 0; owned_by_2.empty(); i++) {
+        std::string k = "new" + std::to_string(i);
+        if (ring1.get_node(k)->node_id == 2) owned_by_2 = k;
+    }
+    set.key   = owned_by_2;
+    set.value = "fresh";
+    EXPECT_EQ(coord1.handle_command(set), "+OK\n");
+    EXPECT_EQ(engine2.get(owned_by_2).value, "fresh");
+    EXPECT_FALSE(engine1.get(owned_by_2).found);
+
+    // While a change is staged, writes also go to the replica it adds.
+    ASSERT_TRUE(ring1.stage_remove(2));
+    std::string owned_by_1_next;  // node 2 now, node 1 once staged
+    for (int i = 0; owned_by_1_next.empty(); i++) {
+        std::string k = "staged" + std::to_string(i);
+        if (ring1.get_node(k)->node_id == 2) owned_by_1_next = k;
+    }
+    set.key   = owned_by_1_next;
+    set.value = "both";
+    EXPECT_EQ(coord1.handle_command(set), "+OK\n");
+    EXPECT_EQ(engine2.get(owned_by_1_next).value, "both");
+    EXPECT_EQ(engine1.get(owned_by_1_next).value, "both");
+    ring1.abort_pending();
+
+    // Leaving pushes node 2's ranges back to node 1.
+    dkv::Command decommission{};
+    decommission.type = dkv::CommandType::DECOMMISSION;
+    EXPECT_EQ(coord2.handle_command(decommission), "+OK\n");
+    EXPECT_EQ(ring1.node_count(), 1u);
+    EXPECT_EQ(ring2.node_count(), 1u);
+    EXPECT_EQ(engine1.get(owned_by_2).value, "fresh");
+}
+
+// ── SWIM gossip over GOSSIP frames ──────────────────────────────────────────
+
+TEST(RpcClient, PerCallTimeoutOverridesDefault) {
+    SilentListener peer(SILENT_PORT);
+    ASSERT_TRUE(peer.ok());
+    dkv::RpcClient rpc(10000);
+
+    std::promise<dkv::RpcResult> done;
+    auto fut   = done.get_future();
+    auto start = std::chrono::steady_clock::now();
+    rpc.call(addr(SILENT_PORT), dkv::RpcClient::encode(dkv::BinaryOpcode::PING, {}, {}, {}),
+             [&](dkv::RpcResult r) { done.set_value(std::move(r)); },
+             std::chrono::milliseconds(100));
+    ASSERT_EQ(fut.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(fut.get().status, dkv::RpcStatus::TIMEOUT);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+}
+
+TEST(RpcClient, GossipDetectsStoppedNode) {
+    const std::string addr1 = addr(SERVER_PORT);
+    const std::string addr2 = addr(REPLICA_PORT);
+    dkv::Gossip::Options opts;
+    opts.period_ms        = 100;
+    opts.probe_timeout_ms = 40;
+
+    dkv::HashRing ring;
+    ring.add_node(1, addr1, 32);
+    ring.add_node(2, addr2, 32);
+
+    dkv::Membership m1;
+    m1.add_peer(2, addr2);
+    std::atomic<int> downs{0};
+    m1.set_down_callback([&](uint32_t id, const std::string&) { if (id == 2) downs++; });
+    dkv::StorageEngine engine1;
+    dkv::ConnectionPool pool1;
+    dkv::Coordinator coord1(engine1, ring, pool1, 1);
+    coord1.set_membership(&m1);
+    ServerRunner server1(std::make_unique<dkv::TCPServer>(
+        engine1, coord1, SERVER_PORT, 2, 1));
+
+    dkv::Membership m2;
+    m2.add_peer(1, addr1);
+    dkv::StorageEngine engine2;
+    dkv::ConnectionPool pool2;
+    dkv::Coordinator coord2(engine2, ring, pool2, 2);
+    coord2.set_membership(&m2);
+    auto server2 = std::make_unique<ServerRunner>(std::make_unique<dkv::TCPServer>(
+        engine2, coord2, REPLICA_PORT, 2, 2));
+
+    // Without gossip a node refuses GOSSIP frames.
+    dkv::Command gossip{};
+    gossip.type  = dkv::CommandType::GOSSIP;
+    gossip.value = dkv::Gossip::encode(dkv::Gossip::Message{});
+    EXPECT_EQ(coord1.handle_command(gossip), "-ERR GOSSIP_DISABLED\n");
+
+    coord1.start_gossip(opts);
+    coord2.start_gossip(opts);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_GT(coord1.gossip()->stats().probes, 2u);
+    EXPECT_EQ(coord1.gossip()->state_of(2), dkv::Gossip::State::ALIVE);
+    EXPECT_EQ(m1.get_state(2), dkv::NodeState::UP);
+    EXPECT_EQ(downs.load(), 0);
+
+    // Node 2 dies (a node that still sends would keep refuting).
+    coord2.gossip()->stop();
+    server2.reset();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (m1.get_state(2) != dkv::NodeState::DOWN &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_EQ(m1.get_state(2), dkv::NodeState::DOWN);
+    EXPECT_EQ(coord1.gossip()->state_of(2), dkv::Gossip::State::DEAD);
+    EXPECT_EQ(downs.load(), 1);
+}
@@ -2,6 +2,7 @@
 
 #include "storage/storage_engine.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <thread>
@@ -31,6 +32,20 @@ TEST(StorageEngine, GetMissingKey) {
     EXPECT_FALSE(result.found);
 }
 
+TEST(StorageEngine, GetVersionSkipsValue) {
+    dkv::StorageEngine engine;
+    EXPECT_FALSE(engine.get_version("key1").has_value());
+
+    engine.set("key1", "value1", {100, 3});
+    auto v = engine.get_version("key1");
+    ASSERT_TRUE(v.has_value());
+    EXPECT_EQ(v->timestamp_ms, 100u);
+    EXPECT_EQ(v->node_id, 3u);
+
+    engine.del("key1", {200, 1});
+    EXPECT_FALSE(engine.get_version("key1").has_value());
+}
+
 TEST(StorageEngine, DeleteWritesTombstone) {
     dkv::StorageEngine engine;
     engine.set("key1", "value1", {100, 1});
@@ -116,6 +131,23 @@ TEST(StorageEngine, SetAfterDeleteResurrects) {
     EXPECT_EQ(result.version.timestamp_ms, 300u);
 }
 
+TEST(StorageEngine, SetMovesValueIntoEngine) {
+    dkv::StorageEngine engine;
+    std::string big(4096, 'x');
+
+    EXPECT_TRUE(engine.set("key1", std::move(big), {100, 1}));
+
+    auto result = engine.get("key1");
+    EXPECT_TRUE(result.found);
+    EXPECT_EQ(result.value, std::string(4096, 'x'));
+
+    // A rejected (older) write must leave the caller's value untouched.
+    std::string stale = "stale";
+    EXPECT_FALSE(engine.set("key1", std::move(stale), {50, 1}));
+    EXPECT_EQ(stale, "stale");
+    EXPECT_EQ(engine.get("key1").value, std::string(4096, 'x'));
+}
+
 // ---------------------------------------------------------------------------
 // Concurrency
 // ---------------------------------------------------------------------------
@@ -243,3 +275,50 @@ TEST(StorageEngine, AllEntriesConsistentUnderConcurrentWrites) {
     EXPECT_EQ(violations.load(), 0)
         << "all_entries() produced an inconsistent snapshot under concurrent writes";
 }
+
+// ---------------------------------------------------------------------------
+// Range scans (rebalancing transfers)
+// ---------------------------------------------------------------------------
+
+TEST(StorageEngine, RangeScanPagesThroughEveryMatch) {
+    dkv::StorageEngine engine;
+    for (int i = 0; i < 2000; i++) {
+        engine.set("k" + std::to_string(i), std::string(50, 'v'), {100, 1});
+    }
+    engine.del("k7", {200, 1});
+
+    // A wrapping range plus an ordinary one.
+    std::vector<dkv::TokenRange> ranges{{0xF000000000000000ull, 0x1000000000000000ull},
+                                        {0x4000000000000000ull, 0x6000000000000000ull}};
+    std::unordered_set<std::string> expected;
+    for (int i = 0; i < 2000; i++) {
+        std::string k = "k" + std::to_string(i);
+        uint64_t pos = dkv::murmurhash3(k);
+        if (ranges[0].contains(pos) || ranges[1].contains(pos)) expected.insert(k);
+    }
+    ASSERT_FALSE(expected.empty());
+
+    std::unordered_set<std::string> seen;
+    size_t chunks = 0;
+    for (size_t shard = 0; shard < dkv::StorageEngine::shard_count(); shard++) {
+        const auto keys = engine.keys_in_ranges(ranges, shard);
+        EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+        size_t next = 0;
+        while (next < keys.size()) {
+            auto chunk = engine.entries_for_keys(shard, keys, next, 500, next);
+            if (chunk.empty()) break;
+            ++chunks;
+            for (size_t i = 1; i < chunk.size(); i++) {
+                EXPECT_LT(chunk[i - 1].first, chunk[i].first);
+            }
+            for (const auto& [k, e] : chunk) {
+                EXPECT_TRUE(seen.insert(k).second) << k;
+                if (k == "k7") {
+                    EXPECT_TRUE(e.is_tombstone);
+                }
+            }
+        }
+    }
+    EXPECT_EQ(seen, expected);
+    EXPECT_GT(chunks, dkv::StorageEngine::shard_count());  // 500 B pages
+}
@@ -4,6 +4,14 @@
 
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
 
 TEST(ThreadPool, SubmitAndExecute) {
     dkv::ThreadPool pool(2);
@@ -78,3 +86,182 @@ TEST(ThreadPool, TasksRunOnDifferentThreads) {
     // We should see more than 1 thread if the pool is working correctly
     EXPECT_GT(thread_ids.size(), 1u);
 }
+
+TEST(ThreadPool, ShutdownRunsPendingTasks) {
+    std::atomic<int> counter{0};
+    dkv::ThreadPool pool(1);
+
+    // Block the only worker so the remaining tasks are still queued when
+    // shutdown() is called.
+    std::atomic<bool> release{false};
+    pool.submit([&]() {
+        while (!release.load()) std::this_thread::yield();
+    });
+    for (int i = 0; i < 100; i++) {
+        pool.submit([&]() { counter++; });
+    }
+
+    std::thread stopper([&]() { pool.shutdown(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release = true;
+    stopper.join();
+
+    EXPECT_EQ(counter.load(), 100);
+}
+
+TEST(ThreadPool, NestedSubmitsFromWorkersAreStolen) {
+    // Tasks submitted by a worker go onto its own deque; other workers must
+    // be able to steal them.
+    dkv::ThreadPool pool(4);
+    std::atomic<int> counter{0};
+    std::mutex ids_mutex;
+    std::set<std::thread::id> thread_ids;
+
+    pool.submit([&]() {
+        for (int i = 0; i < 200; i++) {
+            pool.submit([&]() {
+                {
+                    std::lock_guard lock(ids_mutex);
+                    thread_ids.insert(std::this_thread::get_id());
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                counter++;
+            });
+        }
+    });
+
+    // Wait for completion before shutdown, since shutdown rejects further
+    // submits from the first task if it is still running.
+    for (int i = 0; i < 500 && counter.load() < 200; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    pool.shutdown();
+
+    EXPECT_EQ(counter.load(), 200);
+    EXPECT_GT(thread_ids.size(), 1u);
+}
+
+TEST(ThreadPool, MoreTasksThanQueueCapacity) {
+    // Bursts larger than the injection ring spill into the overflow list.
+    dkv::ThreadPool pool(2);
+    std::atomic<int> counter{0};
+    std::atomic<bool> release{false};
+
+    pool.submit([&]() { while (!release.load()) std::this_thread::yield(); });
+    pool.submit([&]() { while (!release.load()) std::this_thread::yield(); });
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(pool.submit([&]() { counter++; }));
+    }
+    release = true;
+    pool.shutdown();
+
+    EXPECT_EQ(counter.load(), 10000);
+}
+
+TEST(ThreadPool, MoveOnlyAndLargeCaptures) {
+    dkv::ThreadPool pool(2);
+    std::atomic<int> sum{0};
+
+    // Move-only capture (std::function could not hold this)
+    auto p = std::make_unique<int>(7);
+    pool.submit([&sum, p = std::move(p)]() { sum += *p; });
+
+    // Capture larger than the inline buffer falls back to the heap
+    struct Big { char bytes[dkv::Task::INLINE_SIZE * 2]; };
+    Big big{};
+    big.bytes[0] = 5;
+    static_assert(!dkv::Task::fits_inline<decltype([big]() {})>());
+    pool.submit([&sum, big]() { sum += big.bytes[0]; });
+
+    pool.shutdown();
+    EXPECT_EQ(sum.load(), 12);
+}
+
+TEST(Task, SmallLambdaStoredInline) {
+    std::string a = "x", b = "y";
+    auto small = [a, b, n = 1]() { (void)n; };
+    static_assert(dkv::Task::fits_inline<decltype(small)>());
+
+    int calls = 0;
+    dkv::Task t([&calls]() { calls++; });
+    dkv::Task moved(std::move(t));
+    EXPECT_FALSE(static_cast<bool>(t));
+    ASSERT_TRUE(static_cast<bool>(moved));
+    moved();
+    EXPECT_EQ(calls, 1);
+}
+
+// ---------------------------------------------------------------------------
+// Throughput benchmarks (report ops/s; assert only completion)
+// ---------------------------------------------------------------------------
+
+namespace {
+
+/// Submit `per_thread` empty tasks from each of `submitters` threads and
+/// return tasks/second until all have run.
+double measure_throughput(size_t workers, int submitters, int per_thread) {
+    dkv::ThreadPool pool(workers);
+    std::atomic<int> done{0};
+    const int total = submitters * per_thread;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int s = 0; s < submitters; s++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < per_thread; i++) {
+                pool.submit([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    while (done.load(std::memory_order_relaxed) < total) {
+        std::this_thread::yield();
+    }
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    pool.shutdown();
+    EXPECT_EQ(done.load(), total);
+    return total / elapsed;
+}
+
+}  // namespace
+
+TEST(ThreadPoolBenchmark, SingleSubmitterThroughput) {
+    double ops = measure_throughput(4, 1, 200000);
+    std::cout << "[ BENCH    ] 1 submitter  -> 4 workers: "
+              << static_cast<uint64_t>(ops) << " tasks/s\n";
+}
+
+TEST(ThreadPoolBenchmark, MultiSubmitterThroughput) {
+    double ops = measure_throughput(4, 4, 50000);
+    std::cout << "[ BENCH    ] 4 submitters -> 4 workers: "
+              << static_cast<uint64_t>(ops) << " tasks/s\n";
+}
+
+TEST(ThreadPoolBenchmark, ForkJoinThroughput) {
+    // Workers spawning subtasks: exercises local deques and stealing.
+    dkv::ThreadPool pool(4);
+    constexpr int ROOTS = 100;
+    constexpr int CHILDREN = 1000;
+    std::atomic<int> done{0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROOTS; r++) {
+        pool.submit([&]() {
+            for (int c = 0; c < CHILDREN; c++) {
+                pool.submit([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+    }
+    while (done.load(std::memory_order_relaxed) < ROOTS * CHILDREN) {
+        std::this_thread::yield();
+    }
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    pool.shutdown();
+
+    std::cout << "[ BENCH    ] fork-join " << ROOTS << "x" << CHILDREN << ": "
+              << static_cast<uint64_t>(ROOTS * CHILDREN / elapsed) << " tasks/s\n";
+    EXPECT_EQ(done.load(), ROOTS * CHILDREN);
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include "utils/token_bucket.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+using dkv::TokenBucket;
+
+TEST(TokenBucket, UnlimitedNeverWaits) {
+    TokenBucket bucket;
+    bucket.consume(1 << 30);
+    EXPECT_EQ(bucket.time_to_refill(), TokenBucket::Clock::duration::zero());
+}
+
+TEST(TokenBucket, StartsFullAndGoesIntoDebt) {
+    TokenBucket bucket(1000);
+    bucket.consume(1000);  // the initial burst
+    EXPECT_EQ(bucket.time_to_refill(), TokenBucket::Clock::duration::zero());
+
+    bucket.consume(500);   // half a second of debt
+    const auto wait = bucket.time_to_refill();
+    EXPECT_GT(wait, std::chrono::milliseconds(400));
+    EXPECT_LE(wait, std::chrono::milliseconds(500));
+}
+
+TEST(TokenBucket, WaitSleepsOffTheDebt) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    TokenBucket bucket(10'000);
+    bucket.consume(10'000 + 500);  // 50 ms over
+
+    std::unique_lock<std::mutex> lock(mutex);
+    const auto start = std::chrono::steady_clock::now();
+    bucket.wait(lock, cv, [] { return false; });
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40));
+    EXPECT_EQ(bucket.time_to_refill(), TokenBucket::Clock::duration::zero());
+}
+
+TEST(TokenBucket, WaitStopsWhenAsked) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    TokenBucket bucket(1);
+    bucket.consume(1'000'000);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    bucket.wait(lock, cv, [] { return true; });  // returns at once
+    EXPECT_GT(bucket.time_to_refill(), std::chrono::seconds(1));
+}
+
+TEST(TokenBucket, SetRateCapsTheBalance) {
+    TokenBucket bucket(1'000'000);
+    bucket.set_rate(100);
+    bucket.consume(150);  // burst is now 100
+    EXPECT_GT(bucket.time_to_refill(), std::chrono::milliseconds(400));
+
+    bucket.set_rate(0);
+    EXPECT_EQ(bucket.time_to_refill(), TokenBucket::Clock::duration::zero());
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include "cluster/hash_ring.h"
+#include "cluster/token_router.h"
+
+#include <string>
+
+// ---------------------------------------------------------------------------
+// TokenRouter: client-side routing from a TOPOLOGY payload
+// ---------------------------------------------------------------------------
+
+namespace {
+
+void add_three_nodes(dkv::HashRing& ring) {
+    ring.add_node(1, "127.0.0.1:7001", 64);
+    ring.add_node(2, "127.0.0.1:7002", 64);
+    ring.add_node(3, "10.0.0.3:7003", 64);
+}
+
+}  // namespace
+
+TEST(TokenRouter, MatchesHashRingPlacement) {
+    dkv::HashRing ring;
+    add_three_nodes(ring);
+    dkv::TokenRouter router;
+    ASSERT_TRUE(router.update(ring.encode_topology(2)));
+
+    EXPECT_EQ(router.version(), ring.version());
+    EXPECT_EQ(router.replication_factor(), 2u);
+    EXPECT_EQ(router.token_count(), ring.size());
+    ASSERT_EQ(router.nodes().size(), 3u);
+    EXPECT_EQ(router.nodes()[2].host, "10.0.0.3");
+    EXPECT_EQ(router.nodes()[2].port, 7003);
+
+    for (int i = 0; i < 2000; i++) {
+        std::string key = "key:" + std::to_string(i);
+        auto expected = ring.get_replica_nodes(key, 2);
+        auto got      = router.replicas(key);
+        ASSERT_EQ(got.size(), expected.size());
+        for (size_t r = 0; r < got.size(); r++) {
+            EXPECT_EQ(router.nodes()[got[r]].node_id, expected[r].node_id) << key;
+        }
+        EXPECT_EQ(router.primary(key), got[0]);
+    }
+}
+
+TEST(TokenRouter, VersionFollowsMembershipChanges) {
+    dkv::HashRing ring;
+    add_three_nodes(ring);
+    dkv::TokenRouter router;
+    ASSERT_TRUE(router.update(ring.encode_topology(3)));
+    const uint64_t before = router.version();
+
+    ring.remove_node(3);
+    ASSERT_TRUE(router.update(ring.encode_topology(3)));
+    EXPECT_GT(router.version(), before);
+    EXPECT_EQ(router.nodes().size(), 2u);
+    EXPECT_EQ(router.replicas("anything").size(), 2u);  // capped by node count
+}
+
+TEST(TokenRouter, RejectsMalformedPayloadAndKeepsMap) {
+    dkv::HashRing ring;
+    add_three_nodes(ring);
+    dkv::TokenRouter router;
+    ASSERT_TRUE(router.update(ring.encode_topology(3)));
+
+    EXPECT_FALSE(router.update(""));
+    EXPECT_FALSE(router.update("1 3 1 7 nohostport 1 5 0"));
+    EXPECT_FALSE(router.update("1 3 1 7 h:1 2 9 0 5 0"));    // tokens not ascending
+    EXPECT_FALSE(router.update("1 3 1 7 h:1 1 5 1"));        // owner out of range
+    EXPECT_FALSE(router.update("1 3 1 7 h:1 1 5 0 extra"));
+    // Counts the payload cannot hold are rejected before allocating.
+    EXPECT_FALSE(router.update("1 3 18446744073709551615 7 h:1 1 5 0"));
+    EXPECT_FALSE(router.update("1 3 1 7 h:1 4611686018427387904 5 0"));
+    EXPECT_EQ(router.nodes().size(), 3u);
+
+    dkv::TokenRouter empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_TRUE(empty.replicas("k").empty());
+}
@@ -1,8 +1,10 @@
 // dkv_cli.cpp — Interactive REPL client for the distributed KV store.
 // Equivalent of redis-cli: connects to a running dkv_node over TCP.
-// Pure POSIX TCP client — zero dkv_core dependency.
+// Speaks the text protocol over raw POSIX sockets; dkv_core is only used
+// for TokenRouter, to decode the HOTKEYS report and to format MGET/MSET.
 //
-// Usage: ./bin/dkv_cli [--host H] [-h H] [--port P] [-p P] [--help]
+// Usage: ./bin/dkv_cli [--host H] [-h H] [--port P] [-p P] [--token-aware]
+//                      [--help]
 //
 // Compile target: dkv_cli (see CMakeLists.txt)
 // Standard: C++20, POSIX only (Linux / macOS)
@@ -20,10 +22,15 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <unistd.h>
 
+#include "cluster/hot_keys.h"
+#include "cluster/token_router.h"
+#include "network/protocol.h"
+
 // ── Signal flag ───────────────────────────────────────────────────────────────
 
 static volatile sig_atomic_t g_quit = 0;
@@ -108,6 +115,187 @@ static std::string fmt_del(const std::string& key) {
     return "DEL " + std::to_string(key.size()) + " " + key + "\n";
 }
 
+// ── Token-aware routing ───────────────────────────────────────────────────────
+//
+// With --token-aware the REPL fetches the ring once and sends SET/GET/DEL
+// straight to the key's primary replica, opening a connection to each node
+// the first time it is needed.  Anything that cannot be routed (no ring,
+// node unreachable) goes to the node the REPL connected to.
+
+struct Session {
+    int              fd          = -1;      // the --host/--port connection
+    bool             token_aware = false;
+    dkv::TokenRouter router;
+    std::vector<int> node_fds;              // indexed like router.nodes()
+
+    int fd_for(const std::string& key) {
+        if (!token_aware || router.empty()) return fd;
+        size_t idx = router.primary(key);
+        if (node_fds.size() != router.nodes().size()) {
+            for (int nfd : node_fds) if (nfd >= 0) close(nfd);
+            node_fds.assign(router.nodes().size(), -1);
+        }
+        if (node_fds[idx] < 0) {
+            const auto& node = router.nodes()[idx];
+            node_fds[idx] = open_connection(node.host, node.port);
+            if (node_fds[idx] < 0) return fd;
+        }
+        return node_fds[idx];
+    }
+
+    void close_all() {
+        for (int nfd : node_fds) if (nfd >= 0) close(nfd);
+        node_fds.clear();
+    }
+};
+
+// Send TOPOLOGY on `fd` and load the answer into `router`.  Prints the
+// server's error, if any.  Returns false if the connection was lost.
+static bool fetch_topology(int fd, dkv::TokenRouter& router, bool& loaded) {
+    static const char k_req[] = "TOPOLOGY\n";
+    loaded = false;
+    if (!send_all(fd, k_req, sizeof(k_req) - 1)) return false;
+    std::string line = recv_line(fd);
+    if (line.empty()) return false;
+
+    // $<len> <payload>\n
+    size_t sp = line.find(' ');
+    if (line[0] != '$' || sp == std::string::npos) {
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+            line.pop_back();
+        std::string body = line.substr(1);
+        if (body.rfind("ERR ", 0) == 0) body = body.substr(4);
+        std::cout << "(error) " << body << "\n";
+        return true;
+    }
+    loaded = router.update(std::string_view(line).substr(sp + 1, line.size() - sp - 2));
+    if (!loaded) std::cout << "(error) malformed TOPOLOGY response\n";
+    return true;
+}
+
+static void print_topology(const dkv::TokenRouter& router) {
+    std::vector<size_t> owned(router.nodes().size(), 0);
+    // Each node's share of a sample of keys, as the router places them.
+    for (int i = 0; i < 10000; ++i) ++owned[router.primary("k" + std::to_string(i))];
+    std::cout << "ring version " << router.version() << ", replication factor "
+              << router.replication_factor() << ", " << router.token_count()
+              << " tokens\n";
+    for (size_t i = 0; i < router.nodes().size(); ++i) {
+        const auto& n = router.nodes()[i];
+        std::cout << "  node " << n.node_id << "  " << n.address << "  ~"
+                  << owned[i] / 100 << "% of keys as primary\n";
+    }
+}
+
+// Send HOTKEYS on `fd` and print the report.  Returns false if the
+// connection was lost.
+static bool print_hot_keys(int fd) {
+    static const char k_req[] = "HOTKEYS\n";
+    if (!send_all(fd, k_req, sizeof(k_req) - 1)) return false;
+    std::string line = recv_line(fd);
+    if (line.empty()) return false;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+        line.pop_back();
+
+    // $<len> <payload>
+    size_t sp = line.find(' ');
+    if (line[0] != '$' || sp == std::string::npos) {
+        std::string body = line.substr(1);
+        if (body.rfind("ERR ", 0) == 0) body = body.substr(4);
+        std::cout << "(error) " << body << "\n";
+        return true;
+    }
+    dkv::HotKeyCache::Stats stats;
+    std::vector<dkv::HotKeyCache::HotKey> keys;
+    if (!dkv::HotKeyCache::decode_report(std::string_view(line).substr(sp + 1),
+                                         stats, keys)) {
+        std::cout << "(error) malformed HOTKEYS response\n";
+        return true;
+    }
+    std::cout << stats.reads << " reads, " << stats.hits << " cache hits, "
+              << stats.cached << " keys cached (" << stats.fills << " fills, "
+              << stats.invalidations << " invalidated, " << stats.expirations
+              << " expired, " << stats.evictions << " evicted, "
+              << stats.stale_fills << " stale fills dropped)\n";
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::cout << "  " << i + 1 << ") \"" << keys[i].key << "\"  ~"
+                  << keys[i].count << " reads" << (keys[i].cached ? "  (cached)" : "")
+                  << "\n";
+    }
+    return true;
+}
+
+// Send STATS on `fd` and print the metrics, one sample per line.  Returns
+// false if the connection was lost.
+static bool print_stats(int fd) {
+    static const char k_req[] = "STATS\n";
+    if (!send_all(fd, k_req, sizeof(k_req) - 1)) return false;
+    std::string line = recv_line(fd);
+    if (line.empty()) return false;
+
+    // $<len> <payload>\n, where the payload itself spans several lines.
+    size_t sp = line.find(' ');
+    if (line[0] != '$' || sp == std::string::npos) {
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+            line.pop_back();
+        std::string body = line.substr(1);
+        if (body.rfind("ERR ", 0) == 0) body = body.substr(4);
+        std::cout << "(error) " << body << "\n";
+        return true;
+    }
+    const size_t len = std::strtoull(line.c_str() + 1, nullptr, 10);
+    std::string payload = line.substr(sp + 1);
+    while (payload.size() < len + 1) {  // payload plus the closing '\n'
+        std::string more = recv_line(fd);
+        if (more.empty()) return false;
+        payload += more;
+    }
+    payload.resize(len);
+    std::cout << payload;
+    if (!payload.empty() && payload.back() != '\n') std::cout << "\n";
+    return true;
+}
+
+// Send MGET for `keys` on `fd` and print one line per key.  Returns false
+// if the connection was lost.
+static bool print_multi_get(int fd, const std::vector<std::string>& keys) {
+    std::string req = "MGET " + dkv::format_multi_args(keys) + "\n";
+    if (!send_all(fd, req.data(), req.size())) return false;
+    std::string line = recv_line(fd);
+    if (line.empty()) return false;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+        line.pop_back();
+
+    size_t sp = line.find(' ');
+    if (line[0] != '$' || sp == std::string::npos) {
+        std::string body = line.substr(1);
+        if (body.rfind("ERR ", 0) == 0) body = body.substr(4);
+        std::cout << "(error) " << body << "\n";
+        return true;
+    }
+    std::vector<dkv::MultiGetItem> items;
+    if (!dkv::parse_multi_get(std::string_view(line).substr(sp + 1), items) ||
+        items.size() != keys.size()) {
+        std::cout << "(error) malformed MGET response\n";
+        return true;
+    }
+    for (size_t i = 0; i < items.size(); ++i) {
+        std::cout << i + 1 << ") ";
+        switch (items[i].status) {
+            case dkv::MultiGetItem::Status::FOUND:
+                std::cout << "\"" << items[i].value << "\"\n";
+                break;
+            case dkv::MultiGetItem::Status::NOT_FOUND:
+                std::cout << "(nil)\n";
+                break;
+            case dkv::MultiGetItem::Status::FAILED:
+                std::cout << "(error) QUORUM_FAILED\n";
+                break;
+        }
+    }
+    return true;
+}
+
 // ── Response parser ───────────────────────────────────────────────────────────
 //
 // Reads one response line from `fd` and prints it in human-friendly form.
@@ -241,6 +429,20 @@ static std::string trim(const std::string& s) {
     return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
 }
 
+// Wait (without the 5s receive timeout) for the reply to a long-running
+// command, then print it.  Returns false if the connection was lost.
+static bool print_slow_response(int fd) {
+    for (;;) {
+        struct pollfd p{fd, POLLIN, 0};
+        int n = ::poll(&p, 1, 1000);
+        if (g_quit) return true;
+        if (n > 0) break;
+        if (n < 0 && errno != EINTR) return false;
+    }
+    bool timed_out = false;
+    return print_response(fd, timed_out) || timed_out;
+}
+
 // ── Help / usage text ─────────────────────────────────────────────────────────
 
 static void print_help() {
@@ -249,7 +451,13 @@ static void print_help() {
         "  SET <key> <value>   Set a key-value pair\n"
         "  GET <key>           Get a value by key\n"
         "  DEL <key>           Delete a key\n"
+        "  MGET <key> ...      Get several keys in one request\n"
+        "  MSET <k> <v> ...    Set several key-value pairs in one request\n"
         "  PING                Check server connectivity\n"
+        "  TOPOLOGY            Show the ring (and refresh the token router)\n"
+        "  DECOMMISSION        Hand this node's ranges over and leave the ring\n"
+        "  HOTKEYS             Show the most read keys and the read cache\n"
+        "  STATS               Show the server's metrics\n"
         "  QUIT / EXIT         Close connection and exit\n"
         "  HELP                Show this message\n";
 }
@@ -261,6 +469,7 @@ static void print_usage(const char* prog) {
         "Options:\n"
         "  -h, --host HOST   Server hostname or IP  (default: 127.0.0.1)\n"
         "  -p, --port PORT   Server port number     (default: 7001)\n"
+        "      --token-aware Send each key straight to its primary replica\n"
         "      --help        Show this message and exit\n"
         "\n"
         "Example:\n"
@@ -271,7 +480,8 @@ static void print_usage(const char* prog) {
 
 // Returns true if the session ended cleanly (QUIT/EXIT/Ctrl-D/SIGINT).
 // Returns false if the connection was lost unexpectedly.
-static bool run_repl(int fd) {
+static bool run_repl(Session& session) {
+    const int fd = session.fd;
     static const char k_ping[] = "PING\n";
 
     std::string line;
@@ -321,6 +531,50 @@ static bool run_repl(int fd) {
             continue;
         }
 
+        // ── TOPOLOGY ──────────────────────────────────────────────────────────
+        if (cmd == "TOPOLOGY") {
+            bool loaded = false;
+            if (!fetch_topology(fd, session.router, loaded)) {
+                std::cerr << "Error: connection lost\n";
+                return false;
+            }
+            if (loaded) print_topology(session.router);
+            continue;
+        }
+
+        // ── HOTKEYS ───────────────────────────────────────────────────────────
+        if (cmd == "HOTKEYS") {
+            if (!print_hot_keys(fd)) {
+                std::cerr << "Error: connection lost\n";
+                return false;
+            }
+            continue;
+        }
+
+        // ── STATS ─────────────────────────────────────────────────────────────
+        if (cmd == "STATS") {
+            if (!print_stats(fd)) {
+                std::cerr << "Error: connection lost\n";
+                return false;
+            }
+            continue;
+        }
+
+        // ── DECOMMISSION ──────────────────────────────────────────────────────
+        if (cmd == "DECOMMISSION") {
+            static const char k_req[] = "DECOMMISSION\n";
+            if (!send_all(fd, k_req, sizeof(k_req) - 1)) {
+                std::cerr << "Error: connection lost\n";
+                return false;
+            }
+            std::cout << "Streaming ranges to the remaining nodes...\n";
+            if (!print_slow_response(fd)) {
+                std::cerr << "Error: connection lost\n";
+                return false;
+            }
+            continue;
+        }
+
         // ── SET ───────────────────────────────────────────────────────────────
         if (cmd == "SET") {
             if (tokens.size() != 3u) {
@@ -328,12 +582,13 @@ static bool run_repl(int fd) {
                 continue;
             }
             std::string req = fmt_set(tokens[1], tokens[2]);
-            if (!send_all(fd, req.c_str(), req.size())) {
+            int target = session.fd_for(tokens[1]);
+            if (!send_all(target, req.c_str(), req.size())) {
                 std::cerr << "Error: connection lost\n";
                 return false;
             }
             bool timed_out = false;
-            if (!print_response(fd, timed_out) && !timed_out) {
+            if (!print_response(target, timed_out) && !timed_out) {
                 std::cerr << "Error: connection lost\n";
                 return false;
             }
@@ -347,12 +602,13 @@ static bool run_repl(int fd) {
                 continue;
             }
             std::string req = fmt_get(tokens[1]);
-            if (!send_all(fd, req.c_str(), req.size())) {
+            int target = session.fd_for(tokens[1]);
+            if (!send_all(target, req.c_str(), req.size())) {
                 std::cerr << "Error: connection lost\n";
                 return false;
             }
             bool timed_out = false;
-            if (!print_response(fd, timed_out) && !timed_out) {
+            if (!print_response(target, timed_out) && !timed_out) {
                 std::cerr << "Error: connection lost\n";
                 return false;
             }
@@ -366,6 +622,45 @@ static bool run_repl(int fd) {
                 continue;
             }
             std::string req = fmt_del(tokens[1]);
+            int target = session.fd_for(tokens[1]);
+            if (!send_all(target, req.c_str(), req.size())) {
+                std::cerr << "Error: connection lost\n";
+                return false;
+            }
+            bool timed_out = false;
+            if (!print_response(target, timed_out) && !timed_out) {
+                std::cerr << "Error: connection lost\n";
+                return false;
+            }
+            continue;
+        }
+
+        // ── MGET ──────────────────────────────────────────────────────────────
+        // Sent as-is to the connected node, which splits it by replica.
+        if (cmd == "MGET") {
+            if (tokens.size() < 2u) {
+                std::cout << "(error) Usage: MGET <key> [<key> ...]\n";
+                continue;
+            }
+            if (!print_multi_get(fd, {tokens.begin() + 1, tokens.end()})) {
+                std::cerr << "Error: connection lost\n";
+                return false;
+            }
+            continue;
+        }
+
+        // ── MSET ──────────────────────────────────────────────────────────────
+        if (cmd == "MSET") {
+            if (tokens.size() < 3u || tokens.size() % 2 == 0) {
+                std::cout << "(error) Usage: MSET <key> <value> [<key> <value> ...]\n";
+                continue;
+            }
+            std::vector<std::string> keys, values;
+            for (size_t i = 1; i + 1 < tokens.size(); i += 2) {
+                keys.push_back(tokens[i]);
+                values.push_back(tokens[i + 1]);
+            }
+            std::string req = "MSET " + dkv::format_multi_args(keys, values) + "\n";
             if (!send_all(fd, req.c_str(), req.size())) {
                 std::cerr << "Error: connection lost\n";
                 return false;
@@ -392,6 +687,7 @@ static bool run_repl(int fd) {
 int main(int argc, char* argv[]) {
     std::string host = "127.0.0.1";
     int         port = 7001;
+    bool        token_aware = false;
 
     // Parse CLI flags.
     for (int i = 1; i < argc; ++i) {
@@ -401,6 +697,8 @@ int main(int argc, char* argv[]) {
         } else if ((std::strcmp(argv[i], "--port") == 0 ||
                     std::strcmp(argv[i], "-p") == 0) && i + 1 < argc) {
             port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--token-aware") == 0) {
+            token_aware = true;
         } else if (std::strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -427,9 +725,28 @@ int main(int argc, char* argv[]) {
 
     std::cout << "Connected to " << host << ":" << port << "\n";
 
-    // Run the REPL; it owns the connection for its lifetime.
-    bool clean = run_repl(fd);
+    Session session;
+    session.fd          = fd;
+    session.token_aware = token_aware;
+    if (token_aware) {
+        bool loaded = false;
+        if (!fetch_topology(fd, session.router, loaded)) {
+            std::cerr << "Error: connection lost\n";
+            close(fd);
+            return 1;
+        }
+        if (loaded) {
+            std::cout << "Token-aware routing over " << session.router.nodes().size()
+                      << " nodes (ring version " << session.router.version() << ")\n";
+        } else {
+            std::cout << "Token-aware routing unavailable; using this node\n";
+        }
+    }
+
+    // Run the REPL; it owns the connections for its lifetime.
+    bool clean = run_repl(session);
 
+    session.close_all();
     close(fd);
     return clean ? 0 : 1;
 }